@@ -0,0 +1,296 @@
+#include "bench.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "muffin_core/memory.h"
+#include "muffin_core/sync.h"
+#include "muffin_core/timer.h"
+
+enum {
+    MUF_BENCH_MAX_COUNT = 256,
+    MUF_BENCH_MAX_REPETITIONS = 64,
+    MUF_BENCH_DEFAULT_REPETITIONS = 5,
+    MUF_BENCH_DEFAULT_MIN_TIME_MS = 100
+};
+
+typedef struct _MufBenchEntry_s {
+    const muf_char  *name;
+    MufBenchFunc    func;
+    muf_u64         param;
+} _MufBenchEntry;
+
+typedef struct _MufBenchResult_s {
+    muf_u64 iterations;
+    muf_f64 samples[MUF_BENCH_MAX_REPETITIONS];
+    muf_f64 minNs;
+    muf_f64 medianNs;
+    muf_f64 meanNs;
+    muf_f64 stddevNs;
+    muf_f64 itemsPerSecond;
+    muf_f64 bytesPerSecond;
+} _MufBenchResult;
+
+typedef struct _MufBenchOptions_s {
+    const muf_char  *filter;
+    const muf_char  *outputPath;
+    muf_u32         repetitions;
+    muf_u64         minTimeNs;
+    muf_bool        listOnly;
+} _MufBenchOptions;
+
+static _MufBenchEntry _mufBenches[MUF_BENCH_MAX_COUNT];
+static muf_usize _mufBenchCount = 0;
+
+#if !defined(MUF_COMPILER_GCC) && !defined(MUF_COMPILER_CLANG)
+volatile muf_u64 _mufBenchSink = 0;
+#endif
+
+void mufBenchRegister(const muf_char *name, MufBenchFunc func, muf_u64 param) {
+    if (_mufBenchCount == MUF_BENCH_MAX_COUNT) {
+        fprintf(stderr, "muffin_bench: too many benchmarks, '%s' is dropped\n", name);
+        return;
+    }
+    _MufBenchEntry *entry = &_mufBenches[_mufBenchCount++];
+    entry->name = name;
+    entry->func = func;
+    entry->param = param;
+}
+
+void mufBenchPauseTiming(MufBenchState *state) {
+    state->_pauseBegin = mufTimerGetTicks();
+}
+
+void mufBenchResumeTiming(MufBenchState *state) {
+    state->_pausedTicks += mufTimerGetTicks() - state->_pauseBegin;
+}
+
+static muf_f64 _mufBenchRunOnce(const _MufBenchEntry *entry, muf_u64 iterations, MufBenchState *stateOut) {
+    MufBenchState state = { 0 };
+    state.iterations = iterations;
+    state.param = entry->param;
+
+    muf_u64 begin = mufTimerGetTicks();
+    entry->func(&state);
+    muf_u64 end = mufTimerGetTicks();
+
+    if (stateOut)
+        *stateOut = state;
+    muf_u64 ticks = end - begin;
+    ticks = state._pausedTicks < ticks ? ticks - state._pausedTicks : 0;
+    return (muf_f64) mufTimerTicksToNanoseconds(ticks);
+}
+
+static muf_i32 _mufBenchCompareF64(const void *a, const void *b) {
+    muf_f64 x = *(const muf_f64 *) a;
+    muf_f64 y = *(const muf_f64 *) b;
+    return (x > y) - (x < y);
+}
+
+static void _mufBenchRun(const _MufBenchEntry *entry, const _MufBenchOptions *options, _MufBenchResult *result) {
+    /* Grow the iteration count until a single run covers the minimal time */
+    muf_u64 iterations = 1;
+    muf_f64 elapsed = _mufBenchRunOnce(entry, iterations, NULL);
+    while (elapsed < (muf_f64) options->minTimeNs) {
+        muf_f64 scale = elapsed > 0.0 ? 1.4 * (muf_f64) options->minTimeNs / elapsed : 10.0;
+        scale = scale > 10.0 ? 10.0 : (scale < 2.0 ? 2.0 : scale);
+        iterations = (muf_u64) ((muf_f64) iterations * scale);
+        elapsed = _mufBenchRunOnce(entry, iterations, NULL);
+    }
+
+    MufBenchState state = { 0 };
+    memset(result, 0, sizeof(*result));
+    result->iterations = iterations;
+    muf_f64 totalNs = 0.0;
+    for (muf_u32 i = 0; i < options->repetitions; ++i) {
+        muf_f64 ns = _mufBenchRunOnce(entry, iterations, &state);
+        result->samples[i] = ns / (muf_f64) iterations;
+        totalNs += ns;
+    }
+
+    muf_f64 sorted[MUF_BENCH_MAX_REPETITIONS];
+    memcpy(sorted, result->samples, sizeof(muf_f64) * options->repetitions);
+    qsort(sorted, options->repetitions, sizeof(muf_f64), _mufBenchCompareF64);
+    muf_u32 n = options->repetitions;
+    result->minNs = sorted[0];
+    result->medianNs = (n & 1) ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+
+    muf_f64 sum = 0.0;
+    for (muf_u32 i = 0; i < n; ++i)
+        sum += sorted[i];
+    result->meanNs = sum / n;
+    muf_f64 variance = 0.0;
+    for (muf_u32 i = 0; i < n; ++i)
+        variance += (sorted[i] - result->meanNs) * (sorted[i] - result->meanNs);
+    result->stddevNs = n > 1 ? sqrt(variance / (n - 1)) : 0.0;
+
+    /* Throughput is derived from the last repetition, every repetition does the same work */
+    muf_f64 seconds = totalNs / n * 1e-9;
+    if (seconds > 0.0) {
+        result->itemsPerSecond = (muf_f64) state.itemsProcessed / seconds;
+        result->bytesPerSecond = (muf_f64) state.bytesProcessed / seconds;
+    }
+}
+
+static void _mufBenchWriteJsonString(FILE *stream, const muf_char *str) {
+    fputc('"', stream);
+    for (; *str; ++str) {
+        if (*str == '"' || *str == '\\')
+            fputc('\\', stream);
+        fputc(*str, stream);
+    }
+    fputc('"', stream);
+}
+
+static void _mufBenchWriteContext(FILE *stream, const _MufBenchOptions *options) {
+    muf_char date[32];
+    time_t now = time(NULL);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    fprintf(stream, "  \"context\": {\n");
+    fprintf(stream, "    \"date\": \"%s\",\n", date);
+#if defined(__VERSION__)
+    fprintf(stream, "    \"compiler\": ");
+    _mufBenchWriteJsonString(stream, __VERSION__);
+    fprintf(stream, ",\n");
+#endif
+#if defined(MUFFIN_BENCH_BUILD_TYPE)
+    fprintf(stream, "    \"build_type\": \"%s\",\n", MUFFIN_BENCH_BUILD_TYPE);
+#endif
+#if defined(MUF_ENABLE_PROFILER)
+    fprintf(stream, "    \"profiler\": true,\n");
+#else
+    fprintf(stream, "    \"profiler\": false,\n");
+#endif
+#if defined(MUF_ENABLE_MEMORY_TRACKING)
+    fprintf(stream, "    \"memory_tracking\": true,\n");
+#else
+    fprintf(stream, "    \"memory_tracking\": false,\n");
+#endif
+    fprintf(stream, "    \"hardware_concurrency\": %llu,\n", (unsigned long long) mufGetHardwareConcurrency());
+    fprintf(stream, "    \"timer_frequency\": %llu,\n", (unsigned long long) mufTimerGetFrequency());
+    fprintf(stream, "    \"timer_tsc\": %s,\n", mufTimerIsTscBased() ? "true" : "false");
+    fprintf(stream, "    \"repetitions\": %u,\n", options->repetitions);
+    fprintf(stream, "    \"min_time_ns\": %llu\n", (unsigned long long) options->minTimeNs);
+    fprintf(stream, "  },\n");
+}
+
+static void _mufBenchWriteResult(FILE *stream, const _MufBenchEntry *entry, const _MufBenchResult *result,
+    muf_u32 repetitions, muf_bool last) {
+    fprintf(stream, "    {\n");
+    fprintf(stream, "      \"name\": \"%s/%llu\",\n", entry->name, (unsigned long long) entry->param);
+    fprintf(stream, "      \"group\": \"%s\",\n", entry->name);
+    fprintf(stream, "      \"param\": %llu,\n", (unsigned long long) entry->param);
+    fprintf(stream, "      \"iterations\": %llu,\n", (unsigned long long) result->iterations);
+    fprintf(stream, "      \"ns_per_iter\": { \"min\": %.3f, \"median\": %.3f, \"mean\": %.3f, \"stddev\": %.3f },\n",
+        result->minNs, result->medianNs, result->meanNs, result->stddevNs);
+    fprintf(stream, "      \"samples\": [");
+    for (muf_u32 i = 0; i < repetitions; ++i)
+        fprintf(stream, i == 0 ? "%.3f" : ", %.3f", result->samples[i]);
+    fprintf(stream, "],\n");
+    fprintf(stream, "      \"items_per_second\": %.1f,\n", result->itemsPerSecond);
+    fprintf(stream, "      \"bytes_per_second\": %.1f\n", result->bytesPerSecond);
+    fprintf(stream, last ? "    }\n" : "    },\n");
+}
+
+static void _mufBenchPrintUsage(void) {
+    fprintf(stderr,
+        "Usage: muffin_bench [options]\n"
+        "  --filter=<text>       Run only the benchmarks whose name contains <text>\n"
+        "  --out=<path>          Write the JSON report to <path> instead of stdout\n"
+        "  --repetitions=<n>     Measured repetitions per benchmark (default %d)\n"
+        "  --min-time-ms=<ms>    Minimal duration of one repetition (default %d)\n"
+        "  --list                List the benchmark names and exit\n",
+        MUF_BENCH_DEFAULT_REPETITIONS, MUF_BENCH_DEFAULT_MIN_TIME_MS);
+}
+
+static muf_bool _mufBenchParseOptions(muf_i32 argc, muf_char **argv, _MufBenchOptions *options) {
+    options->filter = NULL;
+    options->outputPath = NULL;
+    options->repetitions = MUF_BENCH_DEFAULT_REPETITIONS;
+    options->minTimeNs = MUF_BENCH_DEFAULT_MIN_TIME_MS * 1000000ULL;
+    options->listOnly = MUF_FALSE;
+
+    for (muf_i32 i = 1; i < argc; ++i) {
+        const muf_char *arg = argv[i];
+        if (strncmp(arg, "--filter=", 9) == 0) {
+            options->filter = arg + 9;
+        } else if (strncmp(arg, "--out=", 6) == 0) {
+            options->outputPath = arg + 6;
+        } else if (strncmp(arg, "--repetitions=", 14) == 0) {
+            muf_i32 repetitions = atoi(arg + 14);
+            options->repetitions = (muf_u32) (repetitions < 1 ? 1 :
+                (repetitions > MUF_BENCH_MAX_REPETITIONS ? MUF_BENCH_MAX_REPETITIONS : repetitions));
+        } else if (strncmp(arg, "--min-time-ms=", 14) == 0) {
+            muf_i32 ms = atoi(arg + 14);
+            options->minTimeNs = (muf_u64) (ms < 1 ? 1 : ms) * 1000000ULL;
+        } else if (strcmp(arg, "--list") == 0) {
+            options->listOnly = MUF_TRUE;
+        } else {
+            _mufBenchPrintUsage();
+            return MUF_FALSE;
+        }
+    }
+    return MUF_TRUE;
+}
+
+int main(int argc, char **argv) {
+    _MufBenchOptions options;
+    if (!_mufBenchParseOptions(argc, argv, &options))
+        return 1;
+
+    mufMemorySetReportAtExit(MUF_FALSE);
+
+    mufBenchRegisterCompression();
+    mufBenchRegisterContainers();
+    mufBenchRegisterHash();
+    mufBenchRegisterMath();
+    mufBenchRegisterLog();
+    mufBenchRegisterRender();
+    mufBenchRegisterString();
+
+    muf_char fullName[256];
+    _MufBenchEntry *selected[MUF_BENCH_MAX_COUNT];
+    muf_usize selectedCount = 0;
+    for (muf_usize i = 0; i < _mufBenchCount; ++i) {
+        snprintf(fullName, sizeof(fullName), "%s/%llu", _mufBenches[i].name, (unsigned long long) _mufBenches[i].param);
+        if (options.filter == NULL || strstr(fullName, options.filter) != NULL)
+            selected[selectedCount++] = &_mufBenches[i];
+    }
+
+    if (options.listOnly) {
+        for (muf_usize i = 0; i < selectedCount; ++i)
+            printf("%s/%llu\n", selected[i]->name, (unsigned long long) selected[i]->param);
+        return 0;
+    }
+
+    FILE *stream = stdout;
+    if (options.outputPath) {
+        stream = fopen(options.outputPath, "w");
+        if (stream == NULL) {
+            fprintf(stderr, "muffin_bench: could not open '%s'\n", options.outputPath);
+            return 1;
+        }
+    }
+
+    fprintf(stream, "{\n");
+    _mufBenchWriteContext(stream, &options);
+    fprintf(stream, "  \"benchmarks\": [\n");
+    for (muf_usize i = 0; i < selectedCount; ++i) {
+        _MufBenchResult result;
+        fprintf(stderr, "%-48s", selected[i]->name);
+        fprintf(stderr, " %10llu ", (unsigned long long) selected[i]->param);
+        fflush(stderr);
+        _mufBenchRun(selected[i], &options, &result);
+        fprintf(stderr, "%14.2f ns/iter\n", result.medianNs);
+        _mufBenchWriteResult(stream, selected[i], &result, options.repetitions, i + 1 == selectedCount);
+    }
+    fprintf(stream, "  ]\n}\n");
+
+    if (stream != stdout)
+        fclose(stream);
+    return 0;
+}
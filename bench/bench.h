@@ -0,0 +1,68 @@
+#ifndef _MUFFIN_BENCH_BENCH_H_
+#define _MUFFIN_BENCH_BENCH_H_
+
+#include "muffin_core/common.h"
+
+/**
+ * @brief The state handed to a benchmark body. The body runs its operation `iterations` times
+ * and may report how much work one run did through itemsProcessed / bytesProcessed.
+ */
+typedef struct MufBenchState_s {
+    muf_u64     iterations;
+    muf_u64     param;
+    muf_u64     itemsProcessed;
+    muf_u64     bytesProcessed;
+    muf_u64     _pausedTicks;
+    muf_u64     _pauseBegin;
+} MufBenchState;
+
+typedef void (*MufBenchFunc)(MufBenchState *state);
+
+/**
+ * @brief Register a benchmark. The same body may be registered several times with different params,
+ * the reported name is "<name>/<param>".
+ * @param[in] name The benchmark name, grouped by "/" (e.g. "hash_map/insert")
+ * @param[in] func The benchmark body
+ * @param[in] param A size argument passed through MufBenchState::param
+ */
+void mufBenchRegister(const muf_char *name, MufBenchFunc func, muf_u64 param);
+
+/**
+ * @brief Exclude the following code from the measured time (e.g. per-iteration setup)
+ */
+void mufBenchPauseTiming(MufBenchState *state);
+
+void mufBenchResumeTiming(MufBenchState *state);
+
+/**
+ * @brief SplitMix64 step. All input data is generated from fixed seeds so runs are reproducible.
+ */
+static MUF_INLINE muf_u64 mufBenchNextRandom(muf_u64 *seed) {
+    muf_u64 z = (*seed += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+enum {
+    MUF_BENCH_SEED = 0x6D756666
+};
+
+#if defined(MUF_COMPILER_GCC) || defined(MUF_COMPILER_CLANG)
+#   define mufBenchDoNotOptimize(_value) __asm__ __volatile__("" : : "r,m"(_value) : "memory")
+#   define mufBenchClobberMemory() __asm__ __volatile__("" : : : "memory")
+#else
+extern volatile muf_u64 _mufBenchSink;
+#   define mufBenchDoNotOptimize(_value) (_mufBenchSink += (muf_u64) (muf_usize) (_value))
+#   define mufBenchClobberMemory()
+#endif
+
+void mufBenchRegisterCompression(void);
+void mufBenchRegisterContainers(void);
+void mufBenchRegisterHash(void);
+void mufBenchRegisterMath(void);
+void mufBenchRegisterLog(void);
+void mufBenchRegisterRender(void);
+void mufBenchRegisterString(void);
+
+#endif
@@ -0,0 +1,79 @@
+#include "bench.h"
+
+#include "muffin_core/compression.h"
+#include "muffin_core/memory.h"
+
+/* Text-like input built from a small vocabulary, it compresses about 2-3x like typical asset metadata */
+static muf_byte *_mufBenchMakeCompressibleData(muf_usize size) {
+    static const muf_char *words[] = {
+        "vertex ", "index ", "texture ", "shader ", "normal ", "tangent ", "0.0 ", "1.0 ",
+        "position ", "uv ", "color ", "material ", "mesh ", "node ", "{ ", "} "
+    };
+    muf_byte *data = mufAlloc(muf_byte, size);
+    muf_u64 seed = MUF_BENCH_SEED;
+    muf_usize i = 0;
+    while (i < size) {
+        const muf_char *word = words[mufBenchNextRandom(&seed) % MUF_COUNTOF(words)];
+        while (*word != '\0' && i < size)
+            data[i++] = (muf_byte) *word++;
+        if (i < size && mufBenchNextRandom(&seed) % 8 == 0)
+            data[i++] = (muf_byte) ('0' + mufBenchNextRandom(&seed) % 10);
+    }
+    return data;
+}
+
+static void _mufBenchCompress(MufBenchState *state) {
+    mufBenchPauseTiming(state);
+    muf_usize size = state->param;
+    muf_byte *data = _mufBenchMakeCompressibleData(size);
+    muf_usize capacity = mufCompressBound(size, 0);
+    muf_byte *stream = mufAlloc(muf_byte, capacity);
+    mufBenchResumeTiming(state);
+
+    muf_usize streamSize = 0;
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        streamSize += mufCompressBlocks(data, size, stream, capacity, 0);
+        mufBenchClobberMemory();
+    }
+    mufBenchDoNotOptimize(streamSize);
+
+    mufBenchPauseTiming(state);
+    mufFree(stream);
+    mufFree(data);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations;
+    state->bytesProcessed = state->iterations * size;
+}
+
+static void _mufBenchDecompress(MufBenchState *state) {
+    mufBenchPauseTiming(state);
+    muf_usize size = state->param;
+    muf_byte *data = _mufBenchMakeCompressibleData(size);
+    muf_usize capacity = mufCompressBound(size, 0);
+    muf_byte *stream = mufAlloc(muf_byte, capacity);
+    muf_usize streamSize = mufCompressBlocks(data, size, stream, capacity, 0);
+    mufBenchResumeTiming(state);
+
+    muf_bool ok = MUF_TRUE;
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        ok &= mufDecompressBlocks(NULL, stream, streamSize, data, size);
+        mufBenchClobberMemory();
+    }
+    mufBenchDoNotOptimize(ok);
+
+    mufBenchPauseTiming(state);
+    mufFree(stream);
+    mufFree(data);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations;
+    state->bytesProcessed = state->iterations * size;
+}
+
+void mufBenchRegisterCompression(void) {
+    static const muf_u64 sizes[] = { 65536, 1048576, 16777216 };
+
+    for (muf_usize i = 0; i < MUF_COUNTOF(sizes); ++i) {
+        mufBenchRegister("compression/compress", _mufBenchCompress, sizes[i]);
+        mufBenchRegister("compression/decompress", _mufBenchDecompress, sizes[i]);
+    }
+}
@@ -0,0 +1,350 @@
+#include "bench.h"
+
+#include <stdio.h>
+
+#include "muffin_core/array.h"
+#include "muffin_core/dict.h"
+#include "muffin_core/hash_map.h"
+#include "muffin_core/hash_set.h"
+#include "muffin_core/memory.h"
+
+enum {
+    MUF_BENCH_DICT_KEY_LEN = 24
+};
+
+static muf_u64 *_mufBenchCreateKeys(muf_usize count, muf_u64 seed) {
+    muf_u64 *keys = mufAlloc(muf_u64, count);
+    for (muf_usize i = 0; i < count; ++i)
+        keys[i] = mufBenchNextRandom(&seed);
+    return keys;
+}
+
+static muf_char *_mufBenchCreateStrKeys(muf_usize count, muf_u64 seed) {
+    muf_char *keys = mufAlloc(muf_char, count * MUF_BENCH_DICT_KEY_LEN);
+    for (muf_usize i = 0; i < count; ++i)
+        snprintf(keys + i * MUF_BENCH_DICT_KEY_LEN, MUF_BENCH_DICT_KEY_LEN, "entity_%016llx",
+            (unsigned long long) mufBenchNextRandom(&seed));
+    return keys;
+}
+
+/* MufArray */
+
+static void _mufBenchArrayPush(MufBenchState *state) {
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        MufArray *array = mufCreateArray(muf_u32);
+        for (muf_u32 i = 0; i < (muf_u32) state->param; ++i)
+            mufArrayPush(array, &i);
+        mufBenchDoNotOptimize(array->data);
+        mufDestroyArray(array);
+    }
+    state->itemsProcessed = state->iterations * state->param;
+}
+
+static void _mufBenchArrayPushReserved(MufBenchState *state) {
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        MufArray *array = mufCreateArray(muf_u32);
+        mufArrayReserve(array, state->param);
+        for (muf_u32 i = 0; i < (muf_u32) state->param; ++i)
+            mufArrayPush(array, &i);
+        mufBenchDoNotOptimize(array->data);
+        mufDestroyArray(array);
+    }
+    state->itemsProcessed = state->iterations * state->param;
+}
+
+static void _mufBenchArrayInsertFront(MufBenchState *state) {
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        MufArray *array = mufCreateArray(muf_u32);
+        for (muf_u32 i = 0; i < (muf_u32) state->param; ++i)
+            mufArrayInsert(array, 0, &i);
+        mufBenchDoNotOptimize(array->data);
+        mufDestroyArray(array);
+    }
+    state->itemsProcessed = state->iterations * state->param;
+}
+
+static void _mufBenchArrayInsertRandom(MufBenchState *state) {
+    muf_u64 seed = MUF_BENCH_SEED;
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        MufArray *array = mufCreateArray(muf_u32);
+        for (muf_u32 i = 0; i < (muf_u32) state->param; ++i)
+            mufArrayInsert(array, (muf_index) (mufBenchNextRandom(&seed) % (array->size + 1)), &i);
+        mufBenchDoNotOptimize(array->data);
+        mufDestroyArray(array);
+    }
+    state->itemsProcessed = state->iterations * state->param;
+}
+
+static void _mufBenchArrayRemoveFront(MufBenchState *state) {
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        mufBenchPauseTiming(state);
+        MufArray *array = mufCreateArray(muf_u32);
+        mufArrayResize(array, state->param, &(muf_u32) { 7 });
+        mufBenchResumeTiming(state);
+
+        while (!mufArrayIsEmpty(array))
+            mufArrayRemove(array, 0);
+        mufBenchDoNotOptimize(array->size);
+        mufDestroyArray(array);
+    }
+    state->itemsProcessed = state->iterations * state->param;
+}
+
+static void _mufBenchArrayPop(MufBenchState *state) {
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        mufBenchPauseTiming(state);
+        MufArray *array = mufCreateArray(muf_u32);
+        mufArrayResize(array, state->param, &(muf_u32) { 7 });
+        mufBenchResumeTiming(state);
+
+        while (!mufArrayIsEmpty(array))
+            mufArrayPop(array);
+        mufBenchDoNotOptimize(array->size);
+        mufDestroyArray(array);
+    }
+    state->itemsProcessed = state->iterations * state->param;
+}
+
+/* MufHashMap */
+
+static MufHashMap *_mufBenchCreateFilledHashMap(const muf_u64 *keys, muf_usize count) {
+    MufHashMap *map = mufCreateHashMap_u64(muf_u64);
+    for (muf_usize i = 0; i < count; ++i)
+        mufHashMapInsert(map, &keys[i], &i);
+    return map;
+}
+
+static void _mufBenchHashMapInsert(MufBenchState *state) {
+    muf_u64 *keys = _mufBenchCreateKeys(state->param, MUF_BENCH_SEED);
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        MufHashMap *map = _mufBenchCreateFilledHashMap(keys, state->param);
+        mufBenchDoNotOptimize(map);
+        mufDestoryHashMap(map);
+    }
+    mufFree(keys);
+    state->itemsProcessed = state->iterations * state->param;
+}
+
+/* param is the entry count, the table is rehashed so the lookups run at the given load factor */
+static void _mufBenchHashMapFind(MufBenchState *state, muf_f32 loadFactor, muf_bool hit) {
+    mufBenchPauseTiming(state);
+    muf_usize count = state->param;
+    muf_u64 *keys = _mufBenchCreateKeys(count, MUF_BENCH_SEED);
+    muf_u64 *queries = hit ? keys : _mufBenchCreateKeys(count, MUF_BENCH_SEED + 1);
+    MufHashMap *map = _mufBenchCreateFilledHashMap(keys, count);
+    mufHashMapRehash(map, (muf_usize) ((muf_f32) count / loadFactor));
+    mufBenchResumeTiming(state);
+
+    muf_usize found = 0;
+    muf_usize index = 0;
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        found += mufHashMapGetCRef(map, &queries[index]) != NULL;
+        index = index + 1 == count ? 0 : index + 1;
+    }
+    mufBenchDoNotOptimize(found);
+
+    mufBenchPauseTiming(state);
+    mufDestoryHashMap(map);
+    if (queries != keys)
+        mufFree(queries);
+    mufFree(keys);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations;
+}
+
+static void _mufBenchHashMapFindLf025(MufBenchState *state) {
+    _mufBenchHashMapFind(state, 0.25F, MUF_TRUE);
+}
+
+static void _mufBenchHashMapFindLf050(MufBenchState *state) {
+    _mufBenchHashMapFind(state, 0.5F, MUF_TRUE);
+}
+
+static void _mufBenchHashMapFindLf100(MufBenchState *state) {
+    _mufBenchHashMapFind(state, 1.0F, MUF_TRUE);
+}
+
+static void _mufBenchHashMapFindMiss(MufBenchState *state) {
+    _mufBenchHashMapFind(state, 1.0F, MUF_FALSE);
+}
+
+static void _mufBenchHashMapErase(MufBenchState *state) {
+    muf_u64 *keys = _mufBenchCreateKeys(state->param, MUF_BENCH_SEED);
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        mufBenchPauseTiming(state);
+        MufHashMap *map = _mufBenchCreateFilledHashMap(keys, state->param);
+        mufBenchResumeTiming(state);
+
+        for (muf_usize i = 0; i < state->param; ++i)
+            mufHashMapRemove(map, &keys[i]);
+        mufBenchDoNotOptimize(map);
+        mufDestoryHashMap(map);
+    }
+    mufFree(keys);
+    state->itemsProcessed = state->iterations * state->param;
+}
+
+/* MufHashSet */
+
+static MufHashSet *_mufBenchCreateFilledHashSet(const muf_u64 *keys, muf_usize count) {
+    MufHashSet *set = mufCreateHashSet_u64();
+    for (muf_usize i = 0; i < count; ++i)
+        mufHashSetInsert(set, &keys[i]);
+    return set;
+}
+
+static void _mufBenchHashSetInsert(MufBenchState *state) {
+    muf_u64 *keys = _mufBenchCreateKeys(state->param, MUF_BENCH_SEED);
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        MufHashSet *set = _mufBenchCreateFilledHashSet(keys, state->param);
+        mufBenchDoNotOptimize(set);
+        mufDestroyHashSet(set);
+    }
+    mufFree(keys);
+    state->itemsProcessed = state->iterations * state->param;
+}
+
+static void _mufBenchHashSetFind(MufBenchState *state, muf_f32 loadFactor) {
+    mufBenchPauseTiming(state);
+    muf_usize count = state->param;
+    muf_u64 *keys = _mufBenchCreateKeys(count, MUF_BENCH_SEED);
+    MufHashSet *set = _mufBenchCreateFilledHashSet(keys, count);
+    mufHashSetRehash(set, (muf_usize) ((muf_f32) count / loadFactor));
+    mufBenchResumeTiming(state);
+
+    muf_usize found = 0;
+    muf_usize index = 0;
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        found += mufHashSetContains(set, &keys[index]);
+        index = index + 1 == count ? 0 : index + 1;
+    }
+    mufBenchDoNotOptimize(found);
+
+    mufBenchPauseTiming(state);
+    mufDestroyHashSet(set);
+    mufFree(keys);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations;
+}
+
+static void _mufBenchHashSetFindLf025(MufBenchState *state) {
+    _mufBenchHashSetFind(state, 0.25F);
+}
+
+static void _mufBenchHashSetFindLf100(MufBenchState *state) {
+    _mufBenchHashSetFind(state, 1.0F);
+}
+
+static void _mufBenchHashSetErase(MufBenchState *state) {
+    muf_u64 *keys = _mufBenchCreateKeys(state->param, MUF_BENCH_SEED);
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        mufBenchPauseTiming(state);
+        MufHashSet *set = _mufBenchCreateFilledHashSet(keys, state->param);
+        mufBenchResumeTiming(state);
+
+        for (muf_usize i = 0; i < state->param; ++i)
+            mufHashSetRemove(set, &keys[i]);
+        mufBenchDoNotOptimize(set);
+        mufDestroyHashSet(set);
+    }
+    mufFree(keys);
+    state->itemsProcessed = state->iterations * state->param;
+}
+
+/* MufDict */
+
+static MufDict *_mufBenchCreateFilledDict(const muf_char *keys, muf_usize count) {
+    MufDict *dict = mufCreateDict(muf_u64);
+    for (muf_usize i = 0; i < count; ++i) {
+        muf_u64 value = i;
+        mufDictInsert(dict, keys + i * MUF_BENCH_DICT_KEY_LEN, &value);
+    }
+    return dict;
+}
+
+static void _mufBenchDictInsert(MufBenchState *state) {
+    muf_char *keys = _mufBenchCreateStrKeys(state->param, MUF_BENCH_SEED);
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        MufDict *dict = _mufBenchCreateFilledDict(keys, state->param);
+        mufBenchDoNotOptimize(dict);
+        mufDestroyDict(dict);
+    }
+    mufFree(keys);
+    state->itemsProcessed = state->iterations * state->param;
+}
+
+static void _mufBenchDictFind(MufBenchState *state) {
+    mufBenchPauseTiming(state);
+    muf_usize count = state->param;
+    muf_char *keys = _mufBenchCreateStrKeys(count, MUF_BENCH_SEED);
+    MufDict *dict = _mufBenchCreateFilledDict(keys, count);
+    mufBenchResumeTiming(state);
+
+    muf_usize found = 0;
+    muf_usize index = 0;
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        found += mufDictGetRef(dict, keys + index * MUF_BENCH_DICT_KEY_LEN) != NULL;
+        index = index + 1 == count ? 0 : index + 1;
+    }
+    mufBenchDoNotOptimize(found);
+
+    mufBenchPauseTiming(state);
+    mufDestroyDict(dict);
+    mufFree(keys);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations;
+}
+
+static void _mufBenchDictErase(MufBenchState *state) {
+    muf_char *keys = _mufBenchCreateStrKeys(state->param, MUF_BENCH_SEED);
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        mufBenchPauseTiming(state);
+        MufDict *dict = _mufBenchCreateFilledDict(keys, state->param);
+        mufBenchResumeTiming(state);
+
+        for (muf_usize i = 0; i < state->param; ++i)
+            mufDictRemove(dict, keys + i * MUF_BENCH_DICT_KEY_LEN);
+        mufBenchDoNotOptimize(dict);
+        mufDestroyDict(dict);
+    }
+    mufFree(keys);
+    state->itemsProcessed = state->iterations * state->param;
+}
+
+void mufBenchRegisterContainers(void) {
+    static const muf_u64 sizes[] = { 1024, 16384, 262144 };
+
+    for (muf_usize i = 0; i < MUF_COUNTOF(sizes); ++i) {
+        mufBenchRegister("array/push", _mufBenchArrayPush, sizes[i]);
+        mufBenchRegister("array/push_reserved", _mufBenchArrayPushReserved, sizes[i]);
+        mufBenchRegister("array/pop", _mufBenchArrayPop, sizes[i]);
+    }
+    mufBenchRegister("array/insert_front", _mufBenchArrayInsertFront, 1024);
+    mufBenchRegister("array/insert_front", _mufBenchArrayInsertFront, 16384);
+    mufBenchRegister("array/insert_random", _mufBenchArrayInsertRandom, 1024);
+    mufBenchRegister("array/insert_random", _mufBenchArrayInsertRandom, 16384);
+    mufBenchRegister("array/remove_front", _mufBenchArrayRemoveFront, 1024);
+    mufBenchRegister("array/remove_front", _mufBenchArrayRemoveFront, 16384);
+
+    for (muf_usize i = 0; i < MUF_COUNTOF(sizes); ++i) {
+        mufBenchRegister("hash_map/insert", _mufBenchHashMapInsert, sizes[i]);
+        mufBenchRegister("hash_map/find_lf0.25", _mufBenchHashMapFindLf025, sizes[i]);
+        mufBenchRegister("hash_map/find_lf0.5", _mufBenchHashMapFindLf050, sizes[i]);
+        mufBenchRegister("hash_map/find_lf1.0", _mufBenchHashMapFindLf100, sizes[i]);
+        mufBenchRegister("hash_map/find_miss", _mufBenchHashMapFindMiss, sizes[i]);
+        mufBenchRegister("hash_map/erase", _mufBenchHashMapErase, sizes[i]);
+    }
+
+    for (muf_usize i = 0; i < MUF_COUNTOF(sizes); ++i) {
+        mufBenchRegister("hash_set/insert", _mufBenchHashSetInsert, sizes[i]);
+        mufBenchRegister("hash_set/find_lf0.25", _mufBenchHashSetFindLf025, sizes[i]);
+        mufBenchRegister("hash_set/find_lf1.0", _mufBenchHashSetFindLf100, sizes[i]);
+        mufBenchRegister("hash_set/erase", _mufBenchHashSetErase, sizes[i]);
+    }
+
+    for (muf_usize i = 0; i < MUF_COUNTOF(sizes); ++i) {
+        mufBenchRegister("dict/insert", _mufBenchDictInsert, sizes[i]);
+        mufBenchRegister("dict/find", _mufBenchDictFind, sizes[i]);
+        mufBenchRegister("dict/erase", _mufBenchDictErase, sizes[i]);
+    }
+}
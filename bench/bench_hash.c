@@ -0,0 +1,103 @@
+#include "bench.h"
+
+#include "muffin_core/hash.h"
+#include "muffin_core/math.h"
+#include "muffin_core/memory.h"
+
+static void _mufBenchHashBytes(MufBenchState *state) {
+    mufBenchPauseTiming(state);
+    muf_usize length = state->param;
+    muf_byte *data = mufAlloc(muf_byte, length);
+    muf_u64 seed = MUF_BENCH_SEED;
+    for (muf_usize i = 0; i < length; ++i)
+        data[i] = (muf_byte) mufBenchNextRandom(&seed);
+    mufBenchResumeTiming(state);
+
+    muf_index h = 0;
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        h ^= mufHashBytes(data, length);
+        mufBenchClobberMemory();
+    }
+    mufBenchDoNotOptimize(h);
+
+    mufBenchPauseTiming(state);
+    mufFree(data);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations;
+    state->bytesProcessed = state->iterations * length;
+}
+
+static void _mufBenchHashU64(MufBenchState *state) {
+    muf_u64 value = MUF_BENCH_SEED;
+    muf_index h = 0;
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        h ^= mufHash_u64(&value);
+        ++value;
+    }
+    mufBenchDoNotOptimize(h);
+    state->itemsProcessed = state->iterations;
+    state->bytesProcessed = state->iterations * sizeof(muf_u64);
+}
+
+static void _mufBenchHashStr(MufBenchState *state) {
+    mufBenchPauseTiming(state);
+    muf_usize length = state->param;
+    muf_char *str = mufAlloc(muf_char, length + 1);
+    muf_u64 seed = MUF_BENCH_SEED;
+    for (muf_usize i = 0; i < length; ++i)
+        str[i] = (muf_char) ('a' + mufBenchNextRandom(&seed) % 26);
+    str[length] = '\0';
+    mufBenchResumeTiming(state);
+
+    muf_index h = 0;
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        h ^= mufHash_str(str);
+        mufBenchClobberMemory();
+    }
+    mufBenchDoNotOptimize(h);
+
+    mufBenchPauseTiming(state);
+    mufFree(str);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations;
+    state->bytesProcessed = state->iterations * length;
+}
+
+/* The data is fed in 100-byte pieces, the hasher has to buffer across them */
+static void _mufBenchHasherUpdate(MufBenchState *state) {
+    mufBenchPauseTiming(state);
+    muf_usize length = state->param;
+    muf_byte *data = mufAlloc(muf_byte, length);
+    muf_u64 seed = MUF_BENCH_SEED;
+    for (muf_usize i = 0; i < length; ++i)
+        data[i] = (muf_byte) mufBenchNextRandom(&seed);
+    mufBenchResumeTiming(state);
+
+    muf_u64 h = 0;
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        MufHasher hasher;
+        mufInitHasher(&hasher, 0);
+        for (muf_usize offset = 0; offset < length; offset += 100)
+            mufHasherUpdate(&hasher, data + offset, mufMin(length - offset, (muf_usize) 100));
+        h ^= mufHasherDigest(&hasher);
+        mufBenchClobberMemory();
+    }
+    mufBenchDoNotOptimize(h);
+
+    mufBenchPauseTiming(state);
+    mufFree(data);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations;
+    state->bytesProcessed = state->iterations * length;
+}
+
+void mufBenchRegisterHash(void) {
+    static const muf_u64 lengths[] = { 8, 16, 64, 256, 4096, 65536, 1048576 };
+
+    mufBenchRegister("hash/u64", _mufBenchHashU64, 8);
+    for (muf_usize i = 0; i < MUF_COUNTOF(lengths); ++i)
+        mufBenchRegister("hash/bytes", _mufBenchHashBytes, lengths[i]);
+    mufBenchRegister("hash/str", _mufBenchHashStr, 16);
+    mufBenchRegister("hash/str", _mufBenchHashStr, 256);
+    mufBenchRegister("hash/hasher_update", _mufBenchHasherUpdate, 65536);
+}
@@ -0,0 +1,45 @@
+#include "bench.h"
+
+#include "muffin_core/log.h"
+
+#if defined(MUF_PLATFORM_WIN32)
+#   define MUF_BENCH_NULL_DEVICE "NUL"
+#else
+#   define MUF_BENCH_NULL_DEVICE "/dev/null"
+#endif
+
+/* Formatting and writing a record to a file stream, the sink discards the bytes */
+static void _mufBenchLogFile(MufBenchState *state) {
+    mufBenchPauseTiming(state);
+    MufLogger *logger = mufCreateFileLogger(MUF_BENCH_NULL_DEVICE);
+    mufBenchResumeTiming(state);
+
+    for (muf_u64 it = 0; it < state->iterations; ++it)
+        mufLoggerInfo(logger, "Frame %llu: %s took %.3f ms", (unsigned long long) it, "RenderPass", 1.25);
+
+    mufBenchPauseTiming(state);
+    mufDestroyLogger(logger);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations;
+}
+
+/* The cost of a call whose level is disabled */
+static void _mufBenchLogFiltered(MufBenchState *state) {
+    mufBenchPauseTiming(state);
+    MufLogger *logger = mufCreateFileLogger(MUF_BENCH_NULL_DEVICE);
+    mufLoggerDisable(logger, MUF_LOG_LEVEL_DEBUG);
+    mufBenchResumeTiming(state);
+
+    for (muf_u64 it = 0; it < state->iterations; ++it)
+        mufLoggerDebug(logger, "Frame %llu: %s took %.3f ms", (unsigned long long) it, "RenderPass", 1.25);
+
+    mufBenchPauseTiming(state);
+    mufDestroyLogger(logger);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations;
+}
+
+void mufBenchRegisterLog(void) {
+    mufBenchRegister("log/file", _mufBenchLogFile, 1);
+    mufBenchRegister("log/filtered", _mufBenchLogFiltered, 1);
+}
@@ -0,0 +1,302 @@
+#include "bench.h"
+
+#include "muffin_core/math.h"
+#include "muffin_core/math_batch.h"
+#include "muffin_core/memory.h"
+#include "muffin_core/random.h"
+
+static muf_f32 _mufBenchRandomFloat(muf_u64 *seed) {
+    return (muf_f32) (mufBenchNextRandom(seed) >> 40) / (muf_f32) (1 << 24) * 2.0F - 1.0F;
+}
+
+static MufMat4 _mufBenchRandomMat4(muf_u64 *seed) {
+    muf_f32 values[16];
+    for (muf_usize i = 0; i < 16; ++i)
+        values[i] = _mufBenchRandomFloat(seed);
+    MufMat4 mat;
+    mufMat4Load(&mat, values, 16);
+    return mat;
+}
+
+/* param is the count of elements processed per iteration, the working set stays in cache */
+
+typedef MufMat4 (*_MufBenchMat4BinaryFunc)(const MufMat4 *, const MufMat4 *);
+typedef MufMat4 (*_MufBenchMat4UnaryFunc)(const MufMat4 *);
+
+/* Inlined with a constant func so the SIMD kernels are measured without the indirect call */
+static MUF_INLINE void _mufBenchMat4Binary(MufBenchState *state, _MufBenchMat4BinaryFunc func) {
+    mufBenchPauseTiming(state);
+    muf_usize count = state->param;
+    muf_u64 seed = MUF_BENCH_SEED;
+    MufMat4 *a = mufAlloc(MufMat4, count);
+    MufMat4 *b = mufAlloc(MufMat4, count);
+    MufMat4 *c = mufAlloc(MufMat4, count);
+    for (muf_usize i = 0; i < count; ++i) {
+        a[i] = _mufBenchRandomMat4(&seed);
+        b[i] = _mufBenchRandomMat4(&seed);
+    }
+    mufBenchResumeTiming(state);
+
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        for (muf_usize i = 0; i < count; ++i)
+            c[i] = func(&a[i], &b[i]);
+        mufBenchClobberMemory();
+    }
+    mufBenchDoNotOptimize(c);
+
+    mufBenchPauseTiming(state);
+    mufFree(a);
+    mufFree(b);
+    mufFree(c);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations * count;
+}
+
+static void _mufBenchMat4Mul(MufBenchState *state) {
+    _mufBenchMat4Binary(state, mufMat4Mul);
+}
+
+static void _mufBenchMat4MulRef(MufBenchState *state) {
+    _mufBenchMat4Binary(state, mufMat4MulRef);
+}
+
+static MUF_INLINE void _mufBenchMat4Unary(MufBenchState *state, _MufBenchMat4UnaryFunc func) {
+    mufBenchPauseTiming(state);
+    muf_usize count = state->param;
+    muf_u64 seed = MUF_BENCH_SEED;
+    MufMat4 *a = mufAlloc(MufMat4, count);
+    MufMat4 *c = mufAlloc(MufMat4, count);
+    for (muf_usize i = 0; i < count; ++i)
+        a[i] = _mufBenchRandomMat4(&seed);
+    mufBenchResumeTiming(state);
+
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        for (muf_usize i = 0; i < count; ++i)
+            c[i] = func(&a[i]);
+        mufBenchClobberMemory();
+    }
+    mufBenchDoNotOptimize(c);
+
+    mufBenchPauseTiming(state);
+    mufFree(a);
+    mufFree(c);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations * count;
+}
+
+static void _mufBenchMat4Inverse(MufBenchState *state) {
+    _mufBenchMat4Unary(state, mufMat4Inverse);
+}
+
+static void _mufBenchMat4InverseRef(MufBenchState *state) {
+    _mufBenchMat4Unary(state, mufMat4InverseRef);
+}
+
+static void _mufBenchMat4MulBatch(MufBenchState *state) {
+    mufBenchPauseTiming(state);
+    muf_usize count = state->param;
+    muf_u64 seed = MUF_BENCH_SEED;
+    MufMat4 *a = mufAlloc(MufMat4, count);
+    MufMat4 *b = mufAlloc(MufMat4, count);
+    MufMat4 *c = mufAlloc(MufMat4, count);
+    for (muf_usize i = 0; i < count; ++i) {
+        a[i] = _mufBenchRandomMat4(&seed);
+        b[i] = _mufBenchRandomMat4(&seed);
+    }
+    mufBenchResumeTiming(state);
+
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        mufMat4MulBatch(a, b, c, count);
+        mufBenchClobberMemory();
+    }
+    mufBenchDoNotOptimize(c);
+
+    mufBenchPauseTiming(state);
+    mufFree(a);
+    mufFree(b);
+    mufFree(c);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations * count;
+}
+
+static void _mufBenchVec3TransformPointBatch(MufBenchState *state) {
+    mufBenchPauseTiming(state);
+    muf_usize count = state->param;
+    muf_u64 seed = MUF_BENCH_SEED;
+    MufMat4 transform = _mufBenchRandomMat4(&seed);
+    MufVec3 *src = mufAlloc(MufVec3, count);
+    MufVec3 *dst = mufAlloc(MufVec3, count);
+    for (muf_usize i = 0; i < count; ++i)
+        src[i] = mufCreateVec3(_mufBenchRandomFloat(&seed), _mufBenchRandomFloat(&seed), _mufBenchRandomFloat(&seed));
+    mufBenchResumeTiming(state);
+
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        mufVec3TransformPointBatch(&transform, src, dst, count);
+        mufBenchClobberMemory();
+    }
+    mufBenchDoNotOptimize(dst);
+
+    mufBenchPauseTiming(state);
+    mufFree(src);
+    mufFree(dst);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations * count;
+    state->bytesProcessed = state->iterations * count * sizeof(MufVec3) * 2;
+}
+
+static void _mufBenchVec4Transform(MufBenchState *state) {
+    mufBenchPauseTiming(state);
+    muf_usize count = state->param;
+    muf_u64 seed = MUF_BENCH_SEED;
+    MufMat4 transform = _mufBenchRandomMat4(&seed);
+    MufVec4 *src = mufAlloc(MufVec4, count);
+    MufVec4 *dst = mufAlloc(MufVec4, count);
+    for (muf_usize i = 0; i < count; ++i) {
+        src[i] = mufCreateVec4(_mufBenchRandomFloat(&seed), _mufBenchRandomFloat(&seed),
+            _mufBenchRandomFloat(&seed), 1.0F);
+    }
+    mufBenchResumeTiming(state);
+
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        for (muf_usize i = 0; i < count; ++i)
+            dst[i] = mufVec4Transform(src[i], &transform);
+        mufBenchClobberMemory();
+    }
+    mufBenchDoNotOptimize(dst);
+
+    mufBenchPauseTiming(state);
+    mufFree(src);
+    mufFree(dst);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations * count;
+    state->bytesProcessed = state->iterations * count * sizeof(MufVec4) * 2;
+}
+
+static void _mufBenchVec3Normalize(MufBenchState *state) {
+    mufBenchPauseTiming(state);
+    muf_usize count = state->param;
+    muf_u64 seed = MUF_BENCH_SEED;
+    MufVec3 *v = mufAlloc(MufVec3, count);
+    MufVec3 *n = mufAlloc(MufVec3, count);
+    for (muf_usize i = 0; i < count; ++i)
+        v[i] = mufCreateVec3(_mufBenchRandomFloat(&seed), _mufBenchRandomFloat(&seed), _mufBenchRandomFloat(&seed));
+    mufBenchResumeTiming(state);
+
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        for (muf_usize i = 0; i < count; ++i)
+            n[i] = mufVec3Normalize(v[i]);
+        mufBenchClobberMemory();
+    }
+    mufBenchDoNotOptimize(n);
+
+    mufBenchPauseTiming(state);
+    mufFree(v);
+    mufFree(n);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations * count;
+}
+
+static void _mufBenchVec3Cross(MufBenchState *state) {
+    mufBenchPauseTiming(state);
+    muf_usize count = state->param;
+    muf_u64 seed = MUF_BENCH_SEED;
+    MufVec3 *a = mufAlloc(MufVec3, count);
+    MufVec3 *b = mufAlloc(MufVec3, count);
+    MufVec3 *c = mufAlloc(MufVec3, count);
+    for (muf_usize i = 0; i < count; ++i) {
+        a[i] = mufCreateVec3(_mufBenchRandomFloat(&seed), _mufBenchRandomFloat(&seed), _mufBenchRandomFloat(&seed));
+        b[i] = mufCreateVec3(_mufBenchRandomFloat(&seed), _mufBenchRandomFloat(&seed), _mufBenchRandomFloat(&seed));
+    }
+    mufBenchResumeTiming(state);
+
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        for (muf_usize i = 0; i < count; ++i)
+            c[i] = mufVec3Cross(a[i], b[i]);
+        mufBenchClobberMemory();
+    }
+    mufBenchDoNotOptimize(c);
+
+    mufBenchPauseTiming(state);
+    mufFree(a);
+    mufFree(b);
+    mufFree(c);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations * count;
+}
+
+static void _mufBenchMT19937Next(MufBenchState *state) {
+    mufBenchPauseTiming(state);
+    muf_usize count = state->param;
+    MufMT19937 *generator = mufCreateMT19937(MUF_BENCH_SEED);
+    muf_u32 *out = mufAlloc(muf_u32, count);
+    mufBenchResumeTiming(state);
+
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        for (muf_usize i = 0; i < count; ++i)
+            out[i] = mufMT19937Next(generator);
+        mufBenchClobberMemory();
+    }
+    mufBenchDoNotOptimize(out);
+
+    mufBenchPauseTiming(state);
+    mufFree(out);
+    mufDestroyMT19937(generator);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations * count;
+}
+
+static void _mufBenchXoshiro256Next(MufBenchState *state) {
+    mufBenchPauseTiming(state);
+    muf_usize count = state->param;
+    MufXoshiro256 generator;
+    mufInitXoshiro256(&generator, MUF_BENCH_SEED);
+    muf_u32 *out = mufAlloc(muf_u32, count);
+    mufBenchResumeTiming(state);
+
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        for (muf_usize i = 0; i < count; ++i)
+            out[i] = (muf_u32) (mufXoshiro256Next(&generator) >> 32);
+        mufBenchClobberMemory();
+    }
+    mufBenchDoNotOptimize(out);
+
+    mufBenchPauseTiming(state);
+    mufFree(out);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations * count;
+}
+
+static void _mufBenchRandomFillF32(MufBenchState *state) {
+    mufBenchPauseTiming(state);
+    muf_usize count = state->param;
+    MufXoshiro256x4 generator;
+    mufInitXoshiro256x4(&generator, MUF_BENCH_SEED);
+    muf_f32 *out = mufAlloc(muf_f32, count);
+    mufBenchResumeTiming(state);
+
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        mufRandomFillF32(&generator, out, count, -1.0F, 1.0F);
+        mufBenchClobberMemory();
+    }
+    mufBenchDoNotOptimize(out);
+
+    mufBenchPauseTiming(state);
+    mufFree(out);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations * count;
+}
+
+void mufBenchRegisterMath(void) {
+    mufBenchRegister("math/mat4_mul", _mufBenchMat4Mul, 1024);
+    mufBenchRegister("math/mat4_mul_ref", _mufBenchMat4MulRef, 1024);
+    mufBenchRegister("math/mat4_mul_batch", _mufBenchMat4MulBatch, 1024);
+    mufBenchRegister("math/mat4_inverse", _mufBenchMat4Inverse, 1024);
+    mufBenchRegister("math/mat4_inverse_ref", _mufBenchMat4InverseRef, 1024);
+    mufBenchRegister("math/vec4_transform", _mufBenchVec4Transform, 4096);
+    mufBenchRegister("math/vec3_transform_point_batch", _mufBenchVec3TransformPointBatch, 4096);
+    mufBenchRegister("math/vec3_normalize", _mufBenchVec3Normalize, 4096);
+    mufBenchRegister("math/vec3_cross", _mufBenchVec3Cross, 4096);
+    mufBenchRegister("math/mt19937_next", _mufBenchMT19937Next, 4096);
+    mufBenchRegister("math/xoshiro256_next", _mufBenchXoshiro256Next, 4096);
+    mufBenchRegister("math/random_fill_f32", _mufBenchRandomFillF32, 4096);
+}
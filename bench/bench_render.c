@@ -0,0 +1,154 @@
+#include "bench.h"
+
+#include "muffin_render/backend.h"
+#include "muffin_render/commands.h"
+#include "muffin_render/render.mod.h"
+
+/* A backend whose commands do nothing, so the measured time is the dispatch path of mufCmd* only */
+
+static muf_u64 _mufNullCommandCount = 0;
+
+static void _mufNullInit(void) { }
+static void _mufNullFinish(void) { }
+
+static void _mufNullCopyBuffer(MufBuffer dst, muf_offset dstOffset, MufBuffer src, muf_offset srcOffset, muf_usize size) { ++_mufNullCommandCount; }
+static void _mufNullUpdateBuffer(MufBuffer dst, muf_offset offset, muf_usize size, muf_crawptr data) { ++_mufNullCommandCount; }
+static void _mufNullFillBuffer(MufBuffer dst, muf_offset offset, muf_usize size, muf_u32 data) { ++_mufNullCommandCount; }
+static void _mufNullCopyTexture(MufTexture dst, MufTextureCopyPos dstPos, MufTexture src, MufTextureCopyPos srcPos, MufExtent3i size) { ++_mufNullCommandCount; }
+static void _mufNullCopyTextureToBuffer(MufBuffer dst, muf_usize dstOffset, MufTexture src, MufTextureCopyPos srcPos, MufExtent3i size) { ++_mufNullCommandCount; }
+static void _mufNullCopyBufferToTexture(MufTexture dst, MufTextureCopyPos dstPos, MufBuffer src, muf_offset srcOffset, MufExtent3i size) { ++_mufNullCommandCount; }
+static void _mufNullGenerateMipmaps(MufTexture texture) { ++_mufNullCommandCount; }
+static void _mufNullUpdateTexture(MufTexture texture, MufOffset3i offset, MufExtent3i size, muf_crawptr data) { ++_mufNullCommandCount; }
+static void _mufNullSetPrimitiveTopology(MufPrimitiveTopology topology) { ++_mufNullCommandCount; }
+static void _mufNullSetPrimitiveRestartEnabled(muf_bool enabled) { ++_mufNullCommandCount; }
+static void _mufNullSetViewport(const MufViewport *viewport) { ++_mufNullCommandCount; }
+static void _mufNullSetScissor(const MufScissor *scissor) { ++_mufNullCommandCount; }
+static void _mufNullSetLineWidth(muf_f32 width) { ++_mufNullCommandCount; }
+static void _mufNullSetStencilWriteMask(MufStencilFaceFlags face, muf_u32 mask) { ++_mufNullCommandCount; }
+static void _mufNullSetStencilCompareMask(MufStencilFaceFlags face, muf_u32 mask) { ++_mufNullCommandCount; }
+static void _mufNullSetStencilRef(MufStencilFaceFlags face, muf_u32 ref) { ++_mufNullCommandCount; }
+static void _mufNullSetBlendConstant(MufRGBA rgba) { ++_mufNullCommandCount; }
+static void _mufNullSetClearColor(MufRGBA rgba) { ++_mufNullCommandCount; }
+static void _mufNullSetClearDepth(muf_f32 depth) { ++_mufNullCommandCount; }
+static void _mufNullSetClearStencil(muf_u32 stencil) { ++_mufNullCommandCount; }
+static void _mufNullBindPipeline(MufPipeline pipeline) { ++_mufNullCommandCount; }
+static void _mufNullBindVertexBuffers(const MufBuffer *buffers, const muf_offset *offsets, muf_index firstBindingIndex, muf_usize bindingCount) { ++_mufNullCommandCount; }
+static void _mufNullBindVertexBuffer(MufBuffer buffer, muf_offset offset, muf_index bindingIndex) { ++_mufNullCommandCount; }
+static void _mufNullBindIndexBuffer(MufBuffer buffer, muf_offset offset) { ++_mufNullCommandCount; }
+static void _mufNullBindResourceHeap(MufResourceHeap resourceHeap) { ++_mufNullCommandCount; }
+static void _mufNullBeginRenderPass(MufRenderPass renderPass) { ++_mufNullCommandCount; }
+static void _mufNullEndRenderPass(void) { ++_mufNullCommandCount; }
+static void _mufNullBeginTimerScope(const muf_char *name) { ++_mufNullCommandCount; }
+static void _mufNullEndTimerScope(void) { ++_mufNullCommandCount; }
+static void _mufNullEndFrame(void) { ++_mufNullCommandCount; }
+static void _mufNullDraw(muf_index firstIndex, muf_usize count) { ++_mufNullCommandCount; }
+static void _mufNullDrawIndexed(muf_index firstIndex, muf_usize count) { ++_mufNullCommandCount; }
+
+static const MufRenderBackendRegistry _mufNullBackendRegistry[1] = {{
+    .name = "null",
+    .init = _mufNullInit,
+    .finish = _mufNullFinish,
+    .api = {
+        .cmd = {
+            .copyBuffer                 = _mufNullCopyBuffer,
+            .updateBuffer               = _mufNullUpdateBuffer,
+            .fillBuffer                 = _mufNullFillBuffer,
+            .copyTexture                = _mufNullCopyTexture,
+            .copyTextureToBuffer        = _mufNullCopyTextureToBuffer,
+            .copyBufferToTexture        = _mufNullCopyBufferToTexture,
+            .generateMipmaps            = _mufNullGenerateMipmaps,
+            .updateTexture              = _mufNullUpdateTexture,
+            .setPrimitiveTopology       = _mufNullSetPrimitiveTopology,
+            .setPrimitiveRestartEnabled = _mufNullSetPrimitiveRestartEnabled,
+            .setViewport                = _mufNullSetViewport,
+            .setScissor                 = _mufNullSetScissor,
+            .setLineWidth               = _mufNullSetLineWidth,
+            .setStencilWriteMask        = _mufNullSetStencilWriteMask,
+            .setStencilCompareMask      = _mufNullSetStencilCompareMask,
+            .setStencilRef              = _mufNullSetStencilRef,
+            .setBlendConstant           = _mufNullSetBlendConstant,
+            .setClearColor              = _mufNullSetClearColor,
+            .setClearDepth              = _mufNullSetClearDepth,
+            .setClearStencil            = _mufNullSetClearStencil,
+            .bindPipeline               = _mufNullBindPipeline,
+            .bindVertexBuffers          = _mufNullBindVertexBuffers,
+            .bindVertexBuffer           = _mufNullBindVertexBuffer,
+            .bindIndexBuffer            = _mufNullBindIndexBuffer,
+            .bindResourceHeap           = _mufNullBindResourceHeap,
+            .beginRenderPass            = _mufNullBeginRenderPass,
+            .endRenderPass              = _mufNullEndRenderPass,
+            .beginTimerScope            = _mufNullBeginTimerScope,
+            .endTimerScope              = _mufNullEndTimerScope,
+            .endFrame                   = _mufNullEndFrame,
+            .draw                       = _mufNullDraw,
+            .drawIndexed                = _mufNullDrawIndexed
+        }
+    }
+}};
+
+static void _mufBenchUseNullBackend(void) {
+    static muf_bool initialized = MUF_FALSE;
+    if (initialized)
+        return;
+    mufRegisterModule(_muf_module_Render);
+    mufLoadModule(mufGetModule(_muf_module_Render->name));
+    mufRegisterRenderBackend(_mufNullBackendRegistry);
+    mufSetDefaultRenderBackend(mufGetRenderBackend(_mufNullBackendRegistry->name));
+    initialized = MUF_TRUE;
+}
+
+/* The baseline: an indirect call straight into the backend table */
+static void _mufBenchDirectCall(MufBenchState *state) {
+    void (* volatile draw)(muf_index, muf_usize) = _mufNullBackendRegistry->api.cmd.draw;
+    for (muf_u64 it = 0; it < state->iterations; ++it)
+        draw(0, 3);
+    state->itemsProcessed = state->iterations;
+}
+
+static void _mufBenchCmdDraw(MufBenchState *state) {
+    mufBenchPauseTiming(state);
+    _mufBenchUseNullBackend();
+    mufBenchResumeTiming(state);
+
+    for (muf_u64 it = 0; it < state->iterations; ++it)
+        mufCmdDraw(0, 3);
+    state->itemsProcessed = state->iterations;
+}
+
+/* A frame of `param` indexed draws with the usual per-draw state changes */
+static void _mufBenchCmdFrame(MufBenchState *state) {
+    mufBenchPauseTiming(state);
+    _mufBenchUseNullBackend();
+    MufViewport viewport = { 0, 0, 1920, 1080, 0.0F, 1.0F };
+    MufRGBA clearColor = { 0.0F, 0.0F, 0.0F, 1.0F };
+    MufRenderPass renderPass = mufNullHandle(MufRenderPass);
+    MufPipeline pipeline = mufNullHandle(MufPipeline);
+    MufBuffer vertexBuffer = mufNullHandle(MufBuffer);
+    MufBuffer indexBuffer = mufNullHandle(MufBuffer);
+    MufResourceHeap resourceHeap = mufNullHandle(MufResourceHeap);
+    mufBenchResumeTiming(state);
+
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        mufCmdSetClearColor(clearColor);
+        mufCmdBeginRenderPass(renderPass);
+        mufCmdSetViewport(&viewport);
+        for (muf_u64 i = 0; i < state->param; ++i) {
+            mufCmdBindPipeline(pipeline);
+            mufCmdBindResourceHeap(resourceHeap);
+            mufCmdBindVertexBuffer(vertexBuffer, 0, 0);
+            mufCmdBindIndexBuffer(indexBuffer, 0);
+            mufCmdDrawIndexed(0, 36);
+        }
+        mufCmdEndRenderPass();
+        mufCmdEndFrame();
+    }
+    mufBenchDoNotOptimize(_mufNullCommandCount);
+    state->itemsProcessed = state->iterations * (state->param * 5 + 5);
+}
+
+void mufBenchRegisterRender(void) {
+    mufBenchRegister("render/direct_call", _mufBenchDirectCall, 1);
+    mufBenchRegister("render/cmd_draw", _mufBenchCmdDraw, 1);
+    mufBenchRegister("render/cmd_frame", _mufBenchCmdFrame, 100);
+    mufBenchRegister("render/cmd_frame", _mufBenchCmdFrame, 10000);
+}
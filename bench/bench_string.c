@@ -0,0 +1,166 @@
+#include "bench.h"
+
+#include "muffin_core/memory.h"
+#include "muffin_core/string.h"
+
+/* Fill with text whose characters take 1 to 4 bytes, one in asciiEvery is non-ASCII */
+static muf_char *_mufBenchMakeUtf8(muf_usize length, muf_u32 asciiEvery) {
+    static const muf_char *const samples[] = { "\xC3\xA9", "\xD0\x96", "\xE4\xB8\xAD", "\xF0\x9F\x98\x80" };
+    muf_char *text = mufAlloc(muf_char, length + 1);
+    muf_u64 seed = MUF_BENCH_SEED;
+    muf_usize i = 0;
+    while (i < length) {
+        muf_u64 r = mufBenchNextRandom(&seed);
+        const muf_char *sample = samples[r % MUF_COUNTOF(samples)];
+        muf_usize sampleLength = mufCStrLength(sample);
+        if (asciiEvery != 0 && (r >> 8) % asciiEvery == 0 && i + sampleLength <= length) {
+            mufMemCopyBytes(text + i, sample, sampleLength);
+            i += sampleLength;
+        } else {
+            text[i++] = (muf_char) ('a' + (r >> 16) % 26);
+        }
+    }
+    text[length] = '\0';
+    return text;
+}
+
+/*
+ * Fill with characters of one width taken from [first, first + count), such as Cyrillic (2 bytes) or CJK (3 bytes).
+ * The transcoders vectorize such runs, text mixing widths goes through their scalar path. A count of 0 gives the
+ * mostly ASCII text of _mufBenchMakeUtf8.
+ */
+static muf_char *_mufBenchMakeUtf8Script(muf_usize length, muf_u32 first, muf_u32 count) {
+    if (count == 0)
+        return _mufBenchMakeUtf8(length, 16);
+
+    muf_usize width = first < 0x800 ? 2 : 3;
+    muf_char *text = mufAlloc(muf_char, length + 1);
+    muf_u64 seed = MUF_BENCH_SEED;
+    muf_usize i = 0;
+    for (; i + width <= length; i += width) {
+        muf_u32 codepoint = first + (muf_u32) (mufBenchNextRandom(&seed) % count);
+        if (width == 2) {
+            text[i] = (muf_char) (0xC0 | (codepoint >> 6));
+        } else {
+            text[i] = (muf_char) (0xE0 | (codepoint >> 12));
+            text[i + 1] = (muf_char) (0x80 | ((codepoint >> 6) & 0x3F));
+        }
+        text[i + width - 1] = (muf_char) (0x80 | (codepoint & 0x3F));
+    }
+    for (; i < length; ++i)
+        text[i] = ' ';
+    text[length] = '\0';
+    return text;
+}
+
+static void _mufBenchUtf8Validate(MufBenchState *state, muf_u32 asciiEvery) {
+    mufBenchPauseTiming(state);
+    muf_usize length = state->param;
+    muf_char *text = _mufBenchMakeUtf8(length, asciiEvery);
+    mufBenchResumeTiming(state);
+
+    muf_usize valid = 0;
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        valid += mufUtf8IsValidN(text, length);
+        mufBenchClobberMemory();
+    }
+    mufBenchDoNotOptimize(valid);
+
+    mufBenchPauseTiming(state);
+    mufFree(text);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations;
+    state->bytesProcessed = state->iterations * length;
+}
+
+static void _mufBenchUtf8ValidateAscii(MufBenchState *state) {
+    _mufBenchUtf8Validate(state, 0);
+}
+
+static void _mufBenchUtf8ValidateMixed(MufBenchState *state) {
+    _mufBenchUtf8Validate(state, 4);
+}
+
+static void _mufBenchUtf8ToUtf16Script(MufBenchState *state, muf_u32 first, muf_u32 count) {
+    mufBenchPauseTiming(state);
+    muf_usize length = state->param;
+    muf_char *text = _mufBenchMakeUtf8Script(length, first, count);
+    muf_u16 *out = mufAlloc(muf_u16, length + 1);
+    mufBenchResumeTiming(state);
+
+    muf_usize failures = 0;
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        failures += mufUtf8ToUtf16(out, length + 1, text, length) != MUF_UTF8_SUCCESS;
+        mufBenchClobberMemory();
+    }
+    mufBenchDoNotOptimize(failures);
+
+    mufBenchPauseTiming(state);
+    mufFree(out);
+    mufFree(text);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations;
+    state->bytesProcessed = state->iterations * length;
+}
+
+static void _mufBenchUtf8ToUtf16(MufBenchState *state) {
+    _mufBenchUtf8ToUtf16Script(state, 0, 0);
+}
+
+static void _mufBenchUtf8ToUtf16Cyrillic(MufBenchState *state) {
+    _mufBenchUtf8ToUtf16Script(state, 0x410, 0x40);
+}
+
+static void _mufBenchUtf8ToUtf16Cjk(MufBenchState *state) {
+    _mufBenchUtf8ToUtf16Script(state, 0x4E00, 0x5200);
+}
+
+/* The bytes processed are counted on the UTF-8 side in both directions */
+static void _mufBenchUtf16ToUtf8Script(MufBenchState *state, muf_u32 first, muf_u32 count) {
+    mufBenchPauseTiming(state);
+    muf_usize length = state->param;
+    muf_char *text = _mufBenchMakeUtf8Script(length, first, count);
+    muf_usize unitCount = mufUtf8GetUtf16Length(text, length);
+    muf_u16 *units = mufAlloc(muf_u16, unitCount + 1);
+    muf_char *out = mufAlloc(muf_char, length + 1);
+    mufUtf8ToUtf16(units, unitCount + 1, text, length);
+    mufBenchResumeTiming(state);
+
+    muf_usize failures = 0;
+    for (muf_u64 it = 0; it < state->iterations; ++it) {
+        failures += mufUtf16ToUtf8(out, length + 1, units, unitCount) != MUF_UTF8_SUCCESS;
+        mufBenchClobberMemory();
+    }
+    mufBenchDoNotOptimize(failures);
+
+    mufBenchPauseTiming(state);
+    mufFree(out);
+    mufFree(units);
+    mufFree(text);
+    mufBenchResumeTiming(state);
+    state->itemsProcessed = state->iterations;
+    state->bytesProcessed = state->iterations * length;
+}
+
+static void _mufBenchUtf16ToUtf8(MufBenchState *state) {
+    _mufBenchUtf16ToUtf8Script(state, 0, 0);
+}
+
+static void _mufBenchUtf16ToUtf8Cyrillic(MufBenchState *state) {
+    _mufBenchUtf16ToUtf8Script(state, 0x410, 0x40);
+}
+
+static void _mufBenchUtf16ToUtf8Cjk(MufBenchState *state) {
+    _mufBenchUtf16ToUtf8Script(state, 0x4E00, 0x5200);
+}
+
+void mufBenchRegisterString(void) {
+    mufBenchRegister("string/utf8_validate_ascii", _mufBenchUtf8ValidateAscii, 65536);
+    mufBenchRegister("string/utf8_validate_mixed", _mufBenchUtf8ValidateMixed, 65536);
+    mufBenchRegister("string/utf8_to_utf16", _mufBenchUtf8ToUtf16, 65536);
+    mufBenchRegister("string/utf8_to_utf16_cyrillic", _mufBenchUtf8ToUtf16Cyrillic, 65536);
+    mufBenchRegister("string/utf8_to_utf16_cjk", _mufBenchUtf8ToUtf16Cjk, 65536);
+    mufBenchRegister("string/utf16_to_utf8", _mufBenchUtf16ToUtf8, 65536);
+    mufBenchRegister("string/utf16_to_utf8_cyrillic", _mufBenchUtf16ToUtf8Cyrillic, 65536);
+    mufBenchRegister("string/utf16_to_utf8_cjk", _mufBenchUtf16ToUtf8Cjk, 65536);
+}
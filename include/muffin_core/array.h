@@ -170,6 +170,58 @@ MUF_API void mufArrayResize(MufArray *array, muf_usize newSize, muf_crawptr fill
         } \
     } while (0)
 
+typedef void(*MufArrayElementFunc)(muf_rawptr element, muf_index index, muf_rawptr userData);
+
+/**
+ * @brief Combine two elements into `result`. `result` may alias `lhs`, the operation must be associative.
+ */
+typedef void(*MufArrayCombineFunc)(muf_rawptr result, muf_crawptr lhs, muf_crawptr rhs);
+
+typedef MufUnaryFunc(MufArrayPredicate, muf_bool, muf_crawptr);
+
+/**
+ * @brief Call `func` on every element, spreading the work over the global thread pool.
+ * Small arrays are processed serially on the calling thread.
+ * @param[in] array The array object
+ * @param[in] func The function to be called with each element and its index
+ * @param[in] userData The argument passed to `func`
+ */
+MUF_API void mufArrayParallelForeach(MufArray *array, MufArrayElementFunc func, muf_rawptr userData);
+
+/**
+ * @brief Sort the array with a stable parallel merge sort
+ * @param[in] array The array object
+ * @param[in] cmp The comparator
+ */
+MUF_API void mufArrayParallelSort(MufArray *array, MufComparator cmp);
+
+/**
+ * @brief Reduce the array to a single element
+ * @param[in] array The array object
+ * @param[in] identity The value written to `resultOut` when the array is empty
+ * @param[in] combine The associative combine function
+ * @param[out] resultOut The result
+ */
+MUF_API void mufArrayParallelReduce(const MufArray *array, muf_crawptr identity, MufArrayCombineFunc combine, muf_rawptr resultOut);
+
+/**
+ * @brief Compute the inclusive prefix scan of `src` into `dst`, which is resized to fit and may be `src` itself
+ */
+MUF_API void mufArrayParallelInclusiveScan(const MufArray *src, MufArray *dst, MufArrayCombineFunc combine);
+
+/**
+ * @brief Compute the exclusive prefix scan of `src` into `dst`, which is resized to fit and may be `src` itself
+ */
+MUF_API void mufArrayParallelExclusiveScan(const MufArray *src, MufArray *dst, muf_crawptr identity, MufArrayCombineFunc combine);
+
+/**
+ * @brief Move the elements satisfying `pred` in front of the others, keeping the relative order of both groups
+ * @param[in] array The array object
+ * @param[in] pred The predicate
+ * @return The index of the first element not satisfying `pred`
+ */
+MUF_API muf_index mufArrayParallelStablePartition(MufArray *array, MufArrayPredicate pred);
+
 typedef struct MufArrayIterator {
     
 } MufArrayIterator;
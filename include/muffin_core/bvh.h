@@ -0,0 +1,63 @@
+#ifndef _MUFFIN_CORE_BVH_H_
+#define _MUFFIN_CORE_BVH_H_
+
+#include "muffin_core/array.h"
+#include "muffin_core/common.h"
+#include "muffin_core/geometry.h"
+
+/*
+ * A bounding volume hierarchy over boxes, built top-down with a binned surface area heuristic.
+ * The primitives are referred to by their index in the bounds array the tree is built from.
+ * Moving primitives are handled by refitting, which keeps the topology: rebuild once they have moved a lot.
+ */
+
+#define MUF_BVH_INVALID_INDEX 0xFFFFFFFFU
+
+typedef struct MufBvh_s MufBvh;
+
+/**
+ * @brief Intersect a primitive exactly, for the primitives whose box is only a bound
+ * @param[in] tMax The distance of the closest hit so far
+ * @param[out] tOut The distance of the hit
+ * @return True if the ray hits the primitive before tMax
+ */
+typedef muf_bool (*MufBvhRayFunc)(muf_u32 index, const MufRay *ray, muf_f32 tMax, muf_f32 *tOut, muf_rawptr userData);
+
+/**
+ * @brief Build a tree over boxes
+ * @param[in] bounds The box of each primitive
+ * @param[in] count The count of primitives
+ * @return The tree object, it does not keep a reference to bounds
+ */
+MUF_API MufBvh *mufCreateBvh(const MufAABB3 *bounds, muf_u32 count);
+MUF_API void mufDestroyBvh(MufBvh *bvh);
+
+/**
+ * @brief Update the boxes of the nodes after the primitives moved
+ * @param[in] bounds The new box of each primitive, with the indices and count the tree was built with
+ */
+MUF_API void mufBvhRefit(MufBvh *bvh, const MufAABB3 *bounds);
+
+MUF_API muf_u32 mufBvhGetNodeCount(const MufBvh *bvh);
+MUF_API MufAABB3 mufBvhGetBounds(const MufBvh *bvh);
+
+/**
+ * @brief Find the closest primitive along a ray, the nodes are visited front to back
+ * @param[in] tMax The end of the ray segment
+ * @param[in] func The exact test of a primitive, NULL tests the boxes only
+ * @param[out] tOut The distance of the hit. Can be NULL
+ * @return The index of the primitive, MUF_BVH_INVALID_INDEX if none is hit
+ */
+MUF_API muf_u32 mufBvhRaycast(const MufBvh *bvh, const MufRay *ray, muf_f32 tMax, MufBvhRayFunc func,
+    muf_rawptr userData, muf_f32 *tOut);
+
+/**
+ * @brief Collect the primitives whose box is not outside a frustum
+ *
+ * A node inside a plane skips that plane for its whole subtree, a node inside every plane is accepted without tests.
+ * @param[out] indicesOut An array of muf_u32 the indices are appended to
+ * @return The count of appended indices
+ */
+MUF_API muf_usize mufBvhQueryFrustum(const MufBvh *bvh, const MufFrustum *frustum, MufArray *indicesOut);
+
+#endif
@@ -83,6 +83,12 @@
 
 #define MUF_UNUSED(_variable) ((void) _variable)
 
+#if defined(_MSC_VER)
+#   define MUF_ALIGNAS(_alignment) __declspec(align(_alignment))
+#else
+#   define MUF_ALIGNAS(_alignment) __attribute__((aligned(_alignment)))
+#endif
+
 #if defined(_countof)
 #   define MUF_COUNTOF(_array) _countof(_array)
 #else
@@ -0,0 +1,72 @@
+#ifndef _MUFFIN_CORE_COMPRESSION_H_
+#define _MUFFIN_CORE_COMPRESSION_H_
+
+#include "muffin_core/common.h"
+#include "muffin_core/thread_pool.h"
+
+/**
+ * A block stream splits its input into independently compressed LZ4 blocks so they can be decoded in parallel:
+ *   MufBlockStreamHeader | muf_u32 blockSizes[blockCount] | blocks
+ * The top bit of a block size marks a block stored uncompressed (it did not shrink).
+ */
+#define MUF_BLOCK_STREAM_DEFAULT_BLOCK_SIZE (256U * 1024U)
+#define MUF_BLOCK_STREAM_STORED_BIT         0x80000000U
+
+typedef struct MufBlockStreamHeader_s {
+    muf_u32 blockSize;
+    muf_u32 blockCount;
+} MufBlockStreamHeader;
+
+/**
+ * @brief The state of an asynchronous decompression, it must stay alive until mufDecompressJobWait returns
+ */
+typedef struct MufDecompressJob_s {
+    MufThreadPool   *pool;
+    MufTaskCounter  counter;
+    volatile muf_u32 failed;
+    muf_rawptr      _tasks;
+} MufDecompressJob;
+
+/**
+ * @brief Get the worst case size of a block stream of `size` bytes
+ * @param[in] size The uncompressed size
+ * @param[in] blockSize The block size, 0 for the default
+ */
+MUF_API muf_usize mufCompressBound(muf_usize size, muf_u32 blockSize);
+
+/**
+ * @brief Compress into a block stream
+ * @param[in] src The data
+ * @param[in] srcSize The byte count of the data
+ * @param[out] dst The output buffer, at least mufCompressBound bytes is always enough
+ * @param[in] dstCapacity The byte count of the output buffer
+ * @param[in] blockSize The block size, 0 for the default
+ * @return The byte count of the stream, 0 if it does not fit into dst
+ */
+MUF_API muf_usize mufCompressBlocks(muf_crawptr src, muf_usize srcSize, muf_rawptr dst, muf_usize dstCapacity, muf_u32 blockSize);
+
+/**
+ * @brief Start decoding a block stream, one task per block is queued on the pool and the call returns immediately,
+ * so the caller can issue the next read while the blocks are decoded
+ * @param[in] pool The thread pool object, NULL means the global pool
+ * @param[in] src The stream, it must stay valid until the job is waited
+ * @param[in] srcSize The byte count of the stream
+ * @param[out] dst The output buffer
+ * @param[in] dstSize The uncompressed size, it must match the stream exactly
+ * @param[out] job The job to wait on
+ * @return False if the stream layout is invalid, nothing is queued then
+ */
+MUF_API muf_bool mufDecompressBlocksAsync(MufThreadPool *pool, muf_crawptr src, muf_usize srcSize, muf_rawptr dst, muf_usize dstSize, MufDecompressJob *job);
+
+/**
+ * @brief Wait for an asynchronous decompression, the calling thread helps decoding
+ * @return True if every block was decoded to its expected size
+ */
+MUF_API muf_bool mufDecompressJobWait(MufDecompressJob *job);
+
+/**
+ * @brief Decode a block stream in parallel and wait for it
+ */
+MUF_API muf_bool mufDecompressBlocks(MufThreadPool *pool, muf_crawptr src, muf_usize srcSize, muf_rawptr dst, muf_usize dstSize);
+
+#endif
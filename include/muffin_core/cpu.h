@@ -0,0 +1,62 @@
+#ifndef _MUFFIN_CORE_CPU_H_
+#define _MUFFIN_CORE_CPU_H_
+
+#include "muffin_core/common.h"
+
+/*
+ * Runtime detection of the instruction sets, for the kernels that ship several variants in one binary.
+ * An x86 feature is reported only when the OS also saves its registers (XGETBV), AVX and AVX-512 included.
+ *
+ * Dispatch is done with a kernel table per variant, ordered from the widest, each holding the features it requires.
+ * The first table whose features mufHasCpuFeatures accepts is selected on the first call and cached,
+ * the variants are compiled with MUF_SIMD_TARGET (see simd.h).
+ */
+
+typedef enum MufCpuFeatureFlags_e {
+    MUF_CPU_FEATURE_NONE        = 0,
+    MUF_CPU_FEATURE_SSE2        = 1 << 0,
+    MUF_CPU_FEATURE_SSE3        = 1 << 1,
+    MUF_CPU_FEATURE_SSSE3       = 1 << 2,
+    MUF_CPU_FEATURE_SSE41       = 1 << 3,
+    MUF_CPU_FEATURE_SSE42       = 1 << 4,
+    MUF_CPU_FEATURE_POPCNT      = 1 << 5,
+    MUF_CPU_FEATURE_AVX         = 1 << 6,
+    MUF_CPU_FEATURE_AVX2        = 1 << 7,
+    MUF_CPU_FEATURE_FMA         = 1 << 8,
+    MUF_CPU_FEATURE_F16C        = 1 << 9,
+    MUF_CPU_FEATURE_BMI1        = 1 << 10,
+    MUF_CPU_FEATURE_BMI2        = 1 << 11,
+    MUF_CPU_FEATURE_AVX512F     = 1 << 12,
+    MUF_CPU_FEATURE_AVX512DQ    = 1 << 13,
+    MUF_CPU_FEATURE_AVX512BW    = 1 << 14,
+    MUF_CPU_FEATURE_AVX512VL    = 1 << 15,
+    MUF_CPU_FEATURE_NEON        = 1 << 16,
+    MUF_CPU_FEATURE_ARM_CRC32   = 1 << 17,
+    MUF_CPU_FEATURE_ALL         = 0x7FFFFFFF
+} MufCpuFeatureFlags;
+
+/**
+ * @brief Get the features of the CPU, detected on the first call
+ * @return A combination of MufCpuFeatureFlags, restricted by the mask of mufSetCpuFeatureMask
+ */
+MUF_API MufCpuFeatureFlags mufCpuFeatures(void);
+
+/**
+ * @brief Check if the CPU has every feature of a combination
+ */
+MUF_API muf_bool mufHasCpuFeatures(MufCpuFeatureFlags features);
+
+/**
+ * @brief Hide features from the queries, to run the narrower kernels on a wide machine
+ *
+ * The kernel tables are selected on their first call, the mask must be set before any of them runs.
+ * @param[in] mask The features that can be reported, MUF_CPU_FEATURE_ALL by default
+ */
+MUF_API void mufSetCpuFeatureMask(MufCpuFeatureFlags mask);
+
+/**
+ * @brief Get the name of a single feature ("avx2", "neon"...), NULL for an unknown flag
+ */
+MUF_API const char *mufGetCpuFeatureName(MufCpuFeatureFlags feature);
+
+#endif
@@ -2,6 +2,15 @@
 #define _MUFFIN_CORE_DICT_H_
 
 #include "muffin_core/common.h"
+#include "muffin_core/intern.h"
+#include "muffin_core/string.h"
+
+/*
+ * A hash table keyed by strings. A key inserted as text is copied into the dict and freed with its entry.
+ * The functions ending in Id take the key as a MufStrId (see intern.h), the interned text is used as the key without
+ * a copy and a lookup by id compares pointers. The functions ending in Str take a MufStr and use its cached hash
+ * and length.
+ */
 
 typedef struct MufDict_s MufDict;
 
@@ -19,18 +28,34 @@ MUF_API muf_bool mufDictIsEmpty(const MufDict *dict);
 
 MUF_API muf_bool mufDictContains(const MufDict *dict, const muf_char *key);
 
+MUF_API muf_bool mufDictContainsId(const MufDict *dict, MufStrId key);
+
+MUF_API muf_bool mufDictContainsStr(const MufDict *dict, MufStr *key);
+
 MUF_API muf_rawptr mufDictGetRef(MufDict *dict, const muf_char *key);
 
+MUF_API muf_rawptr mufDictGetRefId(MufDict *dict, MufStrId key);
+
+MUF_API muf_rawptr mufDictGetRefStr(MufDict *dict, MufStr *key);
+
 MUF_API muf_bool mufDictGet(MufDict *dict, const muf_char *key, muf_rawptr out);
 
 MUF_API muf_rawptr mufDictInsert(MufDict *dict, const muf_char *key, muf_crawptr value);
 
+MUF_API muf_rawptr mufDictInsertId(MufDict *dict, MufStrId key, muf_crawptr value);
+
+MUF_API muf_rawptr mufDictInsertStr(MufDict *dict, MufStr *key, muf_crawptr value);
+
 MUF_API void mufDictInsertOrAssign(MufDict *dict, const muf_char *key, muf_crawptr value);
 
 MUF_API void mufDictPut(MufDict *dict, const muf_char *key, muf_crawptr value);
 
 MUF_API muf_bool mufDictRemove(MufDict *dict, const muf_char *key);
 
+MUF_API muf_bool mufDictRemoveId(MufDict *dict, MufStrId key);
+
+MUF_API muf_bool mufDictRemoveStr(MufDict *dict, MufStr *key);
+
 #define mufDictRemoveX(_dict, _key, _destroy) \
     do { muf_rawptr v = mufDictGetRef(_dict, _key); mufDictRemove(_dict, _key); _destroy(v); } while (0)
 
@@ -0,0 +1,83 @@
+#ifndef _MUFFIN_CORE_GEOMETRY_H_
+#define _MUFFIN_CORE_GEOMETRY_H_
+
+#include "muffin_core/common.h"
+#include "muffin_core/math.h"
+
+/*
+ * Planes are stored as MufVec4 (n.x, n.y, n.z, d), a point p is on the inner side when dot(n, p) + d >= 0.
+ * Frustums follow the OpenGL clip space, -w <= z <= w.
+ */
+
+typedef enum MufFrustumPlane_e {
+    MUF_FRUSTUM_PLANE_LEFT,
+    MUF_FRUSTUM_PLANE_RIGHT,
+    MUF_FRUSTUM_PLANE_BOTTOM,
+    MUF_FRUSTUM_PLANE_TOP,
+    MUF_FRUSTUM_PLANE_NEAR,
+    MUF_FRUSTUM_PLANE_FAR,
+    MUF_ENUM_COUNT(MUF_FRUSTUM_PLANE)
+} MufFrustumPlane;
+
+typedef enum MufCullResult_e {
+    MUF_CULL_RESULT_OUTSIDE,
+    MUF_CULL_RESULT_INTERSECT,
+    MUF_CULL_RESULT_INSIDE
+} MufCullResult;
+
+typedef struct MufFrustum_s {
+    /* The planes face inwards and are normalized, indexed by MufFrustumPlane */
+    MufVec4 planes[_MUF_FRUSTUM_PLANE_COUNT_];
+} MufFrustum;
+
+typedef struct MufSphere_s {
+    MufVec3 center;
+    muf_f32 radius;
+} MufSphere;
+
+typedef struct MufRay_s {
+    MufVec3 origin;
+    /* Not required to be normalized, distances are then in units of its length */
+    MufVec3 direction;
+} MufRay;
+
+/**
+ * @brief Extract the planes of the frustum of a view-projection matrix (Gribb-Hartmann)
+ */
+MUF_API void mufExtractFrustum(const MufMat4 *viewProjection, MufFrustum *frustumOut);
+
+MUF_API MufVec4 mufPlaneNormalize(MufVec4 plane);
+MUF_API muf_f32 mufPlaneDistance(MufVec4 plane, MufVec3 point);
+
+MUF_API MufAABB3 mufAABB3Union(MufAABB3 a, MufAABB3 b);
+MUF_API muf_bool mufAABB3Overlaps(MufAABB3 a, MufAABB3 b);
+MUF_API muf_bool mufAABB3Contains(MufAABB3 box, MufVec3 point);
+MUF_API muf_f32 mufAABB3SurfaceArea(MufAABB3 box);
+
+MUF_API MufCullResult mufFrustumTestAABB3(const MufFrustum *frustum, MufAABB3 box);
+MUF_API MufCullResult mufFrustumTestSphere(const MufFrustum *frustum, MufSphere sphere);
+
+/**
+ * @brief Test bounding boxes against a frustum, the planes are tested in parallel for each box
+ * @param[out] resultsOut The MufCullResult of each box
+ * @return The count of boxes that are not outside
+ */
+MUF_API muf_usize mufFrustumCullAABB3Batch(const MufFrustum *frustum, const MufAABB3 *bounds, muf_usize count,
+    muf_u8 *resultsOut);
+
+/**
+ * @brief Test spheres against a frustum
+ * @param[out] resultsOut The MufCullResult of each sphere
+ * @return The count of spheres that are not outside
+ */
+MUF_API muf_usize mufFrustumCullSphereBatch(const MufFrustum *frustum, const MufSphere *spheres, muf_usize count,
+    muf_u8 *resultsOut);
+
+/**
+ * @brief Intersect a ray with a box (slab test)
+ * @param[in] tMax The end of the ray segment, which starts at 0
+ * @param[out] tOut The entry distance, 0 when the origin is inside. Can be NULL
+ */
+MUF_API muf_bool mufRayIntersectAABB3(const MufRay *ray, MufAABB3 box, muf_f32 tMax, muf_f32 *tOut);
+
+#endif
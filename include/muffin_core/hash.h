@@ -5,6 +5,50 @@
 
 typedef muf_index(*MufHash)(muf_crawptr);
 
+/*
+ * The byte hashes are 64-bit: inputs up to MUF_HASH_SHORT_MAX bytes take a multiply-mix path (wyhash style), longer
+ * ones are read in 64-byte stripes by eight accumulators (xxHash3 style), with SSE2 or AVX2 chosen at runtime.
+ * The hashes are not cryptographic, seeds only make collisions harder to predict.
+ */
+
+#define MUF_HASH_SHORT_MAX 256
+
+/**
+ * @brief The streaming state of mufHashBytes64, about 500 bytes
+ */
+typedef struct MufHasher_s {
+    muf_u64     acc[8];
+    muf_u64     secret[16];
+    muf_u64     seed;
+    muf_u64     totalLength;
+    muf_u32     blockStripe;
+    muf_u32     bufferSize;
+    muf_byte    buffer[MUF_HASH_SHORT_MAX];
+    /* The last 64 bytes before the buffer, the final stripe may overlap them */
+    muf_byte    lastStripe[64];
+} MufHasher;
+
+/**
+ * @brief Mix the bits of a 64-bit integer (the MurmurHash3 finalizer), for fixed-size keys
+ */
+MUF_INTERNAL MUF_INLINE muf_u64 mufHashMix64(muf_u64 value) {
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDULL;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+MUF_INTERNAL MUF_INLINE muf_u32 mufHashMix32(muf_u32 value) {
+    value ^= value >> 16;
+    value *= 0x85EBCA6BU;
+    value ^= value >> 13;
+    value *= 0xC2B2AE35U;
+    value ^= value >> 16;
+    return value;
+}
+
 MUF_API muf_index mufHash_i8 (muf_crawptr value);
 MUF_API muf_index mufHash_i16(muf_crawptr value);
 MUF_API muf_index mufHash_i32(muf_crawptr value);
@@ -19,4 +63,25 @@ MUF_API muf_index mufHash_str(muf_crawptr value);
 MUF_API muf_index mufHash_ptr(muf_crawptr value);
 MUF_API muf_index mufHashBytes(muf_crawptr data, muf_usize length);
 
-#endif
\ No newline at end of file
+/**
+ * @brief Hash bytes with a seed, the data has no alignment requirement
+ */
+MUF_API muf_u64 mufHashBytes64(muf_crawptr data, muf_usize length, muf_u64 seed);
+
+/**
+ * @brief Get a different seed on every call, they also differ between runs of the program
+ */
+MUF_API muf_u64 mufGenerateHashSeed(void);
+
+/**
+ * @brief Start hashing data given in pieces, the digest equals mufHashBytes64 of the concatenated pieces
+ */
+MUF_API void mufInitHasher(MufHasher *hasher, muf_u64 seed);
+MUF_API void mufHasherUpdate(MufHasher *hasher, muf_crawptr data, muf_usize length);
+
+/**
+ * @brief Get the hash of the data so far, the hasher can keep taking data afterwards
+ */
+MUF_API muf_u64 mufHasherDigest(const MufHasher *hasher);
+
+#endif
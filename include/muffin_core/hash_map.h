@@ -3,6 +3,7 @@
 
 #include "muffin_core/common.h"
 #include "muffin_core/hash.h"
+#include "muffin_core/intern.h"
 
 typedef struct MufHashMap_s MufHashMap;
 
@@ -81,5 +82,6 @@ MUF_API void mufHashMapForEach(MufHashMap *map, MufBinary2Func(func, void, muf_c
 #define mufCreateHashMap_u16(_valueType) mufCreateHashMap(muf_u16, _valueType, mufEqual_u16, mufHash_u16)
 #define mufCreateHashMap_u32(_valueType) mufCreateHashMap(muf_u32, _valueType, mufEqual_u32, mufHash_u32)
 #define mufCreateHashMap_u64(_valueType) mufCreateHashMap(muf_u64, _valueType, mufEqual_u64, mufHash_u64)
+#define mufCreateHashMap_strId(_valueType) mufCreateHashMap(MufStrId, _valueType, mufEqual_strId, mufHash_strId)
 
 #endif
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "muffin_core/common.h"
 #include "muffin_core/hash.h"
+#include "muffin_core/intern.h"
 
 typedef struct MufHashSet_s MufHashSet;
 
@@ -72,5 +73,6 @@ void mufHashSetForEach(MufHashSet *set, void (*unaryFunc)(muf_rawptr item));
 #define mufCreateHashSet_u16() mufCreateHashSet(muf_u16, mufEqual_u16, mufHash_u16)
 #define mufCreateHashSet_u32() mufCreateHashSet(muf_u32, mufEqual_u32, mufHash_u32)
 #define mufCreateHashSet_u64() mufCreateHashSet(muf_u64, mufEqual_u64, mufHash_u64)
+#define mufCreateHashSet_strId() mufCreateHashSet(MufStrId, mufEqual_strId, mufHash_strId)
 
 #endif
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef _MUFFIN_CORE_INTERN_H_
+#define _MUFFIN_CORE_INTERN_H_
+
+#include "muffin_core/common.h"
+
+/*
+ * A process-wide string interner. Each distinct string gets a 32-bit id. Its text is copied once into an arena and
+ * its hash is computed once at intern time. Two ids are equal exactly when their strings are equal.
+ * Interning and finding take a spin lock, they are meant for load time. Reading the text, length or hash of an id
+ * takes no lock. Interned strings live until the process exits, dicts and maps keyed by id rely on it.
+ */
+
+typedef muf_u32 MufStrId;
+
+#define MUF_STR_ID_INVALID 0U
+
+/* The ids run from 1, the interner holds at most this many strings */
+#define MUF_INTERN_MAX_STRS ((1U << 24) - 1)
+
+/**
+ * @brief Get the id of a string, interning it on first use
+ * @param[in] str A null-terminated string
+ * @return The id, or MUF_STR_ID_INVALID once MUF_INTERN_MAX_STRS strings have been interned
+ */
+MUF_API MufStrId mufInternStr(const muf_char *str);
+
+/**
+ * @brief Get the id of the first length bytes of a string, which may contain null characters
+ */
+MUF_API MufStrId mufInternStrN(const muf_char *str, muf_usize length);
+
+/**
+ * @brief Get the id of a string if it has been interned, without interning it
+ * @return The id, or MUF_STR_ID_INVALID
+ */
+MUF_API MufStrId mufFindStrId(const muf_char *str);
+
+MUF_API MufStrId mufFindStrIdN(const muf_char *str, muf_usize length);
+
+/**
+ * @brief Get the interned text of an id, null-terminated and at a fixed address
+ * @return The text, or NULL for MUF_STR_ID_INVALID
+ */
+MUF_API const muf_char *mufGetStrIdCStr(MufStrId id);
+
+MUF_API muf_usize mufGetStrIdLength(MufStrId id);
+
+/**
+ * @brief Get the hash recorded for an id, it equals mufHashBytes64(text, length, 0) and is the same in every run
+ */
+MUF_API muf_u64 mufGetStrIdHash(MufStrId id);
+
+MUF_API muf_usize mufGetInternedStrCount(void);
+
+/* Hash maps and sets keyed by MufStrId compare and hash the id alone */
+#define mufEqual_strId mufEqual_u32
+#define mufHash_strId  mufHash_u32
+
+#endif
@@ -196,7 +196,8 @@ typedef struct MufVec3_s {
     muf_f32 x, y, z;
 } MufVec3;
 
-typedef struct MufVec4_s {
+/* 16-byte aligned so a vector is a single SIMD load, see math_simd.h */
+typedef struct MUF_ALIGNAS(16) MufVec4_s {
     muf_f32 x, y, z, w;
 } MufVec4;
 
@@ -265,7 +266,6 @@ MUF_API void mufVec4ToArray(MufVec4 vec, muf_f32 *array);
 
 MUF_API MufVec2 mufVec2Negate(MufVec2 v);
 MUF_API MufVec3 mufVec3Negate(MufVec3 v);
-MUF_API MufVec4 mufVec4Negate(MufVec4 v);
 
 /**
  * @brief Add two vectors
@@ -283,21 +283,11 @@ MUF_API MufVec2 mufVec2Add(MufVec2 v1, MufVec2 v2);
  */
 MUF_API MufVec3 mufVec3Add(MufVec3 v1, MufVec3 v2);
 
-/**
- * @brief Add two vectors
- * @param[in] v1 The first vector
- * @param[in] v2 The second vector
- * @return The result vector (v1 + v2)
- */
-MUF_API MufVec4 mufVec4Add(MufVec4 v1, MufVec4 v2);
-
 MUF_API MufVec2 mufVec2Sub(MufVec2 v1, MufVec2 v2);
 MUF_API MufVec3 mufVec3Sub(MufVec3 v1, MufVec3 v2);
-MUF_API MufVec4 mufVec4Sub(MufVec4 v1, MufVec4 v2);
 
 MUF_API MufVec2 mufVec2Mul(MufVec2 v, muf_f32 s);
 MUF_API MufVec3 mufVec3Mul(MufVec3 v, muf_f32 s);
-MUF_API MufVec4 mufVec4Mul(MufVec4 v, muf_f32 s);
 
 MUF_API MufVec2 mufVec2Div(MufVec2 v, muf_f32 s);
 MUF_API MufVec3 mufVec3Div(MufVec3 v, muf_f32 s);
@@ -305,7 +295,6 @@ MUF_API MufVec4 mufVec4Div(MufVec4 v, muf_f32 s);
 
 MUF_API MufVec2 mufVec2Scale(MufVec2 v, muf_f32 s);
 MUF_API MufVec3 mufVec3Scale(MufVec3 v, muf_f32 s);
-MUF_API MufVec4 mufVec4Scale(MufVec4 v, muf_f32 s);
 
 MUF_API muf_f32 mufVec2Dot(MufVec2 v1, MufVec2 v2);
 MUF_API muf_f32 mufVec3Dot(MufVec3 v1, MufVec3 v2);
@@ -315,7 +304,6 @@ MUF_API MufVec3 mufVec3Cross(MufVec3 v1, MufVec3 v2);
 
 MUF_API MufVec2 mufVec2Hadamard(MufVec2 v1, MufVec2 v2);
 MUF_API MufVec3 mufVec3Hadamard(MufVec3 v1, MufVec3 v2);
-MUF_API MufVec4 mufVec4Hadamard(MufVec4 v1, MufVec4 v2);
 
 MUF_API muf_f32 mufVec2Length2(MufVec2 v);
 MUF_API muf_f32 mufVec3Length2(MufVec3 v);
@@ -363,12 +351,17 @@ MUF_API MufRGBA mufRGBASub(MufRGBA c1, MufRGBA c2);
 MUF_API MufRGBA mufRGBAMul(MufRGBA c1, MufRGBA c2);
 MUF_API MufRGBA mufRGBAScale(MufRGBA c, muf_f32 s);
 
-typedef struct MufQuat4_s {
+/* A rotation quaternion, w is the real part */
+typedef struct MUF_ALIGNAS(16) MufQuat4_s {
 	muf_f32 x, y, z, w;
 } MufQuat4;
 
-MufQuat4 mufCreateQuat4(muf_f32 x, muf_f32 y, muf_f32 z, muf_f32 w);
-MufQuat4 mufCreateQuat4AR();
+/**
+ * @brief Create a quaternion rotating around an axis
+ * @param[in] axis The normalized axis
+ * @param[in] rotation The angle expressed in radians
+ */
+MUF_API MufQuat4 mufQuat4FromAxisAngle(MufVec3 axis, muf_f32 rotation);
 
 typedef union MufMat2_u {
 	muf_f32 values[2][2];
@@ -431,7 +424,6 @@ MUF_API MufMat4 *mufMat4SubBy(MufMat4 *base, const MufMat4 *mat);
 
 MUF_API MufMat2 mufMat2Mul(const MufMat2 *a, const MufMat2 *b);
 MUF_API MufMat3 mufMat3Mul(const MufMat3 *a, const MufMat3 *b);
-MUF_API MufMat4 mufMat4Mul(const MufMat4 *a, const MufMat4 *b);
 
 MUF_API MufMat2 *mufMat2MulBy(MufMat2 *base, const MufMat2 *mat);
 MUF_API MufMat3 *mufMat3MulBy(MufMat3 *base, const MufMat3 *mat);
@@ -443,23 +435,18 @@ MUF_API MufMat4 mufMat4Scale(const MufMat4 *mat, muf_f32 s);
 
 MUF_API MufMat2 mufMat2Inverse(const MufMat2 *mat);
 MUF_API MufMat3 mufMat3Inverse(const MufMat3 *mat);
-MUF_API MufMat4 mufMat4Inverse(const MufMat4 *mat);
 
 MUF_API MufMat2 mufMat2Transpose(const MufMat2 *mat);
 MUF_API MufMat3 mufMat3Transpose(const MufMat3 *mat);
-MUF_API MufMat4 mufMat4Transpose(const MufMat4 *mat);
 
 MUF_API muf_f32 mufMat2Determinant(const MufMat2 *mat);
 MUF_API muf_f32 mufMat3Determinant(const MufMat3 *mat);
-MUF_API muf_f32 mufMat4Determinant(const MufMat4 *mat);
 
 MUF_API MufVec2 mufVec2MulMat(MufVec2 vec, const MufMat2 *mat);
 MUF_API MufVec3 mufVec3MulMat(MufVec3 vec, const MufMat3 *mat);
-MUF_API MufVec4 mufVec4MulMat(MufVec4 vec, const MufMat4 *mat);
 
 MUF_API MufVec2 mufMat2MulVec(const MufMat2 *mat, MufVec2 vec);
 MUF_API MufVec3 mufMat3MulVec(const MufMat3 *mat, MufVec3 vec);
-MUF_API MufVec4 mufMat4MulVec(const MufMat4 *mat, MufVec4 vec);
 
 MUF_API MufMat4 *mufRotateX(MufMat4 *base, muf_f32 rotation);
 MUF_API MufMat4 *mufRotateY(MufMat4 *base, muf_f32 rotation);
@@ -473,8 +460,19 @@ MUF_API MufMat4 *mufShearY(MufMat4 *base, muf_f32 s, muf_f32 t);
 MUF_API MufMat4 *mufShearZ(MufMat4 *base, muf_f32 s, muf_f32 t);
 MUF_API MufMat4 *mufMirror(MufMat4 *base, MufVec3 axis);
 
-MUF_API MufVec3 mufVec3Transform(MufVec3 vec, const MufMat4 *transform);
-MUF_API MufVec4 mufVec4Transform(MufVec4 vec, const MufMat4 *transform);
+MUF_API MufMat4 mufQuat4ToMat4(MufQuat4 q);
+
+/*
+ * Scalar references of the kernels in math_simd.h. The scalar builds use them directly and the SIMD paths are checked against them.
+ */
+MUF_API MufMat4 mufMat4MulRef(const MufMat4 *a, const MufMat4 *b);
+MUF_API MufMat4 mufMat4InverseRef(const MufMat4 *mat);
+MUF_API MufMat4 mufMat4TransposeRef(const MufMat4 *mat);
+MUF_API muf_f32 mufMat4DeterminantRef(const MufMat4 *mat);
+MUF_API MufVec4 mufMat4MulVecRef(const MufMat4 *mat, MufVec4 vec);
+MUF_API MufVec4 mufVec4MulMatRef(MufVec4 vec, const MufMat4 *mat);
+MUF_API MufQuat4 mufQuat4MulRef(MufQuat4 q1, MufQuat4 q2);
+MUF_API MufVec3 mufQuat4RotateVec3Ref(MufQuat4 q, MufVec3 v);
 
 typedef struct MufAABB2_s {
 	MufVec2 min;
@@ -596,5 +594,7 @@ typedef struct MufOffset3i_s {
 #define MUF_VEC3_FORWARD 	(MufVec3) {  0.0F,  0.0F,  1.0F }
 #define MUF_VEC3_BACK 		(MufVec3) {  0.0F,  0.0F, -1.0F }
 
+/* The Vec4, Mat4 and Quat4 kernels are inline, they need every type above */
+#include "muffin_core/math_simd.h"
 
 #endif
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef _MUFFIN_CORE_MATH_BATCH_H_
+#define _MUFFIN_CORE_MATH_BATCH_H_
+
+#include "muffin_core/common.h"
+#include "muffin_core/math.h"
+
+/*
+ * Stream versions of the Mat4 kernels for large arrays, such as the world matrices of a scene.
+ * The widest variant the CPU supports (AVX-512F, AVX or the baseline of math_simd.h) is selected on the first call.
+ * Every variant multiplies and adds in the same order without fusing, the results do not depend on the CPU.
+ * The outputs may alias the inputs only when they are the same array.
+ */
+
+/**
+ * @brief Eight 3D vectors stored as structure of arrays, the block layout of the SoA kernels
+ */
+typedef struct MUF_ALIGNAS(32) MufVec3x8_s {
+    muf_f32 x[8];
+    muf_f32 y[8];
+    muf_f32 z[8];
+} MufVec3x8;
+
+/**
+ * @brief Get the name of the selected variant ("avx512f", "avx" or "baseline")
+ */
+MUF_API const char *mufGetMathBatchTarget(void);
+
+/**
+ * @brief Multiply pairs of matrices, out[i] = a[i] * b[i]
+ */
+MUF_API void mufMat4MulBatch(const MufMat4 *a, const MufMat4 *b, MufMat4 *out, muf_usize count);
+
+/**
+ * @brief Multiply a shared matrix by an array of matrices, out[i] = mat * b[i]
+ */
+MUF_API void mufMat4MulSharedBatch(const MufMat4 *mat, const MufMat4 *b, MufMat4 *out, muf_usize count);
+
+/**
+ * @brief Transform directions (w = 0) like mufVec3Transform
+ */
+MUF_API void mufVec3TransformBatch(const MufMat4 *transform, const MufVec3 *vecs, MufVec3 *out, muf_usize count);
+
+/**
+ * @brief Transform points (w = 1), the projective divide is not applied
+ */
+MUF_API void mufVec3TransformPointBatch(const MufMat4 *transform, const MufVec3 *vecs, MufVec3 *out, muf_usize count);
+
+/**
+ * @brief Transform blocks of points (w = 1)
+ * @param[in] blockCount The count of blocks, eight points each
+ */
+MUF_API void mufVec3x8TransformPointBatch(const MufMat4 *transform, const MufVec3x8 *blocks, MufVec3x8 *out,
+    muf_usize blockCount);
+
+/**
+ * @brief Pack vectors into blocks, the tail of the last block repeats the last vector
+ * @param[out] blocks The blocks, (count + 7) / 8 of them
+ */
+MUF_API void mufVec3x8Pack(const MufVec3 *vecs, muf_usize count, MufVec3x8 *blocks);
+
+/**
+ * @brief Unpack the first count vectors of blocks
+ */
+MUF_API void mufVec3x8Unpack(const MufVec3x8 *blocks, muf_usize count, MufVec3 *vecs);
+
+/**
+ * @brief Transform bounding boxes, out[i] is the box enclosing bounds[i] transformed by transforms[i]
+ *
+ * The center is transformed as a point and the half extents by the absolute value of the upper 3x3 (Arvo).
+ * The transforms must be affine.
+ */
+MUF_API void mufAABB3TransformBatch(const MufMat4 *transforms, const MufAABB3 *bounds, MufAABB3 *out,
+    muf_usize count);
+
+#endif
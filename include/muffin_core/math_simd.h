@@ -0,0 +1,393 @@
+#ifndef _MUFFIN_CORE_MATH_SIMD_H_
+#define _MUFFIN_CORE_MATH_SIMD_H_
+
+/*
+ * Inline Vec4, Mat4 and Quat4 kernels. The instruction set is picked at compile time (see simd.h): SSE2, SSE4.1 and
+ * AVX on x86, NEON on ARM. Without any of them, or for the kernels NEON does not cover, the scalar references of
+ * math.c are called. Matrices are column major, values[column][row].
+ */
+
+#include "muffin_core/math.h"
+#include "muffin_core/simd.h"
+
+#if defined(MUF_SIMD_ENABLED)
+#   define _mufSimd4fLoadVec(_v) mufSimd4fLoad(&(_v).x)
+#   define _mufSimd4fLoadColumn(_mat, _index) mufSimd4fLoad((_mat)->values[_index])
+
+static MUF_INLINE MufVec4 _mufSimd4fToVec4(MufSimd4f v) {
+    MufVec4 result;
+    mufSimd4fStore(&result.x, v);
+    return result;
+}
+
+static MUF_INLINE MufQuat4 _mufSimd4fToQuat4(MufSimd4f v) {
+    MufQuat4 result;
+    mufSimd4fStore(&result.x, v);
+    return result;
+}
+#endif
+
+#if defined(MUF_SIMD_SSE2)
+#   define _mufSimd4fShuffle(_v, _x, _y, _z, _w) _mm_shuffle_ps((_v), (_v), _MM_SHUFFLE(_w, _z, _y, _x))
+#endif
+
+static MUF_INLINE MufVec4 mufVec4Negate(MufVec4 v) {
+#if defined(MUF_SIMD_ENABLED)
+    return _mufSimd4fToVec4(mufSimd4fNegate(_mufSimd4fLoadVec(v)));
+#else
+    return (MufVec4) { -v.x, -v.y, -v.z, -v.w };
+#endif
+}
+
+/**
+ * @brief Add two vectors
+ * @param[in] v1 The first vector
+ * @param[in] v2 The second vector
+ * @return The result vector (v1 + v2)
+ */
+static MUF_INLINE MufVec4 mufVec4Add(MufVec4 v1, MufVec4 v2) {
+#if defined(MUF_SIMD_ENABLED)
+    return _mufSimd4fToVec4(mufSimd4fAdd(_mufSimd4fLoadVec(v1), _mufSimd4fLoadVec(v2)));
+#else
+    return (MufVec4) { v1.x + v2.x, v1.y + v2.y, v1.z + v2.z, v1.w + v2.w };
+#endif
+}
+
+static MUF_INLINE MufVec4 mufVec4Sub(MufVec4 v1, MufVec4 v2) {
+#if defined(MUF_SIMD_ENABLED)
+    return _mufSimd4fToVec4(mufSimd4fSub(_mufSimd4fLoadVec(v1), _mufSimd4fLoadVec(v2)));
+#else
+    return (MufVec4) { v1.x - v2.x, v1.y - v2.y, v1.z - v2.z, v1.w - v2.w };
+#endif
+}
+
+static MUF_INLINE MufVec4 mufVec4Mul(MufVec4 v, muf_f32 s) {
+#if defined(MUF_SIMD_ENABLED)
+    return _mufSimd4fToVec4(mufSimd4fMul(_mufSimd4fLoadVec(v), mufSimd4fSplat(s)));
+#else
+    return (MufVec4) { v.x * s, v.y * s, v.z * s, v.w * s };
+#endif
+}
+
+static MUF_INLINE MufVec4 mufVec4Scale(MufVec4 v, muf_f32 s) {
+    return mufVec4Mul(v, s);
+}
+
+static MUF_INLINE MufVec4 mufVec4Hadamard(MufVec4 v1, MufVec4 v2) {
+#if defined(MUF_SIMD_ENABLED)
+    return _mufSimd4fToVec4(mufSimd4fMul(_mufSimd4fLoadVec(v1), _mufSimd4fLoadVec(v2)));
+#else
+    return (MufVec4) { v1.x * v2.x, v1.y * v2.y, v1.z * v2.z, v1.w * v2.w };
+#endif
+}
+
+static MUF_INLINE muf_f32 mufVec4Dot(MufVec4 v1, MufVec4 v2) {
+#if defined(MUF_SIMD_ENABLED)
+    return mufSimd4fDot(_mufSimd4fLoadVec(v1), _mufSimd4fLoadVec(v2));
+#else
+    return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z + v1.w * v2.w;
+#endif
+}
+
+static MUF_INLINE MufMat4 mufMat4Mul(const MufMat4 *a, const MufMat4 *b) {
+#if defined(MUF_SIMD_AVX)
+    /* Two columns of the result per iteration, the in-lane shuffles broadcast b[j][k] and b[j + 1][k] */
+    MufMat4 result;
+    __m256 a0 = _mm256_broadcast_ps((const __m128 *) a->values[0]);
+    __m256 a1 = _mm256_broadcast_ps((const __m128 *) a->values[1]);
+    __m256 a2 = _mm256_broadcast_ps((const __m128 *) a->values[2]);
+    __m256 a3 = _mm256_broadcast_ps((const __m128 *) a->values[3]);
+    for (muf_u32 j = 0; j < 4; j += 2) {
+        __m256 columns = _mm256_loadu_ps(b->values[j]);
+        __m256 r = _mm256_mul_ps(a0, _mm256_shuffle_ps(columns, columns, _MM_SHUFFLE(0, 0, 0, 0)));
+        r = _mm256_add_ps(r, _mm256_mul_ps(a1, _mm256_shuffle_ps(columns, columns, _MM_SHUFFLE(1, 1, 1, 1))));
+        r = _mm256_add_ps(r, _mm256_mul_ps(a2, _mm256_shuffle_ps(columns, columns, _MM_SHUFFLE(2, 2, 2, 2))));
+        r = _mm256_add_ps(r, _mm256_mul_ps(a3, _mm256_shuffle_ps(columns, columns, _MM_SHUFFLE(3, 3, 3, 3))));
+        _mm256_storeu_ps(result.values[j], r);
+    }
+    return result;
+#elif defined(MUF_SIMD_ENABLED)
+    MufMat4 result;
+    MufSimd4f a0 = _mufSimd4fLoadColumn(a, 0);
+    MufSimd4f a1 = _mufSimd4fLoadColumn(a, 1);
+    MufSimd4f a2 = _mufSimd4fLoadColumn(a, 2);
+    MufSimd4f a3 = _mufSimd4fLoadColumn(a, 3);
+    for (muf_u32 j = 0; j < 4; ++j) {
+        MufSimd4f column = _mufSimd4fLoadColumn(b, j);
+        MufSimd4f r = mufSimd4fMul(a0, mufSimd4fSplatLane(column, 0));
+        r = mufSimd4fMulAdd(a1, mufSimd4fSplatLane(column, 1), r);
+        r = mufSimd4fMulAdd(a2, mufSimd4fSplatLane(column, 2), r);
+        r = mufSimd4fMulAdd(a3, mufSimd4fSplatLane(column, 3), r);
+        mufSimd4fStore(result.values[j], r);
+    }
+    return result;
+#else
+    return mufMat4MulRef(a, b);
+#endif
+}
+
+static MUF_INLINE MufMat4 mufMat4Transpose(const MufMat4 *mat) {
+#if defined(MUF_SIMD_SSE2)
+    MufMat4 result;
+    __m128 c0 = _mufSimd4fLoadColumn(mat, 0);
+    __m128 c1 = _mufSimd4fLoadColumn(mat, 1);
+    __m128 c2 = _mufSimd4fLoadColumn(mat, 2);
+    __m128 c3 = _mufSimd4fLoadColumn(mat, 3);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    mufSimd4fStore(result.values[0], c0);
+    mufSimd4fStore(result.values[1], c1);
+    mufSimd4fStore(result.values[2], c2);
+    mufSimd4fStore(result.values[3], c3);
+    return result;
+#elif defined(MUF_SIMD_NEON)
+    /* The de-interleaving load gathers every 4th value, a row of the matrix */
+    MufMat4 result;
+    float32x4x4_t rows = vld4q_f32(&mat->values[0][0]);
+    vst1q_f32(result.values[0], rows.val[0]);
+    vst1q_f32(result.values[1], rows.val[1]);
+    vst1q_f32(result.values[2], rows.val[2]);
+    vst1q_f32(result.values[3], rows.val[3]);
+    return result;
+#else
+    return mufMat4TransposeRef(mat);
+#endif
+}
+
+#if defined(MUF_SIMD_SSE2)
+/**
+ * Cramer's rule on the transposed matrix, after the SSE inverse of Intel's AP-928 note. The transposed input gives
+ * the transposed inverse, which read in column major is the inverse of the column major input.
+ */
+static MUF_INLINE __m128 _mufMat4CofactorsSSE(const MufMat4 *mat, __m128 *minorsOut, __m128 *row0Out) {
+    __m128 c0 = _mufSimd4fLoadColumn(mat, 0);
+    __m128 c1 = _mufSimd4fLoadColumn(mat, 1);
+    __m128 c2 = _mufSimd4fLoadColumn(mat, 2);
+    __m128 c3 = _mufSimd4fLoadColumn(mat, 3);
+
+    __m128 tmp = _mm_movelh_ps(c0, c1);
+    __m128 row1 = _mm_movelh_ps(c2, c3);
+    __m128 row0 = _mm_shuffle_ps(tmp, row1, 0x88);
+    row1 = _mm_shuffle_ps(row1, tmp, 0xDD);
+    tmp = _mm_movehl_ps(c1, c0);
+    __m128 row3 = _mm_movehl_ps(c3, c2);
+    __m128 row2 = _mm_shuffle_ps(tmp, row3, 0x88);
+    row3 = _mm_shuffle_ps(row3, tmp, 0xDD);
+
+    __m128 minor0, minor1, minor2, minor3;
+    tmp = _mm_mul_ps(row2, row3);
+    tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+    minor0 = _mm_mul_ps(row1, tmp);
+    minor1 = _mm_mul_ps(row0, tmp);
+    tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+    minor0 = _mm_sub_ps(_mm_mul_ps(row1, tmp), minor0);
+    minor1 = _mm_sub_ps(_mm_mul_ps(row0, tmp), minor1);
+    minor1 = _mm_shuffle_ps(minor1, minor1, 0x4E);
+
+    tmp = _mm_mul_ps(row1, row2);
+    tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+    minor0 = _mm_add_ps(_mm_mul_ps(row3, tmp), minor0);
+    minor3 = _mm_mul_ps(row0, tmp);
+    tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+    minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row3, tmp));
+    minor3 = _mm_sub_ps(_mm_mul_ps(row0, tmp), minor3);
+    minor3 = _mm_shuffle_ps(minor3, minor3, 0x4E);
+
+    tmp = _mm_mul_ps(_mm_shuffle_ps(row1, row1, 0x4E), row3);
+    tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+    row2 = _mm_shuffle_ps(row2, row2, 0x4E);
+    minor0 = _mm_add_ps(_mm_mul_ps(row2, tmp), minor0);
+    minor2 = _mm_mul_ps(row0, tmp);
+    tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+    minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row2, tmp));
+    minor2 = _mm_sub_ps(_mm_mul_ps(row0, tmp), minor2);
+    minor2 = _mm_shuffle_ps(minor2, minor2, 0x4E);
+
+    if (minorsOut != NULL) {
+        tmp = _mm_mul_ps(row0, row1);
+        tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+        minor2 = _mm_add_ps(_mm_mul_ps(row3, tmp), minor2);
+        minor3 = _mm_sub_ps(_mm_mul_ps(row2, tmp), minor3);
+        tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+        minor2 = _mm_sub_ps(_mm_mul_ps(row3, tmp), minor2);
+        minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row2, tmp));
+
+        tmp = _mm_mul_ps(row0, row3);
+        tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+        minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row2, tmp));
+        minor2 = _mm_add_ps(_mm_mul_ps(row1, tmp), minor2);
+        tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+        minor1 = _mm_add_ps(_mm_mul_ps(row2, tmp), minor1);
+        minor2 = _mm_sub_ps(minor2, _mm_mul_ps(row1, tmp));
+
+        tmp = _mm_mul_ps(row0, row2);
+        tmp = _mm_shuffle_ps(tmp, tmp, 0xB1);
+        minor1 = _mm_add_ps(_mm_mul_ps(row3, tmp), minor1);
+        minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row1, tmp));
+        tmp = _mm_shuffle_ps(tmp, tmp, 0x4E);
+        minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row3, tmp));
+        minor3 = _mm_add_ps(_mm_mul_ps(row1, tmp), minor3);
+
+        minorsOut[0] = minor0;
+        minorsOut[1] = minor1;
+        minorsOut[2] = minor2;
+        minorsOut[3] = minor3;
+    }
+    *row0Out = row0;
+    return minor0;
+}
+#endif
+
+static MUF_INLINE muf_f32 mufMat4Determinant(const MufMat4 *mat) {
+#if defined(MUF_SIMD_SSE2)
+    __m128 row0;
+    __m128 minor0 = _mufMat4CofactorsSSE(mat, NULL, &row0);
+    return mufSimd4fHorizontalAdd(_mm_mul_ps(row0, minor0));
+#else
+    return mufMat4DeterminantRef(mat);
+#endif
+}
+
+static MUF_INLINE MufMat4 mufMat4Inverse(const MufMat4 *mat) {
+#if defined(MUF_SIMD_SSE2)
+    __m128 minors[4];
+    __m128 row0;
+    _mufMat4CofactorsSSE(mat, minors, &row0);
+    muf_f32 det = mufSimd4fHorizontalAdd(_mm_mul_ps(row0, minors[0]));
+    MUF_FASSERT(det != 0.0F, "The matrix is not invertible");
+
+    __m128 invDet = _mm_set1_ps(1.0F / det);
+    MufMat4 result;
+    mufSimd4fStore(result.values[0], _mm_mul_ps(minors[0], invDet));
+    mufSimd4fStore(result.values[1], _mm_mul_ps(minors[1], invDet));
+    mufSimd4fStore(result.values[2], _mm_mul_ps(minors[2], invDet));
+    mufSimd4fStore(result.values[3], _mm_mul_ps(minors[3], invDet));
+    return result;
+#else
+    return mufMat4InverseRef(mat);
+#endif
+}
+
+static MUF_INLINE MufVec4 mufMat4MulVec(const MufMat4 *mat, MufVec4 vec) {
+#if defined(MUF_SIMD_ENABLED)
+    MufSimd4f v = _mufSimd4fLoadVec(vec);
+    MufSimd4f r = mufSimd4fMul(_mufSimd4fLoadColumn(mat, 0), mufSimd4fSplatLane(v, 0));
+    r = mufSimd4fMulAdd(_mufSimd4fLoadColumn(mat, 1), mufSimd4fSplatLane(v, 1), r);
+    r = mufSimd4fMulAdd(_mufSimd4fLoadColumn(mat, 2), mufSimd4fSplatLane(v, 2), r);
+    r = mufSimd4fMulAdd(_mufSimd4fLoadColumn(mat, 3), mufSimd4fSplatLane(v, 3), r);
+    return _mufSimd4fToVec4(r);
+#else
+    return mufMat4MulVecRef(mat, vec);
+#endif
+}
+
+static MUF_INLINE MufVec4 mufVec4MulMat(MufVec4 vec, const MufMat4 *mat) {
+#if defined(MUF_SIMD_ENABLED)
+    MufMat4 transposed = mufMat4Transpose(mat);
+    return mufMat4MulVec(&transposed, vec);
+#else
+    return mufVec4MulMatRef(vec, mat);
+#endif
+}
+
+static MUF_INLINE MufVec4 mufVec4Transform(MufVec4 vec, const MufMat4 *transform) {
+    return mufMat4MulVec(transform, vec);
+}
+
+/**
+ * @brief Transform a direction, the translation of the matrix is ignored
+ */
+static MUF_INLINE MufVec3 mufVec3Transform(MufVec3 vec, const MufMat4 *transform) {
+    MufVec4 result = mufMat4MulVec(transform, (MufVec4) { vec.x, vec.y, vec.z, 0.0F });
+    return (MufVec3) { result.x, result.y, result.z };
+}
+
+static MUF_INLINE MufQuat4 mufCreateQuat4(muf_f32 x, muf_f32 y, muf_f32 z, muf_f32 w) {
+    return (MufQuat4) { x, y, z, w };
+}
+
+static MUF_INLINE MufQuat4 mufQuat4Identity(void) {
+    return (MufQuat4) { 0.0F, 0.0F, 0.0F, 1.0F };
+}
+
+static MUF_INLINE muf_f32 mufQuat4Dot(MufQuat4 q1, MufQuat4 q2) {
+#if defined(MUF_SIMD_ENABLED)
+    return mufSimd4fDot(_mufSimd4fLoadVec(q1), _mufSimd4fLoadVec(q2));
+#else
+    return q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+#endif
+}
+
+static MUF_INLINE MufQuat4 mufQuat4Conjugate(MufQuat4 q) {
+#if defined(MUF_SIMD_ENABLED)
+    return _mufSimd4fToQuat4(mufSimd4fMul(_mufSimd4fLoadVec(q), mufSimd4fSet(-1.0F, -1.0F, -1.0F, 1.0F)));
+#else
+    return (MufQuat4) { -q.x, -q.y, -q.z, q.w };
+#endif
+}
+
+static MUF_INLINE MufQuat4 mufQuat4Normalize(MufQuat4 q) {
+    muf_f32 length = sqrtf(mufQuat4Dot(q, q));
+    MUF_FASSERT(length != 0.0F, "The quaternion has no length");
+    muf_f32 s = 1.0F / length;
+#if defined(MUF_SIMD_ENABLED)
+    return _mufSimd4fToQuat4(mufSimd4fMul(_mufSimd4fLoadVec(q), mufSimd4fSplat(s)));
+#else
+    return (MufQuat4) { q.x * s, q.y * s, q.z * s, q.w * s };
+#endif
+}
+
+static MUF_INLINE MufQuat4 mufQuat4Inverse(MufQuat4 q) {
+    muf_f32 length2 = mufQuat4Dot(q, q);
+    MUF_FASSERT(length2 != 0.0F, "The quaternion is not invertible");
+    muf_f32 s = 1.0F / length2;
+#if defined(MUF_SIMD_ENABLED)
+    return _mufSimd4fToQuat4(mufSimd4fMul(_mufSimd4fLoadVec(q), mufSimd4fSet(-s, -s, -s, s)));
+#else
+    return (MufQuat4) { -q.x * s, -q.y * s, -q.z * s, q.w * s };
+#endif
+}
+
+/**
+ * @brief The Hamilton product, the rotation q2 followed by q1
+ */
+static MUF_INLINE MufQuat4 mufQuat4Mul(MufQuat4 q1, MufQuat4 q2) {
+#if defined(MUF_SIMD_SSE2)
+    __m128 a = _mufSimd4fLoadVec(q1);
+    __m128 b = _mufSimd4fLoadVec(q2);
+    __m128 r = _mm_mul_ps(mufSimd4fSplatLane(a, 3), b);
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(mufSimd4fSplatLane(a, 0), _mufSimd4fShuffle(b, 3, 2, 1, 0)),
+        _mm_set_ps(-1.0F, 1.0F, -1.0F, 1.0F)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(mufSimd4fSplatLane(a, 1), _mufSimd4fShuffle(b, 2, 3, 0, 1)),
+        _mm_set_ps(-1.0F, -1.0F, 1.0F, 1.0F)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(mufSimd4fSplatLane(a, 2), _mufSimd4fShuffle(b, 1, 0, 3, 2)),
+        _mm_set_ps(-1.0F, 1.0F, 1.0F, -1.0F)));
+    return _mufSimd4fToQuat4(r);
+#else
+    return mufQuat4MulRef(q1, q2);
+#endif
+}
+
+/**
+ * @brief Rotate a vector, v + 2w(u x v) + 2u x (u x v) with u the imaginary part
+ */
+static MUF_INLINE MufVec3 mufQuat4RotateVec3(MufQuat4 q, MufVec3 v) {
+#if defined(MUF_SIMD_SSE2)
+    __m128 u = _mufSimd4fLoadVec(q);
+    __m128 p = _mm_set_ps(0.0F, v.z, v.y, v.x);
+    __m128 uYZX = _mufSimd4fShuffle(u, 1, 2, 0, 3);
+    __m128 pYZX = _mufSimd4fShuffle(p, 1, 2, 0, 3);
+    /* a x b is (a * b.yzx - a.yzx * b).yzx */
+    __m128 t = _mm_sub_ps(_mm_mul_ps(u, pYZX), _mm_mul_ps(uYZX, p));
+    t = _mufSimd4fShuffle(_mm_add_ps(t, t), 1, 2, 0, 3);
+    __m128 tYZX = _mufSimd4fShuffle(t, 1, 2, 0, 3);
+    __m128 c = _mm_sub_ps(_mm_mul_ps(u, tYZX), _mm_mul_ps(uYZX, t));
+    __m128 r = _mm_add_ps(_mm_add_ps(p, _mm_mul_ps(mufSimd4fSplatLane(u, 3), t)), _mufSimd4fShuffle(c, 1, 2, 0, 3));
+    MUF_ALIGNAS(16) muf_f32 values[4];
+    _mm_store_ps(values, r);
+    return (MufVec3) { values[0], values[1], values[2] };
+#else
+    return mufQuat4RotateVec3Ref(q, v);
+#endif
+}
+
+#endif
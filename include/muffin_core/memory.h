@@ -18,8 +18,71 @@ typedef struct MufAllocatorCallbacks_s {
 
 extern MufAllocatorCallbacks MUF_DEFAULT_ALLOCATOR[1];
 
+/**
+ * @brief The subsystem an allocation is accounted to when memory tracking is enabled.
+ * A source file selects its tag by defining MUF_MEMORY_TAG before its first include.
+ */
+typedef enum MufMemoryTag_e {
+    MUF_MEMORY_TAG_GENERAL,
+    MUF_MEMORY_TAG_CORE_CONTAINERS,
+    MUF_MEMORY_TAG_RENDER_BACKEND,
+    MUF_MEMORY_TAG_IMAGE,
+    MUF_MEMORY_TAG_LOG,
+    MUF_MEMORY_TAG_MODULE,
+    MUF_ENUM_COUNT(MUF_MEMORY_TAG)
+} MufMemoryTag;
+
+#if !defined(MUF_MEMORY_TAG)
+#   define MUF_MEMORY_TAG MUF_MEMORY_TAG_GENERAL
+#endif
+
+typedef struct MufMemoryTagStats_s {
+    muf_usize liveBytes;
+    muf_usize peakBytes;
+    muf_usize liveCount;
+    muf_usize totalAllocCount;
+    muf_usize totalFreeCount;
+    muf_usize totalAllocBytes;
+} MufMemoryTagStats;
+
+MUF_API muf_rawptr _mufMemoryTrackAlloc(muf_usize size, muf_bool zero, MufMemoryTag tag, const muf_char *file, muf_u32 line);
+MUF_API muf_rawptr _mufMemoryTrackRealloc(muf_rawptr ptr, muf_usize newSize, MufMemoryTag tag, const muf_char *file, muf_u32 line);
+MUF_API void _mufMemoryTrackFree(muf_rawptr ptr);
+MUF_API muf_char *_mufMemoryTrackStrClone(const muf_char *str, MufMemoryTag tag, const muf_char *file, muf_u32 line);
+
+MUF_API const muf_char *mufMemoryTagGetName(MufMemoryTag tag);
+
+/**
+ * @brief Get the counters of a tag. All zero unless built with MUFFIN_ENABLE_MEMORY_TRACKING.
+ */
+MUF_API void mufMemoryGetTagStats(MufMemoryTag tag, MufMemoryTagStats *statsOut);
+
+/**
+ * @brief Aggregate live allocations by call site. Must be set before the first tracked allocation.
+ */
+MUF_API void mufMemorySetCallSiteTracking(muf_bool enabled);
+
+MUF_API void mufMemorySetReportAtExit(muf_bool enabled);
+
+/**
+ * @brief Print live/peak bytes and allocation rates per tag, and the largest live call sites if tracked
+ * @param[in] stream The output stream, e.g. stderr
+ */
+MUF_API void mufMemoryDumpReport(FILE *stream);
+
 #define mufAlignOf()
 
+#if defined(MUF_ENABLE_MEMORY_TRACKING)
+#   define mufAlloc(_type, _count) \
+        (_type*)_mufMemoryTrackAlloc(sizeof(_type) * (muf_usize)(_count), MUF_FALSE, MUF_MEMORY_TAG, __FILE__, __LINE__)
+#   define mufRealloc(_type, _ptr, _newCount) \
+        (_type*)_mufMemoryTrackRealloc(_ptr, sizeof(_type) * (muf_usize)(_newCount), MUF_MEMORY_TAG, __FILE__, __LINE__)
+#   define mufAllocZero(_type, _count) \
+        (_type*)_mufMemoryTrackAlloc(sizeof(_type) * (muf_usize)(_count), MUF_TRUE, MUF_MEMORY_TAG, __FILE__, __LINE__)
+#   define mufFree(_ptr) _mufMemoryTrackFree(_ptr);
+#   define mufSafeFree(_ptr) do { if (_ptr) { _mufMemoryTrackFree(_ptr); _ptr = NULL; } } while(0)
+#else
+
 /**
  * @brief Allocate a block of memory of size (sizeof(_type) * _count)
  * @param _type The data type to be allocated
@@ -29,15 +92,6 @@ extern MufAllocatorCallbacks MUF_DEFAULT_ALLOCATOR[1];
 #define mufRealloc(_type, _ptr, _newCount) (_type*)realloc(_ptr, sizeof(_type) * (muf_usize)(_newCount))
 #define mufAllocZero(_type, _count) (_type*)calloc(_count, sizeof(_type))
 
-#define mufAllocBytes(_count) mufAlloc(muf_byte, _count)
-#define mufReallocBytes(_ptr, _newCount) mufRealloc(muf_byte, _ptr, _newCount)
-
-#define mufAllocAligned(_type, _count, Alignment)
-
-#define mufReallocAligned(_type, _ptr, _newCount, Alignment)
-
-#define mufAllocZeroAligned(_type, _count, Alignment)
-
 /**
  * @brief Free memory for the given pointer
  * @param _ptr The pointer to a block of memory
@@ -50,6 +104,17 @@ extern MufAllocatorCallbacks MUF_DEFAULT_ALLOCATOR[1];
  */
 #define mufSafeFree(_ptr) do { if (_ptr) { free(_ptr); _ptr = NULL; } } while(0)
 
+#endif
+
+#define mufAllocBytes(_count) mufAlloc(muf_byte, _count)
+#define mufReallocBytes(_ptr, _newCount) mufRealloc(muf_byte, _ptr, _newCount)
+
+#define mufAllocAligned(_type, _count, Alignment)
+
+#define mufReallocAligned(_type, _ptr, _newCount, Alignment)
+
+#define mufAllocZeroAligned(_type, _count, Alignment)
+
 /**
  * @brief Fill the memory with the given byte value
  * @param _ptr Specify the pointer to a block of memory
@@ -2,6 +2,7 @@
 #define _MUFFIN_CORE_MODULE_H_
 
 #include "muffin_core/common.h"
+#include "muffin_core/intern.h"
 
 #define MUF_MODULE_REGISTRY_DECLARE(_moduleName) extern MufModuleRegistry _muf_module_##_moduleName[1]
 
@@ -53,6 +54,10 @@ MUF_HANDLE_DEF(MufModule);
 
 void mufRegisterModule(const MufModuleRegistry *registry);
 MufModule mufGetModule(const muf_char *modName);
+/**
+ * @brief Get a module by the interned id of its name, without hashing the name
+ */
+MufModule mufGetModuleById(MufStrId id);
 muf_usize mufGetModuleNames(const muf_char **names);
 muf_usize mufGetEnabledModuleCount();
 
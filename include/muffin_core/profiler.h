@@ -0,0 +1,100 @@
+#ifndef _MUFFIN_CORE_PROFILER_H_
+#define _MUFFIN_CORE_PROFILER_H_
+
+#include "muffin_core/common.h"
+
+typedef enum MufProfileEventType_e {
+    MUF_PROFILE_EVENT_TYPE_BEGIN,
+    MUF_PROFILE_EVENT_TYPE_END,
+    MUF_PROFILE_EVENT_TYPE_INSTANT,
+    MUF_PROFILE_EVENT_TYPE_COMPLETE
+} MufProfileEventType;
+
+/**
+ * @brief A recorded event. Timestamps are in timer ticks (see muffin_core/timer.h).
+ * The name must outlive the profiler, string literals are expected.
+ */
+typedef struct MufProfileEvent_s {
+    const muf_char  *name;
+    muf_u64         timestamp;
+    muf_u64         duration;
+    muf_u32         type;
+} MufProfileEvent;
+
+/**
+ * @brief Identify a timeline in the trace. Every thread gets its own track on its first event,
+ * other tracks (e.g. GPU queues) are created by mufProfilerCreateTrack.
+ */
+typedef muf_u32 MufProfileTrack;
+
+MUF_API void mufProfilerSetEnabled(muf_bool enabled);
+
+MUF_API muf_bool mufProfilerIsEnabled(void);
+
+/**
+ * @brief Drop all recorded events. No thread may be recording while this is called.
+ */
+MUF_API void mufProfilerReset(void);
+
+MUF_API void mufProfilerSetThreadName(const muf_char *name);
+
+MUF_API MufProfileTrack mufProfilerCreateTrack(const muf_char *name);
+
+MUF_API void mufProfilerBegin(const muf_char *name);
+
+MUF_API void mufProfilerEnd(const muf_char *name);
+
+MUF_API void mufProfilerInstant(const muf_char *name);
+
+/**
+ * @brief Append an event with an explicit time range to a track. Each track must have a single producer.
+ * @param[in] track The track created by mufProfilerCreateTrack
+ * @param[in] name The event name
+ * @param[in] beginTicks The begin timestamp in timer ticks
+ * @param[in] endTicks The end timestamp in timer ticks
+ */
+MUF_API void mufProfilerRecordComplete(MufProfileTrack track, const muf_char *name, muf_u64 beginTicks, muf_u64 endTicks);
+
+/**
+ * @brief Write all recorded events in the Chrome trace event JSON format (chrome://tracing, Perfetto)
+ * @return True if the file was written
+ */
+MUF_API muf_bool mufProfilerExportChromeTrace(const muf_char *filePath);
+
+/**
+ * @brief Write all recorded events in the compact binary format.
+ * Layout (little endian): magic "MUFPROF\0", u32 version, u64 tick frequency,
+ * u32 name count, names as (u16 length, bytes), u32 track count, tracks as (u32 id, u16 length, bytes),
+ * then for each track: u32 track id, u32 event count, events as (u32 name index, u8 type, u64 timestamp, u64 duration).
+ * @return True if the file was written
+ */
+MUF_API muf_bool mufProfilerExportBinary(const muf_char *filePath);
+
+#if defined(MUF_ENABLE_PROFILER)
+#   define _MUF_PROFILE_CONCAT_IMPL(_a, _b) _a##_b
+#   define _MUF_PROFILE_CONCAT(_a, _b) _MUF_PROFILE_CONCAT_IMPL(_a, _b)
+
+MUF_INTERNAL MUF_INLINE void _mufProfileScopeExit(const muf_char **name) {
+    mufProfilerEnd(*name);
+}
+
+#   if defined(MUF_COMPILER_GCC) || defined(MUF_COMPILER_CLANG)
+#       define MUF_PROFILE_SCOPE(_name) \
+            const muf_char *_MUF_PROFILE_CONCAT(_mufProfileScope, __LINE__) __attribute__((cleanup(_mufProfileScopeExit))) = (_name); \
+            mufProfilerBegin(_MUF_PROFILE_CONCAT(_mufProfileScope, __LINE__))
+#   else
+#       define MUF_PROFILE_SCOPE(_name) MUF_UNUSED(_name)
+#   endif
+#   define MUF_PROFILE_BEGIN(_name) mufProfilerBegin(_name)
+#   define MUF_PROFILE_END(_name) mufProfilerEnd(_name)
+#   define MUF_PROFILE_INSTANT(_name) mufProfilerInstant(_name)
+#   define MUF_PROFILE_FUNCTION() MUF_PROFILE_SCOPE(__func__)
+#else
+#   define MUF_PROFILE_SCOPE(_name)
+#   define MUF_PROFILE_BEGIN(_name)
+#   define MUF_PROFILE_END(_name)
+#   define MUF_PROFILE_INSTANT(_name)
+#   define MUF_PROFILE_FUNCTION()
+#endif
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef _MUFFIN_CORE_RANDOM_H_
+#define _MUFFIN_CORE_RANDOM_H_
+
+#include "muffin_core/common.h"
+
+/*
+ * Small-state generators, cheaper than MufMT19937 to step and to keep one per thread or per system.
+ *  - SplitMix64: one 64-bit word, used to expand seeds
+ *  - Xoshiro256++: the general purpose generator, jumps give 2^64 non-overlapping streams of 2^128 values
+ *  - PCG32: 32-bit outputs, a stream per odd increment and arbitrary jump-ahead
+ * None of them is suitable for cryptography.
+ */
+
+typedef struct MufSplitMix64_s {
+    muf_u64 state;
+} MufSplitMix64;
+
+typedef struct MufXoshiro256_s {
+    muf_u64 s[4];
+} MufXoshiro256;
+
+typedef struct MufPcg32_s {
+    muf_u64 state;
+    /* Selects the stream, always odd */
+    muf_u64 increment;
+} MufPcg32;
+
+/**
+ * @brief Four Xoshiro256++ streams stepped in lockstep for the bulk fills, the state is stored by word then lane
+ */
+typedef struct MufXoshiro256x4_s {
+    MUF_ALIGNAS(32) muf_u64 s[4][4];
+} MufXoshiro256x4;
+
+MUF_INTERNAL MUF_INLINE muf_u64 _mufRandomRotl64(muf_u64 x, muf_u32 k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+MUF_API void mufInitSplitMix64(MufSplitMix64 *generator, muf_u64 seed);
+
+MUF_INTERNAL MUF_INLINE muf_u64 mufSplitMix64Next(MufSplitMix64 *generator) {
+    muf_u64 z = (generator->state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Seed a generator, the seed is expanded with SplitMix64 so close seeds give unrelated sequences
+ */
+MUF_API void mufInitXoshiro256(MufXoshiro256 *generator, muf_u64 seed);
+
+MUF_INTERNAL MUF_INLINE muf_u64 mufXoshiro256Next(MufXoshiro256 *generator) {
+    muf_u64 *s = generator->s;
+    muf_u64 result = _mufRandomRotl64(s[0] + s[3], 23) + s[0];
+    muf_u64 t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = _mufRandomRotl64(s[3], 45);
+    return result;
+}
+
+/**
+ * @brief Advance a generator by 2^128 values, calling it n times on copies of one generator gives n streams
+ */
+MUF_API void mufXoshiro256Jump(MufXoshiro256 *generator);
+
+/**
+ * @brief Advance a generator by 2^192 values, to split the streams of mufXoshiro256Jump once more
+ */
+MUF_API void mufXoshiro256LongJump(MufXoshiro256 *generator);
+
+/**
+ * @brief Get an integer in [0, bound) without modulo bias (Lemire's multiply and reject)
+ */
+MUF_API muf_u32 mufXoshiro256NextBounded(MufXoshiro256 *generator, muf_u32 bound);
+
+/**
+ * @brief Get an integer in [minValue, maxValue], the bounds may come in any order
+ */
+MUF_API muf_i32 mufXoshiro256Range(MufXoshiro256 *generator, muf_i32 minValue, muf_i32 maxValue);
+
+/**
+ * @brief Get a float in [0, 1), every value is a multiple of 2^-24
+ */
+MUF_INTERNAL MUF_INLINE muf_f32 mufXoshiro256NextF32(MufXoshiro256 *generator) {
+    return (muf_f32) (mufXoshiro256Next(generator) >> 40) * (1.0F / 16777216.0F);
+}
+
+/**
+ * @brief Get a double in [0, 1), every value is a multiple of 2^-53
+ */
+MUF_INTERNAL MUF_INLINE muf_f64 mufXoshiro256NextF64(MufXoshiro256 *generator) {
+    return (muf_f64) (mufXoshiro256Next(generator) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief Seed a generator
+ * @param[in] stream Selects one of 2^63 independent sequences
+ */
+MUF_API void mufInitPcg32(MufPcg32 *generator, muf_u64 seed, muf_u64 stream);
+
+MUF_INTERNAL MUF_INLINE muf_u32 mufPcg32Next(MufPcg32 *generator) {
+    muf_u64 state = generator->state;
+    generator->state = state * 6364136223846793005ULL + generator->increment;
+    muf_u32 xorShifted = (muf_u32) (((state >> 18) ^ state) >> 27);
+    muf_u32 rotation = (muf_u32) (state >> 59);
+    return (xorShifted >> rotation) | (xorShifted << ((0U - rotation) & 31U));
+}
+
+/**
+ * @brief Advance a generator by delta values in O(log delta) steps
+ */
+MUF_API void mufPcg32Advance(MufPcg32 *generator, muf_u64 delta);
+
+/**
+ * @brief Get an integer in [0, bound) without modulo bias
+ */
+MUF_API muf_u32 mufPcg32NextBounded(MufPcg32 *generator, muf_u32 bound);
+
+MUF_INTERNAL MUF_INLINE muf_f32 mufPcg32NextF32(MufPcg32 *generator) {
+    return (muf_f32) (mufPcg32Next(generator) >> 8) * (1.0F / 16777216.0F);
+}
+
+/**
+ * @brief Seed four streams for the bulk fills, lane i is a mufInitXoshiro256 generator jumped i times
+ */
+MUF_API void mufInitXoshiro256x4(MufXoshiro256x4 *generator, muf_u64 seed);
+
+/**
+ * @brief Fill an array with random integers, with AVX2 when the CPU has it
+ *
+ * Each step of the four lanes gives eight values: the low and high halves of the output of lane 0, then of lane 1...
+ * A fill consumes whole steps, the values past the end of the array are dropped. The result does not depend on
+ * the instruction set.
+ */
+MUF_API void mufRandomFillU32(MufXoshiro256x4 *generator, muf_u32 *out, muf_usize count);
+
+/**
+ * @brief Fill an array with random floats between minValue and maxValue, from the integers mufRandomFillU32
+ * would give. The top 24 bits of each integer are scaled, the values are evenly spaced by (maxValue - minValue) / 2^24
+ */
+MUF_API void mufRandomFillF32(MufXoshiro256x4 *generator, muf_f32 *out, muf_usize count, muf_f32 minValue,
+    muf_f32 maxValue);
+
+#endif
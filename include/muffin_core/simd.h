@@ -0,0 +1,199 @@
+#ifndef _MUFFIN_CORE_SIMD_H_
+#define _MUFFIN_CORE_SIMD_H_
+
+#include "muffin_core/common.h"
+
+/*
+ * The instruction sets are selected at compile time from the target flags of the compiler (-msse4.1, -mavx, /arch:AVX...).
+ * Define MUF_SIMD_DISABLE to build the scalar paths only.
+ */
+#if !defined(MUF_SIMD_DISABLE)
+#   if defined(__AVX__)
+#       define MUF_SIMD_AVX
+#   endif
+#   if defined(__SSE4_1__) || defined(MUF_SIMD_AVX)
+#       define MUF_SIMD_SSE41
+#   endif
+#   if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(MUF_SIMD_SSE41)
+#       define MUF_SIMD_SSE2
+#   endif
+#   if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#       define MUF_SIMD_NEON
+#   endif
+#endif
+
+#if defined(MUF_SIMD_SSE2)
+#   include <immintrin.h>
+#elif defined(MUF_SIMD_NEON)
+#   include <arm_neon.h>
+#endif
+
+/*
+ * MUF_SIMD_TARGET compiles a function for a wider x86 instruction set than the rest of its file (MUF_SIMD_TARGET("avx")).
+ * Such functions must only be called after a runtime check of the CPU.
+ */
+#if defined(MUF_SIMD_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#   define MUF_SIMD_TARGET(_isa) __attribute__((target(_isa)))
+#   define MUF_SIMD_MULTI_TARGET
+#elif defined(MUF_SIMD_SSE2) && defined(_MSC_VER)
+#   define MUF_SIMD_TARGET(_isa)
+#   define MUF_SIMD_MULTI_TARGET
+#endif
+
+#if defined(MUF_SIMD_SSE2) || defined(MUF_SIMD_NEON)
+#   define MUF_SIMD_ENABLED
+#endif
+
+#if defined(MUF_SIMD_ENABLED)
+
+/**
+ * @brief Four packed floats, the common subset of the SSE and NEON registers
+ */
+#if defined(MUF_SIMD_SSE2)
+typedef __m128 MufSimd4f;
+#else
+typedef float32x4_t MufSimd4f;
+#endif
+
+/**
+ * @brief Load four floats from a 16-byte aligned address
+ */
+static MUF_INLINE MufSimd4f mufSimd4fLoad(const muf_f32 *values) {
+#if defined(MUF_SIMD_SSE2)
+    return _mm_load_ps(values);
+#else
+    return vld1q_f32(values);
+#endif
+}
+
+static MUF_INLINE MufSimd4f mufSimd4fLoadUnaligned(const muf_f32 *values) {
+#if defined(MUF_SIMD_SSE2)
+    return _mm_loadu_ps(values);
+#else
+    return vld1q_f32(values);
+#endif
+}
+
+/**
+ * @brief Store four floats to a 16-byte aligned address
+ */
+static MUF_INLINE void mufSimd4fStore(muf_f32 *values, MufSimd4f v) {
+#if defined(MUF_SIMD_SSE2)
+    _mm_store_ps(values, v);
+#else
+    vst1q_f32(values, v);
+#endif
+}
+
+static MUF_INLINE void mufSimd4fStoreUnaligned(muf_f32 *values, MufSimd4f v) {
+#if defined(MUF_SIMD_SSE2)
+    _mm_storeu_ps(values, v);
+#else
+    vst1q_f32(values, v);
+#endif
+}
+
+static MUF_INLINE MufSimd4f mufSimd4fSet(muf_f32 x, muf_f32 y, muf_f32 z, muf_f32 w) {
+#if defined(MUF_SIMD_SSE2)
+    return _mm_set_ps(w, z, y, x);
+#else
+    const muf_f32 values[4] = { x, y, z, w };
+    return vld1q_f32(values);
+#endif
+}
+
+static MUF_INLINE MufSimd4f mufSimd4fSplat(muf_f32 s) {
+#if defined(MUF_SIMD_SSE2)
+    return _mm_set1_ps(s);
+#else
+    return vdupq_n_f32(s);
+#endif
+}
+
+static MUF_INLINE MufSimd4f mufSimd4fAdd(MufSimd4f a, MufSimd4f b) {
+#if defined(MUF_SIMD_SSE2)
+    return _mm_add_ps(a, b);
+#else
+    return vaddq_f32(a, b);
+#endif
+}
+
+static MUF_INLINE MufSimd4f mufSimd4fSub(MufSimd4f a, MufSimd4f b) {
+#if defined(MUF_SIMD_SSE2)
+    return _mm_sub_ps(a, b);
+#else
+    return vsubq_f32(a, b);
+#endif
+}
+
+static MUF_INLINE MufSimd4f mufSimd4fMul(MufSimd4f a, MufSimd4f b) {
+#if defined(MUF_SIMD_SSE2)
+    return _mm_mul_ps(a, b);
+#else
+    return vmulq_f32(a, b);
+#endif
+}
+
+/**
+ * @brief Compute a * b + c, not fused so the results match the scalar paths
+ */
+static MUF_INLINE MufSimd4f mufSimd4fMulAdd(MufSimd4f a, MufSimd4f b, MufSimd4f c) {
+#if defined(MUF_SIMD_SSE2)
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#else
+    return vaddq_f32(vmulq_f32(a, b), c);
+#endif
+}
+
+static MUF_INLINE MufSimd4f mufSimd4fNegate(MufSimd4f v) {
+#if defined(MUF_SIMD_SSE2)
+    return _mm_xor_ps(v, _mm_set1_ps(-0.0F));
+#else
+    return vnegq_f32(v);
+#endif
+}
+
+/**
+ * @brief Broadcast a lane, which must be a constant
+ */
+#if defined(MUF_SIMD_SSE2)
+#   define mufSimd4fSplatLane(_v, _lane) _mm_shuffle_ps((_v), (_v), _MM_SHUFFLE(_lane, _lane, _lane, _lane))
+#else
+#   define mufSimd4fSplatLane(_v, _lane) vdupq_n_f32(vgetq_lane_f32((_v), _lane))
+#endif
+
+static MUF_INLINE muf_f32 mufSimd4fGetX(MufSimd4f v) {
+#if defined(MUF_SIMD_SSE2)
+    return _mm_cvtss_f32(v);
+#else
+    return vgetq_lane_f32(v, 0);
+#endif
+}
+
+/**
+ * @brief Get the sum of the four lanes
+ */
+static MUF_INLINE muf_f32 mufSimd4fHorizontalAdd(MufSimd4f v) {
+#if defined(MUF_SIMD_SSE2)
+    MufSimd4f t = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    t = _mm_add_ss(t, _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(t);
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    return vaddvq_f32(v);
+#else
+    float32x2_t t = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(vpadd_f32(t, t), 0);
+#endif
+}
+
+static MUF_INLINE muf_f32 mufSimd4fDot(MufSimd4f a, MufSimd4f b) {
+#if defined(MUF_SIMD_SSE41)
+    return _mm_cvtss_f32(_mm_dp_ps(a, b, 0xFF));
+#else
+    return mufSimd4fHorizontalAdd(mufSimd4fMul(a, b));
+#endif
+}
+
+#endif
+
+#endif
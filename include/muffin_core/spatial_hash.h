@@ -0,0 +1,72 @@
+#ifndef _MUFFIN_CORE_SPATIAL_HASH_H_
+#define _MUFFIN_CORE_SPATIAL_HASH_H_
+
+#include "muffin_core/array.h"
+#include "muffin_core/common.h"
+#include "muffin_core/geometry.h"
+
+/*
+ * A loose uniform grid over dynamic boxes, only the occupied cells are stored, in a hash table.
+ * Each object lives in the single cell that holds the center of its box, the cells are loosened by the largest half
+ * extent of the objects, so moving an object is O(1) and objects larger than a cell need no special handling.
+ * The loosening only grows with incremental updates, a bulk build recomputes it.
+ *
+ * Queries only read the index: any number of threads can query it concurrently while no thread updates it.
+ */
+
+#define MUF_SPATIAL_HASH_INVALID_ID 0xFFFFFFFFU
+
+typedef struct MufSpatialHash_s MufSpatialHash;
+
+/**
+ * @brief Create an empty index
+ * @param[in] cellSize The edge of a cell, about the size of a typical object or query works best
+ */
+MUF_API MufSpatialHash *mufCreateSpatialHash(muf_f32 cellSize);
+MUF_API void mufDestroySpatialHash(MufSpatialHash *hash);
+
+/**
+ * @brief Replace the whole content of the index, for scenes that change too much to update (bulk mode)
+ * @param[in] bounds The box of each object, the id of an object is its index in this array
+ */
+MUF_API void mufSpatialHashBuild(MufSpatialHash *hash, const MufAABB3 *bounds, muf_u32 count);
+MUF_API void mufSpatialHashClear(MufSpatialHash *hash);
+
+/**
+ * @brief Add an object (incremental mode)
+ * @return The id of the object, the ids of removed objects are reused
+ */
+MUF_API muf_u32 mufSpatialHashInsert(MufSpatialHash *hash, MufAABB3 bounds);
+MUF_API void mufSpatialHashRemove(MufSpatialHash *hash, muf_u32 id);
+MUF_API void mufSpatialHashMove(MufSpatialHash *hash, muf_u32 id, MufAABB3 bounds);
+
+MUF_API MufAABB3 mufSpatialHashGetBounds(const MufSpatialHash *hash, muf_u32 id);
+MUF_API muf_u32 mufSpatialHashGetObjectCount(const MufSpatialHash *hash);
+MUF_API muf_u32 mufSpatialHashGetCellCount(const MufSpatialHash *hash);
+
+/**
+ * @brief Collect the objects whose box overlaps a box
+ * @param[out] idsOut An array of muf_u32 the ids are appended to
+ * @return The count of appended ids
+ */
+MUF_API muf_usize mufSpatialHashQueryAABB3(const MufSpatialHash *hash, MufAABB3 box, MufArray *idsOut);
+
+/**
+ * @brief Collect the objects whose box is not outside a frustum
+ * @param[out] idsOut An array of muf_u32 the ids are appended to
+ * @return The count of appended ids
+ */
+MUF_API muf_usize mufSpatialHashQueryFrustum(const MufSpatialHash *hash, const MufFrustum *frustum, MufArray *idsOut);
+
+/**
+ * @brief Find the objects whose box is the closest to a point, the cells are searched in rings around it
+ * @param[in] k The maximal count of objects to find
+ * @param[in] maxDistance Objects further than this are ignored, FLT_MAX for no limit
+ * @param[out] idsOut At least k ids, sorted from the closest
+ * @param[out] distancesOut The distance of each found box, 0 when the point is inside. Can be NULL
+ * @return The count of found objects
+ */
+MUF_API muf_u32 mufSpatialHashQueryNearest(const MufSpatialHash *hash, MufVec3 point, muf_u32 k, muf_f32 maxDistance,
+    muf_u32 *idsOut, muf_f32 *distancesOut);
+
+#endif
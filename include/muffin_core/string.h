@@ -1,13 +1,19 @@
 #ifndef _MUFFIN_CORE_STRING_H_
 #define _MUFFIN_CORE_STRING_H_
 
+#include <stdarg.h>
 #include <string.h>
 
 #include "muffin_core/common.h"
+#include "muffin_core/memory.h"
 
 #define mufCStrLength(Str) strlen(Str)
 #define mufCStrCompare(Str1, Str2) strcmp(Str1, Str2)
-#define mufCStrClone(Str) strdup(Str)
+#if defined(MUF_ENABLE_MEMORY_TRACKING)
+#   define mufCStrClone(Str) _mufMemoryTrackStrClone(Str, MUF_MEMORY_TAG, __FILE__, __LINE__)
+#else
+#   define mufCStrClone(Str) strdup(Str)
+#endif
 #define mufCStrCopy(Dst, Src) strcpy(Dst, Src)
 #define mufCStrCopyN(Dst, Src, Count) strncpy(Dst, Src, Count)
 #define mufCStrConcat(Dst, Src) strcat(Dst, Src)
@@ -18,26 +24,256 @@ typedef enum MufUtf8ResultCode_e {
     MUF_UTF8_INVALID
 } MufUtf8ResultCode;
 
+/*
+ * The UTF-8 functions taking a length do not stop at null characters. Validation and the transcoders use SSE2, SSSE3
+ * or AVX2, chosen at runtime. The transcoders vectorize runs of characters of one width: ASCII, 2 bytes (SSE2 and up)
+ * and 3 bytes (SSSE3 and up). Blocks that mix widths and characters of 4 bytes are converted one character at a time.
+ */
+
+/**
+ * @brief Count the characters of a string
+ * @return The count, or (muf_usize) -1 when the string is not valid UTF-8
+ */
 MUF_API muf_usize mufUtf8Length(const muf_char *str);
+MUF_API muf_usize mufUtf8LengthN(const muf_char *str, muf_usize length);
+
+/**
+ * @brief Check a string is valid UTF-8: no overlong forms, surrogates, values above U+10FFFF or cut sequences
+ */
 MUF_API muf_bool mufUtf8IsValid(const muf_char *str);
-MUF_API muf_result mufUtf8ToUtf16(muf_wchar *dstUtf16, muf_usize dstMaxLength, const muf_char *srcUtf8, muf_usize srcLength);
-MUF_API muf_result mufUtf16ToUtf8(muf_char *dstUtf8, muf_usize dstMaxLength, const muf_wchar *srcUtf16, muf_usize srcLength);
+MUF_API muf_bool mufUtf8IsValidN(const muf_char *str, muf_usize length);
+
+/**
+ * @brief Get the number of UTF-16 units a UTF-8 string converts to, the terminator not included
+ * @return The count, or (muf_usize) -1 when the string is not valid UTF-8
+ */
+MUF_API muf_usize mufUtf8GetUtf16Length(const muf_char *src, muf_usize srcLength);
+
+/**
+ * @brief Get the number of bytes a UTF-16 string converts to, the terminator not included
+ * @return The count, or (muf_usize) -1 when the string has an unpaired surrogate
+ */
+MUF_API muf_usize mufUtf16GetUtf8Length(const muf_u16 *src, muf_usize srcLength);
+
+/**
+ * @brief Convert UTF-8 to UTF-16, the output is null-terminated even when the conversion fails
+ * @param[in] dstMaxLength The size of dstUtf16 in units, the terminator included
+ * @return MUF_UTF8_TOO_SMALL when the output does not fit, MUF_UTF8_INVALID when the input is not valid UTF-8
+ */
+MUF_API MufUtf8ResultCode mufUtf8ToUtf16(muf_u16 *dstUtf16, muf_usize dstMaxLength, const muf_char *srcUtf8,
+    muf_usize srcLength);
+
+/**
+ * @brief Convert UTF-16 to UTF-8, the output is null-terminated even when the conversion fails
+ * @param[in] dstMaxLength The size of dstUtf8 in bytes, the terminator included
+ * @return MUF_UTF8_TOO_SMALL when the output does not fit, MUF_UTF8_INVALID for an unpaired surrogate
+ */
+MUF_API MufUtf8ResultCode mufUtf16ToUtf8(muf_char *dstUtf8, muf_usize dstMaxLength, const muf_u16 *srcUtf16,
+    muf_usize srcLength);
 
+/**
+ * @brief A borrowed, immutable run of characters, not necessarily null-terminated
+ */
+typedef struct MufStrView_s {
+    const muf_char  *data;
+    muf_usize       length;
+} MufStrView;
+
+#define MUF_STR_NPOS ((muf_usize) -1)
+
+/* The longest string kept inside the MufStr itself, one more byte holds the null terminator */
+#define MUF_STR_LOCAL_CAPACITY 23
+
+/*
+ * A growable string. Short strings are stored inline, longer ones in a buffer from the allocator given at init.
+ * The data is always null-terminated, the length is stored and the hash is computed once until the next change.
+ * A MufStr is a value: init one in place with mufInitStr and release its storage with mufDestroyStr.
+ */
 typedef struct MufStr_s {
-    muf_usize capacity;
-    muf_usize size;
+    union {
+        muf_char    *heap;
+        muf_char    local[MUF_STR_LOCAL_CAPACITY + 1];
+    } storage;
+    muf_usize                       size;
+    /* MUF_STR_LOCAL_CAPACITY while the string is stored inline */
+    muf_usize                       capacity;
+    /* mufHashBytes64(data, size, 0), 0 when not computed yet */
+    muf_u64                         hash;
+    const MufAllocatorCallbacks     *allocator;
 } MufStr;
 
-MufStr *mufCreateStr();
+MUF_INTERNAL MUF_INLINE MufStrView mufMakeStrView(const muf_char *data, muf_usize length) {
+    MufStrView view;
+    view.data = data;
+    view.length = length;
+    return view;
+}
+
+MUF_INTERNAL MUF_INLINE MufStrView mufStrViewFromCStr(const muf_char *str) {
+    return mufMakeStrView(str, mufCStrLength(str));
+}
+
+/**
+ * @brief Get a part of a view, the range is clamped to the view
+ * @param[in] begin The index of the first character
+ * @param[in] length The number of characters, or MUF_STR_NPOS for the rest of the view
+ */
+MUF_INTERNAL MUF_INLINE MufStrView mufStrViewSlice(MufStrView view, muf_usize begin, muf_usize length) {
+    begin = begin < view.length ? begin : view.length;
+    length = length < view.length - begin ? length : view.length - begin;
+    return mufMakeStrView(view.data + begin, length);
+}
+
+MUF_INTERNAL MUF_INLINE muf_bool mufStrViewEqual(MufStrView a, MufStrView b) {
+    return a.length == b.length && (a.data == b.data || mufMemEqual(a.data, b.data, a.length));
+}
+
+MUF_INTERNAL MUF_INLINE muf_bool mufStrViewStartsWith(MufStrView view, MufStrView prefix) {
+    return view.length >= prefix.length && mufMemEqual(view.data, prefix.data, prefix.length);
+}
+
+MUF_INTERNAL MUF_INLINE muf_bool mufStrViewEndsWith(MufStrView view, MufStrView suffix) {
+    return view.length >= suffix.length && mufMemEqual(view.data + view.length - suffix.length, suffix.data, suffix.length);
+}
+
+/**
+ * @brief Compare two views like strcmp, a view sorts before the views it is a prefix of
+ */
+MUF_API muf_i32 mufStrViewCompare(MufStrView a, MufStrView b);
+
+/**
+ * @return The index of the first occurrence at or after start, or MUF_STR_NPOS
+ */
+MUF_API muf_usize mufStrViewFind(MufStrView view, MufStrView needle, muf_usize start);
+
+MUF_API muf_usize mufStrViewFindChar(MufStrView view, muf_char c, muf_usize start);
+
+/**
+ * @return The index of the last occurrence, or MUF_STR_NPOS
+ */
+MUF_API muf_usize mufStrViewFindLastChar(MufStrView view, muf_char c);
+
+MUF_API muf_u64 mufStrViewHash(MufStrView view);
+
+/* For hash maps and sets keyed by MufStrView, the text is not copied into the container */
+MUF_API muf_index mufHash_strView(muf_crawptr value);
+MUF_API muf_bool mufEqual_strView(muf_crawptr a, muf_crawptr b);
+
+/**
+ * @brief Init an empty string
+ * @param[in] allocator The allocator of the buffer, NULL for MUF_DEFAULT_ALLOCATOR
+ */
+MUF_API void mufInitStr(MufStr *str, const MufAllocatorCallbacks *allocator);
+
+MUF_API void mufInitStrFromView(MufStr *str, MufStrView view, const MufAllocatorCallbacks *allocator);
+
+MUF_API void mufInitStrFromCStr(MufStr *str, const muf_char *cstr, const MufAllocatorCallbacks *allocator);
+
+/**
+ * @brief Release the buffer of the string, the MufStr itself is not freed
+ */
+MUF_API void mufDestroyStr(MufStr *str);
+
+/**
+ * @brief Copy a string, the copy uses the same allocator
+ */
+MUF_API MufStr mufCloneStr(const MufStr *str);
+
+MUF_INTERNAL MUF_INLINE muf_bool mufStrIsLocal(const MufStr *str) {
+    return str->capacity == MUF_STR_LOCAL_CAPACITY;
+}
+
+MUF_INTERNAL MUF_INLINE muf_char *mufStrGetData(MufStr *str) {
+    return mufStrIsLocal(str) ? str->storage.local : str->storage.heap;
+}
+
+MUF_INTERNAL MUF_INLINE const muf_char *mufStrGetCStr(const MufStr *str) {
+    return mufStrIsLocal(str) ? str->storage.local : str->storage.heap;
+}
+
+MUF_INTERNAL MUF_INLINE muf_usize mufStrGetSize(const MufStr *str) {
+    return str->size;
+}
+
+/**
+ * @brief Get the number of characters the string holds without growing, the terminator not included
+ */
+MUF_INTERNAL MUF_INLINE muf_usize mufStrGetCapacity(const MufStr *str) {
+    return str->capacity;
+}
+
+MUF_INTERNAL MUF_INLINE muf_bool mufStrIsEmpty(const MufStr *str) {
+    return str->size == 0;
+}
+
+MUF_INTERNAL MUF_INLINE MufStrView mufStrGetView(const MufStr *str) {
+    return mufMakeStrView(mufStrGetCStr(str), str->size);
+}
+
+/**
+ * @brief Get a view of a part of the string, valid until the string changes
+ */
+MUF_INTERNAL MUF_INLINE MufStrView mufStrSlice(const MufStr *str, muf_usize begin, muf_usize length) {
+    return mufStrViewSlice(mufStrGetView(str), begin, length);
+}
+
+/**
+ * @brief Get the hash of the string, equal to mufStrViewHash of its view and cached until the string changes
+ */
+MUF_API muf_u64 mufStrGetHash(MufStr *str);
+
+MUF_API muf_bool mufStrEqual(const MufStr *a, const MufStr *b);
+
+/**
+ * @brief Make room for at least capacity characters, the capacity at least doubles when it grows
+ */
+MUF_API void mufStrReserve(MufStr *str, muf_usize capacity);
+
+/**
+ * @brief Give back the unused part of the buffer, the string moves inline if it fits
+ */
+MUF_API void mufStrShrinkToFit(MufStr *str);
+
+/**
+ * @brief Empty the string and keep its buffer
+ */
+MUF_API void mufStrClear(MufStr *str);
+
+/**
+ * @brief Shorten the string to size characters, nothing happens if it is not longer
+ */
+MUF_API void mufStrTruncate(MufStr *str, muf_usize size);
+
+/**
+ * @brief Replace the contents with a view, the view may point into the string itself
+ */
+MUF_API void mufStrAssign(MufStr *str, MufStrView view);
+
+/**
+ * @brief Append characters, the view may point into the string itself
+ */
+MUF_API void mufStrAppend(MufStr *str, MufStrView view);
+
+MUF_API void mufStrAppendCStr(MufStr *str, const muf_char *cstr);
 
-void mufDestroyStr(MufStr *str);
+MUF_API void mufStrAppendChar(MufStr *str, muf_char c);
 
-MufStr mufCloneStr(const MufStr *str);
+/**
+ * @brief Append printf-style formatted text, the arguments may point into the string itself
+ */
+MUF_API void mufStrAppendFormat(MufStr *str, const muf_char *format, ...);
 
-muf_char *mufStrToCStr(const MufStr *str);
+MUF_API void mufStrAppendFormatV(MufStr *str, const muf_char *format, va_list args);
 
-void mufStrConcat();
+/**
+ * @brief Append a path component, adding a '/' between it and the string unless one side already has it
+ * The component may point into the string itself.
+ */
+MUF_API void mufStrAppendPath(MufStr *str, MufStrView component);
 
-void mufStrConcatCStr();
+/**
+ * @brief Replace count characters at index with a view, the view may point into the string itself
+ */
+MUF_API void mufStrReplace(MufStr *str, muf_usize index, muf_usize count, MufStrView view);
 
 #endif
\ No newline at end of file
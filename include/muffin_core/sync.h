@@ -0,0 +1,96 @@
+#ifndef _MUFFIN_CORE_SYNC_H_
+#define _MUFFIN_CORE_SYNC_H_
+
+#include "muffin_core/common.h"
+
+#if defined(MUF_COMPILER_GCC) || defined(MUF_COMPILER_CLANG)
+#   define MUF_THREAD_LOCAL __thread
+#elif defined(MUF_COMPILER_MSVC)
+#   define MUF_THREAD_LOCAL __declspec(thread)
+#else
+#   define MUF_THREAD_LOCAL
+#endif
+
+#if defined(MUF_COMPILER_GCC) || defined(MUF_COMPILER_CLANG)
+#   define mufAtomicLoad(_ptr) __atomic_load_n(_ptr, __ATOMIC_ACQUIRE)
+#   define mufAtomicLoadRelaxed(_ptr) __atomic_load_n(_ptr, __ATOMIC_RELAXED)
+#   define mufAtomicStore(_ptr, _value) __atomic_store_n(_ptr, _value, __ATOMIC_RELEASE)
+#   define mufAtomicExchange(_ptr, _value) __atomic_exchange_n(_ptr, _value, __ATOMIC_ACQ_REL)
+#   define mufAtomicFetchAdd(_ptr, _value) __atomic_fetch_add(_ptr, _value, __ATOMIC_ACQ_REL)
+#   define mufAtomicFetchSub(_ptr, _value) __atomic_fetch_sub(_ptr, _value, __ATOMIC_ACQ_REL)
+#   define mufAtomicCompareExchange(_ptr, _expectedPtr, _desired) \
+        __atomic_compare_exchange_n(_ptr, _expectedPtr, _desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+#   define mufAtomicPause() __builtin_ia32_pause()
+#else
+#   error "Atomic operations are not supported by the current compiler"
+#endif
+
+#if !defined(__i386__) && !defined(__x86_64__)
+#   undef  mufAtomicPause
+#   define mufAtomicPause() ((void) 0)
+#endif
+
+/**
+ * @brief A simple test-and-test-and-set spin lock, for very short critical sections only
+ */
+typedef volatile muf_u32 MufSpinLock;
+
+#define MUF_SPIN_LOCK_INIT 0U
+
+MUF_INTERNAL MUF_INLINE void mufSpinLockAcquire(MufSpinLock *lock) {
+    for (;;) {
+        if (mufAtomicExchange(lock, 1U) == 0U)
+            return;
+        while (mufAtomicLoadRelaxed(lock) != 0U)
+            mufAtomicPause();
+    }
+}
+
+MUF_INTERNAL MUF_INLINE muf_bool mufSpinLockTryAcquire(MufSpinLock *lock) {
+    return mufAtomicExchange(lock, 1U) == 0U;
+}
+
+MUF_INTERNAL MUF_INLINE void mufSpinLockRelease(MufSpinLock *lock) {
+    mufAtomicStore(lock, 0U);
+}
+
+typedef struct MufLock_s MufLock;
+typedef struct MufCondVar_s MufCondVar;
+
+MUF_API MufLock *mufCreateLock(void);
+
+MUF_API void mufDestroyLock(MufLock *lock);
+
+MUF_API void mufLockAcquire(MufLock *lock);
+
+MUF_API muf_bool mufLockTryAcquire(MufLock *lock);
+
+MUF_API void mufLockRelease(MufLock *lock);
+
+MUF_API MufCondVar *mufCreateCondVar(void);
+
+MUF_API void mufDestroyCondVar(MufCondVar *condVar);
+
+/**
+ * @brief Atomically release the lock and wait for the condition variable to be signaled
+ * @param[in] condVar The condition variable
+ * @param[in] lock The lock which must be held by the calling thread
+ */
+MUF_API void mufCondVarWait(MufCondVar *condVar, MufLock *lock);
+
+MUF_API void mufCondVarSignal(MufCondVar *condVar);
+
+MUF_API void mufCondVarBroadcast(MufCondVar *condVar);
+
+/**
+ * @brief Get a small, process-unique identifier of the calling thread
+ * @return The identifier, starting from 1 for the first thread that asks for it
+ */
+MUF_API muf_u32 mufGetCurrentThreadId(void);
+
+/**
+ * @brief Get the number of logical processors available to the process
+ */
+MUF_API muf_usize mufGetHardwareConcurrency(void);
+
+#endif
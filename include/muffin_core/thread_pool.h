@@ -0,0 +1,81 @@
+#ifndef _MUFFIN_CORE_THREAD_POOL_H_
+#define _MUFFIN_CORE_THREAD_POOL_H_
+
+#include "muffin_core/common.h"
+
+typedef struct MufThreadPool_s MufThreadPool;
+
+typedef MufUnaryFunc(MufTaskFunc, void, muf_rawptr);
+
+typedef void(*MufParallelRangeFunc)(muf_index first, muf_index last, muf_rawptr userData);
+
+/**
+ * @brief Track the completion of a group of submitted tasks
+ */
+typedef struct MufTaskCounter_s {
+    volatile muf_usize pending;
+} MufTaskCounter;
+
+#define MUF_TASK_COUNTER_INIT { 0 }
+
+/**
+ * @brief Create a pool of worker threads
+ * @param[in] workerCount The count of workers, 0 means one less than the hardware concurrency
+ * @return The thread pool object
+ */
+MUF_API MufThreadPool *mufCreateThreadPool(muf_usize workerCount);
+
+/**
+ * @brief Destroy the pool. Tasks already queued are finished before the workers exit.
+ * @param[in] pool The thread pool object
+ */
+MUF_API void mufDestroyThreadPool(MufThreadPool *pool);
+
+/**
+ * @brief Get the lazily created pool shared by the engine
+ */
+MUF_API MufThreadPool *mufGetGlobalThreadPool(void);
+
+MUF_API muf_usize mufThreadPoolGetWorkerCount(const MufThreadPool *pool);
+
+/**
+ * @brief Queue a task on the pool
+ * @param[in] pool The thread pool object
+ * @param[in] func The task function
+ * @param[in] userData The argument passed to the task function
+ * @param[in] counter Optional counter which is incremented now and decremented when the task is done
+ */
+MUF_API void mufThreadPoolSubmit(MufThreadPool *pool, MufTaskFunc func, muf_rawptr userData, MufTaskCounter *counter);
+
+/**
+ * @brief Wait until the counter drops to zero. The calling thread runs queued tasks while waiting.
+ * @param[in] pool The thread pool object
+ * @param[in] counter The counter passed to mufThreadPoolSubmit
+ */
+MUF_API void mufThreadPoolWait(MufThreadPool *pool, MufTaskCounter *counter);
+
+/**
+ * @brief Check if the calling thread is one of the workers of any pool
+ */
+MUF_API muf_bool mufThreadPoolIsWorkerThread(void);
+
+/**
+ * @brief Choose a chunk size for splitting `count` items over the workers of the pool
+ * @param[in] pool The thread pool object
+ * @param[in] count The count of items
+ * @param[in] minGrainSize The smallest chunk that is worth a task
+ * @return The chunk size, equal to `count` when the work should be done serially
+ */
+MUF_API muf_usize mufThreadPoolComputeGrainSize(const MufThreadPool *pool, muf_usize count, muf_usize minGrainSize);
+
+/**
+ * @brief Call `func` over [0, count) split into chunks, and wait for all of them
+ * @param[in] pool The thread pool object, NULL means the global pool
+ * @param[in] count The count of items
+ * @param[in] grainSize The chunk size, 0 means choosing it adaptively
+ * @param[in] func The range function
+ * @param[in] userData The argument passed to the range function
+ */
+MUF_API void mufParallelFor(MufThreadPool *pool, muf_usize count, muf_usize grainSize, MufParallelRangeFunc func, muf_rawptr userData);
+
+#endif
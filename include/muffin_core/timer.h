@@ -0,0 +1,29 @@
+#ifndef _MUFFIN_CORE_TIMER_H_
+#define _MUFFIN_CORE_TIMER_H_
+
+#include "muffin_core/common.h"
+
+/**
+ * @brief Read the high-resolution monotonic tick counter.
+ * On x86 with an invariant TSC this is `rdtsc`, otherwise the raw monotonic clock in nanoseconds.
+ * @return The current tick value
+ */
+MUF_API muf_u64 mufTimerGetTicks(void);
+
+/**
+ * @brief Get the count of ticks per second. The TSC frequency is calibrated on the first call.
+ */
+MUF_API muf_u64 mufTimerGetFrequency(void);
+
+MUF_API muf_u64 mufTimerTicksToNanoseconds(muf_u64 ticks);
+
+MUF_API muf_u64 mufTimerNanosecondsToTicks(muf_u64 nanoseconds);
+
+/**
+ * @brief Read the raw monotonic clock (CLOCK_MONOTONIC_RAW on Linux) in nanoseconds
+ */
+MUF_API muf_u64 mufTimerGetNanoseconds(void);
+
+MUF_API muf_bool mufTimerIsTscBased(void);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef _MUFFIN_DATA_BLOCK_COMPRESSION_H_
+#define _MUFFIN_DATA_BLOCK_COMPRESSION_H_
+
+#include "muffin_core/common.h"
+#include "muffin_core/thread_pool.h"
+#include "muffin_data/image.h"
+#include "muffin_data/mipmap.h"
+
+/*
+ * The encoder reads 8-bit images and writes the formats below:
+ *  - MUF_FORMAT_BC1_RGB_UNORM  from 3 or 4 channels, alpha is dropped
+ *  - MUF_FORMAT_BC1_RGBA_UNORM from 4 channels, alpha below 128 becomes transparent
+ *  - MUF_FORMAT_BC3_UNORM      from 4 channels
+ *  - MUF_FORMAT_BC4_UNORM      from the first channel
+ *  - MUF_FORMAT_BC5_UNORM      from the first two channels, typically the XY of a normal map
+ * The rows and columns of a partial block at the edges repeat the last pixel.
+ * A compressed MufImage keeps the size in pixels, its pitch is the byte count of a row of blocks.
+ */
+
+/**
+ * @brief Check if the encoder can write a format from an image of a format
+ */
+MUF_API muf_bool mufIsBlockCompressionSupported(MufFormat srcFormat, MufFormat dstFormat);
+
+/**
+ * @brief Compress an image in parallel over its rows of blocks
+ * @param[in] pool The thread pool object, NULL means the global pool
+ * @return The compressed image destroyed by mufDestroyImage, NULL if the conversion is not supported
+ */
+MUF_API MufImage *mufCompressImage(MufThreadPool *pool, const MufImage *image, MufFormat format);
+
+/**
+ * @brief Compress every level of a mip chain, the result keeps the smallest first layout
+ * @return The compressed chain, NULL if the conversion is not supported
+ */
+MUF_API MufMipChain *mufCompressMipChain(MufThreadPool *pool, const MufMipChain *chain, MufFormat format);
+
+#endif
@@ -2,22 +2,145 @@
 #define _MUFFIN_DATA_IMAGE_H_
 
 #include "muffin_core/common.h"
+#include "muffin_core/thread_pool.h"
+#include "muffin_render/enums.h"
 
+typedef enum MufImagePixelType_e {
+    MUF_IMAGE_PIXEL_TYPE_U8,
+    MUF_IMAGE_PIXEL_TYPE_U16,
+    MUF_IMAGE_PIXEL_TYPE_F32,
+    /* Keep the precision of the file: f32 for HDR images, u16 for 16-bit ones and u8 for the rest */
+    MUF_IMAGE_PIXEL_TYPE_NATIVE,
+    MUF_ENUM_COUNT(MUF_IMAGE_PIXEL_TYPE)
+} MufImagePixelType;
+
+/**
+ * @brief Pixels laid out the way a texture of `format` expects them, so they upload without conversion
+ */
 typedef struct MufImage_s {
     muf_u32     width;
     muf_u32     height;
     muf_u32     channels;
-    muf_rawptr  *data;
+    MufFormat   format;
+    /* The byte count from the start of a row to the start of the next one */
+    muf_usize   rowPitch;
+    muf_rawptr  data;
 } MufImage;
 
+/**
+ * @brief Describe an encoded image, either a file or bytes in memory (a mapped file view works as well)
+ */
+typedef struct MufImageLoadInfo_s {
+    /* Read when data is NULL */
+    const muf_char      *filePath;
+    const muf_byte      *data;
+    muf_usize           dataSize;
+    MufImagePixelType   pixelType;
+    /* The channel count of the decoded pixels, 0 keeps the one of the encoded image */
+    muf_u32             channels;
+    muf_bool            flipVertically;
+} MufImageLoadInfo;
+
 MufImage *mufCreateImage(muf_u32 width, muf_u32 height);
+
+/**
+ * @brief Decode a file keeping its native pixel type, see MUF_IMAGE_PIXEL_TYPE_NATIVE
+ * @return The image, NULL if it cannot be decoded
+ */
 MufImage *mufCreateImageFromFile(const muf_char *filePath, muf_bool flipVertically);
 void mufDestroyImage(MufImage *image);
 
+/**
+ * @brief Get the texture format of pixels of a type with 1 to 4 channels
+ * @return The format, _MUF_FORMAT_UNKNOWN_ for NATIVE or an unsupported channel count
+ */
+MUF_API MufFormat mufGetImageFormat(MufImagePixelType pixelType, muf_u32 channels);
+
+/**
+ * @brief Get the byte count of a pixel of a color format, 0 for depth and block compressed formats
+ */
+MUF_API muf_usize mufGetFormatPixelSize(MufFormat format);
+
+/**
+ * @brief Get the byte count of a 4x4 block of a block compressed format, 0 for the other formats
+ */
+MUF_API muf_usize mufGetFormatBlockSize(MufFormat format);
+
+/**
+ * @brief Decode an image, it is safe to call from several threads at once
+ * @return The image, NULL if it cannot be decoded
+ */
+MUF_API MufImage *mufLoadImage(const MufImageLoadInfo *info);
+
+/**
+ * @brief Decode a batch of images in parallel and wait for all of them
+ * @param[in] pool The thread pool object, NULL means the global pool
+ * @param[out] imagesOut Receives an image per info, NULL for the ones which cannot be decoded
+ */
+MUF_API void mufLoadImages(MufThreadPool *pool, const MufImageLoadInfo *infos, muf_usize count, MufImage **imagesOut);
+
 muf_u32 mufImageGetWidth(const MufImage *image);
 muf_u32 mufImageGetHeight(const MufImage *image);
 muf_u32 mufImageGetChannels(const MufImage *image);
+MUF_API MufFormat mufImageGetFormat(const MufImage *image);
+MUF_API muf_usize mufImageGetRowPitch(const MufImage *image);
 muf_rawptr mufImageGetData(MufImage *image);
 
+/**
+ * @brief Identify a decode request, 0 is never a valid id
+ */
+typedef muf_u64 MufImageDecodeId;
+
+typedef struct MufImageDecodeRequest_s {
+    MufImageLoadInfo    info;
+    muf_rawptr          userData;
+} MufImageDecodeRequest;
+
+typedef struct MufImageDecodeResult_s {
+    MufImageDecodeId    id;
+    muf_rawptr          userData;
+    /* The decoded image owned by the receiver, NULL on failure */
+    MufImage            *image;
+    /* The reason of a failure, a static string */
+    const muf_char      *error;
+} MufImageDecodeResult;
+
+typedef struct MufImageDecodeQueue_s MufImageDecodeQueue;
+
+/**
+ * @brief Create a queue decoding images on a thread pool.
+ * Every request is a task of its own, results are queued in completion order so the first
+ * images can be uploaded while the rest are still decoding.
+ * @param[in] pool The thread pool object, NULL means the global pool
+ */
+MUF_API MufImageDecodeQueue *mufCreateImageDecodeQueue(MufThreadPool *pool);
+
+/**
+ * @brief Wait for the outstanding requests and destroy the queue, images never received are destroyed
+ */
+MUF_API void mufDestroyImageDecodeQueue(MufImageDecodeQueue *queue);
+
+/**
+ * @brief Queue decode requests. The file paths are copied, encoded data must stay valid until its result is received.
+ * @param[out] idsOut Optional, receives an id per request
+ */
+MUF_API void mufImageDecodeQueueSubmit(MufImageDecodeQueue *queue, const MufImageDecodeRequest *requests, muf_usize count, MufImageDecodeId *idsOut);
+
+/**
+ * @brief Take a completed result without blocking
+ * @return False if no result is ready
+ */
+MUF_API muf_bool mufImageDecodeQueuePoll(MufImageDecodeQueue *queue, MufImageDecodeResult *resultOut);
+
+/**
+ * @brief Take the next completed result, blocking until one is ready
+ * @return False if no request is outstanding
+ */
+MUF_API muf_bool mufImageDecodeQueueWait(MufImageDecodeQueue *queue, MufImageDecodeResult *resultOut);
+
+/**
+ * @brief Get the count of requests whose results have not been received
+ */
+MUF_API muf_usize mufImageDecodeQueueGetPendingCount(MufImageDecodeQueue *queue);
 
-#endif
\ No newline at end of file
+#endif
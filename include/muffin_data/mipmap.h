@@ -0,0 +1,66 @@
+#ifndef _MUFFIN_DATA_MIPMAP_H_
+#define _MUFFIN_DATA_MIPMAP_H_
+
+#include "muffin_core/common.h"
+#include "muffin_core/thread_pool.h"
+#include "muffin_data/image.h"
+
+typedef enum MufMipFilter_e {
+    /* Averages the covered source pixels, the classic 2x2 box for even sizes */
+    MUF_MIP_FILTER_BOX,
+    /* Kaiser windowed sinc, sharper mips at a higher cost */
+    MUF_MIP_FILTER_KAISER,
+    MUF_ENUM_COUNT(MUF_MIP_FILTER)
+} MufMipFilter;
+
+typedef enum MufMipFlags_e {
+    MUF_MIP_FLAGS_NONE  = 0x0000,
+    /* The color channels of 8-bit images are sRGB encoded, they are filtered in linear space. Alpha stays linear. */
+    MUF_MIP_FLAGS_SRGB  = 0x0001
+} MufMipFlags;
+
+typedef struct MufMipChainCreateInfo_s {
+    MufMipFilter    filter;
+    MufMipFlags     flags;
+    /* The count of levels including the base one, 0 builds the full chain down to 1x1 */
+    muf_u32         levelCount;
+    /* The pool the rows are filtered on, NULL means the global pool */
+    MufThreadPool   *pool;
+} MufMipChainCreateInfo;
+
+/**
+ * @brief A full set of mip levels in a single allocation.
+ * The levels are stored from the smallest to the largest, so a prefix of the data holds the low mips
+ * and can be streamed in or uploaded first.
+ */
+typedef struct MufMipChain_s {
+    muf_u32     levelCount;
+    /* levels[0] is a copy of the source image, the pixels point into data */
+    MufImage    *levels;
+    muf_rawptr  data;
+    muf_usize   dataSize;
+} MufMipChain;
+
+/**
+ * @brief Get the count of levels of a full chain for a base size
+ */
+MUF_API muf_u32 mufGetMipLevelCount(muf_u32 width, muf_u32 height);
+
+/**
+ * @brief Build a mip chain, each level is filtered from the previous one in parallel over its rows.
+ * Exact 2x2 box levels are filtered as a cascade, each task takes a band of rows through several levels.
+ * @return The chain, NULL if the format of the image is not a 1 to 4 channel u8, u16 or f32 one
+ */
+MUF_API MufMipChain *mufCreateMipChain(const MufImage *image, const MufMipChainCreateInfo *info);
+MUF_API void mufDestroyMipChain(MufMipChain *chain);
+
+/**
+ * @brief Resample an image into another one of the same format and any size
+ * @param[in] pool The thread pool object, NULL means the global pool
+ * @param[in] src The source image
+ * @param[out] dst The destination, its size, format, pitch and pixels must already be set up
+ * @return False if the formats differ or are not supported
+ */
+MUF_API muf_bool mufResampleImage(MufThreadPool *pool, const MufImage *src, MufImage *dst, MufMipFilter filter, MufMipFlags flags);
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef _MUFFIN_PLATFORM_ARCHIVE_H_
+#define _MUFFIN_PLATFORM_ARCHIVE_H_
+
+#include "muffin_core/common.h"
+
+/**
+ * On-disk layout of a pack, every integer is little endian:
+ *   header | aligned blobs | path strings | entries | slots
+ * The slots form an open addressing table (linear probing, power of two size) of entry indices + 1
+ * keyed by mufHashBytes64 of the path with seed 0, so a lookup touches one or two cache lines of the mapping.
+ * The hash is 64 bits on every platform, hashBits is always 64 and rejects the truncated hashes of packs written by
+ * 32-bit builds.
+ */
+#define MUF_ARCHIVE_MAGIC           0x4B41504DU /* "MPAK" */
+#define MUF_ARCHIVE_VERSION         1U
+#define MUF_ARCHIVE_DEFAULT_ALIGN   16U
+
+typedef enum MufArchiveEntryFlags_e {
+    MUF_ARCHIVE_ENTRY_FLAG_NONE         = 0,
+    MUF_ARCHIVE_ENTRY_FLAG_COMPRESSED   = 1 << 0
+} MufArchiveEntryFlags;
+
+typedef struct MufArchiveHeader_s {
+    muf_u32 magic;
+    muf_u32 version;
+    muf_u32 hashBits;
+    muf_u32 alignment;
+    muf_u32 entryCount;
+    muf_u32 slotCount;
+    muf_u64 stringsOffset;
+    muf_u64 stringsSize;
+    muf_u64 entriesOffset;
+    muf_u64 slotsOffset;
+    muf_u64 fileSize;
+} MufArchiveHeader;
+
+typedef struct MufArchiveEntry_s {
+    muf_u64 pathHash;
+    muf_u64 offset;
+    muf_u64 size;
+    muf_u64 compressedSize;
+    muf_u32 pathOffset;
+    muf_u32 pathLength;
+    muf_u32 flags;
+    muf_u32 reserved;
+} MufArchiveEntry;
+
+typedef struct MufArchive_s MufArchive;
+typedef struct MufArchiveWriter_s MufArchiveWriter;
+
+/**
+ * @brief Map a pack read-only and validate its header and table of contents
+ * @param[in] path The pack file
+ * @return The archive, NULL if the file is missing or malformed
+ */
+MUF_API MufArchive *mufCreateArchive(const muf_char *path);
+MUF_API void mufDestroyArchive(MufArchive *archive);
+
+MUF_API muf_usize mufArchiveGetEntryCount(const MufArchive *archive);
+MUF_API const MufArchiveEntry *mufArchiveGetEntry(const MufArchive *archive, muf_index index);
+
+/**
+ * @brief Find an entry by its path ('/' separated, relative to the packed root)
+ * @return The entry, NULL if the pack does not contain the path
+ */
+MUF_API const MufArchiveEntry *mufArchiveFind(const MufArchive *archive, const muf_char *path);
+MUF_API muf_bool mufArchiveExists(const MufArchive *archive, const muf_char *path);
+
+/**
+ * @brief Get the path of an entry, null terminated and entry->pathLength characters long
+ */
+MUF_API const muf_char *mufArchiveGetEntryPath(const MufArchive *archive, const MufArchiveEntry *entry);
+
+/**
+ * @brief Get the stored bytes of an entry inside the mapping (entry->compressedSize bytes).
+ * The pointer stays valid until the archive is destroyed.
+ */
+MUF_API const muf_byte *mufArchiveGetEntryData(const MufArchive *archive, const MufArchiveEntry *entry);
+
+/**
+ * @brief Copy an entry into dst (entry->size bytes), compressed entries are decoded in parallel on the global thread pool
+ * @return False if the compressed payload is corrupted
+ */
+MUF_API muf_bool mufArchiveReadEntry(const MufArchive *archive, const MufArchiveEntry *entry, muf_rawptr dst);
+
+/**
+ * @brief Create a pack file, blobs are streamed to disk as they are added
+ * @param[in] path The output file
+ * @param[in] alignment The alignment of every blob, a power of two, 0 for the default
+ * @return The writer, NULL if the file cannot be created
+ */
+MUF_API MufArchiveWriter *mufCreateArchiveWriter(const muf_char *path, muf_u32 alignment);
+
+/**
+ * @brief Append a file to the pack
+ * @return False if the path is already in the pack or the write failed
+ */
+MUF_API muf_bool mufArchiveWriterAdd(MufArchiveWriter *writer, const muf_char *path, muf_crawptr data, muf_usize size);
+
+/**
+ * @brief Append a file stored as an LZ4 block stream (see muffin_core/compression.h),
+ * it is stored uncompressed when compression does not save anything
+ * @param[in] blockSize The block size, 0 for the default
+ * @return False if the path is already in the pack or the write failed
+ */
+MUF_API muf_bool mufArchiveWriterAddCompressed(MufArchiveWriter *writer, const muf_char *path, muf_crawptr data, muf_usize size, muf_u32 blockSize);
+
+/**
+ * @brief Write the table of contents and the header, then destroy the writer
+ * @return True if the pack is complete
+ */
+MUF_API muf_bool mufArchiveWriterFinish(MufArchiveWriter *writer);
+
+#endif
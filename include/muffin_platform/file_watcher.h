@@ -0,0 +1,121 @@
+#ifndef _MUFFIN_PLATFORM_FILE_WATCHER_H_
+#define _MUFFIN_PLATFORM_FILE_WATCHER_H_
+
+#include "muffin_core/common.h"
+#include "muffin_core/module.h"
+#include "muffin_data/image.h"
+#include "muffin_render/resources.h"
+
+#define MUF_FILE_WATCHER_MAX_PATH 1024
+#define MUF_FILE_WATCHER_MAX_PROGRAM_SHADERS 8
+
+typedef enum MufFileChangeFlags_e {
+    MUF_FILE_CHANGE_MODIFIED    = 0x01,
+    MUF_FILE_CHANGE_CREATED     = 0x02,
+    MUF_FILE_CHANGE_REMOVED     = 0x04,
+    MUF_FILE_CHANGE_DIRECTORY   = 0x08,
+    /* The notification buffer overflowed, anything under the root may have changed */
+    MUF_FILE_CHANGE_OVERFLOW    = 0x10
+} MufFileChangeFlags;
+
+/**
+ * @brief Identify a watched directory or a hook, 0 is never a valid id
+ */
+typedef muf_u32 MufFileWatchId;
+
+typedef struct MufFileChange_s {
+    /* The native path, the watched directory joined with the relative path using '/' */
+    const muf_char  *path;
+    const muf_char  *relativePath;
+    MufFileWatchId  directory;
+    /* The merged MufFileChangeFlags of every event of the path in the batch */
+    muf_u32         flags;
+} MufFileChange;
+
+/**
+ * @brief The changes of one quiet period, every path appears once.
+ * The set and its strings are only valid during the dispatch.
+ */
+typedef struct MufFileChangeSet_s {
+    const MufFileChange *changes;
+    muf_usize           count;
+} MufFileChangeSet;
+
+typedef void (*MufFileChangeHook)(const MufFileChange *change, muf_rawptr userData);
+typedef void (*MufFileChangeSetCallback)(const MufFileChangeSet *changeSet, muf_rawptr userData);
+
+typedef struct MufFileWatcherCreateInfo_s {
+    /* A batch is published once no event arrived for this long, 0 selects 100ms */
+    muf_u32                     coalesceMs;
+    /* A batch is published after this long even if events keep arriving, 0 selects 1000ms */
+    muf_u32                     maxLatencyMs;
+    /* Receives each whole batch during the dispatch before the hooks run, it can be NULL */
+    MufFileChangeSetCallback    callback;
+    muf_rawptr                  userData;
+} MufFileWatcherCreateInfo;
+
+typedef struct MufFileWatcher_s MufFileWatcher;
+
+/**
+ * @brief Create a file watcher.
+ * A background thread collects the change notifications and merges them per path until the directories are quiet,
+ * the batches are delivered on the thread calling mufFileWatcherDispatch so hooks can touch the graphics context.
+ * @return The watcher, NULL if the platform provides no change notifications
+ */
+MUF_API MufFileWatcher *mufCreateFileWatcher(const MufFileWatcherCreateInfo *info);
+MUF_API void mufDestroyFileWatcher(MufFileWatcher *watcher);
+
+/**
+ * @brief Watch a native directory recursively
+ * @return The id, 0 if the directory cannot be watched
+ */
+MUF_API MufFileWatchId mufFileWatcherAddDirectory(MufFileWatcher *watcher, const muf_char *directory);
+MUF_API void mufFileWatcherRemoveDirectory(MufFileWatcher *watcher, MufFileWatchId directory);
+
+/**
+ * @brief Call a hook for the changed paths matching a pattern.
+ * The pattern is matched against the whole native path, '*' matches any run of characters and '?' a single one,
+ * a pattern without wildcards names a single file.
+ * A hook may add and remove hooks, itself included, a hook removed during a dispatch is not called again.
+ * @return The hook id
+ */
+MUF_API MufFileWatchId mufFileWatcherAddHook(MufFileWatcher *watcher, const muf_char *pattern, MufFileChangeHook hook, muf_rawptr userData);
+MUF_API void mufFileWatcherRemoveHook(MufFileWatcher *watcher, MufFileWatchId hook);
+
+/**
+ * @brief Deliver the published batches on the calling thread, call it once per frame
+ * @return The count of delivered changes
+ */
+MUF_API muf_usize mufFileWatcherDispatch(MufFileWatcher *watcher);
+
+/**
+ * @brief Re-create a shader from its source file whenever the file changes.
+ * The new shader replaces *shader and the old one is destroyed, a source failing to compile keeps the old shader.
+ * The programs registered with mufFileWatcherHookShaderProgram that use the slot are relinked afterwards.
+ * The directory of the file is watched when no watched directory contains it.
+ * @param[in] shader The slot holding the live shader, it must outlive the hook
+ * @return The hook id, 0 if the directory cannot be watched
+ */
+MUF_API MufFileWatchId mufFileWatcherHookShader(MufFileWatcher *watcher, const muf_char *path, MufShaderType stageType, MufShader *shader);
+
+/**
+ * @brief Relink a program whenever a shader hook replaces one of its shaders, a failed link keeps the old program
+ * @param[in] program The slot holding the live program, it must outlive the hook
+ * @param[in] shaders The slots of the shaders of the program, they are copied and the slots must outlive the hook
+ * @return The hook id, removed with mufFileWatcherRemoveHook, 0 for more than MUF_FILE_WATCHER_MAX_PROGRAM_SHADERS shaders
+ */
+MUF_API MufFileWatchId mufFileWatcherHookShaderProgram(MufFileWatcher *watcher, MufShaderProgram *program,
+    MufShader *const *shaders, muf_usize shaderCount);
+
+/**
+ * @brief Reload an image whenever its file changes, a file failing to decode keeps the old image
+ * @param[in] image The slot holding the live image, it must outlive the hook
+ */
+MUF_API MufFileWatchId mufFileWatcherHookImage(MufFileWatcher *watcher, const muf_char *path, muf_bool flipVertically, MufImage **image);
+
+/**
+ * @brief Force a reload of a module whenever a file changes, typically the library or script providing it
+ */
+MUF_API MufFileWatchId mufFileWatcherHookModule(MufFileWatcher *watcher, const muf_char *path, MufModule module);
+
+#endif
@@ -19,7 +19,8 @@ typedef enum MufFileSeekMode_e {
 typedef struct MufFile_s {
     MufHandle       handle;
     MufFileOpenMode openMode;
-    const muf_char  *path;
+    /* A copy of the path the file was opened with, owned by the file */
+    muf_char        *path;
 } MufFile;
 
 MUF_API MufFile *mufCreateFile(const muf_char *path, MufFileOpenMode openMode);
@@ -38,6 +39,58 @@ MUF_API muf_usize mufFileWrite(MufFile *file, const muf_rawptr data, muf_usize s
 MUF_API muf_usize mufFileTruncate(MufFile *file, muf_usize size);
 MUF_API void mufFileFlush(MufFile *file);
 
+typedef enum MufFileMapMode_e {
+    MUF_FILE_MAP_READ_ONLY,
+    MUF_FILE_MAP_COPY_ON_WRITE
+} MufFileMapMode;
+
+typedef enum MufFileMapFlags_e {
+    MUF_FILE_MAP_FLAG_NONE          = 0,
+    MUF_FILE_MAP_FLAG_SEQUENTIAL    = 1 << 0,
+    MUF_FILE_MAP_FLAG_RANDOM        = 1 << 1,
+    MUF_FILE_MAP_FLAG_WILL_NEED     = 1 << 2,
+    MUF_FILE_MAP_FLAG_DONT_NEED     = 1 << 3,
+    MUF_FILE_MAP_FLAG_HUGE_PAGES    = 1 << 4,
+    MUF_FILE_MAP_FLAG_POPULATE      = 1 << 5
+} MufFileMapFlags;
+
+/**
+ * @brief A mapped range of a file. `data` points at the requested offset,
+ * the underscored fields describe the page aligned mapping.
+ */
+typedef struct MufFileView_s {
+    muf_rawptr  data;
+    muf_usize   size;
+    muf_rawptr  _base;
+    muf_usize   _mappedSize;
+    MufHandle   _mapping;
+} MufFileView;
+
+/**
+ * @brief Map a range of a file into memory. Writes to a copy-on-write view stay private to the process.
+ * Hints are best effort: HUGE_PAGES asks for transparent huge pages and aligns the mapping for them,
+ * POPULATE prefaults a read-only view (copy-on-write views fall back to WILL_NEED to avoid copying every page).
+ * @param[in] file An opened file
+ * @param[in] offset The first byte of the range, no alignment is required
+ * @param[in] size The byte count of the range, 0 maps to the end of the file
+ * @param[in] mode The access mode
+ * @param[in] flags A combination of MufFileMapFlags
+ * @param[out] viewOut The mapped view
+ * @return True if the range was mapped
+ */
+MUF_API muf_bool mufFileMap(MufFile *file, muf_offset offset, muf_usize size, MufFileMapMode mode, muf_u32 flags, MufFileView *viewOut);
+
+MUF_API void mufFileUnmap(MufFileView *view);
+
+/**
+ * @brief Apply access hints to a sub-range of a view, e.g. WILL_NEED ahead of a streaming cursor and DONT_NEED behind it
+ * @param[in] view The mapped view
+ * @param[in] offset The offset relative to view->data
+ * @param[in] size The byte count, 0 means to the end of the view
+ * @param[in] flags A combination of MufFileMapFlags
+ */
+MUF_API void mufFileViewAdvise(const MufFileView *view, muf_offset offset, muf_usize size, muf_u32 flags);
+
 MUF_API void mufGetCurrentDir();
 MUF_API void mufGetHomeDir();
 
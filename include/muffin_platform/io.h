@@ -1,4 +1,125 @@
 #ifndef _MUFFIN_PLATFORM_IO_H_
 #define _MUFFIN_PLATFORM_IO_H_
 
-#endif
\ No newline at end of file
+#include "muffin_core/common.h"
+#include "muffin_platform/filesystem.h"
+
+typedef enum MufIoPriority_e {
+    MUF_IO_PRIORITY_LOW,
+    MUF_IO_PRIORITY_NORMAL,
+    MUF_IO_PRIORITY_HIGH,
+    MUF_IO_PRIORITY_CRITICAL,
+    MUF_ENUM_COUNT(MUF_IO_PRIORITY)
+} MufIoPriority;
+
+typedef enum MufIoStatus_e {
+    MUF_IO_STATUS_PENDING,
+    MUF_IO_STATUS_COMPLETED,
+    MUF_IO_STATUS_FAILED,
+    MUF_IO_STATUS_CANCELED
+} MufIoStatus;
+
+typedef enum MufIoBackend_e {
+    MUF_IO_BACKEND_AUTO,
+    MUF_IO_BACKEND_THREAD_POOL,
+    MUF_IO_BACKEND_IO_URING
+} MufIoBackend;
+
+/**
+ * @brief Identify a submitted request, 0 is never a valid id
+ */
+typedef muf_u64 MufIoRequestId;
+
+typedef struct MufIoResult_s {
+    MufIoRequestId  id;
+    MufIoStatus     status;
+    muf_usize       bytesRead;
+    muf_i32         error;
+    muf_rawptr      dst;
+    muf_rawptr      userData;
+} MufIoResult;
+
+typedef void (*MufIoCallback)(const MufIoResult *result);
+
+typedef struct MufIoReadRequest_s {
+    MufFile         *file;
+    muf_offset      offset;
+    muf_usize       size;
+    muf_rawptr      dst;
+    MufIoPriority   priority;
+    MufIoCallback   callback;
+    muf_rawptr      userData;
+} MufIoReadRequest;
+
+typedef struct MufIoQueueCreateInfo_s {
+    MufIoBackend    backend;
+    muf_u32         queueDepth;
+    muf_u32         workerCount;
+} MufIoQueueCreateInfo;
+
+typedef struct MufIoQueue_s MufIoQueue;
+
+/**
+ * @brief Create an asynchronous read queue.
+ * AUTO uses io_uring on Linux when the kernel allows it and falls back to worker threads issuing positional reads.
+ * At most queueDepth requests are in flight, the others wait in per-priority FIFOs and the highest priority is dispatched first.
+ * @param[in] info The creation info, NULL for the defaults (AUTO, depth 64, 4 workers)
+ * @return The queue
+ */
+MUF_API MufIoQueue *mufCreateIoQueue(const MufIoQueueCreateInfo *info);
+
+/**
+ * @brief Cancel everything that was not dispatched, wait for the requests in flight and destroy the queue.
+ * Callbacks of requests that were not delivered yet are invoked with their final status.
+ */
+MUF_API void mufDestroyIoQueue(MufIoQueue *queue);
+
+MUF_API MufIoBackend mufIoQueueGetBackend(const MufIoQueue *queue);
+
+/**
+ * @brief Submit a batch of reads with a single kernel round trip.
+ * The destination buffers must stay valid until the callbacks run.
+ * @param[in] queue The queue
+ * @param[in] requests The requests
+ * @param[in] count The count of requests
+ * @param[out] idsOut The ids of the requests, may be NULL
+ * @return The count of accepted requests
+ */
+MUF_API muf_usize mufIoQueueSubmitReads(MufIoQueue *queue, const MufIoReadRequest *requests, muf_usize count, MufIoRequestId *idsOut);
+
+MUF_API MufIoRequestId mufIoQueueSubmitRead(MufIoQueue *queue, const MufIoReadRequest *request);
+
+/**
+ * @brief Cancel a request. The callback is still invoked exactly once, with the CANCELED status if the cancellation won.
+ * @return True if the request had not been dispatched and was withdrawn, false if it already started or finished
+ * (a request in flight on io_uring is still asked to stop)
+ */
+MUF_API muf_bool mufIoQueueCancel(MufIoQueue *queue, MufIoRequestId id);
+
+/**
+ * @brief Collect finished requests and invoke their callbacks on the calling thread
+ * @param[in] queue The queue
+ * @param[in] maxCompletions The maximal count of callbacks to invoke, 0 for no limit
+ * @return The count of invoked callbacks
+ */
+MUF_API muf_usize mufIoQueuePoll(MufIoQueue *queue, muf_usize maxCompletions);
+
+/**
+ * @brief Block until every submitted request finished and its callback was invoked
+ */
+MUF_API void mufIoQueueDrain(MufIoQueue *queue);
+
+MUF_API muf_usize mufIoQueueGetPendingCount(MufIoQueue *queue);
+
+/**
+ * @brief Get the process-wide queue used by the mufIo* shortcuts, it is created on the first use
+ */
+MUF_API MufIoQueue *mufGetDefaultIoQueue(void);
+
+MUF_API MufIoRequestId mufIoSubmitRead(MufFile *file, muf_offset offset, muf_usize size, muf_rawptr dst, MufIoCallback callback);
+
+MUF_API muf_bool mufIoCancel(MufIoRequestId id);
+
+MUF_API muf_usize mufIoPoll(muf_usize maxCompletions);
+
+#endif
@@ -3,9 +3,17 @@
 
 #include "muffin_core/common.h"
 
+/**
+ * @brief Read the monotonic platform clock
+ * @return The counter value, in units of 1 / mufPlatformGetTimeFrequency() seconds
+ */
 muf_u64 mufPlatformGetTime();
+muf_u64 mufPlatformGetTimeFrequency();
 void mufPlatformSleep(muf_u32 milliseconds);
 
+/**
+ * @brief Get the wall-clock time in milliseconds since the Unix epoch
+ */
 muf_u64 mufGetTimeStamp();
 
 #endif
\ No newline at end of file
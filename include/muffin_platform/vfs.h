@@ -0,0 +1,106 @@
+#ifndef _MUFFIN_PLATFORM_VFS_H_
+#define _MUFFIN_PLATFORM_VFS_H_
+
+#include "muffin_core/common.h"
+#include "muffin_platform/archive.h"
+#include "muffin_platform/filesystem.h"
+
+#define MUF_VFS_MAX_PATH 1024
+#define MUF_VFS_MAX_CACHED_MISSES 4096
+
+typedef enum MufVfsSourceType_e {
+    MUF_VFS_SOURCE_DIRECTORY,
+    MUF_VFS_SOURCE_ARCHIVE
+} MufVfsSourceType;
+
+/**
+ * @brief Identify a mount, 0 is never a valid id
+ */
+typedef muf_u32 MufVfsMountId;
+
+/**
+ * @brief Where a virtual path resolved to
+ */
+typedef struct MufVfsLocation_s {
+    MufVfsMountId           mount;
+    MufVfsSourceType        type;
+    muf_usize               size;
+    /* The native path for a directory mount */
+    muf_char                nativePath[MUF_VFS_MAX_PATH];
+    /* The entry for an archive mount, it stays valid while the mount exists */
+    const MufArchive        *archive;
+    const MufArchiveEntry   *entry;
+} MufVfsLocation;
+
+typedef struct MufVfs_s MufVfs;
+
+/**
+ * @brief Create a virtual filesystem.
+ * Lookups are cached by normalized path, negative results included up to MUF_VFS_MAX_CACHED_MISSES, past that
+ * the cached misses are dropped. On platforms with change notifications
+ * the cache entries of directory mounts are invalidated by mufVfsUpdate, elsewhere mufVfsInvalidate must be called.
+ */
+MUF_API MufVfs *mufCreateVfs(void);
+MUF_API void mufDestroyVfs(MufVfs *vfs);
+
+/**
+ * @brief Normalize a path: '\\' becomes '/', empty and '.' components are dropped, '..' pops a component
+ * (it never climbs above the root) and leading and trailing separators are removed
+ * @return The length of the normalized path, 0 if it does not fit into the output
+ */
+MUF_API muf_usize mufVfsNormalizePath(const muf_char *path, muf_char *pathOut, muf_usize capacity);
+
+/**
+ * @brief Mount a native directory at a virtual prefix.
+ * When several mounts provide a path the one with the highest priority wins, the latest mount wins ties.
+ * @param[in] vfs The virtual filesystem
+ * @param[in] prefix The virtual prefix, "" for the root
+ * @param[in] directory The native directory
+ * @param[in] priority The overlay priority
+ * @return The mount id, 0 if the directory cannot be opened
+ */
+MUF_API MufVfsMountId mufVfsMountDirectory(MufVfs *vfs, const muf_char *prefix, const muf_char *directory, muf_i32 priority);
+
+/**
+ * @brief Mount a pack (see archive.h) at a virtual prefix, the archive is owned by the mount
+ * @return The mount id, 0 if the pack cannot be opened
+ */
+MUF_API MufVfsMountId mufVfsMountArchive(MufVfs *vfs, const muf_char *prefix, const muf_char *archivePath, muf_i32 priority);
+
+/**
+ * @brief Remove a mount, a mufVfsReadFile already reading from it completes before its archive is released
+ */
+MUF_API muf_bool mufVfsUnmount(MufVfs *vfs, MufVfsMountId mount);
+
+/**
+ * @brief Resolve a virtual path through the overlays
+ * @return False if no mount provides the path
+ */
+MUF_API muf_bool mufVfsResolve(MufVfs *vfs, const muf_char *path, MufVfsLocation *locationOut);
+
+MUF_API muf_bool mufVfsExists(MufVfs *vfs, const muf_char *path);
+
+/**
+ * @brief Read a whole file, the buffer is allocated with mufAlloc and released with mufFree
+ * @return The buffer, NULL if the path does not exist or cannot be read
+ */
+MUF_API muf_byte *mufVfsReadFile(MufVfs *vfs, const muf_char *path, muf_usize *sizeOut);
+
+/**
+ * @brief Open a file of a directory mount, NULL for a missing path or a path provided by an archive.
+ * The returned file reports the native path it was opened from.
+ */
+MUF_API MufFile *mufVfsOpenFile(MufVfs *vfs, const muf_char *path);
+
+/**
+ * @brief Apply the pending change notifications to the lookup cache, call it once per frame
+ * @return The count of processed notifications
+ */
+MUF_API muf_usize mufVfsUpdate(MufVfs *vfs);
+
+/**
+ * @brief Drop the cached lookup of a path, or every cached lookup when path is NULL
+ */
+MUF_API void mufVfsInvalidate(MufVfs *vfs, const muf_char *path);
+
+#endif
@@ -48,15 +48,18 @@ typedef struct MufRenderBackendApi_s {
 
     MufTexture (* createTexture)(const MufTextureCreateInfo *info);
     void (* destroyTexture)(MufTexture texture);
+    void (* writeTexture)(MufTexture texture, muf_u32 mipLevel, muf_crawptr data, muf_usize rowPitch);
 
     MufFramebuffer (* createFramebuffer)(const MufFramebufferCreateInfo *info);
     void (* destroyFramebuffer)(MufFramebuffer frameBuffer);
 
     MufShader (* createShader)(const MufShaderCreateInfo *info);
     void (* destroyShader)(MufShader shader);
+    muf_bool (* isShaderCompiled)(MufShader shader);
 
     MufShaderProgram (* createShaderProgram)(const MufShaderProgramCreateInfo *info);
     void (* destroyShaderProgram)(MufShaderProgram program);
+    muf_bool (* isShaderProgramLinked)(MufShaderProgram program);
 
     MufPipeline (* createPipeline)(const MufPipelineCreateInfo *info);
     void (* destroyPipeline)(MufPipeline pipeline);
@@ -94,6 +97,9 @@ typedef struct MufRenderBackendApi_s {
         void (* bindIndexBuffer)(MufBuffer buffer, muf_offset offset);
         void (* beginRenderPass)(MufRenderPass renderPass);
         void (* endRenderPass)();
+        void (* beginTimerScope)(const muf_char *name);
+        void (* endTimerScope)();
+        void (* endFrame)();
         void (* bindResourceHeap)(MufResourceHeap resourceHeap);
         void (* draw)(muf_index firstIndex, muf_usize count);
         void (* drawIndexed)(muf_index firstIndex, muf_usize count);
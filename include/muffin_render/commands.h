@@ -56,6 +56,19 @@ MUF_API void mufCmdBindResourceHeap(MufResourceHeap resourceHeap);
 MUF_API void mufCmdBeginRenderPass(MufRenderPass renderPass);
 MUF_API void mufCmdEndRenderPass();
 
+/**
+ * @brief Open a GPU timing scope. Its duration is reported to the profiler a few frames later.
+ * The queries wait for mufCmdEndFrame, when too many are pending the new scopes are not timed.
+ * @param[in] name The scope name, which must outlive the profiler (string literals are expected)
+ */
+MUF_API void mufCmdBeginTimerScope(const muf_char *name);
+MUF_API void mufCmdEndTimerScope();
+
+/**
+ * @brief Mark the end of a frame, finished GPU timer queries are collected here without blocking
+ */
+MUF_API void mufCmdEndFrame();
+
 MUF_API void mufCmdDraw(muf_index firstIndex, muf_usize count);
 MUF_API void mufCmdDrawIndexed(muf_index firstIndex, muf_usize count);
 MUF_API void mufCmdBlit();
@@ -63,6 +63,19 @@ typedef enum MufFormat_e {
     MUF_FORMAT_R32G32B32A32_SINT,
     MUF_FORMAT_R32G32B32A32_FLOAT,
 
+    /* Block compressed formats, each 4x4 block of pixels takes 8 (BC1, BC4) or 16 bytes */
+    MUF_FORMAT_BC1_RGB_UNORM,
+    MUF_FORMAT_BC1_RGBA_UNORM,
+    MUF_FORMAT_BC2_UNORM,
+    MUF_FORMAT_BC3_UNORM,
+    MUF_FORMAT_BC4_UNORM,
+    MUF_FORMAT_BC4_SNORM,
+    MUF_FORMAT_BC5_UNORM,
+    MUF_FORMAT_BC5_SNORM,
+    MUF_FORMAT_BC6H_UFLOAT,
+    MUF_FORMAT_BC6H_SFLOAT,
+    MUF_FORMAT_BC7_UNORM,
+
     MUF_FORMAT_D16_UNORM,
     MUF_FORMAT_D32_FLOAT,
     MUF_FORMAT_D24_UNORM_S8_UINT,
@@ -2,6 +2,8 @@
 #define _MUFFIN_RENDER_RESOURCES_H_
 
 #include "muffin_core/common.h"
+#include "muffin_data/image.h"
+#include "muffin_data/mipmap.h"
 #include "muffin_core/math.h"
 #include "muffin_render/enums.h"
 
@@ -97,6 +99,29 @@ MUF_HANDLE_DEF(MufTexture);
 MUF_API MufTexture mufCreateTexture(const MufTextureCreateInfo *info);
 MUF_API void mufDestroyTexture(MufTexture texture);
 
+/**
+ * @brief Upload a whole mip level, the pixels must already be laid out as the format of the texture
+ * @param[in] texture The texture
+ * @param[in] mipLevel The mip level
+ * @param[in] data The pixels
+ * @param[in] rowPitch The byte count between the starts of two rows, a multiple of the pixel size; 0 means tightly packed
+ */
+MUF_API void mufWriteTexture(MufTexture texture, muf_u32 mipLevel, muf_crawptr data, muf_usize rowPitch);
+
+/**
+ * @brief Create a 2D texture with the format of an image and upload its pixels as they are
+ * @param[in] image The image
+ * @param[in] mipLevels The count of mip levels, the levels past the first are generated; 0 selects a full chain
+ * Block compressed images always get a single level.
+ */
+MUF_API MufTexture mufCreateTextureFromImage(const MufImage *image, muf_u32 mipLevels);
+
+/**
+ * @brief Create a 2D texture from prebuilt mip levels, the levels are uploaded from the smallest to the largest
+ * @param[in] chain The chain, levels[0] gives the size and format of the texture
+ */
+MUF_API MufTexture mufCreateTextureFromMipChain(const MufMipChain *chain);
+
 typedef struct MufSamplerCreateInfo_s {
     MufTextureFilter        minFilter;
     MufTextureFilter        magFilter;
@@ -153,6 +178,11 @@ MUF_HANDLE_DEF(MufShader);
 MUF_API MufShader mufCreateShader(const MufShaderCreateInfo *info);
 MUF_API void mufDestroyShader(MufShader shader);
 
+/**
+ * @brief Check whether a shader compiled, a failed shader still has a handle that must be destroyed
+ */
+MUF_API muf_bool mufIsShaderCompiled(MufShader shader);
+
 typedef struct MufShaderProgramCreateInfo_s {
     muf_usize shaderCount;
     MufShader *shaders;
@@ -163,6 +193,7 @@ MUF_HANDLE_DEF(MufShaderProgram);
 
 MUF_API MufShaderProgram mufCreateShaderProgram(const MufShaderProgramCreateInfo *info);
 MUF_API void mufDestroyShaderProgram(MufShaderProgram program);
+MUF_API muf_bool mufIsShaderProgramLinked(MufShaderProgram program);
 
 typedef enum MufUniformType_e {
     MUF_UNIFORM_TYPE_FLOAT,
@@ -239,6 +270,7 @@ MufFramebuffer mufCreateFramebuffer(const MufFramebufferCreateInfo *info);
 void mufDestroyFramebuffer(MufFramebuffer frameBuffer);
 
 typedef struct MufRenderPassCreateInfo_s {
+    const muf_char              *name;
     MufAttachmentLoadOperator   loadOp;
     MufAttachmentStoreOperator  storeOp;
     MufAttachmentLoadOperator   stencilLoadOp;
@@ -1,3 +1,5 @@
+#define MUF_MEMORY_TAG MUF_MEMORY_TAG_CORE_CONTAINERS
+
 #include "muffin_core/array.h"
 
 #include <stdlib.h>
@@ -170,7 +172,7 @@ void mufArrayRemove(MufArray *array, muf_index index) {
     }
     muf_rawptr moveDst = MUF_RAWPTR_AT(array->data, array->elementSize, index);
     muf_rawptr moveSrc = MUF_RAWPTR_AT(array->data, array->elementSize, index + 1);
-    memmove(moveDst, moveSrc, array->elementSize * (array->size - index));
+    memmove(moveDst, moveSrc, array->elementSize * (array->size - index - 1));
     --array->size;
 }
 
@@ -0,0 +1,428 @@
+#define MUF_MEMORY_TAG MUF_MEMORY_TAG_CORE_CONTAINERS
+
+#include "muffin_core/array.h"
+
+#include "muffin_core/math.h"
+#include "muffin_core/thread_pool.h"
+
+#define MUF_ARRAY_PARALLEL_MIN_GRAIN        4096
+#define MUF_ARRAY_SORT_MIN_GRAIN            8192
+#define MUF_ARRAY_INSERTION_SORT_THRESHOLD  16
+#define MUF_ARRAY_STACK_ELEMENT_SIZE        256
+
+#define _MUF_AT(_ptr, _elementSize, _index) MUF_RAWPTR_AT(_ptr, _elementSize, _index)
+
+/* Split [0, count) into a fixed chunk layout that several passes can share */
+typedef struct _MufChunkLayout_s {
+    muf_usize count;
+    muf_usize grain;
+    muf_usize chunkCount;
+} _MufChunkLayout;
+
+MUF_INTERNAL _MufChunkLayout _mufMakeChunkLayout(MufThreadPool *pool, muf_usize count, muf_usize minGrain) {
+    _MufChunkLayout layout;
+    layout.count = count;
+    layout.grain = mufThreadPoolComputeGrainSize(pool, count, minGrain);
+    layout.chunkCount = (count + layout.grain - 1) / layout.grain;
+    return layout;
+}
+
+MUF_INTERNAL MUF_INLINE muf_index _mufChunkFirst(const _MufChunkLayout *layout, muf_index chunk) {
+    return chunk * layout->grain;
+}
+
+MUF_INTERNAL MUF_INLINE muf_index _mufChunkLast(const _MufChunkLayout *layout, muf_index chunk) {
+    return mufMin(layout->count, (chunk + 1) * layout->grain);
+}
+
+/* Foreach */
+
+typedef struct _MufForeachContext_s {
+    MufArray            *array;
+    MufArrayElementFunc func;
+    muf_rawptr          userData;
+} _MufForeachContext;
+
+MUF_INTERNAL void _mufArrayForeachRange(muf_index first, muf_index last, muf_rawptr data) {
+    _MufForeachContext *ctx = (_MufForeachContext *) data;
+    for (muf_index i = first; i < last; ++i)
+        ctx->func(_MUF_AT(ctx->array->data, ctx->array->elementSize, i), i, ctx->userData);
+}
+
+void mufArrayParallelForeach(MufArray *array, MufArrayElementFunc func, muf_rawptr userData) {
+    MufThreadPool *pool = mufGetGlobalThreadPool();
+    _MufForeachContext ctx = { array, func, userData };
+    muf_usize grain = mufThreadPoolComputeGrainSize(pool, array->size, MUF_ARRAY_PARALLEL_MIN_GRAIN);
+    mufParallelFor(pool, array->size, grain, _mufArrayForeachRange, &ctx);
+}
+
+/* Sort */
+
+MUF_INTERNAL void _mufInsertionSort(muf_byte *data, muf_usize elementSize, muf_usize count, MufComparator cmp, muf_byte *key) {
+    for (muf_index i = 1; i < count; ++i) {
+        muf_byte *current = _MUF_AT(data, elementSize, i);
+        if (cmp(_MUF_AT(data, elementSize, i - 1), current) <= 0)
+            continue;
+
+        memcpy(key, current, elementSize);
+        muf_index j = i;
+        while (j > 0 && cmp(_MUF_AT(data, elementSize, j - 1), key) > 0)
+            --j;
+        memmove(_MUF_AT(data, elementSize, j + 1), _MUF_AT(data, elementSize, j), elementSize * (i - j));
+        memcpy(_MUF_AT(data, elementSize, j), key, elementSize);
+    }
+}
+
+/* Stable merge of a[0, aCount) and b[0, bCount) into dst, ties are taken from `a` */
+MUF_INTERNAL void _mufMerge(const muf_byte *a, muf_usize aCount, const muf_byte *b, muf_usize bCount,
+    muf_byte *dst, muf_usize elementSize, MufComparator cmp) {
+    muf_index i = 0, j = 0;
+    while (i < aCount && j < bCount) {
+        if (cmp(_MUF_AT(b, elementSize, j), _MUF_AT(a, elementSize, i)) < 0) {
+            memcpy(dst, _MUF_AT(b, elementSize, j++), elementSize);
+        } else {
+            memcpy(dst, _MUF_AT(a, elementSize, i++), elementSize);
+        }
+        dst += elementSize;
+    }
+    memcpy(dst, _MUF_AT(a, elementSize, i), elementSize * (aCount - i));
+    dst += elementSize * (aCount - i);
+    memcpy(dst, _MUF_AT(b, elementSize, j), elementSize * (bCount - j));
+}
+
+/* Find how many elements of `a` are among the first `k` outputs of the stable merge */
+MUF_INTERNAL muf_index _mufMergeCoRank(const muf_byte *a, muf_usize aCount, const muf_byte *b, muf_usize bCount,
+    muf_index k, muf_usize elementSize, MufComparator cmp) {
+    muf_index lo = k > bCount ? k - bCount : 0;
+    muf_index hi = mufMin(k, aCount);
+    while (lo < hi) {
+        muf_index i = lo + (hi - lo) / 2;
+        muf_index j = k - i;
+        if (cmp(_MUF_AT(b, elementSize, j - 1), _MUF_AT(a, elementSize, i)) >= 0)
+            lo = i + 1;
+        else
+            hi = i;
+    }
+    return lo;
+}
+
+/* Serial bottom-up merge sort of data[0, count), using buffer[0, count) as scratch */
+MUF_INTERNAL void _mufMergeSort(muf_byte *data, muf_byte *buffer, muf_usize elementSize, muf_usize count, MufComparator cmp) {
+    muf_byte stackKey[MUF_ARRAY_STACK_ELEMENT_SIZE];
+    muf_byte *key = elementSize <= sizeof(stackKey) ? stackKey : mufAllocBytes(elementSize);
+
+    for (muf_index first = 0; first < count; first += MUF_ARRAY_INSERTION_SORT_THRESHOLD) {
+        muf_usize runCount = mufMin(MUF_ARRAY_INSERTION_SORT_THRESHOLD, count - first);
+        _mufInsertionSort(_MUF_AT(data, elementSize, first), elementSize, runCount, cmp, key);
+    }
+    if (key != stackKey)
+        mufFree(key);
+
+    muf_byte *src = data, *dst = buffer;
+    for (muf_usize width = MUF_ARRAY_INSERTION_SORT_THRESHOLD; width < count; width <<= 1) {
+        for (muf_index first = 0; first < count; first += width << 1) {
+            muf_index middle = mufMin(first + width, count);
+            muf_index last = mufMin(first + (width << 1), count);
+            _mufMerge(_MUF_AT(src, elementSize, first), middle - first,
+                _MUF_AT(src, elementSize, middle), last - middle,
+                _MUF_AT(dst, elementSize, first), elementSize, cmp);
+        }
+        muf_byte *tmp = src; src = dst; dst = tmp;
+    }
+    if (src != data)
+        memcpy(data, src, elementSize * count);
+}
+
+typedef struct _MufSortContext_s {
+    muf_byte        *src;
+    muf_byte        *dst;
+    muf_usize       elementSize;
+    muf_usize       count;
+    muf_usize       width;
+    MufComparator   cmp;
+} _MufSortContext;
+
+MUF_INTERNAL void _mufSortRunRange(muf_index first, muf_index last, muf_rawptr data) {
+    _MufSortContext *ctx = (_MufSortContext *) data;
+    _mufMergeSort(_MUF_AT(ctx->src, ctx->elementSize, first), _MUF_AT(ctx->dst, ctx->elementSize, first),
+        ctx->elementSize, last - first, ctx->cmp);
+}
+
+/* Produce the outputs [first, last) of one merge round, which may span several pairs of runs */
+MUF_INTERNAL void _mufSortMergeRange(muf_index first, muf_index last, muf_rawptr data) {
+    _MufSortContext *ctx = (_MufSortContext *) data;
+    muf_usize es = ctx->elementSize;
+    muf_usize pairWidth = ctx->width << 1;
+
+    while (first < last) {
+        muf_index pairFirst = first - first % pairWidth;
+        muf_index pairMiddle = mufMin(pairFirst + ctx->width, ctx->count);
+        muf_index pairLast = mufMin(pairFirst + pairWidth, ctx->count);
+        muf_index outLast = mufMin(last, pairLast);
+
+        const muf_byte *a = _MUF_AT(ctx->src, es, pairFirst);
+        const muf_byte *b = _MUF_AT(ctx->src, es, pairMiddle);
+        muf_usize aCount = pairMiddle - pairFirst;
+        muf_usize bCount = pairLast - pairMiddle;
+
+        muf_index kFirst = first - pairFirst;
+        muf_index kLast = outLast - pairFirst;
+        muf_index aFirst = _mufMergeCoRank(a, aCount, b, bCount, kFirst, es, ctx->cmp);
+        muf_index aLast = _mufMergeCoRank(a, aCount, b, bCount, kLast, es, ctx->cmp);
+        muf_index bFirst = kFirst - aFirst;
+        muf_index bLast = kLast - aLast;
+
+        _mufMerge(_MUF_AT(a, es, aFirst), aLast - aFirst, _MUF_AT(b, es, bFirst), bLast - bFirst,
+            _MUF_AT(ctx->dst, es, first), es, ctx->cmp);
+        first = outLast;
+    }
+}
+
+void mufArrayParallelSort(MufArray *array, MufComparator cmp) {
+    if (array->size < 2)
+        return;
+
+    MufThreadPool *pool = mufGetGlobalThreadPool();
+    muf_usize es = array->elementSize;
+    muf_usize grain = mufThreadPoolComputeGrainSize(pool, array->size, MUF_ARRAY_SORT_MIN_GRAIN);
+    muf_byte *buffer = mufAllocBytes(es * array->size);
+
+    if (grain >= array->size) {
+        _mufMergeSort(array->data, buffer, es, array->size, cmp);
+        mufFree(buffer);
+        return;
+    }
+
+    _MufSortContext ctx = { array->data, buffer, es, array->size, grain, cmp };
+    mufParallelFor(pool, array->size, grain, _mufSortRunRange, &ctx);
+
+    for (; ctx.width < ctx.count; ctx.width <<= 1) {
+        ctx.dst = ctx.src == (muf_byte *) array->data ? buffer : (muf_byte *) array->data;
+        mufParallelFor(pool, ctx.count, grain, _mufSortMergeRange, &ctx);
+        ctx.src = ctx.dst;
+    }
+    if (ctx.src != (muf_byte *) array->data)
+        memcpy(array->data, ctx.src, es * array->size);
+    mufFree(buffer);
+}
+
+/* Reduce and scan */
+
+typedef struct _MufScanContext_s {
+    const muf_byte      *src;
+    muf_byte            *dst;
+    muf_usize           elementSize;
+    _MufChunkLayout     layout;
+    muf_byte            *partials;
+    MufArrayCombineFunc combine;
+    muf_bool            inclusive;
+} _MufScanContext;
+
+MUF_INTERNAL void _mufReduceChunkRange(muf_index firstChunk, muf_index lastChunk, muf_rawptr data) {
+    _MufScanContext *ctx = (_MufScanContext *) data;
+    muf_usize es = ctx->elementSize;
+    for (muf_index c = firstChunk; c < lastChunk; ++c) {
+        muf_byte *acc = _MUF_AT(ctx->partials, es, c);
+        muf_index first = _mufChunkFirst(&ctx->layout, c);
+        muf_index last = _mufChunkLast(&ctx->layout, c);
+        memcpy(acc, _MUF_AT(ctx->src, es, first), es);
+        for (muf_index i = first + 1; i < last; ++i)
+            ctx->combine(acc, acc, _MUF_AT(ctx->src, es, i));
+    }
+}
+
+void mufArrayParallelReduce(const MufArray *array, muf_crawptr identity, MufArrayCombineFunc combine, muf_rawptr resultOut) {
+    if (array->size == 0) {
+        memcpy(resultOut, identity, array->elementSize);
+        return;
+    }
+
+    MufThreadPool *pool = mufGetGlobalThreadPool();
+    muf_usize es = array->elementSize;
+    _MufScanContext ctx;
+    ctx.src = array->data;
+    ctx.dst = NULL;
+    ctx.elementSize = es;
+    ctx.layout = _mufMakeChunkLayout(pool, array->size, MUF_ARRAY_PARALLEL_MIN_GRAIN);
+    ctx.partials = mufAllocBytes(es * ctx.layout.chunkCount);
+    ctx.combine = combine;
+    ctx.inclusive = MUF_FALSE;
+
+    mufParallelFor(pool, ctx.layout.chunkCount, 1, _mufReduceChunkRange, &ctx);
+
+    /* Partials are folded in order, so only associativity is required */
+    memcpy(resultOut, ctx.partials, es);
+    for (muf_index c = 1; c < ctx.layout.chunkCount; ++c)
+        combine(resultOut, resultOut, _MUF_AT(ctx.partials, es, c));
+    mufFree(ctx.partials);
+}
+
+/* `partials[c]` holds the combined value of all chunks before c, chunk 0 has none */
+MUF_INTERNAL void _mufScanChunkRange(muf_index firstChunk, muf_index lastChunk, muf_rawptr data) {
+    _MufScanContext *ctx = (_MufScanContext *) data;
+    muf_usize es = ctx->elementSize;
+    muf_byte stackBuffer[MUF_ARRAY_STACK_ELEMENT_SIZE * 2];
+    muf_byte *acc = es * 2 <= sizeof(stackBuffer) ? stackBuffer : mufAllocBytes(es * 2);
+    muf_byte *current = acc + es;
+
+    for (muf_index c = firstChunk; c < lastChunk; ++c) {
+        muf_index first = _mufChunkFirst(&ctx->layout, c);
+        muf_index last = _mufChunkLast(&ctx->layout, c);
+        muf_bool hasAcc = c > 0 || !ctx->inclusive;
+        if (hasAcc)
+            memcpy(acc, _MUF_AT(ctx->partials, es, c), es);
+
+        for (muf_index i = first; i < last; ++i) {
+            /* Copy first, since `dst` may alias `src` */
+            memcpy(current, _MUF_AT(ctx->src, es, i), es);
+            if (ctx->inclusive) {
+                if (hasAcc)
+                    ctx->combine(acc, acc, current);
+                else
+                    memcpy(acc, current, es);
+                hasAcc = MUF_TRUE;
+                memcpy(_MUF_AT(ctx->dst, es, i), acc, es);
+            } else {
+                memcpy(_MUF_AT(ctx->dst, es, i), acc, es);
+                ctx->combine(acc, acc, current);
+            }
+        }
+    }
+
+    if (acc != stackBuffer)
+        mufFree(acc);
+}
+
+MUF_INTERNAL void _mufArrayParallelScan(const MufArray *src, MufArray *dst, muf_crawptr identity, MufArrayCombineFunc combine, muf_bool inclusive) {
+    MUF_ASSERT(src->elementSize == dst->elementSize);
+    muf_usize count = src->size;
+    if (dst != src) {
+        mufArrayReserve(dst, count);
+        dst->size = count;
+    }
+    if (count == 0)
+        return;
+
+    MufThreadPool *pool = mufGetGlobalThreadPool();
+    muf_usize es = src->elementSize;
+    _MufScanContext ctx;
+    ctx.src = src->data;
+    ctx.dst = dst->data;
+    ctx.elementSize = es;
+    ctx.layout = _mufMakeChunkLayout(pool, count, MUF_ARRAY_PARALLEL_MIN_GRAIN);
+    ctx.partials = mufAllocBytes(es * (ctx.layout.chunkCount + 1));
+    ctx.combine = combine;
+    ctx.inclusive = inclusive;
+
+    if (ctx.layout.chunkCount > 1) {
+        /* Reduce every chunk into partials[c + 1], then turn them into chunk offsets */
+        ctx.partials += es;
+        mufParallelFor(pool, ctx.layout.chunkCount - 1, 1, _mufReduceChunkRange, &ctx);
+        ctx.partials -= es;
+        for (muf_index c = 2; c < ctx.layout.chunkCount; ++c)
+            combine(_MUF_AT(ctx.partials, es, c), _MUF_AT(ctx.partials, es, c - 1), _MUF_AT(ctx.partials, es, c));
+    }
+    if (!inclusive) {
+        memcpy(ctx.partials, identity, es);
+        for (muf_index c = 1; c < ctx.layout.chunkCount; ++c)
+            combine(_MUF_AT(ctx.partials, es, c), identity, _MUF_AT(ctx.partials, es, c));
+    }
+
+    mufParallelFor(pool, ctx.layout.chunkCount, 1, _mufScanChunkRange, &ctx);
+    mufFree(ctx.partials);
+}
+
+void mufArrayParallelInclusiveScan(const MufArray *src, MufArray *dst, MufArrayCombineFunc combine) {
+    _mufArrayParallelScan(src, dst, NULL, combine, MUF_TRUE);
+}
+
+void mufArrayParallelExclusiveScan(const MufArray *src, MufArray *dst, muf_crawptr identity, MufArrayCombineFunc combine) {
+    _mufArrayParallelScan(src, dst, identity, combine, MUF_FALSE);
+}
+
+/* Stable partition */
+
+typedef struct _MufPartitionContext_s {
+    const muf_byte      *src;
+    muf_byte            *dst;
+    muf_usize           elementSize;
+    _MufChunkLayout     layout;
+    MufArrayPredicate   pred;
+    muf_bool            *flags;
+    muf_usize           *trueOffsets;
+    muf_usize           *falseOffsets;
+} _MufPartitionContext;
+
+MUF_INTERNAL void _mufPartitionCountRange(muf_index firstChunk, muf_index lastChunk, muf_rawptr data) {
+    _MufPartitionContext *ctx = (_MufPartitionContext *) data;
+    for (muf_index c = firstChunk; c < lastChunk; ++c) {
+        muf_usize trueCount = 0;
+        muf_index first = _mufChunkFirst(&ctx->layout, c);
+        muf_index last = _mufChunkLast(&ctx->layout, c);
+        for (muf_index i = first; i < last; ++i) {
+            ctx->flags[i] = ctx->pred(_MUF_AT(ctx->src, ctx->elementSize, i)) ? MUF_TRUE : MUF_FALSE;
+            trueCount += (muf_usize) ctx->flags[i];
+        }
+        ctx->trueOffsets[c] = trueCount;
+        ctx->falseOffsets[c] = (last - first) - trueCount;
+    }
+}
+
+MUF_INTERNAL void _mufPartitionScatterRange(muf_index firstChunk, muf_index lastChunk, muf_rawptr data) {
+    _MufPartitionContext *ctx = (_MufPartitionContext *) data;
+    muf_usize es = ctx->elementSize;
+    for (muf_index c = firstChunk; c < lastChunk; ++c) {
+        muf_usize trueIndex = ctx->trueOffsets[c];
+        muf_usize falseIndex = ctx->falseOffsets[c];
+        muf_index first = _mufChunkFirst(&ctx->layout, c);
+        muf_index last = _mufChunkLast(&ctx->layout, c);
+        for (muf_index i = first; i < last; ++i) {
+            muf_usize target = ctx->flags[i] ? trueIndex++ : falseIndex++;
+            memcpy(_MUF_AT(ctx->dst, es, target), _MUF_AT(ctx->src, es, i), es);
+        }
+    }
+}
+
+muf_index mufArrayParallelStablePartition(MufArray *array, MufArrayPredicate pred) {
+    if (array->size == 0)
+        return 0;
+
+    MufThreadPool *pool = mufGetGlobalThreadPool();
+    muf_usize es = array->elementSize;
+    _MufPartitionContext ctx;
+    ctx.src = array->data;
+    ctx.dst = mufAllocBytes(es * array->size);
+    ctx.elementSize = es;
+    ctx.layout = _mufMakeChunkLayout(pool, array->size, MUF_ARRAY_PARALLEL_MIN_GRAIN);
+    ctx.pred = pred;
+    ctx.flags = mufAlloc(muf_bool, array->size);
+    ctx.trueOffsets = mufAlloc(muf_usize, ctx.layout.chunkCount);
+    ctx.falseOffsets = mufAlloc(muf_usize, ctx.layout.chunkCount);
+
+    mufParallelFor(pool, ctx.layout.chunkCount, 1, _mufPartitionCountRange, &ctx);
+
+    muf_usize trueTotal = 0;
+    for (muf_index c = 0; c < ctx.layout.chunkCount; ++c)
+        trueTotal += ctx.trueOffsets[c];
+
+    muf_usize trueRunning = 0, falseRunning = trueTotal;
+    for (muf_index c = 0; c < ctx.layout.chunkCount; ++c) {
+        muf_usize trueCount = ctx.trueOffsets[c];
+        muf_usize falseCount = ctx.falseOffsets[c];
+        ctx.trueOffsets[c] = trueRunning;
+        ctx.falseOffsets[c] = falseRunning;
+        trueRunning += trueCount;
+        falseRunning += falseCount;
+    }
+
+    mufParallelFor(pool, ctx.layout.chunkCount, 1, _mufPartitionScatterRange, &ctx);
+
+    mufFree(array->data);
+    array->data = ctx.dst;
+    array->capacity = array->size;
+
+    mufFree(ctx.falseOffsets);
+    mufFree(ctx.trueOffsets);
+    mufFree(ctx.flags);
+    return trueTotal;
+}
@@ -0,0 +1,390 @@
+#define MUF_MEMORY_TAG MUF_MEMORY_TAG_CORE_CONTAINERS
+
+#include "muffin_core/bvh.h"
+#include "muffin_core/memory.h"
+
+#include <float.h>
+#include <math.h>
+
+#define MUF_BVH_BIN_COUNT       16
+/* Nodes with at most this many primitives always become leaves */
+#define MUF_BVH_MIN_LEAF_SIZE   2
+/* Nodes with more primitives are always split, even when the heuristic prefers a leaf */
+#define MUF_BVH_MAX_LEAF_SIZE   8
+/* The cost of visiting a node relative to testing a primitive */
+#define MUF_BVH_TRAVERSAL_COST  1.0F
+#define MUF_BVH_LOCAL_STACK     64
+/* A centroid spread below this fraction of the coordinates cannot be binned reliably */
+#define MUF_BVH_MIN_EXTENT      (16.0F * FLT_EPSILON)
+
+typedef struct _MufBvhNode_s {
+    MufAABB3    bounds;
+    /* The left child of an inner node (the right one follows it), the first primitive of a leaf */
+    muf_u32     first;
+    /* The primitive count of a leaf, 0 for an inner node */
+    muf_u32     count;
+} _MufBvhNode;
+
+struct MufBvh_s {
+    _MufBvhNode *nodes;
+    muf_u32     nodeCount;
+    muf_u32     primitiveCount;
+    /* The longest path from the root, it sizes the traversal stacks */
+    muf_u32     depth;
+    /* The primitive indices in leaf order, each leaf owns a contiguous range */
+    muf_u32     *indices;
+    /* The primitive boxes in the same order, the leaves read them without indirection */
+    MufAABB3    *bounds;
+};
+
+typedef struct _MufBvhBin_s {
+    MufAABB3    bounds;
+    muf_u32     count;
+} _MufBvhBin;
+
+typedef struct _MufBvhBuildEntry_s {
+    muf_u32 node;
+    muf_u32 depth;
+} _MufBvhBuildEntry;
+
+MUF_INTERNAL MufAABB3 _mufBvhEmptyBounds(void) {
+    MufAABB3 box;
+    box.min = mufCreateVec3(FLT_MAX, FLT_MAX, FLT_MAX);
+    box.max = mufCreateVec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    return box;
+}
+
+MUF_INTERNAL muf_f32 _mufBvhCentroid(const MufAABB3 *box, muf_u32 axis) {
+    return ((&box->min.x)[axis] + (&box->max.x)[axis]) * 0.5F;
+}
+
+/* The comparison order sends NaN and values past the last bin to the last bin, the cast never sees them */
+MUF_INTERNAL muf_u32 _mufBvhBinIndex(muf_f32 centroid, muf_f32 lo, muf_f32 scale) {
+    muf_f32 position = (centroid - lo) * scale;
+    if (position < (muf_f32) MUF_BVH_BIN_COUNT)
+        return position > 0.0F ? (muf_u32) position : 0;
+    return MUF_BVH_BIN_COUNT - 1;
+}
+
+/* Split a node or make it a leaf, returns true if two children were added */
+MUF_INTERNAL muf_bool _mufBvhSplitNode(MufBvh *bvh, muf_u32 nodeIndex) {
+    _MufBvhNode *node = &bvh->nodes[nodeIndex];
+    muf_u32 first = node->first, count = node->count;
+    if (count <= MUF_BVH_MIN_LEAF_SIZE)
+        return MUF_FALSE;
+
+    MufAABB3 centroids = _mufBvhEmptyBounds();
+    for (muf_u32 i = first; i < first + count; ++i) {
+        const MufAABB3 *box = &bvh->bounds[i];
+        MufVec3 c = mufCreateVec3(_mufBvhCentroid(box, 0), _mufBvhCentroid(box, 1), _mufBvhCentroid(box, 2));
+        centroids.min = mufCreateVec3(mufMin(centroids.min.x, c.x), mufMin(centroids.min.y, c.y), mufMin(centroids.min.z, c.z));
+        centroids.max = mufCreateVec3(mufMax(centroids.max.x, c.x), mufMax(centroids.max.y, c.y), mufMax(centroids.max.z, c.z));
+    }
+
+    /* Sweep the bins of every axis, the cost of a split is its surface area heuristic */
+    muf_f32 bestCost = FLT_MAX;
+    muf_u32 bestAxis = 0, bestSplit = 0;
+    for (muf_u32 axis = 0; axis < 3; ++axis) {
+        muf_f32 lo = (&centroids.min.x)[axis];
+        muf_f32 hi = (&centroids.max.x)[axis];
+        muf_f32 extent = hi - lo;
+        /* Also rejects a denormal or NaN extent, its bin scale would not be finite */
+        if (!(extent > mufMax((fabsf(lo) + fabsf(hi)) * MUF_BVH_MIN_EXTENT, FLT_MIN * MUF_BVH_BIN_COUNT)))
+            continue;
+
+        _MufBvhBin bins[MUF_BVH_BIN_COUNT];
+        for (muf_u32 b = 0; b < MUF_BVH_BIN_COUNT; ++b) {
+            bins[b].bounds = _mufBvhEmptyBounds();
+            bins[b].count = 0;
+        }
+        muf_f32 scale = (muf_f32) MUF_BVH_BIN_COUNT / extent;
+        for (muf_u32 i = first; i < first + count; ++i) {
+            muf_u32 b = _mufBvhBinIndex(_mufBvhCentroid(&bvh->bounds[i], axis), lo, scale);
+            bins[b].bounds = mufAABB3Union(bins[b].bounds, bvh->bounds[i]);
+            ++bins[b].count;
+        }
+
+        muf_f32 leftArea[MUF_BVH_BIN_COUNT - 1];
+        muf_u32 leftCount[MUF_BVH_BIN_COUNT - 1];
+        MufAABB3 accum = _mufBvhEmptyBounds();
+        muf_u32 accumCount = 0;
+        for (muf_u32 b = 0; b < MUF_BVH_BIN_COUNT - 1; ++b) {
+            accum = mufAABB3Union(accum, bins[b].bounds);
+            accumCount += bins[b].count;
+            leftArea[b] = accumCount > 0 ? mufAABB3SurfaceArea(accum) : 0.0F;
+            leftCount[b] = accumCount;
+        }
+        accum = _mufBvhEmptyBounds();
+        accumCount = 0;
+        for (muf_u32 b = MUF_BVH_BIN_COUNT - 1; b > 0; --b) {
+            accum = mufAABB3Union(accum, bins[b].bounds);
+            accumCount += bins[b].count;
+            if (leftCount[b - 1] == 0 || accumCount == 0)
+                continue;
+            muf_f32 cost = leftArea[b - 1] * (muf_f32) leftCount[b - 1] + mufAABB3SurfaceArea(accum) * (muf_f32) accumCount;
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b;
+            }
+        }
+    }
+
+    muf_u32 leftCount;
+    if (bestCost == FLT_MAX) {
+        /* Every centroid is at the same place, only an arbitrary split can bound the leaf size */
+        if (count <= MUF_BVH_MAX_LEAF_SIZE)
+            return MUF_FALSE;
+        leftCount = count / 2;
+    } else {
+        muf_f32 area = mufAABB3SurfaceArea(node->bounds);
+        muf_f32 splitCost = MUF_BVH_TRAVERSAL_COST + (area > 0.0F ? bestCost / area : 0.0F);
+        if (splitCost >= (muf_f32) count && count <= MUF_BVH_MAX_LEAF_SIZE)
+            return MUF_FALSE;
+
+        /* Partition the range in place, the indices follow their boxes */
+        muf_f32 lo = (&centroids.min.x)[bestAxis];
+        muf_f32 scale = (muf_f32) MUF_BVH_BIN_COUNT / ((&centroids.max.x)[bestAxis] - lo);
+        muf_u32 i = first, j = first + count;
+        while (i < j) {
+            if (_mufBvhBinIndex(_mufBvhCentroid(&bvh->bounds[i], bestAxis), lo, scale) < bestSplit) {
+                ++i;
+                continue;
+            }
+            --j;
+            mufSwap(MufAABB3, bvh->bounds[i], bvh->bounds[j]);
+            mufSwap(muf_u32, bvh->indices[i], bvh->indices[j]);
+        }
+        leftCount = i - first;
+    }
+
+    muf_u32 left = bvh->nodeCount;
+    bvh->nodeCount += 2;
+    node->first = left;
+    node->count = 0;
+
+    bvh->nodes[left].first = first;
+    bvh->nodes[left].count = leftCount;
+    bvh->nodes[left + 1].first = first + leftCount;
+    bvh->nodes[left + 1].count = count - leftCount;
+    return MUF_TRUE;
+}
+
+MUF_INTERNAL MufAABB3 _mufBvhLeafBounds(const MufBvh *bvh, const _MufBvhNode *node) {
+    MufAABB3 box = _mufBvhEmptyBounds();
+    for (muf_u32 i = node->first; i < node->first + node->count; ++i)
+        box = mufAABB3Union(box, bvh->bounds[i]);
+    return box;
+}
+
+MufBvh *mufCreateBvh(const MufAABB3 *bounds, muf_u32 count) {
+    MufBvh *bvh = mufAllocZero(MufBvh, 1);
+    bvh->primitiveCount = count;
+    bvh->indices = mufAlloc(muf_u32, mufMax(count, 1U));
+    bvh->bounds = mufAlloc(MufAABB3, mufMax(count, 1U));
+    /* A binary tree with at most one primitive per leaf */
+    bvh->nodes = mufAlloc(_MufBvhNode, mufMax(count * 2, 2U) - 1);
+    for (muf_u32 i = 0; i < count; ++i) {
+        bvh->indices[i] = i;
+        bvh->bounds[i] = bounds[i];
+    }
+
+    bvh->nodeCount = 1;
+    bvh->nodes[0].first = 0;
+    bvh->nodes[0].count = count;
+    if (count == 0) {
+        bvh->nodes[0].bounds = _mufBvhEmptyBounds();
+        return bvh;
+    }
+
+    /* Depth first, the children always come after their parent in the node array */
+    _MufBvhBuildEntry localStack[MUF_BVH_LOCAL_STACK];
+    _MufBvhBuildEntry *stack = localStack;
+    muf_u32 stackCapacity = MUF_BVH_LOCAL_STACK;
+    muf_u32 stackSize = 0;
+    stack[stackSize++] = (_MufBvhBuildEntry) { 0, 0 };
+    while (stackSize > 0) {
+        _MufBvhBuildEntry entry = stack[--stackSize];
+        _MufBvhNode *node = &bvh->nodes[entry.node];
+        node->bounds = _mufBvhLeafBounds(bvh, node);
+        bvh->depth = mufMax(bvh->depth, entry.depth);
+        if (!_mufBvhSplitNode(bvh, entry.node))
+            continue;
+
+        if (stackSize + 2 > stackCapacity) {
+            _MufBvhBuildEntry *grown = mufAlloc(_MufBvhBuildEntry, stackCapacity * 2);
+            mufMemCopyBytes(grown, stack, sizeof(_MufBvhBuildEntry) * stackSize);
+            if (stack != localStack)
+                mufFree(stack);
+            stack = grown;
+            stackCapacity *= 2;
+        }
+        muf_u32 left = bvh->nodes[entry.node].first;
+        stack[stackSize++] = (_MufBvhBuildEntry) { left + 1, entry.depth + 1 };
+        stack[stackSize++] = (_MufBvhBuildEntry) { left, entry.depth + 1 };
+    }
+    if (stack != localStack)
+        mufFree(stack);
+    return bvh;
+}
+
+void mufDestroyBvh(MufBvh *bvh) {
+    if (bvh == NULL)
+        return;
+    mufFree(bvh->nodes);
+    mufFree(bvh->indices);
+    mufFree(bvh->bounds);
+    mufFree(bvh);
+}
+
+void mufBvhRefit(MufBvh *bvh, const MufAABB3 *bounds) {
+    if (bvh->primitiveCount == 0)
+        return;
+
+    for (muf_u32 i = 0; i < bvh->primitiveCount; ++i)
+        bvh->bounds[i] = bounds[bvh->indices[i]];
+    /* Children are stored after their parent, a reverse sweep visits them first */
+    for (muf_u32 i = bvh->nodeCount; i-- > 0;) {
+        _MufBvhNode *node = &bvh->nodes[i];
+        if (node->count > 0)
+            node->bounds = _mufBvhLeafBounds(bvh, node);
+        else
+            node->bounds = mufAABB3Union(bvh->nodes[node->first].bounds, bvh->nodes[node->first + 1].bounds);
+    }
+}
+
+muf_u32 mufBvhGetNodeCount(const MufBvh *bvh) {
+    return bvh->nodeCount;
+}
+
+MufAABB3 mufBvhGetBounds(const MufBvh *bvh) {
+    return bvh->nodes[0].bounds;
+}
+
+/* The slab test with the inverse direction computed once per ray */
+MUF_INTERNAL muf_bool _mufBvhRayBox(const MufAABB3 *box, const muf_f32 *origin, const muf_f32 *inverse, muf_f32 tMax,
+    muf_f32 *tOut) {
+    muf_f32 tNear = 0.0F, tFar = tMax;
+    for (muf_u32 k = 0; k < 3; ++k) {
+        muf_f32 t0 = ((&box->min.x)[k] - origin[k]) * inverse[k];
+        muf_f32 t1 = ((&box->max.x)[k] - origin[k]) * inverse[k];
+        tNear = fmaxf(tNear, fminf(t0, t1));
+        tFar = fminf(tFar, fmaxf(t0, t1));
+    }
+    *tOut = tNear;
+    return tNear <= tFar;
+}
+
+muf_u32 mufBvhRaycast(const MufBvh *bvh, const MufRay *ray, muf_f32 tMax, MufBvhRayFunc func,
+    muf_rawptr userData, muf_f32 *tOut) {
+    muf_u32 hit = MUF_BVH_INVALID_INDEX;
+    const muf_f32 *origin = &ray->origin.x;
+    muf_f32 inverse[3] = { 1.0F / ray->direction.x, 1.0F / ray->direction.y, 1.0F / ray->direction.z };
+    muf_f32 t;
+    if (bvh->primitiveCount == 0 || !_mufBvhRayBox(&bvh->nodes[0].bounds, origin, inverse, tMax, &t))
+        return hit;
+
+    muf_u32 localStack[MUF_BVH_LOCAL_STACK];
+    muf_u32 *stack = bvh->depth + 2 <= MUF_BVH_LOCAL_STACK ? localStack : mufAlloc(muf_u32, bvh->depth + 2);
+    muf_u32 stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const _MufBvhNode *node = &bvh->nodes[stack[--stackSize]];
+        if (node->count > 0) {
+            for (muf_u32 i = node->first; i < node->first + node->count; ++i) {
+                muf_bool isHit = func != NULL ?
+                    func(bvh->indices[i], ray, tMax, &t, userData) :
+                    _mufBvhRayBox(&bvh->bounds[i], origin, inverse, tMax, &t);
+                if (isHit && t < tMax) {
+                    tMax = t;
+                    hit = bvh->indices[i];
+                }
+            }
+            continue;
+        }
+
+        /* The nearer child is pushed last so it is visited first, the farther one may be culled by then */
+        muf_f32 tLeft, tRight;
+        muf_bool hitLeft = _mufBvhRayBox(&bvh->nodes[node->first].bounds, origin, inverse, tMax, &tLeft);
+        muf_bool hitRight = _mufBvhRayBox(&bvh->nodes[node->first + 1].bounds, origin, inverse, tMax, &tRight);
+        if (hitLeft && hitRight) {
+            muf_bool leftFirst = tLeft <= tRight;
+            stack[stackSize++] = leftFirst ? node->first + 1 : node->first;
+            stack[stackSize++] = leftFirst ? node->first : node->first + 1;
+        } else if (hitLeft) {
+            stack[stackSize++] = node->first;
+        } else if (hitRight) {
+            stack[stackSize++] = node->first + 1;
+        }
+    }
+
+    if (stack != localStack)
+        mufFree(stack);
+    if (hit != MUF_BVH_INVALID_INDEX && tOut != NULL)
+        *tOut = tMax;
+    return hit;
+}
+
+/* Test a box against the planes of a mask, the planes the box is inside of are removed from it */
+MUF_INTERNAL muf_bool _mufBvhFrustumBox(const MufFrustum *frustum, const MufAABB3 *box, muf_u32 *planeMask) {
+    muf_f32 cx = (box->min.x + box->max.x) * 0.5F, ex = (box->max.x - box->min.x) * 0.5F;
+    muf_f32 cy = (box->min.y + box->max.y) * 0.5F, ey = (box->max.y - box->min.y) * 0.5F;
+    muf_f32 cz = (box->min.z + box->max.z) * 0.5F, ez = (box->max.z - box->min.z) * 0.5F;
+    for (muf_u32 i = 0; i < _MUF_FRUSTUM_PLANE_COUNT_; ++i) {
+        if ((*planeMask & (1U << i)) == 0)
+            continue;
+        MufVec4 p = frustum->planes[i];
+        muf_f32 distance = p.x * cx + p.y * cy + p.z * cz + p.w;
+        muf_f32 radius = fabsf(p.x) * ex + fabsf(p.y) * ey + fabsf(p.z) * ez;
+        if (distance + radius < 0.0F)
+            return MUF_FALSE;
+        if (distance - radius >= 0.0F)
+            *planeMask &= ~(1U << i);
+    }
+    return MUF_TRUE;
+}
+
+muf_usize mufBvhQueryFrustum(const MufBvh *bvh, const MufFrustum *frustum, MufArray *indicesOut) {
+    MUF_FASSERT(indicesOut->elementSize == sizeof(muf_u32), "The index array must hold muf_u32");
+    muf_usize startSize = mufArrayGetSize(indicesOut);
+    if (bvh->primitiveCount == 0)
+        return 0;
+
+    typedef struct _MufBvhFrustumEntry_s {
+        muf_u32 node;
+        muf_u32 planeMask;
+    } _MufBvhFrustumEntry;
+
+    _MufBvhFrustumEntry localStack[MUF_BVH_LOCAL_STACK];
+    _MufBvhFrustumEntry *stack = bvh->depth + 2 <= MUF_BVH_LOCAL_STACK ?
+        localStack : mufAlloc(_MufBvhFrustumEntry, bvh->depth + 2);
+    muf_u32 stackSize = 0;
+    stack[stackSize++] = (_MufBvhFrustumEntry) { 0, (1U << _MUF_FRUSTUM_PLANE_COUNT_) - 1 };
+    while (stackSize > 0) {
+        _MufBvhFrustumEntry entry = stack[--stackSize];
+        const _MufBvhNode *node = &bvh->nodes[entry.node];
+        if (entry.planeMask != 0 && !_mufBvhFrustumBox(frustum, &node->bounds, &entry.planeMask))
+            continue;
+
+        if (node->count == 0) {
+            stack[stackSize++] = (_MufBvhFrustumEntry) { node->first + 1, entry.planeMask };
+            stack[stackSize++] = (_MufBvhFrustumEntry) { node->first, entry.planeMask };
+            continue;
+        }
+
+        if (entry.planeMask == 0) {
+            mufArrayInsertRange(indicesOut, (muf_index) mufArrayGetSize(indicesOut), &bvh->indices[node->first],
+                node->count);
+            continue;
+        }
+        for (muf_u32 i = node->first; i < node->first + node->count; ++i) {
+            muf_u32 planeMask = entry.planeMask;
+            if (_mufBvhFrustumBox(frustum, &bvh->bounds[i], &planeMask))
+                mufArrayPush(indicesOut, &bvh->indices[i]);
+        }
+    }
+
+    if (stack != localStack)
+        mufFree(stack);
+    return mufArrayGetSize(indicesOut) - startSize;
+}
@@ -0,0 +1,146 @@
+#include "muffin_core/compression.h"
+
+#include "internal/lz4.h"
+#include "muffin_core/math.h"
+#include "muffin_core/memory.h"
+#include "muffin_core/sync.h"
+
+/* Keep every block well below MUF_LZ4_MAX_INPUT_SIZE */
+#define MUF_BLOCK_STREAM_MAX_BLOCK_SIZE (64U * 1024U * 1024U)
+
+typedef struct _MufDecompressTask_s {
+    MufDecompressJob    *job;
+    const muf_byte      *src;
+    muf_u32             srcSize;
+    muf_byte            *dst;
+    muf_u32             dstSize;
+    muf_bool            stored;
+} _MufDecompressTask;
+
+MUF_INTERNAL muf_u32 _mufBlockStreamBlockSize(muf_u32 blockSize) {
+    if (blockSize == 0)
+        return MUF_BLOCK_STREAM_DEFAULT_BLOCK_SIZE;
+    return mufMin(blockSize, MUF_BLOCK_STREAM_MAX_BLOCK_SIZE);
+}
+
+MUF_INTERNAL muf_usize _mufBlockStreamBlockCount(muf_usize size, muf_u32 blockSize) {
+    return (size + blockSize - 1) / blockSize;
+}
+
+muf_usize mufCompressBound(muf_usize size, muf_u32 blockSize) {
+    blockSize = _mufBlockStreamBlockSize(blockSize);
+    muf_usize blockCount = _mufBlockStreamBlockCount(size, blockSize);
+    /* A block that does not shrink is stored, so the payload never exceeds the input */
+    return sizeof(MufBlockStreamHeader) + blockCount * sizeof(muf_u32) + size;
+}
+
+muf_usize mufCompressBlocks(muf_crawptr src, muf_usize srcSize, muf_rawptr dst, muf_usize dstCapacity, muf_u32 blockSize) {
+    blockSize = _mufBlockStreamBlockSize(blockSize);
+    muf_usize blockCount = _mufBlockStreamBlockCount(srcSize, blockSize);
+    muf_usize tableSize = sizeof(MufBlockStreamHeader) + blockCount * sizeof(muf_u32);
+    if (blockCount > 0xFFFFFFFFU || dstCapacity < tableSize)
+        return 0;
+
+    MufBlockStreamHeader header;
+    header.blockSize = blockSize;
+    header.blockCount = (muf_u32) blockCount;
+    mufMemCopyBytes(dst, &header, sizeof(MufBlockStreamHeader));
+
+    muf_byte *sizes = (muf_byte *) dst + sizeof(MufBlockStreamHeader);
+    muf_byte *out = (muf_byte *) dst + tableSize;
+    muf_byte *outEnd = (muf_byte *) dst + dstCapacity;
+    muf_byte *scratch = mufAlloc(muf_byte, mufLz4CompressBound(blockSize));
+
+    for (muf_usize i = 0; i < blockCount; ++i) {
+        const muf_byte *block = (const muf_byte *) src + i * blockSize;
+        muf_u32 rawSize = (muf_u32) mufMin(srcSize - i * blockSize, (muf_usize) blockSize);
+        muf_usize packedSize = mufLz4Compress(block, rawSize, scratch, mufLz4CompressBound(rawSize));
+
+        const muf_byte *payload = scratch;
+        muf_u32 storedSize = (muf_u32) packedSize;
+        if (packedSize == 0 || packedSize >= rawSize) {
+            payload = block;
+            storedSize = rawSize | MUF_BLOCK_STREAM_STORED_BIT;
+        }
+
+        muf_usize payloadSize = storedSize & ~MUF_BLOCK_STREAM_STORED_BIT;
+        if ((muf_usize) (outEnd - out) < payloadSize) {
+            mufFree(scratch);
+            return 0;
+        }
+        mufMemCopyBytes(sizes + i * sizeof(muf_u32), &storedSize, sizeof(muf_u32));
+        mufMemCopyBytes(out, payload, payloadSize);
+        out += payloadSize;
+    }
+
+    mufFree(scratch);
+    return (muf_usize) (out - (muf_byte *) dst);
+}
+
+MUF_INTERNAL void _mufDecompressTask(muf_rawptr userData) {
+    _MufDecompressTask *task = (_MufDecompressTask *) userData;
+    if (task->stored) {
+        mufMemCopyBytes(task->dst, task->src, task->dstSize);
+        return;
+    }
+    muf_isize result = mufLz4Decompress(task->src, task->srcSize, task->dst, task->dstSize);
+    if (result != (muf_isize) task->dstSize)
+        mufAtomicStore(&task->job->failed, 1U);
+}
+
+muf_bool mufDecompressBlocksAsync(MufThreadPool *pool, muf_crawptr src, muf_usize srcSize, muf_rawptr dst, muf_usize dstSize, MufDecompressJob *job) {
+    job->pool = pool != NULL ? pool : mufGetGlobalThreadPool();
+    job->counter.pending = 0;
+    job->failed = 0;
+    job->_tasks = NULL;
+
+    MufBlockStreamHeader header;
+    if (srcSize < sizeof(MufBlockStreamHeader))
+        return MUF_FALSE;
+    mufMemCopyBytes(&header, src, sizeof(MufBlockStreamHeader));
+    if (header.blockSize == 0 || header.blockSize > MUF_BLOCK_STREAM_MAX_BLOCK_SIZE
+        || header.blockCount != _mufBlockStreamBlockCount(dstSize, header.blockSize)
+        || (srcSize - sizeof(MufBlockStreamHeader)) / sizeof(muf_u32) < header.blockCount)
+        return MUF_FALSE;
+
+    /* Resolve and validate every block before queuing anything, a malformed stream queues no work */
+    const muf_byte *sizes = (const muf_byte *) src + sizeof(MufBlockStreamHeader);
+    muf_usize offset = sizeof(MufBlockStreamHeader) + (muf_usize) header.blockCount * sizeof(muf_u32);
+    _MufDecompressTask *tasks = mufAlloc(_MufDecompressTask, header.blockCount);
+    for (muf_u32 i = 0; i < header.blockCount; ++i) {
+        muf_u32 storedSize;
+        mufMemCopyBytes(&storedSize, sizes + i * sizeof(muf_u32), sizeof(muf_u32));
+
+        _MufDecompressTask *task = &tasks[i];
+        task->job = job;
+        task->stored = (storedSize & MUF_BLOCK_STREAM_STORED_BIT) != 0;
+        task->srcSize = storedSize & ~MUF_BLOCK_STREAM_STORED_BIT;
+        task->src = (const muf_byte *) src + offset;
+        task->dst = (muf_byte *) dst + (muf_usize) i * header.blockSize;
+        task->dstSize = (muf_u32) mufMin(dstSize - (muf_usize) i * header.blockSize, (muf_usize) header.blockSize);
+
+        if (task->srcSize > srcSize - offset || (task->stored && task->srcSize != task->dstSize)) {
+            mufFree(tasks);
+            return MUF_FALSE;
+        }
+        offset += task->srcSize;
+    }
+
+    job->_tasks = tasks;
+    for (muf_u32 i = 0; i < header.blockCount; ++i)
+        mufThreadPoolSubmit(job->pool, _mufDecompressTask, &tasks[i], &job->counter);
+    return MUF_TRUE;
+}
+
+muf_bool mufDecompressJobWait(MufDecompressJob *job) {
+    mufThreadPoolWait(job->pool, &job->counter);
+    mufSafeFree(job->_tasks);
+    return mufAtomicLoad(&job->failed) == 0;
+}
+
+muf_bool mufDecompressBlocks(MufThreadPool *pool, muf_crawptr src, muf_usize srcSize, muf_rawptr dst, muf_usize dstSize) {
+    MufDecompressJob job;
+    if (!mufDecompressBlocksAsync(pool, src, srcSize, dst, dstSize, &job))
+        return MUF_FALSE;
+    return mufDecompressJobWait(&job);
+}
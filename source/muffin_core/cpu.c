@@ -0,0 +1,149 @@
+#include "muffin_core/cpu.h"
+#include "muffin_core/sync.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#   define MUF_CPU_X86
+#   if defined(_MSC_VER)
+#       include <intrin.h>
+#   else
+#       include <cpuid.h>
+#   endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__arm__)
+#   define MUF_CPU_ARM
+#   if defined(MUF_PLATFORM_LINUX) || defined(MUF_PLATFORM_ANDROID)
+#       include <sys/auxv.h>
+#   endif
+#endif
+
+static volatile muf_u32 _mufCpuDetectedFeatures = 0;
+static volatile muf_u32 _mufCpuFeaturesReady = 0;
+static volatile muf_u32 _mufCpuFeatureMask = MUF_CPU_FEATURE_ALL;
+
+static const char *const _mufCpuFeatureNames[] = {
+    "sse2", "sse3", "ssse3", "sse4.1", "sse4.2", "popcnt", "avx", "avx2", "fma", "f16c", "bmi1", "bmi2",
+    "avx512f", "avx512dq", "avx512bw", "avx512vl", "neon", "crc32"
+};
+
+#if defined(MUF_CPU_X86)
+
+MUF_INTERNAL void _mufCpuid(muf_u32 leaf, muf_u32 subleaf, muf_u32 regs[4]) {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, (int) leaf, (int) subleaf);
+    for (muf_u32 i = 0; i < 4; ++i)
+        regs[i] = (muf_u32) info[i];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+/* The register state the OS saves on context switches, only valid when OSXSAVE is set */
+MUF_INTERNAL muf_u64 _mufCpuXgetbv(void) {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    muf_u32 low, high;
+    __asm__ __volatile__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return ((muf_u64) high << 32) | low;
+#endif
+}
+
+#define _MUF_CPU_BIT(_reg, _bit) (((_reg) >> (_bit)) & 1U)
+
+MUF_INTERNAL muf_u32 _mufCpuDetect(void) {
+    muf_u32 regs[4];
+    _mufCpuid(0, 0, regs);
+    muf_u32 maxLeaf = regs[0];
+    if (maxLeaf < 1)
+        return 0;
+
+    muf_u32 features = 0;
+    _mufCpuid(1, 0, regs);
+    muf_u32 ecx = regs[2], edx = regs[3];
+    if (_MUF_CPU_BIT(edx, 26)) features |= MUF_CPU_FEATURE_SSE2;
+    if (_MUF_CPU_BIT(ecx, 0))  features |= MUF_CPU_FEATURE_SSE3;
+    if (_MUF_CPU_BIT(ecx, 9))  features |= MUF_CPU_FEATURE_SSSE3;
+    if (_MUF_CPU_BIT(ecx, 19)) features |= MUF_CPU_FEATURE_SSE41;
+    if (_MUF_CPU_BIT(ecx, 20)) features |= MUF_CPU_FEATURE_SSE42;
+    if (_MUF_CPU_BIT(ecx, 23)) features |= MUF_CPU_FEATURE_POPCNT;
+
+    muf_u64 xcr0 = _MUF_CPU_BIT(ecx, 27) ? _mufCpuXgetbv() : 0;
+    /* XMM and YMM state for AVX, plus the opmask and ZMM state for AVX-512 */
+    muf_bool ymmSaved = (xcr0 & 0x6) == 0x6;
+    muf_bool zmmSaved = (xcr0 & 0xE6) == 0xE6;
+    if (ymmSaved) {
+        if (_MUF_CPU_BIT(ecx, 28)) features |= MUF_CPU_FEATURE_AVX;
+        if (_MUF_CPU_BIT(ecx, 12)) features |= MUF_CPU_FEATURE_FMA;
+        if (_MUF_CPU_BIT(ecx, 29)) features |= MUF_CPU_FEATURE_F16C;
+    }
+
+    if (maxLeaf >= 7) {
+        _mufCpuid(7, 0, regs);
+        muf_u32 ebx = regs[1];
+        if (_MUF_CPU_BIT(ebx, 3)) features |= MUF_CPU_FEATURE_BMI1;
+        if (_MUF_CPU_BIT(ebx, 8)) features |= MUF_CPU_FEATURE_BMI2;
+        if (ymmSaved && _MUF_CPU_BIT(ebx, 5)) features |= MUF_CPU_FEATURE_AVX2;
+        if (zmmSaved) {
+            if (_MUF_CPU_BIT(ebx, 16)) features |= MUF_CPU_FEATURE_AVX512F;
+            if (_MUF_CPU_BIT(ebx, 17)) features |= MUF_CPU_FEATURE_AVX512DQ;
+            if (_MUF_CPU_BIT(ebx, 30)) features |= MUF_CPU_FEATURE_AVX512BW;
+            if (_MUF_CPU_BIT(ebx, 31)) features |= MUF_CPU_FEATURE_AVX512VL;
+        }
+    }
+    return features;
+}
+
+#elif defined(MUF_CPU_ARM)
+
+MUF_INTERNAL muf_u32 _mufCpuDetect(void) {
+    muf_u32 features = 0;
+#if defined(__aarch64__) || defined(_M_ARM64)
+    /* Advanced SIMD is mandatory on AArch64 */
+    features |= MUF_CPU_FEATURE_NEON;
+#   if defined(__APPLE__)
+    features |= MUF_CPU_FEATURE_ARM_CRC32;
+#   elif defined(MUF_PLATFORM_LINUX) || defined(MUF_PLATFORM_ANDROID)
+    /* HWCAP_CRC32 */
+    if (getauxval(AT_HWCAP) & (1UL << 7))
+        features |= MUF_CPU_FEATURE_ARM_CRC32;
+#   endif
+#elif defined(MUF_PLATFORM_LINUX) || defined(MUF_PLATFORM_ANDROID)
+    /* HWCAP_NEON of 32-bit ARM */
+    if (getauxval(AT_HWCAP) & (1UL << 12))
+        features |= MUF_CPU_FEATURE_NEON;
+#endif
+    return features;
+}
+
+#else
+
+MUF_INTERNAL muf_u32 _mufCpuDetect(void) {
+    return 0;
+}
+
+#endif
+
+MufCpuFeatureFlags mufCpuFeatures(void) {
+    /* The detection gives the same result on every thread, racing first calls only repeat it */
+    if (!mufAtomicLoad(&_mufCpuFeaturesReady)) {
+        mufAtomicStore(&_mufCpuDetectedFeatures, _mufCpuDetect());
+        mufAtomicStore(&_mufCpuFeaturesReady, 1U);
+    }
+    return (MufCpuFeatureFlags) (mufAtomicLoad(&_mufCpuDetectedFeatures) & mufAtomicLoad(&_mufCpuFeatureMask));
+}
+
+muf_bool mufHasCpuFeatures(MufCpuFeatureFlags features) {
+    return (mufCpuFeatures() & features) == features;
+}
+
+void mufSetCpuFeatureMask(MufCpuFeatureFlags mask) {
+    mufAtomicStore(&_mufCpuFeatureMask, (muf_u32) mask);
+}
+
+const char *mufGetCpuFeatureName(MufCpuFeatureFlags feature) {
+    for (muf_usize i = 0; i < MUF_COUNTOF(_mufCpuFeatureNames); ++i) {
+        if ((muf_u32) feature == 1U << i)
+            return _mufCpuFeatureNames[i];
+    }
+    return NULL;
+}
@@ -1,14 +1,23 @@
+#define MUF_MEMORY_TAG MUF_MEMORY_TAG_CORE_CONTAINERS
+
 #include "muffin_core/dict.h"
 
 #include "internal/hash_table.h"
+#include "muffin_core/intern.h"
 #include "muffin_core/memory.h"
 #include "muffin_core/string.h"
 
 #define _TABLE(_ptr) ((MufHashTable *)(_ptr))
 
+/*
+ * A key inserted by text is a copy owned by the dict, a key inserted by id points to the interned text.
+ * A key looked up by id matches an interned key by comparing pointers.
+ */
 typedef struct _MufStrWrapper_s {
-    muf_usize length;
-    muf_char *data;
+    muf_usize       length;
+    const muf_char  *data;
+    muf_u64         hash;
+    muf_bool        owned;
 } _MufStrWrapper;
 
 static muf_rawptr _mufDictKeyExtract(MufHashTableNode *node) {
@@ -18,13 +27,38 @@ static muf_rawptr _mufDictKeyExtract(MufHashTableNode *node) {
 static muf_bool _mufStrWrapperEqual(muf_crawptr a, muf_crawptr b) {
     const _MufStrWrapper *s1 = (const _MufStrWrapper *) a;
     const _MufStrWrapper *s2 = (const _MufStrWrapper *) b;
-    return s1->data == s2->data ? MUF_TRUE : 
-        (s1->length == s2->length ? mufCStrCompare(a, b) == 0 : MUF_FALSE);
+    return s1->data == s2->data ? MUF_TRUE :
+        (s1->hash == s2->hash && s1->length == s2->length && mufMemEqual(s1->data, s2->data, s1->length));
 }
 
 static muf_index _mufStrWrapperHash(muf_crawptr str) {
-    _MufStrWrapper *s = (_MufStrWrapper *) str;
-    return mufHashBytes(s->data, s->length);
+    return (muf_index) ((const _MufStrWrapper *) str)->hash;
+}
+
+static MUF_INLINE void _mufStrWrapperFromCStr(_MufStrWrapper *wrapper, const muf_char *str) {
+    wrapper->data = str;
+    wrapper->length = mufCStrLength(str);
+    wrapper->hash = mufHashBytes64(str, wrapper->length, 0);
+    wrapper->owned = MUF_FALSE;
+}
+
+static MUF_INLINE void _mufStrWrapperFromStr(_MufStrWrapper *wrapper, MufStr *str) {
+    wrapper->data = mufStrGetCStr(str);
+    wrapper->length = mufStrGetSize(str);
+    wrapper->hash = mufStrGetHash(str);
+    wrapper->owned = MUF_FALSE;
+}
+
+static MUF_INLINE void _mufStrWrapperFromId(_MufStrWrapper *wrapper, MufStrId id) {
+    wrapper->data = mufGetStrIdCStr(id);
+    wrapper->length = mufGetStrIdLength(id);
+    wrapper->hash = mufGetStrIdHash(id);
+    wrapper->owned = MUF_FALSE;
+}
+
+static MUF_INLINE void _mufStrWrapperFree(_MufStrWrapper *wrapper) {
+    if (wrapper->owned)
+        mufFree((muf_char *) wrapper->data);
 }
 
 MufDict *_mufCreateDict(muf_usize valueSize) {
@@ -52,64 +86,113 @@ muf_bool mufDictIsEmpty(const MufDict *dict) {
     return _TABLE(dict)->size == 0;
 }
 
+static MUF_INLINE muf_rawptr _mufDictFind(const MufDict *dict, const _MufStrWrapper *query) {
+    MufHashTableNode *node = mufHashTableFind(_TABLE(dict), query, NULL);
+    return node == NULL ? NULL : mufHashTableExtractNodeValue(_TABLE(dict), node);
+}
+
 muf_bool mufDictContains(const MufDict *dict, const muf_char *key) {
     _MufStrWrapper query;
-    query.data = (muf_char *) key;
-    query.length = mufCStrLength(key);
-    return mufHashTableFind(_TABLE(dict), &query, NULL) != NULL;
+    _mufStrWrapperFromCStr(&query, key);
+    return _mufDictFind(dict, &query) != NULL;
+}
+
+muf_bool mufDictContainsId(const MufDict *dict, MufStrId key) {
+    _MufStrWrapper query;
+    _mufStrWrapperFromId(&query, key);
+    return _mufDictFind(dict, &query) != NULL;
+}
+
+muf_bool mufDictContainsStr(const MufDict *dict, MufStr *key) {
+    _MufStrWrapper query;
+    _mufStrWrapperFromStr(&query, key);
+    return _mufDictFind(dict, &query) != NULL;
 }
 
 muf_rawptr mufDictGetRef(MufDict *dict, const muf_char *key) {
     _MufStrWrapper query;
-    query.data = (muf_char *) key;
-    query.length = mufCStrLength(key);
-    MufHashTableNode *node = mufHashTableFind(_TABLE(dict), &query, NULL);
-    return node == NULL ? NULL : mufHashTableExtractNodeValue(_TABLE(dict), node);
+    _mufStrWrapperFromCStr(&query, key);
+    return _mufDictFind(dict, &query);
 }
 
-muf_bool mufDictGet(MufDict *dict, const muf_char *key, muf_rawptr out) {
+muf_rawptr mufDictGetRefId(MufDict *dict, MufStrId key) {
     _MufStrWrapper query;
-    query.data = (muf_char *) key;
-    query.length = mufCStrLength(key);
-    MufHashTableNode *node = mufHashTableFind(_TABLE(dict), &query, NULL);
+    _mufStrWrapperFromId(&query, key);
+    return _mufDictFind(dict, &query);
+}
 
-    if (!node) { 
+muf_rawptr mufDictGetRefStr(MufDict *dict, MufStr *key) {
+    _MufStrWrapper query;
+    _mufStrWrapperFromStr(&query, key);
+    return _mufDictFind(dict, &query);
+}
+
+muf_bool mufDictGet(MufDict *dict, const muf_char *key, muf_rawptr out) {
+    muf_rawptr value = mufDictGetRef(dict, key);
+
+    if (!value) { 
         return MUF_FALSE;
     }
 
-    muf_rawptr value = mufHashTableExtractNodeValue(_TABLE(dict), node);
     mufMemCopyBytes(out, value, _TABLE(dict)->valueSize);
     return MUF_TRUE;
 }
 
-static MUF_INLINE MufHashTableNode *_mufDictCreateNode(const MufDict *dict, const muf_char *key, muf_crawptr value) {
+/* A copied key is freed with its entry, an interned key is not */
+static MUF_INLINE muf_rawptr _mufDictInsertNew(MufDict *dict, const _MufStrWrapper *key, muf_bool copyKey,
+    muf_crawptr value) {
     MufHashTableNode *node = mufCreateHashTableNode(NULL, 0, _TABLE(dict)->storageSize, NULL);
     _MufStrWrapper *keyWrapper = (_MufStrWrapper *) mufHashTableExtractNodeKey(_TABLE(dict), node);
-    keyWrapper->data = mufCStrClone(key);
-    keyWrapper->length = mufCStrLength(key);
-    node->hashCode = _mufStrWrapperHash(keyWrapper);
+    *keyWrapper = *key;
+    if (copyKey) {
+        muf_char *data = mufAlloc(muf_char, key->length + 1);
+        mufMemCopyBytes(data, key->data, key->length);
+        data[key->length] = '\0';
+        keyWrapper->data = data;
+        keyWrapper->owned = MUF_TRUE;
+    }
+    node->hashCode = mufHashTableHashKey(_TABLE(dict), keyWrapper);
     muf_rawptr valueDst = mufHashTableExtractNodeValue(_TABLE(dict), node);
     mufMemCopyBytes(valueDst, value, _TABLE(dict)->valueSize);
-    return node;
+    mufHashTableInsert(_TABLE(dict), node);
+    return valueDst;
 }
 
 muf_rawptr mufDictInsert(MufDict *dict, const muf_char *key, muf_crawptr value) {
-    if (mufDictContains(dict, key)) {
+    _MufStrWrapper query;
+    _mufStrWrapperFromCStr(&query, key);
+    if (_mufDictFind(dict, &query)) {
         return NULL;
     }
+    return _mufDictInsertNew(dict, &query, MUF_TRUE, value);
+}
 
-    MufHashTableNode *node = _mufDictCreateNode(dict, key, value);
-    mufHashTableInsert(_TABLE(dict), node);
-    return mufHashTableExtractNodeValue(_TABLE(dict), node);
+muf_rawptr mufDictInsertId(MufDict *dict, MufStrId key, muf_crawptr value) {
+    _MufStrWrapper query;
+    _mufStrWrapperFromId(&query, key);
+    if (_mufDictFind(dict, &query)) {
+        return NULL;
+    }
+    return _mufDictInsertNew(dict, &query, MUF_FALSE, value);
+}
+
+muf_rawptr mufDictInsertStr(MufDict *dict, MufStr *key, muf_crawptr value) {
+    _MufStrWrapper query;
+    _mufStrWrapperFromStr(&query, key);
+    if (_mufDictFind(dict, &query)) {
+        return NULL;
+    }
+    return _mufDictInsertNew(dict, &query, MUF_TRUE, value);
 }
 
 void mufDictInsertOrAssign(MufDict *dict, const muf_char *key, muf_crawptr value) {
-    muf_rawptr ref = mufDictGetRef(dict, key);
+    _MufStrWrapper query;
+    _mufStrWrapperFromCStr(&query, key);
+    muf_rawptr ref = _mufDictFind(dict, &query);
     if (ref) {
         mufMemCopyBytes(ref, value, _TABLE(dict)->valueSize);
     } else {
-        MufHashTableNode *node = _mufDictCreateNode(dict, key, value);
-        mufHashTableInsert(_TABLE(dict), node);
+        _mufDictInsertNew(dict, &query, MUF_TRUE, value);
     }
 }
 
@@ -117,19 +200,13 @@ void mufDictPut(MufDict *dict, const muf_char *key, muf_crawptr value) {
     mufDictInsertOrAssign(dict, key, value);
 }
 
-muf_bool mufDictRemove(MufDict *dict, const muf_char *key) {
+static muf_bool _mufDictRemove(MufDict *dict, const _MufStrWrapper *query) {
     MufHashTable *table = _TABLE(dict);
-    _MufStrWrapper query;
-    query.data = (muf_char *) key;
-    query.length = mufCStrLength(key);
-
     MufHashTableNode *prev = NULL;
-    MufHashTableNode *node = mufHashTableFind(table, &query, &prev);
+    MufHashTableNode *node = mufHashTableFind(table, query, &prev);
     if (!node) {
         return MUF_FALSE;
     }
-    _MufStrWrapper *keyWrapper = mufHashTableExtractNodeKey(table, node);
-    mufFree(keyWrapper->data);
 
     if (prev) {
         prev->next = node->next;
@@ -138,21 +215,40 @@ muf_bool mufDictRemove(MufDict *dict, const muf_char *key) {
         table->buckets[bucketIndex] = node->next;
     }
     --table->size;
+    _mufStrWrapperFree((_MufStrWrapper *) mufHashTableExtractNodeKey(table, node));
     mufFree(node);
     return MUF_TRUE;
 }
 
+muf_bool mufDictRemove(MufDict *dict, const muf_char *key) {
+    _MufStrWrapper query;
+    _mufStrWrapperFromCStr(&query, key);
+    return _mufDictRemove(dict, &query);
+}
+
+muf_bool mufDictRemoveId(MufDict *dict, MufStrId key) {
+    _MufStrWrapper query;
+    _mufStrWrapperFromId(&query, key);
+    return _mufDictRemove(dict, &query);
+}
+
+muf_bool mufDictRemoveStr(MufDict *dict, MufStr *key) {
+    _MufStrWrapper query;
+    _mufStrWrapperFromStr(&query, key);
+    return _mufDictRemove(dict, &query);
+}
+
 void mufDictClear(MufDict *dict) {
     MufHashTable *table = _TABLE(dict);
     for (muf_index i = 0; i < table->bucketCount; ++i) {
         MufHashTableNode *node = table->buckets[i];
         while (node) {
-            _MufStrWrapper *wrapper = (_MufStrWrapper *) _mufDictKeyExtract(node);
-            mufFree(wrapper->data);
             MufHashTableNode *next = node->next;
+            _mufStrWrapperFree((_MufStrWrapper *) mufHashTableExtractNodeKey(table, node));
             mufFree(node);
             node = next;
         }
+        table->buckets[i] = NULL;
     }
     table->size = 0;
 }
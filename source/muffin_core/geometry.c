@@ -0,0 +1,322 @@
+#include "muffin_core/geometry.h"
+#include "muffin_core/cpu.h"
+#include "muffin_core/simd.h"
+#include "muffin_core/sync.h"
+
+#include <float.h>
+#include <math.h>
+
+/*
+ * The batch tests put the six planes side by side in the lanes (two SSE registers or one AVX register, the extra
+ * lanes hold a plane every volume is far inside of) and test one volume per iteration against all of them.
+ */
+
+typedef struct _MufFrustumLanes_s {
+    MUF_ALIGNAS(32) muf_f32 x[8];
+    MUF_ALIGNAS(32) muf_f32 y[8];
+    MUF_ALIGNAS(32) muf_f32 z[8];
+    MUF_ALIGNAS(32) muf_f32 d[8];
+    MUF_ALIGNAS(32) muf_f32 absX[8];
+    MUF_ALIGNAS(32) muf_f32 absY[8];
+    MUF_ALIGNAS(32) muf_f32 absZ[8];
+} _MufFrustumLanes;
+
+typedef struct _MufGeometryKernels_s {
+    MufCpuFeatureFlags required;
+    muf_usize (*cullAABB3)(const _MufFrustumLanes *lanes, const MufAABB3 *bounds, muf_usize count, muf_u8 *resultsOut);
+    muf_usize (*cullSphere)(const _MufFrustumLanes *lanes, const MufSphere *spheres, muf_usize count,
+        muf_u8 *resultsOut);
+} _MufGeometryKernels;
+
+void mufExtractFrustum(const MufMat4 *viewProjection, MufFrustum *frustumOut) {
+    const muf_f32 (*m)[4] = viewProjection->values;
+    /* Row i of the column major matrix */
+#define _MUF_ROW(_i) mufCreateVec4(m[0][_i], m[1][_i], m[2][_i], m[3][_i])
+    MufVec4 r0 = _MUF_ROW(0), r1 = _MUF_ROW(1), r2 = _MUF_ROW(2), r3 = _MUF_ROW(3);
+#undef _MUF_ROW
+
+    MufVec4 *planes = frustumOut->planes;
+    planes[MUF_FRUSTUM_PLANE_LEFT] = mufPlaneNormalize(mufVec4Add(r3, r0));
+    planes[MUF_FRUSTUM_PLANE_RIGHT] = mufPlaneNormalize(mufVec4Sub(r3, r0));
+    planes[MUF_FRUSTUM_PLANE_BOTTOM] = mufPlaneNormalize(mufVec4Add(r3, r1));
+    planes[MUF_FRUSTUM_PLANE_TOP] = mufPlaneNormalize(mufVec4Sub(r3, r1));
+    planes[MUF_FRUSTUM_PLANE_NEAR] = mufPlaneNormalize(mufVec4Add(r3, r2));
+    planes[MUF_FRUSTUM_PLANE_FAR] = mufPlaneNormalize(mufVec4Sub(r3, r2));
+}
+
+MufVec4 mufPlaneNormalize(MufVec4 plane) {
+    muf_f32 length = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+    MUF_FASSERT(length > 0.0F, "The plane has no normal");
+    return mufVec4Scale(plane, 1.0F / length);
+}
+
+muf_f32 mufPlaneDistance(MufVec4 plane, MufVec3 point) {
+    return plane.x * point.x + plane.y * point.y + plane.z * point.z + plane.w;
+}
+
+MufAABB3 mufAABB3Union(MufAABB3 a, MufAABB3 b) {
+    MufAABB3 result;
+    result.min = mufCreateVec3(mufMin(a.min.x, b.min.x), mufMin(a.min.y, b.min.y), mufMin(a.min.z, b.min.z));
+    result.max = mufCreateVec3(mufMax(a.max.x, b.max.x), mufMax(a.max.y, b.max.y), mufMax(a.max.z, b.max.z));
+    return result;
+}
+
+muf_bool mufAABB3Overlaps(MufAABB3 a, MufAABB3 b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+        a.min.y <= b.max.y && a.max.y >= b.min.y &&
+        a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+muf_bool mufAABB3Contains(MufAABB3 box, MufVec3 point) {
+    return point.x >= box.min.x && point.x <= box.max.x &&
+        point.y >= box.min.y && point.y <= box.max.y &&
+        point.z >= box.min.z && point.z <= box.max.z;
+}
+
+muf_f32 mufAABB3SurfaceArea(MufAABB3 box) {
+    muf_f32 dx = box.max.x - box.min.x, dy = box.max.y - box.min.y, dz = box.max.z - box.min.z;
+    return 2.0F * (dx * dy + dy * dz + dz * dx);
+}
+
+MufCullResult mufFrustumTestAABB3(const MufFrustum *frustum, MufAABB3 box) {
+    muf_f32 cx = (box.min.x + box.max.x) * 0.5F, ex = (box.max.x - box.min.x) * 0.5F;
+    muf_f32 cy = (box.min.y + box.max.y) * 0.5F, ey = (box.max.y - box.min.y) * 0.5F;
+    muf_f32 cz = (box.min.z + box.max.z) * 0.5F, ez = (box.max.z - box.min.z) * 0.5F;
+
+    MufCullResult result = MUF_CULL_RESULT_INSIDE;
+    for (muf_u32 i = 0; i < _MUF_FRUSTUM_PLANE_COUNT_; ++i) {
+        MufVec4 p = frustum->planes[i];
+        muf_f32 distance = p.x * cx + p.y * cy + p.z * cz + p.w;
+        muf_f32 radius = fabsf(p.x) * ex + fabsf(p.y) * ey + fabsf(p.z) * ez;
+        if (distance + radius < 0.0F)
+            return MUF_CULL_RESULT_OUTSIDE;
+        if (distance - radius < 0.0F)
+            result = MUF_CULL_RESULT_INTERSECT;
+    }
+    return result;
+}
+
+MufCullResult mufFrustumTestSphere(const MufFrustum *frustum, MufSphere sphere) {
+    MufCullResult result = MUF_CULL_RESULT_INSIDE;
+    for (muf_u32 i = 0; i < _MUF_FRUSTUM_PLANE_COUNT_; ++i) {
+        muf_f32 distance = mufPlaneDistance(frustum->planes[i], sphere.center);
+        if (distance < -sphere.radius)
+            return MUF_CULL_RESULT_OUTSIDE;
+        if (distance < sphere.radius)
+            result = MUF_CULL_RESULT_INTERSECT;
+    }
+    return result;
+}
+
+MUF_INTERNAL void _mufFrustumToLanes(const MufFrustum *frustum, _MufFrustumLanes *lanes) {
+    for (muf_u32 i = 0; i < 8; ++i) {
+        MufVec4 p = i < _MUF_FRUSTUM_PLANE_COUNT_ ? frustum->planes[i] : mufCreateVec4(0.0F, 0.0F, 0.0F, FLT_MAX);
+        lanes->x[i] = p.x;
+        lanes->y[i] = p.y;
+        lanes->z[i] = p.z;
+        lanes->d[i] = p.w;
+        lanes->absX[i] = fabsf(p.x);
+        lanes->absY[i] = fabsf(p.y);
+        lanes->absZ[i] = fabsf(p.z);
+    }
+}
+
+/* Baseline, SSE when the build has it */
+
+MUF_INTERNAL muf_usize _mufFrustumCullAABB3Baseline(const _MufFrustumLanes *lanes, const MufAABB3 *bounds,
+    muf_usize count, muf_u8 *resultsOut) {
+    muf_usize visible = 0;
+    for (muf_usize i = 0; i < count; ++i) {
+        const MufAABB3 *box = &bounds[i];
+        muf_f32 cx = (box->min.x + box->max.x) * 0.5F, ex = (box->max.x - box->min.x) * 0.5F;
+        muf_f32 cy = (box->min.y + box->max.y) * 0.5F, ey = (box->max.y - box->min.y) * 0.5F;
+        muf_f32 cz = (box->min.z + box->max.z) * 0.5F, ez = (box->max.z - box->min.z) * 0.5F;
+        int outside = 0, intersect = 0;
+#if defined(MUF_SIMD_SSE2)
+        for (muf_u32 h = 0; h < 8; h += 4) {
+            __m128 distance = _mm_mul_ps(_mm_load_ps(lanes->x + h), _mm_set1_ps(cx));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_load_ps(lanes->y + h), _mm_set1_ps(cy)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_load_ps(lanes->z + h), _mm_set1_ps(cz)));
+            distance = _mm_add_ps(distance, _mm_load_ps(lanes->d + h));
+            __m128 radius = _mm_mul_ps(_mm_load_ps(lanes->absX + h), _mm_set1_ps(ex));
+            radius = _mm_add_ps(radius, _mm_mul_ps(_mm_load_ps(lanes->absY + h), _mm_set1_ps(ey)));
+            radius = _mm_add_ps(radius, _mm_mul_ps(_mm_load_ps(lanes->absZ + h), _mm_set1_ps(ez)));
+            outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+            intersect |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(distance, radius), _mm_setzero_ps()));
+        }
+#else
+        for (muf_u32 k = 0; k < _MUF_FRUSTUM_PLANE_COUNT_; ++k) {
+            muf_f32 distance = lanes->x[k] * cx + lanes->y[k] * cy + lanes->z[k] * cz + lanes->d[k];
+            muf_f32 radius = lanes->absX[k] * ex + lanes->absY[k] * ey + lanes->absZ[k] * ez;
+            outside |= distance + radius < 0.0F;
+            intersect |= distance - radius < 0.0F;
+        }
+#endif
+        muf_u8 result = outside ? MUF_CULL_RESULT_OUTSIDE : intersect ? MUF_CULL_RESULT_INTERSECT : MUF_CULL_RESULT_INSIDE;
+        resultsOut[i] = result;
+        visible += result != MUF_CULL_RESULT_OUTSIDE;
+    }
+    return visible;
+}
+
+MUF_INTERNAL muf_usize _mufFrustumCullSphereBaseline(const _MufFrustumLanes *lanes, const MufSphere *spheres,
+    muf_usize count, muf_u8 *resultsOut) {
+    muf_usize visible = 0;
+    for (muf_usize i = 0; i < count; ++i) {
+        const MufSphere *sphere = &spheres[i];
+        int outside = 0, intersect = 0;
+#if defined(MUF_SIMD_SSE2)
+        __m128 r = _mm_set1_ps(sphere->radius);
+        __m128 negR = _mm_set1_ps(-sphere->radius);
+        for (muf_u32 h = 0; h < 8; h += 4) {
+            __m128 distance = _mm_mul_ps(_mm_load_ps(lanes->x + h), _mm_set1_ps(sphere->center.x));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_load_ps(lanes->y + h), _mm_set1_ps(sphere->center.y)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_load_ps(lanes->z + h), _mm_set1_ps(sphere->center.z)));
+            distance = _mm_add_ps(distance, _mm_load_ps(lanes->d + h));
+            outside |= _mm_movemask_ps(_mm_cmplt_ps(distance, negR));
+            intersect |= _mm_movemask_ps(_mm_cmplt_ps(distance, r));
+        }
+#else
+        for (muf_u32 k = 0; k < _MUF_FRUSTUM_PLANE_COUNT_; ++k) {
+            muf_f32 distance = lanes->x[k] * sphere->center.x + lanes->y[k] * sphere->center.y +
+                lanes->z[k] * sphere->center.z + lanes->d[k];
+            outside |= distance < -sphere->radius;
+            intersect |= distance < sphere->radius;
+        }
+#endif
+        muf_u8 result = outside ? MUF_CULL_RESULT_OUTSIDE : intersect ? MUF_CULL_RESULT_INTERSECT : MUF_CULL_RESULT_INSIDE;
+        resultsOut[i] = result;
+        visible += result != MUF_CULL_RESULT_OUTSIDE;
+    }
+    return visible;
+}
+
+static const _MufGeometryKernels _mufGeometryBaseline = {
+    MUF_CPU_FEATURE_NONE,
+    _mufFrustumCullAABB3Baseline,
+    _mufFrustumCullSphereBaseline
+};
+
+#if defined(MUF_SIMD_MULTI_TARGET)
+
+/* AVX, the six planes in one register */
+
+MUF_SIMD_TARGET("avx")
+MUF_INTERNAL muf_usize _mufFrustumCullAABB3AVX(const _MufFrustumLanes *lanes, const MufAABB3 *bounds,
+    muf_usize count, muf_u8 *resultsOut) {
+    const __m256 px = _mm256_load_ps(lanes->x), py = _mm256_load_ps(lanes->y), pz = _mm256_load_ps(lanes->z);
+    const __m256 pd = _mm256_load_ps(lanes->d);
+    const __m256 ax = _mm256_load_ps(lanes->absX), ay = _mm256_load_ps(lanes->absY), az = _mm256_load_ps(lanes->absZ);
+    const __m256 zero = _mm256_setzero_ps();
+    muf_usize visible = 0;
+    for (muf_usize i = 0; i < count; ++i) {
+        const MufAABB3 *box = &bounds[i];
+        muf_f32 cx = (box->min.x + box->max.x) * 0.5F, ex = (box->max.x - box->min.x) * 0.5F;
+        muf_f32 cy = (box->min.y + box->max.y) * 0.5F, ey = (box->max.y - box->min.y) * 0.5F;
+        muf_f32 cz = (box->min.z + box->max.z) * 0.5F, ez = (box->max.z - box->min.z) * 0.5F;
+
+        __m256 distance = _mm256_mul_ps(px, _mm256_set1_ps(cx));
+        distance = _mm256_add_ps(distance, _mm256_mul_ps(py, _mm256_set1_ps(cy)));
+        distance = _mm256_add_ps(distance, _mm256_mul_ps(pz, _mm256_set1_ps(cz)));
+        distance = _mm256_add_ps(distance, pd);
+        __m256 radius = _mm256_mul_ps(ax, _mm256_set1_ps(ex));
+        radius = _mm256_add_ps(radius, _mm256_mul_ps(ay, _mm256_set1_ps(ey)));
+        radius = _mm256_add_ps(radius, _mm256_mul_ps(az, _mm256_set1_ps(ez)));
+        int outside = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+        int intersect = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_sub_ps(distance, radius), zero, _CMP_LT_OQ));
+
+        muf_u8 result = outside ? MUF_CULL_RESULT_OUTSIDE : intersect ? MUF_CULL_RESULT_INTERSECT : MUF_CULL_RESULT_INSIDE;
+        resultsOut[i] = result;
+        visible += result != MUF_CULL_RESULT_OUTSIDE;
+    }
+    return visible;
+}
+
+MUF_SIMD_TARGET("avx")
+MUF_INTERNAL muf_usize _mufFrustumCullSphereAVX(const _MufFrustumLanes *lanes, const MufSphere *spheres,
+    muf_usize count, muf_u8 *resultsOut) {
+    const __m256 px = _mm256_load_ps(lanes->x), py = _mm256_load_ps(lanes->y), pz = _mm256_load_ps(lanes->z);
+    const __m256 pd = _mm256_load_ps(lanes->d);
+    muf_usize visible = 0;
+    for (muf_usize i = 0; i < count; ++i) {
+        const MufSphere *sphere = &spheres[i];
+        __m256 distance = _mm256_mul_ps(px, _mm256_set1_ps(sphere->center.x));
+        distance = _mm256_add_ps(distance, _mm256_mul_ps(py, _mm256_set1_ps(sphere->center.y)));
+        distance = _mm256_add_ps(distance, _mm256_mul_ps(pz, _mm256_set1_ps(sphere->center.z)));
+        distance = _mm256_add_ps(distance, pd);
+        int outside = _mm256_movemask_ps(_mm256_cmp_ps(distance, _mm256_set1_ps(-sphere->radius), _CMP_LT_OQ));
+        int intersect = _mm256_movemask_ps(_mm256_cmp_ps(distance, _mm256_set1_ps(sphere->radius), _CMP_LT_OQ));
+
+        muf_u8 result = outside ? MUF_CULL_RESULT_OUTSIDE : intersect ? MUF_CULL_RESULT_INTERSECT : MUF_CULL_RESULT_INSIDE;
+        resultsOut[i] = result;
+        visible += result != MUF_CULL_RESULT_OUTSIDE;
+    }
+    return visible;
+}
+
+static const _MufGeometryKernels _mufGeometryAVX = {
+    MUF_CPU_FEATURE_AVX,
+    _mufFrustumCullAABB3AVX,
+    _mufFrustumCullSphereAVX
+};
+
+#endif
+
+static const _MufGeometryKernels *const _mufGeometryVariants[] = {
+#if defined(MUF_SIMD_MULTI_TARGET)
+    &_mufGeometryAVX,
+#endif
+    &_mufGeometryBaseline
+};
+
+static const _MufGeometryKernels *_mufGeometryKernels = NULL;
+
+MUF_INTERNAL const _MufGeometryKernels *_mufGetGeometryKernels(void) {
+    const _MufGeometryKernels *kernels = mufAtomicLoad(&_mufGeometryKernels);
+    if (kernels != NULL)
+        return kernels;
+
+    for (muf_usize i = 0; i < MUF_COUNTOF(_mufGeometryVariants); ++i) {
+        kernels = _mufGeometryVariants[i];
+        if (mufHasCpuFeatures(kernels->required))
+            break;
+    }
+    mufAtomicStore(&_mufGeometryKernels, kernels);
+    return kernels;
+}
+
+muf_usize mufFrustumCullAABB3Batch(const MufFrustum *frustum, const MufAABB3 *bounds, muf_usize count,
+    muf_u8 *resultsOut) {
+    _MufFrustumLanes lanes;
+    _mufFrustumToLanes(frustum, &lanes);
+    return _mufGetGeometryKernels()->cullAABB3(&lanes, bounds, count, resultsOut);
+}
+
+muf_usize mufFrustumCullSphereBatch(const MufFrustum *frustum, const MufSphere *spheres, muf_usize count,
+    muf_u8 *resultsOut) {
+    _MufFrustumLanes lanes;
+    _mufFrustumToLanes(frustum, &lanes);
+    return _mufGetGeometryKernels()->cullSphere(&lanes, spheres, count, resultsOut);
+}
+
+muf_bool mufRayIntersectAABB3(const MufRay *ray, MufAABB3 box, muf_f32 tMax, muf_f32 *tOut) {
+    const muf_f32 *origin = &ray->origin.x;
+    const muf_f32 *direction = &ray->direction.x;
+    const muf_f32 *min = &box.min.x;
+    const muf_f32 *max = &box.max.x;
+
+    muf_f32 tNear = 0.0F, tFar = tMax;
+    for (muf_u32 k = 0; k < 3; ++k) {
+        /* A zero component gives infinite slabs, the comparisons below keep working */
+        muf_f32 inverse = 1.0F / direction[k];
+        muf_f32 t0 = (min[k] - origin[k]) * inverse;
+        muf_f32 t1 = (max[k] - origin[k]) * inverse;
+        tNear = fmaxf(tNear, fminf(t0, t1));
+        tFar = fminf(tFar, fmaxf(t0, t1));
+    }
+    if (tNear > tFar)
+        return MUF_FALSE;
+    if (tOut != NULL)
+        *tOut = tNear;
+    return MUF_TRUE;
+}
@@ -1,149 +1,467 @@
 #include "muffin_core/hash.h"
+#include "muffin_core/cpu.h"
+#include "muffin_core/random.h"
+#include "muffin_core/simd.h"
+#include "muffin_core/sync.h"
 
 #include <string.h>
 
-MUF_INTERNAL muf_u32 _mufBytesHash32(muf_crawptr data, muf_usize length) {
-    const muf_u32 m = 0x5BD1E995;
-    const muf_u32 r = 24;
-    const muf_u32 seed = 0xBF114514;
-
-    muf_u32 h = seed ^ length;
-    const muf_byte *bytes = (const muf_byte *) data;
-
-    while (length >= 4) {
-        muf_u32 k = bytes[0] |
-            (bytes[1] << 8) |
-            (bytes[2] << 16) |
-            (bytes[3] << 24);
-        k *= m;
-        k ^= k >> r;
-        k *= m;
-        k *= m;
-        h ^= k;
-
-        bytes += 4;
-        length -= 4;
+#if defined(_MSC_VER) && defined(_M_X64)
+#   include <intrin.h>
+#endif
+
+#define MUF_HASH_STRIPE_SIZE        64
+#define MUF_HASH_STRIPES_PER_BLOCK  8
+/* The stripe keys start at word 0 to 7 of the secret, the scramble and last stripe key at word 8 */
+#define MUF_HASH_TAIL_KEY           8
+
+#define MUF_HASH_PRIME32_1  0x9E3779B1U
+#define MUF_HASH_PRIME32_2  0x85EBCA77U
+#define MUF_HASH_PRIME32_3  0xC2B2AE3DU
+#define MUF_HASH_PRIME64_1  0x9E3779B185EBCA87ULL
+#define MUF_HASH_PRIME64_2  0xC2B2AE3D27D4EB4FULL
+#define MUF_HASH_PRIME64_3  0x165667B19E3779F9ULL
+#define MUF_HASH_PRIME64_4  0x85EBCA77C2B2AE63ULL
+#define MUF_HASH_PRIME64_5  0x27D4EB2F165667C5ULL
+
+/* The constants of the short path */
+static const muf_u64 _mufHashShortSecret[4] = {
+    0xA0761D6478BD642FULL, 0xE7037ED1A0B428DBULL, 0x8EBC6AF09C88C6E3ULL, 0x589965CC75374CC3ULL
+};
+
+/* The secret of the long path for seed 0, other seeds shift it */
+static const muf_u64 _mufHashDefaultSecret[16] = {
+    0x2CB0F69F4ABEA221ULL, 0x9417034723148989ULL, 0xDD555950609DFE03ULL, 0xDBAFB150DEB12800ULL,
+    0x7E789B2E6C442CB6ULL, 0xF41E5636C7E4F8C4ULL, 0x0959D150F8FBA7E4ULL, 0xA97316F13CDB9EEAULL,
+    0x74CD8258F9520068ULL, 0x55C74A62E116868BULL, 0xD2F4C799A2023CBDULL, 0xDF98CB79A37B51B9ULL,
+    0x396F5885524F3905ULL, 0xAF1D56386CA3B276ULL, 0xA9FFBE6B5104E85AULL, 0x6BD0C51B9FD533B3ULL
+};
+
+typedef struct _MufHashKernels_s {
+    MufCpuFeatureFlags required;
+    /* Accumulate whole stripes, the accumulators are scrambled after the last stripe of each block */
+    void (*accumulate)(muf_u64 acc[8], const muf_byte *data, muf_usize stripes, const muf_u64 *secret,
+        muf_u32 *blockStripe);
+} _MufHashKernels;
+
+/* Loads of any alignment, the bytes are read as little endian on every target */
+
+MUF_INTERNAL MUF_INLINE muf_u64 _mufHashRead64(const muf_byte *p) {
+    muf_u64 value;
+    memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+MUF_INTERNAL MUF_INLINE muf_u64 _mufHashRead32(const muf_byte *p) {
+    muf_u32 value;
+    memcpy(&value, p, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+    return value;
+}
+
+/* The full 128-bit product of a and b, the low word in a and the high word in b */
+MUF_INTERNAL MUF_INLINE void _mufHashMultiply(muf_u64 *a, muf_u64 *b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t product = (__uint128_t) *a * *b;
+    *a = (muf_u64) product;
+    *b = (muf_u64) (product >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    *a = _umul128(*a, *b, b);
+#else
+    muf_u64 aLow = *a & 0xFFFFFFFFU, aHigh = *a >> 32, bLow = *b & 0xFFFFFFFFU, bHigh = *b >> 32;
+    muf_u64 ll = aLow * bLow, lh = aLow * bHigh, hl = aHigh * bLow, hh = aHigh * bHigh;
+    muf_u64 middle = (ll >> 32) + (lh & 0xFFFFFFFFU) + (hl & 0xFFFFFFFFU);
+    *a = (middle << 32) | (ll & 0xFFFFFFFFU);
+    *b = hh + (lh >> 32) + (hl >> 32) + (middle >> 32);
+#endif
+}
+
+MUF_INTERNAL MUF_INLINE muf_u64 _mufHashMultiplyFold(muf_u64 a, muf_u64 b) {
+    _mufHashMultiply(&a, &b);
+    return a ^ b;
+}
+
+MUF_INTERNAL muf_u64 _mufHashShort(const muf_byte *p, muf_usize length, muf_u64 seed) {
+    const muf_u64 *s = _mufHashShortSecret;
+    seed ^= _mufHashMultiplyFold(seed ^ s[0], s[1]);
+
+    muf_u64 a, b;
+    if (length <= 16) {
+        if (length >= 4) {
+            /* Two overlapping pairs of words cover 4 to 16 bytes */
+            muf_usize shift = (length >> 3) << 2;
+            a = (_mufHashRead32(p) << 32) | _mufHashRead32(p + shift);
+            b = (_mufHashRead32(p + length - 4) << 32) | _mufHashRead32(p + length - 4 - shift);
+        } else if (length > 0) {
+            a = ((muf_u64) p[0] << 16) | ((muf_u64) p[length >> 1] << 8) | p[length - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        muf_usize i = length;
+        if (i > 48) {
+            muf_u64 see1 = seed, see2 = seed;
+            do {
+                seed = _mufHashMultiplyFold(_mufHashRead64(p) ^ s[1], _mufHashRead64(p + 8) ^ seed);
+                see1 = _mufHashMultiplyFold(_mufHashRead64(p + 16) ^ s[2], _mufHashRead64(p + 24) ^ see1);
+                see2 = _mufHashMultiplyFold(_mufHashRead64(p + 32) ^ s[3], _mufHashRead64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = _mufHashMultiplyFold(_mufHashRead64(p) ^ s[1], _mufHashRead64(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        a = _mufHashRead64(p + i - 16);
+        b = _mufHashRead64(p + i - 8);
+    }
+
+    a ^= s[1];
+    b ^= seed;
+    _mufHashMultiply(&a, &b);
+    return _mufHashMultiplyFold(a ^ s[0] ^ length, b ^ s[1]);
+}
+
+/* Scalar stripes, the reference of the SIMD kernels */
+
+MUF_INTERNAL void _mufHashStripeScalar(muf_u64 acc[8], const muf_byte *p, const muf_u64 *key) {
+    for (muf_u32 i = 0; i < 8; ++i) {
+        muf_u64 value = _mufHashRead64(p + i * 8);
+        muf_u64 keyed = value ^ key[i];
+        acc[i ^ 1] += value;
+        acc[i] += (keyed & 0xFFFFFFFFU) * (keyed >> 32);
     }
+}
+
+#if !defined(MUF_SIMD_SSE2)
 
-    switch (length) {
-    case 3: 
-        h ^= (bytes[2] & 0xFF) << 16;
-    case 2:
-        h ^= (bytes[1] & 0xFF) << 8;
-    case 1:
-        h ^= (bytes[0] & 0xFF);
-        h *= m;
+MUF_INTERNAL void _mufHashScrambleScalar(muf_u64 acc[8], const muf_u64 *key) {
+    for (muf_u32 i = 0; i < 8; ++i) {
+        muf_u64 a = acc[i];
+        a ^= a >> 47;
+        a ^= key[i];
+        acc[i] = a * MUF_HASH_PRIME32_1;
     }
+}
 
-    h ^= h >> 13;
-    h *= m;
-    h ^= h >> 15;
-    return h;
-}
-
-MUF_INTERNAL muf_u64 _mufBytesHash64(muf_crawptr data, muf_usize length) {
-    const muf_u64 m = 0xC6A4A7935BD1E995ULL;
-    const muf_u32 r = 47;
-    const muf_u64 seed = 0xBF114514ULL;
-
-    muf_u64 h = seed ^ (length * m);
-    const muf_u64 *first = (const muf_u64 *) data;
-    const muf_u64 *last = first + (length / 8);
-    
-    while (first != last) {
-        muf_u64 k = *first++;
-        
-        k *= m;
-        k ^= k >> r;
-        k *= m;
-        h ^= k;
-        h *= m;
+MUF_INTERNAL void _mufHashAccumulateBaseline(muf_u64 acc[8], const muf_byte *data, muf_usize stripes,
+    const muf_u64 *secret, muf_u32 *blockStripe) {
+    for (muf_usize i = 0; i < stripes; ++i, data += MUF_HASH_STRIPE_SIZE) {
+        _mufHashStripeScalar(acc, data, secret + *blockStripe);
+        if (++*blockStripe == MUF_HASH_STRIPES_PER_BLOCK) {
+            _mufHashScrambleScalar(acc, secret + MUF_HASH_TAIL_KEY);
+            *blockStripe = 0;
+        }
     }
+}
+
+#else
+
+/* SSE2, two accumulators per register */
+
+MUF_INTERNAL void _mufHashAccumulateBaseline(muf_u64 acc[8], const muf_byte *data, muf_usize stripes,
+    const muf_u64 *secret, muf_u32 *blockStripe) {
+    __m128i a[4];
+    for (muf_u32 j = 0; j < 4; ++j)
+        a[j] = _mm_loadu_si128((const __m128i *) (acc + j * 2));
+    __m128i prime = _mm_set1_epi32((int) MUF_HASH_PRIME32_1);
+
+    for (muf_usize i = 0; i < stripes; ++i, data += MUF_HASH_STRIPE_SIZE) {
+        const muf_u64 *key = secret + *blockStripe;
+        for (muf_u32 j = 0; j < 4; ++j) {
+            __m128i value = _mm_loadu_si128((const __m128i *) (data + j * 16));
+            __m128i keyed = _mm_xor_si128(value, _mm_loadu_si128((const __m128i *) (key + j * 2)));
+            __m128i product = _mm_mul_epu32(keyed, _mm_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+            __m128i swapped = _mm_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+            a[j] = _mm_add_epi64(_mm_add_epi64(a[j], swapped), product);
+        }
+        if (++*blockStripe == MUF_HASH_STRIPES_PER_BLOCK) {
+            for (muf_u32 j = 0; j < 4; ++j) {
+                __m128i x = _mm_xor_si128(a[j], _mm_srli_epi64(a[j], 47));
+                x = _mm_xor_si128(x, _mm_loadu_si128((const __m128i *) (secret + MUF_HASH_TAIL_KEY + j * 2)));
+                __m128i low = _mm_mul_epu32(x, prime);
+                __m128i high = _mm_mul_epu32(_mm_srli_epi64(x, 32), prime);
+                a[j] = _mm_add_epi64(low, _mm_slli_epi64(high, 32));
+            }
+            *blockStripe = 0;
+        }
+    }
+
+    for (muf_u32 j = 0; j < 4; ++j)
+        _mm_storeu_si128((__m128i *) (acc + j * 2), a[j]);
+}
+
+#endif
 
-    const muf_byte *bytes = (const muf_byte *) first;
-
-    switch (length & 7) {
-    case 7:
-        h ^= ((muf_u64) bytes[6]) << 48;
-    case 6:
-        h ^= ((muf_u64) bytes[5]) << 40;
-    case 5:
-        h ^= ((muf_u64) bytes[4]) << 32;
-    case 4:
-        h ^= ((muf_u64) bytes[3]) << 24;
-    case 3:
-        h ^= ((muf_u64) bytes[2]) << 16;
-    case 2:
-        h ^= ((muf_u64) bytes[1]) << 8;
-    case 1:
-        h ^= ((muf_u64) bytes[0]);
-        h *= m;
+static const _MufHashKernels _mufHashBaseline = {
+    MUF_CPU_FEATURE_NONE,
+    _mufHashAccumulateBaseline
+};
+
+#if defined(MUF_SIMD_MULTI_TARGET)
+
+/* AVX2, four accumulators per register */
+
+MUF_SIMD_TARGET("avx2")
+MUF_INTERNAL void _mufHashAccumulateAVX2(muf_u64 acc[8], const muf_byte *data, muf_usize stripes,
+    const muf_u64 *secret, muf_u32 *blockStripe) {
+    __m256i a[2];
+    for (muf_u32 j = 0; j < 2; ++j)
+        a[j] = _mm256_loadu_si256((const __m256i *) (acc + j * 4));
+    __m256i prime = _mm256_set1_epi32((int) MUF_HASH_PRIME32_1);
+
+    for (muf_usize i = 0; i < stripes; ++i, data += MUF_HASH_STRIPE_SIZE) {
+        const muf_u64 *key = secret + *blockStripe;
+        for (muf_u32 j = 0; j < 2; ++j) {
+            __m256i value = _mm256_loadu_si256((const __m256i *) (data + j * 32));
+            __m256i keyed = _mm256_xor_si256(value, _mm256_loadu_si256((const __m256i *) (key + j * 4)));
+            __m256i product = _mm256_mul_epu32(keyed, _mm256_shuffle_epi32(keyed, _MM_SHUFFLE(0, 3, 0, 1)));
+            __m256i swapped = _mm256_shuffle_epi32(value, _MM_SHUFFLE(1, 0, 3, 2));
+            a[j] = _mm256_add_epi64(_mm256_add_epi64(a[j], swapped), product);
+        }
+        if (++*blockStripe == MUF_HASH_STRIPES_PER_BLOCK) {
+            for (muf_u32 j = 0; j < 2; ++j) {
+                __m256i x = _mm256_xor_si256(a[j], _mm256_srli_epi64(a[j], 47));
+                x = _mm256_xor_si256(x, _mm256_loadu_si256((const __m256i *) (secret + MUF_HASH_TAIL_KEY + j * 4)));
+                __m256i low = _mm256_mul_epu32(x, prime);
+                __m256i high = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), prime);
+                a[j] = _mm256_add_epi64(low, _mm256_slli_epi64(high, 32));
+            }
+            *blockStripe = 0;
+        }
     }
-    
-    h ^= h >> r;
-    h *= m;
-    h ^= h >> r;
 
-    return h;
+    for (muf_u32 j = 0; j < 2; ++j)
+        _mm256_storeu_si256((__m256i *) (acc + j * 4), a[j]);
 }
 
-#if MUF_SIZEOF_USIZE == 4
-#   define _mufBytesHash(data, length) _mufBytesHash32(data, length)
-#elif MUF_SIZEOF_USIZE == 8
-#   define _mufBytesHash(data, length) _mufBytesHash64(data, length)
+static const _MufHashKernels _mufHashAVX2 = {
+    MUF_CPU_FEATURE_AVX2,
+    _mufHashAccumulateAVX2
+};
+
 #endif
 
+static const _MufHashKernels *const _mufHashVariants[] = {
+#if defined(MUF_SIMD_MULTI_TARGET)
+    &_mufHashAVX2,
+#endif
+    &_mufHashBaseline
+};
+
+static const _MufHashKernels *_mufHashKernels = NULL;
+
+static const _MufHashKernels *_mufGetHashKernels(void) {
+    const _MufHashKernels *kernels = mufAtomicLoad(&_mufHashKernels);
+    if (kernels != NULL)
+        return kernels;
+
+    for (muf_usize i = 0; i < MUF_COUNTOF(_mufHashVariants); ++i) {
+        kernels = _mufHashVariants[i];
+        if (mufHasCpuFeatures(kernels->required))
+            break;
+    }
+    mufAtomicStore(&_mufHashKernels, kernels);
+    return kernels;
+}
+
+MUF_INTERNAL void _mufHashInitLong(muf_u64 acc[8], muf_u64 secret[16], muf_u64 seed) {
+    acc[0] = MUF_HASH_PRIME32_3;
+    acc[1] = MUF_HASH_PRIME64_1;
+    acc[2] = MUF_HASH_PRIME64_2;
+    acc[3] = MUF_HASH_PRIME64_3;
+    acc[4] = MUF_HASH_PRIME64_4;
+    acc[5] = MUF_HASH_PRIME32_2;
+    acc[6] = MUF_HASH_PRIME64_5;
+    acc[7] = MUF_HASH_PRIME32_1;
+    for (muf_u32 i = 0; i < 16; i += 2) {
+        secret[i] = _mufHashDefaultSecret[i] + seed;
+        secret[i + 1] = _mufHashDefaultSecret[i + 1] - seed;
+    }
+}
+
+MUF_INTERNAL muf_u64 _mufHashFinishLong(muf_u64 acc[8], const muf_byte *lastStripe, const muf_u64 *secret,
+    muf_u64 length) {
+    _mufHashStripeScalar(acc, lastStripe, secret + MUF_HASH_TAIL_KEY);
+
+    muf_u64 h = length * MUF_HASH_PRIME64_1;
+    for (muf_u32 i = 0; i < 4; ++i)
+        h += _mufHashMultiplyFold(acc[i * 2] ^ secret[i * 2 + 3], acc[i * 2 + 1] ^ secret[i * 2 + 4]);
+    h ^= h >> 37;
+    h *= 0x165667919E3779F9ULL;
+    return h ^ (h >> 32);
+}
+
+muf_u64 mufHashBytes64(muf_crawptr data, muf_usize length, muf_u64 seed) {
+    const muf_byte *p = (const muf_byte *) data;
+    if (length <= MUF_HASH_SHORT_MAX)
+        return _mufHashShort(p, length, seed);
+
+    muf_u64 acc[8], secret[16];
+    _mufHashInitLong(acc, secret, seed);
+    muf_u32 blockStripe = 0;
+    /* The final stripe always ends at the last byte, it is left out of the loop even when length is a multiple */
+    _mufGetHashKernels()->accumulate(acc, p, (length - 1) / MUF_HASH_STRIPE_SIZE, secret, &blockStripe);
+    return _mufHashFinishLong(acc, p + length - MUF_HASH_STRIPE_SIZE, secret, length);
+}
+
+void mufInitHasher(MufHasher *hasher, muf_u64 seed) {
+    _mufHashInitLong(hasher->acc, hasher->secret, seed);
+    hasher->seed = seed;
+    hasher->totalLength = 0;
+    hasher->blockStripe = 0;
+    hasher->bufferSize = 0;
+}
+
+void mufHasherUpdate(MufHasher *hasher, muf_crawptr data, muf_usize length) {
+    const muf_byte *p = (const muf_byte *) data;
+    hasher->totalLength += length;
+    if (hasher->bufferSize + length <= MUF_HASH_SHORT_MAX) {
+        memcpy(hasher->buffer + hasher->bufferSize, p, length);
+        hasher->bufferSize += (muf_u32) length;
+        return;
+    }
+
+    /* More data follows whatever is consumed here, so none of it holds the final stripe */
+    const _MufHashKernels *kernels = _mufGetHashKernels();
+    const muf_usize bufferStripes = MUF_HASH_SHORT_MAX / MUF_HASH_STRIPE_SIZE;
+    if (hasher->bufferSize > 0) {
+        muf_usize fill = MUF_HASH_SHORT_MAX - hasher->bufferSize;
+        memcpy(hasher->buffer + hasher->bufferSize, p, fill);
+        p += fill;
+        length -= fill;
+        kernels->accumulate(hasher->acc, hasher->buffer, bufferStripes, hasher->secret, &hasher->blockStripe);
+        memcpy(hasher->lastStripe, hasher->buffer + MUF_HASH_SHORT_MAX - MUF_HASH_STRIPE_SIZE, MUF_HASH_STRIPE_SIZE);
+        hasher->bufferSize = 0;
+    }
+
+    muf_usize chunks = (length - 1) / MUF_HASH_SHORT_MAX;
+    if (chunks > 0) {
+        kernels->accumulate(hasher->acc, p, chunks * bufferStripes, hasher->secret, &hasher->blockStripe);
+        p += chunks * MUF_HASH_SHORT_MAX;
+        length -= chunks * MUF_HASH_SHORT_MAX;
+        memcpy(hasher->lastStripe, p - MUF_HASH_STRIPE_SIZE, MUF_HASH_STRIPE_SIZE);
+    }
+    memcpy(hasher->buffer, p, length);
+    hasher->bufferSize = (muf_u32) length;
+}
+
+muf_u64 mufHasherDigest(const MufHasher *hasher) {
+    if (hasher->totalLength <= MUF_HASH_SHORT_MAX)
+        return _mufHashShort(hasher->buffer, (muf_usize) hasher->totalLength, hasher->seed);
+
+    muf_u64 acc[8];
+    memcpy(acc, hasher->acc, sizeof(acc));
+    muf_u32 blockStripe = hasher->blockStripe;
+    muf_usize size = hasher->bufferSize;
+    _mufGetHashKernels()->accumulate(acc, hasher->buffer, (size - 1) / MUF_HASH_STRIPE_SIZE, hasher->secret,
+        &blockStripe);
+
+    if (size >= MUF_HASH_STRIPE_SIZE)
+        return _mufHashFinishLong(acc, hasher->buffer + size - MUF_HASH_STRIPE_SIZE, hasher->secret,
+            hasher->totalLength);
+    muf_byte lastStripe[MUF_HASH_STRIPE_SIZE];
+    memcpy(lastStripe, hasher->lastStripe + size, MUF_HASH_STRIPE_SIZE - size);
+    memcpy(lastStripe + MUF_HASH_STRIPE_SIZE - size, hasher->buffer, size);
+    return _mufHashFinishLong(acc, lastStripe, hasher->secret, hasher->totalLength);
+}
+
+static volatile muf_u64 _mufHashSeedCounter = 0;
+
+muf_u64 mufGenerateHashSeed(void) {
+    /* The address of the counter moves between runs with ASLR */
+    MufSplitMix64 generator = {
+        mufAtomicFetchAdd(&_mufHashSeedCounter, 1U) ^ (muf_u64) (muf_usize) &_mufHashSeedCounter
+    };
+    return mufSplitMix64Next(&generator);
+}
+
 muf_index mufHash_i8(muf_crawptr value) {
-    return _mufBytesHash(value, sizeof(muf_i8));
+    return (muf_index) mufHashMix64((muf_u64) *(const muf_u8 *) value);
 }
 
 muf_index mufHash_i16(muf_crawptr value) {
-    return _mufBytesHash(value, sizeof(muf_i16));
+    return (muf_index) mufHashMix64((muf_u64) *(const muf_u16 *) value);
 }
 
 muf_index mufHash_i32(muf_crawptr value) {
-    return _mufBytesHash(value, sizeof(muf_i32));
+    return (muf_index) mufHashMix64((muf_u64) *(const muf_u32 *) value);
 }
 
 muf_index mufHash_i64(muf_crawptr value) {
-    return _mufBytesHash(value, sizeof(muf_i64));
+    return (muf_index) mufHashMix64(*(const muf_u64 *) value);
 }
 
 muf_index mufHash_u8(muf_crawptr value) {
-    return _mufBytesHash(value, sizeof(muf_u8));
+    return (muf_index) mufHashMix64((muf_u64) *(const muf_u8 *) value);
 }
 
 muf_index mufHash_u16(muf_crawptr value) {
-    return _mufBytesHash(value, sizeof(muf_u16));
+    return (muf_index) mufHashMix64((muf_u64) *(const muf_u16 *) value);
 }
 
 muf_index mufHash_u32(muf_crawptr value) {
-    return _mufBytesHash(value, sizeof(muf_u32));
+    return (muf_index) mufHashMix64((muf_u64) *(const muf_u32 *) value);
 }
 
 muf_index mufHash_u64(muf_crawptr value) {
-    return _mufBytesHash(value, sizeof(muf_u64));
+    return (muf_index) mufHashMix64(*(const muf_u64 *) value);
 }
 
 muf_index mufHash_f32(muf_crawptr value) {
-    return _mufBytesHash(value, sizeof(muf_f32));
+    /* 0 and -0 compare equal, they must hash the same */
+    muf_f32 f = *(const muf_f32 *) value;
+    muf_u32 bits = 0;
+    if (f != 0.0F)
+        memcpy(&bits, &f, sizeof(bits));
+    return (muf_index) mufHashMix64(bits);
 }
 
 muf_index mufHash_f64(muf_crawptr value) {
-    return _mufBytesHash(value, sizeof(muf_f64));
+    muf_f64 f = *(const muf_f64 *) value;
+    muf_u64 bits = 0;
+    if (f != 0.0)
+        memcpy(&bits, &f, sizeof(bits));
+    return (muf_index) mufHashMix64(bits);
 }
 
 muf_index mufHash_str(muf_crawptr value) {
-    muf_usize length = strlen((const muf_char *) value);
-    return _mufBytesHash(value, length);
+    /* One pass, the words are gathered up to the terminator instead of measuring the string first */
+    const muf_byte *p = (const muf_byte *) value;
+    const muf_u64 *s = _mufHashShortSecret;
+    muf_u64 h = s[0], length = 0;
+    for (;;) {
+        muf_u64 word = 0;
+        muf_u32 n = 0;
+        while (n < 8 && p[n] != 0) {
+            word |= (muf_u64) p[n] << (n * 8);
+            ++n;
+        }
+        if (n > 0)
+            h = _mufHashMultiplyFold(word ^ s[1], h ^ s[2]);
+        length += n;
+        if (n < 8)
+            break;
+        p += 8;
+    }
+    return (muf_index) _mufHashMultiplyFold(h ^ length, s[3]);
 }
 
 muf_index mufHash_ptr(muf_crawptr value) {
-    return _mufBytesHash(&value, sizeof(muf_crawptr));
+    return (muf_index) mufHashMix64((muf_u64) (muf_usize) value);
 }
 
 muf_index mufHashBytes(muf_crawptr data, muf_usize length) {
-    return _mufBytesHash(data, length);
+    return (muf_index) mufHashBytes64(data, length, 0);
 }
 
-#define mufHash(Suffix) mufHash_##Suffix
\ No newline at end of file
+#define mufHash(Suffix) mufHash_##Suffix
@@ -1,3 +1,5 @@
+#define MUF_MEMORY_TAG MUF_MEMORY_TAG_CORE_CONTAINERS
+
 #include "muffin_core/hash_map.h"
 
 #include "internal/hash_table.h"
@@ -18,7 +20,7 @@ void mufDestoryHashMap(MufHashMap *map) {
     mufDestroyHashTable(_TABLE(map));
 }
 
-muf_usize mufHashGetMapSize(const MufHashMap *map) {
+muf_usize mufHashMapGetSize(const MufHashMap *map) {
     return _TABLE(map)->size;
 }
 
@@ -47,7 +49,6 @@ muf_bool mufHashMapGet(const MufHashMap *map, muf_crawptr key, muf_rawptr valueO
 muf_rawptr mufHashMapGetRef(MufHashMap *map, muf_crawptr key) {
     MufHashTable *table = _TABLE(map);
     MufHashTableNode *node = mufHashTableFind(table, key, NULL);
-    return node == NULL ? NULL : mufHashTableNodeGetData(node);
     if (node == NULL) {
         return NULL;
     }
@@ -73,7 +74,7 @@ void mufHashMapRehash(MufHashMap *map, muf_usize newBucketCount) {
 
 static MUF_INLINE MufHashTableNode *_mufHashMapCreateNode(const MufHashMap *map, muf_crawptr key, muf_crawptr value) {
     MufHashTable *table = _TABLE(map);
-    MufHashTableNode *node = mufCreateHashTableNode(NULL, table->hash(key), table->storageSize, NULL);
+    MufHashTableNode *node = mufCreateHashTableNode(NULL, mufHashTableHashKey(table, key), table->storageSize, NULL);
     muf_rawptr keyDst = MUF_RAWPTR_AT(node, sizeof(MufHashTableNode), 1);
     muf_rawptr valueDst = MUF_RAWPTR_AT(node, sizeof(MufHashTableNode) + table->keySize, 1);
     mufMemCopyBytes(keyDst, key, table->keySize);
@@ -1,3 +1,5 @@
+#define MUF_MEMORY_TAG MUF_MEMORY_TAG_CORE_CONTAINERS
+
 #include "muffin_core/hash_set.h"
 
 #include "internal/hash_table.h"
@@ -41,12 +43,12 @@ muf_f32 mufHashSetGetLoadFactor(const MufHashSet *set) {
 
 muf_rawptr mufHashSetFind(MufHashSet *set, muf_crawptr item) {
     MufHashTableNode *node = mufHashTableFind(_TABLE(set), item, NULL);
-    return _mufHashSetKeyExtract(node);
+    return node == NULL ? NULL : _mufHashSetKeyExtract(node);
 }
 
 muf_crawptr mufHashSetCFind(const MufHashSet *set, muf_crawptr item) {
     MufHashTableNode *node = mufHashTableFind(_CTABLE(set), item, NULL);
-    return (muf_crawptr) _mufHashSetKeyExtract(node);
+    return node == NULL ? NULL : (muf_crawptr) _mufHashSetKeyExtract(node);
 }
 
 muf_bool mufHashSetContains(const MufHashSet *set, muf_crawptr item) {
@@ -59,7 +61,7 @@ muf_bool mufHashSetInsert(MufHashSet *set, muf_crawptr item) {
     }
     MufHashTableNode *node = (MufHashTableNode *) mufAlloc(muf_byte, sizeof(MufHashTableNode) + _TABLE(set)->keySize);
     node->next = NULL;
-    node->hashCode = _TABLE(set)->hash(item);
+    node->hashCode = mufHashTableHashKey(_TABLE(set), item);
     memcpy(MUF_RAWPTR_AT((muf_rawptr) node, sizeof(MufHashTableNode), 1), item, _TABLE(set)->keySize);
     mufHashTableInsert(_TABLE(set), node);
     return MUF_TRUE;
@@ -68,7 +70,7 @@ muf_bool mufHashSetInsert(MufHashSet *set, muf_crawptr item) {
 void mufHashSetInsertOrAssign(MufHashSet *set, muf_crawptr item) {
     MufHashTableNode *node = (MufHashTableNode *) mufAlloc(muf_byte, sizeof(MufHashTableNode) + _TABLE(set)->keySize);
     node->next = NULL;
-    node->hashCode = _TABLE(set)->hash(item);
+    node->hashCode = mufHashTableHashKey(_TABLE(set), item);
     memcpy(MUF_RAWPTR_AT((muf_rawptr) node, sizeof(MufHashTableNode), 1), item, _TABLE(set)->keySize);
     //mufHashTableInsertOrAssign(set, node);
 }
@@ -0,0 +1,190 @@
+#define MUF_MEMORY_TAG MUF_MEMORY_TAG_CORE_CONTAINERS
+
+#include "muffin_core/intern.h"
+#include "muffin_core/hash.h"
+#include "muffin_core/memory.h"
+#include "muffin_core/string.h"
+#include "muffin_core/sync.h"
+
+/* The entries are kept in pages that never move, an id is read without the lock */
+#define MUF_INTERN_PAGE_SHIFT       12
+#define MUF_INTERN_PAGE_SIZE        (1U << MUF_INTERN_PAGE_SHIFT)
+#define MUF_INTERN_MAX_PAGES        ((MUF_INTERN_MAX_STRS >> MUF_INTERN_PAGE_SHIFT) + 1)
+#define MUF_INTERN_CHUNK_SIZE       (64 * 1024)
+#define MUF_INTERN_MIN_SLOTS        256
+
+typedef struct _MufInternEntry_s {
+    const muf_char  *data;
+    muf_u64         hash;
+    muf_usize       length;
+} _MufInternEntry;
+
+typedef struct _MufInternSlot_s {
+    /* MUF_STR_ID_INVALID for an empty slot */
+    MufStrId    id;
+    /* The low bits of the hash, most mismatches are rejected without reading the entry */
+    muf_u32     hashTag;
+} _MufInternSlot;
+
+typedef struct _MufInternChunk_s {
+    struct _MufInternChunk_s    *next;
+    muf_usize                   used;
+    muf_usize                   capacity;
+} _MufInternChunk;
+
+#define _mufInternChunkGetData(_chunk) ((muf_char *) ((_chunk) + 1))
+
+typedef struct _MufInterner_s {
+    MufSpinLock         lock;
+    /* The number of ids given out plus one, id 0 is never used */
+    volatile muf_u32    nextId;
+    _MufInternSlot      *slots;
+    muf_u32             slotCount;
+    _MufInternChunk     *chunks;
+    _MufInternEntry     *pages[MUF_INTERN_MAX_PAGES];
+} _MufInterner;
+
+static _MufInterner _mufInterner[1] = {{ MUF_SPIN_LOCK_INIT, 1, NULL, 0, NULL, { NULL } }};
+
+MUF_INTERNAL MUF_INLINE _MufInternEntry *_mufInternGetEntry(MufStrId id) {
+    _MufInternEntry *page = mufAtomicLoad(&_mufInterner->pages[id >> MUF_INTERN_PAGE_SHIFT]);
+    return &page[id & (MUF_INTERN_PAGE_SIZE - 1)];
+}
+
+MUF_INTERNAL MufStrId _mufInternFindLocked(const muf_char *str, muf_usize length, muf_u64 hash, muf_u32 *slotOut) {
+    muf_u32 mask = _mufInterner->slotCount - 1;
+    muf_u32 index = (muf_u32) (hash >> 32) & mask;
+    for (;;) {
+        const _MufInternSlot *slot = &_mufInterner->slots[index];
+        if (slot->id == MUF_STR_ID_INVALID) {
+            *slotOut = index;
+            return MUF_STR_ID_INVALID;
+        }
+        if (slot->hashTag == (muf_u32) hash) {
+            const _MufInternEntry *entry = _mufInternGetEntry(slot->id);
+            if (entry->hash == hash && entry->length == length && mufMemEqual(entry->data, str, length)) {
+                *slotOut = index;
+                return slot->id;
+            }
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+MUF_INTERNAL void _mufInternGrowSlots(void) {
+    muf_u32 oldCount = _mufInterner->slotCount;
+    _MufInternSlot *oldSlots = _mufInterner->slots;
+    muf_u32 newCount = oldCount == 0 ? MUF_INTERN_MIN_SLOTS : oldCount * 2;
+    _MufInternSlot *newSlots = mufAllocZero(_MufInternSlot, newCount);
+
+    for (muf_u32 i = 0; i < oldCount; ++i) {
+        if (oldSlots[i].id == MUF_STR_ID_INVALID)
+            continue;
+        muf_u32 index = (muf_u32) (_mufInternGetEntry(oldSlots[i].id)->hash >> 32) & (newCount - 1);
+        while (newSlots[index].id != MUF_STR_ID_INVALID)
+            index = (index + 1) & (newCount - 1);
+        newSlots[index] = oldSlots[i];
+    }
+
+    if (oldSlots)
+        mufFree(oldSlots);
+    _mufInterner->slots = newSlots;
+    _mufInterner->slotCount = newCount;
+}
+
+MUF_INTERNAL const muf_char *_mufInternStoreText(const muf_char *str, muf_usize length) {
+    _MufInternChunk *chunk = _mufInterner->chunks;
+    if (chunk == NULL || chunk->capacity - chunk->used < length + 1) {
+        /* Long strings get a chunk of their own, the current chunk stays in use for the short ones */
+        muf_usize capacity = length + 1 > MUF_INTERN_CHUNK_SIZE / 4 ? length + 1 : MUF_INTERN_CHUNK_SIZE;
+        _MufInternChunk *newChunk = (_MufInternChunk *) mufAlloc(muf_byte, sizeof(_MufInternChunk) + capacity);
+        newChunk->used = 0;
+        newChunk->capacity = capacity;
+        if (chunk != NULL && capacity != MUF_INTERN_CHUNK_SIZE) {
+            newChunk->next = chunk->next;
+            chunk->next = newChunk;
+        } else {
+            newChunk->next = chunk;
+            _mufInterner->chunks = newChunk;
+        }
+        chunk = newChunk;
+    }
+
+    muf_char *text = _mufInternChunkGetData(chunk) + chunk->used;
+    mufMemCopyBytes(text, str, length);
+    text[length] = '\0';
+    chunk->used += length + 1;
+    return text;
+}
+
+MufStrId mufInternStrN(const muf_char *str, muf_usize length) {
+    muf_u64 hash = mufHashBytes64(str, length, 0);
+
+    mufSpinLockAcquire(&_mufInterner->lock);
+    /* Keep the table at most half full */
+    if ((_mufInterner->nextId - 1) * 2 >= _mufInterner->slotCount)
+        _mufInternGrowSlots();
+
+    muf_u32 slotIndex;
+    MufStrId id = _mufInternFindLocked(str, length, hash, &slotIndex);
+    if (id == MUF_STR_ID_INVALID) {
+        id = _mufInterner->nextId;
+        if (id > MUF_INTERN_MAX_STRS) {
+            mufSpinLockRelease(&_mufInterner->lock);
+            return MUF_STR_ID_INVALID;
+        }
+
+        _MufInternEntry **page = &_mufInterner->pages[id >> MUF_INTERN_PAGE_SHIFT];
+        if (*page == NULL)
+            mufAtomicStore(page, mufAlloc(_MufInternEntry, MUF_INTERN_PAGE_SIZE));
+
+        _MufInternEntry *entry = _mufInternGetEntry(id);
+        entry->data = _mufInternStoreText(str, length);
+        entry->hash = hash;
+        entry->length = length;
+
+        _mufInterner->slots[slotIndex].id = id;
+        _mufInterner->slots[slotIndex].hashTag = (muf_u32) hash;
+        mufAtomicStore(&_mufInterner->nextId, id + 1);
+    }
+    mufSpinLockRelease(&_mufInterner->lock);
+    return id;
+}
+
+MufStrId mufInternStr(const muf_char *str) {
+    return mufInternStrN(str, mufCStrLength(str));
+}
+
+MufStrId mufFindStrIdN(const muf_char *str, muf_usize length) {
+    muf_u64 hash = mufHashBytes64(str, length, 0);
+    MufStrId id = MUF_STR_ID_INVALID;
+
+    mufSpinLockAcquire(&_mufInterner->lock);
+    if (_mufInterner->slotCount != 0) {
+        muf_u32 slotIndex;
+        id = _mufInternFindLocked(str, length, hash, &slotIndex);
+    }
+    mufSpinLockRelease(&_mufInterner->lock);
+    return id;
+}
+
+MufStrId mufFindStrId(const muf_char *str) {
+    return mufFindStrIdN(str, mufCStrLength(str));
+}
+
+const muf_char *mufGetStrIdCStr(MufStrId id) {
+    return id == MUF_STR_ID_INVALID ? NULL : _mufInternGetEntry(id)->data;
+}
+
+muf_usize mufGetStrIdLength(MufStrId id) {
+    return id == MUF_STR_ID_INVALID ? 0 : _mufInternGetEntry(id)->length;
+}
+
+muf_u64 mufGetStrIdHash(MufStrId id) {
+    MUF_FASSERT(id != MUF_STR_ID_INVALID, "The id is invalid");
+    return _mufInternGetEntry(id)->hash;
+}
+
+muf_usize mufGetInternedStrCount(void) {
+    return mufAtomicLoad(&_mufInterner->nextId) - 1;
+}
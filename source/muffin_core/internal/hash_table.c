@@ -1,3 +1,5 @@
+#define MUF_MEMORY_TAG MUF_MEMORY_TAG_CORE_CONTAINERS
+
 #include "hash_table.h"
 
 #include <math.h>
@@ -32,6 +34,7 @@ MufHashTable *mufCreateHashTable(muf_usize keySize, muf_usize valueSize, MufKeyE
     table->keyExtract = keyExtract;
     table->equal = equal;
     table->hash = hash;
+    table->seed = mufGenerateHashSeed();
     table->bucketCount = MUF_HASHTABLE_DEFAULT_INIT_BUCKET_COUNT;
     table->buckets = mufAllocZero(MufHashTableNode *, table->bucketCount);
     table->size = 0;
@@ -53,7 +56,7 @@ muf_f32 mufHashTableGetLoadFactor(const MufHashTable *table) {
 }
 
 MufHashTableNode *mufHashTableFind(const MufHashTable *table, muf_crawptr key, MufHashTableNode **prevOut) {
-    muf_index hashCode = table->hash(key);
+    muf_index hashCode = mufHashTableHashKey(table, key);
     muf_index bucketIndex = _mufHashTableCalcBucketIndex(table, hashCode);
 
     MufHashTableNode *prv = NULL;
@@ -73,7 +76,7 @@ MufHashTableNode *mufHashTableFind(const MufHashTable *table, muf_crawptr key, M
 
 void mufHashTableInsert(MufHashTable *table, MufHashTableNode *node) {
     if (((muf_f32) (table->size + 1)) / table->bucketCount >= MUF_HASHTABLE_DEFAULT_MAX_LOAD_FACTOR)
-        mufHashTableRehash(table, table->size + 1);
+        mufHashTableRehash(table, table->bucketCount * 2);
     
     muf_index bucketIndex = node->hashCode & (table->bucketCount - 1);
     node->next = table->buckets[bucketIndex];
@@ -106,13 +109,15 @@ void mufHashTableClear(MufHashTable *table) {
             mufFree(node);
             node = next;
         }
+        table->buckets[i] = NULL;
     }
     table->size = 0;
 }
 
 void mufHashTableRehash(MufHashTable *table, muf_usize newBucketCount) {
-    if (!(newBucketCount & (newBucketCount - 1)))
-        newBucketCount = mufCeilPower2(newBucketCount);
+    if (newBucketCount < table->size)
+        newBucketCount = table->size;
+    newBucketCount = mufCeilPower2(newBucketCount);
 
     MufHashTableNode **newBuckets = mufAllocZero(MufHashTableNode *, newBucketCount);
 
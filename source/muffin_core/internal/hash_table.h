@@ -24,6 +24,8 @@ typedef struct MufHashTable_s {
     MufKeyExtractor         keyExtract;
     MufEqualityComparator   equal;
     MufHash                 hash;
+    /* Mixed into every hash code, each table lays its keys out differently */
+    muf_u64                 seed;
 
     MufHashTableNode        **buckets;
     muf_usize               bucketCount;
@@ -57,6 +59,10 @@ void mufHashTableRehash(MufHashTable *table, muf_usize newBucketCount);
 
 void mufHashTableForEach(MufHashTable *table, void (*unaryFunc)(muf_rawptr item));
 
+static MUF_INLINE muf_index mufHashTableHashKey(const MufHashTable *table, muf_crawptr key) {
+    return (muf_index) mufHashMix64((muf_u64) table->hash(key) ^ table->seed);
+}
+
 static MUF_INLINE muf_rawptr mufHashTableExtractNodeKey(const MufHashTable *table, MufHashTableNode *node) {
     return MUF_RAWPTR_TYPE_AT(node, MufHashTableNode, 1);
 }
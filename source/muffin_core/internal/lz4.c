@@ -0,0 +1,229 @@
+#include "lz4.h"
+
+#include <string.h>
+
+#define MUF_LZ4_MIN_MATCH       4
+#define MUF_LZ4_LAST_LITERALS   5
+#define MUF_LZ4_MF_LIMIT        12
+#define MUF_LZ4_MAX_DISTANCE    65535
+#define MUF_LZ4_HASH_LOG        12
+#define MUF_LZ4_RUN_MASK        15
+#define MUF_LZ4_MATCH_MASK      15
+#define MUF_LZ4_SKIP_TRIGGER    6
+#define MUF_LZ4_WILD_COPY       8
+
+MUF_INTERNAL MUF_INLINE muf_u32 _mufLz4Read32(const muf_byte *p) {
+    muf_u32 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+MUF_INTERNAL MUF_INLINE muf_u32 _mufLz4Hash(muf_u32 sequence) {
+    return (sequence * 2654435761U) >> (32 - MUF_LZ4_HASH_LOG);
+}
+
+MUF_INTERNAL muf_byte *_mufLz4WriteLength(muf_byte *op, muf_usize length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (muf_byte) length;
+    return op;
+}
+
+MUF_INTERNAL muf_bool _mufLz4ReadLength(const muf_byte **ip, const muf_byte *end, muf_usize *length) {
+    muf_u32 s;
+    do {
+        if (*ip >= end)
+            return MUF_FALSE;
+        s = *(*ip)++;
+        *length += s;
+    } while (s == 255);
+    return MUF_TRUE;
+}
+
+muf_usize mufLz4CompressBound(muf_usize size) {
+    if (size > MUF_LZ4_MAX_INPUT_SIZE)
+        return 0;
+    return size + size / 255 + 16;
+}
+
+muf_usize mufLz4Compress(const muf_byte *src, muf_usize srcSize, muf_byte *dst, muf_usize dstCapacity) {
+    if (srcSize > MUF_LZ4_MAX_INPUT_SIZE || dstCapacity == 0)
+        return 0;
+
+    const muf_byte *const end = src + srcSize;
+    const muf_byte *ip = src;
+    const muf_byte *anchor = src;
+    muf_byte *op = dst;
+    muf_byte *const outEnd = dst + dstCapacity;
+
+    if (srcSize >= MUF_LZ4_MF_LIMIT + 1) {
+        const muf_byte *const matchFindLimit = end - MUF_LZ4_MF_LIMIT;
+        const muf_byte *const matchLimit = end - MUF_LZ4_LAST_LITERALS;
+        muf_u32 table[1 << MUF_LZ4_HASH_LOG];
+        memset(table, 0, sizeof(table));
+        ++ip;
+
+        while (ip <= matchFindLimit) {
+            /* Find a match, the step grows while nothing is found so incompressible data is skipped quickly */
+            const muf_byte *match = NULL;
+            muf_u32 searchCount = 1U << MUF_LZ4_SKIP_TRIGGER;
+            while (ip <= matchFindLimit) {
+                muf_u32 h = _mufLz4Hash(_mufLz4Read32(ip));
+                const muf_byte *candidate = src + table[h];
+                table[h] = (muf_u32) (ip - src);
+                if (candidate < ip && ip - candidate <= MUF_LZ4_MAX_DISTANCE && _mufLz4Read32(candidate) == _mufLz4Read32(ip)) {
+                    match = candidate;
+                    break;
+                }
+                ip += searchCount++ >> MUF_LZ4_SKIP_TRIGGER;
+            }
+            if (match == NULL)
+                break;
+
+            while (ip > anchor && match > src && ip[-1] == match[-1]) {
+                --ip;
+                --match;
+            }
+
+            muf_usize literalLength = (muf_usize) (ip - anchor);
+            muf_usize matchLength = MUF_LZ4_MIN_MATCH;
+            while (ip + matchLength < matchLimit && ip[matchLength] == match[matchLength])
+                ++matchLength;
+
+            if ((muf_usize) (outEnd - op) < 1 + literalLength / 255 + 1 + literalLength + 2 + matchLength / 255 + 1)
+                return 0;
+
+            muf_byte *token = op++;
+            if (literalLength >= MUF_LZ4_RUN_MASK) {
+                *token = MUF_LZ4_RUN_MASK << 4;
+                op = _mufLz4WriteLength(op, literalLength - MUF_LZ4_RUN_MASK);
+            } else {
+                *token = (muf_byte) (literalLength << 4);
+            }
+            memcpy(op, anchor, literalLength);
+            op += literalLength;
+
+            op[0] = (muf_byte) (ip - match);
+            op[1] = (muf_byte) ((ip - match) >> 8);
+            op += 2;
+
+            if (matchLength - MUF_LZ4_MIN_MATCH >= MUF_LZ4_MATCH_MASK) {
+                *token |= MUF_LZ4_MATCH_MASK;
+                op = _mufLz4WriteLength(op, matchLength - MUF_LZ4_MIN_MATCH - MUF_LZ4_MATCH_MASK);
+            } else {
+                *token |= (muf_byte) (matchLength - MUF_LZ4_MIN_MATCH);
+            }
+
+            ip += matchLength;
+            anchor = ip;
+            if (ip > matchFindLimit)
+                break;
+            table[_mufLz4Hash(_mufLz4Read32(ip - 2))] = (muf_u32) (ip - 2 - src);
+        }
+    }
+
+    /* The last sequence carries literals only */
+    muf_usize literalLength = (muf_usize) (end - anchor);
+    if ((muf_usize) (outEnd - op) < 1 + (literalLength + 255 - MUF_LZ4_RUN_MASK) / 255 + literalLength)
+        return 0;
+    if (literalLength >= MUF_LZ4_RUN_MASK) {
+        *op++ = MUF_LZ4_RUN_MASK << 4;
+        op = _mufLz4WriteLength(op, literalLength - MUF_LZ4_RUN_MASK);
+    } else {
+        *op++ = (muf_byte) (literalLength << 4);
+    }
+    memcpy(op, anchor, literalLength);
+    op += literalLength;
+    return (muf_usize) (op - dst);
+}
+
+muf_isize mufLz4Decompress(const muf_byte *src, muf_usize srcSize, muf_byte *dst, muf_usize dstCapacity) {
+    if (srcSize == 0)
+        return -1;
+
+    const muf_byte *ip = src;
+    const muf_byte *const end = src + srcSize;
+    muf_byte *op = dst;
+    muf_byte *const outEnd = dst + dstCapacity;
+
+    for (;;) {
+        muf_u32 token = *ip++;
+        muf_usize length = token >> 4;
+        muf_usize offset;
+        const muf_byte *match;
+
+        /*
+         * Short sequences dominate typical data: with enough room on both sides the literals and the match
+         * are moved with fixed-size copies. A literal run below 15 with 16 readable bytes cannot be the
+         * last sequence, so the offset is always present.
+         */
+        if (length < MUF_LZ4_RUN_MASK && end - ip >= 16 && outEnd - op >= 32) {
+            memcpy(op, ip, 16);
+            op += length;
+            ip += length;
+            offset = (muf_usize) ip[0] | ((muf_usize) ip[1] << 8);
+            length = token & MUF_LZ4_MATCH_MASK;
+            if (length < MUF_LZ4_MATCH_MASK && offset >= 8 && offset <= (muf_usize) (op - dst)) {
+                ip += 2;
+                match = op - offset;
+                memcpy(op, match, 8);
+                memcpy(op + 8, match + 8, 8);
+                memcpy(op + 16, match + 16, 2);
+                op += length + MUF_LZ4_MIN_MATCH;
+                if (ip >= end)
+                    return -1;
+                continue;
+            }
+            goto readOffset;
+        }
+
+        if (length == MUF_LZ4_RUN_MASK && !_mufLz4ReadLength(&ip, end, &length))
+            return -1;
+        if (length > (muf_usize) (end - ip) || length > (muf_usize) (outEnd - op))
+            return -1;
+        memcpy(op, ip, length);
+        op += length;
+        ip += length;
+
+        /* The last sequence carries literals only */
+        if (ip == end)
+            break;
+
+    readOffset:
+        if (end - ip < 2)
+            return -1;
+        offset = (muf_usize) ip[0] | ((muf_usize) ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (muf_usize) (op - dst))
+            return -1;
+
+        length = token & MUF_LZ4_MATCH_MASK;
+        if (length == MUF_LZ4_MATCH_MASK && !_mufLz4ReadLength(&ip, end, &length))
+            return -1;
+        length += MUF_LZ4_MIN_MATCH;
+        if (length > (muf_usize) (outEnd - op))
+            return -1;
+
+        match = op - offset;
+        if (offset >= MUF_LZ4_WILD_COPY && (muf_usize) (outEnd - op) >= length + MUF_LZ4_WILD_COPY) {
+            /* Copy in 8 byte steps, the overrun may touch at most 7 bytes past the match but stays inside dst */
+            muf_byte *const copyEnd = op + length;
+            do {
+                memcpy(op, match, MUF_LZ4_WILD_COPY);
+                op += MUF_LZ4_WILD_COPY;
+                match += MUF_LZ4_WILD_COPY;
+            } while (op < copyEnd);
+            op = copyEnd;
+        } else {
+            for (muf_usize i = 0; i < length; ++i)
+                op[i] = match[i];
+            op += length;
+        }
+
+        if (ip >= end)
+            return -1;
+    }
+    return (muf_isize) (op - dst);
+}
@@ -0,0 +1,32 @@
+#ifndef _MUFFIN_CORE_INTERNAL_LZ4_H_
+#define _MUFFIN_CORE_INTERNAL_LZ4_H_
+
+#include "muffin_core/common.h"
+
+/*
+ * The LZ4 block format (lz4_Block_format.md of the reference implementation), written for the block streams of
+ * compression.c. Blocks are interchangeable with those of the reference library.
+ * The compressor is a single-pass greedy matcher with a 4K-entry hash table, the decompressor checks every length
+ * and offset against both buffers.
+ */
+
+#define MUF_LZ4_MAX_INPUT_SIZE 0x7E000000U
+
+/**
+ * @brief Get the worst case size of compressing size bytes, 0 if size is above MUF_LZ4_MAX_INPUT_SIZE
+ */
+muf_usize mufLz4CompressBound(muf_usize size);
+
+/**
+ * @brief Compress a block, nothing is written past dst + dstCapacity
+ * @return The compressed size, 0 if dst is too small
+ */
+muf_usize mufLz4Compress(const muf_byte *src, muf_usize srcSize, muf_byte *dst, muf_usize dstCapacity);
+
+/**
+ * @brief Decompress a block, nothing is read past src + srcSize nor written past dst + dstCapacity
+ * @return The decompressed size, -1 if the block is malformed or does not fit into dst
+ */
+muf_isize mufLz4Decompress(const muf_byte *src, muf_usize srcSize, muf_byte *dst, muf_usize dstCapacity);
+
+#endif
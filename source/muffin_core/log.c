@@ -1,3 +1,5 @@
+#define MUF_MEMORY_TAG MUF_MEMORY_TAG_LOG
+
 #include "muffin_core/log.h"
 
 #include <stdarg.h>
@@ -4,6 +4,8 @@
 
 #include "muffin_core/hash.h"
 #include "muffin_core/memory.h"
+#include "muffin_core/random.h"
+#include "muffin_core/sync.h"
 
 muf_bool mufFloatEqualEpsilon(muf_f64 a, muf_f64 b, muf_f64 epsilon) {
     return mufAbs(a - b) < epsilon;
@@ -65,15 +67,21 @@ MUF_INTERNAL void _mufInitMT19937(MufMT19937 *generator, muf_u32 seed) {
     }
 }
 
+MUF_INTERNAL muf_u32 _mufMT19937Mix(muf_u32 upper, muf_u32 lower, muf_u32 shifted) {
+    muf_u32 y = (upper & 0x80000000) | (lower & 0x7FFFFFFF);
+    return shifted ^ (y >> 1) ^ ((0U - (y & 1)) & 0x9908B0DF);
+}
+
 MUF_INTERNAL void _mufMT19937Twist(MufMT19937 *generator) {
     muf_u32 *mt = generator->mt;
+    muf_index i = 0;
 
-    for (muf_index i = 0; i < 624; ++i) {
-        muf_u32 y = (mt[i] & 0x80000000) + (mt[(i + 1) % 624] & 0x7FFFFFFF);
-        mt[i] = mt[(i + 397) % 624] ^ (y >> 1);
-        if (y & 1)
-            mt[i] ^= 0x9908B0DF;
-    }
+    /* Split where i + 1 and i + 397 wrap around, the loops need no modulo */
+    for (; i < 624 - 397; ++i)
+        mt[i] = _mufMT19937Mix(mt[i], mt[i + 1], mt[i + 397]);
+    for (; i < 623; ++i)
+        mt[i] = _mufMT19937Mix(mt[i], mt[i + 1], mt[i + 397 - 624]);
+    mt[623] = _mufMT19937Mix(mt[623], mt[0], mt[396]);
 }
 
 MufMT19937 *mufCreateMT19937(muf_u32 seed) {
@@ -99,17 +107,29 @@ muf_u32 mufMT19937Next(MufMT19937 *generator) {
 	y = y ^ ((y << 7) & (0x9D2C5680));
 	y = y ^ ((y << 15) & (0xEFC60000));
 	y = y ^ (y >> 18);
-	generator->index = (generator->index + 1) % 624;
+	generator->index = generator->index == 623 ? 0 : generator->index + 1;
 
     return y;
 }
 
+/* Lemire's multiply and reject, an integer in [0, bound) without modulo bias */
+MUF_INTERNAL muf_u32 _mufMT19937NextBounded(MufMT19937 *generator, muf_u32 bound) {
+    muf_u64 m = (muf_u64) mufMT19937Next(generator) * bound;
+    if ((muf_u32) m < bound) {
+        muf_u32 threshold = (0U - bound) % bound;
+        while ((muf_u32) m < threshold)
+            m = (muf_u64) mufMT19937Next(generator) * bound;
+    }
+    return (muf_u32) (m >> 32);
+}
+
 muf_i32 mufRandomRange(MufMT19937 *generator, muf_i32 minValue, muf_i32 maxValue) {
-    if (minValue < maxValue) {
-        mufSwapInt(minValue, maxValue);
+    if (minValue > maxValue) {
+        mufSwap(muf_i32, minValue, maxValue);
     }
-    muf_u32 v = mufMT19937Next(generator);
-    return (v % (maxValue - minValue + 1)) + minValue;
+    muf_u32 span = (muf_u32) maxValue - (muf_u32) minValue + 1U;
+    muf_u32 offset = span == 0 ? mufMT19937Next(generator) : _mufMT19937NextBounded(generator, span);
+    return (muf_i32) ((muf_u32) minValue + offset);
 }
 
 muf_f32 mufRandomRangef(MufMT19937 *generator, muf_f32 minValue, muf_f32 maxValue) {
@@ -120,6 +140,51 @@ muf_f32 mufRandomRangef(MufMT19937 *generator, muf_f32 minValue, muf_f32 maxValu
     return minValue + (((muf_f32) v) / UINT32_MAX) * (maxValue - minValue);
 }
 
+void mufShuffle(MufMT19937 *generator, const muf_rawptr data, muf_usize elementSize, muf_usize count) {
+    /* Fisher-Yates, swapped byte by byte since the element size is only known at runtime */
+    muf_byte *bytes = (muf_byte *) data;
+    for (muf_usize i = count; i > 1; --i) {
+        muf_usize j = _mufMT19937NextBounded(generator, (muf_u32) i);
+        if (j == i - 1)
+            continue;
+        muf_byte *a = bytes + (i - 1) * elementSize, *b = bytes + j * elementSize;
+        for (muf_usize k = 0; k < elementSize; ++k)
+            mufSwap(muf_byte, a[k], b[k]);
+    }
+}
+
+/*
+ * mufRandom draws from a generator per thread, no lock is shared. Each thread takes the next Xoshiro256++ stream
+ * of the global seed the first time it draws after the seed changed.
+ */
+static volatile muf_u32 _mufRandomSeed = 0;
+static volatile muf_u32 _mufRandomEpoch = 1;
+static volatile muf_u32 _mufRandomStreamCount = 0;
+static MUF_THREAD_LOCAL MufXoshiro256 _mufThreadRandom;
+static MUF_THREAD_LOCAL muf_u32 _mufThreadRandomEpoch = 0;
+
+void mufSetRandomSeed(muf_i32 seed) {
+    mufAtomicStore(&_mufRandomSeed, (muf_u32) seed);
+    mufAtomicStore(&_mufRandomStreamCount, 0U);
+    mufAtomicFetchAdd(&_mufRandomEpoch, 1U);
+}
+
+muf_i32 mufGetRandomSeed(void) {
+    return (muf_i32) mufAtomicLoad(&_mufRandomSeed);
+}
+
+muf_i32 mufRandom(muf_i32 minValue, muf_i32 maxValue) {
+    muf_u32 epoch = mufAtomicLoad(&_mufRandomEpoch);
+    if (_mufThreadRandomEpoch != epoch) {
+        muf_u32 stream = mufAtomicFetchAdd(&_mufRandomStreamCount, 1U);
+        mufInitXoshiro256(&_mufThreadRandom, mufAtomicLoad(&_mufRandomSeed));
+        for (muf_u32 i = 0; i < stream; ++i)
+            mufXoshiro256Jump(&_mufThreadRandom);
+        _mufThreadRandomEpoch = epoch;
+    }
+    return mufXoshiro256Range(&_mufThreadRandom, minValue, maxValue);
+}
+
 MufVec2 mufCreateVec2(muf_f32 x, muf_f32 y) {
     return (MufVec2) { x, y };
 }
@@ -206,10 +271,6 @@ MufVec3 mufVec3Negate(MufVec3 v) {
     return (MufVec3) { -v.x, -v.y, -v.z };
 }
 
-MufVec4 mufVec4Negate(MufVec4 v) {
-    return (MufVec4) { -v.x, -v.y, -v.z, -v.w };
-}
-
 MufVec2 mufVec2Add(MufVec2 v1, MufVec2 v2) {
     return (MufVec2) { v1.x + v2.x, v1.y + v2.y };
 }
@@ -218,10 +279,6 @@ MufVec3 mufVec3Add(MufVec3 v1, MufVec3 v2) {
     return (MufVec3) { v1.x + v2.x, v1.y + v2.y, v1.z + v2.z };
 }
 
-MufVec4 mufVec4Add(MufVec4 v1, MufVec4 v2) {
-    return (MufVec4) { v1.x + v2.x, v1.y + v2.y, v1.z + v2.z, v1.w + v2.w };
-}
-
 MufVec2 mufVec2Sub(MufVec2 v1, MufVec2 v2) {
     return (MufVec2) { v1.x - v2.x, v1.y - v2.y };
 }
@@ -230,10 +287,6 @@ MufVec3 mufVec3Sub(MufVec3 v1, MufVec3 v2) {
     return (MufVec3) { v1.x - v2.x, v1.y - v2.y, v1.z - v2.z };
 }
 
-MufVec4 mufVec4Sub(MufVec4 v1, MufVec4 v2) {
-    return (MufVec4) { v1.x - v2.x, v1.y - v2.y, v1.z - v2.z, v1.w - v2.w };
-}
-
 MufVec2 mufVec2Mul(MufVec2 v, muf_f32 s) {
     return (MufVec2) { v.x * s, v.y * s };
 }
@@ -242,10 +295,6 @@ MufVec3 mufVec3Mul(MufVec3 v, muf_f32 s) {
     return (MufVec3) { v.x * s, v.y * s, v.z * s };
 }
 
-MufVec4 mufVec4Mul(MufVec4 v, muf_f32 s) {
-    return (MufVec4) { v.x * s, v.y * s, v.z * s, v.w * s };
-}
-
 MufVec2 mufVec2Div(MufVec2 v, muf_f32 s) {
     MUF_FASSERT(s != 0.0F, "The divisor cannot be zero");
     muf_f32 denom = 1.0F / s;
@@ -272,10 +321,6 @@ MufVec3 mufVec3Scale(MufVec3 v, muf_f32 s) {
     return mufVec3Mul(v, s);
 }
 
-MufVec4 mufVec4Scale(MufVec4 v, muf_f32 s) {
-    return mufVec4Mul(v, s);
-}
-
 muf_f32 mufVec2Dot(MufVec2 v1, MufVec2 v2) {
     return v1.x * v2.x + v1.y * v2.y;
 }
@@ -304,10 +349,6 @@ MufVec3 mufVec3Hadamard(MufVec3 v1, MufVec3 v2) {
     return (MufVec3) { v1.x * v2.x, v1.y * v2.y, v1.z * v2.z };
 }
 
-MufVec4 mufVec4Hadamard(MufVec4 v1, MufVec4 v2) {
-    return (MufVec4) { v1.x * v2.x, v1.y * v2.y, v1.z * v2.z, v1.w * v2.w };
-}
-
 muf_f32 mufVec2Length2(MufVec2 v) {
     return v.x * v.x + v.y * v.y;
 }
@@ -697,41 +738,16 @@ MufMat3 mufMat3Mul(const MufMat3 *m1, const MufMat3 *m2) {
     );
 }
 
-MufMat4 mufMat4Mul(const MufMat4 *m1, const MufMat4 *m2) {
+MufMat4 mufMat4MulRef(const MufMat4 *m1, const MufMat4 *m2) {
+    const muf_f32 (*a)[4] = m1->values;
     const muf_f32 (*b)[4] = m2->values;
-
-    const MufVec4 a0 = m1->columns.v0;
-    const MufVec4 a1 = m1->columns.v1;
-    const MufVec4 a2 = m1->columns.v2;
-    const MufVec4 a3 = m1->columns.v3;
-
-    MufVec4 v0 = mufCreateVec4(
-        a0.x * b[0][0] + a1.x * b[0][1] * a2.x * b[0][2] * a3.x * b[0][3],
-        a0.y * b[0][0] + a1.y * b[0][1] * a2.y * b[0][2] * a3.y * b[0][3],
-        a0.z * b[0][0] + a1.z * b[0][1] * a2.z * b[0][2] * a3.z * b[0][3],
-        a0.w * b[0][0] + a1.w * b[0][1] * a2.w * b[0][2] * a3.w * b[0][3]
-    );
-    MufVec4 v1 = mufCreateVec4(
-        a0.x * b[1][0] + a1.x * b[1][1] * a2.x * b[1][2] * a3.x * b[1][3],
-        a0.y * b[1][0] + a1.y * b[1][1] * a2.y * b[1][2] * a3.y * b[1][3],
-        a0.z * b[1][0] + a1.z * b[1][1] * a2.z * b[1][2] * a3.z * b[1][3],
-        a0.w * b[1][0] + a1.w * b[1][1] * a2.w * b[1][2] * a3.w * b[1][3]
-    );
-    MufVec4 v2 = mufCreateVec4(
-        a0.x * b[2][0] + a1.x * b[2][1] * a2.x * b[2][2] * a3.x * b[2][3],
-        a0.y * b[2][0] + a1.y * b[2][1] * a2.y * b[2][2] * a3.y * b[2][3],
-        a0.z * b[2][0] + a1.z * b[2][1] * a2.z * b[2][2] * a3.z * b[2][3],
-        a0.w * b[2][0] + a1.w * b[2][1] * a2.w * b[2][2] * a3.w * b[2][3]
-    );
-    MufVec4 v3 = mufCreateVec4(
-        a0.x * b[3][0] + a1.x * b[3][1] * a2.x * b[3][2] * a3.x * b[3][3],
-        a0.y * b[3][0] + a1.y * b[3][1] * a2.y * b[3][2] * a3.y * b[3][3],
-        a0.z * b[3][0] + a1.z * b[3][1] * a2.z * b[3][2] * a3.z * b[3][3],
-        a0.w * b[3][0] + a1.w * b[3][1] * a2.w * b[3][2] * a3.w * b[3][3]
-    );
-
     MufMat4 result;
-    mufMat4Loadv(&result, v0, v1, v2, v3);
+    muf_f32 (*r)[4] = result.values;
+
+    for (muf_u32 j = 0; j < 4; ++j) {
+        for (muf_u32 i = 0; i < 4; ++i)
+            r[j][i] = a[0][i] * b[j][0] + a[1][i] * b[j][1] + a[2][i] * b[j][2] + a[3][i] * b[j][3];
+    }
     return result;
 }
 
@@ -792,7 +808,7 @@ MufMat3 mufMat3Inverse(const MufMat3 *mat) {
     return mufMat3Scale(&result, det);
 }
 
-MufMat4 mufMat4Inverse(const MufMat4 *mat) {
+MufMat4 mufMat4InverseRef(const MufMat4 *mat) {
     MufMat4 result;
     muf_f32 (*r)[4] = result.values;
     const muf_f32 (*m)[4] = mat->values;
@@ -932,7 +948,7 @@ MufMat3 mufMat3Transpose(const MufMat3 *mat) {
     );
 }
 
-MufMat4 mufMat4Transpose(const MufMat4 *mat) {
+MufMat4 mufMat4TransposeRef(const MufMat4 *mat) {
     const muf_f32 (*m)[4] = mat->values;
 
     return mufCreateMat4(
@@ -958,7 +974,7 @@ muf_f32 mufMat3Determinant(const MufMat3 *mat) {
     );
 }
 
-muf_f32 mufMat4Determinant(const MufMat4 *mat) {
+muf_f32 mufMat4DeterminantRef(const MufMat4 *mat) {
     const muf_f32 (*m)[4] = mat->values;
 
     muf_f32 f0 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
@@ -971,7 +987,7 @@ muf_f32 mufMat4Determinant(const MufMat4 *mat) {
     MufVec4 vec = mufCreateVec4(m[1][1] * f0 - m[1][2] * f1 + m[1][3] * f2,
         -(m[1][0] * f0 - m[1][2] * f3 + m[1][3] * f4),
         m[1][0] * f1 - m[1][1] * f3 + m[1][3] * f5,
-        m[1][0] * f2 - m[1][1] * f4 + m[1][2] * f5
+        -(m[1][0] * f2 - m[1][1] * f4 + m[1][2] * f5)
     );
     const muf_f32 *v = &vec.x;
 
@@ -998,7 +1014,7 @@ MufVec3 mufVec3MulMat(MufVec3 vec, const MufMat3 *mat) {
     );
 }
 
-MufVec4 mufVec4MulMat(MufVec4 vec, const MufMat4 *mat) {
+MufVec4 mufVec4MulMatRef(MufVec4 vec, const MufMat4 *mat) {
     const muf_f32 (*m)[4] = mat->values;
     const muf_f32 *v = &vec.x;
     return mufCreateVec4(
@@ -1028,7 +1044,7 @@ MufVec3 mufMat3MulVec(const MufMat3 *mat, MufVec3 vec) {
     );
 }
 
-MufVec4 mufMat4MulVec(const MufMat4 *mat, MufVec4 vec) {
+MufVec4 mufMat4MulVecRef(const MufMat4 *mat, MufVec4 vec) {
     const muf_f32 (*m)[4] = mat->values;
     const muf_f32 *v = &vec.x;
     return mufCreateVec4(
@@ -1210,11 +1226,35 @@ MufMat4 *mufMirror(MufMat4 *base, MufVec3 axis) {
     return mufScaleAxis(base, axis, -1.0F);
 }
 
-MufVec3 mufVec3Transform(MufVec3 vec, const MufMat4 *transform) {
-    MufVec4 result = mufMat4MulVec(transform, (MufVec4) { vec.x, vec.y, vec.z, 0.0F });
-    return mufCreateVec3(result.x, result.y, result.z);
+MufQuat4 mufQuat4FromAxisAngle(MufVec3 axis, muf_f32 rotation) {
+    muf_f32 s = sinf(rotation * 0.5F);
+    return mufCreateQuat4(axis.x * s, axis.y * s, axis.z * s, cosf(rotation * 0.5F));
+}
+
+MufMat4 mufQuat4ToMat4(MufQuat4 q) {
+    muf_f32 xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    muf_f32 xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    muf_f32 wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+    return mufCreateMat4(
+        1.0F - 2.0F * (yy + zz), 2.0F * (xy + wz), 2.0F * (xz - wy), 0.0F,
+        2.0F * (xy - wz), 1.0F - 2.0F * (xx + zz), 2.0F * (yz + wx), 0.0F,
+        2.0F * (xz + wy), 2.0F * (yz - wx), 1.0F - 2.0F * (xx + yy), 0.0F,
+        0.0F, 0.0F, 0.0F, 1.0F
+    );
+}
+
+MufQuat4 mufQuat4MulRef(MufQuat4 q1, MufQuat4 q2) {
+    return mufCreateQuat4(
+        q1.w * q2.x + q1.x * q2.w + q1.y * q2.z - q1.z * q2.y,
+        q1.w * q2.y - q1.x * q2.z + q1.y * q2.w + q1.z * q2.x,
+        q1.w * q2.z + q1.x * q2.y - q1.y * q2.x + q1.z * q2.w,
+        q1.w * q2.w - q1.x * q2.x - q1.y * q2.y - q1.z * q2.z
+    );
 }
 
-MufVec4 mufVec4Transform(MufVec4 vec, const MufMat4 *transform) {
-    return mufMat4MulVec(transform, vec);
-}
\ No newline at end of file
+MufVec3 mufQuat4RotateVec3Ref(MufQuat4 q, MufVec3 v) {
+    MufVec3 u = mufCreateVec3(q.x, q.y, q.z);
+    MufVec3 t = mufVec3Mul(mufVec3Cross(u, v), 2.0F);
+    return mufVec3Add(mufVec3Add(v, mufVec3Mul(t, q.w)), mufVec3Cross(u, t));
+}
@@ -0,0 +1,404 @@
+#include "muffin_core/math_batch.h"
+#include "muffin_core/cpu.h"
+#include "muffin_core/simd.h"
+#include "muffin_core/sync.h"
+
+#include <math.h>
+
+#if defined(MUF_COMPILER_GCC) && !defined(__clang__)
+/* GCC contracts a * b + c into an FMA as soon as a target has one, the variants would stop agreeing */
+#   pragma GCC optimize("fp-contract=off")
+#endif
+
+typedef struct _MufMathBatchKernels_s {
+    MufCpuFeatureFlags required;
+    const char *target;
+    /* a is read at a[i * aStep], 0 shares the first matrix */
+    void (*mat4Mul)(const MufMat4 *a, muf_usize aStep, const MufMat4 *b, MufMat4 *out, muf_usize count);
+    void (*vec3Transform)(const MufMat4 *transform, const MufVec3 *vecs, MufVec3 *out, muf_usize count, muf_f32 w);
+    void (*vec3x8TransformPoint)(const MufMat4 *transform, const MufVec3x8 *blocks, MufVec3x8 *out,
+        muf_usize blockCount);
+    void (*aabb3Transform)(const MufMat4 *transforms, const MufAABB3 *bounds, MufAABB3 *out, muf_usize count);
+} _MufMathBatchKernels;
+
+/* Baseline, the inline kernels of math_simd.h at the instruction set of the build */
+
+MUF_INTERNAL void _mufMat4MulBatchBaseline(const MufMat4 *a, muf_usize aStep, const MufMat4 *b, MufMat4 *out,
+    muf_usize count) {
+    for (muf_usize i = 0; i < count; ++i)
+        out[i] = mufMat4Mul(&a[i * aStep], &b[i]);
+}
+
+MUF_INTERNAL void _mufVec3TransformBatchBaseline(const MufMat4 *transform, const MufVec3 *vecs, MufVec3 *out,
+    muf_usize count, muf_f32 w) {
+    const muf_f32 (*m)[4] = transform->values;
+    muf_f32 tx = m[3][0] * w, ty = m[3][1] * w, tz = m[3][2] * w;
+    for (muf_usize i = 0; i < count; ++i) {
+        MufVec3 v = vecs[i];
+        out[i].x = m[0][0] * v.x + m[1][0] * v.y + m[2][0] * v.z + tx;
+        out[i].y = m[0][1] * v.x + m[1][1] * v.y + m[2][1] * v.z + ty;
+        out[i].z = m[0][2] * v.x + m[1][2] * v.y + m[2][2] * v.z + tz;
+    }
+}
+
+MUF_INTERNAL void _mufVec3x8TransformPointBatchBaseline(const MufMat4 *transform, const MufVec3x8 *blocks, MufVec3x8 *out,
+    muf_usize blockCount) {
+    const muf_f32 (*m)[4] = transform->values;
+    for (muf_usize i = 0; i < blockCount; ++i) {
+        for (muf_usize j = 0; j < 8; ++j) {
+            muf_f32 x = blocks[i].x[j], y = blocks[i].y[j], z = blocks[i].z[j];
+            out[i].x[j] = m[0][0] * x + m[1][0] * y + m[2][0] * z + m[3][0];
+            out[i].y[j] = m[0][1] * x + m[1][1] * y + m[2][1] * z + m[3][1];
+            out[i].z[j] = m[0][2] * x + m[1][2] * y + m[2][2] * z + m[3][2];
+        }
+    }
+}
+
+MUF_INTERNAL void _mufAABB3TransformBatchBaseline(const MufMat4 *transforms, const MufAABB3 *bounds, MufAABB3 *out,
+    muf_usize count) {
+    for (muf_usize i = 0; i < count; ++i) {
+        const muf_f32 (*m)[4] = transforms[i].values;
+        const muf_f32 *min = &bounds[i].min.x;
+        const muf_f32 *max = &bounds[i].max.x;
+        muf_f32 c[3], e[3];
+        for (muf_u32 k = 0; k < 3; ++k) {
+            c[k] = (min[k] + max[k]) * 0.5F;
+            e[k] = (max[k] - min[k]) * 0.5F;
+        }
+
+        muf_f32 *outMin = &out[i].min.x;
+        muf_f32 *outMax = &out[i].max.x;
+        for (muf_u32 r = 0; r < 3; ++r) {
+            muf_f32 center = m[0][r] * c[0] + m[1][r] * c[1] + m[2][r] * c[2] + m[3][r];
+            muf_f32 extent = fabsf(m[0][r]) * e[0] + fabsf(m[1][r]) * e[1] + fabsf(m[2][r]) * e[2];
+            outMin[r] = center - extent;
+            outMax[r] = center + extent;
+        }
+    }
+}
+
+static const _MufMathBatchKernels _mufMathBatchBaseline = {
+    MUF_CPU_FEATURE_NONE,
+    "baseline",
+    _mufMat4MulBatchBaseline,
+    _mufVec3TransformBatchBaseline,
+    _mufVec3x8TransformPointBatchBaseline,
+    _mufAABB3TransformBatchBaseline
+};
+
+#if defined(MUF_SIMD_MULTI_TARGET)
+
+/* AVX, two columns or two boxes per 256-bit register */
+
+MUF_SIMD_TARGET("avx")
+MUF_INTERNAL void _mufMat4MulBatchAVX(const MufMat4 *a, muf_usize aStep, const MufMat4 *b, MufMat4 *out,
+    muf_usize count) {
+    for (muf_usize i = 0; i < count; ++i) {
+        const MufMat4 *m = &a[i * aStep];
+        __m256 a0 = _mm256_broadcast_ps((const __m128 *) m->values[0]);
+        __m256 a1 = _mm256_broadcast_ps((const __m128 *) m->values[1]);
+        __m256 a2 = _mm256_broadcast_ps((const __m128 *) m->values[2]);
+        __m256 a3 = _mm256_broadcast_ps((const __m128 *) m->values[3]);
+        __m256 b01 = _mm256_loadu_ps(b[i].values[0]);
+        __m256 b23 = _mm256_loadu_ps(b[i].values[2]);
+
+        __m256 r01 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(0, 0, 0, 0)));
+        __m256 r23 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(0, 0, 0, 0)));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(a1, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(1, 1, 1, 1))));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(a1, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(1, 1, 1, 1))));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(a2, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(2, 2, 2, 2))));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(a2, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(2, 2, 2, 2))));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(a3, _mm256_shuffle_ps(b01, b01, _MM_SHUFFLE(3, 3, 3, 3))));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(a3, _mm256_shuffle_ps(b23, b23, _MM_SHUFFLE(3, 3, 3, 3))));
+        _mm256_storeu_ps(out[i].values[0], r01);
+        _mm256_storeu_ps(out[i].values[2], r23);
+    }
+}
+
+MUF_SIMD_TARGET("avx")
+MUF_INTERNAL MUF_INLINE void _mufTransformPoint8AVX(const MufMat4 *transform, __m256 tx, __m256 ty, __m256 tz,
+    __m256 *x, __m256 *y, __m256 *z) {
+    const muf_f32 (*m)[4] = transform->values;
+    __m256 rx = _mm256_mul_ps(_mm256_set1_ps(m[0][0]), *x);
+    __m256 ry = _mm256_mul_ps(_mm256_set1_ps(m[0][1]), *x);
+    __m256 rz = _mm256_mul_ps(_mm256_set1_ps(m[0][2]), *x);
+    rx = _mm256_add_ps(rx, _mm256_mul_ps(_mm256_set1_ps(m[1][0]), *y));
+    ry = _mm256_add_ps(ry, _mm256_mul_ps(_mm256_set1_ps(m[1][1]), *y));
+    rz = _mm256_add_ps(rz, _mm256_mul_ps(_mm256_set1_ps(m[1][2]), *y));
+    rx = _mm256_add_ps(rx, _mm256_mul_ps(_mm256_set1_ps(m[2][0]), *z));
+    ry = _mm256_add_ps(ry, _mm256_mul_ps(_mm256_set1_ps(m[2][1]), *z));
+    rz = _mm256_add_ps(rz, _mm256_mul_ps(_mm256_set1_ps(m[2][2]), *z));
+    *x = _mm256_add_ps(rx, tx);
+    *y = _mm256_add_ps(ry, ty);
+    *z = _mm256_add_ps(rz, tz);
+}
+
+MUF_SIMD_TARGET("avx")
+MUF_INTERNAL void _mufVec3TransformBatchAVX(const MufMat4 *transform, const MufVec3 *vecs, MufVec3 *out,
+    muf_usize count, muf_f32 w) {
+    const muf_f32 (*m)[4] = transform->values;
+    __m256 tx = _mm256_set1_ps(m[3][0] * w);
+    __m256 ty = _mm256_set1_ps(m[3][1] * w);
+    __m256 tz = _mm256_set1_ps(m[3][2] * w);
+
+    /* Eight vectors are 24 floats, deinterleaved into x, y and z with the lanes in the same shuffled order */
+    muf_usize i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const muf_f32 *src = &vecs[i].x;
+        __m256 m03 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src)), _mm_loadu_ps(src + 12), 1);
+        __m256 m14 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src + 4)), _mm_loadu_ps(src + 16), 1);
+        __m256 m25 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src + 8)), _mm_loadu_ps(src + 20), 1);
+        __m256 xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+        __m256 yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+        __m256 x = _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0));
+        __m256 y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+        __m256 z = _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1));
+
+        _mufTransformPoint8AVX(transform, tx, ty, tz, &x, &y, &z);
+
+        __m256 rxy = _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 ryz = _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+        __m256 rzx = _mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+        __m256 r03 = _mm256_shuffle_ps(rxy, rzx, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 r14 = _mm256_shuffle_ps(ryz, rxy, _MM_SHUFFLE(3, 1, 2, 0));
+        __m256 r25 = _mm256_shuffle_ps(rzx, ryz, _MM_SHUFFLE(3, 1, 3, 1));
+        muf_f32 *dst = &out[i].x;
+        _mm_storeu_ps(dst, _mm256_castps256_ps128(r03));
+        _mm_storeu_ps(dst + 4, _mm256_castps256_ps128(r14));
+        _mm_storeu_ps(dst + 8, _mm256_castps256_ps128(r25));
+        _mm_storeu_ps(dst + 12, _mm256_extractf128_ps(r03, 1));
+        _mm_storeu_ps(dst + 16, _mm256_extractf128_ps(r14, 1));
+        _mm_storeu_ps(dst + 20, _mm256_extractf128_ps(r25, 1));
+    }
+    _mufVec3TransformBatchBaseline(transform, vecs + i, out + i, count - i, w);
+}
+
+MUF_SIMD_TARGET("avx")
+MUF_INTERNAL void _mufVec3x8TransformPointBatchAVX(const MufMat4 *transform, const MufVec3x8 *blocks, MufVec3x8 *out,
+    muf_usize blockCount) {
+    const muf_f32 (*m)[4] = transform->values;
+    __m256 tx = _mm256_set1_ps(m[3][0]);
+    __m256 ty = _mm256_set1_ps(m[3][1]);
+    __m256 tz = _mm256_set1_ps(m[3][2]);
+    for (muf_usize i = 0; i < blockCount; ++i) {
+        __m256 x = _mm256_loadu_ps(blocks[i].x);
+        __m256 y = _mm256_loadu_ps(blocks[i].y);
+        __m256 z = _mm256_loadu_ps(blocks[i].z);
+        _mufTransformPoint8AVX(transform, tx, ty, tz, &x, &y, &z);
+        _mm256_storeu_ps(out[i].x, x);
+        _mm256_storeu_ps(out[i].y, y);
+        _mm256_storeu_ps(out[i].z, z);
+    }
+}
+
+/* A box is six floats, the loads and stores of its two halves overlap on min.z and max.x to stay in bounds */
+
+MUF_INTERNAL MUF_INLINE void _mufAABB3LoadSSE(const MufAABB3 *box, __m128 *min, __m128 *max) {
+    __m128 high = _mm_loadu_ps(&box->min.z);
+    *min = _mm_loadu_ps(&box->min.x);
+    *max = _mm_shuffle_ps(high, high, _MM_SHUFFLE(3, 3, 2, 1));
+}
+
+MUF_INTERNAL MUF_INLINE void _mufAABB3StoreSSE(MufAABB3 *box, __m128 min, __m128 max) {
+    __m128 zx = _mm_shuffle_ps(min, max, _MM_SHUFFLE(0, 0, 2, 2));
+    _mm_storeu_ps(&box->min.x, _mm_shuffle_ps(min, zx, _MM_SHUFFLE(2, 0, 1, 0)));
+    _mm_storeu_ps(&box->min.z, _mm_shuffle_ps(zx, max, _MM_SHUFFLE(2, 1, 2, 0)));
+}
+
+#define _mufLoad2x128(_low, _high) _mm256_insertf128_ps(_mm256_castps128_ps256(_low), (_high), 1)
+
+MUF_SIMD_TARGET("avx")
+MUF_INTERNAL void _mufAABB3TransformBatchAVX(const MufMat4 *transforms, const MufAABB3 *bounds, MufAABB3 *out,
+    muf_usize count) {
+    const __m256 half = _mm256_set1_ps(0.5F);
+    const __m256 signMask = _mm256_set1_ps(-0.0F);
+    muf_usize i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const MufMat4 *m0 = &transforms[i];
+        const MufMat4 *m1 = &transforms[i + 1];
+        __m256 c0 = _mufLoad2x128(_mm_load_ps(m0->values[0]), _mm_load_ps(m1->values[0]));
+        __m256 c1 = _mufLoad2x128(_mm_load_ps(m0->values[1]), _mm_load_ps(m1->values[1]));
+        __m256 c2 = _mufLoad2x128(_mm_load_ps(m0->values[2]), _mm_load_ps(m1->values[2]));
+        __m256 c3 = _mufLoad2x128(_mm_load_ps(m0->values[3]), _mm_load_ps(m1->values[3]));
+
+        __m128 min0, max0, min1, max1;
+        _mufAABB3LoadSSE(&bounds[i], &min0, &max0);
+        _mufAABB3LoadSSE(&bounds[i + 1], &min1, &max1);
+        __m256 min = _mufLoad2x128(min0, min1);
+        __m256 max = _mufLoad2x128(max0, max1);
+        __m256 center = _mm256_mul_ps(_mm256_add_ps(min, max), half);
+        __m256 extent = _mm256_mul_ps(_mm256_sub_ps(max, min), half);
+
+        __m256 cx = _mm256_shuffle_ps(center, center, _MM_SHUFFLE(0, 0, 0, 0));
+        __m256 cy = _mm256_shuffle_ps(center, center, _MM_SHUFFLE(1, 1, 1, 1));
+        __m256 cz = _mm256_shuffle_ps(center, center, _MM_SHUFFLE(2, 2, 2, 2));
+        __m256 ex = _mm256_shuffle_ps(extent, extent, _MM_SHUFFLE(0, 0, 0, 0));
+        __m256 ey = _mm256_shuffle_ps(extent, extent, _MM_SHUFFLE(1, 1, 1, 1));
+        __m256 ez = _mm256_shuffle_ps(extent, extent, _MM_SHUFFLE(2, 2, 2, 2));
+
+        __m256 c = _mm256_mul_ps(c0, cx);
+        c = _mm256_add_ps(c, _mm256_mul_ps(c1, cy));
+        c = _mm256_add_ps(c, _mm256_mul_ps(c2, cz));
+        c = _mm256_add_ps(c, c3);
+        __m256 e = _mm256_mul_ps(_mm256_andnot_ps(signMask, c0), ex);
+        e = _mm256_add_ps(e, _mm256_mul_ps(_mm256_andnot_ps(signMask, c1), ey));
+        e = _mm256_add_ps(e, _mm256_mul_ps(_mm256_andnot_ps(signMask, c2), ez));
+
+        min = _mm256_sub_ps(c, e);
+        max = _mm256_add_ps(c, e);
+        _mufAABB3StoreSSE(&out[i], _mm256_castps256_ps128(min), _mm256_castps256_ps128(max));
+        _mufAABB3StoreSSE(&out[i + 1], _mm256_extractf128_ps(min, 1), _mm256_extractf128_ps(max, 1));
+    }
+    _mufAABB3TransformBatchBaseline(transforms + i, bounds + i, out + i, count - i);
+}
+
+static const _MufMathBatchKernels _mufMathBatchAVX = {
+    MUF_CPU_FEATURE_AVX,
+    "avx",
+    _mufMat4MulBatchAVX,
+    _mufVec3TransformBatchAVX,
+    _mufVec3x8TransformPointBatchAVX,
+    _mufAABB3TransformBatchAVX
+};
+
+/* AVX-512F, a whole matrix or two blocks per 512-bit register, the AoS kernels keep the AVX versions */
+
+MUF_SIMD_TARGET("avx512f")
+MUF_INTERNAL void _mufMat4MulBatchAVX512(const MufMat4 *a, muf_usize aStep, const MufMat4 *b, MufMat4 *out,
+    muf_usize count) {
+    for (muf_usize i = 0; i < count; ++i) {
+        const MufMat4 *m = &a[i * aStep];
+        __m512 a0 = _mm512_broadcast_f32x4(_mm_load_ps(m->values[0]));
+        __m512 a1 = _mm512_broadcast_f32x4(_mm_load_ps(m->values[1]));
+        __m512 a2 = _mm512_broadcast_f32x4(_mm_load_ps(m->values[2]));
+        __m512 a3 = _mm512_broadcast_f32x4(_mm_load_ps(m->values[3]));
+        __m512 columns = _mm512_loadu_ps(b[i].values);
+
+        __m512 r = _mm512_mul_ps(a0, _mm512_permute_ps(columns, _MM_SHUFFLE(0, 0, 0, 0)));
+        r = _mm512_add_ps(r, _mm512_mul_ps(a1, _mm512_permute_ps(columns, _MM_SHUFFLE(1, 1, 1, 1))));
+        r = _mm512_add_ps(r, _mm512_mul_ps(a2, _mm512_permute_ps(columns, _MM_SHUFFLE(2, 2, 2, 2))));
+        r = _mm512_add_ps(r, _mm512_mul_ps(a3, _mm512_permute_ps(columns, _MM_SHUFFLE(3, 3, 3, 3))));
+        _mm512_storeu_ps(out[i].values, r);
+    }
+}
+
+#define _mufLoad2x256(_low, _high) _mm512_castpd_ps(_mm512_insertf64x4( \
+    _mm512_castpd256_pd512(_mm256_castps_pd(_low)), _mm256_castps_pd(_high), 1))
+#define _mufExtractHigh256(_v) _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(_v), 1))
+
+MUF_SIMD_TARGET("avx512f")
+MUF_INTERNAL void _mufVec3x8TransformPointBatchAVX512(const MufMat4 *transform, const MufVec3x8 *blocks, MufVec3x8 *out,
+    muf_usize blockCount) {
+    const muf_f32 (*m)[4] = transform->values;
+    muf_usize i = 0;
+    for (; i + 2 <= blockCount; i += 2) {
+        __m512 x = _mufLoad2x256(_mm256_loadu_ps(blocks[i].x), _mm256_loadu_ps(blocks[i + 1].x));
+        __m512 y = _mufLoad2x256(_mm256_loadu_ps(blocks[i].y), _mm256_loadu_ps(blocks[i + 1].y));
+        __m512 z = _mufLoad2x256(_mm256_loadu_ps(blocks[i].z), _mm256_loadu_ps(blocks[i + 1].z));
+
+        __m512 rx = _mm512_mul_ps(_mm512_set1_ps(m[0][0]), x);
+        __m512 ry = _mm512_mul_ps(_mm512_set1_ps(m[0][1]), x);
+        __m512 rz = _mm512_mul_ps(_mm512_set1_ps(m[0][2]), x);
+        rx = _mm512_add_ps(rx, _mm512_mul_ps(_mm512_set1_ps(m[1][0]), y));
+        ry = _mm512_add_ps(ry, _mm512_mul_ps(_mm512_set1_ps(m[1][1]), y));
+        rz = _mm512_add_ps(rz, _mm512_mul_ps(_mm512_set1_ps(m[1][2]), y));
+        rx = _mm512_add_ps(rx, _mm512_mul_ps(_mm512_set1_ps(m[2][0]), z));
+        ry = _mm512_add_ps(ry, _mm512_mul_ps(_mm512_set1_ps(m[2][1]), z));
+        rz = _mm512_add_ps(rz, _mm512_mul_ps(_mm512_set1_ps(m[2][2]), z));
+        rx = _mm512_add_ps(rx, _mm512_set1_ps(m[3][0]));
+        ry = _mm512_add_ps(ry, _mm512_set1_ps(m[3][1]));
+        rz = _mm512_add_ps(rz, _mm512_set1_ps(m[3][2]));
+
+        _mm256_storeu_ps(out[i].x, _mm512_castps512_ps256(rx));
+        _mm256_storeu_ps(out[i].y, _mm512_castps512_ps256(ry));
+        _mm256_storeu_ps(out[i].z, _mm512_castps512_ps256(rz));
+        _mm256_storeu_ps(out[i + 1].x, _mufExtractHigh256(rx));
+        _mm256_storeu_ps(out[i + 1].y, _mufExtractHigh256(ry));
+        _mm256_storeu_ps(out[i + 1].z, _mufExtractHigh256(rz));
+    }
+    _mufVec3x8TransformPointBatchAVX(transform, blocks + i, out + i, blockCount - i);
+}
+
+static const _MufMathBatchKernels _mufMathBatchAVX512 = {
+    MUF_CPU_FEATURE_AVX512F,
+    "avx512f",
+    _mufMat4MulBatchAVX512,
+    _mufVec3TransformBatchAVX,
+    _mufVec3x8TransformPointBatchAVX512,
+    _mufAABB3TransformBatchAVX
+};
+
+#endif
+
+/* From the widest, the baseline requires nothing and ends the list */
+static const _MufMathBatchKernels *const _mufMathBatchVariants[] = {
+#if defined(MUF_SIMD_MULTI_TARGET)
+    &_mufMathBatchAVX512,
+    &_mufMathBatchAVX,
+#endif
+    &_mufMathBatchBaseline
+};
+
+static const _MufMathBatchKernels *_mufMathBatchKernels = NULL;
+
+MUF_INTERNAL const _MufMathBatchKernels *_mufGetMathBatchKernels(void) {
+    /* Racing first calls select the same table, a plain atomic store is enough */
+    const _MufMathBatchKernels *kernels = mufAtomicLoad(&_mufMathBatchKernels);
+    if (kernels != NULL)
+        return kernels;
+
+    for (muf_usize i = 0; i < MUF_COUNTOF(_mufMathBatchVariants); ++i) {
+        kernels = _mufMathBatchVariants[i];
+        if (mufHasCpuFeatures(kernels->required))
+            break;
+    }
+    mufAtomicStore(&_mufMathBatchKernels, kernels);
+    return kernels;
+}
+
+const char *mufGetMathBatchTarget(void) {
+    return _mufGetMathBatchKernels()->target;
+}
+
+void mufMat4MulBatch(const MufMat4 *a, const MufMat4 *b, MufMat4 *out, muf_usize count) {
+    _mufGetMathBatchKernels()->mat4Mul(a, 1, b, out, count);
+}
+
+void mufMat4MulSharedBatch(const MufMat4 *mat, const MufMat4 *b, MufMat4 *out, muf_usize count) {
+    _mufGetMathBatchKernels()->mat4Mul(mat, 0, b, out, count);
+}
+
+void mufVec3TransformBatch(const MufMat4 *transform, const MufVec3 *vecs, MufVec3 *out, muf_usize count) {
+    _mufGetMathBatchKernels()->vec3Transform(transform, vecs, out, count, 0.0F);
+}
+
+void mufVec3TransformPointBatch(const MufMat4 *transform, const MufVec3 *vecs, MufVec3 *out, muf_usize count) {
+    _mufGetMathBatchKernels()->vec3Transform(transform, vecs, out, count, 1.0F);
+}
+
+void mufVec3x8TransformPointBatch(const MufMat4 *transform, const MufVec3x8 *blocks, MufVec3x8 *out,
+    muf_usize blockCount) {
+    _mufGetMathBatchKernels()->vec3x8TransformPoint(transform, blocks, out, blockCount);
+}
+
+void mufVec3x8Pack(const MufVec3 *vecs, muf_usize count, MufVec3x8 *blocks) {
+    if (count == 0)
+        return;
+
+    muf_usize blockCount = (count + 7) / 8;
+    for (muf_usize i = 0; i < blockCount * 8; ++i) {
+        MufVec3 v = vecs[mufMin(i, count - 1)];
+        blocks[i / 8].x[i % 8] = v.x;
+        blocks[i / 8].y[i % 8] = v.y;
+        blocks[i / 8].z[i % 8] = v.z;
+    }
+}
+
+void mufVec3x8Unpack(const MufVec3x8 *blocks, muf_usize count, MufVec3 *vecs) {
+    for (muf_usize i = 0; i < count; ++i)
+        vecs[i] = mufCreateVec3(blocks[i / 8].x[i % 8], blocks[i / 8].y[i % 8], blocks[i / 8].z[i % 8]);
+}
+
+void mufAABB3TransformBatch(const MufMat4 *transforms, const MufAABB3 *bounds, MufAABB3 *out, muf_usize count) {
+    _mufGetMathBatchKernels()->aabb3Transform(transforms, bounds, out, count);
+}
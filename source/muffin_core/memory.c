@@ -2,6 +2,313 @@
 
 #include <stdlib.h>
 
+#include "muffin_core/sync.h"
+#include "muffin_core/timer.h"
+
+static const muf_char *_MUF_MEMORY_TAG_STRS[] = {
+    "General",
+    "CoreContainers",
+    "RenderBackend",
+    "Image",
+    "Log",
+    "Module"
+};
+
+const muf_char *mufMemoryTagGetName(MufMemoryTag tag) {
+    return (muf_index) tag < _MUF_MEMORY_TAG_COUNT_ ? _MUF_MEMORY_TAG_STRS[tag] : "Unknown";
+}
+
+#if defined(MUF_ENABLE_MEMORY_TRACKING)
+
+#define MUF_MEMORY_HEADER_MAGIC         0x4D46U
+#define MUF_MEMORY_CALL_SITE_CAPACITY   4096
+#define MUF_MEMORY_REPORT_CALL_SITES    16
+
+/* Placed in front of every tracked block, sized to keep the user pointer 16-byte aligned */
+typedef union _MufMemoryHeader_u {
+    struct {
+        muf_usize   size;
+        muf_u32     siteIndex;
+        muf_u16     tag;
+        muf_u16     magic;
+    } info;
+    muf_byte _padding[32];
+} _MufMemoryHeader;
+
+typedef struct _MufMemoryTagCounters_s {
+    volatile muf_usize liveBytes;
+    volatile muf_usize peakBytes;
+    volatile muf_usize liveCount;
+    volatile muf_usize totalAllocCount;
+    volatile muf_usize totalFreeCount;
+    volatile muf_usize totalAllocBytes;
+    muf_usize          reportedAllocCount;
+    muf_usize          reportedAllocBytes;
+} _MufMemoryTagCounters;
+
+typedef struct _MufMemoryCallSite_s {
+    const muf_char  *file;
+    muf_u32         line;
+    muf_u16         tag;
+    muf_usize       liveBytes;
+    muf_usize       liveCount;
+} _MufMemoryCallSite;
+
+typedef struct _MufMemoryTracker_s {
+    _MufMemoryTagCounters   tags[_MUF_MEMORY_TAG_COUNT_];
+    muf_bool                callSitesEnabled;
+    MufSpinLock             callSiteLock;
+    _MufMemoryCallSite      *callSites;
+    muf_bool                reportAtExit;
+    volatile muf_u32        exitHandlerInstalled;
+    muf_u64                 lastReportNs;
+} _MufMemoryTracker;
+
+static _MufMemoryTracker _mufMemoryTracker[1] = {{ .reportAtExit = MUF_TRUE }};
+
+#define _MUF_MEMORY_NO_SITE ((muf_u32) -1)
+
+static void _mufMemoryReportAtExit(void) {
+    if (_mufMemoryTracker->reportAtExit)
+        mufMemoryDumpReport(stderr);
+}
+
+MUF_INTERNAL void _mufMemoryInstallExitHandler(void) {
+    if (mufAtomicLoadRelaxed(&_mufMemoryTracker->exitHandlerInstalled) != 0)
+        return;
+    if (mufAtomicExchange(&_mufMemoryTracker->exitHandlerInstalled, 1U) == 0) {
+        _mufMemoryTracker->lastReportNs = mufTimerGetNanoseconds();
+        atexit(_mufMemoryReportAtExit);
+    }
+}
+
+/* Open addressing over (file, line), entries are never removed */
+MUF_INTERNAL muf_u32 _mufMemoryFindCallSite(const muf_char *file, muf_u32 line, MufMemoryTag tag) {
+    muf_usize hash = ((muf_usize) file >> 4) * 31U + line;
+    hash ^= hash >> 13;
+    muf_u32 index = (muf_u32) (hash & (MUF_MEMORY_CALL_SITE_CAPACITY - 1));
+
+    for (muf_u32 probe = 0; probe < MUF_MEMORY_CALL_SITE_CAPACITY; ++probe) {
+        _MufMemoryCallSite *site = &_mufMemoryTracker->callSites[index];
+        if (site->file == NULL) {
+            site->file = file;
+            site->line = line;
+            site->tag = (muf_u16) tag;
+            return index;
+        }
+        if (site->file == file && site->line == line)
+            return index;
+        index = (index + 1) & (MUF_MEMORY_CALL_SITE_CAPACITY - 1);
+    }
+    return _MUF_MEMORY_NO_SITE;
+}
+
+MUF_INTERNAL void _mufMemoryRecordAlloc(_MufMemoryHeader *header, muf_usize size, MufMemoryTag tag, const muf_char *file, muf_u32 line) {
+    _MufMemoryTagCounters *c = &_mufMemoryTracker->tags[tag];
+    header->info.size = size;
+    header->info.tag = (muf_u16) tag;
+    header->info.magic = MUF_MEMORY_HEADER_MAGIC;
+    header->info.siteIndex = _MUF_MEMORY_NO_SITE;
+
+    muf_usize live = mufAtomicFetchAdd(&c->liveBytes, size) + size;
+    mufAtomicFetchAdd(&c->liveCount, 1);
+    mufAtomicFetchAdd(&c->totalAllocCount, 1);
+    mufAtomicFetchAdd(&c->totalAllocBytes, size);
+
+    muf_usize peak = mufAtomicLoadRelaxed(&c->peakBytes);
+    while (live > peak && !mufAtomicCompareExchange(&c->peakBytes, &peak, live));
+
+    if (_mufMemoryTracker->callSitesEnabled) {
+        mufSpinLockAcquire(&_mufMemoryTracker->callSiteLock);
+        muf_u32 siteIndex = _mufMemoryFindCallSite(file, line, tag);
+        if (siteIndex != _MUF_MEMORY_NO_SITE) {
+            _mufMemoryTracker->callSites[siteIndex].liveBytes += size;
+            ++_mufMemoryTracker->callSites[siteIndex].liveCount;
+        }
+        header->info.siteIndex = siteIndex;
+        mufSpinLockRelease(&_mufMemoryTracker->callSiteLock);
+    }
+}
+
+MUF_INTERNAL void _mufMemoryRecordFree(_MufMemoryHeader *header) {
+    MUF_FASSERT(header->info.magic == MUF_MEMORY_HEADER_MAGIC, "Freeing a block that was not allocated by mufAlloc");
+    _MufMemoryTagCounters *c = &_mufMemoryTracker->tags[header->info.tag];
+    mufAtomicFetchSub(&c->liveBytes, header->info.size);
+    mufAtomicFetchSub(&c->liveCount, 1);
+    mufAtomicFetchAdd(&c->totalFreeCount, 1);
+
+    if (header->info.siteIndex != _MUF_MEMORY_NO_SITE) {
+        mufSpinLockAcquire(&_mufMemoryTracker->callSiteLock);
+        _mufMemoryTracker->callSites[header->info.siteIndex].liveBytes -= header->info.size;
+        --_mufMemoryTracker->callSites[header->info.siteIndex].liveCount;
+        mufSpinLockRelease(&_mufMemoryTracker->callSiteLock);
+    }
+    header->info.magic = 0;
+}
+
+muf_rawptr _mufMemoryTrackAlloc(muf_usize size, muf_bool zero, MufMemoryTag tag, const muf_char *file, muf_u32 line) {
+    _mufMemoryInstallExitHandler();
+    _MufMemoryHeader *header = zero ? calloc(1, sizeof(_MufMemoryHeader) + size) : malloc(sizeof(_MufMemoryHeader) + size);
+    if (header == NULL)
+        return NULL;
+    _mufMemoryRecordAlloc(header, size, tag, file, line);
+    return header + 1;
+}
+
+muf_rawptr _mufMemoryTrackRealloc(muf_rawptr ptr, muf_usize newSize, MufMemoryTag tag, const muf_char *file, muf_u32 line) {
+    if (ptr == NULL)
+        return _mufMemoryTrackAlloc(newSize, MUF_FALSE, tag, file, line);
+
+    _MufMemoryHeader *header = (_MufMemoryHeader *) ptr - 1;
+    _mufMemoryRecordFree(header);
+    _MufMemoryHeader *newHeader = realloc(header, sizeof(_MufMemoryHeader) + newSize);
+    if (newHeader == NULL) {
+        /* The old block is still valid, keep accounting for it */
+        header->info.magic = MUF_MEMORY_HEADER_MAGIC;
+        _mufMemoryRecordAlloc(header, header->info.size, (MufMemoryTag) header->info.tag, file, line);
+        return NULL;
+    }
+    _mufMemoryRecordAlloc(newHeader, newSize, tag, file, line);
+    return newHeader + 1;
+}
+
+void _mufMemoryTrackFree(muf_rawptr ptr) {
+    if (ptr == NULL)
+        return;
+    _MufMemoryHeader *header = (_MufMemoryHeader *) ptr - 1;
+    _mufMemoryRecordFree(header);
+    free(header);
+}
+
+muf_char *_mufMemoryTrackStrClone(const muf_char *str, MufMemoryTag tag, const muf_char *file, muf_u32 line) {
+    muf_usize length = strlen(str);
+    muf_char *clone = (muf_char *) _mufMemoryTrackAlloc(length + 1, MUF_FALSE, tag, file, line);
+    memcpy(clone, str, length + 1);
+    return clone;
+}
+
+void mufMemoryGetTagStats(MufMemoryTag tag, MufMemoryTagStats *statsOut) {
+    const _MufMemoryTagCounters *c = &_mufMemoryTracker->tags[tag];
+    statsOut->liveBytes = mufAtomicLoad(&c->liveBytes);
+    statsOut->peakBytes = mufAtomicLoad(&c->peakBytes);
+    statsOut->liveCount = mufAtomicLoad(&c->liveCount);
+    statsOut->totalAllocCount = mufAtomicLoad(&c->totalAllocCount);
+    statsOut->totalFreeCount = mufAtomicLoad(&c->totalFreeCount);
+    statsOut->totalAllocBytes = mufAtomicLoad(&c->totalAllocBytes);
+}
+
+void mufMemorySetCallSiteTracking(muf_bool enabled) {
+    if (enabled && _mufMemoryTracker->callSites == NULL)
+        _mufMemoryTracker->callSites = calloc(MUF_MEMORY_CALL_SITE_CAPACITY, sizeof(_MufMemoryCallSite));
+    _mufMemoryTracker->callSitesEnabled = enabled;
+}
+
+void mufMemorySetReportAtExit(muf_bool enabled) {
+    _mufMemoryTracker->reportAtExit = enabled;
+}
+
+void mufMemoryDumpReport(FILE *stream) {
+    muf_u64 now = mufTimerGetNanoseconds();
+    muf_f64 elapsed = (muf_f64) (now - _mufMemoryTracker->lastReportNs) / 1e9;
+    _mufMemoryTracker->lastReportNs = now;
+    if (elapsed <= 0.0)
+        elapsed = 1.0;
+
+    fprintf(stream, "Memory report (%.2fs since the previous report)\n", elapsed);
+    fprintf(stream, "%-16s %14s %14s %10s %12s %14s\n", "Tag", "Live bytes", "Peak bytes", "Live", "Allocs/s", "Bytes/s");
+    for (muf_index i = 0; i < _MUF_MEMORY_TAG_COUNT_; ++i) {
+        _MufMemoryTagCounters *c = &_mufMemoryTracker->tags[i];
+        MufMemoryTagStats stats;
+        mufMemoryGetTagStats((MufMemoryTag) i, &stats);
+        fprintf(stream, "%-16s %14llu %14llu %10llu %12.1f %14.1f\n",
+            mufMemoryTagGetName((MufMemoryTag) i), (unsigned long long) stats.liveBytes,
+            (unsigned long long) stats.peakBytes, (unsigned long long) stats.liveCount,
+            (muf_f64) (stats.totalAllocCount - c->reportedAllocCount) / elapsed,
+            (muf_f64) (stats.totalAllocBytes - c->reportedAllocBytes) / elapsed);
+        c->reportedAllocCount = stats.totalAllocCount;
+        c->reportedAllocBytes = stats.totalAllocBytes;
+    }
+
+    if (_mufMemoryTracker->callSites == NULL)
+        return;
+
+    /* Select the call sites holding the most live memory */
+    _MufMemoryCallSite top[MUF_MEMORY_REPORT_CALL_SITES];
+    muf_usize topCount = 0;
+    mufSpinLockAcquire(&_mufMemoryTracker->callSiteLock);
+    for (muf_index i = 0; i < MUF_MEMORY_CALL_SITE_CAPACITY; ++i) {
+        const _MufMemoryCallSite *site = &_mufMemoryTracker->callSites[i];
+        if (site->file == NULL || site->liveCount == 0)
+            continue;
+        muf_index pos = topCount < MUF_MEMORY_REPORT_CALL_SITES ? topCount++ : MUF_MEMORY_REPORT_CALL_SITES;
+        while (pos > 0 && top[pos - 1].liveBytes < site->liveBytes) {
+            if (pos < MUF_MEMORY_REPORT_CALL_SITES)
+                top[pos] = top[pos - 1];
+            --pos;
+        }
+        if (pos < MUF_MEMORY_REPORT_CALL_SITES)
+            top[pos] = *site;
+    }
+    mufSpinLockRelease(&_mufMemoryTracker->callSiteLock);
+
+    fprintf(stream, "Largest live call sites\n");
+    for (muf_index i = 0; i < topCount; ++i) {
+        fprintf(stream, "  %14llu bytes in %8llu blocks  [%s] %s:%u\n",
+            (unsigned long long) top[i].liveBytes, (unsigned long long) top[i].liveCount,
+            mufMemoryTagGetName((MufMemoryTag) top[i].tag), top[i].file, top[i].line);
+    }
+}
+
+static muf_rawptr _mufDefaultAlloc(muf_usize size) {
+    return _mufMemoryTrackAlloc(size, MUF_FALSE, MUF_MEMORY_TAG_GENERAL, __FILE__, __LINE__);
+}
+
+static void _mufDefaultDealloc(muf_rawptr ptr) {
+    _mufMemoryTrackFree(ptr);
+}
+
+static muf_rawptr _mufDefaultRealloc(muf_rawptr ptr, muf_usize newSize) {
+    return _mufMemoryTrackRealloc(ptr, newSize, MUF_MEMORY_TAG_GENERAL, __FILE__, __LINE__);
+}
+
+#else
+
+muf_rawptr _mufMemoryTrackAlloc(muf_usize size, muf_bool zero, MufMemoryTag tag, const muf_char *file, muf_u32 line) {
+    MUF_UNUSED(tag); MUF_UNUSED(file); MUF_UNUSED(line);
+    return zero ? calloc(1, size) : malloc(size);
+}
+
+muf_rawptr _mufMemoryTrackRealloc(muf_rawptr ptr, muf_usize newSize, MufMemoryTag tag, const muf_char *file, muf_u32 line) {
+    MUF_UNUSED(tag); MUF_UNUSED(file); MUF_UNUSED(line);
+    return realloc(ptr, newSize);
+}
+
+void _mufMemoryTrackFree(muf_rawptr ptr) {
+    free(ptr);
+}
+
+muf_char *_mufMemoryTrackStrClone(const muf_char *str, MufMemoryTag tag, const muf_char *file, muf_u32 line) {
+    MUF_UNUSED(tag); MUF_UNUSED(file); MUF_UNUSED(line);
+    return strdup(str);
+}
+
+void mufMemoryGetTagStats(MufMemoryTag tag, MufMemoryTagStats *statsOut) {
+    MUF_UNUSED(tag);
+    memset(statsOut, 0, sizeof(MufMemoryTagStats));
+}
+
+void mufMemorySetCallSiteTracking(muf_bool enabled) {
+    MUF_UNUSED(enabled);
+}
+
+void mufMemorySetReportAtExit(muf_bool enabled) {
+    MUF_UNUSED(enabled);
+}
+
+void mufMemoryDumpReport(FILE *stream) {
+    fprintf(stream, "Memory tracking is disabled, rebuild with MUFFIN_ENABLE_MEMORY_TRACKING\n");
+}
+
 static muf_rawptr _mufDefaultAlloc(muf_usize size) {
     return malloc(size);
 }
@@ -14,8 +321,10 @@ static muf_rawptr _mufDefaultRealloc(muf_rawptr ptr, muf_usize newSize) {
     return realloc(ptr, newSize);
 }
 
+#endif
+
 MufAllocatorCallbacks MUF_DEFAULT_ALLOCATOR[1] = {{
     _mufDefaultAlloc,
     _mufDefaultDealloc,
     _mufDefaultRealloc
-}};
\ No newline at end of file
+}};
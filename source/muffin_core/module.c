@@ -1,3 +1,5 @@
+#define MUF_MEMORY_TAG MUF_MEMORY_TAG_MODULE
+
 #include "muffin_core/module.h"
 
 #include <stdarg.h>
@@ -5,6 +7,7 @@
 
 #include "muffin_core/array.h"
 #include "muffin_core/dict.h"
+#include "muffin_core/intern.h"
 #include "muffin_core/log.h"
 #include "muffin_core/memory.h"
 #include "muffin_core/string.h"
@@ -41,8 +44,13 @@ static void _mufDestroyModuleManager(_MufModuleManager *manager) {
 
 static void _mufModuleManagerRegister(_MufModuleManager *manager, const MufModuleRegistry *registry) {
     const muf_char *name = registry->name;
+    MufStrId id = mufInternStr(name);
+    if (id == MUF_STR_ID_INVALID) {
+        mufError("Could not intern the name of the module '%s'", name);
+        return;
+    }
     
-    if (mufDictContains(_manager->modules, name)) {
+    if (mufDictContainsId(manager->modules, id)) {
         return;
     }
     
@@ -56,13 +64,13 @@ static void _mufModuleManagerRegister(_MufModuleManager *manager, const MufModul
     mod.unloadCallback = registry->unloadCallback;
     mod.loadTime = 0;
 
-    _MufModule *target = (_MufModule *) mufDictInsert(_manager->modules, name, &mod);
+    _MufModule *target = (_MufModule *) mufDictInsertId(manager->modules, id, &mod);
     const muf_char *nameBuffer = target->name;
-    mufArrayPush(_manager->names, &nameBuffer);
+    mufArrayPush(manager->names, &nameBuffer);
 }
 
-static MUF_INLINE _MufModule *_mufModuleManagerGet(_MufModuleManager *manager, const muf_char *modName) {
-    return (_MufModule *) mufDictGetRef(manager->modules, modName);
+static MUF_INLINE _MufModule *_mufModuleManagerGet(_MufModuleManager *manager, MufStrId id) {
+    return (_MufModule *) mufDictGetRefId(manager->modules, id);
 }
 
 static MUF_INLINE const muf_char **_mufModuleManagerGetAllNames(_MufModuleManager *manager, muf_usize *count) {
@@ -102,10 +110,14 @@ void mufRegisterModule(const MufModuleRegistry *registry) {
 }
 
 MufModule mufGetModule(const muf_char *modName) {
-    _MufModule *mod = (_MufModule *) mufDictGetRef(_mufGetModuleManager()->modules, modName);
+    /* A name that was never interned cannot be the one of a module, the lookup does not intern it */
+    return mufGetModuleById(mufFindStrId(modName));
+}
+
+MufModule mufGetModuleById(MufStrId id) {
+    _MufModule *mod = id == MUF_STR_ID_INVALID ? NULL : _mufModuleManagerGet(_mufGetModuleManager(), id);
 
     if (!mod) {
-        //mufError("Could not find module named with %s", modName);
         return mufNullHandle(MufModule);
     }
     return mufMakeHandle(MufModule, ptr, mod);
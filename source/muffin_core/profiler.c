@@ -0,0 +1,365 @@
+#include "muffin_core/profiler.h"
+
+#include "muffin_core/array.h"
+#include "muffin_core/math.h"
+#include "muffin_core/memory.h"
+#include "muffin_core/string.h"
+#include "muffin_core/sync.h"
+#include "muffin_core/timer.h"
+
+#define MUF_PROFILER_BLOCK_EVENT_COUNT  4096
+#define MUF_PROFILER_TRACK_NAME_MAX_LEN 64
+#define MUF_PROFILER_BINARY_VERSION     1
+
+typedef struct _MufProfileBlock_s {
+    struct _MufProfileBlock_s   *next;
+    volatile muf_usize          count;
+    MufProfileEvent             events[MUF_PROFILER_BLOCK_EVENT_COUNT];
+} _MufProfileBlock;
+
+typedef struct _MufProfileTrack_s {
+    struct _MufProfileTrack_s   *next;
+    MufProfileTrack             id;
+    muf_char                    name[MUF_PROFILER_TRACK_NAME_MAX_LEN];
+    _MufProfileBlock            *head;
+    _MufProfileBlock            *tail;
+} _MufProfileTrack;
+
+typedef struct _MufProfiler_s {
+    MufSpinLock         lock;
+    volatile muf_bool   enabled;
+    _MufProfileTrack    *tracks;
+    MufProfileTrack     nextTrackId;
+} _MufProfiler;
+
+#if defined(MUF_ENABLE_PROFILER)
+#   define _MUF_PROFILER_ENABLED_BY_DEFAULT MUF_TRUE
+#else
+#   define _MUF_PROFILER_ENABLED_BY_DEFAULT MUF_FALSE
+#endif
+
+static _MufProfiler _mufProfiler[1] = {{ MUF_SPIN_LOCK_INIT, _MUF_PROFILER_ENABLED_BY_DEFAULT, NULL, 1 }};
+static MUF_THREAD_LOCAL _MufProfileTrack *_mufProfilerThreadTrack = NULL;
+
+MUF_INTERNAL _MufProfileBlock *_mufCreateProfileBlock(void) {
+    _MufProfileBlock *block = mufAlloc(_MufProfileBlock, 1);
+    block->next = NULL;
+    block->count = 0;
+    return block;
+}
+
+MUF_INTERNAL _MufProfileTrack *_mufCreateProfileTrack(const muf_char *name) {
+    _MufProfileTrack *track = mufAlloc(_MufProfileTrack, 1);
+    track->head = track->tail = _mufCreateProfileBlock();
+
+    mufSpinLockAcquire(&_mufProfiler->lock);
+    track->id = _mufProfiler->nextTrackId++;
+    snprintf(track->name, sizeof(track->name), "%s", name);
+    track->next = _mufProfiler->tracks;
+    mufAtomicStore(&_mufProfiler->tracks, track);
+    mufSpinLockRelease(&_mufProfiler->lock);
+    return track;
+}
+
+MUF_INTERNAL _MufProfileTrack *_mufProfilerGetThreadTrack(void) {
+    if (_mufProfilerThreadTrack == NULL) {
+        muf_char name[MUF_PROFILER_TRACK_NAME_MAX_LEN];
+        snprintf(name, sizeof(name), "Thread %u", mufGetCurrentThreadId());
+        _mufProfilerThreadTrack = _mufCreateProfileTrack(name);
+    }
+    return _mufProfilerThreadTrack;
+}
+
+MUF_INTERNAL _MufProfileTrack *_mufProfilerFindTrack(MufProfileTrack id) {
+    _MufProfileTrack *track = mufAtomicLoad(&_mufProfiler->tracks);
+    while (track != NULL && track->id != id)
+        track = track->next;
+    return track;
+}
+
+/* Only the owner of the track appends, readers see events once `count` is published */
+MUF_INTERNAL void _mufProfilerAppend(_MufProfileTrack *track, const muf_char *name, muf_u32 type, muf_u64 timestamp, muf_u64 duration) {
+    _MufProfileBlock *block = track->tail;
+    muf_usize count = block->count;
+    if (count == MUF_PROFILER_BLOCK_EVENT_COUNT) {
+        _MufProfileBlock *newBlock = _mufCreateProfileBlock();
+        mufAtomicStore(&block->next, newBlock);
+        track->tail = block = newBlock;
+        count = 0;
+    }
+
+    MufProfileEvent *event = &block->events[count];
+    event->name = name;
+    event->timestamp = timestamp;
+    event->duration = duration;
+    event->type = type;
+    mufAtomicStore(&block->count, count + 1);
+}
+
+void mufProfilerSetEnabled(muf_bool enabled) {
+    mufAtomicStore(&_mufProfiler->enabled, enabled);
+}
+
+muf_bool mufProfilerIsEnabled(void) {
+    return mufAtomicLoadRelaxed(&_mufProfiler->enabled);
+}
+
+void mufProfilerReset(void) {
+    mufSpinLockAcquire(&_mufProfiler->lock);
+    for (_MufProfileTrack *track = _mufProfiler->tracks; track != NULL; track = track->next) {
+        _MufProfileBlock *block = track->head->next;
+        while (block != NULL) {
+            _MufProfileBlock *next = block->next;
+            mufFree(block);
+            block = next;
+        }
+        track->head->next = NULL;
+        track->head->count = 0;
+        track->tail = track->head;
+    }
+    mufSpinLockRelease(&_mufProfiler->lock);
+}
+
+void mufProfilerSetThreadName(const muf_char *name) {
+    _MufProfileTrack *track = _mufProfilerGetThreadTrack();
+    mufSpinLockAcquire(&_mufProfiler->lock);
+    snprintf(track->name, sizeof(track->name), "%s", name);
+    mufSpinLockRelease(&_mufProfiler->lock);
+}
+
+MufProfileTrack mufProfilerCreateTrack(const muf_char *name) {
+    return _mufCreateProfileTrack(name)->id;
+}
+
+void mufProfilerBegin(const muf_char *name) {
+    if (!mufProfilerIsEnabled())
+        return;
+    _mufProfilerAppend(_mufProfilerGetThreadTrack(), name, MUF_PROFILE_EVENT_TYPE_BEGIN, mufTimerGetTicks(), 0);
+}
+
+void mufProfilerEnd(const muf_char *name) {
+    if (!mufProfilerIsEnabled())
+        return;
+    _mufProfilerAppend(_mufProfilerGetThreadTrack(), name, MUF_PROFILE_EVENT_TYPE_END, mufTimerGetTicks(), 0);
+}
+
+void mufProfilerInstant(const muf_char *name) {
+    if (!mufProfilerIsEnabled())
+        return;
+    _mufProfilerAppend(_mufProfilerGetThreadTrack(), name, MUF_PROFILE_EVENT_TYPE_INSTANT, mufTimerGetTicks(), 0);
+}
+
+void mufProfilerRecordComplete(MufProfileTrack track, const muf_char *name, muf_u64 beginTicks, muf_u64 endTicks) {
+    if (!mufProfilerIsEnabled())
+        return;
+    _MufProfileTrack *target = _mufProfilerFindTrack(track);
+    MUF_FASSERT(target != NULL, "Unknown profiler track %u", track);
+    if (target == NULL)
+        return;
+    _mufProfilerAppend(target, name, MUF_PROFILE_EVENT_TYPE_COMPLETE, beginTicks,
+        endTicks > beginTicks ? endTicks - beginTicks : 0);
+}
+
+/* Export */
+
+MUF_INTERNAL void _mufProfilerWriteJsonString(FILE *file, const muf_char *str) {
+    fputc('"', file);
+    for (; *str != '\0'; ++str) {
+        muf_uchar c = (muf_uchar) *str;
+        if (c == '"' || c == '\\')
+            fprintf(file, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(file, "\\u%04x", c);
+        else
+            fputc(c, file);
+    }
+    fputc('"', file);
+}
+
+MUF_INTERNAL muf_f64 _mufProfilerTicksToMicroseconds(muf_u64 ticks, muf_u64 origin) {
+    return (muf_f64) mufTimerTicksToNanoseconds(ticks - origin) / 1000.0;
+}
+
+/* The earliest timestamp in the trace, so that exported times start near zero */
+MUF_INTERNAL muf_u64 _mufProfilerFindOrigin(_MufProfileTrack *tracks) {
+    muf_u64 origin = MUF_U64_MAX;
+    for (_MufProfileTrack *track = tracks; track != NULL; track = track->next) {
+        for (_MufProfileBlock *block = track->head; block != NULL; block = mufAtomicLoad(&block->next)) {
+            muf_usize count = mufAtomicLoad(&block->count);
+            for (muf_index i = 0; i < count; ++i)
+                origin = mufMin(origin, block->events[i].timestamp);
+        }
+    }
+    return origin == MUF_U64_MAX ? 0 : origin;
+}
+
+muf_bool mufProfilerExportChromeTrace(const muf_char *filePath) {
+    FILE *file = fopen(filePath, "w");
+    if (file == NULL)
+        return MUF_FALSE;
+
+    _MufProfileTrack *tracks = mufAtomicLoad(&_mufProfiler->tracks);
+    muf_u64 origin = _mufProfilerFindOrigin(tracks);
+    muf_bool first = MUF_TRUE;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (_MufProfileTrack *track = tracks; track != NULL; track = track->next) {
+        fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+            first ? "" : ",", track->id);
+        _mufProfilerWriteJsonString(file, track->name);
+        fprintf(file, "}}");
+        first = MUF_FALSE;
+
+        for (_MufProfileBlock *block = track->head; block != NULL; block = mufAtomicLoad(&block->next)) {
+            muf_usize count = mufAtomicLoad(&block->count);
+            for (muf_index i = 0; i < count; ++i) {
+                const MufProfileEvent *event = &block->events[i];
+                fprintf(file, ",\n{\"name\":");
+                _mufProfilerWriteJsonString(file, event->name);
+                fprintf(file, ",\"pid\":1,\"tid\":%u,\"ts\":%.3f", track->id,
+                    _mufProfilerTicksToMicroseconds(event->timestamp, origin));
+
+                switch (event->type) {
+                    case MUF_PROFILE_EVENT_TYPE_BEGIN:
+                        fprintf(file, ",\"ph\":\"B\"}");
+                        break;
+                    case MUF_PROFILE_EVENT_TYPE_END:
+                        fprintf(file, ",\"ph\":\"E\"}");
+                        break;
+                    case MUF_PROFILE_EVENT_TYPE_INSTANT:
+                        fprintf(file, ",\"ph\":\"i\",\"s\":\"t\"}");
+                        break;
+                    default:
+                        fprintf(file, ",\"ph\":\"X\",\"dur\":%.3f}",
+                            (muf_f64) mufTimerTicksToNanoseconds(event->duration) / 1000.0);
+                        break;
+                }
+            }
+        }
+    }
+    fprintf(file, "\n]}\n");
+
+    muf_bool succeeded = ferror(file) == 0;
+    fclose(file);
+    return succeeded;
+}
+
+MUF_INTERNAL void _mufProfilerWriteU8(FILE *file, muf_u8 value) {
+    fputc(value, file);
+}
+
+MUF_INTERNAL void _mufProfilerWriteU16(FILE *file, muf_u16 value) {
+    muf_u8 bytes[2] = { (muf_u8) value, (muf_u8) (value >> 8) };
+    fwrite(bytes, 1, sizeof(bytes), file);
+}
+
+MUF_INTERNAL void _mufProfilerWriteU32(FILE *file, muf_u32 value) {
+    muf_u8 bytes[4];
+    for (muf_index i = 0; i < 4; ++i)
+        bytes[i] = (muf_u8) (value >> (i * 8));
+    fwrite(bytes, 1, sizeof(bytes), file);
+}
+
+MUF_INTERNAL void _mufProfilerWriteU64(FILE *file, muf_u64 value) {
+    muf_u8 bytes[8];
+    for (muf_index i = 0; i < 8; ++i)
+        bytes[i] = (muf_u8) (value >> (i * 8));
+    fwrite(bytes, 1, sizeof(bytes), file);
+}
+
+MUF_INTERNAL void _mufProfilerWriteStr(FILE *file, const muf_char *str) {
+    muf_usize length = mufMin(mufCStrLength(str), MUF_U16_MAX);
+    _mufProfilerWriteU16(file, (muf_u16) length);
+    fwrite(str, 1, length, file);
+}
+
+MUF_INTERNAL muf_i32 _mufProfilerCompareNamePtr(muf_crawptr a, muf_crawptr b) {
+    muf_usize x = (muf_usize) *(const muf_char * const *) a;
+    muf_usize y = (muf_usize) *(const muf_char * const *) b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/* Names are deduplicated by address, a sorted table keeps the lookup cheap */
+MUF_INTERNAL muf_u32 _mufProfilerFindNameIndex(const MufArray *names, const muf_char *name) {
+    muf_index lo = 0, hi = mufArrayGetSize(names);
+    const muf_char * const *data = (const muf_char * const *) names->data;
+    while (lo < hi) {
+        muf_index mid = lo + (hi - lo) / 2;
+        if ((muf_usize) data[mid] < (muf_usize) name)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (muf_u32) lo;
+}
+
+muf_bool mufProfilerExportBinary(const muf_char *filePath) {
+    FILE *file = fopen(filePath, "wb");
+    if (file == NULL)
+        return MUF_FALSE;
+
+    _MufProfileTrack *tracks = mufAtomicLoad(&_mufProfiler->tracks);
+    MufArray *names = mufCreateArray(const muf_char *);
+    MufArray *eventCounts = mufCreateArray(muf_u32);
+
+    /* Gather the name table and freeze the event count of every track */
+    for (_MufProfileTrack *track = tracks; track != NULL; track = track->next) {
+        muf_u32 eventCount = 0;
+        for (_MufProfileBlock *block = track->head; block != NULL; block = mufAtomicLoad(&block->next)) {
+            muf_usize count = mufAtomicLoad(&block->count);
+            for (muf_index i = 0; i < count; ++i)
+                mufArrayPush(names, &block->events[i].name);
+            eventCount += (muf_u32) count;
+        }
+        mufArrayPush(eventCounts, &eventCount);
+    }
+
+    mufArrayParallelSort(names, _mufProfilerCompareNamePtr);
+    muf_usize uniqueCount = 0;
+    const muf_char **nameData = (const muf_char **) names->data;
+    for (muf_index i = 0; i < mufArrayGetSize(names); ++i) {
+        if (uniqueCount == 0 || nameData[uniqueCount - 1] != nameData[i])
+            nameData[uniqueCount++] = nameData[i];
+    }
+    names->size = uniqueCount;
+
+    fwrite("MUFPROF", 1, 8, file);
+    _mufProfilerWriteU32(file, MUF_PROFILER_BINARY_VERSION);
+    _mufProfilerWriteU64(file, mufTimerGetFrequency());
+
+    _mufProfilerWriteU32(file, (muf_u32) uniqueCount);
+    for (muf_index i = 0; i < uniqueCount; ++i)
+        _mufProfilerWriteStr(file, nameData[i]);
+
+    muf_u32 trackCount = (muf_u32) mufArrayGetSize(eventCounts);
+    _mufProfilerWriteU32(file, trackCount);
+    for (_MufProfileTrack *track = tracks; track != NULL; track = track->next) {
+        _mufProfilerWriteU32(file, track->id);
+        _mufProfilerWriteStr(file, track->name);
+    }
+
+    muf_index trackIndex = 0;
+    for (_MufProfileTrack *track = tracks; track != NULL; track = track->next, ++trackIndex) {
+        muf_u32 remaining = *(muf_u32 *) mufArrayGetRef(eventCounts, trackIndex);
+        _mufProfilerWriteU32(file, track->id);
+        _mufProfilerWriteU32(file, remaining);
+        for (_MufProfileBlock *block = track->head; block != NULL && remaining > 0; block = block->next) {
+            muf_usize count = mufMin(remaining, block->count);
+            for (muf_index i = 0; i < count; ++i) {
+                const MufProfileEvent *event = &block->events[i];
+                _mufProfilerWriteU32(file, _mufProfilerFindNameIndex(names, event->name));
+                _mufProfilerWriteU8(file, (muf_u8) event->type);
+                _mufProfilerWriteU64(file, event->timestamp);
+                _mufProfilerWriteU64(file, event->duration);
+            }
+            remaining -= (muf_u32) count;
+        }
+    }
+
+    mufDestroyArray(eventCounts);
+    mufDestroyArray(names);
+
+    muf_bool succeeded = ferror(file) == 0;
+    fclose(file);
+    return succeeded;
+}
@@ -0,0 +1,276 @@
+#include "muffin_core/random.h"
+#include "muffin_core/cpu.h"
+#include "muffin_core/math.h"
+#include "muffin_core/simd.h"
+#include "muffin_core/sync.h"
+
+#include <string.h>
+
+#if defined(MUF_COMPILER_GCC) && !defined(__clang__)
+/* Keep the float fills of every variant identical, see math_batch.c */
+#   pragma GCC optimize("fp-contract=off")
+#endif
+
+#define MUF_RANDOM_FILL_STEP 8
+
+typedef struct _MufRandomKernels_s {
+    MufCpuFeatureFlags required;
+    /* Both write steps * MUF_RANDOM_FILL_STEP values */
+    void (*fillU32)(MufXoshiro256x4 *generator, muf_u32 *out, muf_usize steps);
+    void (*fillF32)(MufXoshiro256x4 *generator, muf_f32 *out, muf_usize steps, muf_f32 minValue, muf_f32 range);
+} _MufRandomKernels;
+
+void mufInitSplitMix64(MufSplitMix64 *generator, muf_u64 seed) {
+    generator->state = seed;
+}
+
+void mufInitXoshiro256(MufXoshiro256 *generator, muf_u64 seed) {
+    MufSplitMix64 expander;
+    mufInitSplitMix64(&expander, seed);
+    /* SplitMix64 never outputs four zeros in a row, the state can not be the fixed point */
+    for (muf_u32 i = 0; i < 4; ++i)
+        generator->s[i] = mufSplitMix64Next(&expander);
+}
+
+MUF_INTERNAL void _mufXoshiro256Jump(MufXoshiro256 *generator, const muf_u64 polynomial[4]) {
+    muf_u64 s[4] = { 0, 0, 0, 0 };
+    for (muf_u32 i = 0; i < 4; ++i) {
+        for (muf_u32 b = 0; b < 64; ++b) {
+            if (polynomial[i] & (1ULL << b)) {
+                s[0] ^= generator->s[0];
+                s[1] ^= generator->s[1];
+                s[2] ^= generator->s[2];
+                s[3] ^= generator->s[3];
+            }
+            mufXoshiro256Next(generator);
+        }
+    }
+    memcpy(generator->s, s, sizeof(s));
+}
+
+void mufXoshiro256Jump(MufXoshiro256 *generator) {
+    static const muf_u64 jump[4] = {
+        0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL
+    };
+    _mufXoshiro256Jump(generator, jump);
+}
+
+void mufXoshiro256LongJump(MufXoshiro256 *generator) {
+    static const muf_u64 longJump[4] = {
+        0x76E15D3EFEFDCBBFULL, 0xC5004E441C522FB3ULL, 0x77710069854EE241ULL, 0x39109BB02ACBE635ULL
+    };
+    _mufXoshiro256Jump(generator, longJump);
+}
+
+muf_u32 mufXoshiro256NextBounded(MufXoshiro256 *generator, muf_u32 bound) {
+    /* The high half of x * bound is in [0, bound), the low half flags the products that would bias it */
+    muf_u64 m = (mufXoshiro256Next(generator) >> 32) * bound;
+    if ((muf_u32) m < bound) {
+        muf_u32 threshold = (0U - bound) % bound;
+        while ((muf_u32) m < threshold)
+            m = (mufXoshiro256Next(generator) >> 32) * bound;
+    }
+    return (muf_u32) (m >> 32);
+}
+
+muf_i32 mufXoshiro256Range(MufXoshiro256 *generator, muf_i32 minValue, muf_i32 maxValue) {
+    if (minValue > maxValue)
+        mufSwap(muf_i32, minValue, maxValue);
+    muf_u32 span = (muf_u32) maxValue - (muf_u32) minValue + 1U;
+    /* The span wraps to 0 for the whole range of muf_i32 */
+    muf_u32 offset = span == 0 ? (muf_u32) (mufXoshiro256Next(generator) >> 32) :
+        mufXoshiro256NextBounded(generator, span);
+    return (muf_i32) ((muf_u32) minValue + offset);
+}
+
+void mufInitPcg32(MufPcg32 *generator, muf_u64 seed, muf_u64 stream) {
+    generator->state = 0;
+    generator->increment = (stream << 1) | 1U;
+    mufPcg32Next(generator);
+    generator->state += seed;
+    mufPcg32Next(generator);
+}
+
+void mufPcg32Advance(MufPcg32 *generator, muf_u64 delta) {
+    /* Square and multiply on the affine step state * a + c after Brown's arbitrary strides */
+    muf_u64 accMultiplier = 1, accIncrement = 0;
+    muf_u64 multiplier = 6364136223846793005ULL, increment = generator->increment;
+    for (; delta > 0; delta >>= 1) {
+        if (delta & 1) {
+            accMultiplier *= multiplier;
+            accIncrement = accIncrement * multiplier + increment;
+        }
+        increment = (multiplier + 1) * increment;
+        multiplier *= multiplier;
+    }
+    generator->state = accMultiplier * generator->state + accIncrement;
+}
+
+muf_u32 mufPcg32NextBounded(MufPcg32 *generator, muf_u32 bound) {
+    muf_u64 m = (muf_u64) mufPcg32Next(generator) * bound;
+    if ((muf_u32) m < bound) {
+        muf_u32 threshold = (0U - bound) % bound;
+        while ((muf_u32) m < threshold)
+            m = (muf_u64) mufPcg32Next(generator) * bound;
+    }
+    return (muf_u32) (m >> 32);
+}
+
+void mufInitXoshiro256x4(MufXoshiro256x4 *generator, muf_u64 seed) {
+    MufXoshiro256 lane;
+    mufInitXoshiro256(&lane, seed);
+    for (muf_u32 i = 0; i < 4; ++i) {
+        for (muf_u32 word = 0; word < 4; ++word)
+            generator->s[word][i] = lane.s[word];
+        mufXoshiro256Jump(&lane);
+    }
+}
+
+/* Baseline, the four lanes one after the other */
+
+MUF_INTERNAL void _mufRandomFillU32Baseline(MufXoshiro256x4 *generator, muf_u32 *out, muf_usize steps) {
+    for (muf_usize i = 0; i < steps; ++i, out += MUF_RANDOM_FILL_STEP) {
+        for (muf_u32 lane = 0; lane < 4; ++lane) {
+            MufXoshiro256 g = {
+                { generator->s[0][lane], generator->s[1][lane], generator->s[2][lane], generator->s[3][lane] }
+            };
+            muf_u64 value = mufXoshiro256Next(&g);
+            out[lane * 2] = (muf_u32) value;
+            out[lane * 2 + 1] = (muf_u32) (value >> 32);
+            for (muf_u32 word = 0; word < 4; ++word)
+                generator->s[word][lane] = g.s[word];
+        }
+    }
+}
+
+MUF_INTERNAL void _mufRandomFillF32Baseline(MufXoshiro256x4 *generator, muf_f32 *out, muf_usize steps,
+    muf_f32 minValue, muf_f32 range) {
+    muf_u32 values[MUF_RANDOM_FILL_STEP];
+    for (muf_usize i = 0; i < steps; ++i, out += MUF_RANDOM_FILL_STEP) {
+        _mufRandomFillU32Baseline(generator, values, 1);
+        for (muf_u32 k = 0; k < MUF_RANDOM_FILL_STEP; ++k)
+            out[k] = minValue + (muf_f32) (values[k] >> 8) * (1.0F / 16777216.0F) * range;
+    }
+}
+
+static const _MufRandomKernels _mufRandomBaseline = {
+    MUF_CPU_FEATURE_NONE,
+    _mufRandomFillU32Baseline,
+    _mufRandomFillF32Baseline
+};
+
+#if defined(MUF_SIMD_MULTI_TARGET)
+
+/* AVX2, the four lanes of each state word in one register */
+
+#define _MUF_RANDOM_ROTL_AVX2(_x, _k) _mm256_or_si256(_mm256_slli_epi64(_x, _k), _mm256_srli_epi64(_x, 64 - (_k)))
+
+MUF_SIMD_TARGET("avx2")
+MUF_INTERNAL MUF_INLINE __m256i _mufXoshiro256x4NextAVX2(__m256i *s0, __m256i *s1, __m256i *s2, __m256i *s3) {
+    __m256i sum = _mm256_add_epi64(*s0, *s3);
+    __m256i result = _mm256_add_epi64(_MUF_RANDOM_ROTL_AVX2(sum, 23), *s0);
+    __m256i t = _mm256_slli_epi64(*s1, 17);
+    *s2 = _mm256_xor_si256(*s2, *s0);
+    *s3 = _mm256_xor_si256(*s3, *s1);
+    *s1 = _mm256_xor_si256(*s1, *s2);
+    *s0 = _mm256_xor_si256(*s0, *s3);
+    *s2 = _mm256_xor_si256(*s2, t);
+    *s3 = _MUF_RANDOM_ROTL_AVX2(*s3, 45);
+    return result;
+}
+
+MUF_SIMD_TARGET("avx2")
+MUF_INTERNAL void _mufRandomFillU32AVX2(MufXoshiro256x4 *generator, muf_u32 *out, muf_usize steps) {
+    __m256i s0 = _mm256_loadu_si256((const __m256i *) generator->s[0]);
+    __m256i s1 = _mm256_loadu_si256((const __m256i *) generator->s[1]);
+    __m256i s2 = _mm256_loadu_si256((const __m256i *) generator->s[2]);
+    __m256i s3 = _mm256_loadu_si256((const __m256i *) generator->s[3]);
+    for (muf_usize i = 0; i < steps; ++i, out += MUF_RANDOM_FILL_STEP)
+        _mm256_storeu_si256((__m256i *) out, _mufXoshiro256x4NextAVX2(&s0, &s1, &s2, &s3));
+    _mm256_storeu_si256((__m256i *) generator->s[0], s0);
+    _mm256_storeu_si256((__m256i *) generator->s[1], s1);
+    _mm256_storeu_si256((__m256i *) generator->s[2], s2);
+    _mm256_storeu_si256((__m256i *) generator->s[3], s3);
+}
+
+MUF_SIMD_TARGET("avx2")
+MUF_INTERNAL void _mufRandomFillF32AVX2(MufXoshiro256x4 *generator, muf_f32 *out, muf_usize steps,
+    muf_f32 minValue, muf_f32 range) {
+    __m256i s0 = _mm256_loadu_si256((const __m256i *) generator->s[0]);
+    __m256i s1 = _mm256_loadu_si256((const __m256i *) generator->s[1]);
+    __m256i s2 = _mm256_loadu_si256((const __m256i *) generator->s[2]);
+    __m256i s3 = _mm256_loadu_si256((const __m256i *) generator->s[3]);
+    __m256 scale = _mm256_set1_ps(1.0F / 16777216.0F);
+    __m256 vRange = _mm256_set1_ps(range);
+    __m256 vMin = _mm256_set1_ps(minValue);
+    for (muf_usize i = 0; i < steps; ++i, out += MUF_RANDOM_FILL_STEP) {
+        __m256i bits = _mm256_srli_epi32(_mufXoshiro256x4NextAVX2(&s0, &s1, &s2, &s3), 8);
+        __m256 unit = _mm256_mul_ps(_mm256_cvtepi32_ps(bits), scale);
+        _mm256_storeu_ps(out, _mm256_add_ps(vMin, _mm256_mul_ps(unit, vRange)));
+    }
+    _mm256_storeu_si256((__m256i *) generator->s[0], s0);
+    _mm256_storeu_si256((__m256i *) generator->s[1], s1);
+    _mm256_storeu_si256((__m256i *) generator->s[2], s2);
+    _mm256_storeu_si256((__m256i *) generator->s[3], s3);
+}
+
+#undef _MUF_RANDOM_ROTL_AVX2
+
+static const _MufRandomKernels _mufRandomAVX2 = {
+    MUF_CPU_FEATURE_AVX2,
+    _mufRandomFillU32AVX2,
+    _mufRandomFillF32AVX2
+};
+
+#endif
+
+static const _MufRandomKernels *const _mufRandomVariants[] = {
+#if defined(MUF_SIMD_MULTI_TARGET)
+    &_mufRandomAVX2,
+#endif
+    &_mufRandomBaseline
+};
+
+static const _MufRandomKernels *_mufRandomKernels = NULL;
+
+static const _MufRandomKernels *_mufGetRandomKernels(void) {
+    const _MufRandomKernels *kernels = mufAtomicLoad(&_mufRandomKernels);
+    if (kernels != NULL)
+        return kernels;
+
+    for (muf_usize i = 0; i < MUF_COUNTOF(_mufRandomVariants); ++i) {
+        kernels = _mufRandomVariants[i];
+        if (mufHasCpuFeatures(kernels->required))
+            break;
+    }
+    mufAtomicStore(&_mufRandomKernels, kernels);
+    return kernels;
+}
+
+void mufRandomFillU32(MufXoshiro256x4 *generator, muf_u32 *out, muf_usize count) {
+    const _MufRandomKernels *kernels = _mufGetRandomKernels();
+    muf_usize steps = count / MUF_RANDOM_FILL_STEP;
+    kernels->fillU32(generator, out, steps);
+
+    muf_usize rest = count - steps * MUF_RANDOM_FILL_STEP;
+    if (rest > 0) {
+        muf_u32 tail[MUF_RANDOM_FILL_STEP];
+        kernels->fillU32(generator, tail, 1);
+        memcpy(out + steps * MUF_RANDOM_FILL_STEP, tail, rest * sizeof(muf_u32));
+    }
+}
+
+void mufRandomFillF32(MufXoshiro256x4 *generator, muf_f32 *out, muf_usize count, muf_f32 minValue,
+    muf_f32 maxValue) {
+    const _MufRandomKernels *kernels = _mufGetRandomKernels();
+    muf_f32 range = maxValue - minValue;
+    muf_usize steps = count / MUF_RANDOM_FILL_STEP;
+    kernels->fillF32(generator, out, steps, minValue, range);
+
+    muf_usize rest = count - steps * MUF_RANDOM_FILL_STEP;
+    if (rest > 0) {
+        muf_f32 tail[MUF_RANDOM_FILL_STEP];
+        kernels->fillF32(generator, tail, 1, minValue, range);
+        memcpy(out + steps * MUF_RANDOM_FILL_STEP, tail, rest * sizeof(muf_f32));
+    }
+}
@@ -0,0 +1,565 @@
+#define MUF_MEMORY_TAG MUF_MEMORY_TAG_CORE_CONTAINERS
+
+#include "muffin_core/spatial_hash.h"
+#include "muffin_core/hash.h"
+#include "muffin_core/memory.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+/* The cell coordinates are packed 21 bits per axis, the key of every cell fits in 63 bits */
+#define MUF_SPATIAL_HASH_COORD_BITS     21
+#define MUF_SPATIAL_HASH_COORD_LIMIT    (1 << (MUF_SPATIAL_HASH_COORD_BITS - 1))
+#define MUF_SPATIAL_HASH_EMPTY_KEY      0xFFFFFFFFFFFFFFFFULL
+#define MUF_SPATIAL_HASH_MIN_CELLS      16
+
+typedef struct _MufSpatialObject_s {
+    MufAABB3    bounds;
+    /* The key of the cell, MUF_SPATIAL_HASH_EMPTY_KEY for a free slot */
+    muf_u64     cell;
+    /* The neighbours in the list of the cell, next also links the free slots */
+    muf_u32     prev;
+    muf_u32     next;
+} _MufSpatialObject;
+
+typedef struct _MufSpatialCell_s {
+    muf_u64 key;
+    muf_u32 head;
+    muf_u32 count;
+} _MufSpatialCell;
+
+struct MufSpatialHash_s {
+    muf_f32             cellSize;
+    muf_f32             inverseCellSize;
+    /* The largest half extent of the objects on each axis, how far the cells are loosened */
+    MufVec3             looseness;
+
+    _MufSpatialObject   *objects;
+    muf_u32             objectCapacity;
+    /* The slots in use or freed, the slots after it were never used */
+    muf_u32             objectEnd;
+    muf_u32             objectCount;
+    muf_u32             freeHead;
+
+    /* Open addressing with linear probing, the capacity is a power of two */
+    _MufSpatialCell     *cells;
+    muf_u32             cellCapacity;
+    muf_u32             cellCount;
+    /* The range of the cell coordinates that were occupied since the last build */
+    muf_i32             cellMin[3];
+    muf_i32             cellMax[3];
+};
+
+MUF_INTERNAL muf_i32 _mufSpatialHashCoord(const MufSpatialHash *hash, muf_f32 value) {
+    muf_f32 c = floorf(value * hash->inverseCellSize);
+    if (!(c >= (muf_f32) -MUF_SPATIAL_HASH_COORD_LIMIT))
+        return -MUF_SPATIAL_HASH_COORD_LIMIT;
+    if (c > (muf_f32) (MUF_SPATIAL_HASH_COORD_LIMIT - 1))
+        return MUF_SPATIAL_HASH_COORD_LIMIT - 1;
+    return (muf_i32) c;
+}
+
+MUF_INTERNAL muf_u64 _mufSpatialHashKey(const muf_i32 coord[3]) {
+    muf_u64 key = 0;
+    for (muf_u32 axis = 0; axis < 3; ++axis)
+        key = (key << MUF_SPATIAL_HASH_COORD_BITS) | (muf_u64) (coord[axis] + MUF_SPATIAL_HASH_COORD_LIMIT);
+    return key;
+}
+
+MUF_INTERNAL void _mufSpatialHashUnpackKey(muf_u64 key, muf_i32 coordOut[3]) {
+    const muf_u64 mask = (1ULL << MUF_SPATIAL_HASH_COORD_BITS) - 1;
+    for (muf_u32 axis = 3; axis-- > 0; key >>= MUF_SPATIAL_HASH_COORD_BITS)
+        coordOut[axis] = (muf_i32) (key & mask) - MUF_SPATIAL_HASH_COORD_LIMIT;
+}
+
+MUF_INTERNAL void _mufSpatialHashCellOf(const MufSpatialHash *hash, const MufAABB3 *box, muf_i32 coordOut[3]) {
+    coordOut[0] = _mufSpatialHashCoord(hash, (box->min.x + box->max.x) * 0.5F);
+    coordOut[1] = _mufSpatialHashCoord(hash, (box->min.y + box->max.y) * 0.5F);
+    coordOut[2] = _mufSpatialHashCoord(hash, (box->min.z + box->max.z) * 0.5F);
+}
+
+MUF_INTERNAL muf_u32 _mufSpatialHashSlot(const MufSpatialHash *hash, muf_u64 key) {
+    return (muf_u32) mufHash_u64(&key) & (hash->cellCapacity - 1);
+}
+
+MUF_INTERNAL _MufSpatialCell *_mufSpatialHashFindCell(const MufSpatialHash *hash, muf_u64 key) {
+    if (hash->cellCount == 0)
+        return NULL;
+    for (muf_u32 slot = _mufSpatialHashSlot(hash, key); ; slot = (slot + 1) & (hash->cellCapacity - 1)) {
+        _MufSpatialCell *cell = &hash->cells[slot];
+        if (cell->key == key)
+            return cell;
+        if (cell->key == MUF_SPATIAL_HASH_EMPTY_KEY)
+            return NULL;
+    }
+}
+
+MUF_INTERNAL void _mufSpatialHashResizeCells(MufSpatialHash *hash, muf_u32 newCapacity) {
+    _MufSpatialCell *oldCells = hash->cells;
+    muf_u32 oldCapacity = hash->cellCapacity;
+
+    hash->cells = mufAlloc(_MufSpatialCell, newCapacity);
+    hash->cellCapacity = newCapacity;
+    for (muf_u32 i = 0; i < newCapacity; ++i)
+        hash->cells[i].key = MUF_SPATIAL_HASH_EMPTY_KEY;
+
+    for (muf_u32 i = 0; i < oldCapacity; ++i) {
+        if (oldCells[i].key == MUF_SPATIAL_HASH_EMPTY_KEY)
+            continue;
+        muf_u32 slot = _mufSpatialHashSlot(hash, oldCells[i].key);
+        while (hash->cells[slot].key != MUF_SPATIAL_HASH_EMPTY_KEY)
+            slot = (slot + 1) & (newCapacity - 1);
+        hash->cells[slot] = oldCells[i];
+    }
+    mufFree(oldCells);
+}
+
+MUF_INTERNAL _MufSpatialCell *_mufSpatialHashAcquireCell(MufSpatialHash *hash, muf_u64 key) {
+    /* Keep the load factor at most 1/2, the probe sequences stay short */
+    if ((hash->cellCount + 1) * 2 > hash->cellCapacity)
+        _mufSpatialHashResizeCells(hash, hash->cellCapacity * 2);
+
+    muf_u32 slot = _mufSpatialHashSlot(hash, key);
+    for (; hash->cells[slot].key != MUF_SPATIAL_HASH_EMPTY_KEY; slot = (slot + 1) & (hash->cellCapacity - 1)) {
+        if (hash->cells[slot].key == key)
+            return &hash->cells[slot];
+    }
+
+    _MufSpatialCell *cell = &hash->cells[slot];
+    cell->key = key;
+    cell->head = MUF_SPATIAL_HASH_INVALID_ID;
+    cell->count = 0;
+    ++hash->cellCount;
+
+    muf_i32 coord[3];
+    _mufSpatialHashUnpackKey(key, coord);
+    for (muf_u32 axis = 0; axis < 3; ++axis) {
+        hash->cellMin[axis] = mufMin(hash->cellMin[axis], coord[axis]);
+        hash->cellMax[axis] = mufMax(hash->cellMax[axis], coord[axis]);
+    }
+    return cell;
+}
+
+/* Backward shift deletion, the table needs no tombstones */
+MUF_INTERNAL void _mufSpatialHashReleaseCell(MufSpatialHash *hash, _MufSpatialCell *cell) {
+    muf_u32 mask = hash->cellCapacity - 1;
+    muf_u32 hole = (muf_u32) (cell - hash->cells);
+    for (muf_u32 slot = (hole + 1) & mask; hash->cells[slot].key != MUF_SPATIAL_HASH_EMPTY_KEY; slot = (slot + 1) & mask) {
+        muf_u32 home = _mufSpatialHashSlot(hash, hash->cells[slot].key);
+        /* The entry can fill the hole only if the hole is between its home slot and its slot */
+        if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+            hash->cells[hole] = hash->cells[slot];
+            hole = slot;
+        }
+    }
+    hash->cells[hole].key = MUF_SPATIAL_HASH_EMPTY_KEY;
+    --hash->cellCount;
+}
+
+MUF_INTERNAL void _mufSpatialHashLink(MufSpatialHash *hash, muf_u32 id) {
+    _MufSpatialObject *object = &hash->objects[id];
+    muf_i32 coord[3];
+    _mufSpatialHashCellOf(hash, &object->bounds, coord);
+    _MufSpatialCell *cell = _mufSpatialHashAcquireCell(hash, _mufSpatialHashKey(coord));
+
+    object->cell = cell->key;
+    object->prev = MUF_SPATIAL_HASH_INVALID_ID;
+    object->next = cell->head;
+    if (cell->head != MUF_SPATIAL_HASH_INVALID_ID)
+        hash->objects[cell->head].prev = id;
+    cell->head = id;
+    ++cell->count;
+
+    MufVec3 halfExtent = mufVec3Scale(mufVec3Sub(object->bounds.max, object->bounds.min), 0.5F);
+    hash->looseness.x = mufMax(hash->looseness.x, halfExtent.x);
+    hash->looseness.y = mufMax(hash->looseness.y, halfExtent.y);
+    hash->looseness.z = mufMax(hash->looseness.z, halfExtent.z);
+}
+
+MUF_INTERNAL void _mufSpatialHashUnlink(MufSpatialHash *hash, muf_u32 id) {
+    _MufSpatialObject *object = &hash->objects[id];
+    _MufSpatialCell *cell = _mufSpatialHashFindCell(hash, object->cell);
+    MUF_FASSERT(cell != NULL, "The cell of object %u is missing", id);
+
+    if (object->prev != MUF_SPATIAL_HASH_INVALID_ID)
+        hash->objects[object->prev].next = object->next;
+    else
+        cell->head = object->next;
+    if (object->next != MUF_SPATIAL_HASH_INVALID_ID)
+        hash->objects[object->next].prev = object->prev;
+
+    if (--cell->count == 0)
+        _mufSpatialHashReleaseCell(hash, cell);
+}
+
+MUF_INTERNAL void _mufSpatialHashReserveObjects(MufSpatialHash *hash, muf_u32 capacity) {
+    if (capacity <= hash->objectCapacity)
+        return;
+    muf_u32 newCapacity = mufMax(hash->objectCapacity * 2, capacity);
+    hash->objects = mufRealloc(_MufSpatialObject, hash->objects, newCapacity);
+    hash->objectCapacity = newCapacity;
+}
+
+MUF_INTERNAL void _mufSpatialHashReset(MufSpatialHash *hash, muf_u32 cellCapacity) {
+    hash->looseness = mufCreateVec3(0.0F, 0.0F, 0.0F);
+    hash->objectEnd = 0;
+    hash->objectCount = 0;
+    hash->freeHead = MUF_SPATIAL_HASH_INVALID_ID;
+
+    if (cellCapacity != hash->cellCapacity) {
+        mufFree(hash->cells);
+        hash->cells = mufAlloc(_MufSpatialCell, cellCapacity);
+        hash->cellCapacity = cellCapacity;
+    }
+    for (muf_u32 i = 0; i < hash->cellCapacity; ++i)
+        hash->cells[i].key = MUF_SPATIAL_HASH_EMPTY_KEY;
+    hash->cellCount = 0;
+    for (muf_u32 axis = 0; axis < 3; ++axis) {
+        hash->cellMin[axis] = MUF_SPATIAL_HASH_COORD_LIMIT;
+        hash->cellMax[axis] = -MUF_SPATIAL_HASH_COORD_LIMIT;
+    }
+}
+
+MufSpatialHash *mufCreateSpatialHash(muf_f32 cellSize) {
+    MUF_FASSERT(cellSize > 0.0F, "The cell size must be positive");
+    MufSpatialHash *hash = mufAllocZero(MufSpatialHash, 1);
+    hash->cellSize = cellSize;
+    hash->inverseCellSize = 1.0F / cellSize;
+    _mufSpatialHashReset(hash, MUF_SPATIAL_HASH_MIN_CELLS);
+    return hash;
+}
+
+void mufDestroySpatialHash(MufSpatialHash *hash) {
+    if (!hash)
+        return;
+    mufFree(hash->objects);
+    mufFree(hash->cells);
+    mufFree(hash);
+}
+
+void mufSpatialHashBuild(MufSpatialHash *hash, const MufAABB3 *bounds, muf_u32 count) {
+    /* Size both tables once, the objects are then linked without any growth */
+    muf_u32 cellCapacity = MUF_SPATIAL_HASH_MIN_CELLS;
+    while (cellCapacity < count * 2)
+        cellCapacity *= 2;
+    _mufSpatialHashReset(hash, cellCapacity);
+    _mufSpatialHashReserveObjects(hash, count);
+
+    for (muf_u32 i = 0; i < count; ++i) {
+        hash->objects[i].bounds = bounds[i];
+        _mufSpatialHashLink(hash, i);
+    }
+    hash->objectEnd = count;
+    hash->objectCount = count;
+}
+
+void mufSpatialHashClear(MufSpatialHash *hash) {
+    _mufSpatialHashReset(hash, hash->cellCapacity);
+}
+
+muf_u32 mufSpatialHashInsert(MufSpatialHash *hash, MufAABB3 bounds) {
+    muf_u32 id = hash->freeHead;
+    if (id != MUF_SPATIAL_HASH_INVALID_ID) {
+        hash->freeHead = hash->objects[id].next;
+    } else {
+        _mufSpatialHashReserveObjects(hash, hash->objectEnd + 1);
+        id = hash->objectEnd++;
+    }
+
+    hash->objects[id].bounds = bounds;
+    _mufSpatialHashLink(hash, id);
+    ++hash->objectCount;
+    return id;
+}
+
+void mufSpatialHashRemove(MufSpatialHash *hash, muf_u32 id) {
+    MUF_FASSERT(id < hash->objectEnd && hash->objects[id].cell != MUF_SPATIAL_HASH_EMPTY_KEY,
+        "Object %u is not in the index", id);
+    _mufSpatialHashUnlink(hash, id);
+    hash->objects[id].cell = MUF_SPATIAL_HASH_EMPTY_KEY;
+    hash->objects[id].next = hash->freeHead;
+    hash->freeHead = id;
+    --hash->objectCount;
+}
+
+void mufSpatialHashMove(MufSpatialHash *hash, muf_u32 id, MufAABB3 bounds) {
+    MUF_FASSERT(id < hash->objectEnd && hash->objects[id].cell != MUF_SPATIAL_HASH_EMPTY_KEY,
+        "Object %u is not in the index", id);
+    _MufSpatialObject *object = &hash->objects[id];
+    muf_i32 coord[3];
+    _mufSpatialHashCellOf(hash, &bounds, coord);
+    if (_mufSpatialHashKey(coord) == object->cell) {
+        object->bounds = bounds;
+        MufVec3 halfExtent = mufVec3Scale(mufVec3Sub(bounds.max, bounds.min), 0.5F);
+        hash->looseness.x = mufMax(hash->looseness.x, halfExtent.x);
+        hash->looseness.y = mufMax(hash->looseness.y, halfExtent.y);
+        hash->looseness.z = mufMax(hash->looseness.z, halfExtent.z);
+        return;
+    }
+
+    _mufSpatialHashUnlink(hash, id);
+    object->bounds = bounds;
+    _mufSpatialHashLink(hash, id);
+}
+
+MufAABB3 mufSpatialHashGetBounds(const MufSpatialHash *hash, muf_u32 id) {
+    MUF_FASSERT(id < hash->objectEnd && hash->objects[id].cell != MUF_SPATIAL_HASH_EMPTY_KEY,
+        "Object %u is not in the index", id);
+    return hash->objects[id].bounds;
+}
+
+muf_u32 mufSpatialHashGetObjectCount(const MufSpatialHash *hash) {
+    return hash->objectCount;
+}
+
+muf_u32 mufSpatialHashGetCellCount(const MufSpatialHash *hash) {
+    return hash->cellCount;
+}
+
+/* The region the objects of a cell can reach */
+MUF_INTERNAL MufAABB3 _mufSpatialHashLooseCellBounds(const MufSpatialHash *hash, const muf_i32 coord[3]) {
+    MufVec3 min = mufCreateVec3((muf_f32) coord[0], (muf_f32) coord[1], (muf_f32) coord[2]);
+    min = mufVec3Scale(min, hash->cellSize);
+    MufAABB3 box;
+    box.min = mufVec3Sub(min, hash->looseness);
+    box.max = mufVec3Add(mufVec3Add(min, mufCreateVec3(hash->cellSize, hash->cellSize, hash->cellSize)),
+        hash->looseness);
+    return box;
+}
+
+MUF_INTERNAL void _mufSpatialHashCollectCell(const MufSpatialHash *hash, const _MufSpatialCell *cell,
+    MufAABB3 box, MufArray *idsOut) {
+    for (muf_u32 id = cell->head; id != MUF_SPATIAL_HASH_INVALID_ID; id = hash->objects[id].next) {
+        if (mufAABB3Overlaps(hash->objects[id].bounds, box))
+            mufArrayPush(idsOut, &id);
+    }
+}
+
+muf_usize mufSpatialHashQueryAABB3(const MufSpatialHash *hash, MufAABB3 box, MufArray *idsOut) {
+    MUF_FASSERT(idsOut->elementSize == sizeof(muf_u32), "The id array must hold muf_u32");
+    muf_usize startSize = mufArrayGetSize(idsOut);
+    if (hash->objectCount == 0)
+        return 0;
+
+    /* An overlapping object has its center within the looseness of the box */
+    MufAABB3 centers;
+    centers.min = mufVec3Sub(box.min, hash->looseness);
+    centers.max = mufVec3Add(box.max, hash->looseness);
+    muf_i32 lo[3], hi[3];
+    lo[0] = _mufSpatialHashCoord(hash, centers.min.x);
+    lo[1] = _mufSpatialHashCoord(hash, centers.min.y);
+    lo[2] = _mufSpatialHashCoord(hash, centers.min.z);
+    hi[0] = _mufSpatialHashCoord(hash, centers.max.x);
+    hi[1] = _mufSpatialHashCoord(hash, centers.max.y);
+    hi[2] = _mufSpatialHashCoord(hash, centers.max.z);
+    muf_u64 volume = 1;
+    for (muf_u32 axis = 0; axis < 3; ++axis) {
+        lo[axis] = mufMax(lo[axis], hash->cellMin[axis]);
+        hi[axis] = mufMin(hi[axis], hash->cellMax[axis]);
+        if (lo[axis] > hi[axis])
+            return 0;
+        volume *= (muf_u64) (hi[axis] - lo[axis] + 1);
+    }
+
+    if (volume > hash->cellCount) {
+        /* The box covers more cells than are occupied, visit the occupied ones instead */
+        for (muf_u32 i = 0; i < hash->cellCapacity; ++i) {
+            const _MufSpatialCell *cell = &hash->cells[i];
+            if (cell->key == MUF_SPATIAL_HASH_EMPTY_KEY)
+                continue;
+            muf_i32 coord[3];
+            _mufSpatialHashUnpackKey(cell->key, coord);
+            if (coord[0] >= lo[0] && coord[0] <= hi[0] && coord[1] >= lo[1] && coord[1] <= hi[1] &&
+                coord[2] >= lo[2] && coord[2] <= hi[2])
+                _mufSpatialHashCollectCell(hash, cell, box, idsOut);
+        }
+    } else {
+        muf_i32 coord[3];
+        for (coord[0] = lo[0]; coord[0] <= hi[0]; ++coord[0]) {
+            for (coord[1] = lo[1]; coord[1] <= hi[1]; ++coord[1]) {
+                for (coord[2] = lo[2]; coord[2] <= hi[2]; ++coord[2]) {
+                    const _MufSpatialCell *cell = _mufSpatialHashFindCell(hash, _mufSpatialHashKey(coord));
+                    if (cell)
+                        _mufSpatialHashCollectCell(hash, cell, box, idsOut);
+                }
+            }
+        }
+    }
+    return mufArrayGetSize(idsOut) - startSize;
+}
+
+muf_usize mufSpatialHashQueryFrustum(const MufSpatialHash *hash, const MufFrustum *frustum, MufArray *idsOut) {
+    MUF_FASSERT(idsOut->elementSize == sizeof(muf_u32), "The id array must hold muf_u32");
+    muf_usize startSize = mufArrayGetSize(idsOut);
+    for (muf_u32 i = 0; i < hash->cellCapacity; ++i) {
+        const _MufSpatialCell *cell = &hash->cells[i];
+        if (cell->key == MUF_SPATIAL_HASH_EMPTY_KEY)
+            continue;
+
+        muf_i32 coord[3];
+        _mufSpatialHashUnpackKey(cell->key, coord);
+        MufCullResult cellResult = mufFrustumTestAABB3(frustum, _mufSpatialHashLooseCellBounds(hash, coord));
+        if (cellResult == MUF_CULL_RESULT_OUTSIDE)
+            continue;
+        for (muf_u32 id = cell->head; id != MUF_SPATIAL_HASH_INVALID_ID; id = hash->objects[id].next) {
+            if (cellResult == MUF_CULL_RESULT_INSIDE ||
+                mufFrustumTestAABB3(frustum, hash->objects[id].bounds) != MUF_CULL_RESULT_OUTSIDE)
+                mufArrayPush(idsOut, &id);
+        }
+    }
+    return mufArrayGetSize(idsOut) - startSize;
+}
+
+MUF_INTERNAL muf_f32 _mufSpatialHashDistanceSquared(const MufAABB3 *box, MufVec3 point) {
+    muf_f32 dx = mufMax(mufMax(box->min.x - point.x, point.x - box->max.x), 0.0F);
+    muf_f32 dy = mufMax(mufMax(box->min.y - point.y, point.y - box->max.y), 0.0F);
+    muf_f32 dz = mufMax(mufMax(box->min.z - point.z, point.z - box->max.z), 0.0F);
+    return dx * dx + dy * dy + dz * dz;
+}
+
+/* The k best candidates, a max-heap on the distance kept in the output arrays */
+typedef struct _MufSpatialNearest_s {
+    muf_u32 *ids;
+    muf_f32 *distances;
+    muf_u32 size;
+    muf_u32 k;
+    /* The squared distance a candidate must be under */
+    muf_f32 limit;
+} _MufSpatialNearest;
+
+MUF_INTERNAL void _mufSpatialNearestSiftDown(_MufSpatialNearest *nearest, muf_u32 i, muf_u32 size) {
+    for (;;) {
+        muf_u32 child = i * 2 + 1;
+        if (child >= size)
+            return;
+        if (child + 1 < size && nearest->distances[child + 1] > nearest->distances[child])
+            ++child;
+        if (nearest->distances[child] <= nearest->distances[i])
+            return;
+        mufSwap(muf_f32, nearest->distances[i], nearest->distances[child]);
+        mufSwap(muf_u32, nearest->ids[i], nearest->ids[child]);
+        i = child;
+    }
+}
+
+MUF_INTERNAL void _mufSpatialNearestOffer(_MufSpatialNearest *nearest, muf_u32 id, muf_f32 distance) {
+    if (distance >= nearest->limit)
+        return;
+
+    if (nearest->size < nearest->k) {
+        muf_u32 i = nearest->size++;
+        nearest->ids[i] = id;
+        nearest->distances[i] = distance;
+        while (i > 0 && nearest->distances[(i - 1) / 2] < nearest->distances[i]) {
+            muf_u32 parent = (i - 1) / 2;
+            mufSwap(muf_f32, nearest->distances[i], nearest->distances[parent]);
+            mufSwap(muf_u32, nearest->ids[i], nearest->ids[parent]);
+            i = parent;
+        }
+    } else {
+        nearest->ids[0] = id;
+        nearest->distances[0] = distance;
+        _mufSpatialNearestSiftDown(nearest, 0, nearest->size);
+    }
+    if (nearest->size == nearest->k)
+        nearest->limit = nearest->distances[0];
+}
+
+MUF_INTERNAL void _mufSpatialNearestOfferCell(const MufSpatialHash *hash, _MufSpatialNearest *nearest,
+    const _MufSpatialCell *cell, MufVec3 point) {
+    for (muf_u32 id = cell->head; id != MUF_SPATIAL_HASH_INVALID_ID; id = hash->objects[id].next)
+        _mufSpatialNearestOffer(nearest, id, _mufSpatialHashDistanceSquared(&hash->objects[id].bounds, point));
+}
+
+muf_u32 mufSpatialHashQueryNearest(const MufSpatialHash *hash, MufVec3 point, muf_u32 k, muf_f32 maxDistance,
+    muf_u32 *idsOut, muf_f32 *distancesOut) {
+    if (k == 0 || hash->objectCount == 0)
+        return 0;
+
+    muf_f32 localDistances[16];
+    _MufSpatialNearest nearest;
+    nearest.ids = idsOut;
+    nearest.distances = distancesOut ? distancesOut : k <= MUF_COUNTOF(localDistances) ? localDistances :
+        mufAlloc(muf_f32, k);
+    nearest.size = 0;
+    nearest.k = k;
+    nearest.limit = maxDistance < sqrtf(FLT_MAX) ? maxDistance * maxDistance : FLT_MAX;
+    /* Keep the objects exactly at the maximal distance */
+    nearest.limit = nextafterf(nearest.limit, FLT_MAX);
+
+    muf_i32 center[3] = {
+        _mufSpatialHashCoord(hash, point.x), _mufSpatialHashCoord(hash, point.y), _mufSpatialHashCoord(hash, point.z)
+    };
+    /* The rings start at the first one that reaches an occupied cell and end after the last one */
+    muf_i32 firstRing = 0, lastRing = 0;
+    for (muf_u32 axis = 0; axis < 3; ++axis) {
+        firstRing = mufMax(firstRing, mufMax(hash->cellMin[axis] - center[axis], center[axis] - hash->cellMax[axis]));
+        lastRing = mufMax(lastRing, mufMax(center[axis] - hash->cellMin[axis], hash->cellMax[axis] - center[axis]));
+    }
+    muf_f32 looseness = mufMax(hash->looseness.x, mufMax(hash->looseness.y, hash->looseness.z));
+    muf_u64 visitedCells = 0;
+
+    for (muf_i32 ring = firstRing; ring <= lastRing; ++ring) {
+        /* An object of the ring has its center at least ring - 1 cells away from the point on some axis */
+        muf_f32 bound = (muf_f32) (ring - 1) * hash->cellSize - looseness;
+        if (bound > 0.0F && bound * bound >= nearest.limit)
+            break;
+
+        muf_i32 lo[3], hi[3];
+        muf_u64 ringCells = 1;
+        for (muf_u32 axis = 0; axis < 3; ++axis) {
+            lo[axis] = mufMax(center[axis] - ring, hash->cellMin[axis]);
+            hi[axis] = mufMin(center[axis] + ring, hash->cellMax[axis]);
+            ringCells *= (muf_u64) (hi[axis] - lo[axis] + 1);
+        }
+        visitedCells += ringCells;
+
+        if (visitedCells > hash->cellCount) {
+            /* The rings cost more than visiting every occupied cell, finish with the cells not visited yet */
+            for (muf_u32 i = 0; i < hash->cellCapacity; ++i) {
+                const _MufSpatialCell *cell = &hash->cells[i];
+                if (cell->key == MUF_SPATIAL_HASH_EMPTY_KEY)
+                    continue;
+                muf_i32 coord[3];
+                _mufSpatialHashUnpackKey(cell->key, coord);
+                muf_i32 distance = 0;
+                for (muf_u32 axis = 0; axis < 3; ++axis)
+                    distance = mufMax(distance, abs(coord[axis] - center[axis]));
+                if (distance >= ring)
+                    _mufSpatialNearestOfferCell(hash, &nearest, cell, point);
+            }
+            break;
+        }
+
+        muf_i32 coord[3];
+        for (coord[0] = lo[0]; coord[0] <= hi[0]; ++coord[0]) {
+            for (coord[1] = lo[1]; coord[1] <= hi[1]; ++coord[1]) {
+                muf_bool onShell = abs(coord[0] - center[0]) == ring || abs(coord[1] - center[1]) == ring;
+                /* Inside the shell only the two caps along z belong to the ring */
+                muf_i32 step = onShell ? 1 : mufMax(2 * ring, 1);
+                for (coord[2] = onShell ? lo[2] : center[2] - ring; coord[2] <= hi[2]; coord[2] += step) {
+                    if (coord[2] < lo[2])
+                        continue;
+                    const _MufSpatialCell *cell = _mufSpatialHashFindCell(hash, _mufSpatialHashKey(coord));
+                    if (cell)
+                        _mufSpatialNearestOfferCell(hash, &nearest, cell, point);
+                }
+            }
+        }
+    }
+
+    /* Heap sort, the closest first */
+    for (muf_u32 end = nearest.size; end > 1; --end) {
+        mufSwap(muf_f32, nearest.distances[0], nearest.distances[end - 1]);
+        mufSwap(muf_u32, nearest.ids[0], nearest.ids[end - 1]);
+        _mufSpatialNearestSiftDown(&nearest, 0, end - 1);
+    }
+    if (distancesOut) {
+        for (muf_u32 i = 0; i < nearest.size; ++i)
+            distancesOut[i] = sqrtf(distancesOut[i]);
+    } else if (nearest.distances != localDistances) {
+        mufFree(nearest.distances);
+    }
+    return nearest.size;
+}
@@ -1,5 +1,18 @@
+#define MUF_MEMORY_TAG MUF_MEMORY_TAG_CORE_CONTAINERS
+
 #include "muffin_core/string.h"
 
+#include <stdio.h>
+
+#include "muffin_core/cpu.h"
+#include "muffin_core/hash.h"
+#include "muffin_core/math.h"
+#include "muffin_core/simd.h"
+#include "muffin_core/sync.h"
+
+/* The formatted text up to this size, terminator included, is built on the stack */
+#define MUF_STR_FORMAT_LOCAL_SIZE 256
+
 #define MUF_UTF8_ACCEPT 0
 #define MUF_UTF8_REJECT 12
 
@@ -31,69 +44,1052 @@ static MUF_INLINE muf_u32 _mufUtf8Decode(muf_byte byte, muf_u32 *state, muf_u32
     return *state;
 }
 
-muf_usize mufUtf8Length(const muf_char *str) {
-    const muf_byte *bytes = (const muf_byte *) str;
-    muf_u32 state = 0;
+/*
+ * The SIMD validation follows Keiser and Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte". Each byte is
+ * classified with three 16-entry tables indexed by nibbles of it and of the byte before, the AND of the three lookups
+ * is non-zero for every invalid pair. Sequences of three and four bytes are checked with shifted copies of the input.
+ */
+#define MUF_UTF8_ERROR_TOO_SHORT      (1 << 0)
+#define MUF_UTF8_ERROR_TOO_LONG       (1 << 1)
+#define MUF_UTF8_ERROR_OVERLONG_3     (1 << 2)
+#define MUF_UTF8_ERROR_TOO_LARGE      (1 << 3)
+#define MUF_UTF8_ERROR_SURROGATE      (1 << 4)
+#define MUF_UTF8_ERROR_OVERLONG_2     (1 << 5)
+#define MUF_UTF8_ERROR_TOO_LARGE_1000 (1 << 6)
+#define MUF_UTF8_ERROR_OVERLONG_4     (1 << 6)
+#define MUF_UTF8_ERROR_TWO_CONTS      (1 << 7)
+#define MUF_UTF8_ERROR_CARRY          (MUF_UTF8_ERROR_TOO_SHORT | MUF_UTF8_ERROR_TOO_LONG | MUF_UTF8_ERROR_TWO_CONTS)
+
+/*
+ * The transcoding kernels convert a run of characters of one width, the caller converts whatever stops them.
+ * Mixed runs, such as words of a 2-byte script separated by ASCII spaces, are left to the scalar decoder.
+ */
+typedef struct _MufUtf8Kernels_s {
+    MufCpuFeatureFlags required;
+    muf_bool (*validate)(const muf_byte *data, muf_usize length);
+    /* Convert the leading ASCII characters, at most length of them, and return how many were converted */
+    muf_usize (*widenAscii)(muf_u16 *dst, const muf_byte *src, muf_usize length);
+    muf_usize (*narrowAscii)(muf_byte *dst, const muf_u16 *src, muf_usize length);
+    /*
+     * Convert whole blocks of valid characters of 2 or 3 bytes, reading at most length bytes or units. Return how
+     * many bytes (widen) or units (narrow) were converted, the tail of a run is left to the caller.
+     */
+    muf_usize (*widenTwoByte)(muf_u16 *dst, const muf_byte *src, muf_usize length);
+    muf_usize (*widenThreeByte)(muf_u16 *dst, const muf_byte *src, muf_usize length);
+    muf_usize (*narrowTwoByte)(muf_byte *dst, const muf_u16 *src, muf_usize length);
+    muf_usize (*narrowThreeByte)(muf_byte *dst, const muf_u16 *src, muf_usize length);
+} _MufUtf8Kernels;
+
+/* Skip the leading ASCII bytes, at most length of them */
+MUF_INTERNAL MUF_INLINE muf_usize _mufUtf8SkipAscii(const muf_byte *data, muf_usize length) {
+    muf_usize i = 0;
+#if defined(MUF_SIMD_SSE2)
+    for (; i + 16 <= length; i += 16) {
+        if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i *) (data + i))) != 0)
+            break;
+    }
+#else
+    for (; i + 8 <= length; i += 8) {
+        muf_u64 word;
+        memcpy(&word, data + i, sizeof(word));
+        if ((word & 0x8080808080808080ULL) != 0)
+            break;
+    }
+#endif
+    while (i < length && data[i] < 0x80)
+        ++i;
+    return i;
+}
+
+MUF_INTERNAL muf_bool _mufUtf8ValidateBaseline(const muf_byte *data, muf_usize length) {
+    muf_u32 state = MUF_UTF8_ACCEPT;
     muf_u32 codepoint = 0;
-    muf_usize count = 0;
 
-    for (muf_index i = 0; bytes[i]; ++i) {
-        _mufUtf8Decode(bytes[i], &state, &codepoint);
-        if (state == MUF_UTF8_ACCEPT)
-            ++count;
+    for (muf_usize i = 0; i < length; ++i) {
+        if (state == MUF_UTF8_ACCEPT && data[i] < 0x80) {
+            i += _mufUtf8SkipAscii(data + i, length - i);
+            if (i == length)
+                break;
+        }
+        if (_mufUtf8Decode(data[i], &state, &codepoint) == MUF_UTF8_REJECT)
+            return MUF_FALSE;
     }
-    if (state != MUF_UTF8_ACCEPT) {
-        return (muf_usize) -1;
+    return state == MUF_UTF8_ACCEPT;
+}
+
+MUF_INTERNAL muf_usize _mufUtf8WidenAsciiBaseline(muf_u16 *dst, const muf_byte *src, muf_usize length) {
+    muf_usize i = 0;
+#if defined(MUF_SIMD_SSE2)
+    __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *) (src + i));
+        if (_mm_movemask_epi8(bytes) != 0)
+            break;
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_unpacklo_epi8(bytes, zero));
+        _mm_storeu_si128((__m128i *) (dst + i + 8), _mm_unpackhi_epi8(bytes, zero));
+    }
+#endif
+    for (; i < length && src[i] < 0x80; ++i)
+        dst[i] = src[i];
+    return i;
+}
+
+MUF_INTERNAL muf_usize _mufUtf8NarrowAsciiBaseline(muf_byte *dst, const muf_u16 *src, muf_usize length) {
+    muf_usize i = 0;
+#if defined(MUF_SIMD_SSE2)
+    __m128i nonAscii = _mm_set1_epi16((short) 0xFF80);
+    for (; i + 16 <= length; i += 16) {
+        __m128i low = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i high = _mm_loadu_si128((const __m128i *) (src + i + 8));
+        __m128i outside = _mm_and_si128(_mm_or_si128(low, high), nonAscii);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(outside, _mm_setzero_si128())) != 0xFFFF)
+            break;
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_packus_epi16(low, high));
+    }
+#endif
+    for (; i < length && src[i] < 0x80; ++i)
+        dst[i] = (muf_byte) src[i];
+    return i;
+}
+
+MUF_INTERNAL muf_usize _mufUtf8WidenNone(muf_u16 *dst, const muf_byte *src, muf_usize length) {
+    (void) dst, (void) src, (void) length;
+    return 0;
+}
+
+MUF_INTERNAL muf_usize _mufUtf8NarrowNone(muf_byte *dst, const muf_u16 *src, muf_usize length) {
+    (void) dst, (void) src, (void) length;
+    return 0;
+}
+
+#if defined(MUF_SIMD_SSE2)
+
+/* Eight characters of 2 bytes, each little endian word holds the lead byte low and the continuation byte high */
+MUF_INTERNAL muf_usize _mufUtf8WidenTwoByteSSE2(muf_u16 *dst, const muf_byte *src, muf_usize length) {
+    __m128i tagMask = _mm_set1_epi16((short) 0xC0E0);
+    __m128i tags = _mm_set1_epi16((short) 0x80C0);
+    /* C0 and C1 only start overlong forms */
+    __m128i overlongMask = _mm_set1_epi16(0x001E);
+    muf_usize i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i words = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i valid = _mm_andnot_si128(_mm_cmpeq_epi16(_mm_and_si128(words, overlongMask), _mm_setzero_si128()),
+            _mm_cmpeq_epi16(_mm_and_si128(words, tagMask), tags));
+        if (_mm_movemask_epi8(valid) != 0xFFFF)
+            break;
+        __m128i units = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(words, _mm_set1_epi16(0x1F)), 6),
+            _mm_and_si128(_mm_srli_epi16(words, 8), _mm_set1_epi16(0x3F)));
+        _mm_storeu_si128((__m128i *) (dst + i / 2), units);
+    }
+    return i;
+}
+
+MUF_INTERNAL muf_usize _mufUtf8NarrowTwoByteSSE2(muf_byte *dst, const muf_u16 *src, muf_usize length) {
+    muf_usize i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m128i units = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i valid = _mm_andnot_si128(_mm_cmpeq_epi16(_mm_and_si128(units, _mm_set1_epi16((short) 0xFF80)), _mm_setzero_si128()),
+            _mm_cmpeq_epi16(_mm_and_si128(units, _mm_set1_epi16((short) 0xF800)), _mm_setzero_si128()));
+        if (_mm_movemask_epi8(valid) != 0xFFFF)
+            break;
+        __m128i lead = _mm_or_si128(_mm_srli_epi16(units, 6), _mm_set1_epi16(0xC0));
+        __m128i continuation = _mm_or_si128(_mm_and_si128(units, _mm_set1_epi16(0x3F)), _mm_set1_epi16(0x80));
+        _mm_storeu_si128((__m128i *) (dst + i * 2), _mm_or_si128(lead, _mm_slli_epi16(continuation, 8)));
+    }
+    return i;
+}
+
+#endif
+
+static const _MufUtf8Kernels _mufUtf8Baseline = {
+    MUF_CPU_FEATURE_NONE,
+    _mufUtf8ValidateBaseline,
+    _mufUtf8WidenAsciiBaseline,
+    _mufUtf8NarrowAsciiBaseline,
+#if defined(MUF_SIMD_SSE2)
+    _mufUtf8WidenTwoByteSSE2,
+    _mufUtf8WidenNone,
+    _mufUtf8NarrowTwoByteSSE2,
+    _mufUtf8NarrowNone
+#else
+    _mufUtf8WidenNone,
+    _mufUtf8WidenNone,
+    _mufUtf8NarrowNone,
+    _mufUtf8NarrowNone
+#endif
+};
+
+#if defined(MUF_SIMD_MULTI_TARGET)
+
+#define _MUF_UTF8_BYTE_1_HIGH \
+    MUF_UTF8_ERROR_TOO_LONG, MUF_UTF8_ERROR_TOO_LONG, MUF_UTF8_ERROR_TOO_LONG, MUF_UTF8_ERROR_TOO_LONG, \
+    MUF_UTF8_ERROR_TOO_LONG, MUF_UTF8_ERROR_TOO_LONG, MUF_UTF8_ERROR_TOO_LONG, MUF_UTF8_ERROR_TOO_LONG, \
+    (char) MUF_UTF8_ERROR_TWO_CONTS, (char) MUF_UTF8_ERROR_TWO_CONTS, (char) MUF_UTF8_ERROR_TWO_CONTS, (char) MUF_UTF8_ERROR_TWO_CONTS, \
+    MUF_UTF8_ERROR_TOO_SHORT | MUF_UTF8_ERROR_OVERLONG_2, \
+    MUF_UTF8_ERROR_TOO_SHORT, \
+    MUF_UTF8_ERROR_TOO_SHORT | MUF_UTF8_ERROR_OVERLONG_3 | MUF_UTF8_ERROR_SURROGATE, \
+    MUF_UTF8_ERROR_TOO_SHORT | MUF_UTF8_ERROR_TOO_LARGE | MUF_UTF8_ERROR_TOO_LARGE_1000 | MUF_UTF8_ERROR_OVERLONG_4
+
+#define _MUF_UTF8_BYTE_1_LOW \
+    (char) (MUF_UTF8_ERROR_CARRY | MUF_UTF8_ERROR_OVERLONG_3 | MUF_UTF8_ERROR_OVERLONG_2 | MUF_UTF8_ERROR_OVERLONG_4), \
+    (char) (MUF_UTF8_ERROR_CARRY | MUF_UTF8_ERROR_OVERLONG_2), \
+    (char) MUF_UTF8_ERROR_CARRY, \
+    (char) MUF_UTF8_ERROR_CARRY, \
+    (char) (MUF_UTF8_ERROR_CARRY | MUF_UTF8_ERROR_TOO_LARGE), \
+    (char) (MUF_UTF8_ERROR_CARRY | MUF_UTF8_ERROR_TOO_LARGE | MUF_UTF8_ERROR_TOO_LARGE_1000), \
+    (char) (MUF_UTF8_ERROR_CARRY | MUF_UTF8_ERROR_TOO_LARGE | MUF_UTF8_ERROR_TOO_LARGE_1000), \
+    (char) (MUF_UTF8_ERROR_CARRY | MUF_UTF8_ERROR_TOO_LARGE | MUF_UTF8_ERROR_TOO_LARGE_1000), \
+    (char) (MUF_UTF8_ERROR_CARRY | MUF_UTF8_ERROR_TOO_LARGE | MUF_UTF8_ERROR_TOO_LARGE_1000), \
+    (char) (MUF_UTF8_ERROR_CARRY | MUF_UTF8_ERROR_TOO_LARGE | MUF_UTF8_ERROR_TOO_LARGE_1000), \
+    (char) (MUF_UTF8_ERROR_CARRY | MUF_UTF8_ERROR_TOO_LARGE | MUF_UTF8_ERROR_TOO_LARGE_1000), \
+    (char) (MUF_UTF8_ERROR_CARRY | MUF_UTF8_ERROR_TOO_LARGE | MUF_UTF8_ERROR_TOO_LARGE_1000), \
+    (char) (MUF_UTF8_ERROR_CARRY | MUF_UTF8_ERROR_TOO_LARGE | MUF_UTF8_ERROR_TOO_LARGE_1000), \
+    (char) (MUF_UTF8_ERROR_CARRY | MUF_UTF8_ERROR_TOO_LARGE | MUF_UTF8_ERROR_TOO_LARGE_1000 | MUF_UTF8_ERROR_SURROGATE), \
+    (char) (MUF_UTF8_ERROR_CARRY | MUF_UTF8_ERROR_TOO_LARGE | MUF_UTF8_ERROR_TOO_LARGE_1000), \
+    (char) (MUF_UTF8_ERROR_CARRY | MUF_UTF8_ERROR_TOO_LARGE | MUF_UTF8_ERROR_TOO_LARGE_1000)
+
+#define _MUF_UTF8_BYTE_2_HIGH \
+    MUF_UTF8_ERROR_TOO_SHORT, MUF_UTF8_ERROR_TOO_SHORT, MUF_UTF8_ERROR_TOO_SHORT, MUF_UTF8_ERROR_TOO_SHORT, \
+    MUF_UTF8_ERROR_TOO_SHORT, MUF_UTF8_ERROR_TOO_SHORT, MUF_UTF8_ERROR_TOO_SHORT, MUF_UTF8_ERROR_TOO_SHORT, \
+    (char) (MUF_UTF8_ERROR_TOO_LONG | MUF_UTF8_ERROR_OVERLONG_2 | MUF_UTF8_ERROR_TWO_CONTS | MUF_UTF8_ERROR_OVERLONG_3 | \
+        MUF_UTF8_ERROR_TOO_LARGE_1000 | MUF_UTF8_ERROR_OVERLONG_4), \
+    (char) (MUF_UTF8_ERROR_TOO_LONG | MUF_UTF8_ERROR_OVERLONG_2 | MUF_UTF8_ERROR_TWO_CONTS | MUF_UTF8_ERROR_OVERLONG_3 | MUF_UTF8_ERROR_TOO_LARGE), \
+    (char) (MUF_UTF8_ERROR_TOO_LONG | MUF_UTF8_ERROR_OVERLONG_2 | MUF_UTF8_ERROR_TWO_CONTS | MUF_UTF8_ERROR_SURROGATE | MUF_UTF8_ERROR_TOO_LARGE), \
+    (char) (MUF_UTF8_ERROR_TOO_LONG | MUF_UTF8_ERROR_OVERLONG_2 | MUF_UTF8_ERROR_TWO_CONTS | MUF_UTF8_ERROR_SURROGATE | MUF_UTF8_ERROR_TOO_LARGE), \
+    MUF_UTF8_ERROR_TOO_SHORT, MUF_UTF8_ERROR_TOO_SHORT, MUF_UTF8_ERROR_TOO_SHORT, MUF_UTF8_ERROR_TOO_SHORT
+
+/* SSSE3, 16 bytes per step */
+
+MUF_SIMD_TARGET("ssse3")
+MUF_INTERNAL MUF_INLINE __m128i _mufUtf8CheckSSSE3(__m128i input, __m128i prevInput) {
+    __m128i nibbleMask = _mm_set1_epi8(0x0F);
+    __m128i prev1 = _mm_alignr_epi8(input, prevInput, 15);
+    __m128i byte1High = _mm_shuffle_epi8(_mm_setr_epi8(_MUF_UTF8_BYTE_1_HIGH),
+        _mm_and_si128(_mm_srli_epi16(prev1, 4), nibbleMask));
+    __m128i byte1Low = _mm_shuffle_epi8(_mm_setr_epi8(_MUF_UTF8_BYTE_1_LOW), _mm_and_si128(prev1, nibbleMask));
+    __m128i byte2High = _mm_shuffle_epi8(_mm_setr_epi8(_MUF_UTF8_BYTE_2_HIGH),
+        _mm_and_si128(_mm_srli_epi16(input, 4), nibbleMask));
+    __m128i special = _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+
+    /* The second and third bytes after a lead of three or four bytes must be continuations */
+    __m128i prev2 = _mm_alignr_epi8(input, prevInput, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, prevInput, 13);
+    __m128i isThird = _mm_subs_epu8(prev2, _mm_set1_epi8((char) (0xE0 - 0x80)));
+    __m128i isFourth = _mm_subs_epu8(prev3, _mm_set1_epi8((char) (0xF0 - 0x80)));
+    __m128i must23 = _mm_and_si128(_mm_or_si128(isThird, isFourth), _mm_set1_epi8((char) 0x80));
+    return _mm_xor_si128(must23, special);
+}
+
+MUF_SIMD_TARGET("ssse3")
+MUF_INTERNAL MUF_INLINE __m128i _mufUtf8IncompleteSSSE3(__m128i input) {
+    /* Non-zero when the block ends inside a sequence */
+    __m128i maxValue = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char) (0xF0 - 1), (char) (0xE0 - 1), (char) (0xC0 - 1));
+    return _mm_subs_epu8(input, maxValue);
+}
+
+MUF_SIMD_TARGET("ssse3")
+MUF_INTERNAL muf_bool _mufUtf8ValidateSSSE3(const muf_byte *data, muf_usize length) {
+    __m128i error = _mm_setzero_si128();
+    __m128i prevInput = _mm_setzero_si128();
+    __m128i prevIncomplete = _mm_setzero_si128();
+
+    muf_usize i = 0;
+    while (i < length) {
+        __m128i input;
+        if (i + 16 <= length) {
+            input = _mm_loadu_si128((const __m128i *) (data + i));
+        } else {
+            /* The tail is padded with zeros, which are ASCII and end any open sequence */
+            MUF_ALIGNAS(16) muf_byte tail[16] = { 0 };
+            memcpy(tail, data + i, length - i);
+            input = _mm_load_si128((const __m128i *) tail);
+        }
+        i += 16;
+
+        if (_mm_movemask_epi8(input) == 0) {
+            error = _mm_or_si128(error, prevIncomplete);
+            prevIncomplete = _mm_setzero_si128();
+        } else {
+            error = _mm_or_si128(error, _mufUtf8CheckSSSE3(input, prevInput));
+            prevIncomplete = _mufUtf8IncompleteSSSE3(input);
+        }
+        prevInput = input;
+    }
+    error = _mm_or_si128(error, prevIncomplete);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+}
+
+/* The bytes of four characters of 3 bytes, each moved to the low bytes of a 32-bit lane */
+#define _MUF_UTF8_GATHER_3_FROM_0 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1
+#define _MUF_UTF8_GATHER_3_FROM_4 4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15, -1
+/* The reverse, the three low bytes of each 32-bit lane packed to the front */
+#define _MUF_UTF8_SCATTER_3       0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1
+
+/* Decode the lanes of _MUF_UTF8_GATHER_3, the tags and the range are checked: no overlong forms and no surrogates */
+MUF_SIMD_TARGET("ssse3")
+MUF_INTERNAL MUF_INLINE __m128i _mufUtf8DecodeThreeByteSSSE3(__m128i lanes, __m128i *valid) {
+    __m128i codepoints = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(_mm_and_si128(lanes, _mm_set1_epi32(0x0F)), 12),
+        _mm_and_si128(_mm_srli_epi32(lanes, 2), _mm_set1_epi32(0x0FC0))), _mm_and_si128(_mm_srli_epi32(lanes, 16), _mm_set1_epi32(0x3F)));
+    __m128i high = _mm_and_si128(codepoints, _mm_set1_epi32(0xF800));
+    __m128i outside = _mm_or_si128(_mm_cmpeq_epi32(high, _mm_setzero_si128()), _mm_cmpeq_epi32(high, _mm_set1_epi32(0xD800)));
+    __m128i tagged = _mm_cmpeq_epi32(_mm_and_si128(lanes, _mm_set1_epi32(0x00C0C0F0)), _mm_set1_epi32(0x008080E0));
+    *valid = _mm_andnot_si128(outside, tagged);
+    return codepoints;
+}
+
+/* Eight characters of 3 bytes, the second load overlaps the first so no byte past the block is read */
+MUF_SIMD_TARGET("ssse3")
+MUF_INTERNAL muf_usize _mufUtf8WidenThreeByteSSSE3(muf_u16 *dst, const muf_byte *src, muf_usize length) {
+    __m128i gatherLow = _mm_setr_epi8(_MUF_UTF8_GATHER_3_FROM_0);
+    __m128i gatherHigh = _mm_setr_epi8(_MUF_UTF8_GATHER_3_FROM_4);
+    __m128i narrow = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+    muf_usize i = 0, j = 0;
+    for (; i + 24 <= length; i += 24, j += 8) {
+        __m128i validLow, validHigh;
+        __m128i low = _mufUtf8DecodeThreeByteSSSE3(
+            _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (src + i)), gatherLow), &validLow);
+        __m128i high = _mufUtf8DecodeThreeByteSSSE3(
+            _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (src + i + 8)), gatherHigh), &validHigh);
+        if (_mm_movemask_epi8(_mm_and_si128(validLow, validHigh)) != 0xFFFF)
+            break;
+        __m128i units = _mm_unpacklo_epi64(_mm_shuffle_epi8(low, narrow), _mm_shuffle_epi8(high, narrow));
+        _mm_storeu_si128((__m128i *) (dst + j), units);
     }
+    return i;
+}
+
+/* Encode four code points of 3 bytes, one character in the low bytes of each 32-bit lane */
+MUF_SIMD_TARGET("ssse3")
+MUF_INTERNAL MUF_INLINE __m128i _mufUtf8EncodeThreeByteSSSE3(__m128i codepoints) {
+    __m128i lead = _mm_or_si128(_mm_srli_epi32(codepoints, 12), _mm_set1_epi32(0xE0));
+    __m128i middle = _mm_and_si128(_mm_slli_epi32(codepoints, 2), _mm_set1_epi32(0x3F00));
+    __m128i last = _mm_and_si128(_mm_slli_epi32(codepoints, 16), _mm_set1_epi32(0x3F0000));
+    __m128i lanes = _mm_or_si128(_mm_or_si128(lead, middle), _mm_or_si128(last, _mm_set1_epi32(0x808000)));
+    return _mm_shuffle_epi8(lanes, _mm_setr_epi8(_MUF_UTF8_SCATTER_3));
+}
+
+MUF_SIMD_TARGET("ssse3")
+MUF_INTERNAL muf_usize _mufUtf8NarrowThreeByteSSSE3(muf_byte *dst, const muf_u16 *src, muf_usize length) {
+    muf_usize i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m128i units = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i high = _mm_and_si128(units, _mm_set1_epi16((short) 0xF800));
+        __m128i outside = _mm_or_si128(_mm_cmpeq_epi16(high, _mm_setzero_si128()),
+            _mm_cmpeq_epi16(high, _mm_set1_epi16((short) 0xD800)));
+        if (_mm_movemask_epi8(outside) != 0)
+            break;
+        __m128i low = _mufUtf8EncodeThreeByteSSSE3(_mm_unpacklo_epi16(units, _mm_setzero_si128()));
+        __m128i rest = _mufUtf8EncodeThreeByteSSSE3(_mm_unpackhi_epi16(units, _mm_setzero_si128()));
+        /* 12 + 12 bytes, stored as 16 and 8 so nothing past the block is written */
+        _mm_storeu_si128((__m128i *) (dst + i * 3), _mm_or_si128(low, _mm_slli_si128(rest, 12)));
+        _mm_storel_epi64((__m128i *) (dst + i * 3 + 16), _mm_srli_si128(rest, 4));
+    }
+    return i;
+}
+
+static const _MufUtf8Kernels _mufUtf8SSSE3 = {
+    MUF_CPU_FEATURE_SSSE3,
+    _mufUtf8ValidateSSSE3,
+    _mufUtf8WidenAsciiBaseline,
+    _mufUtf8NarrowAsciiBaseline,
+    _mufUtf8WidenTwoByteSSE2,
+    _mufUtf8WidenThreeByteSSSE3,
+    _mufUtf8NarrowTwoByteSSE2,
+    _mufUtf8NarrowThreeByteSSSE3
+};
+
+/* AVX2, 32 bytes per step, the previous bytes cross the middle of the register */
+
+MUF_SIMD_TARGET("avx2")
+MUF_INTERNAL MUF_INLINE __m256i _mufUtf8CheckAVX2(__m256i input, __m256i prevInput) {
+    __m256i nibbleMask = _mm256_set1_epi8(0x0F);
+    __m256i shifted = _mm256_permute2x128_si256(prevInput, input, 0x21);
+    __m256i prev1 = _mm256_alignr_epi8(input, shifted, 15);
+    __m256i byte1High = _mm256_shuffle_epi8(_mm256_setr_epi8(_MUF_UTF8_BYTE_1_HIGH, _MUF_UTF8_BYTE_1_HIGH),
+        _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibbleMask));
+    __m256i byte1Low = _mm256_shuffle_epi8(_mm256_setr_epi8(_MUF_UTF8_BYTE_1_LOW, _MUF_UTF8_BYTE_1_LOW),
+        _mm256_and_si256(prev1, nibbleMask));
+    __m256i byte2High = _mm256_shuffle_epi8(_mm256_setr_epi8(_MUF_UTF8_BYTE_2_HIGH, _MUF_UTF8_BYTE_2_HIGH),
+        _mm256_and_si256(_mm256_srli_epi16(input, 4), nibbleMask));
+    __m256i special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+    __m256i prev2 = _mm256_alignr_epi8(input, shifted, 14);
+    __m256i prev3 = _mm256_alignr_epi8(input, shifted, 13);
+    __m256i isThird = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char) (0xE0 - 0x80)));
+    __m256i isFourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char) (0xF0 - 0x80)));
+    __m256i must23 = _mm256_and_si256(_mm256_or_si256(isThird, isFourth), _mm256_set1_epi8((char) 0x80));
+    return _mm256_xor_si256(must23, special);
+}
+
+MUF_SIMD_TARGET("avx2")
+MUF_INTERNAL muf_bool _mufUtf8ValidateAVX2(const muf_byte *data, muf_usize length) {
+    __m256i maxValue = _mm256_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char) (0xF0 - 1), (char) (0xE0 - 1), (char) (0xC0 - 1));
+    __m256i error = _mm256_setzero_si256();
+    __m256i prevInput = _mm256_setzero_si256();
+    __m256i prevIncomplete = _mm256_setzero_si256();
+
+    muf_usize i = 0;
+    while (i < length) {
+        __m256i input;
+        if (i + 32 <= length) {
+            input = _mm256_loadu_si256((const __m256i *) (data + i));
+        } else {
+            MUF_ALIGNAS(32) muf_byte tail[32] = { 0 };
+            memcpy(tail, data + i, length - i);
+            input = _mm256_load_si256((const __m256i *) tail);
+        }
+        i += 32;
+
+        if (_mm256_movemask_epi8(input) == 0) {
+            error = _mm256_or_si256(error, prevIncomplete);
+            prevIncomplete = _mm256_setzero_si256();
+        } else {
+            error = _mm256_or_si256(error, _mufUtf8CheckAVX2(input, prevInput));
+            prevIncomplete = _mm256_subs_epu8(input, maxValue);
+        }
+        prevInput = input;
+    }
+    error = _mm256_or_si256(error, prevIncomplete);
+    return _mm256_testz_si256(error, error) != 0;
+}
+
+MUF_SIMD_TARGET("avx2")
+MUF_INTERNAL muf_usize _mufUtf8WidenAsciiAVX2(muf_u16 *dst, const muf_byte *src, muf_usize length) {
+    muf_usize i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i *) (src + i));
+        if (_mm256_movemask_epi8(bytes) != 0)
+            break;
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bytes)));
+        _mm256_storeu_si256((__m256i *) (dst + i + 16), _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bytes, 1)));
+    }
+    /* The tail stays in this function, calling the SSE code with the upper halves in use costs a transition */
+    for (; i + 16 <= length; i += 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *) (src + i));
+        if (_mm_movemask_epi8(bytes) != 0)
+            break;
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_cvtepu8_epi16(bytes));
+    }
+    for (; i < length && src[i] < 0x80; ++i)
+        dst[i] = src[i];
+    return i;
+}
+
+MUF_SIMD_TARGET("avx2")
+MUF_INTERNAL muf_usize _mufUtf8NarrowAsciiAVX2(muf_byte *dst, const muf_u16 *src, muf_usize length) {
+    __m256i nonAscii = _mm256_set1_epi16((short) 0xFF80);
+    muf_usize i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i low = _mm256_loadu_si256((const __m256i *) (src + i));
+        __m256i high = _mm256_loadu_si256((const __m256i *) (src + i + 16));
+        __m256i outside = _mm256_and_si256(_mm256_or_si256(low, high), nonAscii);
+        if (!_mm256_testz_si256(outside, outside))
+            break;
+        /* The pack works within each half, the permute puts the quarters back in order */
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i *) (dst + i), packed);
+    }
+    for (; i + 16 <= length; i += 16) {
+        __m256i units = _mm256_loadu_si256((const __m256i *) (src + i));
+        __m256i outside = _mm256_and_si256(units, nonAscii);
+        if (!_mm256_testz_si256(outside, outside))
+            break;
+        __m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(units), _mm256_extracti128_si256(units, 1));
+        _mm_storeu_si128((__m128i *) (dst + i), packed);
+    }
+    for (; i < length && src[i] < 0x80; ++i)
+        dst[i] = (muf_byte) src[i];
+    return i;
+}
+
+MUF_SIMD_TARGET("avx2")
+MUF_INTERNAL muf_usize _mufUtf8WidenTwoByteAVX2(muf_u16 *dst, const muf_byte *src, muf_usize length) {
+    __m256i tagMask = _mm256_set1_epi16((short) 0xC0E0);
+    __m256i tags = _mm256_set1_epi16((short) 0x80C0);
+    __m256i overlongMask = _mm256_set1_epi16(0x001E);
+    muf_usize i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i words = _mm256_loadu_si256((const __m256i *) (src + i));
+        __m256i valid = _mm256_andnot_si256(_mm256_cmpeq_epi16(_mm256_and_si256(words, overlongMask), _mm256_setzero_si256()),
+            _mm256_cmpeq_epi16(_mm256_and_si256(words, tagMask), tags));
+        if (_mm256_movemask_epi8(valid) != -1)
+            break;
+        __m256i units = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(words, _mm256_set1_epi16(0x1F)), 6),
+            _mm256_and_si256(_mm256_srli_epi16(words, 8), _mm256_set1_epi16(0x3F)));
+        _mm256_storeu_si256((__m256i *) (dst + i / 2), units);
+    }
+    return i;
+}
+
+MUF_SIMD_TARGET("avx2")
+MUF_INTERNAL muf_usize _mufUtf8NarrowTwoByteAVX2(muf_byte *dst, const muf_u16 *src, muf_usize length) {
+    muf_usize i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m256i units = _mm256_loadu_si256((const __m256i *) (src + i));
+        __m256i valid = _mm256_andnot_si256(
+            _mm256_cmpeq_epi16(_mm256_and_si256(units, _mm256_set1_epi16((short) 0xFF80)), _mm256_setzero_si256()),
+            _mm256_cmpeq_epi16(_mm256_and_si256(units, _mm256_set1_epi16((short) 0xF800)), _mm256_setzero_si256()));
+        if (_mm256_movemask_epi8(valid) != -1)
+            break;
+        __m256i lead = _mm256_or_si256(_mm256_srli_epi16(units, 6), _mm256_set1_epi16(0xC0));
+        __m256i continuation = _mm256_or_si256(_mm256_and_si256(units, _mm256_set1_epi16(0x3F)), _mm256_set1_epi16(0x80));
+        _mm256_storeu_si256((__m256i *) (dst + i * 2), _mm256_or_si256(lead, _mm256_slli_epi16(continuation, 8)));
+    }
+    return i;
+}
+
+/* Eight characters of 3 bytes per step, the low half gathers the first four and the high half the next four */
+MUF_SIMD_TARGET("avx2")
+MUF_INTERNAL muf_usize _mufUtf8WidenThreeByteAVX2(muf_u16 *dst, const muf_byte *src, muf_usize length) {
+    __m256i gather = _mm256_setr_epi8(_MUF_UTF8_GATHER_3_FROM_0, _MUF_UTF8_GATHER_3_FROM_4);
+    muf_usize i = 0, j = 0;
+    for (; i + 24 <= length; i += 24, j += 8) {
+        __m256i bytes = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) (src + i))),
+            _mm_loadu_si128((const __m128i *) (src + i + 8)), 1);
+        __m256i lanes = _mm256_shuffle_epi8(bytes, gather);
+        __m256i codepoints = _mm256_or_si256(
+            _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(lanes, _mm256_set1_epi32(0x0F)), 12),
+                _mm256_and_si256(_mm256_srli_epi32(lanes, 2), _mm256_set1_epi32(0x0FC0))),
+            _mm256_and_si256(_mm256_srli_epi32(lanes, 16), _mm256_set1_epi32(0x3F)));
+        __m256i high = _mm256_and_si256(codepoints, _mm256_set1_epi32(0xF800));
+        __m256i outside = _mm256_or_si256(_mm256_cmpeq_epi32(high, _mm256_setzero_si256()),
+            _mm256_cmpeq_epi32(high, _mm256_set1_epi32(0xD800)));
+        __m256i tagged = _mm256_cmpeq_epi32(_mm256_and_si256(lanes, _mm256_set1_epi32(0x00C0C0F0)),
+            _mm256_set1_epi32(0x008080E0));
+        if (_mm256_movemask_epi8(_mm256_andnot_si256(outside, tagged)) != -1)
+            break;
+        /* The pack works within each half, the permute brings the two groups of four together */
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(codepoints, codepoints), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128((__m128i *) (dst + j), _mm256_castsi256_si128(packed));
+    }
+    return i;
+}
+
+MUF_SIMD_TARGET("avx2")
+MUF_INTERNAL muf_usize _mufUtf8NarrowThreeByteAVX2(muf_byte *dst, const muf_u16 *src, muf_usize length) {
+    __m256i scatter = _mm256_setr_epi8(_MUF_UTF8_SCATTER_3, _MUF_UTF8_SCATTER_3);
+    muf_usize i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m128i units = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i high = _mm_and_si128(units, _mm_set1_epi16((short) 0xF800));
+        __m128i outside = _mm_or_si128(_mm_cmpeq_epi16(high, _mm_setzero_si128()),
+            _mm_cmpeq_epi16(high, _mm_set1_epi16((short) 0xD800)));
+        if (_mm_movemask_epi8(outside) != 0)
+            break;
+        __m256i codepoints = _mm256_cvtepu16_epi32(units);
+        __m256i lead = _mm256_or_si256(_mm256_srli_epi32(codepoints, 12), _mm256_set1_epi32(0xE0));
+        __m256i middle = _mm256_and_si256(_mm256_slli_epi32(codepoints, 2), _mm256_set1_epi32(0x3F00));
+        __m256i last = _mm256_and_si256(_mm256_slli_epi32(codepoints, 16), _mm256_set1_epi32(0x3F0000));
+        __m256i lanes = _mm256_or_si256(_mm256_or_si256(lead, middle), _mm256_or_si256(last, _mm256_set1_epi32(0x808000)));
+        __m256i bytes = _mm256_shuffle_epi8(lanes, scatter);
+        __m128i low = _mm256_castsi256_si128(bytes);
+        __m128i rest = _mm256_extracti128_si256(bytes, 1);
+        _mm_storeu_si128((__m128i *) (dst + i * 3), _mm_or_si128(low, _mm_slli_si128(rest, 12)));
+        _mm_storel_epi64((__m128i *) (dst + i * 3 + 16), _mm_srli_si128(rest, 4));
+    }
+    return i;
+}
+
+static const _MufUtf8Kernels _mufUtf8AVX2 = {
+    MUF_CPU_FEATURE_AVX2,
+    _mufUtf8ValidateAVX2,
+    _mufUtf8WidenAsciiAVX2,
+    _mufUtf8NarrowAsciiAVX2,
+    _mufUtf8WidenTwoByteAVX2,
+    _mufUtf8WidenThreeByteAVX2,
+    _mufUtf8NarrowTwoByteAVX2,
+    _mufUtf8NarrowThreeByteAVX2
+};
+
+#endif
+
+static const _MufUtf8Kernels *const _mufUtf8Variants[] = {
+#if defined(MUF_SIMD_MULTI_TARGET)
+    &_mufUtf8AVX2,
+    &_mufUtf8SSSE3,
+#endif
+    &_mufUtf8Baseline
+};
+
+static const _MufUtf8Kernels *_mufUtf8Kernels = NULL;
+
+static const _MufUtf8Kernels *_mufGetUtf8Kernels(void) {
+    const _MufUtf8Kernels *kernels = mufAtomicLoad(&_mufUtf8Kernels);
+    if (kernels != NULL)
+        return kernels;
+
+    for (muf_usize i = 0; i < MUF_COUNTOF(_mufUtf8Variants); ++i) {
+        kernels = _mufUtf8Variants[i];
+        if (mufHasCpuFeatures(kernels->required))
+            break;
+    }
+    mufAtomicStore(&_mufUtf8Kernels, kernels);
+    return kernels;
+}
+
+/* Count the bytes that start a character, and with fourByteLeads the leads of four bytes a second time */
+MUF_INTERNAL muf_usize _mufUtf8CountLeads(const muf_byte *data, muf_usize length, muf_bool fourByteLeads) {
+    muf_usize count = 0;
+    muf_usize i = 0;
+#if defined(MUF_SIMD_SSE2)
+    __m128i notContinuation = _mm_set1_epi8(-65);
+    __m128i fourByteMask = fourByteLeads ? _mm_set1_epi8(-1) : _mm_setzero_si128();
+    while (i + 16 <= length) {
+        /* The byte counters are summed before they can overflow */
+        __m128i counters = _mm_setzero_si128();
+        for (muf_u32 step = 0; step < 127 && i + 16 <= length; ++step, i += 16) {
+            __m128i bytes = _mm_loadu_si128((const __m128i *) (data + i));
+            __m128i leads = _mm_cmpgt_epi8(bytes, notContinuation);
+            __m128i fours = _mm_cmpeq_epi8(_mm_subs_epu8(bytes, _mm_set1_epi8((char) 0xEF)), _mm_setzero_si128());
+            counters = _mm_sub_epi8(counters, leads);
+            counters = _mm_sub_epi8(counters, _mm_andnot_si128(fours, fourByteMask));
+        }
+        __m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+        count += (muf_usize) _mm_cvtsi128_si32(sums) + (muf_usize) _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+    }
+#endif
+    for (; i < length; ++i)
+        count += ((data[i] & 0xC0) != 0x80) + (fourByteLeads && data[i] >= 0xF0);
     return count;
 }
 
+muf_usize mufUtf8Length(const muf_char *str) {
+    return mufUtf8LengthN(str, mufCStrLength(str));
+}
+
+muf_usize mufUtf8LengthN(const muf_char *str, muf_usize length) {
+    if (!mufUtf8IsValidN(str, length))
+        return (muf_usize) -1;
+    return _mufUtf8CountLeads((const muf_byte *) str, length, MUF_FALSE);
+}
+
 muf_bool mufUtf8IsValid(const muf_char *str) {
-    const muf_byte *bytes = (const muf_byte *) str;
-    muf_u32 state = 0;
+    return mufUtf8IsValidN(str, mufCStrLength(str));
+}
+
+muf_bool mufUtf8IsValidN(const muf_char *str, muf_usize length) {
+    return _mufGetUtf8Kernels()->validate((const muf_byte *) str, length);
+}
+
+muf_usize mufUtf8GetUtf16Length(const muf_char *src, muf_usize srcLength) {
+    if (!mufUtf8IsValidN(src, srcLength))
+        return (muf_usize) -1;
+    return _mufUtf8CountLeads((const muf_byte *) src, srcLength, MUF_TRUE);
+}
+
+muf_usize mufUtf16GetUtf8Length(const muf_u16 *src, muf_usize srcLength) {
+    muf_usize length = 0;
+    for (muf_usize i = 0; i < srcLength; ++i) {
+        muf_u32 unit = src[i];
+        if (unit < 0x80) {
+            length += 1;
+        } else if (unit < 0x800) {
+            length += 2;
+        } else if (unit < 0xD800 || unit > 0xDFFF) {
+            length += 3;
+        } else if (unit < 0xDC00 && i + 1 < srcLength && src[i + 1] >= 0xDC00 && src[i + 1] <= 0xDFFF) {
+            length += 4;
+            ++i;
+        } else {
+            return (muf_usize) -1;
+        }
+    }
+    return length;
+}
+
+/* The bytes a widening kernel may read so that its output, one unit per width bytes, fits in room units */
+MUF_INTERNAL MUF_INLINE muf_usize _mufUtf8WidenLimit(muf_usize available, muf_usize room, muf_usize width) {
+    return room < available / width ? room * width : available;
+}
+
+MufUtf8ResultCode mufUtf8ToUtf16(muf_u16 *dstUtf16, muf_usize dstMaxLength, const muf_char *srcUtf8, muf_usize srcLength) {
+    if (dstMaxLength == 0)
+        return MUF_UTF8_TOO_SMALL;
+
+    const _MufUtf8Kernels *kernels = _mufGetUtf8Kernels();
+    const muf_byte *src = (const muf_byte *) srcUtf8;
+    muf_usize room = dstMaxLength - 1;
+    muf_usize i = 0, j = 0;
+    muf_u32 state = MUF_UTF8_ACCEPT;
     muf_u32 codepoint = 0;
-    
-    for(muf_index i = 0; bytes[i]; ++i) {
-        _mufUtf8Decode(bytes[i], &state, &codepoint);
+    MufUtf8ResultCode result = MUF_UTF8_SUCCESS;
+
+    while (i < srcLength) {
+        if (state == MUF_UTF8_ACCEPT) {
+            muf_usize count = 0;
+            if (src[i] < 0x80) {
+                count = kernels->widenAscii(dstUtf16 + j, src + i, mufMin(srcLength - i, room - j));
+                j += count;
+            } else if (src[i] < 0xE0) {
+                count = kernels->widenTwoByte(dstUtf16 + j, src + i, _mufUtf8WidenLimit(srcLength - i, room - j, 2));
+                j += count / 2;
+            } else if (src[i] < 0xF0) {
+                count = kernels->widenThreeByte(dstUtf16 + j, src + i, _mufUtf8WidenLimit(srcLength - i, room - j, 3));
+                j += count / 3;
+            }
+            i += count;
+            if (i == srcLength)
+                break;
+        }
+
+        if (_mufUtf8Decode(src[i++], &state, &codepoint) != MUF_UTF8_ACCEPT) {
+            if (state == MUF_UTF8_REJECT) {
+                result = MUF_UTF8_INVALID;
+                break;
+            }
+            continue;
+        }
+
+        muf_usize units = codepoint > 0xFFFF ? 2 : 1;
+        if (room - j < units) {
+            result = MUF_UTF8_TOO_SMALL;
+            break;
+        }
+        if (units == 2) {
+            dstUtf16[j++] = (muf_u16) (0xD7C0 + (codepoint >> 10));
+            dstUtf16[j++] = (muf_u16) (0xDC00 + (codepoint & 0x3FF));
+        } else {
+            dstUtf16[j++] = (muf_u16) codepoint;
+        }
     }
-    return state == MUF_UTF8_ACCEPT;
+
+    if (result == MUF_UTF8_SUCCESS && state != MUF_UTF8_ACCEPT)
+        result = MUF_UTF8_INVALID;
+    dstUtf16[j] = 0;
+    return result;
 }
 
-MufUtf8ResultCode mufUtf8ToUtf16(muf_wchar *dstUtf16, muf_usize dstMaxLength, const muf_char *srcUtf8, muf_usize srcLength) {
-    muf_byte *src = (muf_byte *) srcUtf8;
-    muf_byte *srcEnd = src + srcLength;
-
-    muf_wchar *dst = dstUtf16;
-    muf_u32 codepoint;
-    muf_u32 state = 0;
-
-    while (src < srcEnd) {
-        muf_usize dstFree = dstMaxLength - (dst - dstUtf16);
-        muf_byte *sCurrentEnd = src + dstFree  - 1;
-
-        if (srcEnd < sCurrentEnd)
-            sCurrentEnd = srcEnd;
-        
-        if (sCurrentEnd <= src)
-            return MUF_UTF8_TOO_SMALL;
-        
-        while (src < sCurrentEnd) {
-            if (_mufUtf8Decode(*src++, &state, &codepoint))
-                continue;
-            
-            if (codepoint > 0xFFFF) {
-                *dst++ = (muf_u16)(0xD7C0 + (codepoint >> 10));
-                *dst++ = (muf_u16)(0xDC00 + (codepoint & 0x3FF));
-            } else {
-                *dst++ = (muf_u16)codepoint;
+MufUtf8ResultCode mufUtf16ToUtf8(muf_char *dstUtf8, muf_usize dstMaxLength, const muf_u16 *srcUtf16, muf_usize srcLength) {
+    if (dstMaxLength == 0)
+        return MUF_UTF8_TOO_SMALL;
+
+    const _MufUtf8Kernels *kernels = _mufGetUtf8Kernels();
+    muf_byte *dst = (muf_byte *) dstUtf8;
+    muf_usize room = dstMaxLength - 1;
+    muf_usize i = 0, j = 0;
+    MufUtf8ResultCode result = MUF_UTF8_SUCCESS;
+
+    while (i < srcLength) {
+        muf_u32 unit = srcUtf16[i];
+        muf_usize count = 0;
+        if (unit < 0x80) {
+            count = kernels->narrowAscii(dst + j, srcUtf16 + i, mufMin(srcLength - i, room - j));
+            j += count;
+        } else if (unit < 0x800) {
+            count = kernels->narrowTwoByte(dst + j, srcUtf16 + i, mufMin(srcLength - i, (room - j) / 2));
+            j += count * 2;
+        } else if (unit < 0xD800 || unit > 0xDFFF) {
+            count = kernels->narrowThreeByte(dst + j, srcUtf16 + i, mufMin(srcLength - i, (room - j) / 3));
+            j += count * 3;
+        }
+        i += count;
+        if (i == srcLength)
+            break;
+
+        muf_u32 codepoint = srcUtf16[i++];
+        if (codepoint >= 0xD800 && codepoint <= 0xDFFF) {
+            if (codepoint >= 0xDC00 || i == srcLength || srcUtf16[i] < 0xDC00 || srcUtf16[i] > 0xDFFF) {
+                result = MUF_UTF8_INVALID;
+                break;
             }
+            codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (srcUtf16[i++] - 0xDC00);
         }
 
-        if (state != MUF_UTF8_ACCEPT)
-            return MUF_UTF8_INVALID;
+        muf_usize bytes = codepoint < 0x80 ? 1 : (codepoint < 0x800 ? 2 : (codepoint < 0x10000 ? 3 : 4));
+        if (room - j < bytes) {
+            result = MUF_UTF8_TOO_SMALL;
+            break;
+        }
+        switch (bytes) {
+            case 1:
+                dst[j++] = (muf_byte) codepoint;
+                break;
+            case 2:
+                dst[j++] = (muf_byte) (0xC0 | (codepoint >> 6));
+                dst[j++] = (muf_byte) (0x80 | (codepoint & 0x3F));
+                break;
+            case 3:
+                dst[j++] = (muf_byte) (0xE0 | (codepoint >> 12));
+                dst[j++] = (muf_byte) (0x80 | ((codepoint >> 6) & 0x3F));
+                dst[j++] = (muf_byte) (0x80 | (codepoint & 0x3F));
+                break;
+            default:
+                dst[j++] = (muf_byte) (0xF0 | (codepoint >> 18));
+                dst[j++] = (muf_byte) (0x80 | ((codepoint >> 12) & 0x3F));
+                dst[j++] = (muf_byte) (0x80 | ((codepoint >> 6) & 0x3F));
+                dst[j++] = (muf_byte) (0x80 | (codepoint & 0x3F));
+                break;
+        }
+    }
+
+    dst[j] = '\0';
+    return result;
+}
+
+muf_i32 mufStrViewCompare(MufStrView a, MufStrView b) {
+    muf_usize length = a.length < b.length ? a.length : b.length;
+    muf_i32 result = length == 0 ? 0 : mufMemCompare(a.data, b.data, length);
+    if (result != 0)
+        return result;
+    return a.length < b.length ? -1 : (a.length > b.length ? 1 : 0);
+}
+
+muf_usize mufStrViewFind(MufStrView view, MufStrView needle, muf_usize start) {
+    if (start > view.length || needle.length > view.length - start)
+        return MUF_STR_NPOS;
+    if (needle.length == 0)
+        return start;
+
+    const muf_char *end = view.data + view.length - needle.length + 1;
+    const muf_char *p = view.data + start;
+    while (p < end) {
+        /* memchr finds the candidates, most of them are rejected by the first byte */
+        p = (const muf_char *) memchr(p, needle.data[0], (muf_usize) (end - p));
+        if (p == NULL)
+            break;
+        if (mufMemEqual(p + 1, needle.data + 1, needle.length - 1))
+            return (muf_usize) (p - view.data);
+        ++p;
+    }
+    return MUF_STR_NPOS;
+}
+
+muf_usize mufStrViewFindChar(MufStrView view, muf_char c, muf_usize start) {
+    if (start >= view.length)
+        return MUF_STR_NPOS;
+    const muf_char *p = (const muf_char *) memchr(view.data + start, c, view.length - start);
+    return p == NULL ? MUF_STR_NPOS : (muf_usize) (p - view.data);
+}
+
+muf_usize mufStrViewFindLastChar(MufStrView view, muf_char c) {
+    for (muf_usize i = view.length; i > 0; --i) {
+        if (view.data[i - 1] == c)
+            return i - 1;
+    }
+    return MUF_STR_NPOS;
+}
+
+muf_u64 mufStrViewHash(MufStrView view) {
+    return mufHashBytes64(view.data, view.length, 0);
+}
+
+muf_index mufHash_strView(muf_crawptr value) {
+    return (muf_index) mufStrViewHash(*(const MufStrView *) value);
+}
+
+muf_bool mufEqual_strView(muf_crawptr a, muf_crawptr b) {
+    return mufStrViewEqual(*(const MufStrView *) a, *(const MufStrView *) b);
+}
 
-        if ((dstMaxLength - (dst - dstUtf16)) == 0)
-            return MUF_UTF8_TOO_SMALL;
+MUF_INTERNAL MUF_INLINE void _mufStrChanged(MufStr *str) {
+    mufStrGetData(str)[str->size] = '\0';
+    str->hash = 0;
+}
+
+MUF_INTERNAL void _mufStrReallocate(MufStr *str, muf_usize capacity) {
+    if (mufStrIsLocal(str)) {
+        muf_char *heap = (muf_char *) str->allocator->alloc(capacity + 1);
+        mufMemCopyBytes(heap, str->storage.local, str->size + 1);
+        str->storage.heap = heap;
+    } else {
+        str->storage.heap = (muf_char *) str->allocator->realloc(str->storage.heap, capacity + 1);
     }
-    return MUF_UTF8_SUCCESS;
-}
\ No newline at end of file
+    str->capacity = capacity;
+}
+
+MUF_INTERNAL MUF_INLINE void _mufStrGrow(MufStr *str, muf_usize size) {
+    if (size > str->capacity)
+        _mufStrReallocate(str, size > str->capacity * 2 ? size : str->capacity * 2);
+}
+
+MUF_INTERNAL MUF_INLINE muf_bool _mufStrContainsView(const MufStr *str, MufStrView view) {
+    const muf_char *data = mufStrGetCStr(str);
+    return view.data >= data && view.data <= data + str->size;
+}
+
+/* Grow for a view that may point into the string, the view is found again after the buffer moves */
+MUF_INTERNAL MUF_INLINE void _mufStrGrowForView(MufStr *str, muf_usize size, MufStrView *view) {
+    if (_mufStrContainsView(str, *view)) {
+        muf_usize offset = (muf_usize) (view->data - mufStrGetCStr(str));
+        _mufStrGrow(str, size);
+        view->data = mufStrGetCStr(str) + offset;
+    } else {
+        _mufStrGrow(str, size);
+    }
+}
+
+void mufInitStr(MufStr *str, const MufAllocatorCallbacks *allocator) {
+    str->storage.local[0] = '\0';
+    str->size = 0;
+    str->capacity = MUF_STR_LOCAL_CAPACITY;
+    str->hash = 0;
+    str->allocator = allocator != NULL ? allocator : MUF_DEFAULT_ALLOCATOR;
+}
+
+void mufInitStrFromView(MufStr *str, MufStrView view, const MufAllocatorCallbacks *allocator) {
+    mufInitStr(str, allocator);
+    if (view.length > MUF_STR_LOCAL_CAPACITY) {
+        str->storage.heap = (muf_char *) str->allocator->alloc(view.length + 1);
+        str->capacity = view.length;
+    }
+    mufMemCopyBytes(mufStrGetData(str), view.data, view.length);
+    str->size = view.length;
+    _mufStrChanged(str);
+}
+
+void mufInitStrFromCStr(MufStr *str, const muf_char *cstr, const MufAllocatorCallbacks *allocator) {
+    mufInitStrFromView(str, mufStrViewFromCStr(cstr), allocator);
+}
+
+void mufDestroyStr(MufStr *str) {
+    if (!mufStrIsLocal(str))
+        str->allocator->dealloc(str->storage.heap);
+    mufInitStr(str, str->allocator);
+}
+
+MufStr mufCloneStr(const MufStr *str) {
+    MufStr clone;
+    mufInitStrFromView(&clone, mufStrGetView(str), str->allocator);
+    clone.hash = str->hash;
+    return clone;
+}
+
+muf_u64 mufStrGetHash(MufStr *str) {
+    if (str->hash == 0)
+        str->hash = mufStrViewHash(mufStrGetView(str));
+    return str->hash;
+}
+
+muf_bool mufStrEqual(const MufStr *a, const MufStr *b) {
+    if (a->size != b->size)
+        return MUF_FALSE;
+    if (a->hash != 0 && b->hash != 0 && a->hash != b->hash)
+        return MUF_FALSE;
+    return mufMemEqual(mufStrGetCStr(a), mufStrGetCStr(b), a->size);
+}
+
+void mufStrReserve(MufStr *str, muf_usize capacity) {
+    _mufStrGrow(str, capacity);
+}
+
+void mufStrShrinkToFit(MufStr *str) {
+    if (mufStrIsLocal(str) || str->capacity == str->size)
+        return;
+
+    if (str->size <= MUF_STR_LOCAL_CAPACITY) {
+        muf_char *heap = str->storage.heap;
+        mufMemCopyBytes(str->storage.local, heap, str->size + 1);
+        str->allocator->dealloc(heap);
+        str->capacity = MUF_STR_LOCAL_CAPACITY;
+    } else {
+        _mufStrReallocate(str, str->size);
+    }
+}
+
+void mufStrClear(MufStr *str) {
+    str->size = 0;
+    _mufStrChanged(str);
+}
+
+void mufStrTruncate(MufStr *str, muf_usize size) {
+    if (size < str->size) {
+        str->size = size;
+        _mufStrChanged(str);
+    }
+}
+
+void mufStrAssign(MufStr *str, MufStrView view) {
+    _mufStrGrowForView(str, view.length, &view);
+    mufMemMoveBytes(mufStrGetData(str), view.data, view.length);
+    str->size = view.length;
+    _mufStrChanged(str);
+}
+
+void mufStrAppend(MufStr *str, MufStrView view) {
+    _mufStrGrowForView(str, str->size + view.length, &view);
+    mufMemMoveBytes(mufStrGetData(str) + str->size, view.data, view.length);
+    str->size += view.length;
+    _mufStrChanged(str);
+}
+
+void mufStrAppendCStr(MufStr *str, const muf_char *cstr) {
+    mufStrAppend(str, mufStrViewFromCStr(cstr));
+}
+
+void mufStrAppendChar(MufStr *str, muf_char c) {
+    _mufStrGrow(str, str->size + 1);
+    mufStrGetData(str)[str->size++] = c;
+    _mufStrChanged(str);
+}
+
+void mufStrAppendFormatV(MufStr *str, const muf_char *format, va_list args) {
+    /*
+     * An argument may point into the string, so its buffer is neither written nor moved while the arguments are read:
+     * short text is formatted on the stack, longer text into a scratch string, and then appended.
+     */
+    muf_char local[MUF_STR_FORMAT_LOCAL_SIZE];
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    int length = vsnprintf(local, sizeof(local), format, argsCopy);
+    va_end(argsCopy);
+
+    if (length < 0)
+        return;
+    if ((muf_usize) length < sizeof(local)) {
+        mufStrAppend(str, mufMakeStrView(local, (muf_usize) length));
+        return;
+    }
+
+    MufStr scratch;
+    mufInitStr(&scratch, str->allocator);
+    _mufStrGrow(&scratch, (muf_usize) length);
+    vsnprintf(mufStrGetData(&scratch), (muf_usize) length + 1, format, args);
+    scratch.size = (muf_usize) length;
+    mufStrAppend(str, mufStrGetView(&scratch));
+    mufDestroyStr(&scratch);
+}
+
+void mufStrAppendFormat(MufStr *str, const muf_char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    mufStrAppendFormatV(str, format, args);
+    va_end(args);
+}
+
+void mufStrAppendPath(MufStr *str, MufStrView component) {
+    muf_bool hasSeparator = str->size == 0 || mufStrGetCStr(str)[str->size - 1] == '/';
+    if (component.length != 0 && component.data[0] == '/') {
+        if (hasSeparator && str->size != 0)
+            component = mufStrViewSlice(component, 1, MUF_STR_NPOS);
+    } else if (!hasSeparator) {
+        /* Room for both first, the separator must not move the buffer under a component taken from the string */
+        _mufStrGrowForView(str, str->size + 1 + component.length, &component);
+        mufStrAppendChar(str, '/');
+    }
+    mufStrAppend(str, component);
+}
+
+void mufStrReplace(MufStr *str, muf_usize index, muf_usize count, MufStrView view) {
+    index = index < str->size ? index : str->size;
+    count = count < str->size - index ? count : str->size - index;
+    muf_usize newSize = str->size - count + view.length;
+
+    if (_mufStrContainsView(str, view) && view.length != 0) {
+        /* The move below shifts the bytes of a view taken from the string, replace with a copy */
+        MufStr copy;
+        mufInitStrFromView(&copy, view, str->allocator);
+        mufStrReplace(str, index, count, mufStrGetView(&copy));
+        mufDestroyStr(&copy);
+        return;
+    }
+
+    _mufStrGrow(str, newSize);
+    muf_char *data = mufStrGetData(str);
+    mufMemMoveBytes(data + index + view.length, data + index + count, str->size - index - count);
+    mufMemCopyBytes(data + index, view.data, view.length);
+    str->size = newSize;
+    _mufStrChanged(str);
+}
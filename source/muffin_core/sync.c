@@ -0,0 +1,146 @@
+#include "muffin_core/sync.h"
+
+#include "muffin_core/memory.h"
+
+#if defined(MUF_PLATFORM_WIN32)
+#   include <windows.h>
+#else
+#   include <pthread.h>
+#   include <unistd.h>
+#endif
+
+#if defined(MUF_PLATFORM_WIN32)
+
+struct MufLock_s {
+    SRWLOCK handle;
+};
+
+struct MufCondVar_s {
+    CONDITION_VARIABLE handle;
+};
+
+MufLock *mufCreateLock(void) {
+    MufLock *lock = mufAlloc(MufLock, 1);
+    InitializeSRWLock(&lock->handle);
+    return lock;
+}
+
+void mufDestroyLock(MufLock *lock) {
+    mufFree(lock);
+}
+
+void mufLockAcquire(MufLock *lock) {
+    AcquireSRWLockExclusive(&lock->handle);
+}
+
+muf_bool mufLockTryAcquire(MufLock *lock) {
+    return TryAcquireSRWLockExclusive(&lock->handle) != 0;
+}
+
+void mufLockRelease(MufLock *lock) {
+    ReleaseSRWLockExclusive(&lock->handle);
+}
+
+MufCondVar *mufCreateCondVar(void) {
+    MufCondVar *condVar = mufAlloc(MufCondVar, 1);
+    InitializeConditionVariable(&condVar->handle);
+    return condVar;
+}
+
+void mufDestroyCondVar(MufCondVar *condVar) {
+    mufFree(condVar);
+}
+
+void mufCondVarWait(MufCondVar *condVar, MufLock *lock) {
+    SleepConditionVariableSRW(&condVar->handle, &lock->handle, INFINITE, 0);
+}
+
+void mufCondVarSignal(MufCondVar *condVar) {
+    WakeConditionVariable(&condVar->handle);
+}
+
+void mufCondVarBroadcast(MufCondVar *condVar) {
+    WakeAllConditionVariable(&condVar->handle);
+}
+
+muf_usize mufGetHardwareConcurrency(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (muf_usize) info.dwNumberOfProcessors : 1;
+}
+
+#else
+
+struct MufLock_s {
+    pthread_mutex_t handle;
+};
+
+struct MufCondVar_s {
+    pthread_cond_t handle;
+};
+
+MufLock *mufCreateLock(void) {
+    MufLock *lock = mufAlloc(MufLock, 1);
+    pthread_mutex_init(&lock->handle, NULL);
+    return lock;
+}
+
+void mufDestroyLock(MufLock *lock) {
+    if (lock == NULL)
+        return;
+    pthread_mutex_destroy(&lock->handle);
+    mufFree(lock);
+}
+
+void mufLockAcquire(MufLock *lock) {
+    pthread_mutex_lock(&lock->handle);
+}
+
+muf_bool mufLockTryAcquire(MufLock *lock) {
+    return pthread_mutex_trylock(&lock->handle) == 0;
+}
+
+void mufLockRelease(MufLock *lock) {
+    pthread_mutex_unlock(&lock->handle);
+}
+
+MufCondVar *mufCreateCondVar(void) {
+    MufCondVar *condVar = mufAlloc(MufCondVar, 1);
+    pthread_cond_init(&condVar->handle, NULL);
+    return condVar;
+}
+
+void mufDestroyCondVar(MufCondVar *condVar) {
+    if (condVar == NULL)
+        return;
+    pthread_cond_destroy(&condVar->handle);
+    mufFree(condVar);
+}
+
+void mufCondVarWait(MufCondVar *condVar, MufLock *lock) {
+    pthread_cond_wait(&condVar->handle, &lock->handle);
+}
+
+void mufCondVarSignal(MufCondVar *condVar) {
+    pthread_cond_signal(&condVar->handle);
+}
+
+void mufCondVarBroadcast(MufCondVar *condVar) {
+    pthread_cond_broadcast(&condVar->handle);
+}
+
+muf_usize mufGetHardwareConcurrency(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (muf_usize) count : 1;
+}
+
+#endif
+
+static volatile muf_u32 _mufThreadIdCounter = 0;
+static MUF_THREAD_LOCAL muf_u32 _mufCurrentThreadId = 0;
+
+muf_u32 mufGetCurrentThreadId(void) {
+    if (_mufCurrentThreadId == 0)
+        _mufCurrentThreadId = mufAtomicFetchAdd(&_mufThreadIdCounter, 1U) + 1U;
+    return _mufCurrentThreadId;
+}
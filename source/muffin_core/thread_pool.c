@@ -0,0 +1,297 @@
+#include "muffin_core/thread_pool.h"
+
+#include "muffin_core/math.h"
+#include "muffin_core/memory.h"
+#include "muffin_core/sync.h"
+
+#if defined(MUF_PLATFORM_WIN32)
+#   include <windows.h>
+#else
+#   include <pthread.h>
+#endif
+
+#define MUF_THREAD_POOL_MAX_WORKERS         64
+#define MUF_PARALLEL_DEFAULT_MIN_GRAIN      1024
+#define MUF_PARALLEL_CHUNKS_PER_THREAD      4
+
+typedef struct _MufTask_s {
+    struct _MufTask_s   *next;
+    MufTaskFunc         func;
+    muf_rawptr          userData;
+    MufTaskCounter      *counter;
+} _MufTask;
+
+#if defined(MUF_PLATFORM_WIN32)
+    typedef HANDLE _MufNativeThread;
+#else
+    typedef pthread_t _MufNativeThread;
+#endif
+
+struct MufThreadPool_s {
+    MufLock             *lock;
+    MufCondVar          *taskReady;
+    MufCondVar          *taskDone;
+    _MufTask            *head;
+    _MufTask            *tail;
+    _MufTask            *freeList;
+    muf_bool            stopping;
+    muf_usize           workerCount;
+    _MufNativeThread    *workers;
+};
+
+static MUF_THREAD_LOCAL muf_bool _mufIsWorkerThread = MUF_FALSE;
+
+MUF_INTERNAL _MufTask *_mufThreadPoolPopLocked(MufThreadPool *pool) {
+    _MufTask *task = pool->head;
+    if (task != NULL) {
+        pool->head = task->next;
+        if (pool->head == NULL)
+            pool->tail = NULL;
+    }
+    return task;
+}
+
+MUF_INTERNAL void _mufThreadPoolRun(MufThreadPool *pool, _MufTask *task) {
+    MufTaskFunc func = task->func;
+    muf_rawptr userData = task->userData;
+    MufTaskCounter *counter = task->counter;
+
+    mufLockAcquire(pool->lock);
+    task->next = pool->freeList;
+    pool->freeList = task;
+    mufLockRelease(pool->lock);
+
+    func(userData);
+
+    if (counter != NULL && mufAtomicFetchSub(&counter->pending, 1) == 1) {
+        mufLockAcquire(pool->lock);
+        mufCondVarBroadcast(pool->taskDone);
+        mufLockRelease(pool->lock);
+    }
+}
+
+MUF_INTERNAL void _mufThreadPoolWorkerLoop(MufThreadPool *pool) {
+    _mufIsWorkerThread = MUF_TRUE;
+    for (;;) {
+        mufLockAcquire(pool->lock);
+        while (pool->head == NULL && !pool->stopping)
+            mufCondVarWait(pool->taskReady, pool->lock);
+        _MufTask *task = _mufThreadPoolPopLocked(pool);
+        mufLockRelease(pool->lock);
+
+        if (task == NULL)
+            return;
+        _mufThreadPoolRun(pool, task);
+    }
+}
+
+#if defined(MUF_PLATFORM_WIN32)
+
+static DWORD WINAPI _mufThreadPoolWorkerEntry(LPVOID param) {
+    _mufThreadPoolWorkerLoop((MufThreadPool *) param);
+    return 0;
+}
+
+MUF_INTERNAL muf_bool _mufStartWorker(MufThreadPool *pool, _MufNativeThread *thread) {
+    *thread = CreateThread(NULL, 0, _mufThreadPoolWorkerEntry, pool, 0, NULL);
+    return *thread != NULL;
+}
+
+MUF_INTERNAL void _mufJoinWorker(_MufNativeThread thread) {
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
+
+#else
+
+static void *_mufThreadPoolWorkerEntry(void *param) {
+    _mufThreadPoolWorkerLoop((MufThreadPool *) param);
+    return NULL;
+}
+
+MUF_INTERNAL muf_bool _mufStartWorker(MufThreadPool *pool, _MufNativeThread *thread) {
+    return pthread_create(thread, NULL, _mufThreadPoolWorkerEntry, pool) == 0;
+}
+
+MUF_INTERNAL void _mufJoinWorker(_MufNativeThread thread) {
+    pthread_join(thread, NULL);
+}
+
+#endif
+
+MufThreadPool *mufCreateThreadPool(muf_usize workerCount) {
+    if (workerCount == 0) {
+        muf_usize hardware = mufGetHardwareConcurrency();
+        workerCount = hardware > 1 ? hardware - 1 : 0;
+    }
+    workerCount = mufMin(workerCount, MUF_THREAD_POOL_MAX_WORKERS);
+
+    MufThreadPool *pool = mufAllocZero(MufThreadPool, 1);
+    pool->lock = mufCreateLock();
+    pool->taskReady = mufCreateCondVar();
+    pool->taskDone = mufCreateCondVar();
+    pool->workers = workerCount > 0 ? mufAlloc(_MufNativeThread, workerCount) : NULL;
+
+    for (muf_index i = 0; i < workerCount; ++i) {
+        if (!_mufStartWorker(pool, &pool->workers[i]))
+            break;
+        ++pool->workerCount;
+    }
+    return pool;
+}
+
+void mufDestroyThreadPool(MufThreadPool *pool) {
+    if (pool == NULL)
+        return;
+
+    mufLockAcquire(pool->lock);
+    pool->stopping = MUF_TRUE;
+    mufCondVarBroadcast(pool->taskReady);
+    mufLockRelease(pool->lock);
+
+    for (muf_index i = 0; i < pool->workerCount; ++i)
+        _mufJoinWorker(pool->workers[i]);
+
+    /* Without workers the remaining tasks are run here */
+    _MufTask *task;
+    while ((task = _mufThreadPoolPopLocked(pool)) != NULL)
+        _mufThreadPoolRun(pool, task);
+
+    while (pool->freeList != NULL) {
+        _MufTask *next = pool->freeList->next;
+        mufFree(pool->freeList);
+        pool->freeList = next;
+    }
+
+    mufDestroyCondVar(pool->taskDone);
+    mufDestroyCondVar(pool->taskReady);
+    mufDestroyLock(pool->lock);
+    mufSafeFree(pool->workers);
+    mufFree(pool);
+}
+
+static MufThreadPool *_mufGlobalThreadPool = NULL;
+static MufSpinLock _mufGlobalThreadPoolLock = MUF_SPIN_LOCK_INIT;
+
+MufThreadPool *mufGetGlobalThreadPool(void) {
+    MufThreadPool *pool = mufAtomicLoad(&_mufGlobalThreadPool);
+    if (pool != NULL)
+        return pool;
+
+    mufSpinLockAcquire(&_mufGlobalThreadPoolLock);
+    if (_mufGlobalThreadPool == NULL)
+        mufAtomicStore(&_mufGlobalThreadPool, mufCreateThreadPool(0));
+    pool = _mufGlobalThreadPool;
+    mufSpinLockRelease(&_mufGlobalThreadPoolLock);
+    return pool;
+}
+
+muf_usize mufThreadPoolGetWorkerCount(const MufThreadPool *pool) {
+    return pool->workerCount;
+}
+
+void mufThreadPoolSubmit(MufThreadPool *pool, MufTaskFunc func, muf_rawptr userData, MufTaskCounter *counter) {
+    if (counter != NULL)
+        mufAtomicFetchAdd(&counter->pending, 1);
+
+    if (pool->workerCount == 0) {
+        func(userData);
+        if (counter != NULL)
+            mufAtomicFetchSub(&counter->pending, 1);
+        return;
+    }
+
+    mufLockAcquire(pool->lock);
+    _MufTask *task = pool->freeList;
+    if (task != NULL)
+        pool->freeList = task->next;
+    else
+        task = mufAlloc(_MufTask, 1);
+
+    task->next = NULL;
+    task->func = func;
+    task->userData = userData;
+    task->counter = counter;
+    if (pool->tail != NULL)
+        pool->tail->next = task;
+    else
+        pool->head = task;
+    pool->tail = task;
+    mufCondVarSignal(pool->taskReady);
+    mufLockRelease(pool->lock);
+}
+
+void mufThreadPoolWait(MufThreadPool *pool, MufTaskCounter *counter) {
+    while (mufAtomicLoad(&counter->pending) != 0) {
+        mufLockAcquire(pool->lock);
+        _MufTask *task = _mufThreadPoolPopLocked(pool);
+        if (task == NULL) {
+            if (mufAtomicLoad(&counter->pending) != 0)
+                mufCondVarWait(pool->taskDone, pool->lock);
+            mufLockRelease(pool->lock);
+            continue;
+        }
+        mufLockRelease(pool->lock);
+        _mufThreadPoolRun(pool, task);
+    }
+}
+
+muf_bool mufThreadPoolIsWorkerThread(void) {
+    return _mufIsWorkerThread;
+}
+
+muf_usize mufThreadPoolComputeGrainSize(const MufThreadPool *pool, muf_usize count, muf_usize minGrainSize) {
+    if (minGrainSize == 0)
+        minGrainSize = MUF_PARALLEL_DEFAULT_MIN_GRAIN;
+    if (pool->workerCount == 0 || count <= minGrainSize)
+        return mufMax(count, 1);
+
+    muf_usize chunkCount = (pool->workerCount + 1) * MUF_PARALLEL_CHUNKS_PER_THREAD;
+    muf_usize grain = (count + chunkCount - 1) / chunkCount;
+    return mufMax(grain, minGrainSize);
+}
+
+typedef struct _MufParallelForChunk_s {
+    MufParallelRangeFunc    func;
+    muf_rawptr              userData;
+    muf_index               first;
+    muf_index               last;
+} _MufParallelForChunk;
+
+MUF_INTERNAL void _mufParallelForTask(muf_rawptr data) {
+    _MufParallelForChunk *chunk = (_MufParallelForChunk *) data;
+    chunk->func(chunk->first, chunk->last, chunk->userData);
+}
+
+void mufParallelFor(MufThreadPool *pool, muf_usize count, muf_usize grainSize, MufParallelRangeFunc func, muf_rawptr userData) {
+    if (count == 0)
+        return;
+    if (pool == NULL)
+        pool = mufGetGlobalThreadPool();
+    if (grainSize == 0)
+        grainSize = mufThreadPoolComputeGrainSize(pool, count, 0);
+
+    if (pool->workerCount == 0 || grainSize >= count) {
+        func(0, count, userData);
+        return;
+    }
+
+    muf_usize chunkCount = (count + grainSize - 1) / grainSize;
+    _MufParallelForChunk *chunks = mufAlloc(_MufParallelForChunk, chunkCount);
+    MufTaskCounter counter = MUF_TASK_COUNTER_INIT;
+
+    for (muf_index i = 0; i < chunkCount; ++i) {
+        chunks[i].func = func;
+        chunks[i].userData = userData;
+        chunks[i].first = i * grainSize;
+        chunks[i].last = mufMin(count, (i + 1) * grainSize);
+    }
+
+    /* The calling thread takes the first chunk itself */
+    for (muf_index i = 1; i < chunkCount; ++i)
+        mufThreadPoolSubmit(pool, _mufParallelForTask, &chunks[i], &counter);
+    _mufParallelForTask(&chunks[0]);
+    mufThreadPoolWait(pool, &counter);
+
+    mufFree(chunks);
+}
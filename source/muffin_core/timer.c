@@ -0,0 +1,117 @@
+#include "muffin_core/timer.h"
+
+#include "muffin_core/sync.h"
+
+#if defined(MUF_PLATFORM_WIN32)
+#   include <windows.h>
+#else
+#   include <time.h>
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(MUF_COMPILER_GCC) || defined(MUF_COMPILER_CLANG))
+#   include <cpuid.h>
+#   include <x86intrin.h>
+#   define _MUF_TIMER_HAS_TSC
+#endif
+
+#define MUF_TIMER_CALIBRATION_NS 5000000ULL
+
+enum {
+    _MUF_TIMER_SOURCE_UNKNOWN = 0,
+    _MUF_TIMER_SOURCE_CLOCK,
+    _MUF_TIMER_SOURCE_TSC
+};
+
+static volatile muf_u32 _mufTimerSource = _MUF_TIMER_SOURCE_UNKNOWN;
+static volatile muf_u64 _mufTimerFrequency = 0;
+
+muf_u64 mufTimerGetNanoseconds(void) {
+#if defined(MUF_PLATFORM_WIN32)
+    static LARGE_INTEGER frequency = { 0 };
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0)
+        QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (muf_u64) (counter.QuadPart / frequency.QuadPart) * 1000000000ULL
+        + (muf_u64) (counter.QuadPart % frequency.QuadPart) * 1000000000ULL / (muf_u64) frequency.QuadPart;
+#else
+    struct timespec ts;
+#   if defined(CLOCK_MONOTONIC_RAW)
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+#   else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#   endif
+    return (muf_u64) ts.tv_sec * 1000000000ULL + (muf_u64) ts.tv_nsec;
+#endif
+}
+
+#if defined(_MUF_TIMER_HAS_TSC)
+MUF_INTERNAL muf_bool _mufTimerHasInvariantTsc(void) {
+    muf_u32 eax, ebx, ecx, edx;
+    if (__get_cpuid(0x80000000U, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007U)
+        return MUF_FALSE;
+    __get_cpuid(0x80000007U, &eax, &ebx, &ecx, &edx);
+    return (edx & (1U << 8)) != 0;
+}
+#endif
+
+MUF_INTERNAL muf_u32 _mufTimerGetSource(void) {
+    muf_u32 source = mufAtomicLoadRelaxed(&_mufTimerSource);
+    if (source != _MUF_TIMER_SOURCE_UNKNOWN)
+        return source;
+#if defined(_MUF_TIMER_HAS_TSC)
+    source = _mufTimerHasInvariantTsc() ? _MUF_TIMER_SOURCE_TSC : _MUF_TIMER_SOURCE_CLOCK;
+#else
+    source = _MUF_TIMER_SOURCE_CLOCK;
+#endif
+    mufAtomicStore(&_mufTimerSource, source);
+    return source;
+}
+
+muf_u64 mufTimerGetTicks(void) {
+#if defined(_MUF_TIMER_HAS_TSC)
+    if (_mufTimerGetSource() == _MUF_TIMER_SOURCE_TSC)
+        return __rdtsc();
+#endif
+    return mufTimerGetNanoseconds();
+}
+
+muf_u64 mufTimerGetFrequency(void) {
+    muf_u64 frequency = mufAtomicLoadRelaxed(&_mufTimerFrequency);
+    if (frequency != 0)
+        return frequency;
+
+    if (_mufTimerGetSource() == _MUF_TIMER_SOURCE_CLOCK) {
+        frequency = 1000000000ULL;
+    } else {
+        /* Measure the TSC against the monotonic clock over a short busy window */
+        muf_u64 ns0 = mufTimerGetNanoseconds();
+        muf_u64 tsc0 = mufTimerGetTicks();
+        muf_u64 ns1, tsc1;
+        do {
+            ns1 = mufTimerGetNanoseconds();
+            tsc1 = mufTimerGetTicks();
+        } while (ns1 - ns0 < MUF_TIMER_CALIBRATION_NS);
+        frequency = (muf_u64) ((muf_f64) (tsc1 - tsc0) * 1e9 / (muf_f64) (ns1 - ns0));
+    }
+    mufAtomicStore(&_mufTimerFrequency, frequency);
+    return frequency;
+}
+
+muf_u64 mufTimerTicksToNanoseconds(muf_u64 ticks) {
+    muf_u64 frequency = mufTimerGetFrequency();
+    if (frequency == 1000000000ULL)
+        return ticks;
+    return (ticks / frequency) * 1000000000ULL + (ticks % frequency) * 1000000000ULL / frequency;
+}
+
+muf_u64 mufTimerNanosecondsToTicks(muf_u64 nanoseconds) {
+    muf_u64 frequency = mufTimerGetFrequency();
+    if (frequency == 1000000000ULL)
+        return nanoseconds;
+    return (nanoseconds / 1000000000ULL) * frequency + (nanoseconds % 1000000000ULL) * frequency / 1000000000ULL;
+}
+
+muf_bool mufTimerIsTscBased(void) {
+    return _mufTimerGetSource() == _MUF_TIMER_SOURCE_TSC;
+}
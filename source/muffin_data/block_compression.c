@@ -0,0 +1,461 @@
+#define MUF_MEMORY_TAG MUF_MEMORY_TAG_IMAGE
+
+#include "muffin_data/block_compression.h"
+
+#include <math.h>
+
+#include "muffin_core/math.h"
+#include "muffin_core/memory.h"
+
+/* A task encodes at least this many blocks */
+#define MUF_BC_MIN_TASK_BLOCKS  256
+#define MUF_BC_REFINE_STEPS     2
+
+typedef struct _MufBcContext_s {
+    const MufImage  *src;
+    MufImage        *dst;
+    muf_u32         blocksX;
+    muf_usize       blockSize;
+} _MufBcContext;
+
+MUF_INTERNAL void _mufBcFetchBlock(const MufImage *image, muf_u32 bx, muf_u32 by, muf_u8 pixels[16][4]) {
+    for (muf_u32 y = 0; y < 4; ++y) {
+        muf_u32 sy = mufMin(by * 4 + y, image->height - 1);
+        const muf_u8 *row = (const muf_u8 *) image->data + (muf_usize) sy * image->rowPitch;
+        for (muf_u32 x = 0; x < 4; ++x) {
+            muf_u32 sx = mufMin(bx * 4 + x, image->width - 1);
+            const muf_u8 *p = row + (muf_usize) sx * image->channels;
+            muf_u8 *pixel = pixels[y * 4 + x];
+            for (muf_u32 c = 0; c < 4; ++c)
+                pixel[c] = c < image->channels ? p[c] : (c == 3 ? 255 : 0);
+        }
+    }
+}
+
+MUF_INTERNAL muf_u16 _mufBcPack565(const muf_f32 color[3]) {
+    muf_i32 r = (muf_i32) (mufClamp(color[0], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+    muf_i32 g = (muf_i32) (mufClamp(color[1], 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+    muf_i32 b = (muf_i32) (mufClamp(color[2], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+    return (muf_u16) ((r << 11) | (g << 5) | b);
+}
+
+MUF_INTERNAL void _mufBcUnpack565(muf_u16 value, muf_i32 color[3]) {
+    muf_i32 r = (value >> 11) & 31;
+    muf_i32 g = (value >> 5) & 63;
+    muf_i32 b = value & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+/* Pixels with a zero mask entry are ignored, they are transparent in the 3 color mode */
+MUF_INTERNAL muf_u32 _mufBcSelectColorIndices(const muf_u8 pixels[16][4], const muf_bool mask[16], muf_u16 c0, muf_u16 c1,
+    muf_bool threeColor, muf_u8 indicesOut[16]) {
+    muf_i32 palette[4][3];
+    _mufBcUnpack565(c0, palette[0]);
+    _mufBcUnpack565(c1, palette[1]);
+    for (muf_u32 c = 0; c < 3; ++c) {
+        if (threeColor) {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        } else {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+    }
+
+    muf_u32 candidateCount = threeColor ? 3 : 4;
+    muf_u32 error = 0;
+    for (muf_u32 i = 0; i < 16; ++i) {
+        if (!mask[i]) {
+            indicesOut[i] = 3;
+            continue;
+        }
+        muf_u32 best = 0;
+        muf_u32 bestError = ~0U;
+        for (muf_u32 k = 0; k < candidateCount; ++k) {
+            muf_i32 dr = palette[k][0] - pixels[i][0];
+            muf_i32 dg = palette[k][1] - pixels[i][1];
+            muf_i32 db = palette[k][2] - pixels[i][2];
+            muf_u32 e = (muf_u32) (dr * dr + dg * dg + db * db);
+            if (e < bestError) {
+                bestError = e;
+                best = k;
+            }
+        }
+        indicesOut[i] = (muf_u8) best;
+        error += bestError;
+    }
+    return error;
+}
+
+/* Fit the endpoints on the principal axis of the colors, found by power iteration */
+MUF_INTERNAL void _mufBcFindColorEndpoints(const muf_u8 pixels[16][4], const muf_bool mask[16], muf_f32 lo[3], muf_f32 hi[3]) {
+    muf_f32 mean[3] = { 0.0f, 0.0f, 0.0f };
+    muf_f32 minColor[3] = { 255.0f, 255.0f, 255.0f };
+    muf_f32 maxColor[3] = { 0.0f, 0.0f, 0.0f };
+    muf_u32 count = 0;
+    for (muf_u32 i = 0; i < 16; ++i) {
+        if (!mask[i])
+            continue;
+        for (muf_u32 c = 0; c < 3; ++c) {
+            mean[c] += pixels[i][c];
+            minColor[c] = mufMin(minColor[c], (muf_f32) pixels[i][c]);
+            maxColor[c] = mufMax(maxColor[c], (muf_f32) pixels[i][c]);
+        }
+        ++count;
+    }
+    for (muf_u32 c = 0; c < 3; ++c)
+        mean[c] /= (muf_f32) count;
+
+    muf_f32 cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    for (muf_u32 i = 0; i < 16; ++i) {
+        if (!mask[i])
+            continue;
+        muf_f32 r = pixels[i][0] - mean[0];
+        muf_f32 g = pixels[i][1] - mean[1];
+        muf_f32 b = pixels[i][2] - mean[2];
+        cov[0] += r * r;
+        cov[1] += r * g;
+        cov[2] += r * b;
+        cov[3] += g * g;
+        cov[4] += g * b;
+        cov[5] += b * b;
+    }
+
+    muf_f32 axis[3] = { maxColor[0] - minColor[0], maxColor[1] - minColor[1], maxColor[2] - minColor[2] };
+    for (muf_u32 iteration = 0; iteration < 4; ++iteration) {
+        muf_f32 x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        muf_f32 y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        muf_f32 z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        muf_f32 length = mufMax(fabsf(x), mufMax(fabsf(y), fabsf(z)));
+        if (length < 1e-6f)
+            break;
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+    }
+
+    muf_f32 tMin = 0.0f, tMax = 0.0f;
+    muf_f32 lengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    if (lengthSquared > 1e-12f) {
+        tMin = 1e30f;
+        tMax = -1e30f;
+        for (muf_u32 i = 0; i < 16; ++i) {
+            if (!mask[i])
+                continue;
+            muf_f32 t = ((pixels[i][0] - mean[0]) * axis[0] + (pixels[i][1] - mean[1]) * axis[1]
+                + (pixels[i][2] - mean[2]) * axis[2]) / lengthSquared;
+            tMin = mufMin(tMin, t);
+            tMax = mufMax(tMax, t);
+        }
+    }
+    for (muf_u32 c = 0; c < 3; ++c) {
+        lo[c] = mean[c] + tMin * axis[c];
+        hi[c] = mean[c] + tMax * axis[c];
+    }
+}
+
+/* Solve the endpoints minimizing the squared error for fixed 4 color indices */
+MUF_INTERNAL muf_bool _mufBcRefineColorEndpoints(const muf_u8 pixels[16][4], const muf_u8 indices[16], muf_u16 *c0, muf_u16 *c1) {
+    static const muf_f32 weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+    muf_f32 aa = 0.0f, bb = 0.0f, ab = 0.0f;
+    muf_f32 ax[3] = { 0.0f, 0.0f, 0.0f };
+    muf_f32 bx[3] = { 0.0f, 0.0f, 0.0f };
+    for (muf_u32 i = 0; i < 16; ++i) {
+        muf_f32 w = weights[indices[i]];
+        aa += w * w;
+        bb += (1.0f - w) * (1.0f - w);
+        ab += w * (1.0f - w);
+        for (muf_u32 c = 0; c < 3; ++c) {
+            ax[c] += w * pixels[i][c];
+            bx[c] += (1.0f - w) * pixels[i][c];
+        }
+    }
+
+    muf_f32 det = aa * bb - ab * ab;
+    if (fabsf(det) < 1e-6f)
+        return MUF_FALSE;
+    muf_f32 a[3], b[3];
+    for (muf_u32 c = 0; c < 3; ++c) {
+        a[c] = (ax[c] * bb - bx[c] * ab) / det;
+        b[c] = (bx[c] * aa - ax[c] * ab) / det;
+    }
+    *c0 = _mufBcPack565(a);
+    *c1 = _mufBcPack565(b);
+    return MUF_TRUE;
+}
+
+MUF_INTERNAL void _mufBcWriteColorBlock(muf_u16 c0, muf_u16 c1, const muf_u8 indices[16], muf_u8 *out) {
+    muf_u32 bits = 0;
+    for (muf_u32 i = 0; i < 16; ++i)
+        bits |= (muf_u32) indices[i] << (i * 2);
+    out[0] = (muf_u8) c0;
+    out[1] = (muf_u8) (c0 >> 8);
+    out[2] = (muf_u8) c1;
+    out[3] = (muf_u8) (c1 >> 8);
+    out[4] = (muf_u8) bits;
+    out[5] = (muf_u8) (bits >> 8);
+    out[6] = (muf_u8) (bits >> 16);
+    out[7] = (muf_u8) (bits >> 24);
+}
+
+/**
+ * The 4 color mode needs c0 > c1, the 3 color one c0 <= c1 and spends the last index on transparent black.
+ * BC2 and BC3 always decode the 4 color mode.
+ */
+MUF_INTERNAL void _mufBcEncodeColorBlock(const muf_u8 pixels[16][4], muf_bool punchThroughAlpha, muf_u8 *out) {
+    muf_bool mask[16];
+    muf_bool threeColor = MUF_FALSE;
+    muf_u32 opaqueCount = 16;
+    for (muf_u32 i = 0; i < 16; ++i) {
+        mask[i] = !punchThroughAlpha || pixels[i][3] >= 128;
+        if (!mask[i]) {
+            threeColor = MUF_TRUE;
+            --opaqueCount;
+        }
+    }
+
+    muf_u8 indices[16];
+    if (opaqueCount == 0) {
+        mufMemFill(indices, 3, sizeof(indices));
+        _mufBcWriteColorBlock(0, 0, indices, out);
+        return;
+    }
+
+    muf_f32 lo[3], hi[3];
+    _mufBcFindColorEndpoints(pixels, mask, lo, hi);
+    muf_u16 c0 = _mufBcPack565(hi);
+    muf_u16 c1 = _mufBcPack565(lo);
+    muf_u32 error = _mufBcSelectColorIndices(pixels, mask, c0, c1, threeColor, indices);
+
+    if (!threeColor) {
+        for (muf_u32 step = 0; step < MUF_BC_REFINE_STEPS && error > 0; ++step) {
+            muf_u16 r0, r1;
+            muf_u8 refined[16];
+            if (!_mufBcRefineColorEndpoints(pixels, indices, &r0, &r1))
+                break;
+            muf_u32 refinedError = _mufBcSelectColorIndices(pixels, mask, r0, r1, MUF_FALSE, refined);
+            if (refinedError >= error)
+                break;
+            c0 = r0;
+            c1 = r1;
+            error = refinedError;
+            mufMemCopyBytes(indices, refined, sizeof(indices));
+        }
+    }
+
+    if (c0 == c1) {
+        /* Every index decodes to c0 in both modes */
+        for (muf_u32 i = 0; i < 16; ++i)
+            indices[i] = mask[i] ? 0 : 3;
+    } else if (threeColor ? c0 > c1 : c0 < c1) {
+        muf_u16 tmp = c0;
+        c0 = c1;
+        c1 = tmp;
+        for (muf_u32 i = 0; i < 16; ++i) {
+            if (threeColor ? indices[i] < 2 : MUF_TRUE)
+                indices[i] ^= 1;
+        }
+    }
+    _mufBcWriteColorBlock(c0, c1, indices, out);
+}
+
+MUF_INTERNAL void _mufBcBuildAlphaPalette(muf_u32 r0, muf_u32 r1, muf_u32 palette[8]) {
+    palette[0] = r0;
+    palette[1] = r1;
+    if (r0 > r1) {
+        for (muf_u32 i = 1; i < 7; ++i)
+            palette[i + 1] = ((7 - i) * r0 + i * r1 + 3) / 7;
+    } else {
+        for (muf_u32 i = 1; i < 5; ++i)
+            palette[i + 1] = ((5 - i) * r0 + i * r1 + 2) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+MUF_INTERNAL muf_u32 _mufBcSelectAlphaIndices(const muf_u8 values[16], muf_u32 r0, muf_u32 r1, muf_u8 indicesOut[16]) {
+    muf_u32 palette[8];
+    _mufBcBuildAlphaPalette(r0, r1, palette);
+    muf_u32 error = 0;
+    for (muf_u32 i = 0; i < 16; ++i) {
+        muf_u32 best = 0;
+        muf_u32 bestError = ~0U;
+        for (muf_u32 k = 0; k < 8; ++k) {
+            muf_i32 d = (muf_i32) palette[k] - values[i];
+            if ((muf_u32) (d * d) < bestError) {
+                bestError = (muf_u32) (d * d);
+                best = k;
+            }
+        }
+        indicesOut[i] = (muf_u8) best;
+        error += bestError;
+    }
+    return error;
+}
+
+/* A BC4 block, also the alpha block of BC3. Both the 8 value and the 6 value plus 0 and 255 modes are tried. */
+MUF_INTERNAL void _mufBcEncodeAlphaBlock(const muf_u8 values[16], muf_u8 *out) {
+    muf_u32 minValue = 255, maxValue = 0;
+    muf_u32 minInner = 255, maxInner = 0;
+    for (muf_u32 i = 0; i < 16; ++i) {
+        minValue = mufMin(minValue, (muf_u32) values[i]);
+        maxValue = mufMax(maxValue, (muf_u32) values[i]);
+        if (values[i] != 0 && values[i] != 255) {
+            minInner = mufMin(minInner, (muf_u32) values[i]);
+            maxInner = mufMax(maxInner, (muf_u32) values[i]);
+        }
+    }
+
+    muf_u8 indices[16];
+    muf_u32 r0 = maxValue, r1 = minValue;
+    muf_u32 error = _mufBcSelectAlphaIndices(values, r0, r1, indices);
+    if (error > 0) {
+        if (minInner > maxInner)
+            minInner = maxInner = 0;
+        muf_u8 sixIndices[16];
+        muf_u32 sixError = _mufBcSelectAlphaIndices(values, minInner, maxInner, sixIndices);
+        if (sixError < error) {
+            r0 = minInner;
+            r1 = maxInner;
+            mufMemCopyBytes(indices, sixIndices, sizeof(indices));
+        }
+    }
+
+    muf_u64 bits = 0;
+    for (muf_u32 i = 0; i < 16; ++i)
+        bits |= (muf_u64) indices[i] << (i * 3);
+    out[0] = (muf_u8) r0;
+    out[1] = (muf_u8) r1;
+    for (muf_u32 i = 0; i < 6; ++i)
+        out[2 + i] = (muf_u8) (bits >> (i * 8));
+}
+
+MUF_INTERNAL void _mufBcEncodeBlock(MufFormat format, const muf_u8 pixels[16][4], muf_u8 *out) {
+    muf_u8 values[16];
+    switch (format) {
+        case MUF_FORMAT_BC1_RGB_UNORM:
+            _mufBcEncodeColorBlock(pixels, MUF_FALSE, out);
+            break;
+        case MUF_FORMAT_BC1_RGBA_UNORM:
+            _mufBcEncodeColorBlock(pixels, MUF_TRUE, out);
+            break;
+        case MUF_FORMAT_BC3_UNORM:
+            for (muf_u32 i = 0; i < 16; ++i)
+                values[i] = pixels[i][3];
+            _mufBcEncodeAlphaBlock(values, out);
+            _mufBcEncodeColorBlock(pixels, MUF_FALSE, out + 8);
+            break;
+        case MUF_FORMAT_BC5_UNORM:
+            for (muf_u32 i = 0; i < 16; ++i)
+                values[i] = pixels[i][1];
+            _mufBcEncodeAlphaBlock(values, out + 8);
+            /* Fall through, the red block comes first */
+        case MUF_FORMAT_BC4_UNORM:
+            for (muf_u32 i = 0; i < 16; ++i)
+                values[i] = pixels[i][0];
+            _mufBcEncodeAlphaBlock(values, out);
+            break;
+        default:
+            MUF_UNREACHABLE();
+    }
+}
+
+MUF_INTERNAL void _mufBcEncodeRows(muf_index first, muf_index last, muf_rawptr userData) {
+    const _MufBcContext *context = (const _MufBcContext *) userData;
+    muf_u8 pixels[16][4];
+    for (muf_index by = first; by < last; ++by) {
+        muf_u8 *out = (muf_u8 *) context->dst->data + by * context->dst->rowPitch;
+        for (muf_u32 bx = 0; bx < context->blocksX; ++bx) {
+            _mufBcFetchBlock(context->src, bx, (muf_u32) by, pixels);
+            _mufBcEncodeBlock(context->dst->format, pixels, out + bx * context->blockSize);
+        }
+    }
+}
+
+MUF_INTERNAL muf_u32 _mufBcGetChannelCount(MufFormat format) {
+    switch (format) {
+        case MUF_FORMAT_BC4_UNORM       : return 1;
+        case MUF_FORMAT_BC5_UNORM       : return 2;
+        case MUF_FORMAT_BC1_RGB_UNORM   : return 3;
+        default                         : return 4;
+    }
+}
+
+MUF_INTERNAL void _mufBcSetupImage(MufImage *dst, const MufImage *src, MufFormat format) {
+    dst->width = src->width;
+    dst->height = src->height;
+    dst->channels = _mufBcGetChannelCount(format);
+    dst->format = format;
+    dst->rowPitch = (muf_usize) ((src->width + 3) / 4) * mufGetFormatBlockSize(format);
+    dst->data = NULL;
+}
+
+MUF_INTERNAL void _mufBcCompress(MufThreadPool *pool, const MufImage *src, MufImage *dst) {
+    _MufBcContext context;
+    context.src = src;
+    context.dst = dst;
+    context.blocksX = (src->width + 3) / 4;
+    context.blockSize = mufGetFormatBlockSize(dst->format);
+
+    muf_usize blocksY = (src->height + 3) / 4;
+    if (pool == NULL)
+        pool = mufGetGlobalThreadPool();
+    muf_usize minRows = mufMax((muf_usize) MUF_BC_MIN_TASK_BLOCKS / context.blocksX, (muf_usize) 1);
+    mufParallelFor(pool, blocksY, mufThreadPoolComputeGrainSize(pool, blocksY, minRows), _mufBcEncodeRows, &context);
+}
+
+muf_bool mufIsBlockCompressionSupported(MufFormat srcFormat, MufFormat dstFormat) {
+    muf_u32 channels = 0;
+    for (muf_u32 c = 1; c <= 4; ++c) {
+        if (mufGetImageFormat(MUF_IMAGE_PIXEL_TYPE_U8, c) == srcFormat)
+            channels = c;
+    }
+    if (channels == 0)
+        return MUF_FALSE;
+
+    switch (dstFormat) {
+        case MUF_FORMAT_BC4_UNORM       : return MUF_TRUE;
+        case MUF_FORMAT_BC5_UNORM       : return channels >= 2;
+        case MUF_FORMAT_BC1_RGB_UNORM   : return channels >= 3;
+        case MUF_FORMAT_BC1_RGBA_UNORM  :
+        case MUF_FORMAT_BC3_UNORM       : return channels == 4;
+        default                         : return MUF_FALSE;
+    }
+}
+
+MufImage *mufCompressImage(MufThreadPool *pool, const MufImage *image, MufFormat format) {
+    if (!mufIsBlockCompressionSupported(image->format, format) || image->width == 0 || image->height == 0)
+        return NULL;
+
+    MufImage *result = mufAlloc(MufImage, 1);
+    _mufBcSetupImage(result, image, format);
+    result->data = mufAllocBytes(result->rowPitch * ((image->height + 3) / 4));
+    _mufBcCompress(pool, image, result);
+    return result;
+}
+
+MufMipChain *mufCompressMipChain(MufThreadPool *pool, const MufMipChain *chain, MufFormat format) {
+    if (chain->levelCount == 0 || !mufIsBlockCompressionSupported(chain->levels[0].format, format))
+        return NULL;
+
+    MufMipChain *result = mufAlloc(MufMipChain, 1);
+    result->levelCount = chain->levelCount;
+    result->levels = mufAlloc(MufImage, chain->levelCount);
+    result->dataSize = 0;
+    for (muf_u32 i = 0; i < chain->levelCount; ++i) {
+        _mufBcSetupImage(&result->levels[i], &chain->levels[i], format);
+        result->dataSize += result->levels[i].rowPitch * ((result->levels[i].height + 3) / 4);
+    }
+
+    result->data = mufAllocBytes(result->dataSize);
+    muf_usize offset = 0;
+    for (muf_u32 i = chain->levelCount; i-- > 0; ) {
+        MufImage *level = &result->levels[i];
+        level->data = (muf_byte *) result->data + offset;
+        offset += level->rowPitch * ((level->height + 3) / 4);
+        _mufBcCompress(pool, &chain->levels[i], level);
+    }
+    return result;
+}
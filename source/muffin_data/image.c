@@ -1,28 +1,184 @@
+#define MUF_MEMORY_TAG MUF_MEMORY_TAG_IMAGE
+
 #include "muffin_data/image.h"
 
+#include <limits.h>
+
+#include "muffin_core/memory.h"
+
+#define STBI_MALLOC(_size) mufAllocBytes(_size)
+#define STBI_REALLOC(_ptr, _newSize) mufReallocBytes(_ptr, _newSize)
+#define STBI_FREE(_ptr) _mufMemoryTrackFree(_ptr)
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb/stb_image.h"
 
-#include "muffin_core/memory.h"
+MufFormat mufGetImageFormat(MufImagePixelType pixelType, muf_u32 channels) {
+    static const MufFormat formats[][4] = {
+        { MUF_FORMAT_R8_UNORM, MUF_FORMAT_R8G8_UNORM, MUF_FORMAT_R8G8B8_UNORM, MUF_FORMAT_R8G8B8A8_UNORM },
+        { MUF_FORMAT_R16_UNORM, MUF_FORMAT_R16G16_UNORM, MUF_FORMAT_R16G16B16_UNORM, MUF_FORMAT_R16G16B16A16_UNORM },
+        { MUF_FORMAT_R32_FLOAT, MUF_FORMAT_R32G32_FLOAT, MUF_FORMAT_R32G32B32_FLOAT, MUF_FORMAT_R32G32B32A32_FLOAT }
+    };
+    if (pixelType > MUF_IMAGE_PIXEL_TYPE_F32 || channels < 1 || channels > 4)
+        return _MUF_FORMAT_UNKNOWN_;
+    return formats[pixelType][channels - 1];
+}
+
+muf_usize mufGetFormatPixelSize(MufFormat format) {
+    switch (format) {
+        case MUF_FORMAT_R8_UINT             :
+        case MUF_FORMAT_R8_SINT             :
+        case MUF_FORMAT_R8_UNORM            :
+        case MUF_FORMAT_R8_SNORM            : return 1;
+        case MUF_FORMAT_R8G8_UINT           :
+        case MUF_FORMAT_R8G8_SINT           :
+        case MUF_FORMAT_R8G8_UNORM          :
+        case MUF_FORMAT_R8G8_SNORM          :
+        case MUF_FORMAT_R16_UINT            :
+        case MUF_FORMAT_R16_SINT            :
+        case MUF_FORMAT_R16_UNORM           :
+        case MUF_FORMAT_R16_SNORM           : return 2;
+        case MUF_FORMAT_R8G8B8_UINT         :
+        case MUF_FORMAT_R8G8B8_SINT         :
+        case MUF_FORMAT_R8G8B8_UNORM        :
+        case MUF_FORMAT_R8G8B8_SNORM        : return 3;
+        case MUF_FORMAT_R8G8B8A8_UINT       :
+        case MUF_FORMAT_R8G8B8A8_SINT       :
+        case MUF_FORMAT_R8G8B8A8_UNORM      :
+        case MUF_FORMAT_R8G8B8A8_SNORM      :
+        case MUF_FORMAT_R16G16_UINT         :
+        case MUF_FORMAT_R16G16_SINT         :
+        case MUF_FORMAT_R16G16_UNORM        :
+        case MUF_FORMAT_R16G16_SNORM        :
+        case MUF_FORMAT_R32_UINT            :
+        case MUF_FORMAT_R32_SINT            :
+        case MUF_FORMAT_R32_UNORM           :
+        case MUF_FORMAT_R32_SNORM           :
+        case MUF_FORMAT_R32_FLOAT           : return 4;
+        case MUF_FORMAT_R16G16B16_UINT      :
+        case MUF_FORMAT_R16G16B16_SINT      :
+        case MUF_FORMAT_R16G16B16_UNORM     :
+        case MUF_FORMAT_R16G16B16_SNORM     : return 6;
+        case MUF_FORMAT_R16G16B16A16_UINT   :
+        case MUF_FORMAT_R16G16B16A16_SINT   :
+        case MUF_FORMAT_R16G16B16A16_UNORM  :
+        case MUF_FORMAT_R16G16B16A16_SNORM  :
+        case MUF_FORMAT_R32G32_UINT         :
+        case MUF_FORMAT_R32G32_SINT         :
+        case MUF_FORMAT_R32G32_FLOAT        : return 8;
+        case MUF_FORMAT_R32G32B32_UINT      :
+        case MUF_FORMAT_R32G32B32_SINT      :
+        case MUF_FORMAT_R32G32B32_FLOAT     : return 12;
+        case MUF_FORMAT_R32G32B32A32_UINT   :
+        case MUF_FORMAT_R32G32B32A32_SINT   :
+        case MUF_FORMAT_R32G32B32A32_FLOAT  : return 16;
+        default                             : return 0;
+    }
+}
+
+muf_usize mufGetFormatBlockSize(MufFormat format) {
+    switch (format) {
+        case MUF_FORMAT_BC1_RGB_UNORM       :
+        case MUF_FORMAT_BC1_RGBA_UNORM      :
+        case MUF_FORMAT_BC4_UNORM           :
+        case MUF_FORMAT_BC4_SNORM           : return 8;
+        case MUF_FORMAT_BC2_UNORM           :
+        case MUF_FORMAT_BC3_UNORM           :
+        case MUF_FORMAT_BC5_UNORM           :
+        case MUF_FORMAT_BC5_SNORM           :
+        case MUF_FORMAT_BC6H_UFLOAT         :
+        case MUF_FORMAT_BC6H_SFLOAT         :
+        case MUF_FORMAT_BC7_UNORM           : return 16;
+        default                             : return 0;
+    }
+}
 
 MufImage *mufCreateImage(muf_u32 width, muf_u32 height) {
     MufImage *image = mufAlloc(MufImage, 1);
     image->width = width;
     image->height = height;
-    image->channels = 0;
-    image->data = mufAllocBytes(image->width * image->height);
+    image->channels = 1;
+    image->format = MUF_FORMAT_R8_UNORM;
+    image->rowPitch = width;
+    image->data = mufAllocBytes(image->rowPitch * image->height);
     return image;
 }
 
 MufImage *mufCreateImageFromFile(const muf_char *filePath, muf_bool flipVertically) {
-    MufImage *image = mufAlloc(MufImage, 1);
+    MufImageLoadInfo info = { 0 };
+    info.filePath = filePath;
+    info.pixelType = MUF_IMAGE_PIXEL_TYPE_NATIVE;
+    info.flipVertically = flipVertically;
+    return mufLoadImage(&info);
+}
+
+MUF_INTERNAL MufImagePixelType _mufImageResolveNativeType(const MufImageLoadInfo *info) {
+    if (info->data != NULL) {
+        const stbi_uc *buffer = (const stbi_uc *) info->data;
+        muf_i32 length = (muf_i32) info->dataSize;
+        if (stbi_is_hdr_from_memory(buffer, length))
+            return MUF_IMAGE_PIXEL_TYPE_F32;
+        return stbi_is_16_bit_from_memory(buffer, length) ? MUF_IMAGE_PIXEL_TYPE_U16 : MUF_IMAGE_PIXEL_TYPE_U8;
+    }
+    if (stbi_is_hdr(info->filePath))
+        return MUF_IMAGE_PIXEL_TYPE_F32;
+    return stbi_is_16_bit(info->filePath) ? MUF_IMAGE_PIXEL_TYPE_U16 : MUF_IMAGE_PIXEL_TYPE_U8;
+}
+
+MufImage *mufLoadImage(const MufImageLoadInfo *info) {
     muf_i32 w, h, c;
-    stbi_set_flip_vertically_on_load(flipVertically);
-    //muf_rawptr data = stbi_load(filePath, &w, &h, &c, 0);
-    muf_rawptr data = stbi_loadf(filePath, &w, &h, &c, 0);
-    image->width = w;
-    image->height = h;
-    image->channels = c;
+    muf_i32 desiredChannels = (muf_i32) info->channels;
+    MufImagePixelType pixelType = info->pixelType;
+    muf_rawptr data = NULL;
+
+    if (info->channels > 4 || (info->data == NULL && info->filePath == NULL))
+        return NULL;
+    if (info->data != NULL && info->dataSize > (muf_usize) INT_MAX)
+        return NULL;
+    if (pixelType == MUF_IMAGE_PIXEL_TYPE_NATIVE)
+        pixelType = _mufImageResolveNativeType(info);
+
+    stbi_set_flip_vertically_on_load_thread(info->flipVertically);
+    if (info->data != NULL) {
+        const stbi_uc *buffer = (const stbi_uc *) info->data;
+        muf_i32 length = (muf_i32) info->dataSize;
+        switch (pixelType) {
+            case MUF_IMAGE_PIXEL_TYPE_U8:
+                data = stbi_load_from_memory(buffer, length, &w, &h, &c, desiredChannels);
+                break;
+            case MUF_IMAGE_PIXEL_TYPE_U16:
+                data = stbi_load_16_from_memory(buffer, length, &w, &h, &c, desiredChannels);
+                break;
+            case MUF_IMAGE_PIXEL_TYPE_F32:
+                data = stbi_loadf_from_memory(buffer, length, &w, &h, &c, desiredChannels);
+                break;
+            default:
+                break;
+        }
+    } else {
+        switch (pixelType) {
+            case MUF_IMAGE_PIXEL_TYPE_U8:
+                data = stbi_load(info->filePath, &w, &h, &c, desiredChannels);
+                break;
+            case MUF_IMAGE_PIXEL_TYPE_U16:
+                data = stbi_load_16(info->filePath, &w, &h, &c, desiredChannels);
+                break;
+            case MUF_IMAGE_PIXEL_TYPE_F32:
+                data = stbi_loadf(info->filePath, &w, &h, &c, desiredChannels);
+                break;
+            default:
+                break;
+        }
+    }
+    if (data == NULL)
+        return NULL;
+
+    MufImage *image = mufAlloc(MufImage, 1);
+    image->width = (muf_u32) w;
+    image->height = (muf_u32) h;
+    image->channels = desiredChannels != 0 ? (muf_u32) desiredChannels : (muf_u32) c;
+    image->format = mufGetImageFormat(pixelType, image->channels);
+    /* stb packs the rows tightly */
+    image->rowPitch = (muf_usize) image->width * mufGetFormatPixelSize(image->format);
     image->data = data;
     return image;
 }
@@ -44,6 +200,14 @@ muf_u32 mufImageGetChannels(const MufImage *image) {
     return image->channels;
 }
 
+MufFormat mufImageGetFormat(const MufImage *image) {
+    return image->format;
+}
+
+muf_usize mufImageGetRowPitch(const MufImage *image) {
+    return image->rowPitch;
+}
+
 muf_rawptr mufImageGetData(MufImage *image) {
     return image->data;
 }
\ No newline at end of file
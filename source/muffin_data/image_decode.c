@@ -0,0 +1,171 @@
+#define MUF_MEMORY_TAG MUF_MEMORY_TAG_IMAGE
+
+#include "muffin_data/image.h"
+
+#include <string.h>
+
+#include "muffin_core/memory.h"
+#include "muffin_core/sync.h"
+#include "stb/stb_image.h"
+
+typedef struct _MufImageDecodeTask_s {
+    MufImageDecodeQueue             *queue;
+    MufImageDecodeId                id;
+    MufImageLoadInfo                info;
+    muf_rawptr                      userData;
+    MufImage                        *image;
+    const muf_char                  *error;
+    struct _MufImageDecodeTask_s    *next;
+} _MufImageDecodeTask;
+
+struct MufImageDecodeQueue_s {
+    MufThreadPool           *pool;
+    MufTaskCounter          counter;
+    MufLock                 *lock;
+    MufCondVar              *resultReady;
+    /* Completed tasks in completion order */
+    _MufImageDecodeTask     *head;
+    _MufImageDecodeTask     *tail;
+    MufImageDecodeId        nextId;
+    muf_usize               pendingCount;
+};
+
+MUF_INTERNAL void _mufImageDecodeTaskRun(muf_rawptr userData) {
+    _MufImageDecodeTask *task = (_MufImageDecodeTask *) userData;
+    MufImageDecodeQueue *queue = task->queue;
+
+    task->image = mufLoadImage(&task->info);
+    if (task->image == NULL) {
+        const muf_char *reason = stbi_failure_reason();
+        task->error = reason != NULL ? reason : "unknown failure";
+    }
+
+    mufLockAcquire(queue->lock);
+    task->next = NULL;
+    if (queue->tail != NULL)
+        queue->tail->next = task;
+    else
+        queue->head = task;
+    queue->tail = task;
+    mufCondVarBroadcast(queue->resultReady);
+    mufLockRelease(queue->lock);
+}
+
+MufImageDecodeQueue *mufCreateImageDecodeQueue(MufThreadPool *pool) {
+    MufImageDecodeQueue *queue = mufAllocZero(MufImageDecodeQueue, 1);
+    queue->pool = pool != NULL ? pool : mufGetGlobalThreadPool();
+    queue->lock = mufCreateLock();
+    queue->resultReady = mufCreateCondVar();
+    return queue;
+}
+
+void mufDestroyImageDecodeQueue(MufImageDecodeQueue *queue) {
+    if (queue == NULL)
+        return;
+
+    mufThreadPoolWait(queue->pool, &queue->counter);
+    while (queue->head != NULL) {
+        _MufImageDecodeTask *task = queue->head;
+        queue->head = task->next;
+        if (task->image != NULL)
+            mufDestroyImage(task->image);
+        mufFree(task);
+    }
+    mufDestroyCondVar(queue->resultReady);
+    mufDestroyLock(queue->lock);
+    mufFree(queue);
+}
+
+void mufImageDecodeQueueSubmit(MufImageDecodeQueue *queue, const MufImageDecodeRequest *requests, muf_usize count, MufImageDecodeId *idsOut) {
+    for (muf_usize i = 0; i < count; ++i) {
+        const MufImageDecodeRequest *request = &requests[i];
+        /* The path is copied behind the task so the caller's string may be temporary */
+        muf_usize pathSize = request->info.data == NULL && request->info.filePath != NULL ? strlen(request->info.filePath) + 1 : 0;
+        _MufImageDecodeTask *task = (_MufImageDecodeTask *) mufAllocBytes(sizeof(_MufImageDecodeTask) + pathSize);
+        mufMemFill(task, 0, sizeof(_MufImageDecodeTask));
+        task->queue = queue;
+        task->info = request->info;
+        task->userData = request->userData;
+        if (pathSize > 0) {
+            muf_char *path = (muf_char *) (task + 1);
+            mufMemCopyBytes(path, request->info.filePath, pathSize);
+            task->info.filePath = path;
+        }
+
+        mufLockAcquire(queue->lock);
+        task->id = ++queue->nextId;
+        ++queue->pendingCount;
+        mufLockRelease(queue->lock);
+
+        if (idsOut != NULL)
+            idsOut[i] = task->id;
+        mufThreadPoolSubmit(queue->pool, _mufImageDecodeTaskRun, task, &queue->counter);
+    }
+}
+
+MUF_INTERNAL void _mufImageDecodeQueuePopLocked(MufImageDecodeQueue *queue, MufImageDecodeResult *resultOut) {
+    _MufImageDecodeTask *task = queue->head;
+    queue->head = task->next;
+    if (queue->head == NULL)
+        queue->tail = NULL;
+    --queue->pendingCount;
+
+    resultOut->id = task->id;
+    resultOut->userData = task->userData;
+    resultOut->image = task->image;
+    resultOut->error = task->error;
+    mufFree(task);
+}
+
+muf_bool mufImageDecodeQueuePoll(MufImageDecodeQueue *queue, MufImageDecodeResult *resultOut) {
+    mufLockAcquire(queue->lock);
+    muf_bool ready = queue->head != NULL;
+    if (ready)
+        _mufImageDecodeQueuePopLocked(queue, resultOut);
+    mufLockRelease(queue->lock);
+    return ready;
+}
+
+muf_bool mufImageDecodeQueueWait(MufImageDecodeQueue *queue, MufImageDecodeResult *resultOut) {
+    /* A worker blocking on the condition could starve the pool, it helps decoding instead */
+    if (mufThreadPoolIsWorkerThread()) {
+        mufLockAcquire(queue->lock);
+        muf_bool waitAll = queue->head == NULL && queue->pendingCount > 0;
+        mufLockRelease(queue->lock);
+        if (waitAll)
+            mufThreadPoolWait(queue->pool, &queue->counter);
+    }
+
+    mufLockAcquire(queue->lock);
+    while (queue->head == NULL && queue->pendingCount > 0)
+        mufCondVarWait(queue->resultReady, queue->lock);
+    muf_bool ready = queue->head != NULL;
+    if (ready)
+        _mufImageDecodeQueuePopLocked(queue, resultOut);
+    mufLockRelease(queue->lock);
+    return ready;
+}
+
+muf_usize mufImageDecodeQueueGetPendingCount(MufImageDecodeQueue *queue) {
+    mufLockAcquire(queue->lock);
+    muf_usize count = queue->pendingCount;
+    mufLockRelease(queue->lock);
+    return count;
+}
+
+typedef struct _MufLoadImagesContext_s {
+    const MufImageLoadInfo  *infos;
+    MufImage                **images;
+} _MufLoadImagesContext;
+
+MUF_INTERNAL void _mufLoadImagesRange(muf_index first, muf_index last, muf_rawptr userData) {
+    _MufLoadImagesContext *context = (_MufLoadImagesContext *) userData;
+    for (muf_index i = first; i < last; ++i)
+        context->images[i] = mufLoadImage(&context->infos[i]);
+}
+
+void mufLoadImages(MufThreadPool *pool, const MufImageLoadInfo *infos, muf_usize count, MufImage **imagesOut) {
+    _MufLoadImagesContext context = { infos, imagesOut };
+    /* A single image is already a large amount of work, every one gets its own task */
+    mufParallelFor(pool, count, 1, _mufLoadImagesRange, &context);
+}
@@ -0,0 +1,551 @@
+#define MUF_MEMORY_TAG MUF_MEMORY_TAG_IMAGE
+
+#include "muffin_data/mipmap.h"
+
+#include <math.h>
+
+#include "muffin_core/cpu.h"
+#include "muffin_core/math.h"
+#include "muffin_core/memory.h"
+#include "muffin_core/simd.h"
+#include "muffin_core/sync.h"
+
+#define MUF_MIP_KAISER_WIDTH        3.0f
+#define MUF_MIP_KAISER_ALPHA        4.0f
+/* A task filters at least this many destination pixels */
+#define MUF_MIP_MIN_TASK_PIXELS     (64 * 1024)
+
+/*
+ * Rows are decoded into 4 floats per pixel whatever the channel count, so every filter works on whole pixels:
+ * an SSE register holds exactly one pixel and an AVX register two.
+ */
+
+typedef struct _MufMipContrib_s {
+    muf_u32 first;
+    muf_u32 count;
+    muf_u32 offset;
+} _MufMipContrib;
+
+typedef struct _MufMipKernel_s {
+    _MufMipContrib  *contribs;
+    muf_f32         *weights;
+} _MufMipKernel;
+
+typedef void (*_MufMipFilterVerticalFunc)(const muf_f32 *rows, muf_usize stride, const muf_f32 *weights, muf_u32 count,
+    muf_f32 *out, muf_usize length);
+
+typedef struct _MufMipResampleContext_s {
+    const MufImage      *src;
+    MufImage            *dst;
+    MufImagePixelType   pixelType;
+    muf_u32             channels;
+    /* For u8 images, the value of each code per channel, linear or sRGB decoded */
+    const muf_f32       *u8Tables[4];
+    muf_bool            srgbChannels[4];
+    muf_bool            box2x2;
+    _MufMipKernel       horizontal;
+    _MufMipKernel       vertical;
+    /* The vertical pass is the hot loop, its AVX variant is selected at runtime */
+    _MufMipFilterVerticalFunc filterVertical;
+} _MufMipResampleContext;
+
+static muf_f32 _mufMipUnormTable[256];
+static muf_f32 _mufMipSrgbTable[256];
+/* The linear value halfway between two sRGB codes, encoding counts the thresholds below a value */
+static muf_f32 _mufMipSrgbThresholds[255];
+static volatile muf_u32 _mufMipTablesReady = 0;
+static MufSpinLock _mufMipTablesLock = MUF_SPIN_LOCK_INIT;
+
+MUF_INTERNAL muf_f32 _mufMipSrgbDecode(muf_f32 c) {
+    return c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+}
+
+MUF_INTERNAL void _mufMipInitTables(void) {
+    if (mufAtomicLoad(&_mufMipTablesReady))
+        return;
+
+    mufSpinLockAcquire(&_mufMipTablesLock);
+    if (!_mufMipTablesReady) {
+        for (muf_u32 i = 0; i < 256; ++i) {
+            _mufMipUnormTable[i] = (muf_f32) i / 255.0f;
+            _mufMipSrgbTable[i] = _mufMipSrgbDecode((muf_f32) i / 255.0f);
+        }
+        for (muf_u32 i = 0; i < 255; ++i)
+            _mufMipSrgbThresholds[i] = _mufMipSrgbDecode(((muf_f32) i + 0.5f) / 255.0f);
+        mufAtomicStore(&_mufMipTablesReady, 1U);
+    }
+    mufSpinLockRelease(&_mufMipTablesLock);
+}
+
+MUF_INTERNAL muf_u8 _mufMipSrgbEncode(muf_f32 value) {
+    muf_u32 code = 0;
+    for (muf_u32 step = 128; step > 0; step >>= 1) {
+        if (_mufMipSrgbThresholds[code + step - 1] < value)
+            code += step;
+    }
+    return (muf_u8) code;
+}
+
+MUF_INTERNAL muf_bool _mufMipGetFormatInfo(MufFormat format, MufImagePixelType *pixelTypeOut, muf_u32 *channelsOut) {
+    for (muf_u32 type = MUF_IMAGE_PIXEL_TYPE_U8; type <= MUF_IMAGE_PIXEL_TYPE_F32; ++type) {
+        for (muf_u32 channels = 1; channels <= 4; ++channels) {
+            if (mufGetImageFormat((MufImagePixelType) type, channels) == format) {
+                *pixelTypeOut = (MufImagePixelType) type;
+                *channelsOut = channels;
+                return MUF_TRUE;
+            }
+        }
+    }
+    return MUF_FALSE;
+}
+
+MUF_INTERNAL muf_f32 _mufMipBesselI0(muf_f32 x) {
+    muf_f32 sum = 1.0f;
+    muf_f32 term = 1.0f;
+    muf_f32 halfX = x * 0.5f;
+    for (muf_u32 k = 1; k < 32; ++k) {
+        muf_f32 factor = halfX / (muf_f32) k;
+        term *= factor * factor;
+        sum += term;
+        if (term < sum * 1e-7f)
+            break;
+    }
+    return sum;
+}
+
+MUF_INTERNAL muf_f32 _mufMipFilterWeight(MufMipFilter filter, muf_f32 x) {
+    if (filter == MUF_MIP_FILTER_BOX)
+        return x > -0.5f && x <= 0.5f ? 1.0f : 0.0f;
+
+    if (fabsf(x) >= MUF_MIP_KAISER_WIDTH)
+        return 0.0f;
+    muf_f32 sinc = 1.0f;
+    if (x != 0.0f) {
+        muf_f32 px = (muf_f32) MUF_PI * x;
+        sinc = sinf(px) / px;
+    }
+    muf_f32 t = x / MUF_MIP_KAISER_WIDTH;
+    return sinc * _mufMipBesselI0(MUF_MIP_KAISER_ALPHA * sqrtf(1.0f - t * t)) / _mufMipBesselI0(MUF_MIP_KAISER_ALPHA);
+}
+
+/* Taps falling outside the source are folded onto the edge pixels, which clamps the image */
+MUF_INTERNAL void _mufMipBuildKernel(_MufMipKernel *kernel, muf_u32 srcSize, muf_u32 dstSize, MufMipFilter filter) {
+    muf_f32 scale = (muf_f32) srcSize / (muf_f32) dstSize;
+    muf_f32 filterScale = mufMax(scale, 1.0f);
+    muf_f32 support = (filter == MUF_MIP_FILTER_BOX ? 0.5f : MUF_MIP_KAISER_WIDTH) * filterScale;
+    muf_u32 maxTaps = (muf_u32) ceilf(support * 2.0f) + 2;
+
+    kernel->contribs = mufAlloc(_MufMipContrib, dstSize);
+    kernel->weights = mufAllocZero(muf_f32, (muf_usize) dstSize * maxTaps);
+    for (muf_u32 d = 0; d < dstSize; ++d) {
+        muf_f32 center = ((muf_f32) d + 0.5f) * scale;
+        muf_i32 lo = (muf_i32) floorf(center - support);
+        muf_i32 hi = (muf_i32) ceilf(center + support);
+        muf_i32 first = mufMax(lo, 0);
+        muf_i32 last = mufMin(hi, (muf_i32) srcSize - 1);
+        muf_f32 *weights = kernel->weights + (muf_usize) d * maxTaps;
+
+        muf_f32 sum = 0.0f;
+        for (muf_i32 i = lo; i <= hi; ++i) {
+            muf_f32 weight = _mufMipFilterWeight(filter, ((muf_f32) i + 0.5f - center) / filterScale);
+            muf_i32 clamped = mufClamp(i, first, last);
+            weights[clamped - first] += weight;
+            sum += weight;
+        }
+
+        muf_u32 count = (muf_u32) (last - first + 1);
+        if (sum == 0.0f) {
+            mufMemFill(weights, 0, sizeof(muf_f32) * count);
+            muf_i32 nearest = mufClamp((muf_i32) center, first, last);
+            weights[nearest - first] = 1.0f;
+            sum = 1.0f;
+        }
+        for (muf_u32 k = 0; k < count; ++k)
+            weights[k] /= sum;
+
+        /* Drop the zero taps at the ends of the window */
+        muf_u32 skip = 0;
+        while (count > 1 && weights[skip] == 0.0f) {
+            ++skip;
+            --count;
+        }
+        while (count > 1 && weights[skip + count - 1] == 0.0f)
+            --count;
+
+        kernel->contribs[d].first = (muf_u32) first + skip;
+        kernel->contribs[d].count = count;
+        kernel->contribs[d].offset = d * maxTaps + skip;
+    }
+}
+
+MUF_INTERNAL void _mufMipDestroyKernel(_MufMipKernel *kernel) {
+    mufSafeFree(kernel->contribs);
+    mufSafeFree(kernel->weights);
+}
+
+MUF_INTERNAL void _mufMipDecodeRow(const _MufMipResampleContext *context, muf_u32 y, muf_f32 *out) {
+    const MufImage *image = context->src;
+    const muf_byte *row = (const muf_byte *) image->data + (muf_usize) y * image->rowPitch;
+    muf_u32 channels = context->channels;
+
+    for (muf_u32 x = 0; x < image->width; ++x) {
+        muf_f32 *pixel = out + (muf_usize) x * 4;
+        pixel[0] = 0.0f;
+        pixel[1] = 0.0f;
+        pixel[2] = 0.0f;
+        pixel[3] = 1.0f;
+    }
+    switch (context->pixelType) {
+        case MUF_IMAGE_PIXEL_TYPE_U8: {
+            const muf_u8 *p = (const muf_u8 *) row;
+            for (muf_u32 x = 0; x < image->width; ++x) {
+                for (muf_u32 c = 0; c < channels; ++c)
+                    out[(muf_usize) x * 4 + c] = context->u8Tables[c][p[(muf_usize) x * channels + c]];
+            }
+            break;
+        }
+        case MUF_IMAGE_PIXEL_TYPE_U16: {
+            const muf_u16 *p = (const muf_u16 *) row;
+            for (muf_u32 x = 0; x < image->width; ++x) {
+                for (muf_u32 c = 0; c < channels; ++c)
+                    out[(muf_usize) x * 4 + c] = (muf_f32) p[(muf_usize) x * channels + c] * (1.0f / 65535.0f);
+            }
+            break;
+        }
+        default: {
+            const muf_f32 *p = (const muf_f32 *) row;
+            for (muf_u32 x = 0; x < image->width; ++x) {
+                for (muf_u32 c = 0; c < channels; ++c)
+                    out[(muf_usize) x * 4 + c] = p[(muf_usize) x * channels + c];
+            }
+            break;
+        }
+    }
+}
+
+MUF_INTERNAL void _mufMipEncodeRow(const _MufMipResampleContext *context, muf_u32 y, const muf_f32 *in) {
+    MufImage *image = context->dst;
+    muf_byte *row = (muf_byte *) image->data + (muf_usize) y * image->rowPitch;
+    muf_u32 channels = context->channels;
+
+    switch (context->pixelType) {
+        case MUF_IMAGE_PIXEL_TYPE_U8: {
+            muf_u8 *p = (muf_u8 *) row;
+            for (muf_u32 x = 0; x < image->width; ++x) {
+                for (muf_u32 c = 0; c < channels; ++c) {
+                    muf_f32 value = in[(muf_usize) x * 4 + c];
+                    p[(muf_usize) x * channels + c] = context->srgbChannels[c]
+                        ? _mufMipSrgbEncode(value)
+                        : (muf_u8) (mufClamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+                }
+            }
+            break;
+        }
+        case MUF_IMAGE_PIXEL_TYPE_U16: {
+            muf_u16 *p = (muf_u16 *) row;
+            for (muf_u32 x = 0; x < image->width; ++x) {
+                for (muf_u32 c = 0; c < channels; ++c)
+                    p[(muf_usize) x * channels + c] = (muf_u16) (mufClamp(in[(muf_usize) x * 4 + c], 0.0f, 1.0f) * 65535.0f + 0.5f);
+            }
+            break;
+        }
+        default: {
+            muf_f32 *p = (muf_f32 *) row;
+            for (muf_u32 x = 0; x < image->width; ++x) {
+                for (muf_u32 c = 0; c < channels; ++c)
+                    p[(muf_usize) x * channels + c] = in[(muf_usize) x * 4 + c];
+            }
+            break;
+        }
+    }
+}
+
+MUF_INTERNAL void _mufMipBox2x2Row(const muf_f32 *a, const muf_f32 *b, muf_f32 *out, muf_u32 dstWidth) {
+#if defined(MUF_SIMD_SSE2)
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    for (muf_u32 x = 0; x < dstWidth; ++x) {
+        const muf_f32 *pa = a + (muf_usize) x * 8;
+        const muf_f32 *pb = b + (muf_usize) x * 8;
+        __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(pa), _mm_loadu_ps(pa + 4)),
+            _mm_add_ps(_mm_loadu_ps(pb), _mm_loadu_ps(pb + 4)));
+        _mm_storeu_ps(out + (muf_usize) x * 4, _mm_mul_ps(sum, quarter));
+    }
+#else
+    for (muf_u32 x = 0; x < dstWidth; ++x) {
+        for (muf_u32 c = 0; c < 4; ++c) {
+            muf_usize i = (muf_usize) x * 8 + c;
+            out[(muf_usize) x * 4 + c] = (a[i] + a[i + 4] + b[i] + b[i + 4]) * 0.25f;
+        }
+    }
+#endif
+}
+
+MUF_INTERNAL void _mufMipFilterHorizontal(const _MufMipKernel *kernel, const muf_f32 *src, muf_f32 *out, muf_u32 dstWidth) {
+    for (muf_u32 x = 0; x < dstWidth; ++x) {
+        const _MufMipContrib *contrib = &kernel->contribs[x];
+        const muf_f32 *weights = kernel->weights + contrib->offset;
+        const muf_f32 *p = src + (muf_usize) contrib->first * 4;
+#if defined(MUF_SIMD_SSE2)
+        __m128 acc = _mm_setzero_ps();
+        for (muf_u32 k = 0; k < contrib->count; ++k)
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(p + (muf_usize) k * 4)));
+        _mm_storeu_ps(out + (muf_usize) x * 4, acc);
+#else
+        muf_f32 acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (muf_u32 k = 0; k < contrib->count; ++k) {
+            for (muf_u32 c = 0; c < 4; ++c)
+                acc[c] += weights[k] * p[(muf_usize) k * 4 + c];
+        }
+        mufMemCopyBytes(out + (muf_usize) x * 4, acc, sizeof(acc));
+#endif
+    }
+}
+
+/* Sum `count` rows spaced by `stride` floats, the rows hold `length` floats */
+MUF_INTERNAL void _mufMipFilterVertical(const muf_f32 *rows, muf_usize stride, const muf_f32 *weights, muf_u32 count,
+    muf_f32 *out, muf_usize length) {
+    muf_usize i = 0;
+#if defined(MUF_SIMD_SSE2)
+    for (; i + 4 <= length; i += 4) {
+        __m128 acc = _mm_setzero_ps();
+        for (muf_u32 k = 0; k < count; ++k)
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(rows + k * stride + i)));
+        _mm_storeu_ps(out + i, acc);
+    }
+#endif
+    for (; i < length; ++i) {
+        muf_f32 acc = 0.0f;
+        for (muf_u32 k = 0; k < count; ++k)
+            acc += weights[k] * rows[k * stride + i];
+        out[i] = acc;
+    }
+}
+
+#if defined(MUF_SIMD_MULTI_TARGET)
+MUF_SIMD_TARGET("avx")
+MUF_INTERNAL void _mufMipFilterVerticalAVX(const muf_f32 *rows, muf_usize stride, const muf_f32 *weights, muf_u32 count,
+    muf_f32 *out, muf_usize length) {
+    muf_usize i = 0;
+    for (; i + 8 <= length; i += 8) {
+        __m256 acc = _mm256_setzero_ps();
+        for (muf_u32 k = 0; k < count; ++k)
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(rows + k * stride + i)));
+        _mm256_storeu_ps(out + i, acc);
+    }
+    _mufMipFilterVertical(rows + i, stride, weights, count, out + i, length - i);
+}
+#endif
+
+MUF_INTERNAL void _mufMipResampleRows(muf_index first, muf_index last, muf_rawptr userData) {
+    const _MufMipResampleContext *context = (const _MufMipResampleContext *) userData;
+    muf_u32 srcWidth = context->src->width;
+    muf_u32 dstWidth = context->dst->width;
+    muf_usize dstLength = (muf_usize) dstWidth * 4;
+    muf_f32 *out = mufAlloc(muf_f32, dstLength);
+
+    if (context->box2x2) {
+        muf_f32 *a = mufAlloc(muf_f32, (muf_usize) srcWidth * 4);
+        muf_f32 *b = mufAlloc(muf_f32, (muf_usize) srcWidth * 4);
+        for (muf_index y = first; y < last; ++y) {
+            _mufMipDecodeRow(context, (muf_u32) y * 2, a);
+            _mufMipDecodeRow(context, (muf_u32) y * 2 + 1, b);
+            _mufMipBox2x2Row(a, b, out, dstWidth);
+            _mufMipEncodeRow(context, (muf_u32) y, out);
+        }
+        mufFree(b);
+        mufFree(a);
+        mufFree(out);
+        return;
+    }
+
+    /* Each source row of the band is filtered horizontally once, then the destination rows blend them */
+    const _MufMipContrib *contribs = context->vertical.contribs;
+    muf_u32 srcFirst = contribs[first].first;
+    muf_u32 srcEnd = 0;
+    for (muf_index y = first; y < last; ++y) {
+        srcFirst = mufMin(srcFirst, contribs[y].first);
+        srcEnd = mufMax(srcEnd, contribs[y].first + contribs[y].count);
+    }
+
+    muf_f32 *srcRow = mufAlloc(muf_f32, (muf_usize) srcWidth * 4);
+    muf_f32 *band = mufAlloc(muf_f32, (muf_usize) (srcEnd - srcFirst) * dstLength);
+    for (muf_u32 r = srcFirst; r < srcEnd; ++r) {
+        _mufMipDecodeRow(context, r, srcRow);
+        _mufMipFilterHorizontal(&context->horizontal, srcRow, band + (muf_usize) (r - srcFirst) * dstLength, dstWidth);
+    }
+    for (muf_index y = first; y < last; ++y) {
+        const _MufMipContrib *contrib = &contribs[y];
+        context->filterVertical(band + (muf_usize) (contrib->first - srcFirst) * dstLength, dstLength,
+            context->vertical.weights + contrib->offset, contrib->count, out, dstLength);
+        _mufMipEncodeRow(context, (muf_u32) y, out);
+    }
+    mufFree(band);
+    mufFree(srcRow);
+    mufFree(out);
+}
+
+MUF_INTERNAL muf_bool _mufMipInitContext(_MufMipResampleContext *context, const MufImage *src, MufImage *dst,
+    MufMipFilter filter, MufMipFlags flags) {
+    mufMemFill(context, 0, sizeof(_MufMipResampleContext));
+    if (src->format != dst->format || !_mufMipGetFormatInfo(src->format, &context->pixelType, &context->channels))
+        return MUF_FALSE;
+    if (src->width == 0 || src->height == 0 || dst->width == 0 || dst->height == 0)
+        return MUF_FALSE;
+
+    _mufMipInitTables();
+    context->src = src;
+    context->dst = dst;
+    /* The last channel of a two or four channel image is alpha */
+    muf_bool hasAlpha = context->channels == 2 || context->channels == 4;
+    for (muf_u32 c = 0; c < context->channels; ++c) {
+        muf_bool isColor = !hasAlpha || c + 1 < context->channels;
+        context->srgbChannels[c] = (flags & MUF_MIP_FLAGS_SRGB) && isColor && context->pixelType == MUF_IMAGE_PIXEL_TYPE_U8;
+        context->u8Tables[c] = context->srgbChannels[c] ? _mufMipSrgbTable : _mufMipUnormTable;
+    }
+
+    context->box2x2 = filter == MUF_MIP_FILTER_BOX && src->width == dst->width * 2 && src->height == dst->height * 2;
+    if (!context->box2x2) {
+        context->filterVertical = _mufMipFilterVertical;
+#if defined(MUF_SIMD_MULTI_TARGET)
+        if (mufHasCpuFeatures(MUF_CPU_FEATURE_AVX))
+            context->filterVertical = _mufMipFilterVerticalAVX;
+#endif
+        _mufMipBuildKernel(&context->horizontal, src->width, dst->width, filter);
+        _mufMipBuildKernel(&context->vertical, src->height, dst->height, filter);
+    }
+    return MUF_TRUE;
+}
+
+muf_bool mufResampleImage(MufThreadPool *pool, const MufImage *src, MufImage *dst, MufMipFilter filter, MufMipFlags flags) {
+    _MufMipResampleContext context;
+    if (!_mufMipInitContext(&context, src, dst, filter, flags))
+        return MUF_FALSE;
+
+    if (pool == NULL)
+        pool = mufGetGlobalThreadPool();
+    muf_usize minRows = mufMax((muf_usize) MUF_MIP_MIN_TASK_PIXELS / dst->width, (muf_usize) 1);
+    muf_usize grainSize = mufThreadPoolComputeGrainSize(pool, dst->height, minRows);
+    mufParallelFor(pool, dst->height, grainSize, _mufMipResampleRows, &context);
+
+    _mufMipDestroyKernel(&context.horizontal);
+    _mufMipDestroyKernel(&context.vertical);
+    return MUF_TRUE;
+}
+
+/*
+ * Exact 2x2 box levels only read the two rows above each destination row, so a band of rows of the deepest level
+ * depends on nothing outside the bands above it: a task filters its band through all the cascaded levels.
+ */
+typedef struct _MufMipCascade_s {
+    _MufMipResampleContext  levels[32];
+    muf_u32                 count;
+} _MufMipCascade;
+
+MUF_INTERNAL void _mufMipCascadeRows(muf_index first, muf_index last, muf_rawptr userData) {
+    _MufMipCascade *cascade = (_MufMipCascade *) userData;
+    for (muf_u32 i = 0; i < cascade->count; ++i) {
+        muf_u32 shift = cascade->count - 1 - i;
+        _mufMipResampleRows(first << shift, last << shift, &cascade->levels[i]);
+    }
+}
+
+/* Build the leading exact 2x2 box levels as a cascade, return the first level left to build */
+MUF_INTERNAL muf_u32 _mufMipBuildCascade(MufThreadPool *pool, MufMipChain *chain, const MufMipChainCreateInfo *info) {
+    if (info->filter != MUF_MIP_FILTER_BOX)
+        return 1;
+
+    /* A band of one row of a level covers two rows of the level above it */
+    muf_u32 depth = 0;
+    muf_u32 exactCount = 0;
+    muf_usize bandPixels = 0;
+    muf_usize grainSize = 0;
+    while (exactCount + 1 < chain->levelCount) {
+        const MufImage *src = &chain->levels[exactCount];
+        const MufImage *dst = &chain->levels[exactCount + 1];
+        if (src->width != dst->width * 2 || src->height != dst->height * 2)
+            break;
+        ++exactCount;
+
+        /* Go as deep as the rows of the deepest level still give every thread a task */
+        bandPixels = bandPixels * 2 + dst->width;
+        muf_usize minRows = mufMax((muf_usize) MUF_MIP_MIN_TASK_PIXELS / bandPixels, (muf_usize) 1);
+        muf_usize levelGrainSize = mufThreadPoolComputeGrainSize(pool, dst->height, minRows);
+        muf_usize taskCount = (dst->height + levelGrainSize - 1) / levelGrainSize;
+        if (depth == 0 || taskCount > mufThreadPoolGetWorkerCount(pool)) {
+            depth = exactCount;
+            grainSize = levelGrainSize;
+        }
+    }
+    if (depth < 2)
+        return 1;
+
+    _MufMipCascade *cascade = mufAlloc(_MufMipCascade, 1);
+    cascade->count = depth;
+    for (muf_u32 i = 0; i < depth; ++i)
+        _mufMipInitContext(&cascade->levels[i], &chain->levels[i], &chain->levels[i + 1], info->filter, info->flags);
+
+    mufParallelFor(pool, chain->levels[depth].height, grainSize, _mufMipCascadeRows, cascade);
+    mufFree(cascade);
+    return depth + 1;
+}
+
+muf_u32 mufGetMipLevelCount(muf_u32 width, muf_u32 height) {
+    muf_u32 size = mufMax(width, height);
+    muf_u32 count = 0;
+    while (size > 0) {
+        ++count;
+        size >>= 1;
+    }
+    return count;
+}
+
+MufMipChain *mufCreateMipChain(const MufImage *image, const MufMipChainCreateInfo *info) {
+    MufImagePixelType pixelType;
+    muf_u32 channels;
+    if (!_mufMipGetFormatInfo(image->format, &pixelType, &channels) || image->width == 0 || image->height == 0)
+        return NULL;
+
+    muf_u32 fullCount = mufGetMipLevelCount(image->width, image->height);
+    muf_u32 levelCount = info->levelCount != 0 ? mufMin(info->levelCount, fullCount) : fullCount;
+    muf_usize pixelSize = mufGetFormatPixelSize(image->format);
+
+    MufMipChain *chain = mufAlloc(MufMipChain, 1);
+    chain->levelCount = levelCount;
+    chain->levels = mufAlloc(MufImage, levelCount);
+    chain->dataSize = 0;
+    for (muf_u32 i = 0; i < levelCount; ++i) {
+        MufImage *level = &chain->levels[i];
+        level->width = mufMax(image->width >> i, 1U);
+        level->height = mufMax(image->height >> i, 1U);
+        level->channels = channels;
+        level->format = image->format;
+        level->rowPitch = level->width * pixelSize;
+        chain->dataSize += level->rowPitch * level->height;
+    }
+
+    chain->data = mufAllocBytes(chain->dataSize);
+    muf_usize offset = 0;
+    for (muf_u32 i = levelCount; i-- > 0; ) {
+        MufImage *level = &chain->levels[i];
+        level->data = (muf_byte *) chain->data + offset;
+        offset += level->rowPitch * level->height;
+    }
+
+    MufImage *base = &chain->levels[0];
+    for (muf_u32 y = 0; y < base->height; ++y) {
+        mufMemCopyBytes((muf_byte *) base->data + y * base->rowPitch,
+            (const muf_byte *) image->data + y * image->rowPitch, base->rowPitch);
+    }
+    MufThreadPool *pool = info->pool != NULL ? info->pool : mufGetGlobalThreadPool();
+    for (muf_u32 i = _mufMipBuildCascade(pool, chain, info); i < levelCount; ++i)
+        mufResampleImage(pool, &chain->levels[i - 1], &chain->levels[i], info->filter, info->flags);
+    return chain;
+}
+
+void mufDestroyMipChain(MufMipChain *chain) {
+    if (chain == NULL)
+        return;
+    mufFree(chain->data);
+    mufFree(chain->levels);
+    mufFree(chain);
+}
@@ -0,0 +1,314 @@
+#include "muffin_platform/archive.h"
+
+#include <string.h>
+
+#include "muffin_core/compression.h"
+#include "muffin_core/hash.h"
+#include "muffin_core/hash_set.h"
+#include "muffin_core/memory.h"
+#include "muffin_platform/filesystem.h"
+
+struct MufArchive_s {
+    MufFile                 *file;
+    MufFileView             view;
+    const MufArchiveHeader  *header;
+    const muf_char          *strings;
+    const MufArchiveEntry   *entries;
+    const muf_u32           *slots;
+};
+
+struct MufArchiveWriter_s {
+    MufFile         *file;
+    muf_u32         alignment;
+    muf_u64         position;
+    muf_char        *strings;
+    muf_usize       stringsSize;
+    muf_usize       stringsCapacity;
+    MufArchiveEntry *entries;
+    muf_usize       entryCount;
+    muf_usize       entryCapacity;
+    /* The path hashes added so far, only a hash already in it needs the entries to be searched */
+    MufHashSet      *pathHashes;
+    muf_bool        failed;
+};
+
+MUF_INTERNAL muf_u64 _mufArchiveHashPath(const muf_char *path, muf_usize length) {
+    return mufHashBytes64(path, length, 0);
+}
+
+MUF_INTERNAL muf_bool _mufArchiveRangeValid(muf_u64 offset, muf_u64 size, muf_u64 limit) {
+    return offset <= limit && size <= limit - offset;
+}
+
+MUF_INTERNAL muf_bool _mufArchiveValidate(MufArchive *archive) {
+    const muf_byte *base = (const muf_byte *) archive->view.data;
+    muf_u64 fileSize = archive->view.size;
+    if (fileSize < sizeof(MufArchiveHeader))
+        return MUF_FALSE;
+
+    const MufArchiveHeader *header = (const MufArchiveHeader *) base;
+    if (header->magic != MUF_ARCHIVE_MAGIC || header->version != MUF_ARCHIVE_VERSION
+        || header->hashBits != 64 || header->fileSize != fileSize)
+        return MUF_FALSE;
+    if (header->slotCount == 0 || (header->slotCount & (header->slotCount - 1)) != 0
+        || header->slotCount <= header->entryCount)
+        return MUF_FALSE;
+    if (!_mufArchiveRangeValid(header->stringsOffset, header->stringsSize, fileSize)
+        || !_mufArchiveRangeValid(header->entriesOffset, (muf_u64) header->entryCount * sizeof(MufArchiveEntry), fileSize)
+        || !_mufArchiveRangeValid(header->slotsOffset, (muf_u64) header->slotCount * sizeof(muf_u32), fileSize)
+        || header->entriesOffset % sizeof(muf_u64) != 0 || header->slotsOffset % sizeof(muf_u32) != 0)
+        return MUF_FALSE;
+
+    archive->header = header;
+    archive->strings = (const muf_char *) (base + header->stringsOffset);
+    archive->entries = (const MufArchiveEntry *) (base + header->entriesOffset);
+    archive->slots = (const muf_u32 *) (base + header->slotsOffset);
+
+    /* The paths are handed out as C strings, each must end with its terminator */
+    for (muf_u32 i = 0; i < header->entryCount; ++i) {
+        const MufArchiveEntry *entry = &archive->entries[i];
+        if (!_mufArchiveRangeValid(entry->offset, entry->compressedSize, fileSize)
+            || !_mufArchiveRangeValid(entry->pathOffset, (muf_u64) entry->pathLength + 1, header->stringsSize)
+            || archive->strings[entry->pathOffset + entry->pathLength] != '\0')
+            return MUF_FALSE;
+    }
+    /* A probe for a missing path ends at an empty slot, a table without one is malformed */
+    muf_bool hasEmptySlot = MUF_FALSE;
+    for (muf_u32 i = 0; i < header->slotCount; ++i) {
+        if (archive->slots[i] > header->entryCount)
+            return MUF_FALSE;
+        hasEmptySlot |= archive->slots[i] == 0;
+    }
+    return hasEmptySlot;
+}
+
+MufArchive *mufCreateArchive(const muf_char *path) {
+    MufFile *file = mufCreateFile(path, MUF_FILE_OPEN_READ);
+    if (!mufFileIsOpened(file)) {
+        mufDestroyFile(file);
+        return NULL;
+    }
+
+    MufArchive *archive = mufAllocZero(MufArchive, 1);
+    archive->file = file;
+    if (!mufFileMap(file, 0, 0, MUF_FILE_MAP_READ_ONLY, MUF_FILE_MAP_FLAG_RANDOM, &archive->view)
+        || !_mufArchiveValidate(archive)) {
+        mufDestroyArchive(archive);
+        return NULL;
+    }
+    return archive;
+}
+
+void mufDestroyArchive(MufArchive *archive) {
+    if (archive == NULL)
+        return;
+    mufFileUnmap(&archive->view);
+    mufDestroyFile(archive->file);
+    mufFree(archive);
+}
+
+muf_usize mufArchiveGetEntryCount(const MufArchive *archive) {
+    return archive->header->entryCount;
+}
+
+const MufArchiveEntry *mufArchiveGetEntry(const MufArchive *archive, muf_index index) {
+    if (index >= archive->header->entryCount)
+        return NULL;
+    return &archive->entries[index];
+}
+
+const MufArchiveEntry *mufArchiveFind(const MufArchive *archive, const muf_char *path) {
+    muf_usize length = strlen(path);
+    muf_u64 hash = _mufArchiveHashPath(path, length);
+    muf_u32 mask = archive->header->slotCount - 1;
+
+    muf_u32 slot = (muf_u32) hash & mask;
+    for (muf_u32 probe = 0; probe <= mask; ++probe, slot = (slot + 1) & mask) {
+        muf_u32 index = archive->slots[slot];
+        if (index == 0)
+            return NULL;
+        const MufArchiveEntry *entry = &archive->entries[index - 1];
+        if (entry->pathHash == hash && entry->pathLength == length
+            && memcmp(archive->strings + entry->pathOffset, path, length) == 0)
+            return entry;
+    }
+    return NULL;
+}
+
+muf_bool mufArchiveExists(const MufArchive *archive, const muf_char *path) {
+    return mufArchiveFind(archive, path) != NULL;
+}
+
+const muf_char *mufArchiveGetEntryPath(const MufArchive *archive, const MufArchiveEntry *entry) {
+    return archive->strings + entry->pathOffset;
+}
+
+const muf_byte *mufArchiveGetEntryData(const MufArchive *archive, const MufArchiveEntry *entry) {
+    return (const muf_byte *) archive->view.data + entry->offset;
+}
+
+muf_bool mufArchiveReadEntry(const MufArchive *archive, const MufArchiveEntry *entry, muf_rawptr dst) {
+    const muf_byte *data = mufArchiveGetEntryData(archive, entry);
+    if (entry->flags & MUF_ARCHIVE_ENTRY_FLAG_COMPRESSED)
+        return mufDecompressBlocks(NULL, data, (muf_usize) entry->compressedSize, dst, (muf_usize) entry->size);
+    if (entry->compressedSize != entry->size)
+        return MUF_FALSE;
+    mufMemCopyBytes(dst, data, (muf_usize) entry->size);
+    return MUF_TRUE;
+}
+
+MUF_INTERNAL void _mufArchiveWriterWrite(MufArchiveWriter *writer, muf_crawptr data, muf_usize size) {
+    if (size == 0 || writer->failed)
+        return;
+    if (mufFileWrite(writer->file, (const muf_rawptr) data, size) != size)
+        writer->failed = MUF_TRUE;
+    writer->position += size;
+}
+
+MUF_INTERNAL void _mufArchiveWriterPad(MufArchiveWriter *writer, muf_u64 alignment) {
+    static const muf_byte zeros[64] = { 0 };
+    muf_u64 padding = (alignment - writer->position % alignment) % alignment;
+    while (padding > 0) {
+        muf_usize chunk = (muf_usize) (padding < sizeof(zeros) ? padding : sizeof(zeros));
+        _mufArchiveWriterWrite(writer, zeros, chunk);
+        padding -= chunk;
+    }
+}
+
+MufArchiveWriter *mufCreateArchiveWriter(const muf_char *path, muf_u32 alignment) {
+    if (alignment == 0)
+        alignment = MUF_ARCHIVE_DEFAULT_ALIGN;
+    if ((alignment & (alignment - 1)) != 0)
+        return NULL;
+
+    MufFile *file = mufCreateFile(path, MUF_FILE_OPEN_TRUNC);
+    if (!mufFileIsOpened(file)) {
+        mufDestroyFile(file);
+        return NULL;
+    }
+
+    MufArchiveWriter *writer = mufAllocZero(MufArchiveWriter, 1);
+    writer->file = file;
+    writer->alignment = alignment;
+    writer->pathHashes = mufCreateHashSet_u64();
+
+    /* The header is rewritten by mufArchiveWriterFinish once the table of contents is known */
+    MufArchiveHeader header;
+    mufMemFill(&header, 0, sizeof(MufArchiveHeader));
+    _mufArchiveWriterWrite(writer, &header, sizeof(MufArchiveHeader));
+    return writer;
+}
+
+MUF_INTERNAL muf_bool _mufArchiveWriterAppend(MufArchiveWriter *writer, const muf_char *path,
+    muf_crawptr payload, muf_usize payloadSize, muf_usize size, muf_u32 flags) {
+    muf_usize length = strlen(path);
+    muf_u64 hash = _mufArchiveHashPath(path, length);
+    if (writer->failed || writer->entryCount >= 0xFFFFFFFEU)
+        return MUF_FALSE;
+
+    if (!mufHashSetInsert(writer->pathHashes, &hash)) {
+        for (muf_usize i = 0; i < writer->entryCount; ++i) {
+            const MufArchiveEntry *entry = &writer->entries[i];
+            if (entry->pathHash == hash && entry->pathLength == length
+                && memcmp(writer->strings + entry->pathOffset, path, length) == 0)
+                return MUF_FALSE;
+        }
+    }
+
+    if (writer->entryCount == writer->entryCapacity) {
+        writer->entryCapacity = writer->entryCapacity == 0 ? 64 : writer->entryCapacity * 2;
+        writer->entries = mufRealloc(MufArchiveEntry, writer->entries, writer->entryCapacity);
+    }
+    if (writer->stringsSize + length + 1 > writer->stringsCapacity) {
+        while (writer->stringsSize + length + 1 > writer->stringsCapacity)
+            writer->stringsCapacity = writer->stringsCapacity == 0 ? 4096 : writer->stringsCapacity * 2;
+        writer->strings = mufRealloc(muf_char, writer->strings, writer->stringsCapacity);
+    }
+
+    _mufArchiveWriterPad(writer, writer->alignment);
+
+    MufArchiveEntry *entry = &writer->entries[writer->entryCount++];
+    mufMemFill(entry, 0, sizeof(MufArchiveEntry));
+    entry->pathHash = hash;
+    entry->offset = writer->position;
+    entry->size = size;
+    entry->compressedSize = payloadSize;
+    entry->flags = flags;
+    entry->pathOffset = (muf_u32) writer->stringsSize;
+    entry->pathLength = (muf_u32) length;
+
+    /* Paths are stored null terminated so they can be handed out as C strings */
+    mufMemCopyBytes(writer->strings + writer->stringsSize, path, length + 1);
+    writer->stringsSize += length + 1;
+
+    _mufArchiveWriterWrite(writer, payload, payloadSize);
+    return !writer->failed;
+}
+
+muf_bool mufArchiveWriterAdd(MufArchiveWriter *writer, const muf_char *path, muf_crawptr data, muf_usize size) {
+    return _mufArchiveWriterAppend(writer, path, data, size, size, MUF_ARCHIVE_ENTRY_FLAG_NONE);
+}
+
+muf_bool mufArchiveWriterAddCompressed(MufArchiveWriter *writer, const muf_char *path, muf_crawptr data, muf_usize size, muf_u32 blockSize) {
+    muf_usize capacity = mufCompressBound(size, blockSize);
+    muf_byte *stream = mufAlloc(muf_byte, capacity);
+    muf_usize streamSize = mufCompressBlocks(data, size, stream, capacity, blockSize);
+
+    muf_bool succeeded;
+    if (streamSize == 0 || streamSize >= size)
+        succeeded = _mufArchiveWriterAppend(writer, path, data, size, size, MUF_ARCHIVE_ENTRY_FLAG_NONE);
+    else
+        succeeded = _mufArchiveWriterAppend(writer, path, stream, streamSize, size, MUF_ARCHIVE_ENTRY_FLAG_COMPRESSED);
+    mufFree(stream);
+    return succeeded;
+}
+
+muf_bool mufArchiveWriterFinish(MufArchiveWriter *writer) {
+    MufArchiveHeader header;
+    mufMemFill(&header, 0, sizeof(MufArchiveHeader));
+
+    /* Keep the load factor at or below one half so probe sequences stay short */
+    muf_u32 slotCount = 16;
+    while (slotCount < writer->entryCount * 2)
+        slotCount <<= 1;
+    muf_u32 *slots = mufAllocZero(muf_u32, slotCount);
+    for (muf_usize i = 0; i < writer->entryCount; ++i) {
+        muf_u32 slot = (muf_u32) writer->entries[i].pathHash & (slotCount - 1);
+        while (slots[slot] != 0)
+            slot = (slot + 1) & (slotCount - 1);
+        slots[slot] = (muf_u32) i + 1;
+    }
+
+    header.stringsOffset = writer->position;
+    header.stringsSize = writer->stringsSize;
+    _mufArchiveWriterWrite(writer, writer->strings, writer->stringsSize);
+
+    _mufArchiveWriterPad(writer, sizeof(muf_u64));
+    header.entriesOffset = writer->position;
+    _mufArchiveWriterWrite(writer, writer->entries, writer->entryCount * sizeof(MufArchiveEntry));
+
+    header.slotsOffset = writer->position;
+    _mufArchiveWriterWrite(writer, slots, slotCount * sizeof(muf_u32));
+
+    header.magic = MUF_ARCHIVE_MAGIC;
+    header.version = MUF_ARCHIVE_VERSION;
+    header.hashBits = 64;
+    header.alignment = writer->alignment;
+    header.entryCount = (muf_u32) writer->entryCount;
+    header.slotCount = slotCount;
+    header.fileSize = writer->position;
+
+    mufFileSeek(writer->file, 0, MUF_FILE_SEEK_BEG);
+    if (!writer->failed && mufFileWrite(writer->file, (const muf_rawptr) &header, sizeof(MufArchiveHeader)) != sizeof(MufArchiveHeader))
+        writer->failed = MUF_TRUE;
+    mufFileFlush(writer->file);
+
+    muf_bool succeeded = !writer->failed;
+    mufFree(slots);
+    mufSafeFree(writer->strings);
+    mufSafeFree(writer->entries);
+    mufDestroyHashSet(writer->pathHashes);
+    mufDestroyFile(writer->file);
+    mufFree(writer);
+    return succeeded;
+}
@@ -0,0 +1,819 @@
+#include "muffin_platform/file_watcher.h"
+
+#include <string.h>
+
+#include "internal/dir_watch.h"
+#include "muffin_core/hash.h"
+#include "muffin_core/math.h"
+#include "muffin_core/memory.h"
+#include "muffin_core/sync.h"
+#include "muffin_core/timer.h"
+#include "muffin_platform/filesystem.h"
+
+#if defined(MUF_PLATFORM_WIN32)
+#   include <windows.h>
+#else
+#   include <pthread.h>
+#endif
+
+#define MUF_FILE_WATCHER_DEFAULT_COALESCE_MS    100
+#define MUF_FILE_WATCHER_DEFAULT_MAX_LATENCY_MS 1000
+
+#if defined(MUF_PLATFORM_WIN32)
+    typedef HANDLE _MufFileWatcherNativeThread;
+#else
+    typedef pthread_t _MufFileWatcherNativeThread;
+#endif
+
+enum {
+    _MUF_FILE_WATCHER_COMMAND_NONE,
+    _MUF_FILE_WATCHER_COMMAND_ADD,
+    _MUF_FILE_WATCHER_COMMAND_REMOVE
+};
+
+typedef struct _MufFileWatchRoot_s {
+    MufFileWatchId  id;
+    muf_char        *path;
+    muf_usize       pathLength;
+} _MufFileWatchRoot;
+
+typedef struct _MufFileWatchHook_s {
+    MufFileWatchId      id;
+    muf_char            *pattern;
+    MufFileChangeHook   hook;
+    muf_rawptr          userData;
+    /* The binding of the shader, image and module hooks, released with the hook */
+    muf_rawptr          ownedData;
+    /* Removed while a dispatch runs, the entry is released once it returns */
+    muf_bool            removed;
+} _MufFileWatchHook;
+
+/* A program relinked from the shader slots whenever a shader hook replaces one of them */
+typedef struct _MufFileWatchProgram_s {
+    MufFileWatchId      id;
+    MufShaderProgram    *program;
+    MufShader           **shaders;
+    muf_usize           shaderCount;
+} _MufFileWatchProgram;
+
+/* A change owns its path, relativePath points into it */
+typedef struct _MufFilePendingChange_s {
+    muf_u64         hash;
+    muf_usize       pathLength;
+    MufFileChange   change;
+} _MufFilePendingChange;
+
+typedef struct _MufFileChangeList_s {
+    _MufFilePendingChange   *changes;
+    muf_usize               count;
+    muf_usize               capacity;
+} _MufFileChangeList;
+
+typedef struct _MufFileWatcherCommand_s {
+    muf_u32         op;
+    MufFileWatchId  id;
+    const muf_char  *directory;
+    muf_bool        done;
+    muf_bool        result;
+} _MufFileWatcherCommand;
+
+struct MufFileWatcher_s {
+    _MufDirWatch                *watch;
+    _MufFileWatcherNativeThread thread;
+    muf_u64                     coalesceNs;
+    muf_u64                     maxLatencyNs;
+    MufFileChangeSetCallback    callback;
+    muf_rawptr                  userData;
+
+    /* Guards the roots, the command and the published batches */
+    MufLock                     *lock;
+    MufCondVar                  *commandDone;
+    _MufFileWatcherCommand      command;
+    muf_bool                    stopping;
+    MufFileWatchId              nextId;
+
+    /* Only the watcher thread modifies the roots, it reads them without the lock */
+    _MufFileWatchRoot           *roots;
+    muf_usize                   rootCount;
+    muf_usize                   rootCapacity;
+
+    /* Owned by the watcher thread */
+    _MufFileChangeList          pending;
+    muf_u64                     firstEventTime;
+    muf_u64                     lastEventTime;
+
+    /* Published batches, batchEnds holds the end index of each batch in published */
+    _MufFileChangeList          published;
+    muf_usize                   *batchEnds;
+    muf_usize                   batchCount;
+    muf_usize                   batchCapacity;
+
+    /* Guards the hooks and the programs, it is released while a hook runs so hooks can add and remove hooks */
+    MufLock                     *hookLock;
+    _MufFileWatchHook           *hooks;
+    muf_usize                   hookCount;
+    muf_usize                   hookCapacity;
+    muf_u32                     dispatchDepth;
+    _MufFileWatchProgram        *programs;
+    muf_usize                   programCount;
+    muf_usize                   programCapacity;
+};
+
+typedef struct _MufShaderBinding_s {
+    MufFileWatcher  *watcher;
+    MufShaderType   stageType;
+    MufShader       *shader;
+} _MufShaderBinding;
+
+typedef struct _MufImageBinding_s {
+    muf_bool        flipVertically;
+    MufImage        **image;
+} _MufImageBinding;
+
+typedef struct _MufModuleBinding_s {
+    MufModule       module;
+} _MufModuleBinding;
+
+MUF_INTERNAL muf_char *_mufFileWatcherDuplicate(const muf_char *str, muf_usize length) {
+    muf_char *copy = mufAlloc(muf_char, length + 1);
+    mufMemCopyBytes(copy, str, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+/**
+ * Bring a path into the form the watcher reports: '\\' becomes '/', empty and '.' components are dropped
+ * and a leading separator is kept. Unlike mufVfsNormalizePath '..' is left alone since native paths may climb.
+ */
+MUF_INTERNAL muf_usize _mufFileWatcherCleanPath(const muf_char *path, muf_char *pathOut, muf_usize capacity) {
+    muf_usize length = 0;
+    const muf_char *p = path;
+    muf_bool absolute = *p == '/' || *p == '\\';
+
+    if (absolute) {
+        if (capacity < 2)
+            return 0;
+        pathOut[length++] = '/';
+    }
+    while (*p != '\0') {
+        while (*p == '/' || *p == '\\')
+            ++p;
+        const muf_char *begin = p;
+        while (*p != '\0' && *p != '/' && *p != '\\')
+            ++p;
+        muf_usize componentLength = (muf_usize) (p - begin);
+        if (componentLength == 0 || (componentLength == 1 && begin[0] == '.'))
+            continue;
+
+        muf_bool separate = length > 0 && pathOut[length - 1] != '/';
+        if (length + (separate ? 1 : 0) + componentLength + 1 > capacity)
+            return 0;
+        if (separate)
+            pathOut[length++] = '/';
+        mufMemCopyBytes(pathOut + length, begin, componentLength);
+        length += componentLength;
+    }
+
+    if (length == 0) {
+        if (capacity < 2)
+            return 0;
+        pathOut[length++] = '.';
+    }
+    pathOut[length] = '\0';
+    return length;
+}
+
+MUF_INTERNAL muf_bool _mufFileWatcherMatch(const muf_char *pattern, const muf_char *path) {
+    const muf_char *star = NULL;
+    const muf_char *resume = NULL;
+    while (*path != '\0') {
+        if (*pattern == '*') {
+            star = pattern++;
+            resume = path;
+        } else if (*pattern == '?' || *pattern == *path) {
+            ++pattern;
+            ++path;
+        } else if (star != NULL) {
+            pattern = star + 1;
+            path = ++resume;
+        } else {
+            return MUF_FALSE;
+        }
+    }
+    while (*pattern == '*')
+        ++pattern;
+    return *pattern == '\0';
+}
+
+MUF_INTERNAL muf_bool _mufFileWatchRootContains(const _MufFileWatchRoot *root, const muf_char *path) {
+    if (root->pathLength == 1 && root->path[0] == '.')
+        return path[0] != '/' && strncmp(path, "../", 3) != 0;
+    if (root->pathLength == 1 && root->path[0] == '/')
+        return path[0] == '/';
+    return strncmp(path, root->path, root->pathLength) == 0 && path[root->pathLength] == '/';
+}
+
+MUF_INTERNAL void _mufFileChangeListClear(_MufFileChangeList *list) {
+    for (muf_usize i = 0; i < list->count; ++i)
+        mufFree((muf_rawptr) list->changes[i].change.path);
+    list->count = 0;
+}
+
+MUF_INTERNAL _MufFilePendingChange *_mufFileChangeListPush(_MufFileChangeList *list) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity == 0 ? 16 : list->capacity * 2;
+        list->changes = mufRealloc(_MufFilePendingChange, list->changes, list->capacity);
+    }
+    return &list->changes[list->count++];
+}
+
+MUF_INTERNAL const _MufFileWatchRoot *_mufFileWatcherFindRoot(const MufFileWatcher *watcher, MufFileWatchId id) {
+    for (muf_usize i = 0; i < watcher->rootCount; ++i) {
+        if (watcher->roots[i].id == id)
+            return &watcher->roots[i];
+    }
+    return NULL;
+}
+
+/* Fold a new event into the flags already collected for the path during the quiet period */
+MUF_INTERNAL muf_u32 _mufFileWatcherMergeFlags(muf_u32 flags, muf_u32 events) {
+    if (events & MUF_FILE_CHANGE_REMOVED)
+        return (flags & ~(muf_u32) (MUF_FILE_CHANGE_MODIFIED | MUF_FILE_CHANGE_CREATED)) | events;
+    if ((events & MUF_FILE_CHANGE_CREATED) && (flags & MUF_FILE_CHANGE_REMOVED)) {
+        /* Removed and created again, the way most editors save a file */
+        flags &= ~(muf_u32) MUF_FILE_CHANGE_REMOVED;
+        flags |= MUF_FILE_CHANGE_MODIFIED;
+    }
+    return flags | events;
+}
+
+MUF_INTERNAL void _mufFileWatcherOnEvent(muf_rawptr userData, muf_u32 tag, const muf_char *relativePath, muf_u32 events) {
+    MufFileWatcher *watcher = (MufFileWatcher *) userData;
+    const _MufFileWatchRoot *root = _mufFileWatcherFindRoot(watcher, tag);
+    if (root == NULL)
+        return;
+
+    muf_u32 flags = 0;
+    if (events & _MUF_DIR_WATCH_EVENT_MODIFIED)
+        flags |= MUF_FILE_CHANGE_MODIFIED;
+    if (events & _MUF_DIR_WATCH_EVENT_CREATED)
+        flags |= MUF_FILE_CHANGE_CREATED;
+    if (events & _MUF_DIR_WATCH_EVENT_REMOVED)
+        flags |= MUF_FILE_CHANGE_REMOVED;
+    if (events & _MUF_DIR_WATCH_EVENT_DIRECTORY)
+        flags |= MUF_FILE_CHANGE_DIRECTORY;
+    if (events & _MUF_DIR_WATCH_EVENT_OVERFLOW)
+        flags |= MUF_FILE_CHANGE_OVERFLOW;
+
+    muf_char joined[MUF_FILE_WATCHER_MAX_PATH];
+    muf_char path[MUF_FILE_WATCHER_MAX_PATH];
+    muf_usize relativeLength = strlen(relativePath);
+    if (root->pathLength + 1 + relativeLength + 1 > sizeof(joined))
+        return;
+    mufMemCopyBytes(joined, root->path, root->pathLength);
+    joined[root->pathLength] = '/';
+    mufMemCopyBytes(joined + root->pathLength + 1, relativePath, relativeLength + 1);
+    muf_usize pathLength = _mufFileWatcherCleanPath(joined, path, sizeof(path));
+    if (pathLength == 0)
+        return;
+
+    muf_u64 now = mufTimerGetNanoseconds();
+    if (watcher->pending.count == 0)
+        watcher->firstEventTime = now;
+    watcher->lastEventTime = now;
+
+    muf_u64 hash = mufHashBytes64(path, pathLength, 0);
+    for (muf_usize i = 0; i < watcher->pending.count; ++i) {
+        _MufFilePendingChange *pending = &watcher->pending.changes[i];
+        if (pending->hash == hash && pending->pathLength == pathLength && memcmp(pending->change.path, path, pathLength) == 0) {
+            pending->change.flags = _mufFileWatcherMergeFlags(pending->change.flags, flags);
+            return;
+        }
+    }
+
+    _MufFilePendingChange *pending = _mufFileChangeListPush(&watcher->pending);
+    muf_char *copy = _mufFileWatcherDuplicate(path, pathLength);
+    muf_usize skip = relativeLength == 0 ? pathLength : mufMin(pathLength, root->pathLength + 1);
+    if (root->pathLength == 1 && root->path[0] == '.')
+        skip = relativeLength == 0 ? pathLength : 0;
+    pending->hash = hash;
+    pending->pathLength = pathLength;
+    pending->change.path = copy;
+    pending->change.relativePath = copy + skip;
+    pending->change.directory = tag;
+    pending->change.flags = flags;
+}
+
+MUF_INTERNAL void _mufFileWatcherRunCommandLocked(MufFileWatcher *watcher) {
+    _MufFileWatcherCommand *command = &watcher->command;
+    if (command->op == _MUF_FILE_WATCHER_COMMAND_ADD) {
+        muf_char path[MUF_FILE_WATCHER_MAX_PATH];
+        muf_usize pathLength = _mufFileWatcherCleanPath(command->directory, path, sizeof(path));
+        command->result = pathLength != 0 && _mufDirWatchAddTree(watcher->watch, path, command->id);
+        if (command->result) {
+            if (watcher->rootCount == watcher->rootCapacity) {
+                watcher->rootCapacity = watcher->rootCapacity == 0 ? 4 : watcher->rootCapacity * 2;
+                watcher->roots = mufRealloc(_MufFileWatchRoot, watcher->roots, watcher->rootCapacity);
+            }
+            _MufFileWatchRoot *root = &watcher->roots[watcher->rootCount++];
+            root->id = command->id;
+            root->path = _mufFileWatcherDuplicate(path, pathLength);
+            root->pathLength = pathLength;
+        }
+    } else {
+        _mufDirWatchRemoveTree(watcher->watch, command->id);
+        command->result = MUF_FALSE;
+        for (muf_usize i = 0; i < watcher->rootCount; ++i) {
+            if (watcher->roots[i].id == command->id) {
+                mufFree(watcher->roots[i].path);
+                watcher->roots[i] = watcher->roots[--watcher->rootCount];
+                command->result = MUF_TRUE;
+                break;
+            }
+        }
+    }
+    command->done = MUF_TRUE;
+    mufCondVarBroadcast(watcher->commandDone);
+}
+
+MUF_INTERNAL void _mufFileWatcherPublishLocked(MufFileWatcher *watcher) {
+    for (muf_usize i = 0; i < watcher->pending.count; ++i)
+        *_mufFileChangeListPush(&watcher->published) = watcher->pending.changes[i];
+    watcher->pending.count = 0;
+
+    if (watcher->batchCount == watcher->batchCapacity) {
+        watcher->batchCapacity = watcher->batchCapacity == 0 ? 4 : watcher->batchCapacity * 2;
+        watcher->batchEnds = mufRealloc(muf_usize, watcher->batchEnds, watcher->batchCapacity);
+    }
+    watcher->batchEnds[watcher->batchCount++] = watcher->published.count;
+}
+
+MUF_INTERNAL void _mufFileWatcherLoop(MufFileWatcher *watcher) {
+    mufLockAcquire(watcher->lock);
+    while (!watcher->stopping) {
+        if (watcher->command.op != _MUF_FILE_WATCHER_COMMAND_NONE && !watcher->command.done)
+            _mufFileWatcherRunCommandLocked(watcher);
+
+        muf_i32 timeoutMs = -1;
+        if (watcher->pending.count > 0) {
+            muf_u64 now = mufTimerGetNanoseconds();
+            muf_u64 quietDeadline = watcher->lastEventTime + watcher->coalesceNs;
+            muf_u64 latencyDeadline = watcher->firstEventTime + watcher->maxLatencyNs;
+            muf_u64 deadline = mufMin(quietDeadline, latencyDeadline);
+            if (now >= deadline) {
+                _mufFileWatcherPublishLocked(watcher);
+                continue;
+            }
+            /* Round up so the wait does not end just before the deadline */
+            timeoutMs = (muf_i32) ((deadline - now + 999999) / 1000000);
+        }
+
+        mufLockRelease(watcher->lock);
+        _mufDirWatchRead(watcher->watch, timeoutMs, _mufFileWatcherOnEvent, watcher);
+        mufLockAcquire(watcher->lock);
+    }
+    mufLockRelease(watcher->lock);
+}
+
+#if defined(MUF_PLATFORM_WIN32)
+static DWORD WINAPI _mufFileWatcherEntry(LPVOID param) {
+    _mufFileWatcherLoop((MufFileWatcher *) param);
+    return 0;
+}
+#else
+static void *_mufFileWatcherEntry(void *param) {
+    _mufFileWatcherLoop((MufFileWatcher *) param);
+    return NULL;
+}
+#endif
+
+MufFileWatcher *mufCreateFileWatcher(const MufFileWatcherCreateInfo *info) {
+    _MufDirWatch *watch = _mufCreateDirWatch();
+    if (watch == NULL)
+        return NULL;
+
+    MufFileWatcher *watcher = mufAllocZero(MufFileWatcher, 1);
+    muf_u32 coalesceMs = info != NULL && info->coalesceMs != 0 ? info->coalesceMs : MUF_FILE_WATCHER_DEFAULT_COALESCE_MS;
+    muf_u32 maxLatencyMs = info != NULL && info->maxLatencyMs != 0 ? info->maxLatencyMs : MUF_FILE_WATCHER_DEFAULT_MAX_LATENCY_MS;
+    watcher->watch = watch;
+    watcher->coalesceNs = (muf_u64) coalesceMs * 1000000;
+    watcher->maxLatencyNs = (muf_u64) mufMax(maxLatencyMs, coalesceMs) * 1000000;
+    watcher->callback = info != NULL ? info->callback : NULL;
+    watcher->userData = info != NULL ? info->userData : NULL;
+    watcher->lock = mufCreateLock();
+    watcher->commandDone = mufCreateCondVar();
+    watcher->hookLock = mufCreateLock();
+
+#if defined(MUF_PLATFORM_WIN32)
+    watcher->thread = CreateThread(NULL, 0, _mufFileWatcherEntry, watcher, 0, NULL);
+    muf_bool started = watcher->thread != NULL;
+#else
+    muf_bool started = pthread_create(&watcher->thread, NULL, _mufFileWatcherEntry, watcher) == 0;
+#endif
+    if (!started) {
+        mufDestroyLock(watcher->hookLock);
+        mufDestroyCondVar(watcher->commandDone);
+        mufDestroyLock(watcher->lock);
+        _mufDestroyDirWatch(watch);
+        mufFree(watcher);
+        return NULL;
+    }
+    return watcher;
+}
+
+void mufDestroyFileWatcher(MufFileWatcher *watcher) {
+    if (watcher == NULL)
+        return;
+
+    mufLockAcquire(watcher->lock);
+    watcher->stopping = MUF_TRUE;
+    _mufDirWatchWake(watcher->watch);
+    mufLockRelease(watcher->lock);
+#if defined(MUF_PLATFORM_WIN32)
+    WaitForSingleObject(watcher->thread, INFINITE);
+    CloseHandle(watcher->thread);
+#else
+    pthread_join(watcher->thread, NULL);
+#endif
+
+    _mufFileChangeListClear(&watcher->pending);
+    _mufFileChangeListClear(&watcher->published);
+    mufSafeFree(watcher->pending.changes);
+    mufSafeFree(watcher->published.changes);
+    mufSafeFree(watcher->batchEnds);
+    for (muf_usize i = 0; i < watcher->rootCount; ++i)
+        mufFree(watcher->roots[i].path);
+    mufSafeFree(watcher->roots);
+    for (muf_usize i = 0; i < watcher->hookCount; ++i) {
+        mufFree(watcher->hooks[i].pattern);
+        mufSafeFree(watcher->hooks[i].ownedData);
+    }
+    mufSafeFree(watcher->hooks);
+    for (muf_usize i = 0; i < watcher->programCount; ++i)
+        mufFree(watcher->programs[i].shaders);
+    mufSafeFree(watcher->programs);
+
+    _mufDestroyDirWatch(watcher->watch);
+    mufDestroyLock(watcher->hookLock);
+    mufDestroyCondVar(watcher->commandDone);
+    mufDestroyLock(watcher->lock);
+    mufFree(watcher);
+}
+
+/* Hand a directory command to the watcher thread, it owns the native watch */
+MUF_INTERNAL muf_bool _mufFileWatcherRunCommand(MufFileWatcher *watcher, muf_u32 op, MufFileWatchId id, const muf_char *directory) {
+    mufLockAcquire(watcher->lock);
+    while (watcher->command.op != _MUF_FILE_WATCHER_COMMAND_NONE)
+        mufCondVarWait(watcher->commandDone, watcher->lock);
+
+    watcher->command.op = op;
+    watcher->command.id = id;
+    watcher->command.directory = directory;
+    watcher->command.done = MUF_FALSE;
+    _mufDirWatchWake(watcher->watch);
+    while (!watcher->command.done)
+        mufCondVarWait(watcher->commandDone, watcher->lock);
+
+    muf_bool result = watcher->command.result;
+    watcher->command.op = _MUF_FILE_WATCHER_COMMAND_NONE;
+    mufCondVarBroadcast(watcher->commandDone);
+    mufLockRelease(watcher->lock);
+    return result;
+}
+
+MUF_INTERNAL MufFileWatchId _mufFileWatcherNextId(MufFileWatcher *watcher) {
+    mufLockAcquire(watcher->lock);
+    MufFileWatchId id = ++watcher->nextId;
+    mufLockRelease(watcher->lock);
+    return id;
+}
+
+MufFileWatchId mufFileWatcherAddDirectory(MufFileWatcher *watcher, const muf_char *directory) {
+    MufFileWatchId id = _mufFileWatcherNextId(watcher);
+    return _mufFileWatcherRunCommand(watcher, _MUF_FILE_WATCHER_COMMAND_ADD, id, directory) ? id : 0;
+}
+
+void mufFileWatcherRemoveDirectory(MufFileWatcher *watcher, MufFileWatchId directory) {
+    _mufFileWatcherRunCommand(watcher, _MUF_FILE_WATCHER_COMMAND_REMOVE, directory, NULL);
+}
+
+MUF_INTERNAL MufFileWatchId _mufFileWatcherAddHook(MufFileWatcher *watcher, const muf_char *pattern, MufFileChangeHook hook,
+    muf_rawptr userData, muf_rawptr ownedData) {
+    muf_char cleaned[MUF_FILE_WATCHER_MAX_PATH];
+    muf_usize length = _mufFileWatcherCleanPath(pattern, cleaned, sizeof(cleaned));
+    if (length == 0) {
+        mufSafeFree(ownedData);
+        return 0;
+    }
+
+    MufFileWatchId id = _mufFileWatcherNextId(watcher);
+    mufLockAcquire(watcher->hookLock);
+    if (watcher->hookCount == watcher->hookCapacity) {
+        watcher->hookCapacity = watcher->hookCapacity == 0 ? 8 : watcher->hookCapacity * 2;
+        watcher->hooks = mufRealloc(_MufFileWatchHook, watcher->hooks, watcher->hookCapacity);
+    }
+    _MufFileWatchHook *entry = &watcher->hooks[watcher->hookCount++];
+    entry->id = id;
+    entry->pattern = _mufFileWatcherDuplicate(cleaned, length);
+    entry->hook = hook;
+    entry->userData = userData;
+    entry->ownedData = ownedData;
+    entry->removed = MUF_FALSE;
+    mufLockRelease(watcher->hookLock);
+    return id;
+}
+
+MufFileWatchId mufFileWatcherAddHook(MufFileWatcher *watcher, const muf_char *pattern, MufFileChangeHook hook, muf_rawptr userData) {
+    return _mufFileWatcherAddHook(watcher, pattern, hook, userData, NULL);
+}
+
+/* Keep the registration order, hooks run in it */
+MUF_INTERNAL void _mufFileWatcherPurgeHooksLocked(MufFileWatcher *watcher) {
+    muf_usize kept = 0;
+    for (muf_usize i = 0; i < watcher->hookCount; ++i) {
+        if (watcher->hooks[i].removed) {
+            mufFree(watcher->hooks[i].pattern);
+            mufSafeFree(watcher->hooks[i].ownedData);
+        } else {
+            watcher->hooks[kept++] = watcher->hooks[i];
+        }
+    }
+    watcher->hookCount = kept;
+}
+
+void mufFileWatcherRemoveHook(MufFileWatcher *watcher, MufFileWatchId hook) {
+    mufLockAcquire(watcher->hookLock);
+    for (muf_usize i = 0; i < watcher->hookCount; ++i) {
+        if (watcher->hooks[i].id == hook) {
+            /* A running dispatch may still hold the pattern and the binding */
+            watcher->hooks[i].removed = MUF_TRUE;
+            if (watcher->dispatchDepth == 0)
+                _mufFileWatcherPurgeHooksLocked(watcher);
+            break;
+        }
+    }
+    for (muf_usize i = 0; i < watcher->programCount; ++i) {
+        if (watcher->programs[i].id == hook) {
+            mufFree(watcher->programs[i].shaders);
+            watcher->programs[i] = watcher->programs[--watcher->programCount];
+            break;
+        }
+    }
+    mufLockRelease(watcher->hookLock);
+}
+
+muf_usize mufFileWatcherDispatch(MufFileWatcher *watcher) {
+    _MufFileChangeList published;
+    muf_usize *batchEnds;
+    muf_usize batchCount;
+
+    mufLockAcquire(watcher->lock);
+    if (watcher->batchCount == 0) {
+        mufLockRelease(watcher->lock);
+        return 0;
+    }
+    published = watcher->published;
+    batchEnds = watcher->batchEnds;
+    batchCount = watcher->batchCount;
+    mufMemFill(&watcher->published, 0, sizeof(_MufFileChangeList));
+    watcher->batchEnds = NULL;
+    watcher->batchCount = 0;
+    watcher->batchCapacity = 0;
+    mufLockRelease(watcher->lock);
+
+    MufFileChange *changes = mufAlloc(MufFileChange, published.count);
+    for (muf_usize i = 0; i < published.count; ++i)
+        changes[i] = published.changes[i].change;
+
+    /*
+     * The hooks run without the hook lock so they can add and remove hooks. Removed entries stay in place until
+     * the outermost dispatch returns, the indices and the copied patterns remain valid meanwhile.
+     */
+    mufLockAcquire(watcher->hookLock);
+    ++watcher->dispatchDepth;
+    mufLockRelease(watcher->hookLock);
+
+    muf_usize begin = 0;
+    for (muf_usize b = 0; b < batchCount; ++b) {
+        MufFileChangeSet changeSet = { changes + begin, batchEnds[b] - begin };
+        if (watcher->callback != NULL)
+            watcher->callback(&changeSet, watcher->userData);
+        for (muf_usize i = 0; i < changeSet.count; ++i) {
+            const MufFileChange *change = &changeSet.changes[i];
+            for (muf_usize h = 0;; ++h) {
+                mufLockAcquire(watcher->hookLock);
+                if (h >= watcher->hookCount) {
+                    mufLockRelease(watcher->hookLock);
+                    break;
+                }
+                _MufFileWatchHook hook = watcher->hooks[h];
+                mufLockRelease(watcher->hookLock);
+
+                /* An overflow may hide any change, every hook is told about it */
+                if (!hook.removed && ((change->flags & MUF_FILE_CHANGE_OVERFLOW) || _mufFileWatcherMatch(hook.pattern, change->path)))
+                    hook.hook(change, hook.userData);
+            }
+        }
+        begin = batchEnds[b];
+    }
+
+    mufLockAcquire(watcher->hookLock);
+    if (--watcher->dispatchDepth == 0)
+        _mufFileWatcherPurgeHooksLocked(watcher);
+    mufLockRelease(watcher->hookLock);
+
+    mufFree(changes);
+    _mufFileChangeListClear(&published);
+    mufSafeFree(published.changes);
+    mufFree(batchEnds);
+    return begin;
+}
+
+/* Watch the directory of a file unless a watched directory already covers it */
+MUF_INTERNAL muf_bool _mufFileWatcherCover(MufFileWatcher *watcher, const muf_char *path) {
+    muf_char cleaned[MUF_FILE_WATCHER_MAX_PATH];
+    if (_mufFileWatcherCleanPath(path, cleaned, sizeof(cleaned)) == 0)
+        return MUF_FALSE;
+
+    mufLockAcquire(watcher->lock);
+    muf_bool covered = MUF_FALSE;
+    for (muf_usize i = 0; i < watcher->rootCount && !covered; ++i)
+        covered = _mufFileWatchRootContains(&watcher->roots[i], cleaned);
+    mufLockRelease(watcher->lock);
+    if (covered)
+        return MUF_TRUE;
+
+    muf_char *separator = strrchr(cleaned, '/');
+    if (separator == NULL)
+        return mufFileWatcherAddDirectory(watcher, ".") != 0;
+    if (separator == cleaned)
+        separator[1] = '\0';
+    else
+        separator[0] = '\0';
+    return mufFileWatcherAddDirectory(watcher, cleaned) != 0;
+}
+
+MUF_INTERNAL muf_bool _mufFileChangeNeedsReload(const MufFileChange *change) {
+    if (change->flags & MUF_FILE_CHANGE_OVERFLOW)
+        return MUF_TRUE;
+    return !(change->flags & (MUF_FILE_CHANGE_REMOVED | MUF_FILE_CHANGE_DIRECTORY));
+}
+
+/* Keep the old program when the new one fails to link, a later fix of the sources relinks again */
+MUF_INTERNAL void _mufFileWatcherRelinkProgram(const _MufFileWatchProgram *binding) {
+    MufShader shaders[MUF_FILE_WATCHER_MAX_PROGRAM_SHADERS];
+    for (muf_usize i = 0; i < binding->shaderCount; ++i)
+        shaders[i] = *binding->shaders[i];
+
+    MufShaderProgramCreateInfo info;
+    info.shaderCount = binding->shaderCount;
+    info.shaders = shaders;
+    info.autoDestroy = MUF_FALSE;
+    MufShaderProgram program = mufCreateShaderProgram(&info);
+    if (mufIsNullHandle(program))
+        return;
+    if (!mufIsShaderProgramLinked(program)) {
+        mufDestroyShaderProgram(program);
+        return;
+    }
+    if (!mufIsNullHandle((*binding->program)))
+        mufDestroyShaderProgram(*binding->program);
+    *binding->program = program;
+}
+
+MUF_INTERNAL void _mufFileWatcherReloadShader(const MufFileChange *change, muf_rawptr userData) {
+    _MufShaderBinding *binding = (_MufShaderBinding *) userData;
+    if (!_mufFileChangeNeedsReload(change))
+        return;
+
+    /* On an overflow the change names the watched directory, the hook pattern is the file itself */
+    const muf_char *path = (const muf_char *) (binding + 1);
+    MufFile *file = mufCreateFile(path, MUF_FILE_OPEN_READ);
+    if (!mufFileIsOpened(file)) {
+        mufDestroyFile(file);
+        return;
+    }
+    muf_usize size = mufFileGetSize(file);
+    muf_char *source = mufAlloc(muf_char, size + 1);
+    size = mufFileRead(file, size, source);
+    source[size] = '\0';
+    mufDestroyFile(file);
+
+    MufShaderCreateInfo info = MUF_DEFAULT_SHADER_CREATE_INFO;
+    info.stageType = binding->stageType;
+    info.sourceType = MUF_SHADER_SOURCE_TYPE_TEXT;
+    info.source = source;
+    info.sourceSize = size;
+    MufShader shader = mufCreateShader(&info);
+    mufFree(source);
+
+    if (mufIsNullHandle(shader))
+        return;
+    if (!mufIsShaderCompiled(shader)) {
+        mufDestroyShader(shader);
+        return;
+    }
+    if (!mufIsNullHandle((*binding->shader)))
+        mufDestroyShader(*binding->shader);
+    *binding->shader = shader;
+
+    MufFileWatcher *watcher = binding->watcher;
+    mufLockAcquire(watcher->hookLock);
+    for (muf_usize i = 0; i < watcher->programCount; ++i) {
+        for (muf_usize j = 0; j < watcher->programs[i].shaderCount; ++j) {
+            if (watcher->programs[i].shaders[j] == binding->shader) {
+                _mufFileWatcherRelinkProgram(&watcher->programs[i]);
+                break;
+            }
+        }
+    }
+    mufLockRelease(watcher->hookLock);
+}
+
+MUF_INTERNAL void _mufFileWatcherReloadImage(const MufFileChange *change, muf_rawptr userData) {
+    _MufImageBinding *binding = (_MufImageBinding *) userData;
+    if (!_mufFileChangeNeedsReload(change))
+        return;
+
+    const muf_char *path = (const muf_char *) (binding + 1);
+    MufImage *image = mufCreateImageFromFile(path, binding->flipVertically);
+    if (image == NULL || image->data == NULL) {
+        if (image != NULL)
+            mufDestroyImage(image);
+        return;
+    }
+    if (*binding->image != NULL)
+        mufDestroyImage(*binding->image);
+    *binding->image = image;
+}
+
+MUF_INTERNAL void _mufFileWatcherReloadModule(const MufFileChange *change, muf_rawptr userData) {
+    _MufModuleBinding *binding = (_MufModuleBinding *) userData;
+    if (_mufFileChangeNeedsReload(change))
+        mufReloadModule(binding->module, MUF_TRUE);
+}
+
+/* The binding is followed by the cleaned path of the file, both live in one allocation owned by the hook */
+MUF_INTERNAL muf_rawptr _mufFileWatcherAllocBinding(muf_usize bindingSize, const muf_char *path) {
+    muf_char cleaned[MUF_FILE_WATCHER_MAX_PATH];
+    muf_usize length = _mufFileWatcherCleanPath(path, cleaned, sizeof(cleaned));
+    if (length == 0)
+        return NULL;
+    muf_byte *binding = mufAllocZero(muf_byte, bindingSize + length + 1);
+    mufMemCopyBytes(binding + bindingSize, cleaned, length + 1);
+    return binding;
+}
+
+MufFileWatchId mufFileWatcherHookShader(MufFileWatcher *watcher, const muf_char *path, MufShaderType stageType, MufShader *shader) {
+    if (!_mufFileWatcherCover(watcher, path))
+        return 0;
+    _MufShaderBinding *binding = (_MufShaderBinding *) _mufFileWatcherAllocBinding(sizeof(_MufShaderBinding), path);
+    if (binding == NULL)
+        return 0;
+    binding->watcher = watcher;
+    binding->stageType = stageType;
+    binding->shader = shader;
+    return _mufFileWatcherAddHook(watcher, path, _mufFileWatcherReloadShader, binding, binding);
+}
+
+MufFileWatchId mufFileWatcherHookShaderProgram(MufFileWatcher *watcher, MufShaderProgram *program,
+    MufShader *const *shaders, muf_usize shaderCount) {
+    if (shaderCount == 0 || shaderCount > MUF_FILE_WATCHER_MAX_PROGRAM_SHADERS)
+        return 0;
+
+    MufFileWatchId id = _mufFileWatcherNextId(watcher);
+    mufLockAcquire(watcher->hookLock);
+    if (watcher->programCount == watcher->programCapacity) {
+        watcher->programCapacity = watcher->programCapacity == 0 ? 8 : watcher->programCapacity * 2;
+        watcher->programs = mufRealloc(_MufFileWatchProgram, watcher->programs, watcher->programCapacity);
+    }
+    _MufFileWatchProgram *entry = &watcher->programs[watcher->programCount++];
+    entry->id = id;
+    entry->program = program;
+    entry->shaders = mufAlloc(MufShader *, shaderCount);
+    mufMemCopyBytes(entry->shaders, shaders, shaderCount * sizeof(MufShader *));
+    entry->shaderCount = shaderCount;
+    mufLockRelease(watcher->hookLock);
+    return id;
+}
+
+MufFileWatchId mufFileWatcherHookImage(MufFileWatcher *watcher, const muf_char *path, muf_bool flipVertically, MufImage **image) {
+    if (!_mufFileWatcherCover(watcher, path))
+        return 0;
+    _MufImageBinding *binding = (_MufImageBinding *) _mufFileWatcherAllocBinding(sizeof(_MufImageBinding), path);
+    if (binding == NULL)
+        return 0;
+    binding->flipVertically = flipVertically;
+    binding->image = image;
+    return _mufFileWatcherAddHook(watcher, path, _mufFileWatcherReloadImage, binding, binding);
+}
+
+MufFileWatchId mufFileWatcherHookModule(MufFileWatcher *watcher, const muf_char *path, MufModule module) {
+    if (!_mufFileWatcherCover(watcher, path))
+        return 0;
+    _MufModuleBinding *binding = (_MufModuleBinding *) _mufFileWatcherAllocBinding(sizeof(_MufModuleBinding), path);
+    if (binding == NULL)
+        return 0;
+    binding->module = module;
+    return _mufFileWatcherAddHook(watcher, path, _mufFileWatcherReloadModule, binding, binding);
+}
@@ -0,0 +1,50 @@
+#ifndef _MUFFIN_PLATFORM_INTERNAL_DIR_WATCH_H_
+#define _MUFFIN_PLATFORM_INTERNAL_DIR_WATCH_H_
+
+#include "muffin_core/common.h"
+
+enum {
+    _MUF_DIR_WATCH_EVENT_MODIFIED   = 1 << 0,
+    _MUF_DIR_WATCH_EVENT_CREATED    = 1 << 1,
+    _MUF_DIR_WATCH_EVENT_REMOVED    = 1 << 2,
+    _MUF_DIR_WATCH_EVENT_DIRECTORY  = 1 << 3,
+    /* Events were dropped by the kernel, every cached state of the tree is suspect */
+    _MUF_DIR_WATCH_EVENT_OVERFLOW   = 1 << 4
+};
+
+/**
+ * @brief Receive one change, the path is relative to the watched root and '/' separated
+ * (empty for an overflow, which is reported once per tree)
+ */
+typedef void (*_MufDirWatchCallback)(muf_rawptr userData, muf_u32 tag, const muf_char *relativePath, muf_u32 events);
+
+typedef struct _MufDirWatch_s _MufDirWatch;
+
+/**
+ * @brief Create a change notification source, NULL if the platform or the kernel refuses
+ */
+_MufDirWatch *_mufCreateDirWatch(void);
+
+void _mufDestroyDirWatch(_MufDirWatch *watch);
+
+/**
+ * @brief Watch a directory and everything below it, subdirectories created later are picked up automatically
+ * @param[in] tag The tag reported with the events of this tree, it also identifies the tree for removal
+ */
+muf_bool _mufDirWatchAddTree(_MufDirWatch *watch, const muf_char *directory, muf_u32 tag);
+
+void _mufDirWatchRemoveTree(_MufDirWatch *watch, muf_u32 tag);
+
+/**
+ * @brief Deliver the pending changes
+ * @param[in] timeoutMs How long to wait for the first change, 0 to return immediately, negative to wait forever
+ * @return The count of delivered changes
+ */
+muf_usize _mufDirWatchRead(_MufDirWatch *watch, muf_i32 timeoutMs, _MufDirWatchCallback callback, muf_rawptr userData);
+
+/**
+ * @brief Make a blocked _mufDirWatchRead return, it is safe to call from any thread
+ */
+void _mufDirWatchWake(_MufDirWatch *watch);
+
+#endif
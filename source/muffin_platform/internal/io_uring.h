@@ -0,0 +1,67 @@
+#ifndef _MUFFIN_PLATFORM_INTERNAL_IO_URING_H_
+#define _MUFFIN_PLATFORM_INTERNAL_IO_URING_H_
+
+#include "muffin_core/common.h"
+
+#if defined(MUF_PLATFORM_LINUX)
+#   define MUF_IO_HAS_IO_URING
+#endif
+
+#if defined(MUF_IO_HAS_IO_URING)
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/* A minimal io_uring driver on top of the raw system calls */
+typedef struct _MufIoUring_s {
+    muf_i32             fd;
+    muf_u32             sqEntries;
+    muf_u32             cqEntries;
+    volatile muf_u32    *sqHead;
+    volatile muf_u32    *sqTail;
+    muf_u32             sqMask;
+    muf_u32             *sqArray;
+    struct io_uring_sqe *sqes;
+    volatile muf_u32    *cqHead;
+    volatile muf_u32    *cqTail;
+    muf_u32             cqMask;
+    struct io_uring_cqe *cqes;
+    muf_rawptr          sqRing;
+    muf_usize           sqRingSize;
+    muf_rawptr          cqRing;
+    muf_usize           cqRingSize;
+    muf_usize           sqesSize;
+    muf_u32             unsubmitted;
+} _MufIoUring;
+
+muf_bool _mufIoUringInit(_MufIoUring *ring, muf_u32 entries);
+
+void _mufIoUringFinish(_MufIoUring *ring);
+
+muf_u32 _mufIoUringGetFreeSlots(const _MufIoUring *ring);
+
+/**
+ * @brief Queue a read, it is sent to the kernel by the next _mufIoUringSubmit
+ * @param[in] ioprio The ioprio value (class and level), 0 to inherit the thread priority
+ * @return False if the submission ring is full
+ */
+muf_bool _mufIoUringPrepRead(_MufIoUring *ring, muf_i32 fd, muf_rawptr dst, muf_u32 size, muf_u64 offset,
+    muf_u64 userData, muf_u16 ioprio);
+
+muf_bool _mufIoUringPrepCancel(_MufIoUring *ring, muf_u64 targetUserData, muf_u64 userData);
+
+/**
+ * @brief Submit the queued entries and optionally wait for completions
+ * @return The count of submitted entries, or a negative errno
+ */
+muf_i32 _mufIoUringSubmit(_MufIoUring *ring, muf_u32 waitCount);
+
+/**
+ * @brief Pop a completion without blocking
+ * @return False if the completion ring is empty
+ */
+muf_bool _mufIoUringPeek(_MufIoUring *ring, muf_u64 *userDataOut, muf_i32 *resultOut);
+
+#endif
+
+#endif
@@ -0,0 +1,578 @@
+#include "muffin_platform/io.h"
+
+#include <errno.h>
+
+#include "internal/io_uring.h"
+#include "muffin_core/math.h"
+#include "muffin_core/memory.h"
+#include "muffin_core/sync.h"
+
+#if defined(MUF_PLATFORM_WIN32)
+#   include <windows.h>
+#else
+#   include <pthread.h>
+#   include <unistd.h>
+#endif
+
+#define MUF_IO_DEFAULT_QUEUE_DEPTH  64
+#define MUF_IO_DEFAULT_WORKER_COUNT 4
+#define MUF_IO_MAX_WORKERS          32
+/* A single kernel read is capped below 2 GiB, larger requests are split */
+#define MUF_IO_MAX_CHUNK_SIZE       (1U << 30)
+
+enum {
+    _MUF_IO_STATE_FREE,
+    _MUF_IO_STATE_QUEUED,
+    _MUF_IO_STATE_DISPATCHED,
+    _MUF_IO_STATE_RUNNING,
+    _MUF_IO_STATE_DONE
+};
+
+typedef struct _MufIoRequest_s {
+    struct _MufIoRequest_s  *next;
+    MufIoRequestId          id;
+    MufIoReadRequest        info;
+    muf_usize               bytesRead;
+    muf_i32                 error;
+    MufIoStatus             status;
+    muf_u32                 state;
+    muf_u32                 generation;
+    muf_bool                cancelRequested;
+} _MufIoRequest;
+
+typedef struct _MufIoList_s {
+    _MufIoRequest *head;
+    _MufIoRequest *tail;
+} _MufIoList;
+
+#if defined(MUF_PLATFORM_WIN32)
+    typedef HANDLE _MufIoNativeThread;
+#else
+    typedef pthread_t _MufIoNativeThread;
+#endif
+
+struct MufIoQueue_s {
+    MufLock             *lock;
+    MufCondVar          *workReady;
+    MufCondVar          *progress;
+    MufIoBackend        backend;
+    muf_u32             queueDepth;
+    muf_u32             inFlight;
+    muf_usize           outstanding;
+    muf_bool            stopping;
+
+    _MufIoList          queued[_MUF_IO_PRIORITY_COUNT_];
+    _MufIoList          work;
+    _MufIoList          done;
+
+    _MufIoRequest       **slots;
+    muf_u32             slotCount;
+    muf_u32             slotCapacity;
+    _MufIoRequest       *freeList;
+
+    muf_usize           workerCount;
+    _MufIoNativeThread  *workers;
+#if defined(MUF_IO_HAS_IO_URING)
+    _MufIoUring         ring;
+#endif
+};
+
+MUF_INTERNAL void _mufIoListPush(_MufIoList *list, _MufIoRequest *request) {
+    request->next = NULL;
+    if (list->tail != NULL)
+        list->tail->next = request;
+    else
+        list->head = request;
+    list->tail = request;
+}
+
+MUF_INTERNAL _MufIoRequest *_mufIoListPop(_MufIoList *list) {
+    _MufIoRequest *request = list->head;
+    if (request != NULL) {
+        list->head = request->next;
+        if (list->head == NULL)
+            list->tail = NULL;
+        request->next = NULL;
+    }
+    return request;
+}
+
+MUF_INTERNAL muf_bool _mufIoListRemove(_MufIoList *list, _MufIoRequest *request) {
+    _MufIoRequest *prev = NULL;
+    for (_MufIoRequest *cur = list->head; cur != NULL; prev = cur, cur = cur->next) {
+        if (cur != request)
+            continue;
+        if (prev != NULL)
+            prev->next = cur->next;
+        else
+            list->head = cur->next;
+        if (list->tail == cur)
+            list->tail = prev;
+        cur->next = NULL;
+        return MUF_TRUE;
+    }
+    return MUF_FALSE;
+}
+
+/* Requests live in slots that are never freed, the id is (generation << 32 | slot + 1) so stale ids are rejected */
+MUF_INTERNAL _MufIoRequest *_mufIoAllocRequestLocked(MufIoQueue *queue) {
+    _MufIoRequest *request = queue->freeList;
+    if (request != NULL) {
+        queue->freeList = request->next;
+    } else {
+        if (queue->slotCount == queue->slotCapacity) {
+            queue->slotCapacity = queue->slotCapacity == 0 ? 64 : queue->slotCapacity * 2;
+            queue->slots = mufRealloc(_MufIoRequest *, queue->slots, queue->slotCapacity);
+        }
+        request = mufAllocZero(_MufIoRequest, 1);
+        request->id = (MufIoRequestId) queue->slotCount + 1;
+        queue->slots[queue->slotCount++] = request;
+    }
+    ++request->generation;
+    request->id = ((MufIoRequestId) request->generation << 32) | (request->id & 0xFFFFFFFFULL);
+    request->next = NULL;
+    request->bytesRead = 0;
+    request->error = 0;
+    request->status = MUF_IO_STATUS_PENDING;
+    request->cancelRequested = MUF_FALSE;
+    return request;
+}
+
+MUF_INTERNAL void _mufIoFreeRequestLocked(MufIoQueue *queue, _MufIoRequest *request) {
+    request->state = _MUF_IO_STATE_FREE;
+    request->next = queue->freeList;
+    queue->freeList = request;
+}
+
+MUF_INTERNAL _MufIoRequest *_mufIoFindRequestLocked(MufIoQueue *queue, MufIoRequestId id) {
+    muf_u32 slot = (muf_u32) (id & 0xFFFFFFFFULL);
+    if (slot == 0 || slot > queue->slotCount)
+        return NULL;
+    _MufIoRequest *request = queue->slots[slot - 1];
+    if (request->id != id || request->state == _MUF_IO_STATE_FREE)
+        return NULL;
+    return request;
+}
+
+MUF_INTERNAL void _mufIoFinishLocked(MufIoQueue *queue, _MufIoRequest *request, MufIoStatus status, muf_i32 error) {
+    if (request->state == _MUF_IO_STATE_DISPATCHED || request->state == _MUF_IO_STATE_RUNNING)
+        --queue->inFlight;
+    request->state = _MUF_IO_STATE_DONE;
+    request->status = status;
+    request->error = error;
+    _mufIoListPush(&queue->done, request);
+    mufCondVarBroadcast(queue->progress);
+}
+
+/* Positional read used by the worker threads, it does not touch the file cursor */
+MUF_INTERNAL muf_i32 _mufIoReadAt(MufFile *file, muf_offset offset, muf_usize size, muf_rawptr dst, muf_usize *bytesReadOut) {
+    muf_usize total = 0;
+#if defined(MUF_PLATFORM_WIN32)
+    while (total < size) {
+        DWORD chunk = (DWORD) mufMin(size - total, (muf_usize) MUF_IO_MAX_CHUNK_SIZE);
+        DWORD readSize = 0;
+        OVERLAPPED overlapped = { 0 };
+        muf_u64 position = (muf_u64) offset + total;
+        overlapped.Offset = (DWORD) position;
+        overlapped.OffsetHigh = (DWORD) (position >> 32);
+        overlapped.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+        BOOL ok = ReadFile(file->handle._ptr, (muf_byte *) dst + total, chunk, NULL, &overlapped);
+        if (ok || GetLastError() == ERROR_IO_PENDING)
+            ok = GetOverlappedResult(file->handle._ptr, &overlapped, &readSize, TRUE);
+        CloseHandle(overlapped.hEvent);
+        if (!ok) {
+            *bytesReadOut = total;
+            return GetLastError() == ERROR_HANDLE_EOF ? 0 : (muf_i32) GetLastError();
+        }
+        if (readSize == 0)
+            break;
+        total += readSize;
+    }
+#else
+    while (total < size) {
+        muf_usize chunk = mufMin(size - total, (muf_usize) MUF_IO_MAX_CHUNK_SIZE);
+        ssize_t result = pread(file->handle._i32, (muf_byte *) dst + total, chunk, (off_t) (offset + total));
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result < 0) {
+            *bytesReadOut = total;
+            return errno;
+        }
+        if (result == 0)
+            break;
+        total += (muf_usize) result;
+    }
+#endif
+    *bytesReadOut = total;
+    return 0;
+}
+
+#if defined(MUF_IO_HAS_IO_URING)
+MUF_INTERNAL muf_u16 _mufIoUringPriority(MufIoPriority priority) {
+    /* Best-effort class (2) with level 0 as the most urgent */
+    static const muf_u16 levels[] = { 6, 4, 2, 0 };
+    return (muf_u16) ((2 << 13) | levels[(muf_index) priority]);
+}
+
+MUF_INTERNAL muf_bool _mufIoUringDispatchLocked(MufIoQueue *queue, _MufIoRequest *request) {
+    muf_usize remaining = request->info.size - request->bytesRead;
+    muf_u32 chunk = (muf_u32) mufMin(remaining, (muf_usize) MUF_IO_MAX_CHUNK_SIZE);
+    return _mufIoUringPrepRead(&queue->ring, request->info.file->handle._i32,
+        (muf_byte *) request->info.dst + request->bytesRead, chunk,
+        (muf_u64) request->info.offset + request->bytesRead,
+        (muf_u64) (muf_usize) request, _mufIoUringPriority(request->info.priority));
+}
+
+/* Move completions from the ring into the done list, short reads are resubmitted for the remainder */
+MUF_INTERNAL void _mufIoUringReapLocked(MufIoQueue *queue) {
+    muf_u64 userData;
+    muf_i32 result;
+    while (_mufIoUringPeek(&queue->ring, &userData, &result)) {
+        if (userData == 0)
+            continue;
+        _MufIoRequest *request = (_MufIoRequest *) (muf_usize) userData;
+        if (result == -ECANCELED) {
+            _mufIoFinishLocked(queue, request, MUF_IO_STATUS_CANCELED, ECANCELED);
+        } else if (result < 0) {
+            _mufIoFinishLocked(queue, request, MUF_IO_STATUS_FAILED, -result);
+        } else {
+            request->bytesRead += (muf_usize) result;
+            if (result == 0 || request->bytesRead == request->info.size || request->cancelRequested
+                || !_mufIoUringDispatchLocked(queue, request)) {
+                _mufIoFinishLocked(queue, request, request->cancelRequested && request->bytesRead < request->info.size
+                    ? MUF_IO_STATUS_CANCELED : MUF_IO_STATUS_COMPLETED, 0);
+            }
+        }
+    }
+}
+#endif
+
+/* Start queued requests, highest priority first, until the queue depth is reached */
+MUF_INTERNAL void _mufIoDispatchLocked(MufIoQueue *queue) {
+    muf_bool dispatched = MUF_FALSE;
+    while (queue->inFlight < queue->queueDepth) {
+        _MufIoRequest *request = NULL;
+        for (muf_i32 p = _MUF_IO_PRIORITY_COUNT_ - 1; p >= 0 && request == NULL; --p)
+            request = _mufIoListPop(&queue->queued[p]);
+        if (request == NULL)
+            break;
+
+        request->state = _MUF_IO_STATE_DISPATCHED;
+        ++queue->inFlight;
+#if defined(MUF_IO_HAS_IO_URING)
+        if (queue->backend == MUF_IO_BACKEND_IO_URING) {
+            if (!_mufIoUringDispatchLocked(queue, request)) {
+                /* The submission ring is full, flush it and retry once */
+                _mufIoUringSubmit(&queue->ring, 0);
+                if (!_mufIoUringDispatchLocked(queue, request)) {
+                    --queue->inFlight;
+                    request->state = _MUF_IO_STATE_QUEUED;
+                    _mufIoListPush(&queue->queued[request->info.priority], request);
+                    break;
+                }
+            }
+            continue;
+        }
+#endif
+        _mufIoListPush(&queue->work, request);
+        dispatched = MUF_TRUE;
+    }
+
+#if defined(MUF_IO_HAS_IO_URING)
+    if (queue->backend == MUF_IO_BACKEND_IO_URING) {
+        muf_i32 result = _mufIoUringSubmit(&queue->ring, 0);
+        (void) result;
+        return;
+    }
+#endif
+    if (dispatched)
+        mufCondVarBroadcast(queue->workReady);
+}
+
+MUF_INTERNAL void _mufIoWorkerLoop(MufIoQueue *queue) {
+    mufLockAcquire(queue->lock);
+    for (;;) {
+        while (queue->work.head == NULL && !queue->stopping)
+            mufCondVarWait(queue->workReady, queue->lock);
+        _MufIoRequest *request = _mufIoListPop(&queue->work);
+        if (request == NULL)
+            break;
+        request->state = _MUF_IO_STATE_RUNNING;
+        MufIoReadRequest info = request->info;
+        mufLockRelease(queue->lock);
+
+        muf_usize bytesRead = 0;
+        muf_i32 error = _mufIoReadAt(info.file, info.offset, info.size, info.dst, &bytesRead);
+
+        mufLockAcquire(queue->lock);
+        request->bytesRead = bytesRead;
+        _mufIoFinishLocked(queue, request, error == 0 ? MUF_IO_STATUS_COMPLETED : MUF_IO_STATUS_FAILED, error);
+        _mufIoDispatchLocked(queue);
+    }
+    mufLockRelease(queue->lock);
+}
+
+#if defined(MUF_PLATFORM_WIN32)
+static DWORD WINAPI _mufIoWorkerEntry(LPVOID param) {
+    _mufIoWorkerLoop((MufIoQueue *) param);
+    return 0;
+}
+#else
+static void *_mufIoWorkerEntry(void *param) {
+    _mufIoWorkerLoop((MufIoQueue *) param);
+    return NULL;
+}
+#endif
+
+MUF_INTERNAL void _mufIoStartWorkers(MufIoQueue *queue, muf_usize workerCount) {
+    queue->workers = mufAlloc(_MufIoNativeThread, workerCount);
+    queue->workerCount = 0;
+    for (muf_usize i = 0; i < workerCount; ++i) {
+#if defined(MUF_PLATFORM_WIN32)
+        HANDLE thread = CreateThread(NULL, 0, _mufIoWorkerEntry, queue, 0, NULL);
+        if (thread == NULL)
+            break;
+        queue->workers[queue->workerCount++] = thread;
+#else
+        if (pthread_create(&queue->workers[queue->workerCount], NULL, _mufIoWorkerEntry, queue) != 0)
+            break;
+        ++queue->workerCount;
+#endif
+    }
+}
+
+MufIoQueue *mufCreateIoQueue(const MufIoQueueCreateInfo *info) {
+    MufIoQueue *queue = mufAllocZero(MufIoQueue, 1);
+    MufIoBackend backend = info != NULL ? info->backend : MUF_IO_BACKEND_AUTO;
+    muf_u32 queueDepth = info != NULL && info->queueDepth != 0 ? info->queueDepth : MUF_IO_DEFAULT_QUEUE_DEPTH;
+    muf_u32 workerCount = info != NULL && info->workerCount != 0 ? info->workerCount : MUF_IO_DEFAULT_WORKER_COUNT;
+
+    queue->lock = mufCreateLock();
+    queue->workReady = mufCreateCondVar();
+    queue->progress = mufCreateCondVar();
+    queue->queueDepth = queueDepth;
+
+#if defined(MUF_IO_HAS_IO_URING)
+    if (backend == MUF_IO_BACKEND_AUTO || backend == MUF_IO_BACKEND_IO_URING) {
+        if (_mufIoUringInit(&queue->ring, queueDepth)) {
+            queue->backend = MUF_IO_BACKEND_IO_URING;
+            return queue;
+        }
+    }
+#endif
+
+    queue->backend = MUF_IO_BACKEND_THREAD_POOL;
+    _mufIoStartWorkers(queue, mufMin(workerCount, (muf_u32) MUF_IO_MAX_WORKERS));
+    return queue;
+}
+
+void mufDestroyIoQueue(MufIoQueue *queue) {
+    if (queue == NULL)
+        return;
+
+    mufLockAcquire(queue->lock);
+    for (muf_usize p = 0; p < _MUF_IO_PRIORITY_COUNT_; ++p) {
+        _MufIoRequest *request;
+        while ((request = _mufIoListPop(&queue->queued[p])) != NULL)
+            _mufIoFinishLocked(queue, request, MUF_IO_STATUS_CANCELED, ECANCELED);
+    }
+    mufLockRelease(queue->lock);
+    mufIoQueueDrain(queue);
+
+    mufLockAcquire(queue->lock);
+    queue->stopping = MUF_TRUE;
+    mufCondVarBroadcast(queue->workReady);
+    mufLockRelease(queue->lock);
+
+    for (muf_usize i = 0; i < queue->workerCount; ++i) {
+#if defined(MUF_PLATFORM_WIN32)
+        WaitForSingleObject(queue->workers[i], INFINITE);
+        CloseHandle(queue->workers[i]);
+#else
+        pthread_join(queue->workers[i], NULL);
+#endif
+    }
+    mufSafeFree(queue->workers);
+
+#if defined(MUF_IO_HAS_IO_URING)
+    if (queue->backend == MUF_IO_BACKEND_IO_URING)
+        _mufIoUringFinish(&queue->ring);
+#endif
+
+    for (muf_u32 i = 0; i < queue->slotCount; ++i)
+        mufFree(queue->slots[i]);
+    mufSafeFree(queue->slots);
+    mufDestroyCondVar(queue->progress);
+    mufDestroyCondVar(queue->workReady);
+    mufDestroyLock(queue->lock);
+    mufFree(queue);
+}
+
+MufIoBackend mufIoQueueGetBackend(const MufIoQueue *queue) {
+    return queue->backend;
+}
+
+muf_usize mufIoQueueSubmitReads(MufIoQueue *queue, const MufIoReadRequest *requests, muf_usize count, MufIoRequestId *idsOut) {
+    muf_usize accepted = 0;
+    mufLockAcquire(queue->lock);
+    for (muf_usize i = 0; i < count; ++i) {
+        const MufIoReadRequest *info = &requests[i];
+        if (info->file == NULL || !mufFileIsOpened(info->file) || info->offset < 0
+            || (muf_u32) info->priority >= _MUF_IO_PRIORITY_COUNT_) {
+            if (idsOut != NULL)
+                idsOut[i] = 0;
+            continue;
+        }
+
+        _MufIoRequest *request = _mufIoAllocRequestLocked(queue);
+        request->info = *info;
+        request->state = _MUF_IO_STATE_QUEUED;
+        _mufIoListPush(&queue->queued[info->priority], request);
+        ++queue->outstanding;
+        ++accepted;
+        if (idsOut != NULL)
+            idsOut[i] = request->id;
+    }
+    _mufIoDispatchLocked(queue);
+    mufLockRelease(queue->lock);
+    return accepted;
+}
+
+MufIoRequestId mufIoQueueSubmitRead(MufIoQueue *queue, const MufIoReadRequest *request) {
+    MufIoRequestId id = 0;
+    mufIoQueueSubmitReads(queue, request, 1, &id);
+    return id;
+}
+
+muf_bool mufIoQueueCancel(MufIoQueue *queue, MufIoRequestId id) {
+    muf_bool withdrawn = MUF_FALSE;
+    mufLockAcquire(queue->lock);
+    _MufIoRequest *request = _mufIoFindRequestLocked(queue, id);
+    if (request != NULL) {
+        if (request->state == _MUF_IO_STATE_QUEUED) {
+            _mufIoListRemove(&queue->queued[request->info.priority], request);
+            _mufIoFinishLocked(queue, request, MUF_IO_STATUS_CANCELED, ECANCELED);
+            withdrawn = MUF_TRUE;
+        } else if (request->state == _MUF_IO_STATE_DISPATCHED && queue->backend == MUF_IO_BACKEND_THREAD_POOL) {
+            _mufIoListRemove(&queue->work, request);
+            _mufIoFinishLocked(queue, request, MUF_IO_STATUS_CANCELED, ECANCELED);
+            _mufIoDispatchLocked(queue);
+            withdrawn = MUF_TRUE;
+        }
+#if defined(MUF_IO_HAS_IO_URING)
+        else if (request->state == _MUF_IO_STATE_DISPATCHED && queue->backend == MUF_IO_BACKEND_IO_URING) {
+            request->cancelRequested = MUF_TRUE;
+            if (_mufIoUringPrepCancel(&queue->ring, (muf_u64) (muf_usize) request, 0))
+                _mufIoUringSubmit(&queue->ring, 0);
+        }
+#endif
+    }
+    mufLockRelease(queue->lock);
+    return withdrawn;
+}
+
+muf_usize mufIoQueuePoll(MufIoQueue *queue, muf_usize maxCompletions) {
+    muf_usize invoked = 0;
+    mufLockAcquire(queue->lock);
+#if defined(MUF_IO_HAS_IO_URING)
+    if (queue->backend == MUF_IO_BACKEND_IO_URING) {
+        _mufIoUringReapLocked(queue);
+        _mufIoDispatchLocked(queue);
+    }
+#endif
+    while (maxCompletions == 0 || invoked < maxCompletions) {
+        _MufIoRequest *request = _mufIoListPop(&queue->done);
+        if (request == NULL)
+            break;
+
+        MufIoResult result;
+        result.id = request->id;
+        result.status = request->status;
+        result.bytesRead = request->bytesRead;
+        result.error = request->error;
+        result.dst = request->info.dst;
+        result.userData = request->info.userData;
+        MufIoCallback callback = request->info.callback;
+        _mufIoFreeRequestLocked(queue, request);
+        --queue->outstanding;
+        mufLockRelease(queue->lock);
+
+        if (callback != NULL)
+            callback(&result);
+        ++invoked;
+
+        mufLockAcquire(queue->lock);
+    }
+    if (queue->outstanding == 0)
+        mufCondVarBroadcast(queue->progress);
+    mufLockRelease(queue->lock);
+    return invoked;
+}
+
+void mufIoQueueDrain(MufIoQueue *queue) {
+    for (;;) {
+        mufIoQueuePoll(queue, 0);
+
+        mufLockAcquire(queue->lock);
+        if (queue->outstanding == 0) {
+            mufLockRelease(queue->lock);
+            return;
+        }
+#if defined(MUF_IO_HAS_IO_URING)
+        if (queue->backend == MUF_IO_BACKEND_IO_URING) {
+            if (queue->done.head == NULL && queue->inFlight > 0)
+                _mufIoUringSubmit(&queue->ring, 1);
+            mufLockRelease(queue->lock);
+            continue;
+        }
+#endif
+        while (queue->done.head == NULL && queue->outstanding > 0)
+            mufCondVarWait(queue->progress, queue->lock);
+        mufLockRelease(queue->lock);
+    }
+}
+
+muf_usize mufIoQueueGetPendingCount(MufIoQueue *queue) {
+    mufLockAcquire(queue->lock);
+    muf_usize count = queue->outstanding;
+    mufLockRelease(queue->lock);
+    return count;
+}
+
+static MufIoQueue *_mufDefaultIoQueue = NULL;
+static MufSpinLock _mufDefaultIoQueueLock = MUF_SPIN_LOCK_INIT;
+
+MufIoQueue *mufGetDefaultIoQueue(void) {
+    MufIoQueue *queue = mufAtomicLoad(&_mufDefaultIoQueue);
+    if (queue != NULL)
+        return queue;
+
+    mufSpinLockAcquire(&_mufDefaultIoQueueLock);
+    queue = _mufDefaultIoQueue;
+    if (queue == NULL) {
+        queue = mufCreateIoQueue(NULL);
+        mufAtomicStore(&_mufDefaultIoQueue, queue);
+    }
+    mufSpinLockRelease(&_mufDefaultIoQueueLock);
+    return queue;
+}
+
+MufIoRequestId mufIoSubmitRead(MufFile *file, muf_offset offset, muf_usize size, muf_rawptr dst, MufIoCallback callback) {
+    MufIoReadRequest request;
+    request.file = file;
+    request.offset = offset;
+    request.size = size;
+    request.dst = dst;
+    request.priority = MUF_IO_PRIORITY_NORMAL;
+    request.callback = callback;
+    request.userData = NULL;
+    return mufIoQueueSubmitRead(mufGetDefaultIoQueue(), &request);
+}
+
+muf_bool mufIoCancel(MufIoRequestId id) {
+    return mufIoQueueCancel(mufGetDefaultIoQueue(), id);
+}
+
+muf_usize mufIoPoll(muf_usize maxCompletions) {
+    return mufIoQueuePoll(mufGetDefaultIoQueue(), maxCompletions);
+}
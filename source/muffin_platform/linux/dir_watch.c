@@ -0,0 +1,309 @@
+#include "../internal/dir_watch.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "muffin_core/memory.h"
+#include "muffin_core/string.h"
+
+#define MUF_DIR_WATCH_MASK (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_CREATE | IN_DELETE \
+    | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR)
+
+typedef struct _MufDirWatchRecord_s {
+    muf_i32     wd;
+    muf_u32     tag;
+    muf_char    *relative;
+} _MufDirWatchRecord;
+
+typedef struct _MufDirWatchTree_s {
+    muf_u32     tag;
+    muf_char    *root;
+} _MufDirWatchTree;
+
+struct _MufDirWatch_s {
+    muf_i32             fd;
+    muf_i32             wakeFd;
+    _MufDirWatchRecord  *records;
+    muf_usize           recordCount;
+    muf_usize           recordCapacity;
+    _MufDirWatchTree    *trees;
+    muf_usize           treeCount;
+    muf_usize           treeCapacity;
+};
+
+/* Return false if the joined path does not fit */
+MUF_INTERNAL muf_bool _mufDirWatchJoin(muf_char *out, muf_usize capacity, const muf_char *lhs, const muf_char *rhs) {
+    int length;
+    if (lhs[0] == '\0')
+        length = snprintf(out, capacity, "%s", rhs);
+    else if (rhs[0] == '\0')
+        length = snprintf(out, capacity, "%s", lhs);
+    else
+        length = snprintf(out, capacity, "%s/%s", lhs, rhs);
+    return length >= 0 && (muf_usize) length < capacity;
+}
+
+MUF_INTERNAL const _MufDirWatchTree *_mufDirWatchFindTree(const _MufDirWatch *watch, muf_u32 tag) {
+    for (muf_usize i = 0; i < watch->treeCount; ++i) {
+        if (watch->trees[i].tag == tag)
+            return &watch->trees[i];
+    }
+    return NULL;
+}
+
+MUF_INTERNAL muf_bool _mufDirWatchWdInUse(const _MufDirWatch *watch, muf_i32 wd) {
+    for (muf_usize i = 0; i < watch->recordCount; ++i) {
+        if (watch->records[i].wd == wd)
+            return MUF_TRUE;
+    }
+    return MUF_FALSE;
+}
+
+MUF_INTERNAL void _mufDirWatchRemoveRecordAt(_MufDirWatch *watch, muf_usize index) {
+    mufFree(watch->records[index].relative);
+    watch->records[index] = watch->records[--watch->recordCount];
+}
+
+MUF_INTERNAL muf_bool _mufDirWatchAddRecord(_MufDirWatch *watch, const muf_char *root, const muf_char *relative, muf_u32 tag) {
+    muf_char path[PATH_MAX];
+    if (!_mufDirWatchJoin(path, sizeof(path), root, relative))
+        return MUF_FALSE;
+
+    /* The kernel hands out one descriptor per directory, a directory in two trees gets one record per tree */
+    muf_i32 wd = inotify_add_watch(watch->fd, path, MUF_DIR_WATCH_MASK);
+    if (wd < 0)
+        return MUF_FALSE;
+
+    for (muf_usize i = 0; i < watch->recordCount; ++i) {
+        if (watch->records[i].wd == wd && watch->records[i].tag == tag)
+            return MUF_TRUE;
+    }
+    if (watch->recordCount == watch->recordCapacity) {
+        watch->recordCapacity = watch->recordCapacity == 0 ? 64 : watch->recordCapacity * 2;
+        watch->records = mufRealloc(_MufDirWatchRecord, watch->records, watch->recordCapacity);
+    }
+    _MufDirWatchRecord *record = &watch->records[watch->recordCount++];
+    record->wd = wd;
+    record->tag = tag;
+    record->relative = mufCStrClone(relative);
+    return MUF_TRUE;
+}
+
+/**
+ * Watch `relative` and its subdirectories. When `callback` is set the files found are reported as created,
+ * this covers the window between a directory being created and its watch being installed.
+ */
+MUF_INTERNAL muf_usize _mufDirWatchAddSubtree(_MufDirWatch *watch, const muf_char *root, const muf_char *relative, muf_u32 tag,
+    _MufDirWatchCallback callback, muf_rawptr userData) {
+    muf_usize reported = 0;
+    if (!_mufDirWatchAddRecord(watch, root, relative, tag))
+        return 0;
+
+    muf_char path[PATH_MAX];
+    if (!_mufDirWatchJoin(path, sizeof(path), root, relative))
+        return 0;
+    DIR *dir = opendir(path);
+    if (dir == NULL)
+        return 0;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+            continue;
+
+        muf_char child[PATH_MAX];
+        muf_char childPath[PATH_MAX];
+        struct stat st;
+        if (!_mufDirWatchJoin(child, sizeof(child), relative, entry->d_name)
+            || !_mufDirWatchJoin(childPath, sizeof(childPath), root, child)
+            || stat(childPath, &st) != 0)
+            continue;
+
+        if (S_ISDIR(st.st_mode)) {
+            reported += _mufDirWatchAddSubtree(watch, root, child, tag, callback, userData);
+        } else if (callback != NULL) {
+            callback(userData, tag, child, _MUF_DIR_WATCH_EVENT_CREATED);
+            ++reported;
+        }
+    }
+    closedir(dir);
+    return reported;
+}
+
+_MufDirWatch *_mufCreateDirWatch(void) {
+    muf_i32 fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+        return NULL;
+    muf_i32 wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd < 0) {
+        close(fd);
+        return NULL;
+    }
+
+    _MufDirWatch *watch = mufAllocZero(_MufDirWatch, 1);
+    watch->fd = fd;
+    watch->wakeFd = wakeFd;
+    return watch;
+}
+
+void _mufDestroyDirWatch(_MufDirWatch *watch) {
+    if (watch == NULL)
+        return;
+    for (muf_usize i = 0; i < watch->recordCount; ++i)
+        mufFree(watch->records[i].relative);
+    for (muf_usize i = 0; i < watch->treeCount; ++i)
+        mufFree(watch->trees[i].root);
+    mufSafeFree(watch->records);
+    mufSafeFree(watch->trees);
+    close(watch->wakeFd);
+    close(watch->fd);
+    mufFree(watch);
+}
+
+muf_bool _mufDirWatchAddTree(_MufDirWatch *watch, const muf_char *directory, muf_u32 tag) {
+    if (_mufDirWatchFindTree(watch, tag) != NULL)
+        return MUF_FALSE;
+
+    muf_usize recordCount = watch->recordCount;
+    _mufDirWatchAddSubtree(watch, directory, "", tag, NULL, NULL);
+    if (watch->recordCount == recordCount)
+        return MUF_FALSE;
+
+    if (watch->treeCount == watch->treeCapacity) {
+        watch->treeCapacity = watch->treeCapacity == 0 ? 8 : watch->treeCapacity * 2;
+        watch->trees = mufRealloc(_MufDirWatchTree, watch->trees, watch->treeCapacity);
+    }
+    watch->trees[watch->treeCount].tag = tag;
+    watch->trees[watch->treeCount].root = mufCStrClone(directory);
+    ++watch->treeCount;
+    return MUF_TRUE;
+}
+
+void _mufDirWatchRemoveTree(_MufDirWatch *watch, muf_u32 tag) {
+    for (muf_usize i = watch->recordCount; i > 0; --i) {
+        if (watch->records[i - 1].tag != tag)
+            continue;
+        muf_i32 wd = watch->records[i - 1].wd;
+        _mufDirWatchRemoveRecordAt(watch, i - 1);
+        if (!_mufDirWatchWdInUse(watch, wd))
+            inotify_rm_watch(watch->fd, wd);
+    }
+    for (muf_usize i = 0; i < watch->treeCount; ++i) {
+        if (watch->trees[i].tag == tag) {
+            mufFree(watch->trees[i].root);
+            watch->trees[i] = watch->trees[--watch->treeCount];
+            break;
+        }
+    }
+}
+
+MUF_INTERNAL muf_u32 _mufDirWatchTranslate(muf_u32 mask) {
+    muf_u32 events = 0;
+    if (mask & (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB))
+        events |= _MUF_DIR_WATCH_EVENT_MODIFIED;
+    if (mask & (IN_CREATE | IN_MOVED_TO))
+        events |= _MUF_DIR_WATCH_EVENT_CREATED;
+    if (mask & (IN_DELETE | IN_MOVED_FROM | IN_DELETE_SELF))
+        events |= _MUF_DIR_WATCH_EVENT_REMOVED;
+    if (mask & IN_ISDIR)
+        events |= _MUF_DIR_WATCH_EVENT_DIRECTORY;
+    return events;
+}
+
+MUF_INTERNAL muf_usize _mufDirWatchDispatch(_MufDirWatch *watch, const struct inotify_event *event,
+    _MufDirWatchCallback callback, muf_rawptr userData) {
+    muf_usize delivered = 0;
+
+    if (event->mask & IN_Q_OVERFLOW) {
+        for (muf_usize i = 0; i < watch->treeCount; ++i)
+            callback(userData, watch->trees[i].tag, "", _MUF_DIR_WATCH_EVENT_OVERFLOW);
+        return watch->treeCount;
+    }
+    if (event->mask & IN_IGNORED) {
+        for (muf_usize i = watch->recordCount; i > 0; --i) {
+            if (watch->records[i - 1].wd == event->wd)
+                _mufDirWatchRemoveRecordAt(watch, i - 1);
+        }
+        return 0;
+    }
+
+    muf_u32 events = _mufDirWatchTranslate(event->mask);
+    for (muf_usize i = 0; i < watch->recordCount; ++i) {
+        const _MufDirWatchRecord *record = &watch->records[i];
+        if (record->wd != event->wd)
+            continue;
+        /* A subdirectory deleting itself is also reported by its parent, only a vanished root is forwarded */
+        if ((event->mask & IN_DELETE_SELF) && record->relative[0] != '\0')
+            continue;
+
+        muf_char relative[PATH_MAX];
+        muf_u32 tag = record->tag;
+        /* A path that does not fit cannot be named, the tree is reported as if events were dropped */
+        if (!_mufDirWatchJoin(relative, sizeof(relative), record->relative, event->len > 0 ? event->name : "")) {
+            callback(userData, tag, "", _MUF_DIR_WATCH_EVENT_OVERFLOW);
+            ++delivered;
+            continue;
+        }
+        callback(userData, tag, relative, events);
+        ++delivered;
+
+        if ((events & _MUF_DIR_WATCH_EVENT_DIRECTORY) && (events & _MUF_DIR_WATCH_EVENT_CREATED)) {
+            const _MufDirWatchTree *tree = _mufDirWatchFindTree(watch, tag);
+            /* Adding records may move the array, the loop continues by index */
+            if (tree != NULL)
+                delivered += _mufDirWatchAddSubtree(watch, tree->root, relative, tag, callback, userData);
+        }
+    }
+    return delivered;
+}
+
+muf_usize _mufDirWatchRead(_MufDirWatch *watch, muf_i32 timeoutMs, _MufDirWatchCallback callback, muf_rawptr userData) {
+    struct pollfd fds[2];
+    fds[0].fd = watch->fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = watch->wakeFd;
+    fds[1].events = POLLIN;
+
+    muf_i32 ready;
+    do {
+        ready = poll(fds, 2, timeoutMs);
+    } while (ready < 0 && errno == EINTR);
+    if (ready <= 0)
+        return 0;
+
+    if (fds[1].revents & POLLIN) {
+        muf_u64 value;
+        ssize_t ignored = read(watch->wakeFd, &value, sizeof(value));
+        (void) ignored;
+    }
+
+    muf_usize delivered = 0;
+    muf_byte buffer[16 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+    for (;;) {
+        ssize_t size = read(watch->fd, buffer, sizeof(buffer));
+        if (size < 0 && errno == EINTR)
+            continue;
+        if (size <= 0)
+            break;
+        for (muf_byte *p = buffer; p < buffer + size; ) {
+            const struct inotify_event *event = (const struct inotify_event *) p;
+            delivered += _mufDirWatchDispatch(watch, event, callback, userData);
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    return delivered;
+}
+
+void _mufDirWatchWake(_MufDirWatch *watch) {
+    muf_u64 value = 1;
+    ssize_t ignored = write(watch->wakeFd, &value, sizeof(value));
+    (void) ignored;
+}
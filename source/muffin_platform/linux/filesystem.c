@@ -0,0 +1,298 @@
+#include "muffin_platform/filesystem.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "muffin_core/memory.h"
+#include "muffin_core/string.h"
+
+#define MUF_FILE_HUGE_PAGE_SIZE (2ULL * 1024ULL * 1024ULL)
+
+#define _FD(_file) ((_file)->handle._i32)
+
+MUF_INTERNAL muf_i32 _mufFileOpenFlags(MufFileOpenMode openMode) {
+    switch (openMode) {
+        case MUF_FILE_OPEN_READ:   return O_RDONLY;
+        case MUF_FILE_OPEN_WRITE:  return O_RDWR | O_CREAT;
+        case MUF_FILE_OPEN_APPEND: return O_WRONLY | O_CREAT | O_APPEND;
+        case MUF_FILE_OPEN_TRUNC:  return O_WRONLY | O_CREAT | O_TRUNC;
+    }
+    return O_RDONLY;
+}
+
+MufFile *mufCreateFile(const muf_char *path, MufFileOpenMode openMode) {
+    MufFile *file = mufAlloc(MufFile, 1);
+    file->handle = mufNullHandle(MufHandle);
+    _FD(file) = -1;
+    file->path = NULL;
+    mufFileOpen(file, path, openMode);
+    return file;
+}
+
+void mufDestroyFile(MufFile *file) {
+    mufFileClose(file);
+    mufSafeFree(file->path);
+    mufFree(file);
+}
+
+muf_bool mufFileIsOpened(const MufFile *file) {
+    return _FD(file) >= 0;
+}
+
+muf_index mufFileTell(MufFile *file) {
+    off_t position = lseek(_FD(file), 0, SEEK_CUR);
+    return position < 0 ? 0 : (muf_index) position;
+}
+
+muf_usize mufFileGetSize(MufFile *file) {
+    struct stat st;
+    if (fstat(_FD(file), &st) != 0)
+        return 0;
+    return (muf_usize) st.st_size;
+}
+
+const muf_char *mufFileGetPath(const MufFile *file) {
+    return file->path;
+}
+
+void mufFileOpen(MufFile *file, const muf_char *path, MufFileOpenMode openMode) {
+    mufFileClose(file);
+    file->openMode = openMode;
+    if (file->path != path) {
+        mufSafeFree(file->path);
+        file->path = mufCStrClone(path);
+    }
+
+    muf_i32 fd;
+    do {
+        fd = open(path, _mufFileOpenFlags(openMode) | O_CLOEXEC, 0644);
+    } while (fd < 0 && errno == EINTR);
+    _FD(file) = fd;
+}
+
+void mufFileClose(MufFile *file) {
+    if (_FD(file) >= 0) {
+        close(_FD(file));
+        _FD(file) = -1;
+    }
+}
+
+void mufFileSeek(MufFile *file, muf_offset offset, MufFileSeekMode seekMode) {
+    const muf_i32 seekModes[] = { SEEK_SET, SEEK_END, SEEK_CUR };
+    lseek(_FD(file), (off_t) offset, seekModes[(muf_index) seekMode]);
+}
+
+muf_usize mufFileRead(MufFile *file, muf_usize size, muf_rawptr dataOut) {
+    muf_usize readSize = 0;
+    while (readSize < size) {
+        ssize_t result = read(_FD(file), (muf_byte *) dataOut + readSize, size - readSize);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0)
+            break;
+        readSize += (muf_usize) result;
+    }
+    return readSize;
+}
+
+muf_usize mufFileWrite(MufFile *file, const muf_rawptr data, muf_usize size) {
+    muf_usize writeSize = 0;
+    while (writeSize < size) {
+        ssize_t result = write(_FD(file), (const muf_byte *) data + writeSize, size - writeSize);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0)
+            break;
+        writeSize += (muf_usize) result;
+    }
+    return writeSize;
+}
+
+muf_usize mufFileTruncate(MufFile *file, muf_usize size) {
+    if (ftruncate(_FD(file), (off_t) size) != 0)
+        return mufFileGetSize(file);
+    return size;
+}
+
+void mufFileFlush(MufFile *file) {
+    fsync(_FD(file));
+}
+
+MUF_INTERNAL void _mufFileMadvise(muf_rawptr address, muf_usize size, muf_u32 flags) {
+    if (size == 0)
+        return;
+    if (flags & MUF_FILE_MAP_FLAG_SEQUENTIAL)
+        madvise(address, size, MADV_SEQUENTIAL);
+    if (flags & MUF_FILE_MAP_FLAG_RANDOM)
+        madvise(address, size, MADV_RANDOM);
+    if (flags & MUF_FILE_MAP_FLAG_WILL_NEED)
+        madvise(address, size, MADV_WILLNEED);
+    if (flags & MUF_FILE_MAP_FLAG_DONT_NEED)
+        madvise(address, size, MADV_DONTNEED);
+#if defined(MADV_HUGEPAGE)
+    if (flags & MUF_FILE_MAP_FLAG_HUGE_PAGES)
+        madvise(address, size, MADV_HUGEPAGE);
+#endif
+}
+
+/**
+ * Reserve an address range whose start is congruent with the file offset modulo the huge page size,
+ * the kernel can only back a file mapping with PMD entries when both are aligned.
+ */
+MUF_INTERNAL muf_rawptr _mufFileReserveHugeAligned(muf_usize mappedSize, muf_usize fileOffset) {
+    muf_usize reserveSize = mappedSize + 2 * MUF_FILE_HUGE_PAGE_SIZE;
+    muf_byte *reserve = (muf_byte *) mmap(NULL, reserveSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (reserve == MAP_FAILED)
+        return NULL;
+
+    muf_usize begin = ((muf_usize) reserve + MUF_FILE_HUGE_PAGE_SIZE - 1) & ~(muf_usize) (MUF_FILE_HUGE_PAGE_SIZE - 1);
+    begin += fileOffset & (MUF_FILE_HUGE_PAGE_SIZE - 1);
+    muf_usize end = begin + mappedSize;
+
+    if (begin > (muf_usize) reserve)
+        munmap(reserve, begin - (muf_usize) reserve);
+    if ((muf_usize) reserve + reserveSize > end)
+        munmap((muf_rawptr) end, (muf_usize) reserve + reserveSize - end);
+    return (muf_rawptr) begin;
+}
+
+muf_bool mufFileMap(MufFile *file, muf_offset offset, muf_usize size, MufFileMapMode mode, muf_u32 flags, MufFileView *viewOut) {
+    mufMemFill(viewOut, 0, sizeof(MufFileView));
+    if (!mufFileIsOpened(file) || offset < 0)
+        return MUF_FALSE;
+
+    muf_usize fileSize = mufFileGetSize(file);
+    if ((muf_usize) offset >= fileSize)
+        return MUF_FALSE;
+    if (size == 0 || size > fileSize - (muf_usize) offset)
+        size = fileSize - (muf_usize) offset;
+
+    muf_usize pageSize = (muf_usize) sysconf(_SC_PAGESIZE);
+    muf_usize alignedOffset = (muf_usize) offset & ~(pageSize - 1);
+    muf_usize mappedSize = size + ((muf_usize) offset - alignedOffset);
+
+    muf_i32 prot = PROT_READ;
+    muf_i32 mapFlags = MAP_SHARED;
+    if (mode == MUF_FILE_MAP_COPY_ON_WRITE) {
+        prot |= PROT_WRITE;
+        mapFlags = MAP_PRIVATE;
+    }
+#if defined(MAP_POPULATE)
+    if ((flags & MUF_FILE_MAP_FLAG_POPULATE) && mode == MUF_FILE_MAP_READ_ONLY)
+        mapFlags |= MAP_POPULATE;
+#endif
+    if ((flags & MUF_FILE_MAP_FLAG_POPULATE) && mode == MUF_FILE_MAP_COPY_ON_WRITE)
+        flags |= MUF_FILE_MAP_FLAG_WILL_NEED;
+
+    muf_rawptr hint = NULL;
+    if ((flags & MUF_FILE_MAP_FLAG_HUGE_PAGES) && mappedSize >= MUF_FILE_HUGE_PAGE_SIZE) {
+        hint = _mufFileReserveHugeAligned(mappedSize, alignedOffset);
+        if (hint != NULL)
+            mapFlags |= MAP_FIXED;
+    }
+
+    muf_rawptr base = mmap(hint, mappedSize, prot, mapFlags, _FD(file), (off_t) alignedOffset);
+    if (base == MAP_FAILED) {
+        if (hint != NULL)
+            munmap(hint, mappedSize);
+        return MUF_FALSE;
+    }
+
+    _mufFileMadvise(base, mappedSize, flags & ~(muf_u32) MUF_FILE_MAP_FLAG_DONT_NEED);
+
+    viewOut->_base = base;
+    viewOut->_mappedSize = mappedSize;
+    viewOut->data = (muf_byte *) base + ((muf_usize) offset - alignedOffset);
+    viewOut->size = size;
+    return MUF_TRUE;
+}
+
+void mufFileUnmap(MufFileView *view) {
+    if (view->_base != NULL)
+        munmap(view->_base, view->_mappedSize);
+    mufMemFill(view, 0, sizeof(MufFileView));
+}
+
+void mufFileViewAdvise(const MufFileView *view, muf_offset offset, muf_usize size, muf_u32 flags) {
+    if (view->_base == NULL || offset < 0 || (muf_usize) offset >= view->size)
+        return;
+    if (size == 0 || size > view->size - (muf_usize) offset)
+        size = view->size - (muf_usize) offset;
+
+    muf_usize pageSize = (muf_usize) sysconf(_SC_PAGESIZE);
+    muf_usize first = (muf_usize) view->data + (muf_usize) offset;
+    muf_usize last = first + size;
+    first &= ~(pageSize - 1);
+    _mufFileMadvise((muf_rawptr) first, last - first, flags);
+}
+
+muf_bool mufExistsFile(const muf_char *filePath) {
+    return access(filePath, F_OK) == 0;
+}
+
+void mufNewFile(const muf_char *filePath) {
+    muf_i32 fd = open(filePath, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd >= 0)
+        close(fd);
+}
+
+void mufNewDirectory(const muf_char *directoryPath) {
+    mkdir(directoryPath, 0755);
+}
+
+void mufCopyFile(const muf_char *oldPath, const muf_char *newPath) {
+    muf_i32 src = open(oldPath, O_RDONLY | O_CLOEXEC);
+    if (src < 0)
+        return;
+    muf_i32 dst = open(newPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (dst < 0) {
+        close(src);
+        return;
+    }
+
+    muf_byte buffer[64 * 1024];
+    ssize_t readSize;
+    while ((readSize = read(src, buffer, sizeof(buffer))) != 0) {
+        if (readSize < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        ssize_t written = 0;
+        while (written < readSize) {
+            ssize_t result = write(dst, buffer + written, (size_t) (readSize - written));
+            if (result < 0 && errno == EINTR)
+                continue;
+            if (result <= 0)
+                break;
+            written += result;
+        }
+        if (written < readSize)
+            break;
+    }
+    close(dst);
+    close(src);
+}
+
+void mufMoveFile(const muf_char *oldPath, const muf_char *newPath) {
+    rename(oldPath, newPath);
+}
+
+void mufMoveDirectory(const muf_char *oldPath, const muf_char *newPath) {
+    rename(oldPath, newPath);
+}
+
+void mufRemoveFile(const muf_char *filePath) {
+    unlink(filePath);
+}
+
+void mufRemoveDirectory(const muf_char *directoryPath) {
+    rmdir(directoryPath);
+}
+
+#undef _FD
@@ -0,0 +1,165 @@
+#include "../internal/io_uring.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+
+#include "muffin_core/sync.h"
+
+MUF_INTERNAL muf_i32 _mufIoUringSetup(muf_u32 entries, struct io_uring_params *params) {
+    return (muf_i32) syscall(__NR_io_uring_setup, entries, params);
+}
+
+MUF_INTERNAL muf_i32 _mufIoUringEnter(muf_i32 fd, muf_u32 toSubmit, muf_u32 minComplete, muf_u32 flags) {
+    return (muf_i32) syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, NULL, 0);
+}
+
+muf_bool _mufIoUringInit(_MufIoUring *ring, muf_u32 entries) {
+    struct io_uring_params params;
+    memset(ring, 0, sizeof(_MufIoUring));
+    memset(&params, 0, sizeof(params));
+    ring->fd = -1;
+
+    muf_i32 fd = _mufIoUringSetup(entries, &params);
+    if (fd < 0)
+        return MUF_FALSE;
+
+    ring->fd = fd;
+    ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(muf_u32);
+    ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cqRingSize > ring->sqRingSize)
+            ring->sqRingSize = ring->cqRingSize;
+        ring->cqRingSize = ring->sqRingSize;
+    }
+
+    ring->sqRing = mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring->sqRing == MAP_FAILED) {
+        ring->sqRing = NULL;
+        _mufIoUringFinish(ring);
+        return MUF_FALSE;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cqRing = ring->sqRing;
+    } else {
+        ring->cqRing = mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (ring->cqRing == MAP_FAILED) {
+            ring->cqRing = NULL;
+            _mufIoUringFinish(ring);
+            return MUF_FALSE;
+        }
+    }
+
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe *) mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        _mufIoUringFinish(ring);
+        return MUF_FALSE;
+    }
+
+    muf_byte *sq = (muf_byte *) ring->sqRing;
+    muf_byte *cq = (muf_byte *) ring->cqRing;
+    ring->sqEntries = params.sq_entries;
+    ring->sqHead = (volatile muf_u32 *) (sq + params.sq_off.head);
+    ring->sqTail = (volatile muf_u32 *) (sq + params.sq_off.tail);
+    ring->sqMask = *(muf_u32 *) (sq + params.sq_off.ring_mask);
+    ring->sqArray = (muf_u32 *) (sq + params.sq_off.array);
+    ring->cqEntries = params.cq_entries;
+    ring->cqHead = (volatile muf_u32 *) (cq + params.cq_off.head);
+    ring->cqTail = (volatile muf_u32 *) (cq + params.cq_off.tail);
+    ring->cqMask = *(muf_u32 *) (cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+    return MUF_TRUE;
+}
+
+void _mufIoUringFinish(_MufIoUring *ring) {
+    if (ring->sqes != NULL)
+        munmap(ring->sqes, ring->sqesSize);
+    if (ring->cqRing != NULL && ring->cqRing != ring->sqRing)
+        munmap(ring->cqRing, ring->cqRingSize);
+    if (ring->sqRing != NULL)
+        munmap(ring->sqRing, ring->sqRingSize);
+    if (ring->fd >= 0)
+        close(ring->fd);
+    memset(ring, 0, sizeof(_MufIoUring));
+    ring->fd = -1;
+}
+
+muf_u32 _mufIoUringGetFreeSlots(const _MufIoUring *ring) {
+    muf_u32 head = mufAtomicLoad(ring->sqHead);
+    muf_u32 tail = *ring->sqTail;
+    return ring->sqEntries - (tail - head);
+}
+
+MUF_INTERNAL struct io_uring_sqe *_mufIoUringGetSqe(_MufIoUring *ring) {
+    if (_mufIoUringGetFreeSlots(ring) == 0)
+        return NULL;
+    muf_u32 tail = *ring->sqTail;
+    muf_u32 index = tail & ring->sqMask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    ring->sqArray[index] = index;
+    return sqe;
+}
+
+MUF_INTERNAL void _mufIoUringCommitSqe(_MufIoUring *ring) {
+    mufAtomicStore(ring->sqTail, *ring->sqTail + 1);
+    ++ring->unsubmitted;
+}
+
+muf_bool _mufIoUringPrepRead(_MufIoUring *ring, muf_i32 fd, muf_rawptr dst, muf_u32 size, muf_u64 offset,
+    muf_u64 userData, muf_u16 ioprio) {
+    struct io_uring_sqe *sqe = _mufIoUringGetSqe(ring);
+    if (sqe == NULL)
+        return MUF_FALSE;
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (muf_u64) (muf_usize) dst;
+    sqe->len = size;
+    sqe->off = offset;
+    sqe->ioprio = ioprio;
+    sqe->user_data = userData;
+    _mufIoUringCommitSqe(ring);
+    return MUF_TRUE;
+}
+
+muf_bool _mufIoUringPrepCancel(_MufIoUring *ring, muf_u64 targetUserData, muf_u64 userData) {
+    struct io_uring_sqe *sqe = _mufIoUringGetSqe(ring);
+    if (sqe == NULL)
+        return MUF_FALSE;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = targetUserData;
+    sqe->user_data = userData;
+    _mufIoUringCommitSqe(ring);
+    return MUF_TRUE;
+}
+
+muf_i32 _mufIoUringSubmit(_MufIoUring *ring, muf_u32 waitCount) {
+    if (ring->unsubmitted == 0 && waitCount == 0)
+        return 0;
+    muf_i32 result;
+    do {
+        result = _mufIoUringEnter(ring->fd, ring->unsubmitted, waitCount, waitCount > 0 ? IORING_ENTER_GETEVENTS : 0);
+    } while (result < 0 && errno == EINTR);
+    if (result < 0)
+        return -errno;
+    ring->unsubmitted -= (muf_u32) result < ring->unsubmitted ? (muf_u32) result : ring->unsubmitted;
+    return result;
+}
+
+muf_bool _mufIoUringPeek(_MufIoUring *ring, muf_u64 *userDataOut, muf_i32 *resultOut) {
+    muf_u32 head = *ring->cqHead;
+    if (head == mufAtomicLoad(ring->cqTail))
+        return MUF_FALSE;
+    const struct io_uring_cqe *cqe = &ring->cqes[head & ring->cqMask];
+    *userDataOut = cqe->user_data;
+    *resultOut = cqe->res;
+    mufAtomicStore(ring->cqHead, head + 1);
+    return MUF_TRUE;
+}
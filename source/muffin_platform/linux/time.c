@@ -0,0 +1,27 @@
+#include "muffin_platform/time.h"
+
+#include <errno.h>
+#include <time.h>
+
+#include "muffin_core/timer.h"
+
+muf_u64 mufPlatformGetTime() {
+    return mufTimerGetNanoseconds();
+}
+
+muf_u64 mufPlatformGetTimeFrequency() {
+    return 1000000000ULL;
+}
+
+void mufPlatformSleep(muf_u32 milliseconds) {
+    struct timespec request;
+    request.tv_sec = milliseconds / 1000;
+    request.tv_nsec = (long) (milliseconds % 1000) * 1000000L;
+    while (nanosleep(&request, &request) != 0 && errno == EINTR);
+}
+
+muf_u64 mufGetTimeStamp() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (muf_u64) ts.tv_sec * 1000ULL + (muf_u64) ts.tv_nsec / 1000000ULL;
+}
\ No newline at end of file
@@ -0,0 +1,509 @@
+#include "muffin_platform/vfs.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "internal/dir_watch.h"
+#include "muffin_core/hash.h"
+#include "muffin_core/memory.h"
+#include "muffin_core/string.h"
+#include "muffin_core/sync.h"
+
+#define MUF_VFS_INITIAL_CACHE_CAPACITY 256
+
+/* An archive outlives its mount while a read still decodes from it, the count is guarded by the vfs lock */
+typedef struct _MufVfsArchive_s {
+    MufArchive          *handle;
+    muf_u32             refCount;
+} _MufVfsArchive;
+
+typedef struct _MufVfsMount_s {
+    MufVfsMountId       id;
+    MufVfsSourceType    type;
+    muf_i32             priority;
+    muf_char            *prefix;
+    muf_usize           prefixLength;
+    muf_char            *directory;
+    _MufVfsArchive      *archive;
+} _MufVfsMount;
+
+/* A cached lookup is valid while its generation matches the one of the vfs, mount 0 caches a miss */
+typedef struct _MufVfsCacheEntry_s {
+    muf_u64                 hash;
+    muf_char                *path;
+    muf_usize               pathLength;
+    muf_u32                 generation;
+    MufVfsMountId           mount;
+    muf_usize               size;
+    const MufArchiveEntry   *entry;
+} _MufVfsCacheEntry;
+
+struct MufVfs_s {
+    MufLock             *lock;
+    _MufVfsMount        *mounts;
+    muf_usize           mountCount;
+    muf_usize           mountCapacity;
+    MufVfsMountId       nextMountId;
+
+    _MufVfsCacheEntry   *cache;
+    muf_usize           cacheCount;
+    muf_usize           cacheCapacity;
+    /* An upper bound of the misses in the cache, recounted on every rebuild */
+    muf_usize           cacheMissCount;
+    muf_u32             generation;
+
+    _MufDirWatch        *watch;
+};
+
+muf_usize mufVfsNormalizePath(const muf_char *path, muf_char *pathOut, muf_usize capacity) {
+    muf_usize length = 0;
+    const muf_char *p = path;
+
+    while (*p != '\0') {
+        while (*p == '/' || *p == '\\')
+            ++p;
+        const muf_char *begin = p;
+        while (*p != '\0' && *p != '/' && *p != '\\')
+            ++p;
+        muf_usize componentLength = (muf_usize) (p - begin);
+
+        if (componentLength == 0 || (componentLength == 1 && begin[0] == '.'))
+            continue;
+        if (componentLength == 2 && begin[0] == '.' && begin[1] == '.') {
+            while (length > 0 && pathOut[length - 1] != '/')
+                --length;
+            if (length > 0)
+                --length;
+            continue;
+        }
+
+        muf_usize required = length + (length > 0 ? 1 : 0) + componentLength;
+        if (required + 1 > capacity)
+            return 0;
+        if (length > 0)
+            pathOut[length++] = '/';
+        mufMemCopyBytes(pathOut + length, begin, componentLength);
+        length += componentLength;
+    }
+
+    if (capacity == 0)
+        return 0;
+    pathOut[length] = '\0';
+    return length;
+}
+
+MUF_INTERNAL void _mufVfsInvalidateAllLocked(MufVfs *vfs) {
+    /* Generation 0 marks a single invalidated entry, skip it on wrap around */
+    if (++vfs->generation == 0)
+        vfs->generation = 1;
+}
+
+MUF_INTERNAL _MufVfsCacheEntry *_mufVfsCacheFind(MufVfs *vfs, const muf_char *path, muf_usize length, muf_u64 hash) {
+    muf_usize mask = vfs->cacheCapacity - 1;
+    for (muf_usize slot = (muf_usize) hash & mask; ; slot = (slot + 1) & mask) {
+        _MufVfsCacheEntry *entry = &vfs->cache[slot];
+        if (entry->path == NULL)
+            return entry;
+        if (entry->hash == hash && entry->pathLength == length && memcmp(entry->path, path, length) == 0)
+            return entry;
+    }
+}
+
+MUF_INTERNAL void _mufVfsCacheRebuild(MufVfs *vfs, muf_usize capacity, muf_bool keepMisses) {
+    _MufVfsCacheEntry *oldCache = vfs->cache;
+    muf_usize oldCapacity = vfs->cacheCapacity;
+
+    vfs->cacheCapacity = capacity;
+    vfs->cache = mufAllocZero(_MufVfsCacheEntry, vfs->cacheCapacity);
+    vfs->cacheCount = 0;
+    vfs->cacheMissCount = 0;
+    for (muf_usize i = 0; i < oldCapacity; ++i) {
+        _MufVfsCacheEntry *entry = &oldCache[i];
+        if (entry->path == NULL)
+            continue;
+        /* Stale lookups are not worth a slot */
+        if (entry->generation != vfs->generation || (entry->mount == 0 && !keepMisses)) {
+            mufFree(entry->path);
+            continue;
+        }
+        *_mufVfsCacheFind(vfs, entry->path, entry->pathLength, entry->hash) = *entry;
+        ++vfs->cacheCount;
+        if (entry->mount == 0)
+            ++vfs->cacheMissCount;
+    }
+    mufFree(oldCache);
+}
+
+MUF_INTERNAL muf_bool _mufVfsMountMatches(const _MufVfsMount *mount, const muf_char *path, muf_usize length, const muf_char **relativeOut) {
+    if (mount->prefixLength == 0) {
+        *relativeOut = path;
+        return MUF_TRUE;
+    }
+    if (length < mount->prefixLength || memcmp(path, mount->prefix, mount->prefixLength) != 0)
+        return MUF_FALSE;
+    if (length == mount->prefixLength) {
+        *relativeOut = path + length;
+        return MUF_TRUE;
+    }
+    if (path[mount->prefixLength] != '/')
+        return MUF_FALSE;
+    *relativeOut = path + mount->prefixLength + 1;
+    return MUF_TRUE;
+}
+
+MUF_INTERNAL const _MufVfsMount *_mufVfsFindMount(const MufVfs *vfs, MufVfsMountId id) {
+    for (muf_usize i = 0; i < vfs->mountCount; ++i) {
+        if (vfs->mounts[i].id == id)
+            return &vfs->mounts[i];
+    }
+    return NULL;
+}
+
+MUF_INTERNAL muf_bool _mufVfsNativePath(const _MufVfsMount *mount, const muf_char *relative, muf_char *out, muf_usize capacity) {
+    int length;
+    if (relative[0] == '\0')
+        length = snprintf(out, capacity, "%s", mount->directory);
+    else
+        length = snprintf(out, capacity, "%s/%s", mount->directory, relative);
+    return length >= 0 && (muf_usize) length < capacity;
+}
+
+/* Probe the mounts in overlay order, this is the only place that touches the disk */
+MUF_INTERNAL void _mufVfsLookupUncached(const MufVfs *vfs, const muf_char *path, muf_usize length, _MufVfsCacheEntry *result) {
+    result->mount = 0;
+    result->size = 0;
+    result->entry = NULL;
+
+    for (muf_usize i = 0; i < vfs->mountCount; ++i) {
+        const _MufVfsMount *mount = &vfs->mounts[i];
+        const muf_char *relative;
+        if (!_mufVfsMountMatches(mount, path, length, &relative) || relative[0] == '\0')
+            continue;
+
+        if (mount->type == MUF_VFS_SOURCE_ARCHIVE) {
+            const MufArchiveEntry *entry = mufArchiveFind(mount->archive->handle, relative);
+            if (entry != NULL) {
+                result->mount = mount->id;
+                result->size = (muf_usize) entry->size;
+                result->entry = entry;
+                return;
+            }
+        } else {
+            muf_char nativePath[MUF_VFS_MAX_PATH];
+            struct stat st;
+            /* A path too long for the native buffer cannot be opened, it is looked up in the next mount */
+            if (_mufVfsNativePath(mount, relative, nativePath, sizeof(nativePath))
+                && stat(nativePath, &st) == 0 && (st.st_mode & S_IFMT) == S_IFREG) {
+                result->mount = mount->id;
+                result->size = (muf_usize) st.st_size;
+                return;
+            }
+        }
+    }
+}
+
+MUF_INTERNAL const _MufVfsCacheEntry *_mufVfsLookupLocked(MufVfs *vfs, const muf_char *path, muf_usize length) {
+    muf_u64 hash = mufHashBytes64(path, length, 0);
+    _MufVfsCacheEntry *entry = _mufVfsCacheFind(vfs, path, length, hash);
+    if (entry->path != NULL && entry->generation == vfs->generation)
+        return entry;
+
+    /* Probing for many missing paths must not grow the cache without bound */
+    if (vfs->cacheMissCount >= MUF_VFS_MAX_CACHED_MISSES) {
+        _mufVfsCacheRebuild(vfs, vfs->cacheCapacity, MUF_FALSE);
+        entry = _mufVfsCacheFind(vfs, path, length, hash);
+    }
+    if (entry->path == NULL) {
+        if ((vfs->cacheCount + 1) * 2 > vfs->cacheCapacity) {
+            _mufVfsCacheRebuild(vfs, vfs->cacheCapacity * 2, MUF_TRUE);
+            entry = _mufVfsCacheFind(vfs, path, length, hash);
+        }
+        entry->hash = hash;
+        entry->path = mufCStrClone(path);
+        entry->pathLength = length;
+        ++vfs->cacheCount;
+    }
+    _mufVfsLookupUncached(vfs, path, length, entry);
+    entry->generation = vfs->generation;
+    if (entry->mount == 0)
+        ++vfs->cacheMissCount;
+    return entry;
+}
+
+MUF_INTERNAL void _mufVfsInvalidatePathLocked(MufVfs *vfs, const muf_char *path, muf_usize length) {
+    _MufVfsCacheEntry *entry = _mufVfsCacheFind(vfs, path, length, mufHashBytes64(path, length, 0));
+    if (entry->path != NULL)
+        entry->generation = 0;
+}
+
+MUF_INTERNAL void _mufVfsOnChange(muf_rawptr userData, muf_u32 tag, const muf_char *relativePath, muf_u32 events) {
+    MufVfs *vfs = (MufVfs *) userData;
+    const _MufVfsMount *mount = _mufVfsFindMount(vfs, (MufVfsMountId) tag);
+    if (mount == NULL)
+        return;
+
+    /* A directory change or a dropped event can affect any path below it */
+    if ((events & (_MUF_DIR_WATCH_EVENT_DIRECTORY | _MUF_DIR_WATCH_EVENT_OVERFLOW)) || relativePath[0] == '\0') {
+        _mufVfsInvalidateAllLocked(vfs);
+        return;
+    }
+
+    muf_char joined[MUF_VFS_MAX_PATH];
+    muf_char virtualPath[MUF_VFS_MAX_PATH];
+    int joinedLength = snprintf(joined, sizeof(joined), "%s/%s", mount->prefix, relativePath);
+    /* The path cannot have been looked up if it does not fit */
+    if (joinedLength < 0 || (muf_usize) joinedLength >= sizeof(joined))
+        return;
+    muf_usize length = mufVfsNormalizePath(joined, virtualPath, sizeof(virtualPath));
+    if (length > 0)
+        _mufVfsInvalidatePathLocked(vfs, virtualPath, length);
+}
+
+MufVfs *mufCreateVfs(void) {
+    MufVfs *vfs = mufAllocZero(MufVfs, 1);
+    vfs->lock = mufCreateLock();
+    vfs->nextMountId = 1;
+    vfs->generation = 1;
+    vfs->cacheCapacity = MUF_VFS_INITIAL_CACHE_CAPACITY;
+    vfs->cache = mufAllocZero(_MufVfsCacheEntry, vfs->cacheCapacity);
+    vfs->watch = _mufCreateDirWatch();
+    return vfs;
+}
+
+void mufDestroyVfs(MufVfs *vfs) {
+    if (vfs == NULL)
+        return;
+    for (muf_usize i = 0; i < vfs->mountCount; ++i) {
+        mufFree(vfs->mounts[i].prefix);
+        mufSafeFree(vfs->mounts[i].directory);
+        if (vfs->mounts[i].archive != NULL) {
+            mufDestroyArchive(vfs->mounts[i].archive->handle);
+            mufFree(vfs->mounts[i].archive);
+        }
+    }
+    for (muf_usize i = 0; i < vfs->cacheCapacity; ++i)
+        mufSafeFree(vfs->cache[i].path);
+    _mufDestroyDirWatch(vfs->watch);
+    mufSafeFree(vfs->mounts);
+    mufFree(vfs->cache);
+    mufDestroyLock(vfs->lock);
+    mufFree(vfs);
+}
+
+MUF_INTERNAL MufVfsMountId _mufVfsAddMount(MufVfs *vfs, const muf_char *prefix, muf_i32 priority, _MufVfsMount *mount) {
+    /* Normalizing never lengthens a path, so 0 here always means the root */
+    muf_char normalized[MUF_VFS_MAX_PATH];
+    if (strlen(prefix) >= sizeof(normalized))
+        return 0;
+    muf_usize prefixLength = mufVfsNormalizePath(prefix, normalized, sizeof(normalized));
+
+    mount->priority = priority;
+    mount->prefix = mufCStrClone(normalized);
+    mount->prefixLength = prefixLength;
+
+    mufLockAcquire(vfs->lock);
+    mount->id = vfs->nextMountId++;
+    if (vfs->mountCount == vfs->mountCapacity) {
+        vfs->mountCapacity = vfs->mountCapacity == 0 ? 8 : vfs->mountCapacity * 2;
+        vfs->mounts = mufRealloc(_MufVfsMount, vfs->mounts, vfs->mountCapacity);
+    }
+    /* Keep the mounts in overlay order: higher priority first, newer first among equals */
+    muf_usize index = 0;
+    while (index < vfs->mountCount && vfs->mounts[index].priority > priority)
+        ++index;
+    memmove(&vfs->mounts[index + 1], &vfs->mounts[index], (vfs->mountCount - index) * sizeof(_MufVfsMount));
+    vfs->mounts[index] = *mount;
+    ++vfs->mountCount;
+
+    if (mount->type == MUF_VFS_SOURCE_DIRECTORY && vfs->watch != NULL)
+        _mufDirWatchAddTree(vfs->watch, mount->directory, mount->id);
+    _mufVfsInvalidateAllLocked(vfs);
+    MufVfsMountId id = mount->id;
+    mufLockRelease(vfs->lock);
+    return id;
+}
+
+MufVfsMountId mufVfsMountDirectory(MufVfs *vfs, const muf_char *prefix, const muf_char *directory, muf_i32 priority) {
+    struct stat st;
+    if (stat(directory, &st) != 0 || (st.st_mode & S_IFMT) != S_IFDIR)
+        return 0;
+
+    _MufVfsMount mount;
+    mufMemFill(&mount, 0, sizeof(_MufVfsMount));
+    mount.type = MUF_VFS_SOURCE_DIRECTORY;
+    muf_usize length = strlen(directory);
+    while (length > 1 && (directory[length - 1] == '/' || directory[length - 1] == '\\'))
+        --length;
+    mount.directory = mufCStrClone(directory);
+    mount.directory[length] = '\0';
+
+    MufVfsMountId id = _mufVfsAddMount(vfs, prefix, priority, &mount);
+    if (id == 0)
+        mufFree(mount.directory);
+    return id;
+}
+
+MufVfsMountId mufVfsMountArchive(MufVfs *vfs, const muf_char *prefix, const muf_char *archivePath, muf_i32 priority) {
+    _MufVfsMount mount;
+    mufMemFill(&mount, 0, sizeof(_MufVfsMount));
+    mount.type = MUF_VFS_SOURCE_ARCHIVE;
+    MufArchive *archive = mufCreateArchive(archivePath);
+    if (archive == NULL)
+        return 0;
+    mount.archive = mufAlloc(_MufVfsArchive, 1);
+    mount.archive->handle = archive;
+    mount.archive->refCount = 1;
+
+    MufVfsMountId id = _mufVfsAddMount(vfs, prefix, priority, &mount);
+    if (id == 0) {
+        mufDestroyArchive(archive);
+        mufFree(mount.archive);
+    }
+    return id;
+}
+
+MUF_INTERNAL void _mufVfsReleaseArchive(MufVfs *vfs, _MufVfsArchive *archive) {
+    if (archive == NULL)
+        return;
+    mufLockAcquire(vfs->lock);
+    muf_bool last = --archive->refCount == 0;
+    mufLockRelease(vfs->lock);
+    if (last) {
+        mufDestroyArchive(archive->handle);
+        mufFree(archive);
+    }
+}
+
+muf_bool mufVfsUnmount(MufVfs *vfs, MufVfsMountId mount) {
+    _MufVfsArchive *archive = NULL;
+    muf_bool removed = MUF_FALSE;
+    mufLockAcquire(vfs->lock);
+    for (muf_usize i = 0; i < vfs->mountCount; ++i) {
+        _MufVfsMount *m = &vfs->mounts[i];
+        if (m->id != mount)
+            continue;
+        if (vfs->watch != NULL && m->type == MUF_VFS_SOURCE_DIRECTORY)
+            _mufDirWatchRemoveTree(vfs->watch, m->id);
+        mufFree(m->prefix);
+        mufSafeFree(m->directory);
+        archive = m->archive;
+        memmove(m, m + 1, (vfs->mountCount - i - 1) * sizeof(_MufVfsMount));
+        --vfs->mountCount;
+        _mufVfsInvalidateAllLocked(vfs);
+        removed = MUF_TRUE;
+        break;
+    }
+    mufLockRelease(vfs->lock);
+    /* A read in flight keeps the archive alive, the last release destroys it */
+    _mufVfsReleaseArchive(vfs, archive);
+    return removed;
+}
+
+/* With archiveOut set an archive location also takes a reference, released with _mufVfsReleaseArchive */
+MUF_INTERNAL muf_bool _mufVfsResolve(MufVfs *vfs, const muf_char *path, MufVfsLocation *locationOut, _MufVfsArchive **archiveOut) {
+    muf_char normalized[MUF_VFS_MAX_PATH];
+    muf_usize length = mufVfsNormalizePath(path, normalized, sizeof(normalized));
+    if (length == 0)
+        return MUF_FALSE;
+
+    mufLockAcquire(vfs->lock);
+    const _MufVfsCacheEntry *entry = _mufVfsLookupLocked(vfs, normalized, length);
+    const _MufVfsMount *mount = entry->mount != 0 ? _mufVfsFindMount(vfs, entry->mount) : NULL;
+    if (mount != NULL && locationOut != NULL) {
+        locationOut->mount = mount->id;
+        locationOut->type = mount->type;
+        locationOut->size = entry->size;
+        locationOut->archive = mount->archive != NULL ? mount->archive->handle : NULL;
+        locationOut->entry = entry->entry;
+        locationOut->nativePath[0] = '\0';
+        if (mount->type == MUF_VFS_SOURCE_DIRECTORY) {
+            const muf_char *relative = normalized;
+            _mufVfsMountMatches(mount, normalized, length, &relative);
+            /* The lookup only succeeds for a native path that fits */
+            _mufVfsNativePath(mount, relative, locationOut->nativePath, sizeof(locationOut->nativePath));
+        }
+    }
+    if (mount != NULL && archiveOut != NULL && mount->archive != NULL) {
+        ++mount->archive->refCount;
+        *archiveOut = mount->archive;
+    }
+    mufLockRelease(vfs->lock);
+    return mount != NULL;
+}
+
+muf_bool mufVfsResolve(MufVfs *vfs, const muf_char *path, MufVfsLocation *locationOut) {
+    return _mufVfsResolve(vfs, path, locationOut, NULL);
+}
+
+muf_bool mufVfsExists(MufVfs *vfs, const muf_char *path) {
+    return mufVfsResolve(vfs, path, NULL);
+}
+
+muf_byte *mufVfsReadFile(MufVfs *vfs, const muf_char *path, muf_usize *sizeOut) {
+    MufVfsLocation location;
+    _MufVfsArchive *archive = NULL;
+    if (!_mufVfsResolve(vfs, path, &location, &archive))
+        return NULL;
+
+    muf_byte *data = NULL;
+    muf_usize size = 0;
+    if (location.type == MUF_VFS_SOURCE_ARCHIVE) {
+        size = location.size;
+        data = mufAlloc(muf_byte, size > 0 ? size : 1);
+        muf_bool read = mufArchiveReadEntry(archive->handle, location.entry, data);
+        _mufVfsReleaseArchive(vfs, archive);
+        if (!read) {
+            mufFree(data);
+            return NULL;
+        }
+    } else {
+        MufFile *file = mufCreateFile(location.nativePath, MUF_FILE_OPEN_READ);
+        if (mufFileIsOpened(file)) {
+            size = mufFileGetSize(file);
+            data = mufAlloc(muf_byte, size > 0 ? size : 1);
+            size = mufFileRead(file, size, data);
+        }
+        mufDestroyFile(file);
+        if (data == NULL)
+            return NULL;
+    }
+
+    if (sizeOut != NULL)
+        *sizeOut = size;
+    return data;
+}
+
+MufFile *mufVfsOpenFile(MufVfs *vfs, const muf_char *path) {
+    MufVfsLocation location;
+    if (!mufVfsResolve(vfs, path, &location) || location.type != MUF_VFS_SOURCE_DIRECTORY)
+        return NULL;
+    MufFile *file = mufCreateFile(location.nativePath, MUF_FILE_OPEN_READ);
+    if (!mufFileIsOpened(file)) {
+        mufDestroyFile(file);
+        return NULL;
+    }
+    return file;
+}
+
+muf_usize mufVfsUpdate(MufVfs *vfs) {
+    if (vfs->watch == NULL)
+        return 0;
+    mufLockAcquire(vfs->lock);
+    muf_usize processed = _mufDirWatchRead(vfs->watch, 0, _mufVfsOnChange, vfs);
+    mufLockRelease(vfs->lock);
+    return processed;
+}
+
+void mufVfsInvalidate(MufVfs *vfs, const muf_char *path) {
+    mufLockAcquire(vfs->lock);
+    if (path == NULL) {
+        _mufVfsInvalidateAllLocked(vfs);
+    } else {
+        muf_char normalized[MUF_VFS_MAX_PATH];
+        muf_usize length = mufVfsNormalizePath(path, normalized, sizeof(normalized));
+        if (length > 0)
+            _mufVfsInvalidatePathLocked(vfs, normalized, length);
+    }
+    mufLockRelease(vfs->lock);
+}
@@ -0,0 +1,174 @@
+#include "../internal/dir_watch.h"
+
+#include <windows.h>
+
+#include "muffin_core/math.h"
+#include "muffin_core/memory.h"
+#include "muffin_core/string.h"
+
+#define MUF_DIR_WATCH_BUFFER_SIZE   (64 * 1024)
+#define MUF_DIR_WATCH_MAX_TREES     (MAXIMUM_WAIT_OBJECTS - 1)
+#define MUF_DIR_WATCH_FILTER (FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME \
+    | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_CREATION)
+
+typedef struct _MufDirWatchTree_s {
+    muf_u32     tag;
+    muf_wchar   root[MAX_PATH];
+    HANDLE      directory;
+    OVERLAPPED  overlapped;
+    DWORD       *buffer;
+} _MufDirWatchTree;
+
+struct _MufDirWatch_s {
+    HANDLE              wakeEvent;
+    _MufDirWatchTree    trees[MUF_DIR_WATCH_MAX_TREES];
+    muf_usize           treeCount;
+};
+
+MUF_INTERNAL muf_bool _mufDirWatchIssue(_MufDirWatchTree *tree) {
+    ResetEvent(tree->overlapped.hEvent);
+    return ReadDirectoryChangesW(tree->directory, tree->buffer, MUF_DIR_WATCH_BUFFER_SIZE, TRUE,
+        MUF_DIR_WATCH_FILTER, NULL, &tree->overlapped, NULL) != 0;
+}
+
+MUF_INTERNAL void _mufDirWatchCloseTree(_MufDirWatchTree *tree) {
+    CancelIo(tree->directory);
+    CloseHandle(tree->directory);
+    CloseHandle(tree->overlapped.hEvent);
+    mufFree(tree->buffer);
+}
+
+_MufDirWatch *_mufCreateDirWatch(void) {
+    _MufDirWatch *watch = mufAllocZero(_MufDirWatch, 1);
+    watch->wakeEvent = CreateEventW(NULL, FALSE, FALSE, NULL);
+    return watch;
+}
+
+void _mufDestroyDirWatch(_MufDirWatch *watch) {
+    if (watch == NULL)
+        return;
+    for (muf_usize i = 0; i < watch->treeCount; ++i)
+        _mufDirWatchCloseTree(&watch->trees[i]);
+    CloseHandle(watch->wakeEvent);
+    mufFree(watch);
+}
+
+muf_bool _mufDirWatchAddTree(_MufDirWatch *watch, const muf_char *directory, muf_u32 tag) {
+    if (watch->treeCount == MUF_DIR_WATCH_MAX_TREES)
+        return MUF_FALSE;
+    for (muf_usize i = 0; i < watch->treeCount; ++i) {
+        if (watch->trees[i].tag == tag)
+            return MUF_FALSE;
+    }
+
+    _MufDirWatchTree *tree = &watch->trees[watch->treeCount];
+    mufMemFill(tree, 0, sizeof(_MufDirWatchTree));
+    tree->tag = tag;
+    mufUtf8ToUtf16(tree->root, MAX_PATH - 1, directory, mufCStrLength(directory));
+    tree->directory = CreateFileW(tree->root, FILE_LIST_DIRECTORY,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (tree->directory == INVALID_HANDLE_VALUE)
+        return MUF_FALSE;
+    tree->overlapped.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    tree->buffer = (DWORD *) mufAllocBytes(MUF_DIR_WATCH_BUFFER_SIZE);
+    if (!_mufDirWatchIssue(tree)) {
+        _mufDirWatchCloseTree(tree);
+        return MUF_FALSE;
+    }
+    ++watch->treeCount;
+    return MUF_TRUE;
+}
+
+void _mufDirWatchRemoveTree(_MufDirWatch *watch, muf_u32 tag) {
+    for (muf_usize i = 0; i < watch->treeCount; ++i) {
+        if (watch->trees[i].tag == tag) {
+            _mufDirWatchCloseTree(&watch->trees[i]);
+            watch->trees[i] = watch->trees[--watch->treeCount];
+            return;
+        }
+    }
+}
+
+MUF_INTERNAL muf_u32 _mufDirWatchTranslate(DWORD action) {
+    switch (action) {
+        case FILE_ACTION_ADDED:
+        case FILE_ACTION_RENAMED_NEW_NAME:
+            return _MUF_DIR_WATCH_EVENT_CREATED;
+        case FILE_ACTION_REMOVED:
+        case FILE_ACTION_RENAMED_OLD_NAME:
+            return _MUF_DIR_WATCH_EVENT_REMOVED;
+        default:
+            return _MUF_DIR_WATCH_EVENT_MODIFIED;
+    }
+}
+
+MUF_INTERNAL muf_usize _mufDirWatchDrainTree(_MufDirWatchTree *tree, _MufDirWatchCallback callback, muf_rawptr userData) {
+    DWORD size = 0;
+    if (!GetOverlappedResult(tree->directory, &tree->overlapped, &size, FALSE))
+        return 0;
+
+    muf_usize delivered = 0;
+    if (size == 0) {
+        /* The buffer overflowed and the changes were dropped */
+        callback(userData, tree->tag, "", _MUF_DIR_WATCH_EVENT_OVERFLOW);
+        ++delivered;
+    } else {
+        const muf_byte *p = (const muf_byte *) tree->buffer;
+        for (;;) {
+            const FILE_NOTIFY_INFORMATION *info = (const FILE_NOTIFY_INFORMATION *) p;
+            muf_char relative[MAX_PATH * 3];
+            muf_usize length = info->FileNameLength / sizeof(WCHAR);
+            mufMemFill(relative, 0, sizeof(relative));
+            mufUtf16ToUtf8(relative, sizeof(relative) - 1, info->FileName, length);
+            for (muf_char *c = relative; *c != '\0'; ++c) {
+                if (*c == '\\')
+                    *c = '/';
+            }
+
+            muf_wchar fullPath[MAX_PATH * 2];
+            muf_usize rootLength = wcslen(tree->root);
+            muf_usize nameLength = mufMin(length, MAX_PATH * 2 - rootLength - 2);
+            mufMemCopyBytes(fullPath, tree->root, rootLength * sizeof(muf_wchar));
+            fullPath[rootLength] = L'\\';
+            mufMemCopyBytes(fullPath + rootLength + 1, info->FileName, nameLength * sizeof(muf_wchar));
+            fullPath[rootLength + 1 + nameLength] = L'\0';
+
+            muf_u32 events = _mufDirWatchTranslate(info->Action);
+            DWORD attributes = GetFileAttributesW(fullPath);
+            if (attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY))
+                events |= _MUF_DIR_WATCH_EVENT_DIRECTORY;
+            callback(userData, tree->tag, relative, events);
+            ++delivered;
+
+            if (info->NextEntryOffset == 0)
+                break;
+            p += info->NextEntryOffset;
+        }
+    }
+    _mufDirWatchIssue(tree);
+    return delivered;
+}
+
+muf_usize _mufDirWatchRead(_MufDirWatch *watch, muf_i32 timeoutMs, _MufDirWatchCallback callback, muf_rawptr userData) {
+    HANDLE handles[MAXIMUM_WAIT_OBJECTS];
+    handles[0] = watch->wakeEvent;
+    for (muf_usize i = 0; i < watch->treeCount; ++i)
+        handles[i + 1] = watch->trees[i].overlapped.hEvent;
+
+    DWORD result = WaitForMultipleObjects((DWORD) watch->treeCount + 1, handles, FALSE,
+        timeoutMs < 0 ? INFINITE : (DWORD) timeoutMs);
+    if (result == WAIT_TIMEOUT || result == WAIT_FAILED)
+        return 0;
+
+    muf_usize delivered = 0;
+    for (muf_usize i = 0; i < watch->treeCount; ++i) {
+        if (WaitForSingleObject(watch->trees[i].overlapped.hEvent, 0) == WAIT_OBJECT_0)
+            delivered += _mufDirWatchDrainTree(&watch->trees[i], callback, userData);
+    }
+    return delivered;
+}
+
+void _mufDirWatchWake(_MufDirWatch *watch) {
+    SetEvent(watch->wakeEvent);
+}
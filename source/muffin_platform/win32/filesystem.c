@@ -8,7 +8,7 @@
 MufFile *mufCreateFile(const muf_char *path, MufFileOpenMode openMode) {
     MufFile *file = mufAlloc(MufFile, 1);
     file->openMode = openMode;
-    file->path = path;
+    file->path = mufCStrClone(path);
 
     muf_wchar utf16Path[256];
     mufUtf8ToUtf16(utf16Path, 256, path, mufCStrLength(path));
@@ -33,6 +33,7 @@ MufFile *mufCreateFile(const muf_char *path, MufFileOpenMode openMode) {
 
 void mufDestroyFile(MufFile *file) {
     CloseHandle(file->handle._ptr);
+    mufSafeFree(file->path);
     mufFree(file);
 }
 
@@ -124,6 +125,77 @@ void mufFileFlush(MufFile *file) {
     FlushFileBuffers(file->handle._ptr);
 }
 
+static void _mufFilePrefetch(muf_rawptr address, muf_usize size) {
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = address;
+    range.NumberOfBytes = size;
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+}
+
+muf_bool mufFileMap(MufFile *file, muf_offset offset, muf_usize size, MufFileMapMode mode, muf_u32 flags, MufFileView *viewOut) {
+    memset(viewOut, 0, sizeof(MufFileView));
+    if (!mufFileIsOpened(file) || offset < 0)
+        return MUF_FALSE;
+
+    muf_usize fileSize = mufFileGetSize(file);
+    if ((muf_usize) offset >= fileSize)
+        return MUF_FALSE;
+    if (size == 0 || size > fileSize - (muf_usize) offset)
+        size = fileSize - (muf_usize) offset;
+
+    /* Views must start at a multiple of the allocation granularity, large pages are not available for file mappings */
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    muf_u64 granularity = systemInfo.dwAllocationGranularity;
+    muf_u64 alignedOffset = (muf_u64) offset & ~(granularity - 1);
+    muf_usize mappedSize = size + (muf_usize) ((muf_u64) offset - alignedOffset);
+
+    DWORD protect = mode == MUF_FILE_MAP_COPY_ON_WRITE ? PAGE_WRITECOPY : PAGE_READONLY;
+    DWORD access = mode == MUF_FILE_MAP_COPY_ON_WRITE ? FILE_MAP_COPY : FILE_MAP_READ;
+    HANDLE mapping = CreateFileMappingW(file->handle._ptr, NULL, protect, 0, 0, NULL);
+    if (mapping == NULL)
+        return MUF_FALSE;
+
+    muf_rawptr base = MapViewOfFile(mapping, access, (DWORD) (alignedOffset >> 32), (DWORD) alignedOffset, mappedSize);
+    if (base == NULL) {
+        CloseHandle(mapping);
+        return MUF_FALSE;
+    }
+
+    if (flags & (MUF_FILE_MAP_FLAG_WILL_NEED | MUF_FILE_MAP_FLAG_POPULATE))
+        _mufFilePrefetch(base, mappedSize);
+
+    viewOut->_base = base;
+    viewOut->_mappedSize = mappedSize;
+    viewOut->_mapping._ptr = mapping;
+    viewOut->data = (muf_byte *) base + ((muf_u64) offset - alignedOffset);
+    viewOut->size = size;
+    return MUF_TRUE;
+}
+
+void mufFileUnmap(MufFileView *view) {
+    if (view->_base != NULL) {
+        UnmapViewOfFile(view->_base);
+        CloseHandle(view->_mapping._ptr);
+    }
+    memset(view, 0, sizeof(MufFileView));
+}
+
+void mufFileViewAdvise(const MufFileView *view, muf_offset offset, muf_usize size, muf_u32 flags) {
+    if (view->_base == NULL || offset < 0 || (muf_usize) offset >= view->size)
+        return;
+    if (size == 0 || size > view->size - (muf_usize) offset)
+        size = view->size - (muf_usize) offset;
+
+    muf_byte *first = (muf_byte *) view->data + offset;
+    if (flags & MUF_FILE_MAP_FLAG_WILL_NEED)
+        _mufFilePrefetch(first, size);
+    if (flags & MUF_FILE_MAP_FLAG_DONT_NEED)
+        VirtualUnlock(first, size);
+}
+
 void mufCopyFile(const muf_char *oldPath, const muf_char *newPath) {
     muf_wchar utf16OldPath[256];
     muf_wchar utf16NewPath[256];
@@ -9,6 +9,12 @@ muf_u64 mufPlatformGetTime() {
     return (muf_u64) time.QuadPart;
 }
 
+muf_u64 mufPlatformGetTimeFrequency() {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    return (muf_u64) frequency.QuadPart;
+}
+
 void mufPlatformSleep(muf_u32 milliseconds) {
     Sleep(milliseconds);
 }
\ No newline at end of file
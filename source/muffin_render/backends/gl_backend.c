@@ -1,3 +1,5 @@
+#define MUF_MEMORY_TAG MUF_MEMORY_TAG_RENDER_BACKEND
+
 #include "muffin_render/backends/gl_backend.h"
 
 #include "glad/glad.h"
@@ -5,25 +7,39 @@
 #include "muffin_core/array.h"
 #include "muffin_core/hash_map.h"
 #include "muffin_core/log.h"
+#include "muffin_core/math.h"
 #include "muffin_core/memory.h"
+#include "muffin_core/profiler.h"
+#include "muffin_core/timer.h"
 #include "muffin_render/backend.h"
 #include "muffin_render/commands.h"
 #include "muffin_render/enums.h"
 #include "muffin_render/pipeline.h"
 #include "muffin_render/resources.h"
 
+/* EXT_texture_compression_s3tc is not part of core GL but every desktop driver exposes it */
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#   define GL_COMPRESSED_RGB_S3TC_DXT1_EXT  0x83F0
+#   define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#   define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#   define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
 MUF_INTERNAL MufBuffer mufGLCreateBuffer(const MufBufferCreateInfo *info);
 MUF_INTERNAL void mufGLDestroyBuffer(MufBuffer buffer);
 MUF_INTERNAL MufSampler mufGLCreateSampler(const MufSamplerCreateInfo *info);
 MUF_INTERNAL void mufGLDestroySampler(MufSampler sampler);
 MUF_INTERNAL MufTexture mufGLCreateTexture(const MufTextureCreateInfo *info);
 MUF_INTERNAL void mufGLDestroyTexture(MufTexture texture);
+MUF_INTERNAL void mufGLWriteTexture(MufTexture texture, muf_u32 mipLevel, muf_crawptr data, muf_usize rowPitch);
 MUF_INTERNAL MufFramebuffer mufGLCreateFramebuffer(const MufFramebufferCreateInfo *info);
 MUF_INTERNAL void mufGLDestroyFramebuffer(MufFramebuffer framebuffer);
 MUF_INTERNAL MufShader mufGLCreateShader(const MufShaderCreateInfo *info);
 MUF_INTERNAL void mufGLDestroyShader(MufShader shader);
+MUF_INTERNAL muf_bool mufGLIsShaderCompiled(MufShader shader);
 MUF_INTERNAL MufShaderProgram mufGLCreateShaderProgram(const MufShaderProgramCreateInfo *info);
 MUF_INTERNAL void mufGLDestroyShaderProgram(MufShaderProgram program);
+MUF_INTERNAL muf_bool mufGLIsShaderProgramLinked(MufShaderProgram program);
 
 MUF_INTERNAL MufResourceHeap mufGLCreateResourceHeap(const MufResourceHeapCreateInfo *info);
 MUF_INTERNAL void mufGLDestroyResourceHeap(MufResourceHeap heap);
@@ -61,6 +77,9 @@ MUF_INTERNAL void mufGLCmdBindResourceHeap(MufResourceHeap heap);
 MUF_INTERNAL void mufGLCmdDraw(muf_index firstIndex, muf_usize count);
 MUF_INTERNAL void mufGLCmdDrawIndexed(muf_index firstIndex, muf_usize count);
 MUF_INTERNAL void mufGLCmdBlit();
+MUF_INTERNAL void mufGLCmdBeginTimerScope(const muf_char *name);
+MUF_INTERNAL void mufGLCmdEndTimerScope();
+MUF_INTERNAL void mufGLCmdEndFrame();
 
 /// GL backend global configuration
 
@@ -73,7 +92,13 @@ enum _MUFGL_GLOBAL_CONFIG {
     MUFGL_MAX_PIPELINE_COUNT = 32,
 
     MUFGL_PIPELINE_STATE_POOL_BUCKET_SIZE = 32,
-    MUFGL_PIPELINE_STATE_POOL_INIT_BITS = MUF_U32_MAX
+    MUFGL_PIPELINE_STATE_POOL_INIT_BITS = MUF_U32_MAX,
+
+    MUFGL_QUERY_POOL_GROW_SIZE = 64,
+    MUFGL_TIMER_QUERY_LATENCY_FRAMES = 3,
+    MUFGL_TIMER_QUERY_MAX_DEPTH = 32,
+    MUFGL_TIMER_QUERY_MAX_PENDING = 1024,
+    MUFGL_TIMER_CALIBRATION_INTERVAL = 64
 };
 
 typedef struct _MufGLInputAssemblyState_s {
@@ -252,13 +277,19 @@ typedef struct _MufGLVertexArray_s {
 } _MufGLVertexArray;
 
 typedef struct _MufGLRenderPass_s {
+    const muf_char *name;
     GLuint      resourceId;
     GLbitfield  clearBits;
     GLuint      sampleCount;
 } _MufGLRenderPass;
 
+/* A pair of GL_TIMESTAMP queries around one timing scope */
 typedef struct _MufGLQuery_s {
-
+    const muf_char  *name;
+    GLuint          beginId;
+    GLuint          endId;
+    muf_u64         frame;
+    muf_bool        closed;
 } _MufGLQuery;
 
 typedef struct _MufGLPipelineState_s {
@@ -511,6 +542,107 @@ static void _mufGLFinishCache() {
     _mufGLDestroyPipelineStatePool(_mufGLCache->pools.pipelinePool);
 }
 
+/// GPU timer queries
+
+typedef struct _MufGLTimerQueries_s {
+    MufArray        *freeIds;
+    MufArray        *pending;
+    muf_index       pendingHead;
+    muf_index       openScopes[MUFGL_TIMER_QUERY_MAX_DEPTH];
+    muf_usize       openDepth;
+    muf_u64         frame;
+    MufProfileTrack track;
+    GLint64         calibrationGpuNs;
+    muf_u64         calibrationCpuTicks;
+} _MufGLTimerQueries;
+
+_MufGLTimerQueries _mufGLTimers[1];
+
+#define _MUFGL_TIMER_SCOPE_DISABLED ((muf_index) -1)
+
+static void _mufGLCalibrateTimers() {
+    glGetInteger64v(GL_TIMESTAMP, &_mufGLTimers->calibrationGpuNs);
+    _mufGLTimers->calibrationCpuTicks = mufTimerGetTicks();
+}
+
+static void _mufGLInitTimers() {
+    _mufGLTimers->freeIds = mufCreateArray(GLuint);
+    _mufGLTimers->pending = mufCreateArray(_MufGLQuery);
+    _mufGLTimers->pendingHead = 0;
+    _mufGLTimers->openDepth = 0;
+    _mufGLTimers->frame = 0;
+    _mufGLTimers->track = mufProfilerCreateTrack("GPU");
+    _mufGLCalibrateTimers();
+}
+
+static void _mufGLFinishTimers() {
+    MufArray *pending = _mufGLTimers->pending;
+    for (muf_index i = _mufGLTimers->pendingHead; i < mufArrayGetSize(pending); ++i) {
+        _MufGLQuery *q = (_MufGLQuery *) mufArrayGetRef(pending, i);
+        glDeleteQueries(1, &q->beginId);
+        glDeleteQueries(1, &q->endId);
+    }
+    MufArray *freeIds = _mufGLTimers->freeIds;
+    if (mufArrayGetSize(freeIds) > 0)
+        glDeleteQueries((GLsizei) mufArrayGetSize(freeIds), (const GLuint *) mufArrayGetData(freeIds));
+    mufDestroyArray(pending);
+    mufDestroyArray(freeIds);
+}
+
+static GLuint _mufGLRequireQueryId() {
+    MufArray *freeIds = _mufGLTimers->freeIds;
+    if (mufArrayIsEmpty(freeIds)) {
+        GLuint ids[MUFGL_QUERY_POOL_GROW_SIZE];
+        glGenQueries(MUFGL_QUERY_POOL_GROW_SIZE, ids);
+        for (muf_index i = 0; i < MUFGL_QUERY_POOL_GROW_SIZE; ++i)
+            mufArrayPush(freeIds, &ids[i]);
+    }
+    GLuint id;
+    mufArrayGetBack(freeIds, &id);
+    mufArrayPop(freeIds);
+    return id;
+}
+
+static muf_u64 _mufGLGpuTimeToCpuTicks(GLuint64 gpuNs) {
+    GLint64 delta = (GLint64) gpuNs - _mufGLTimers->calibrationGpuNs;
+    if (delta >= 0)
+        return _mufGLTimers->calibrationCpuTicks + mufTimerNanosecondsToTicks((muf_u64) delta);
+    return _mufGLTimers->calibrationCpuTicks - mufTimerNanosecondsToTicks((muf_u64) -delta);
+}
+
+/* Queries complete in submission order, so collection stops at the first one that is not ready */
+static void _mufGLCollectTimers() {
+    MufArray *pending = _mufGLTimers->pending;
+    muf_index head = _mufGLTimers->pendingHead;
+
+    for (; head < mufArrayGetSize(pending); ++head) {
+        _MufGLQuery *q = (_MufGLQuery *) mufArrayGetRef(pending, head);
+        if (!q->closed || q->frame + MUFGL_TIMER_QUERY_LATENCY_FRAMES > _mufGLTimers->frame)
+            break;
+
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(q->endId, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+
+        GLuint64 beginNs = 0, endNs = 0;
+        glGetQueryObjectui64v(q->beginId, GL_QUERY_RESULT, &beginNs);
+        glGetQueryObjectui64v(q->endId, GL_QUERY_RESULT, &endNs);
+        mufProfilerRecordComplete(_mufGLTimers->track, q->name,
+            _mufGLGpuTimeToCpuTicks(beginNs), _mufGLGpuTimeToCpuTicks(endNs));
+
+        mufArrayPush(_mufGLTimers->freeIds, &q->beginId);
+        mufArrayPush(_mufGLTimers->freeIds, &q->endId);
+    }
+
+    /* Open scopes refer to pending entries by index, so only compact when none are open */
+    if (_mufGLTimers->openDepth == 0 && head > 0) {
+        mufArrayRemoveRange(pending, 0, head);
+        head = 0;
+    }
+    _mufGLTimers->pendingHead = head;
+}
+
 static GLenum _mufGLConvertFormat(MufFormat format) {
     switch (format) {
         case MUF_FORMAT_R8_UINT             : return GL_R8UI;
@@ -560,6 +692,18 @@ static GLenum _mufGLConvertFormat(MufFormat format) {
         case MUF_FORMAT_R32G32B32A32_SINT   : return GL_RGBA32I;
         case MUF_FORMAT_R32G32B32A32_FLOAT  : return GL_RGBA32F;
 
+        case MUF_FORMAT_BC1_RGB_UNORM       : return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case MUF_FORMAT_BC1_RGBA_UNORM      : return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        case MUF_FORMAT_BC2_UNORM           : return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+        case MUF_FORMAT_BC3_UNORM           : return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case MUF_FORMAT_BC4_UNORM           : return GL_COMPRESSED_RED_RGTC1;
+        case MUF_FORMAT_BC4_SNORM           : return GL_COMPRESSED_SIGNED_RED_RGTC1;
+        case MUF_FORMAT_BC5_UNORM           : return GL_COMPRESSED_RG_RGTC2;
+        case MUF_FORMAT_BC5_SNORM           : return GL_COMPRESSED_SIGNED_RG_RGTC2;
+        case MUF_FORMAT_BC6H_UFLOAT         : return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+        case MUF_FORMAT_BC6H_SFLOAT         : return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;
+        case MUF_FORMAT_BC7_UNORM           : return GL_COMPRESSED_RGBA_BPTC_UNORM;
+
         case MUF_FORMAT_D16_UNORM           : return GL_DEPTH_COMPONENT16;
         case MUF_FORMAT_D32_FLOAT           : return GL_DEPTH_COMPONENT32F;
         case MUF_FORMAT_D24_UNORM_S8_UINT   : return GL_DEPTH24_STENCIL8;
@@ -574,55 +718,55 @@ static GLenum _mufGLConvertPixelDataFormat(MufFormat format) {
     switch (format) {
         case MUF_FORMAT_R8_UINT             :
         case MUF_FORMAT_R8_SINT             :
-        case MUF_FORMAT_R8_UNORM            :
-        case MUF_FORMAT_R8_SNORM            :
         case MUF_FORMAT_R16_UINT            :
         case MUF_FORMAT_R16_SINT            :
-        case MUF_FORMAT_R16_UNORM           :
-        case MUF_FORMAT_R16_SNORM           :
         case MUF_FORMAT_R32_UINT            :
         case MUF_FORMAT_R32_SINT            : return GL_RED_INTEGER;
 
         case MUF_FORMAT_R8G8_UINT           :
         case MUF_FORMAT_R8G8_SINT           :
-        case MUF_FORMAT_R8G8_UNORM          :
-        case MUF_FORMAT_R8G8_SNORM          :
         case MUF_FORMAT_R16G16_UINT         :
         case MUF_FORMAT_R16G16_SINT         :
-        case MUF_FORMAT_R16G16_UNORM        :
-        case MUF_FORMAT_R16G16_SNORM        :
         case MUF_FORMAT_R32G32_UINT         :
         case MUF_FORMAT_R32G32_SINT         : return GL_RG_INTEGER;
-        
+
         case MUF_FORMAT_R8G8B8_UINT         :
         case MUF_FORMAT_R8G8B8_SINT         :
-        case MUF_FORMAT_R8G8B8_UNORM        :
-        case MUF_FORMAT_R8G8B8_SNORM        :
         case MUF_FORMAT_R16G16B16_UINT      :
         case MUF_FORMAT_R16G16B16_SINT      :
-        case MUF_FORMAT_R16G16B16_UNORM     :
-        case MUF_FORMAT_R16G16B16_SNORM     :
         case MUF_FORMAT_R32G32B32_UINT      :
         case MUF_FORMAT_R32G32B32_SINT      : return GL_RGB_INTEGER;
-        
+
         case MUF_FORMAT_R8G8B8A8_UINT       :
         case MUF_FORMAT_R8G8B8A8_SINT       :
-        case MUF_FORMAT_R8G8B8A8_UNORM      :
-        case MUF_FORMAT_R8G8B8A8_SNORM      :
         case MUF_FORMAT_R16G16B16A16_UINT   :
         case MUF_FORMAT_R16G16B16A16_SINT   :
-        case MUF_FORMAT_R16G16B16A16_UNORM  :
-        case MUF_FORMAT_R16G16B16A16_SNORM  :
         case MUF_FORMAT_R32G32B32A32_UINT   :
         case MUF_FORMAT_R32G32B32A32_SINT   : return GL_RGBA_INTEGER;
 
-        
+        /* Normalized and float formats are uploaded through the non integer layouts */
+        case MUF_FORMAT_R8_UNORM            :
+        case MUF_FORMAT_R8_SNORM            :
+        case MUF_FORMAT_R16_UNORM           :
+        case MUF_FORMAT_R16_SNORM           :
         case MUF_FORMAT_R32_FLOAT           : return GL_RED;
-        
+
+        case MUF_FORMAT_R8G8_UNORM          :
+        case MUF_FORMAT_R8G8_SNORM          :
+        case MUF_FORMAT_R16G16_UNORM        :
+        case MUF_FORMAT_R16G16_SNORM        :
         case MUF_FORMAT_R32G32_FLOAT        : return GL_RG;
-        
+
+        case MUF_FORMAT_R8G8B8_UNORM        :
+        case MUF_FORMAT_R8G8B8_SNORM        :
+        case MUF_FORMAT_R16G16B16_UNORM     :
+        case MUF_FORMAT_R16G16B16_SNORM     :
         case MUF_FORMAT_R32G32B32_FLOAT     : return GL_RGB;
-        
+
+        case MUF_FORMAT_R8G8B8A8_UNORM      :
+        case MUF_FORMAT_R8G8B8A8_SNORM      :
+        case MUF_FORMAT_R16G16B16A16_UNORM  :
+        case MUF_FORMAT_R16G16B16A16_SNORM  :
         case MUF_FORMAT_R32G32B32A32_FLOAT  : return GL_RGBA;
 
         case MUF_FORMAT_D16_UNORM           :
@@ -631,6 +775,19 @@ static GLenum _mufGLConvertPixelDataFormat(MufFormat format) {
         case MUF_FORMAT_D24_UNORM_S8_UINT   :
         case MUF_FORMAT_D32_FLOAT_S8_UINT   : return GL_DEPTH_STENCIL;
 
+        /* Compressed blocks are uploaded as they are */
+        case MUF_FORMAT_BC1_RGB_UNORM       :
+        case MUF_FORMAT_BC1_RGBA_UNORM      :
+        case MUF_FORMAT_BC2_UNORM           :
+        case MUF_FORMAT_BC3_UNORM           :
+        case MUF_FORMAT_BC4_UNORM           :
+        case MUF_FORMAT_BC4_SNORM           :
+        case MUF_FORMAT_BC5_UNORM           :
+        case MUF_FORMAT_BC5_SNORM           :
+        case MUF_FORMAT_BC6H_UFLOAT         :
+        case MUF_FORMAT_BC6H_SFLOAT         :
+        case MUF_FORMAT_BC7_UNORM           : return GL_NONE;
+
         default                             : MUF_UNREACHABLE();
     }
     return -1;
@@ -695,6 +852,18 @@ static GLenum _mufGLConvertPixelDataType(MufFormat format) {
 
         case MUF_FORMAT_D32_FLOAT_S8_UINT   : return GL_FLOAT_32_UNSIGNED_INT_24_8_REV;
 
+        case MUF_FORMAT_BC1_RGB_UNORM       :
+        case MUF_FORMAT_BC1_RGBA_UNORM      :
+        case MUF_FORMAT_BC2_UNORM           :
+        case MUF_FORMAT_BC3_UNORM           :
+        case MUF_FORMAT_BC4_UNORM           :
+        case MUF_FORMAT_BC4_SNORM           :
+        case MUF_FORMAT_BC5_UNORM           :
+        case MUF_FORMAT_BC5_SNORM           :
+        case MUF_FORMAT_BC6H_UFLOAT         :
+        case MUF_FORMAT_BC6H_SFLOAT         :
+        case MUF_FORMAT_BC7_UNORM           : return GL_NONE;
+
         default                             : MUF_UNREACHABLE();
     }
     return -1;
@@ -716,6 +885,46 @@ static GLuint _mufGLGetFormatSize(MufFormat format) {
     return -1;
 }
 
+/* The byte count of a pixel in client memory for a pixel data format and type */
+static GLuint _mufGLGetPixelSize(GLenum format, GLenum pixelType) {
+    GLuint components;
+    switch (format) {
+        case GL_RG              :
+        case GL_RG_INTEGER      : components = 2; break;
+        case GL_RGB             :
+        case GL_RGB_INTEGER     : components = 3; break;
+        case GL_RGBA            :
+        case GL_RGBA_INTEGER    : components = 4; break;
+        default                 : components = 1; break;
+    }
+    switch (pixelType) {
+        case GL_UNSIGNED_BYTE                   :
+        case GL_BYTE                            : return components;
+        case GL_UNSIGNED_SHORT                  :
+        case GL_SHORT                           : return components * 2;
+        case GL_FLOAT_32_UNSIGNED_INT_24_8_REV  : return 8;
+        default                                 : return components * 4;
+    }
+}
+
+/* The byte count of a 4x4 block of a compressed internal format, 0 for the uncompressed ones */
+static GLuint _mufGLGetCompressedBlockSize(GLenum internalFormat) {
+    switch (internalFormat) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT        :
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT       :
+        case GL_COMPRESSED_RED_RGTC1                :
+        case GL_COMPRESSED_SIGNED_RED_RGTC1         : return 8;
+        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT       :
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT       :
+        case GL_COMPRESSED_RG_RGTC2                 :
+        case GL_COMPRESSED_SIGNED_RG_RGTC2          :
+        case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT  :
+        case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT    :
+        case GL_COMPRESSED_RGBA_BPTC_UNORM          : return 16;
+        default                                     : return 0;
+    }
+}
+
 static GLboolean _mufGLIsNormalized(MufFormat format) {
     switch (format) {
         case MUF_FORMAT_R8_UNORM            :
@@ -1070,6 +1279,9 @@ MufTexture mufGLCreateTexture(const MufTextureCreateInfo *info) {
             mufError("The `type` must be MUF_TEXTURE_2D for cubemap");
         }
     }
+    if (_mufGLGetCompressedBlockSize(internalFormat) != 0 && (info->type != MUF_TEXTURE_TYPE_2D || isMultiSamples)) {
+        mufError("Block compressed formats are only supported by single sampled 2D textures");
+    }
 
     glGenTextures(1, &textureId);
     glBindTexture(textureTarget, textureId);
@@ -1110,6 +1322,7 @@ MufTexture mufGLCreateTexture(const MufTextureCreateInfo *info) {
     texture->internalFormat     = internalFormat;
     texture->format             = format;
     texture->pixelType          = pixelType;
+    texture->mipLevels          = info->mipLevels;
     texture->sampleCount        = sampleCount;
     texture->samplerId          = 0;
 
@@ -1122,6 +1335,74 @@ void mufGLDestroyTexture(MufTexture texture) {
     mufFree(t);
 }
 
+/* Upload whole 4x4 blocks, the pitch is the byte count of a row of blocks */
+MUF_INTERNAL void _mufGLWriteCompressedTexture(_MufGLTexture *t, muf_u32 mipLevel, muf_crawptr data, muf_usize rowPitch) {
+    GLuint blockSize = _mufGLGetCompressedBlockSize(t->internalFormat);
+    GLsizei width = mufMax(t->width >> mipLevel, 1U);
+    GLsizei height = mufMax(t->height >> mipLevel, 1U);
+    GLsizei blocksX = (width + 3) / 4;
+    GLsizei blocksY = (height + 3) / 4;
+    muf_usize tightPitch = (muf_usize) blocksX * blockSize;
+    if (rowPitch == 0)
+        rowPitch = tightPitch;
+
+    /* The unpack row length only applies to compressed data once the block layout is known */
+    glPixelStorei(GL_UNPACK_COMPRESSED_BLOCK_WIDTH, 4);
+    glPixelStorei(GL_UNPACK_COMPRESSED_BLOCK_HEIGHT, 4);
+    glPixelStorei(GL_UNPACK_COMPRESSED_BLOCK_SIZE, blockSize);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, rowPitch != tightPitch ? (GLint) (rowPitch / blockSize * 4) : 0);
+    GLsizei imageSize = (GLsizei) (rowPitch * (blocksY - 1) + tightPitch);
+    switch (t->target) {
+        case GL_TEXTURE_2D:
+            glCompressedTextureSubImage2D(t->resourceId, mipLevel, 0, 0, width, height, t->internalFormat, imageSize, data);
+            break;
+        case GL_TEXTURE_2D_ARRAY:
+            imageSize = (GLsizei) (rowPitch * blocksY * t->arrayLayerCount);
+            glCompressedTextureSubImage3D(t->resourceId, mipLevel, 0, 0, 0, width, height, t->arrayLayerCount, t->internalFormat, imageSize, data);
+            break;
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_COMPRESSED_BLOCK_WIDTH, 0);
+    glPixelStorei(GL_UNPACK_COMPRESSED_BLOCK_HEIGHT, 0);
+    glPixelStorei(GL_UNPACK_COMPRESSED_BLOCK_SIZE, 0);
+}
+
+void mufGLWriteTexture(MufTexture texture, muf_u32 mipLevel, muf_crawptr data, muf_usize rowPitch) {
+    _MufGLTexture *t = mufHandleCastPtr(_MufGLTexture, texture);
+    if (_mufGLGetCompressedBlockSize(t->internalFormat) != 0) {
+        _mufGLWriteCompressedTexture(t, mipLevel, data, rowPitch);
+        return;
+    }
+
+    GLsizei width = mufMax(t->width >> mipLevel, 1U);
+    GLsizei height = mufMax(t->height >> mipLevel, 1U);
+    GLsizei depth = mufMax(t->depth >> mipLevel, 1U);
+    GLuint pixelSize = _mufGLGetPixelSize(t->format, t->pixelType);
+
+    /* The rows are described by the pitch, not by the default 4 byte row alignment */
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, rowPitch != 0 ? (GLint) (rowPitch / pixelSize) : 0);
+    switch (t->target) {
+        case GL_TEXTURE_1D:
+            glTextureSubImage1D(t->resourceId, mipLevel, 0, width, t->format, t->pixelType, data);
+            break;
+        case GL_TEXTURE_2D:
+            glTextureSubImage2D(t->resourceId, mipLevel, 0, 0, width, height, t->format, t->pixelType, data);
+            break;
+        case GL_TEXTURE_1D_ARRAY:
+            glTextureSubImage2D(t->resourceId, mipLevel, 0, 0, width, t->arrayLayerCount, t->format, t->pixelType, data);
+            break;
+        case GL_TEXTURE_3D:
+            glTextureSubImage3D(t->resourceId, mipLevel, 0, 0, 0, width, height, depth, t->format, t->pixelType, data);
+            break;
+        case GL_TEXTURE_2D_ARRAY:
+            glTextureSubImage3D(t->resourceId, mipLevel, 0, 0, 0, width, height, t->arrayLayerCount, t->format, t->pixelType, data);
+            break;
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
 MufFramebuffer mufGLCreateFramebuffer(const MufFramebufferCreateInfo *info) {
     GLuint framebufferId;
     glCreateFramebuffers(1, &framebufferId);
@@ -1213,11 +1494,16 @@ void mufGLDestroyShader(MufShader shader) {
     mufFree(s);
 }
 
+muf_bool mufGLIsShaderCompiled(MufShader shader) {
+    return mufHandleCastPtr(_MufGLShader, shader)->compiled == GL_TRUE;
+}
+
 MufShaderProgram mufGLCreateShaderProgram(const MufShaderProgramCreateInfo *info) {
     GLuint programId = glCreateProgram();
 
     _MufGLShaderProgram *program = mufAlloc(_MufGLShaderProgram, 1);
     program->resourceId = programId;
+    program->linked = GL_TRUE;
 
     for (muf_index i = 0; i < info->shaderCount; ++i) {
         _MufGLShader *shader = mufHandleCastPtr(_MufGLShader, info->shaders[i]);
@@ -1237,7 +1523,6 @@ MufShaderProgram mufGLCreateShaderProgram(const MufShaderProgramCreateInfo *info
         glGetProgramInfoLog(program->resourceId, MUFGL_MAX_SHADER_PROGRAM_INFO_LEN, &infoLength, program->linkInfo);
         mufError("Cannot link shader program: %s", program->linkInfo);
     }
-    program->linked = GL_TRUE;
     return mufMakeHandle(MufShaderProgram, ptr, program);
 }
 
@@ -1247,6 +1532,10 @@ void mufGLDestroyShaderProgram(MufShaderProgram program) {
     mufFree(p);
 }
 
+muf_bool mufGLIsShaderProgramLinked(MufShaderProgram program) {
+    return mufHandleCastPtr(_MufGLShaderProgram, program)->linked == GL_TRUE;
+}
+
 MufResourceHeap mufGLCreateResourceHeap(const MufResourceHeapCreateInfo *info) {
     _MufGLResourceHeap *resourceHeap = mufAlloc(_MufGLResourceHeap, 1);
     resourceHeap->bindingCount = info->bindingCount;
@@ -1292,6 +1581,7 @@ MufRenderPass mufGLCreateRenderPass(const MufRenderPassCreateInfo *info) {
         clearBits |= GL_STENCIL_BUFFER_BIT;
     }
 
+    pass->name = info->name != NULL ? info->name : "RenderPass";
     pass->clearBits = clearBits;
     return mufMakeHandle(MufRenderPass, ptr, pass);
 }
@@ -1682,18 +1972,35 @@ void mufGLCmdGenerateMipmaps(MufTexture texture) {
 
 void mufGLCmdUpdateTexture(MufTexture texture, MufOffset3i offset, MufExtent3i size, muf_crawptr data) {
     _MufGLTexture *t = mufHandleCastPtr(_MufGLTexture, texture);
+    GLuint blockSize = _mufGLGetCompressedBlockSize(t->internalFormat);
     glBindTexture(t->target, t->resourceId);
+
+    if (blockSize != 0) {
+        /* The region must start on a block, the data holds tightly packed 4x4 blocks */
+        GLsizei imageSize = (GLsizei) (((size.width + 3) / 4) * ((size.height + 3) / 4) * blockSize);
+        switch (t->target) {
+            case GL_TEXTURE_2D:
+                glCompressedTexSubImage2D(t->target, 0, offset.x, offset.y, size.width, size.height, t->internalFormat, imageSize, data);
+                break;
+            case GL_TEXTURE_2D_ARRAY:
+                glCompressedTexSubImage3D(t->target, 0, offset.x, offset.y, offset.z, size.width, size.height, size.depth,
+                    t->internalFormat, imageSize * size.depth, data);
+                break;
+        }
+        return;
+    }
+
     switch (t->target) {
         case GL_TEXTURE_1D:
-            glTexSubImage1D(t->target, t->mipLevels, offset.x, size.width, t->format, t->pixelType, data);
+            glTexSubImage1D(t->target, 0, offset.x, size.width, t->format, t->pixelType, data);
             break;
         case GL_TEXTURE_2D:
         case GL_TEXTURE_1D_ARRAY:
-            glTexSubImage2D(t->target, t->mipLevels, offset.x, offset.y, size.width, size.height, t->format, t->pixelType, data);
+            glTexSubImage2D(t->target, 0, offset.x, offset.y, size.width, size.height, t->format, t->pixelType, data);
             break;
         case GL_TEXTURE_3D:
         case GL_TEXTURE_2D_ARRAY:
-            glTexSubImage3D(t->target, t->mipLevels, offset.x, offset.y, offset.z, size.width, size.height, size.depth, t->format, t->pixelType, data);
+            glTexSubImage3D(t->target, 0, offset.x, offset.y, offset.z, size.width, size.height, size.depth, t->format, t->pixelType, data);
             break;
     }
 }
@@ -1896,12 +2203,59 @@ void mufGLCmdBindResourceHeap(MufResourceHeap heap) {
 
 void mufGLCmdBeginRenderPass(MufRenderPass renderPass) {
     _MufGLRenderPass *r = mufHandleCastPtr(_MufGLRenderPass, renderPass);
+    mufGLCmdBeginTimerScope(r->name);
     glClear(r->clearBits);
     _mufGLCache->renderPass = r;
 }
 
 void mufGLCmdEndRenderPass() {
     _mufGLCache->renderPass = NULL;
+    mufGLCmdEndTimerScope();
+}
+
+void mufGLCmdBeginTimerScope(const muf_char *name) {
+    MUF_FASSERT(_mufGLTimers->openDepth < MUFGL_TIMER_QUERY_MAX_DEPTH, "Too many nested timer scopes");
+    if (_mufGLTimers->openDepth >= MUFGL_TIMER_QUERY_MAX_DEPTH)
+        return;
+
+    /* Without mufCmdEndFrame nothing is collected, past the cap the scopes are not timed */
+    muf_usize pendingCount = mufArrayGetSize(_mufGLTimers->pending) - _mufGLTimers->pendingHead;
+    if (!mufProfilerIsEnabled() || pendingCount >= MUFGL_TIMER_QUERY_MAX_PENDING) {
+        _mufGLTimers->openScopes[_mufGLTimers->openDepth++] = _MUFGL_TIMER_SCOPE_DISABLED;
+        return;
+    }
+
+    _MufGLQuery q;
+    q.name = name;
+    q.beginId = _mufGLRequireQueryId();
+    q.endId = _mufGLRequireQueryId();
+    q.frame = _mufGLTimers->frame;
+    q.closed = MUF_FALSE;
+    glQueryCounter(q.beginId, GL_TIMESTAMP);
+
+    _mufGLTimers->openScopes[_mufGLTimers->openDepth++] = mufArrayGetSize(_mufGLTimers->pending);
+    mufArrayPush(_mufGLTimers->pending, &q);
+}
+
+void mufGLCmdEndTimerScope() {
+    MUF_FASSERT(_mufGLTimers->openDepth > 0, "No timer scope to end");
+    if (_mufGLTimers->openDepth == 0)
+        return;
+
+    muf_index index = _mufGLTimers->openScopes[--_mufGLTimers->openDepth];
+    if (index == _MUFGL_TIMER_SCOPE_DISABLED)
+        return;
+
+    _MufGLQuery *q = (_MufGLQuery *) mufArrayGetRef(_mufGLTimers->pending, index);
+    glQueryCounter(q->endId, GL_TIMESTAMP);
+    q->closed = MUF_TRUE;
+}
+
+void mufGLCmdEndFrame() {
+    ++_mufGLTimers->frame;
+    if (_mufGLTimers->frame % MUFGL_TIMER_CALIBRATION_INTERVAL == 0)
+        _mufGLCalibrateTimers();
+    _mufGLCollectTimers();
 }
 
 void mufGLCmdDraw(muf_index firstIndex, muf_index count) {
@@ -1935,9 +2289,11 @@ void mufGLCmdDrawIndexed(muf_index firstIndex, muf_usize count) {
 static void mufGLInit() {
     //_mufGLinitConfig();
     _mufGLInitCache();
+    _mufGLInitTimers();
 }
 
 static void mufGLFinish() {
+    _mufGLFinishTimers();
     _mufGLFinishCache();
 }
 
@@ -1952,12 +2308,15 @@ MufRenderBackendRegistry _glBackendRegistry[1] = {{
         .destroySampler         = mufGLDestroySampler,
         .createTexture          = mufGLCreateTexture,
         .destroyTexture         = mufGLDestroyTexture,
+        .writeTexture           = mufGLWriteTexture,
         .createFramebuffer      = mufGLCreateFramebuffer,
         .destroyFramebuffer     = mufGLDestroyFramebuffer,
         .createShader           = mufGLCreateShader,
         .destroyShader          = mufGLDestroyShader,
+        .isShaderCompiled       = mufGLIsShaderCompiled,
         .createShaderProgram    = mufGLCreateShaderProgram,
         .destroyShaderProgram   = mufGLDestroyShaderProgram,
+        .isShaderProgramLinked  = mufGLIsShaderProgramLinked,
         .createPipeline         = mufGLCreatePipeline,
         .destroyPipeline        = mufGLDestroyPipeline,
         .createRenderPass       = mufGLCreateRenderPass,
@@ -1993,6 +2352,9 @@ MufRenderBackendRegistry _glBackendRegistry[1] = {{
             .bindResourceHeap           = mufGLCmdBindResourceHeap,
             .beginRenderPass            = mufGLCmdBeginRenderPass,
             .endRenderPass              = mufGLCmdEndRenderPass,
+            .beginTimerScope            = mufGLCmdBeginTimerScope,
+            .endTimerScope              = mufGLCmdEndTimerScope,
+            .endFrame                   = mufGLCmdEndFrame,
             .draw                       = mufGLCmdDraw,
             .drawIndexed                = mufGLCmdDrawIndexed
         }
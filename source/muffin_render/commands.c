@@ -114,6 +114,18 @@ void mufCmdEndRenderPass() {
     _MUF_BACKEND_CMD_CALL(endRenderPass);
 }
 
+void mufCmdBeginTimerScope(const muf_char *name) {
+    _MUF_BACKEND_CMD_CALL(beginTimerScope, name);
+}
+
+void mufCmdEndTimerScope() {
+    _MUF_BACKEND_CMD_CALL(endTimerScope);
+}
+
+void mufCmdEndFrame() {
+    _MUF_BACKEND_CMD_CALL(endFrame);
+}
+
 void mufCmdDraw(muf_index firstIndex, muf_usize count) {
     _MUF_BACKEND_CMD_CALL(draw, firstIndex, count);
 }
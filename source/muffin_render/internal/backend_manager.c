@@ -1,3 +1,5 @@
+#define MUF_MEMORY_TAG MUF_MEMORY_TAG_RENDER_BACKEND
+
 #include "backend_manager.h"
 
 #include "muffin_core/memory.h"
@@ -1,6 +1,9 @@
 #include "muffin_render/resources.h"
 
 #include "internal/backend_manager.h"
+#include "muffin_core/math.h"
+#include "muffin_core/memory.h"
+#include "muffin_render/commands.h"
 
 extern _MufRenderBackendManager *_mufRenderBackendManager;
 
@@ -31,6 +34,51 @@ void mufDestroyTexture(MufTexture texture) {
     _MUF_BACKEND_CHECK_CALL(destroyTexture, texture);
 }
 
+void mufWriteTexture(MufTexture texture, muf_u32 mipLevel, muf_crawptr data, muf_usize rowPitch) {
+    _MUF_BACKEND_CHECK_CALL(writeTexture, texture, mipLevel, data, rowPitch);
+}
+
+MUF_INTERNAL MufTexture _mufCreateTexture2D(const MufImage *image, muf_u32 mipLevels) {
+    MufTextureCreateInfo info;
+    mufMemFill(&info, 0, sizeof(MufTextureCreateInfo));
+    info.type = MUF_TEXTURE_TYPE_2D;
+    info.flags = MUF_TEXTURE_FLAGS_NONE;
+    info.accessFlags = MUF_ACCESS_FLAGS_READ;
+    info.width = image->width;
+    info.height = image->height;
+    info.depth = 1;
+    info.arrayLayerCount = 1;
+    info.format = image->format;
+    info.mipLevels = mipLevels;
+    info.sampleCount = MUF_SAMPLE_COUNT_1;
+    return _MUF_BACKEND_CALL(createTexture, &info);
+}
+
+MufTexture mufCreateTextureFromImage(const MufImage *image, muf_u32 mipLevels) {
+    _MUF_CHECK_BACKEND();
+    /* Block compressed levels cannot be generated by the GPU, they come from mufCreateTextureFromMipChain */
+    if (mufGetFormatBlockSize(image->format) != 0)
+        mipLevels = 1;
+    else if (mipLevels == 0)
+        mipLevels = mufGetMipLevelCount(image->width, image->height);
+
+    MufTexture texture = _mufCreateTexture2D(image, mipLevels);
+    _MUF_BACKEND_CALL(writeTexture, texture, 0, image->data, image->rowPitch);
+    if (mipLevels > 1)
+        mufCmdGenerateMipmaps(texture);
+    return texture;
+}
+
+MufTexture mufCreateTextureFromMipChain(const MufMipChain *chain) {
+    _MUF_CHECK_BACKEND();
+    MufTexture texture = _mufCreateTexture2D(&chain->levels[0], chain->levelCount);
+    for (muf_u32 i = chain->levelCount; i-- > 0; ) {
+        const MufImage *level = &chain->levels[i];
+        _MUF_BACKEND_CALL(writeTexture, texture, i, level->data, level->rowPitch);
+    }
+    return texture;
+}
+
 MufSampler mufCreateSampler(const MufSamplerCreateInfo *info) {
     _MUF_CHECK_BACKEND();
     return _MUF_BACKEND_CALL(createSampler, info);
@@ -49,6 +97,11 @@ void mufDestroyShader(MufShader shader) {
     _MUF_BACKEND_CHECK_CALL(destroyShader, shader);
 }
 
+muf_bool mufIsShaderCompiled(MufShader shader) {
+    _MUF_CHECK_BACKEND();
+    return _MUF_BACKEND_CALL(isShaderCompiled, shader);
+}
+
 MufShaderProgram mufCreateShaderProgram(const MufShaderProgramCreateInfo *info) {
     _MUF_CHECK_BACKEND();
     return _MUF_BACKEND_CALL(createShaderProgram, info);
@@ -58,6 +111,11 @@ void mufDestroyShaderProgram(MufShaderProgram program) {
     _MUF_BACKEND_CHECK_CALL(destroyShaderProgram, program);
 }
 
+muf_bool mufIsShaderProgramLinked(MufShaderProgram program) {
+    _MUF_CHECK_BACKEND();
+    return _MUF_BACKEND_CALL(isShaderProgramLinked, program);
+}
+
 MufFramebuffer mufCreateFramebuffer(const MufFramebufferCreateInfo *info) {
     _MUF_CHECK_BACKEND();
     return _MUF_BACKEND_CALL(createFramebuffer, info);
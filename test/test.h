@@ -0,0 +1,42 @@
+#ifndef _MUFFIN_TEST_TEST_H_
+#define _MUFFIN_TEST_TEST_H_
+
+/*
+ * Every test is a program of its own, registered with ctest. A failed check is reported and counted,
+ * the program exits with MUF_TEST_RESULT() so ctest sees the failure.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "muffin_core/common.h"
+
+/* ctest reports the test as skipped for this exit code, see SKIP_RETURN_CODE in CMakeLists.txt */
+#define MUF_TEST_SKIPPED 77
+
+/* Only the first failures are printed, a broken kernel fails every iteration */
+#define MUF_TEST_MAX_REPORTS 16
+
+static muf_u32 _mufTestFailureCount = 0;
+
+#define MUF_TEST_CHECK(_cond, ...) do { \
+        if (!(_cond)) { \
+            if (_mufTestFailureCount++ < MUF_TEST_MAX_REPORTS) { \
+                fprintf(stderr, "%s:%d: check failed: ", __FILE__, __LINE__); \
+                fprintf(stderr, __VA_ARGS__); \
+                fputc('\n', stderr); \
+            } \
+        } \
+    } while (0)
+
+#define MUF_TEST_RESULT() (_mufTestFailureCount == 0 ? 0 : 1)
+
+/**
+ * @brief Compare a value with its reference, the tolerance is absolute below `scale` and relative above it
+ */
+static MUF_INLINE muf_bool mufTestNear(muf_f64 value, muf_f64 reference, muf_f64 tolerance, muf_f64 scale) {
+    muf_f64 magnitude = fabs(reference) > scale ? fabs(reference) : scale;
+    return fabs(value - reference) <= tolerance * magnitude;
+}
+
+#endif
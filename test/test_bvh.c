@@ -0,0 +1,219 @@
+/*
+ * Comparison of the raycast and frustum queries of bvh.h with brute-force loops over every primitive.
+ * The scenes include the degenerate ones the binning has to survive: shared centroids and centroids spread
+ * over denormal distances.
+ */
+
+#include "test.h"
+
+#include <float.h>
+#include <stdlib.h>
+
+#include "muffin_core/bvh.h"
+#include "muffin_core/memory.h"
+#include "muffin_core/random.h"
+
+#define MUF_TEST_MAX_COUNT      300
+#define MUF_TEST_QUERY_COUNT    200
+#define MUF_TEST_TOLERANCE      1e-4
+
+typedef enum _MufTestScene_e {
+    _MUF_TEST_SCENE_SCATTERED,
+    /* Every box has the same centroid */
+    _MUF_TEST_SCENE_STACKED,
+    /* The centroids differ by denormal amounts along x */
+    _MUF_TEST_SCENE_DENORMAL,
+    /* A few far clusters of tiny boxes */
+    _MUF_TEST_SCENE_CLUSTERED,
+    _MUF_TEST_SCENE_COUNT
+} _MufTestScene;
+
+static MufXoshiro256 _generator[1];
+
+static muf_f32 _mufTestRandom(muf_f32 minValue, muf_f32 maxValue) {
+    return minValue + (maxValue - minValue) * mufXoshiro256NextF32(_generator);
+}
+
+static MufVec3 _mufTestRandomVec3(muf_f32 minValue, muf_f32 maxValue) {
+    return mufCreateVec3(_mufTestRandom(minValue, maxValue), _mufTestRandom(minValue, maxValue), _mufTestRandom(minValue, maxValue));
+}
+
+static MufAABB3 _mufTestBox(MufVec3 center, MufVec3 extent) {
+    MufAABB3 box;
+    box.min = mufCreateVec3(center.x - extent.x, center.y - extent.y, center.z - extent.z);
+    box.max = mufCreateVec3(center.x + extent.x, center.y + extent.y, center.z + extent.z);
+    return box;
+}
+
+static void _mufTestFillScene(_MufTestScene scene, MufAABB3 *bounds, muf_u32 count) {
+    for (muf_u32 i = 0; i < count; ++i) {
+        switch (scene) {
+        case _MUF_TEST_SCENE_SCATTERED:
+            bounds[i] = _mufTestBox(_mufTestRandomVec3(-20.0F, 20.0F), _mufTestRandomVec3(0.0F, 2.0F));
+            break;
+        case _MUF_TEST_SCENE_STACKED:
+            bounds[i] = _mufTestBox(mufCreateVec3(1.0F, 2.0F, 3.0F), _mufTestRandomVec3(0.0F, 4.0F));
+            break;
+        case _MUF_TEST_SCENE_DENORMAL:
+            bounds[i].min = mufCreateVec3((muf_f32) i * FLT_MIN * 1e-3F, -1.0F, -1.0F);
+            bounds[i].max = mufCreateVec3((muf_f32) i * FLT_MIN * 1e-3F, 1.0F, 1.0F);
+            break;
+        default: {
+            MufVec3 cluster = mufCreateVec3((muf_f32) (i % 4) * 10.0F, (muf_f32) (i % 3) * -7.0F, 5.0F);
+            MufVec3 offset = _mufTestRandomVec3(-1e-3F, 1e-3F);
+            bounds[i] = _mufTestBox(mufCreateVec3(cluster.x + offset.x, cluster.y + offset.y, cluster.z + offset.z),
+                _mufTestRandomVec3(0.0F, 1e-3F));
+            break;
+        }
+        }
+    }
+}
+
+/* The slab test in double precision, -1 for a miss, a ray grazing the box within the tolerance is ambiguous */
+static muf_f64 _mufTestRayAABB3(const MufRay *ray, const MufAABB3 *box, muf_f64 tMax, muf_bool *ambiguous) {
+    muf_f64 tNear = 0.0, tFar = tMax;
+    const muf_f32 *origin = &ray->origin.x, *direction = &ray->direction.x;
+    const muf_f32 *min = &box->min.x, *max = &box->max.x;
+    for (muf_u32 k = 0; k < 3; ++k) {
+        muf_f64 t0 = (min[k] - origin[k]) / (muf_f64) direction[k];
+        muf_f64 t1 = (max[k] - origin[k]) / (muf_f64) direction[k];
+        tNear = fmax(tNear, fmin(t0, t1));
+        tFar = fmin(tFar, fmax(t0, t1));
+    }
+    if (fabs(tNear - tFar) < MUF_TEST_TOLERANCE)
+        *ambiguous = MUF_TRUE;
+    return tNear <= tFar ? tNear : -1.0;
+}
+
+static void _mufTestRaycast(const MufBvh *bvh, const MufAABB3 *bounds, muf_u32 count, const char *name) {
+    for (muf_u32 q = 0; q < MUF_TEST_QUERY_COUNT; ++q) {
+        MufRay ray;
+        ray.origin = _mufTestRandomVec3(-30.0F, 30.0F);
+        /* Aim at a primitive half of the time, random rays mostly miss the small scenes */
+        if (count > 0 && q % 2 == 0) {
+            const MufAABB3 *target = &bounds[q % count];
+            ray.direction = mufCreateVec3((target->min.x + target->max.x) * 0.5F - ray.origin.x,
+                (target->min.y + target->max.y) * 0.5F - ray.origin.y, (target->min.z + target->max.z) * 0.5F - ray.origin.z);
+        } else {
+            ray.direction = _mufTestRandomVec3(-1.0F, 1.0F);
+        }
+        muf_f32 tMax = q % 3 == 0 ? 0.5F : 100.0F;
+
+        muf_bool ambiguous = MUF_FALSE;
+        muf_f64 expected = -1.0;
+        for (muf_u32 i = 0; i < count; ++i) {
+            muf_f64 t = _mufTestRayAABB3(&ray, &bounds[i], tMax, &ambiguous);
+            if (t >= 0.0 && (expected < 0.0 || t < expected))
+                expected = t;
+        }
+        if (ambiguous)
+            continue;
+
+        muf_f32 t = -1.0F;
+        muf_u32 hit = mufBvhRaycast(bvh, &ray, tMax, NULL, NULL, &t);
+        MUF_TEST_CHECK((hit != MUF_BVH_INVALID_INDEX) == (expected >= 0.0), "mufBvhRaycast, %s, count %u, ray %u: hit %u, expected %s",
+            name, count, q, hit, expected >= 0.0 ? "a hit" : "a miss");
+        if (hit == MUF_BVH_INVALID_INDEX || expected < 0.0)
+            continue;
+        /* Several boxes may be entered at the same distance, any of them is the closest */
+        muf_bool hitAmbiguous = MUF_FALSE;
+        muf_f64 hitT = _mufTestRayAABB3(&ray, &bounds[hit], tMax, &hitAmbiguous);
+        MUF_TEST_CHECK(hit < count && mufTestNear(hitT, expected, MUF_TEST_TOLERANCE, 1.0) && mufTestNear(t, expected, MUF_TEST_TOLERANCE, 1.0),
+            "mufBvhRaycast, %s, count %u, ray %u: primitive %u at %g, expected %g", name, count, q, hit, t, expected);
+    }
+}
+
+/* The distance of the box to the outside of the frustum, negative when it is outside of a plane */
+static muf_f64 _mufTestFrustumSeparation(const MufFrustum *frustum, const MufAABB3 *box) {
+    muf_f64 separation = INFINITY;
+    for (muf_u32 i = 0; i < _MUF_FRUSTUM_PLANE_COUNT_; ++i) {
+        MufVec4 p = frustum->planes[i];
+        muf_f64 farthest = (p.x > 0.0F ? box->max.x : box->min.x) * (muf_f64) p.x
+            + (p.y > 0.0F ? box->max.y : box->min.y) * (muf_f64) p.y + (p.z > 0.0F ? box->max.z : box->min.z) * (muf_f64) p.z + p.w;
+        separation = farthest < separation ? farthest : separation;
+    }
+    return separation;
+}
+
+static void _mufTestQueryFrustum(const MufBvh *bvh, const MufAABB3 *bounds, muf_u32 count, const char *name) {
+    MufArray *indices = mufCreateArray(muf_u32);
+    muf_u8 *found = mufAlloc(muf_u8, count + 1);
+    for (muf_u32 q = 0; q < MUF_TEST_QUERY_COUNT; ++q) {
+        MufFrustum frustum;
+        MufVec3 center = _mufTestRandomVec3(-20.0F, 20.0F);
+        for (muf_u32 i = 0; i < _MUF_FRUSTUM_PLANE_COUNT_; ++i) {
+            MufVec3 n = _mufTestRandomVec3(-1.0F, 1.0F);
+            muf_f64 length = sqrt((muf_f64) n.x * n.x + (muf_f64) n.y * n.y + (muf_f64) n.z * n.z);
+            if (length < 0.1) {
+                n = mufCreateVec3(1.0F, 0.0F, 0.0F);
+                length = 1.0;
+            }
+            n = mufCreateVec3((muf_f32) (n.x / length), (muf_f32) (n.y / length), (muf_f32) (n.z / length));
+            muf_f32 d = _mufTestRandom(1.0F, 25.0F) - (n.x * center.x + n.y * center.y + n.z * center.z);
+            frustum.planes[i] = mufCreateVec4(n.x, n.y, n.z, d);
+        }
+
+        mufArrayClear(indices);
+        /* The query appends, the existing content must be kept */
+        muf_u32 marker = 0xABCDEF;
+        mufArrayPush(indices, &marker);
+        muf_usize appended = mufBvhQueryFrustum(bvh, &frustum, indices);
+        MUF_TEST_CHECK(appended + 1 == mufArrayGetSize(indices) && *(const muf_u32 *) mufArrayGetCRef(indices, 0) == marker,
+            "mufBvhQueryFrustum, %s, count %u, query %u: %u appended to 1, size %u", name, count, q,
+            (unsigned) appended, (unsigned) mufArrayGetSize(indices));
+
+        for (muf_u32 i = 0; i < count; ++i)
+            found[i] = 0;
+        for (muf_usize j = 1; j < mufArrayGetSize(indices); ++j) {
+            muf_u32 index = *(const muf_u32 *) mufArrayGetCRef(indices, j);
+            MUF_TEST_CHECK(index < count && found[index] == 0, "mufBvhQueryFrustum, %s, count %u, query %u: index %u reported twice or invalid",
+                name, count, q, index);
+            if (index < count)
+                found[index] = 1;
+        }
+        for (muf_u32 i = 0; i < count; ++i) {
+            muf_f64 separation = _mufTestFrustumSeparation(&frustum, &bounds[i]);
+            if (fabs(separation) < MUF_TEST_TOLERANCE)
+                continue;
+            MUF_TEST_CHECK(found[i] == (separation > 0.0), "mufBvhQueryFrustum, %s, count %u, query %u: primitive %u %s, separation %g",
+                name, count, q, i, found[i] ? "reported" : "missed", separation);
+        }
+    }
+    mufFree(found);
+    mufDestroyArray(indices);
+}
+
+static void _mufTestScene(_MufTestScene scene, muf_u32 count) {
+    static const char *const names[_MUF_TEST_SCENE_COUNT] = { "scattered", "stacked", "denormal", "clustered" };
+    MufAABB3 *bounds = mufAlloc(MufAABB3, count + 1);
+    _mufTestFillScene(scene, bounds, count);
+
+    MufBvh *bvh = mufCreateBvh(bounds, count);
+    MUF_TEST_CHECK(mufBvhGetNodeCount(bvh) >= 1 && mufBvhGetNodeCount(bvh) <= (count > 0 ? count * 2 - 1 : 1),
+        "mufCreateBvh, %s, count %u: %u nodes", names[scene], count, mufBvhGetNodeCount(bvh));
+    _mufTestRaycast(bvh, bounds, count, names[scene]);
+    _mufTestQueryFrustum(bvh, bounds, count, names[scene]);
+
+    /* Refitting keeps the topology, the queries must follow the moved boxes */
+    for (muf_u32 i = 0; i < count; ++i) {
+        MufVec3 offset = _mufTestRandomVec3(-3.0F, 3.0F);
+        bounds[i].min = mufCreateVec3(bounds[i].min.x + offset.x, bounds[i].min.y + offset.y, bounds[i].min.z + offset.z);
+        bounds[i].max = mufCreateVec3(bounds[i].max.x + offset.x, bounds[i].max.y + offset.y, bounds[i].max.z + offset.z);
+    }
+    mufBvhRefit(bvh, bounds);
+    _mufTestRaycast(bvh, bounds, count, names[scene]);
+    _mufTestQueryFrustum(bvh, bounds, count, names[scene]);
+
+    mufDestroyBvh(bvh);
+    mufFree(bounds);
+}
+
+int main(void) {
+    mufInitXoshiro256(_generator, 0x62766821ULL);
+    for (muf_u32 scene = 0; scene < _MUF_TEST_SCENE_COUNT; ++scene) {
+        for (muf_u32 count = 0; count <= 16; ++count)
+            _mufTestScene((_MufTestScene) scene, count);
+        _mufTestScene((_MufTestScene) scene, MUF_TEST_MAX_COUNT);
+    }
+    return MUF_TEST_RESULT();
+}
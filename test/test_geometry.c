@@ -0,0 +1,209 @@
+/*
+ * Comparison of the culling and ray tests of geometry.h with brute-force references in double precision.
+ * The culling kernels are selected once per process, ctest runs this program once per feature mask:
+ *     test_geometry <mask>
+ * Boxes and spheres that touch a plane within the tolerance may be classified either way and are not checked.
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+
+#include "muffin_core/cpu.h"
+#include "muffin_core/geometry.h"
+#include "muffin_core/memory.h"
+#include "muffin_core/random.h"
+
+#define MUF_TEST_FRUSTUM_COUNT  64
+/* The counts around the vector widths exercise the tails of every variant */
+#define MUF_TEST_MAX_COUNT      67
+#define MUF_TEST_RAY_COUNT      2000
+#define MUF_TEST_TOLERANCE      1e-4
+
+static MufXoshiro256 _generator[1];
+
+static muf_f32 _mufTestRandom(muf_f32 minValue, muf_f32 maxValue) {
+    return minValue + (maxValue - minValue) * mufXoshiro256NextF32(_generator);
+}
+
+static MufVec3 _mufTestRandomVec3(muf_f32 minValue, muf_f32 maxValue) {
+    return mufCreateVec3(_mufTestRandom(minValue, maxValue), _mufTestRandom(minValue, maxValue), _mufTestRandom(minValue, maxValue));
+}
+
+/* Inward planes around the origin, a convex region like a frustum but in any orientation */
+static void _mufTestFillFrustum(MufFrustum *frustum) {
+    for (muf_u32 i = 0; i < _MUF_FRUSTUM_PLANE_COUNT_; ++i) {
+        MufVec3 n;
+        muf_f64 length;
+        do {
+            n = _mufTestRandomVec3(-1.0F, 1.0F);
+            length = sqrt((muf_f64) n.x * n.x + (muf_f64) n.y * n.y + (muf_f64) n.z * n.z);
+        } while (length < 0.1);
+        frustum->planes[i] = mufCreateVec4((muf_f32) (n.x / length), (muf_f32) (n.y / length), (muf_f32) (n.z / length),
+            _mufTestRandom(1.0F, 10.0F));
+    }
+}
+
+static void _mufTestFillAABB3(MufAABB3 *bounds, muf_usize count) {
+    for (muf_usize i = 0; i < count; ++i) {
+        MufVec3 center = _mufTestRandomVec3(-15.0F, 15.0F);
+        MufVec3 extent = _mufTestRandomVec3(0.0F, 4.0F);
+        bounds[i].min = mufCreateVec3(center.x - extent.x, center.y - extent.y, center.z - extent.z);
+        bounds[i].max = mufCreateVec3(center.x + extent.x, center.y + extent.y, center.z + extent.z);
+    }
+}
+
+static muf_f64 _mufTestPlaneDistance(MufVec4 plane, muf_f64 x, muf_f64 y, muf_f64 z) {
+    return plane.x * x + plane.y * y + plane.z * z + plane.w;
+}
+
+/*
+ * Classify from the eight corners, -1 when a corner lies on a plane within the tolerance.
+ * A box is outside when it is outside one of the planes, like the tests of geometry.h.
+ */
+static muf_i32 _mufTestClassifyAABB3(const MufFrustum *frustum, const MufAABB3 *box) {
+    muf_bool inside = MUF_TRUE;
+    for (muf_u32 i = 0; i < _MUF_FRUSTUM_PLANE_COUNT_; ++i) {
+        muf_f64 nearest = INFINITY, farthest = -INFINITY;
+        for (muf_u32 corner = 0; corner < 8; ++corner) {
+            muf_f64 distance = _mufTestPlaneDistance(frustum->planes[i], corner & 1 ? box->max.x : box->min.x,
+                corner & 2 ? box->max.y : box->min.y, corner & 4 ? box->max.z : box->min.z);
+            nearest = distance < nearest ? distance : nearest;
+            farthest = distance > farthest ? distance : farthest;
+        }
+        if (fabs(nearest) < MUF_TEST_TOLERANCE || fabs(farthest) < MUF_TEST_TOLERANCE)
+            return -1;
+        if (farthest < 0.0)
+            return MUF_CULL_RESULT_OUTSIDE;
+        if (nearest < 0.0)
+            inside = MUF_FALSE;
+    }
+    return inside ? MUF_CULL_RESULT_INSIDE : MUF_CULL_RESULT_INTERSECT;
+}
+
+static muf_i32 _mufTestClassifySphere(const MufFrustum *frustum, const MufSphere *sphere) {
+    muf_bool inside = MUF_TRUE;
+    for (muf_u32 i = 0; i < _MUF_FRUSTUM_PLANE_COUNT_; ++i) {
+        muf_f64 distance = _mufTestPlaneDistance(frustum->planes[i], sphere->center.x, sphere->center.y, sphere->center.z);
+        if (fabs(distance + sphere->radius) < MUF_TEST_TOLERANCE || fabs(distance - sphere->radius) < MUF_TEST_TOLERANCE)
+            return -1;
+        if (distance < -sphere->radius)
+            return MUF_CULL_RESULT_OUTSIDE;
+        if (distance < sphere->radius)
+            inside = MUF_FALSE;
+    }
+    return inside ? MUF_CULL_RESULT_INSIDE : MUF_CULL_RESULT_INTERSECT;
+}
+
+static void _mufTestCulling(const MufFrustum *frustum, muf_usize count) {
+    MufAABB3 *bounds = mufAlloc(MufAABB3, count + 1);
+    MufSphere *spheres = mufAlloc(MufSphere, count + 1);
+    muf_u8 *results = mufAlloc(muf_u8, count + 1);
+
+    _mufTestFillAABB3(bounds, count);
+    muf_usize visible = 0;
+    for (muf_usize i = 0; i < count; ++i) {
+        muf_i32 expected = _mufTestClassifyAABB3(frustum, &bounds[i]);
+        MufCullResult result = mufFrustumTestAABB3(frustum, bounds[i]);
+        MUF_TEST_CHECK(expected < 0 || (muf_i32) result == expected, "mufFrustumTestAABB3, count %u, index %u: %d, expected %d",
+            (unsigned) count, (unsigned) i, (int) result, (int) expected);
+        visible += result != MUF_CULL_RESULT_OUTSIDE;
+    }
+    results[count] = 0xFF;
+    muf_usize batchVisible = mufFrustumCullAABB3Batch(frustum, bounds, count, results);
+    MUF_TEST_CHECK(batchVisible == visible, "mufFrustumCullAABB3Batch, count %u: %u visible, expected %u",
+        (unsigned) count, (unsigned) batchVisible, (unsigned) visible);
+    MUF_TEST_CHECK(results[count] == 0xFF, "mufFrustumCullAABB3Batch, count %u: wrote past the results", (unsigned) count);
+    for (muf_usize i = 0; i < count; ++i) {
+        MufCullResult expected = mufFrustumTestAABB3(frustum, bounds[i]);
+        MUF_TEST_CHECK(results[i] == expected, "mufFrustumCullAABB3Batch, count %u, index %u: %d, expected %d",
+            (unsigned) count, (unsigned) i, (int) results[i], (int) expected);
+    }
+
+    visible = 0;
+    for (muf_usize i = 0; i < count; ++i) {
+        spheres[i].center = _mufTestRandomVec3(-15.0F, 15.0F);
+        spheres[i].radius = _mufTestRandom(0.0F, 4.0F);
+        muf_i32 expected = _mufTestClassifySphere(frustum, &spheres[i]);
+        MufCullResult result = mufFrustumTestSphere(frustum, spheres[i]);
+        MUF_TEST_CHECK(expected < 0 || (muf_i32) result == expected, "mufFrustumTestSphere, count %u, index %u: %d, expected %d",
+            (unsigned) count, (unsigned) i, (int) result, (int) expected);
+        visible += result != MUF_CULL_RESULT_OUTSIDE;
+    }
+    results[count] = 0xFF;
+    batchVisible = mufFrustumCullSphereBatch(frustum, spheres, count, results);
+    MUF_TEST_CHECK(batchVisible == visible, "mufFrustumCullSphereBatch, count %u: %u visible, expected %u",
+        (unsigned) count, (unsigned) batchVisible, (unsigned) visible);
+    MUF_TEST_CHECK(results[count] == 0xFF, "mufFrustumCullSphereBatch, count %u: wrote past the results", (unsigned) count);
+    for (muf_usize i = 0; i < count; ++i) {
+        MufCullResult expected = mufFrustumTestSphere(frustum, spheres[i]);
+        MUF_TEST_CHECK(results[i] == expected, "mufFrustumCullSphereBatch, count %u, index %u: %d, expected %d",
+            (unsigned) count, (unsigned) i, (int) results[i], (int) expected);
+    }
+
+    mufFree(bounds);
+    mufFree(spheres);
+    mufFree(results);
+}
+
+/* The entry distance along the ray, negative for a miss, a ray grazing the box within the tolerance is ambiguous */
+static muf_f64 _mufTestRayAABB3(const MufRay *ray, const MufAABB3 *box, muf_f64 tMax, muf_bool *ambiguous) {
+    muf_f64 tNear = 0.0, tFar = tMax;
+    const muf_f32 *origin = &ray->origin.x, *direction = &ray->direction.x;
+    const muf_f32 *min = &box->min.x, *max = &box->max.x;
+    for (muf_u32 k = 0; k < 3; ++k) {
+        if (direction[k] == 0.0F) {
+            if (origin[k] < min[k] || origin[k] > max[k])
+                return -1.0;
+            continue;
+        }
+        muf_f64 t0 = (min[k] - origin[k]) / (muf_f64) direction[k];
+        muf_f64 t1 = (max[k] - origin[k]) / (muf_f64) direction[k];
+        tNear = fmax(tNear, fmin(t0, t1));
+        tFar = fmin(tFar, fmax(t0, t1));
+    }
+    *ambiguous = fabs(tNear - tFar) < MUF_TEST_TOLERANCE;
+    return tNear <= tFar ? tNear : -1.0;
+}
+
+static void _mufTestRays(void) {
+    for (muf_u32 r = 0; r < MUF_TEST_RAY_COUNT; ++r) {
+        MufAABB3 box;
+        _mufTestFillAABB3(&box, 1);
+        MufRay ray;
+        ray.origin = _mufTestRandomVec3(-20.0F, 20.0F);
+        ray.direction = _mufTestRandomVec3(-1.0F, 1.0F);
+        /* Axis-aligned rays take the infinite slabs */
+        if (r % 4 == 0)
+            (&ray.direction.x)[r % 3] = 0.0F;
+        muf_f32 tMax = _mufTestRandom(1.0F, 100.0F);
+
+        muf_bool ambiguous = MUF_FALSE;
+        muf_f64 expected = _mufTestRayAABB3(&ray, &box, tMax, &ambiguous);
+        muf_f32 t = -1.0F;
+        muf_bool hit = mufRayIntersectAABB3(&ray, box, tMax, &t);
+        if (ambiguous)
+            continue;
+        MUF_TEST_CHECK(hit == (expected >= 0.0), "mufRayIntersectAABB3, ray %u: %d, expected %d", r, (int) hit, (int) (expected >= 0.0));
+        MUF_TEST_CHECK(!hit || expected < 0.0 || mufTestNear(t, expected, MUF_TEST_TOLERANCE, 1.0),
+            "mufRayIntersectAABB3, ray %u: t %g, expected %g", r, t, expected);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <feature mask>\n", argv[0]);
+        return 1;
+    }
+    mufSetCpuFeatureMask((MufCpuFeatureFlags) strtoul(argv[1], NULL, 0));
+
+    mufInitXoshiro256(_generator, 0x67656F6DULL);
+    for (muf_u32 f = 0; f < MUF_TEST_FRUSTUM_COUNT; ++f) {
+        MufFrustum frustum;
+        _mufTestFillFrustum(&frustum);
+        for (muf_usize count = 0; count <= MUF_TEST_MAX_COUNT; ++count)
+            _mufTestCulling(&frustum, count);
+    }
+    _mufTestRays();
+    return MUF_TEST_RESULT();
+}
@@ -0,0 +1,109 @@
+/*
+ * Comparison of the streaming hasher of hash.h with mufHashBytes64 over the same bytes given in random pieces.
+ * The stripe kernels are selected once per process, ctest runs this program once per feature mask:
+ *     test_hash <mask>
+ * Every variant must give the same digests, they are folded into a value checked against the one of the scalar code.
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "muffin_core/cpu.h"
+#include "muffin_core/hash.h"
+#include "muffin_core/math.h"
+#include "muffin_core/random.h"
+
+/* Every length around the short path and the first blocks, then a few larger ones */
+#define MUF_TEST_DENSE_LENGTH   1100
+#define MUF_TEST_MAX_LENGTH     9000
+#define MUF_TEST_SPLIT_COUNT    4
+/* The fold of the digests of the fixed inputs, it changes with the hash and with the on-disk slots of the packs */
+#define MUF_TEST_REFERENCE_FOLD 0x2FBA5046D3A4A888ULL
+
+static MufXoshiro256 _generator[1];
+static muf_byte _data[MUF_TEST_MAX_LENGTH + 8];
+
+static muf_usize _mufTestRandomIndex(muf_usize count) {
+    return count == 0 ? 0 : (muf_usize) (mufXoshiro256Next(_generator) % count);
+}
+
+/* Feed the bytes in random pieces, some empty, and check the digest of every prefix on the way */
+static void _mufTestStreaming(const muf_byte *data, muf_usize length, muf_u64 seed, muf_u64 expected) {
+    MufHasher hasher;
+    mufInitHasher(&hasher, seed);
+    muf_usize offset = 0;
+    while (offset < length) {
+        /* Mostly small pieces that stay in the buffer, sometimes ones that cross several blocks */
+        muf_usize piece = _mufTestRandomIndex(4) == 0 ? _mufTestRandomIndex(length - offset + 1) : _mufTestRandomIndex(80);
+        piece = mufMin(piece, length - offset);
+        mufHasherUpdate(&hasher, data + offset, piece);
+        offset += piece;
+
+        muf_u64 digest = mufHasherDigest(&hasher);
+        muf_u64 prefix = mufHashBytes64(data, offset, seed);
+        MUF_TEST_CHECK(digest == prefix, "mufHasherDigest, length %u of %u: %016llx, expected %016llx",
+            (unsigned) offset, (unsigned) length, (unsigned long long) digest, (unsigned long long) prefix);
+    }
+    muf_u64 digest = mufHasherDigest(&hasher);
+    MUF_TEST_CHECK(digest == expected, "mufHasherDigest, length %u: %016llx, expected %016llx",
+        (unsigned) length, (unsigned long long) digest, (unsigned long long) expected);
+}
+
+static void _mufTestByteByByte(const muf_byte *data, muf_usize length, muf_u64 seed, muf_u64 expected) {
+    MufHasher hasher;
+    mufInitHasher(&hasher, seed);
+    for (muf_usize i = 0; i < length; ++i)
+        mufHasherUpdate(&hasher, data + i, 1);
+    muf_u64 digest = mufHasherDigest(&hasher);
+    MUF_TEST_CHECK(digest == expected, "mufHasherUpdate byte by byte, length %u: %016llx, expected %016llx",
+        (unsigned) length, (unsigned long long) digest, (unsigned long long) expected);
+}
+
+static void _mufTestLength(muf_usize length, muf_u64 seed) {
+    /* The data has no alignment requirement, every offset in a word must give the same hash */
+    muf_u64 expected = mufHashBytes64(_data, length, seed);
+    for (muf_usize shift = 1; shift < 8; ++shift) {
+        memmove(_data + shift, _data + shift - 1, length);
+        muf_u64 shifted = mufHashBytes64(_data + shift, length, seed);
+        MUF_TEST_CHECK(shifted == expected, "mufHashBytes64, length %u at offset %u: %016llx, expected %016llx",
+            (unsigned) length, (unsigned) shift, (unsigned long long) shifted, (unsigned long long) expected);
+    }
+    memmove(_data, _data + 7, length);
+
+    for (muf_u32 split = 0; split < MUF_TEST_SPLIT_COUNT; ++split)
+        _mufTestStreaming(_data, length, seed, expected);
+    if (length <= MUF_TEST_DENSE_LENGTH / 2 || length % 97 == 0)
+        _mufTestByteByByte(_data, length, seed, expected);
+}
+
+/* Fixed inputs independent of the random pieces, only the hash itself decides the fold */
+static muf_u64 _mufTestFold(void) {
+    muf_u64 fold = 0;
+    for (muf_usize i = 0; i < MUF_TEST_MAX_LENGTH; ++i)
+        _data[i] = (muf_byte) (mufHashMix64(i) >> 56);
+    for (muf_usize length = 0; length <= MUF_TEST_MAX_LENGTH; length += length < MUF_TEST_DENSE_LENGTH ? 1 : 61)
+        fold = mufHashMix64(fold ^ mufHashBytes64(_data, length, length * 0x9E3779B97F4A7C15ULL));
+    return fold;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <feature mask>\n", argv[0]);
+        return 1;
+    }
+    mufSetCpuFeatureMask((MufCpuFeatureFlags) strtoul(argv[1], NULL, 0));
+
+    muf_u64 fold = _mufTestFold();
+    MUF_TEST_CHECK(fold == MUF_TEST_REFERENCE_FOLD, "mufHashBytes64: fold %016llx, expected %016llx",
+        (unsigned long long) fold, (unsigned long long) MUF_TEST_REFERENCE_FOLD);
+
+    mufInitXoshiro256(_generator, 0x68617368ULL);
+    for (muf_usize length = 0; length <= MUF_TEST_MAX_LENGTH; length += length < MUF_TEST_DENSE_LENGTH ? 1 : 173) {
+        for (muf_usize i = 0; i < length; ++i)
+            _data[i] = (muf_byte) mufXoshiro256Next(_generator);
+        _mufTestLength(length, length % 3 == 0 ? 0 : mufXoshiro256Next(_generator));
+    }
+    return MUF_TEST_RESULT();
+}
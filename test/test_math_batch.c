@@ -0,0 +1,182 @@
+/*
+ * Comparison of the batch kernels of math_batch.h with scalar loops.
+ * The kernel table is selected once per process, ctest runs this program once per feature mask:
+ *     test_math_batch <mask> <target>
+ * The test is skipped when the CPU cannot run the target the mask is meant to select.
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "muffin_core/cpu.h"
+#include "muffin_core/math_batch.h"
+#include "muffin_core/memory.h"
+#include "muffin_core/random.h"
+
+/* The counts around the vector widths exercise the tails of every variant */
+#define MUF_TEST_MAX_COUNT  67
+#define MUF_TEST_LARGE_COUNT 1000
+#define MUF_TEST_TOLERANCE  1e-5
+
+static MufXoshiro256 _generator[1];
+
+static muf_f32 _mufTestRandom(muf_f32 minValue, muf_f32 maxValue) {
+    return minValue + (maxValue - minValue) * mufXoshiro256NextF32(_generator);
+}
+
+static void _mufTestFillMat4(MufMat4 *mats, muf_usize count) {
+    for (muf_usize i = 0; i < count; ++i) {
+        for (muf_u32 j = 0; j < 4; ++j) {
+            for (muf_u32 k = 0; k < 4; ++k)
+                mats[i].values[j][k] = _mufTestRandom(-2.0F, 2.0F);
+        }
+        /* Affine, the AABB kernels require it */
+        mats[i].values[0][3] = mats[i].values[1][3] = mats[i].values[2][3] = 0.0F;
+        mats[i].values[3][3] = 1.0F;
+    }
+}
+
+static void _mufTestFillVec3(MufVec3 *vecs, muf_usize count) {
+    for (muf_usize i = 0; i < count; ++i)
+        vecs[i] = mufCreateVec3(_mufTestRandom(-10.0F, 10.0F), _mufTestRandom(-10.0F, 10.0F), _mufTestRandom(-10.0F, 10.0F));
+}
+
+static MufVec3 _mufTestTransform(const MufMat4 *transform, MufVec3 v, muf_f32 w) {
+    const muf_f32 (*m)[4] = transform->values;
+    return mufCreateVec3(m[0][0] * v.x + m[1][0] * v.y + m[2][0] * v.z + m[3][0] * w,
+        m[0][1] * v.x + m[1][1] * v.y + m[2][1] * v.z + m[3][1] * w,
+        m[0][2] * v.x + m[1][2] * v.y + m[2][2] * v.z + m[3][2] * w);
+}
+
+/* Transform the eight corners, the box of the results is the box of the transformed box */
+static MufAABB3 _mufTestTransformAABB3(const MufMat4 *transform, const MufAABB3 *bounds) {
+    MufAABB3 result;
+    for (muf_u32 corner = 0; corner < 8; ++corner) {
+        MufVec3 p = mufCreateVec3(corner & 1 ? bounds->max.x : bounds->min.x, corner & 2 ? bounds->max.y : bounds->min.y,
+            corner & 4 ? bounds->max.z : bounds->min.z);
+        MufVec3 q = _mufTestTransform(transform, p, 1.0F);
+        if (corner == 0) {
+            result.min = result.max = q;
+            continue;
+        }
+        result.min = mufCreateVec3(mufMin(result.min.x, q.x), mufMin(result.min.y, q.y), mufMin(result.min.z, q.z));
+        result.max = mufCreateVec3(mufMax(result.max.x, q.x), mufMax(result.max.y, q.y), mufMax(result.max.z, q.z));
+    }
+    return result;
+}
+
+static muf_bool _mufTestVec3Near(MufVec3 value, MufVec3 reference, muf_f64 scale) {
+    return mufTestNear(value.x, reference.x, MUF_TEST_TOLERANCE, scale)
+        && mufTestNear(value.y, reference.y, MUF_TEST_TOLERANCE, scale)
+        && mufTestNear(value.z, reference.z, MUF_TEST_TOLERANCE, scale);
+}
+
+static muf_bool _mufTestMat4Near(const MufMat4 *value, const MufMat4 *reference) {
+    for (muf_u32 i = 0; i < 4; ++i) {
+        for (muf_u32 j = 0; j < 4; ++j) {
+            if (!mufTestNear(value->values[i][j], reference->values[i][j], MUF_TEST_TOLERANCE, 1.0))
+                return MUF_FALSE;
+        }
+    }
+    return MUF_TRUE;
+}
+
+static void _mufTestCount(muf_usize count) {
+    MufMat4 *a = mufAlloc(MufMat4, count);
+    MufMat4 *b = mufAlloc(MufMat4, count);
+    MufMat4 *mats = mufAlloc(MufMat4, count);
+    MufVec3 *vecs = mufAlloc(MufVec3, count);
+    MufVec3 *vecsOut = mufAlloc(MufVec3, count);
+    MufVec3x8 *blocks = mufAlloc(MufVec3x8, (count + 7) / 8);
+    MufAABB3 *bounds = mufAlloc(MufAABB3, count);
+    MufAABB3 *boundsOut = mufAlloc(MufAABB3, count);
+
+    MufMat4 shared;
+    _mufTestFillMat4(&shared, 1);
+    _mufTestFillMat4(a, count);
+    _mufTestFillMat4(b, count);
+    _mufTestFillVec3(vecs, count);
+    for (muf_usize i = 0; i < count; ++i) {
+        MufVec3 center = mufCreateVec3(_mufTestRandom(-10.0F, 10.0F), _mufTestRandom(-10.0F, 10.0F), _mufTestRandom(-10.0F, 10.0F));
+        MufVec3 extent = mufCreateVec3(_mufTestRandom(0.0F, 5.0F), _mufTestRandom(0.0F, 5.0F), _mufTestRandom(0.0F, 5.0F));
+        bounds[i].min = mufCreateVec3(center.x - extent.x, center.y - extent.y, center.z - extent.z);
+        bounds[i].max = mufCreateVec3(center.x + extent.x, center.y + extent.y, center.z + extent.z);
+    }
+
+    mufMat4MulBatch(a, b, mats, count);
+    for (muf_usize i = 0; i < count; ++i) {
+        MufMat4 expected = mufMat4MulRef(&a[i], &b[i]);
+        MUF_TEST_CHECK(_mufTestMat4Near(&mats[i], &expected), "mufMat4MulBatch, count %u, index %u", (unsigned) count, (unsigned) i);
+    }
+
+    mufMat4MulSharedBatch(&shared, b, mats, count);
+    for (muf_usize i = 0; i < count; ++i) {
+        MufMat4 expected = mufMat4MulRef(&shared, &b[i]);
+        MUF_TEST_CHECK(_mufTestMat4Near(&mats[i], &expected), "mufMat4MulSharedBatch, count %u, index %u", (unsigned) count, (unsigned) i);
+    }
+
+    /* The output may be the second input */
+    if (count > 0)
+        memcpy(mats, b, count * sizeof(MufMat4));
+    mufMat4MulBatch(a, mats, mats, count);
+    for (muf_usize i = 0; i < count; ++i) {
+        MufMat4 expected = mufMat4MulRef(&a[i], &b[i]);
+        MUF_TEST_CHECK(_mufTestMat4Near(&mats[i], &expected), "mufMat4MulBatch in place, count %u, index %u", (unsigned) count, (unsigned) i);
+    }
+
+    mufVec3TransformBatch(&shared, vecs, vecsOut, count);
+    for (muf_usize i = 0; i < count; ++i) {
+        MUF_TEST_CHECK(_mufTestVec3Near(vecsOut[i], _mufTestTransform(&shared, vecs[i], 0.0F), 10.0),
+            "mufVec3TransformBatch, count %u, index %u", (unsigned) count, (unsigned) i);
+    }
+
+    mufVec3TransformPointBatch(&shared, vecs, vecsOut, count);
+    for (muf_usize i = 0; i < count; ++i) {
+        MUF_TEST_CHECK(_mufTestVec3Near(vecsOut[i], _mufTestTransform(&shared, vecs[i], 1.0F), 10.0),
+            "mufVec3TransformPointBatch, count %u, index %u", (unsigned) count, (unsigned) i);
+    }
+
+    mufVec3x8Pack(vecs, count, blocks);
+    mufVec3x8TransformPointBatch(&shared, blocks, blocks, (count + 7) / 8);
+    mufVec3x8Unpack(blocks, count, vecsOut);
+    for (muf_usize i = 0; i < count; ++i) {
+        MUF_TEST_CHECK(_mufTestVec3Near(vecsOut[i], _mufTestTransform(&shared, vecs[i], 1.0F), 10.0),
+            "mufVec3x8TransformPointBatch, count %u, index %u", (unsigned) count, (unsigned) i);
+    }
+
+    mufAABB3TransformBatch(a, bounds, boundsOut, count);
+    for (muf_usize i = 0; i < count; ++i) {
+        MufAABB3 expected = _mufTestTransformAABB3(&a[i], &bounds[i]);
+        MUF_TEST_CHECK(_mufTestVec3Near(boundsOut[i].min, expected.min, 10.0)
+            && _mufTestVec3Near(boundsOut[i].max, expected.max, 10.0), "mufAABB3TransformBatch, count %u, index %u", (unsigned) count, (unsigned) i);
+    }
+
+    mufFree(a);
+    mufFree(b);
+    mufFree(mats);
+    mufFree(vecs);
+    mufFree(vecsOut);
+    mufFree(blocks);
+    mufFree(bounds);
+    mufFree(boundsOut);
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <feature mask> <expected target>\n", argv[0]);
+        return 1;
+    }
+    mufSetCpuFeatureMask((MufCpuFeatureFlags) strtoul(argv[1], NULL, 0));
+    if (strcmp(mufGetMathBatchTarget(), argv[2]) != 0) {
+        printf("the %s kernels are not available, %s selected\n", argv[2], mufGetMathBatchTarget());
+        return MUF_TEST_SKIPPED;
+    }
+
+    mufInitXoshiro256(_generator, 0x6D75666669E5ULL);
+    for (muf_usize count = 0; count <= MUF_TEST_MAX_COUNT; ++count)
+        _mufTestCount(count);
+    _mufTestCount(MUF_TEST_LARGE_COUNT);
+    return MUF_TEST_RESULT();
+}
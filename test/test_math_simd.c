@@ -0,0 +1,138 @@
+/*
+ * Randomized comparison of the inline kernels of math_simd.h with the scalar references of math.c.
+ * The kernels are picked at compile time, the AVX build of this file covers the AVX paths.
+ */
+
+#include "test.h"
+
+#include "muffin_core/cpu.h"
+#include "muffin_core/math_simd.h"
+#include "muffin_core/random.h"
+
+#define MUF_TEST_ITERATIONS 100000
+
+/* Reordered sums and fused multiply-adds move the last few bits */
+#define MUF_TEST_MUL_TOLERANCE          1e-5
+/* Cramer's rule cancels more than the cofactor expansion of the reference */
+#define MUF_TEST_DETERMINANT_TOLERANCE  2e-3
+#define MUF_TEST_INVERSE_TOLERANCE      1e-4
+
+static MufXoshiro256 _generator[1];
+
+static muf_f32 _mufTestRandom(muf_f32 minValue, muf_f32 maxValue) {
+    return minValue + (maxValue - minValue) * mufXoshiro256NextF32(_generator);
+}
+
+static MufVec4 _mufTestRandomVec4(void) {
+    return (MufVec4) { _mufTestRandom(-10.0F, 10.0F), _mufTestRandom(-10.0F, 10.0F),
+        _mufTestRandom(-10.0F, 10.0F), _mufTestRandom(-10.0F, 10.0F) };
+}
+
+/* Nearly singular matrices are drawn again, both inverses are meaningless for them */
+static MufMat4 _mufTestRandomMat4(void) {
+    MufMat4 mat;
+    do {
+        for (muf_u32 i = 0; i < 4; ++i) {
+            for (muf_u32 j = 0; j < 4; ++j)
+                mat.values[i][j] = _mufTestRandom(-1.0F, 1.0F);
+        }
+    } while (fabsf(mufMat4DeterminantRef(&mat)) < 0.05F);
+    return mat;
+}
+
+static MufQuat4 _mufTestRandomQuat4(void) {
+    MufVec4 v = _mufTestRandomVec4();
+    return (MufQuat4) { v.x, v.y, v.z, v.w };
+}
+
+static muf_bool _mufTestMat4Near(const MufMat4 *value, const MufMat4 *reference, muf_f64 tolerance, muf_f64 scale) {
+    for (muf_u32 i = 0; i < 4; ++i) {
+        for (muf_u32 j = 0; j < 4; ++j) {
+            if (!mufTestNear(value->values[i][j], reference->values[i][j], tolerance, scale))
+                return MUF_FALSE;
+        }
+    }
+    return MUF_TRUE;
+}
+
+static muf_bool _mufTestVec4Near(MufVec4 value, MufVec4 reference, muf_f64 tolerance, muf_f64 scale) {
+    return mufTestNear(value.x, reference.x, tolerance, scale) && mufTestNear(value.y, reference.y, tolerance, scale)
+        && mufTestNear(value.z, reference.z, tolerance, scale) && mufTestNear(value.w, reference.w, tolerance, scale);
+}
+
+static muf_f64 _mufTestMat4MaxAbs(const MufMat4 *mat) {
+    muf_f64 result = 0.0;
+    for (muf_u32 i = 0; i < 4; ++i) {
+        for (muf_u32 j = 0; j < 4; ++j)
+            result = fabs(mat->values[i][j]) > result ? fabs(mat->values[i][j]) : result;
+    }
+    return result;
+}
+
+static void _mufTestMat4(void) {
+    for (muf_u32 i = 0; i < MUF_TEST_ITERATIONS; ++i) {
+        MufMat4 a = _mufTestRandomMat4();
+        MufMat4 b = _mufTestRandomMat4();
+
+        MufMat4 product = mufMat4Mul(&a, &b);
+        MufMat4 productRef = mufMat4MulRef(&a, &b);
+        MUF_TEST_CHECK(_mufTestMat4Near(&product, &productRef, MUF_TEST_MUL_TOLERANCE, 1.0), "mufMat4Mul, iteration %u", i);
+
+        MufMat4 transposed = mufMat4Transpose(&a);
+        MufMat4 transposedRef = mufMat4TransposeRef(&a);
+        MUF_TEST_CHECK(_mufTestMat4Near(&transposed, &transposedRef, 0.0, 1.0), "mufMat4Transpose, iteration %u", i);
+
+        muf_f32 det = mufMat4Determinant(&a);
+        muf_f32 detRef = mufMat4DeterminantRef(&a);
+        MUF_TEST_CHECK(mufTestNear(det, detRef, MUF_TEST_DETERMINANT_TOLERANCE, 1.0),
+            "mufMat4Determinant, iteration %u: %g, expected %g", i, det, detRef);
+
+        MufMat4 inverse = mufMat4Inverse(&a);
+        MufMat4 inverseRef = mufMat4InverseRef(&a);
+        MUF_TEST_CHECK(_mufTestMat4Near(&inverse, &inverseRef, MUF_TEST_INVERSE_TOLERANCE, _mufTestMat4MaxAbs(&inverseRef)),
+            "mufMat4Inverse, iteration %u", i);
+
+        MufVec4 v = _mufTestRandomVec4();
+        MUF_TEST_CHECK(_mufTestVec4Near(mufMat4MulVec(&a, v), mufMat4MulVecRef(&a, v), MUF_TEST_MUL_TOLERANCE, 10.0),
+            "mufMat4MulVec, iteration %u", i);
+        MUF_TEST_CHECK(_mufTestVec4Near(mufVec4MulMat(v, &a), mufVec4MulMatRef(v, &a), MUF_TEST_MUL_TOLERANCE, 10.0),
+            "mufVec4MulMat, iteration %u", i);
+    }
+}
+
+static void _mufTestQuat4(void) {
+    for (muf_u32 i = 0; i < MUF_TEST_ITERATIONS; ++i) {
+        MufQuat4 a = _mufTestRandomQuat4();
+        MufQuat4 b = _mufTestRandomQuat4();
+
+        MufQuat4 product = mufQuat4Mul(a, b);
+        MufQuat4 productRef = mufQuat4MulRef(a, b);
+        MUF_TEST_CHECK(_mufTestVec4Near((MufVec4) { product.x, product.y, product.z, product.w },
+            (MufVec4) { productRef.x, productRef.y, productRef.z, productRef.w }, MUF_TEST_MUL_TOLERANCE, 100.0),
+            "mufQuat4Mul, iteration %u", i);
+
+        MufQuat4 q = mufQuat4Normalize(a);
+        MufVec3 v = { _mufTestRandom(-10.0F, 10.0F), _mufTestRandom(-10.0F, 10.0F), _mufTestRandom(-10.0F, 10.0F) };
+        MufVec3 rotated = mufQuat4RotateVec3(q, v);
+        MufVec3 rotatedRef = mufQuat4RotateVec3Ref(q, v);
+        MUF_TEST_CHECK(_mufTestVec4Near((MufVec4) { rotated.x, rotated.y, rotated.z, 0.0F },
+            (MufVec4) { rotatedRef.x, rotatedRef.y, rotatedRef.z, 0.0F }, MUF_TEST_MUL_TOLERANCE, 10.0),
+            "mufQuat4RotateVec3, iteration %u", i);
+
+        /* A unit quaternion times its inverse is the identity */
+        MufQuat4 identity = mufQuat4Mul(q, mufQuat4Inverse(q));
+        MUF_TEST_CHECK(_mufTestVec4Near((MufVec4) { identity.x, identity.y, identity.z, identity.w },
+            (MufVec4) { 0.0F, 0.0F, 0.0F, 1.0F }, MUF_TEST_MUL_TOLERANCE, 1.0), "mufQuat4Inverse, iteration %u", i);
+    }
+}
+
+int main(void) {
+#if defined(MUF_SIMD_AVX)
+    if (!mufHasCpuFeatures(MUF_CPU_FEATURE_AVX))
+        return MUF_TEST_SKIPPED;
+#endif
+    mufInitXoshiro256(_generator, 0x6D75666669E5ULL);
+    _mufTestMat4();
+    _mufTestQuat4();
+    return MUF_TEST_RESULT();
+}
@@ -0,0 +1,177 @@
+/*
+ * Checks of the generators of random.h: known sequences, jumps and bounded draws of the scalar generators, and the
+ * bulk fills against the scalar lanes they are made of. The fill kernels are selected once per process, ctest runs
+ * this program once per feature mask:
+ *     test_random <mask>
+ * The fills of every variant are folded into a value checked against the one of the scalar code.
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "muffin_core/cpu.h"
+#include "muffin_core/hash.h"
+#include "muffin_core/random.h"
+
+#define MUF_TEST_MAX_COUNT      67
+#define MUF_TEST_DRAW_COUNT     300000
+#define MUF_TEST_ADVANCE_COUNT  1000
+/* The fold of fixed fills, it only changes with the sequences themselves */
+#define MUF_TEST_REFERENCE_FOLD 0x9EA5EA128A7CC2AFULL
+
+/* Published outputs of the reference implementations */
+static const muf_u64 _splitMix64Zero[] = { 0xE220A8397B1DCDAFULL, 0x6E789E6AA1B965F4ULL, 0x06C45D188009454FULL };
+static const muf_u64 _xoshiro256OneToFour[] = {
+    41943041ULL, 58720359ULL, 3588806011781223ULL, 3591011842654386ULL, 9228616714210784205ULL
+};
+/* seed 42, stream 54 */
+static const muf_u32 _pcg32Demo[] = { 0xA15C02B7U, 0x7B47F409U, 0xBA1D3330U, 0x83D2F293U, 0xBFA4784BU, 0xCBED606EU };
+
+static void _mufTestKnownSequences(void) {
+    MufSplitMix64 splitMix;
+    mufInitSplitMix64(&splitMix, 0);
+    for (muf_u32 i = 0; i < MUF_COUNTOF(_splitMix64Zero); ++i) {
+        muf_u64 value = mufSplitMix64Next(&splitMix);
+        MUF_TEST_CHECK(value == _splitMix64Zero[i], "mufSplitMix64Next, value %u: %016llx, expected %016llx", i,
+            (unsigned long long) value, (unsigned long long) _splitMix64Zero[i]);
+    }
+
+    MufXoshiro256 xoshiro = { { 1, 2, 3, 4 } };
+    for (muf_u32 i = 0; i < MUF_COUNTOF(_xoshiro256OneToFour); ++i) {
+        muf_u64 value = mufXoshiro256Next(&xoshiro);
+        MUF_TEST_CHECK(value == _xoshiro256OneToFour[i], "mufXoshiro256Next, value %u: %llu, expected %llu", i,
+            (unsigned long long) value, (unsigned long long) _xoshiro256OneToFour[i]);
+    }
+
+    MufPcg32 pcg;
+    mufInitPcg32(&pcg, 42, 54);
+    for (muf_u32 i = 0; i < MUF_COUNTOF(_pcg32Demo); ++i) {
+        muf_u32 value = mufPcg32Next(&pcg);
+        MUF_TEST_CHECK(value == _pcg32Demo[i], "mufPcg32Next, value %u: %08x, expected %08x", i, value, _pcg32Demo[i]);
+    }
+}
+
+static void _mufTestAdvance(void) {
+    MufPcg32 stepped, advanced;
+    mufInitPcg32(&stepped, 0x1234, 7);
+    for (muf_u64 delta = 0; delta < MUF_TEST_ADVANCE_COUNT; ++delta) {
+        advanced = stepped;
+        mufPcg32Advance(&advanced, delta);
+        MufPcg32 reference = stepped;
+        for (muf_u64 i = 0; i < delta; ++i)
+            mufPcg32Next(&reference);
+        MUF_TEST_CHECK(advanced.state == reference.state, "mufPcg32Advance, delta %u", (unsigned) delta);
+
+        /* The period is 2^64, going forward by 2^64 - delta comes back to the start */
+        mufPcg32Advance(&advanced, 0ULL - delta);
+        MUF_TEST_CHECK(advanced.state == stepped.state, "mufPcg32Advance, delta %u then back", (unsigned) delta);
+        mufPcg32Next(&stepped);
+    }
+}
+
+/*
+ * With 32 random bits, a bound of 3 * 2^30 makes the low third twice as likely under a modulo. The unbiased draws
+ * land there a third of the time.
+ */
+static void _mufTestBounded(void) {
+    const muf_u32 bound = 0xC0000000U;
+    MufXoshiro256 xoshiro;
+    MufPcg32 pcg;
+    mufInitXoshiro256(&xoshiro, 5);
+    mufInitPcg32(&pcg, 5, 11);
+    muf_u32 xoshiroLow = 0, pcgLow = 0;
+    muf_bool inRange = MUF_TRUE;
+    for (muf_u32 i = 0; i < MUF_TEST_DRAW_COUNT; ++i) {
+        muf_u32 a = mufXoshiro256NextBounded(&xoshiro, bound), b = mufPcg32NextBounded(&pcg, bound);
+        inRange = inRange && a < bound && b < bound;
+        xoshiroLow += a < bound / 3;
+        pcgLow += b < bound / 3;
+    }
+    MUF_TEST_CHECK(inRange, "mufXoshiro256NextBounded, mufPcg32NextBounded: a value is out of range");
+    MUF_TEST_CHECK(fabs(xoshiroLow / (muf_f64) MUF_TEST_DRAW_COUNT - 1.0 / 3.0) < 0.01,
+        "mufXoshiro256NextBounded: %u of %u in the low third", xoshiroLow, (unsigned) MUF_TEST_DRAW_COUNT);
+    MUF_TEST_CHECK(fabs(pcgLow / (muf_f64) MUF_TEST_DRAW_COUNT - 1.0 / 3.0) < 0.01,
+        "mufPcg32NextBounded: %u of %u in the low third", pcgLow, (unsigned) MUF_TEST_DRAW_COUNT);
+
+    /* Small bounds reach every value, the ranges include both ends in either order */
+    muf_u32 seen[7] = { 0 };
+    for (muf_u32 i = 0; i < 7000; ++i)
+        ++seen[mufXoshiro256NextBounded(&xoshiro, 7)];
+    for (muf_u32 v = 0; v < 7; ++v)
+        MUF_TEST_CHECK(seen[v] > 800 && seen[v] < 1200, "mufXoshiro256NextBounded: %u drawn %u times of 7000", v, seen[v]);
+    muf_bool hitMin = MUF_FALSE, hitMax = MUF_FALSE;
+    for (muf_u32 i = 0; i < 1000; ++i) {
+        muf_i32 value = mufXoshiro256Range(&xoshiro, 3, -2);
+        MUF_TEST_CHECK(value >= -2 && value <= 3, "mufXoshiro256Range(3, -2): %d", value);
+        hitMin = hitMin || value == -2;
+        hitMax = hitMax || value == 3;
+    }
+    MUF_TEST_CHECK(hitMin && hitMax, "mufXoshiro256Range(3, -2): an end is never drawn");
+    MUF_TEST_CHECK(mufXoshiro256Range(&xoshiro, 9, 9) == 9, "mufXoshiro256Range(9, 9)");
+}
+
+/* Lane i of the bulk generator is a scalar generator jumped i times, each step gives both halves of every lane */
+static muf_u64 _mufTestFills(void) {
+    MufXoshiro256x4 bulk, bulkF32;
+    MufXoshiro256 lanes[4];
+    mufInitXoshiro256x4(&bulk, 0xF111ULL);
+    mufInitXoshiro256(&lanes[0], 0xF111ULL);
+    for (muf_u32 lane = 1; lane < 4; ++lane) {
+        lanes[lane] = lanes[lane - 1];
+        mufXoshiro256Jump(&lanes[lane]);
+    }
+
+    muf_u64 fold = 0;
+    muf_u32 values[MUF_TEST_MAX_COUNT + 1];
+    muf_f32 floats[MUF_TEST_MAX_COUNT + 1];
+    for (muf_usize count = 0; count <= MUF_TEST_MAX_COUNT; ++count) {
+        bulkF32 = bulk;
+        values[count] = 0xDEADBEEFU;
+        mufRandomFillU32(&bulk, values, count);
+        MUF_TEST_CHECK(values[count] == 0xDEADBEEFU, "mufRandomFillU32, count %u: wrote past the array", (unsigned) count);
+        muf_usize steps = (count + 7) / 8;
+        for (muf_usize step = 0; step < steps; ++step) {
+            for (muf_u32 lane = 0; lane < 4; ++lane) {
+                muf_u64 value = mufXoshiro256Next(&lanes[lane]);
+                muf_usize index = step * 8 + lane * 2;
+                MUF_TEST_CHECK(index >= count || values[index] == (muf_u32) value, "mufRandomFillU32, count %u, index %u",
+                    (unsigned) count, (unsigned) index);
+                MUF_TEST_CHECK(index + 1 >= count || values[index + 1] == (muf_u32) (value >> 32),
+                    "mufRandomFillU32, count %u, index %u", (unsigned) count, (unsigned) index + 1);
+            }
+        }
+
+        floats[count] = -1.0F;
+        mufRandomFillF32(&bulkF32, floats, count, -3.0F, 5.0F);
+        MUF_TEST_CHECK(floats[count] == -1.0F, "mufRandomFillF32, count %u: wrote past the array", (unsigned) count);
+        MUF_TEST_CHECK(memcmp(&bulkF32, &bulk, sizeof(bulk)) == 0, "mufRandomFillF32, count %u: the state differs from the "
+            "one after mufRandomFillU32", (unsigned) count);
+        for (muf_usize i = 0; i < count; ++i) {
+            muf_f64 reference = -3.0 + (values[i] >> 8) / 16777216.0 * 8.0;
+            MUF_TEST_CHECK(floats[i] >= -3.0F && floats[i] < 5.0F && mufTestNear(floats[i], reference, 1e-6, 1.0),
+                "mufRandomFillF32, count %u, index %u: %g, expected %g", (unsigned) count, (unsigned) i, floats[i], reference);
+            muf_u32 bits;
+            memcpy(&bits, &floats[i], sizeof(bits));
+            fold = mufHashMix64(fold ^ values[i] ^ ((muf_u64) bits << 32));
+        }
+    }
+    return fold;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <feature mask>\n", argv[0]);
+        return 1;
+    }
+    mufSetCpuFeatureMask((MufCpuFeatureFlags) strtoul(argv[1], NULL, 0));
+
+    _mufTestKnownSequences();
+    _mufTestAdvance();
+    _mufTestBounded();
+    muf_u64 fold = _mufTestFills();
+    MUF_TEST_CHECK(fold == MUF_TEST_REFERENCE_FOLD, "mufRandomFillU32, mufRandomFillF32: fold %016llx, expected %016llx",
+        (unsigned long long) fold, (unsigned long long) MUF_TEST_REFERENCE_FOLD);
+    return MUF_TEST_RESULT();
+}
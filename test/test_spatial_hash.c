@@ -0,0 +1,244 @@
+/*
+ * Comparison of the queries of spatial_hash.h with brute-force loops over the live objects, in bulk mode and
+ * after random inserts, moves and removals. Boxes within the tolerance of a query border may be reported either way.
+ */
+
+#include "test.h"
+
+#include <float.h>
+#include <stdlib.h>
+
+#include "muffin_core/memory.h"
+#include "muffin_core/random.h"
+#include "muffin_core/spatial_hash.h"
+
+#define MUF_TEST_OBJECT_COUNT   4000
+#define MUF_TEST_UPDATE_COUNT   8000
+#define MUF_TEST_QUERY_COUNT    100
+#define MUF_TEST_NEAREST_K      8
+#define MUF_TEST_TOLERANCE      1e-4
+
+typedef struct _MufTestWorld_s {
+    MufAABB3    *bounds;
+    muf_bool    *alive;
+    muf_u32     capacity;
+    /* The found flags of a query, indexed by id */
+    muf_u8      *found;
+} _MufTestWorld;
+
+static MufXoshiro256 _generator[1];
+
+static muf_f32 _mufTestRandom(muf_f32 minValue, muf_f32 maxValue) {
+    return minValue + (maxValue - minValue) * mufXoshiro256NextF32(_generator);
+}
+
+static MufVec3 _mufTestRandomVec3(muf_f32 minValue, muf_f32 maxValue) {
+    return mufCreateVec3(_mufTestRandom(minValue, maxValue), _mufTestRandom(minValue, maxValue), _mufTestRandom(minValue, maxValue));
+}
+
+/* Mostly small boxes, a few span many cells and stretch the loosening */
+static MufAABB3 _mufTestRandomBox(void) {
+    MufVec3 center = _mufTestRandomVec3(-50.0F, 50.0F);
+    MufVec3 extent = mufXoshiro256NextF32(_generator) < 0.05F ? _mufTestRandomVec3(0.0F, 15.0F) : _mufTestRandomVec3(0.0F, 1.5F);
+    MufAABB3 box;
+    box.min = mufCreateVec3(center.x - extent.x, center.y - extent.y, center.z - extent.z);
+    box.max = mufCreateVec3(center.x + extent.x, center.y + extent.y, center.z + extent.z);
+    return box;
+}
+
+/* The distance by which two boxes overlap on their tightest axis, negative when they are apart */
+static muf_f64 _mufTestOverlap(const MufAABB3 *a, const MufAABB3 *b) {
+    muf_f64 overlap = INFINITY;
+    for (muf_u32 axis = 0; axis < 3; ++axis) {
+        muf_f64 lo = fmax((&a->min.x)[axis], (&b->min.x)[axis]);
+        muf_f64 hi = fmin((&a->max.x)[axis], (&b->max.x)[axis]);
+        overlap = fmin(overlap, hi - lo);
+    }
+    return overlap;
+}
+
+static muf_f64 _mufTestFrustumSeparation(const MufFrustum *frustum, const MufAABB3 *box) {
+    muf_f64 separation = INFINITY;
+    for (muf_u32 i = 0; i < _MUF_FRUSTUM_PLANE_COUNT_; ++i) {
+        MufVec4 p = frustum->planes[i];
+        muf_f64 farthest = (p.x > 0.0F ? box->max.x : box->min.x) * (muf_f64) p.x
+            + (p.y > 0.0F ? box->max.y : box->min.y) * (muf_f64) p.y + (p.z > 0.0F ? box->max.z : box->min.z) * (muf_f64) p.z + p.w;
+        separation = fmin(separation, farthest);
+    }
+    return separation;
+}
+
+static muf_f64 _mufTestPointDistance(const MufAABB3 *box, MufVec3 point) {
+    muf_f64 squared = 0.0;
+    for (muf_u32 axis = 0; axis < 3; ++axis) {
+        muf_f64 p = (&point.x)[axis];
+        muf_f64 d = fmax(fmax((&box->min.x)[axis] - p, p - (&box->max.x)[axis]), 0.0);
+        squared += d * d;
+    }
+    return sqrt(squared);
+}
+
+/* Mark the returned ids, every one must be live and reported once */
+static void _mufTestCollect(_MufTestWorld *world, MufArray *ids, muf_usize appended, const char *query) {
+    MUF_TEST_CHECK(appended + 1 == mufArrayGetSize(ids) && *(const muf_u32 *) mufArrayGetCRef(ids, 0) == MUF_SPATIAL_HASH_INVALID_ID,
+        "%s: %u appended to 1, size %u", query, (unsigned) appended, (unsigned) mufArrayGetSize(ids));
+    for (muf_u32 i = 0; i < world->capacity; ++i)
+        world->found[i] = 0;
+    for (muf_usize j = 1; j < mufArrayGetSize(ids); ++j) {
+        muf_u32 id = *(const muf_u32 *) mufArrayGetCRef(ids, j);
+        MUF_TEST_CHECK(id < world->capacity && world->alive[id] && world->found[id] == 0, "%s: id %u reported twice or not live",
+            query, id);
+        if (id < world->capacity)
+            world->found[id] = 1;
+    }
+}
+
+static void _mufTestQueries(const MufSpatialHash *hash, _MufTestWorld *world, const char *mode) {
+    muf_u32 liveCount = 0;
+    for (muf_u32 i = 0; i < world->capacity; ++i) {
+        if (!world->alive[i])
+            continue;
+        ++liveCount;
+        MufAABB3 stored = mufSpatialHashGetBounds(hash, i);
+        MUF_TEST_CHECK(stored.min.x == world->bounds[i].min.x && stored.max.z == world->bounds[i].max.z,
+            "mufSpatialHashGetBounds, %s: id %u", mode, i);
+    }
+    MUF_TEST_CHECK(mufSpatialHashGetObjectCount(hash) == liveCount, "mufSpatialHashGetObjectCount, %s: %u, expected %u",
+        mode, mufSpatialHashGetObjectCount(hash), liveCount);
+
+    MufArray *ids = mufCreateArray(muf_u32);
+    const muf_u32 marker = MUF_SPATIAL_HASH_INVALID_ID;
+    for (muf_u32 q = 0; q < MUF_TEST_QUERY_COUNT; ++q) {
+        MufAABB3 box = _mufTestRandomBox();
+        /* Some queries cover most of the grid, they take the path over every cell */
+        if (q % 10 == 0) {
+            box.min = mufCreateVec3(box.min.x - 40.0F, box.min.y - 40.0F, box.min.z - 40.0F);
+            box.max = mufCreateVec3(box.max.x + 40.0F, box.max.y + 40.0F, box.max.z + 40.0F);
+        }
+        mufArrayClear(ids);
+        mufArrayPush(ids, &marker);
+        _mufTestCollect(world, ids, mufSpatialHashQueryAABB3(hash, box, ids), "mufSpatialHashQueryAABB3");
+        for (muf_u32 i = 0; i < world->capacity; ++i) {
+            if (!world->alive[i])
+                continue;
+            muf_f64 overlap = _mufTestOverlap(&world->bounds[i], &box);
+            MUF_TEST_CHECK(fabs(overlap) < MUF_TEST_TOLERANCE || world->found[i] == (overlap > 0.0),
+                "mufSpatialHashQueryAABB3, %s, query %u: id %u %s, overlap %g", mode, q, i, world->found[i] ? "reported" : "missed", overlap);
+        }
+
+        MufFrustum frustum;
+        MufVec3 center = _mufTestRandomVec3(-50.0F, 50.0F);
+        for (muf_u32 p = 0; p < _MUF_FRUSTUM_PLANE_COUNT_; ++p) {
+            MufVec3 n = _mufTestRandomVec3(-1.0F, 1.0F);
+            muf_f64 length = sqrt((muf_f64) n.x * n.x + (muf_f64) n.y * n.y + (muf_f64) n.z * n.z);
+            if (length < 0.1) {
+                n = mufCreateVec3(0.0F, 1.0F, 0.0F);
+                length = 1.0;
+            }
+            n = mufCreateVec3((muf_f32) (n.x / length), (muf_f32) (n.y / length), (muf_f32) (n.z / length));
+            frustum.planes[p] = mufCreateVec4(n.x, n.y, n.z,
+                _mufTestRandom(2.0F, 40.0F) - (n.x * center.x + n.y * center.y + n.z * center.z));
+        }
+        mufArrayClear(ids);
+        mufArrayPush(ids, &marker);
+        _mufTestCollect(world, ids, mufSpatialHashQueryFrustum(hash, &frustum, ids), "mufSpatialHashQueryFrustum");
+        for (muf_u32 i = 0; i < world->capacity; ++i) {
+            if (!world->alive[i])
+                continue;
+            muf_f64 separation = _mufTestFrustumSeparation(&frustum, &world->bounds[i]);
+            MUF_TEST_CHECK(fabs(separation) < MUF_TEST_TOLERANCE || world->found[i] == (separation > 0.0),
+                "mufSpatialHashQueryFrustum, %s, query %u: id %u %s, separation %g", mode, q, i,
+                world->found[i] ? "reported" : "missed", separation);
+        }
+
+        /* The k-th distance of the brute force, ties may pick any of the objects at that distance */
+        MufVec3 point = _mufTestRandomVec3(-70.0F, 70.0F);
+        muf_f32 maxDistance = q % 3 == 0 ? _mufTestRandom(0.0F, 10.0F) : FLT_MAX;
+        muf_f64 expected[MUF_TEST_NEAREST_K];
+        muf_u32 expectedCount = 0;
+        for (muf_u32 i = 0; i < world->capacity; ++i) {
+            muf_f64 distance = _mufTestPointDistance(&world->bounds[i], point);
+            if (!world->alive[i] || distance > maxDistance)
+                continue;
+            muf_u32 slot = expectedCount < MUF_TEST_NEAREST_K ? expectedCount++ : MUF_TEST_NEAREST_K;
+            while (slot > 0 && expected[slot - 1] > distance) {
+                if (slot < MUF_TEST_NEAREST_K)
+                    expected[slot] = expected[slot - 1];
+                --slot;
+            }
+            if (slot < MUF_TEST_NEAREST_K)
+                expected[slot] = distance;
+        }
+
+        muf_u32 nearestIds[MUF_TEST_NEAREST_K];
+        muf_f32 distances[MUF_TEST_NEAREST_K];
+        muf_u32 found = mufSpatialHashQueryNearest(hash, point, MUF_TEST_NEAREST_K, maxDistance, nearestIds, distances);
+        muf_bool nearLimit = expectedCount > 0 && fabs(expected[expectedCount - 1] - maxDistance) < MUF_TEST_TOLERANCE;
+        MUF_TEST_CHECK(found == expectedCount || nearLimit, "mufSpatialHashQueryNearest, %s, query %u: %u found, expected %u",
+            mode, q, found, expectedCount);
+        for (muf_u32 j = 0; j < found && j < expectedCount; ++j) {
+            muf_u32 id = nearestIds[j];
+            muf_bool valid = id < world->capacity && world->alive[id];
+            MUF_TEST_CHECK(valid && mufTestNear(distances[j], expected[j], MUF_TEST_TOLERANCE, 1.0)
+                && mufTestNear(_mufTestPointDistance(&world->bounds[id], point), expected[j], MUF_TEST_TOLERANCE, 1.0),
+                "mufSpatialHashQueryNearest, %s, query %u: rank %u is id %u at %g, expected %g", mode, q, j, id, distances[j], expected[j]);
+        }
+    }
+    mufDestroyArray(ids);
+}
+
+int main(void) {
+    mufInitXoshiro256(_generator, 0x73686173ULL);
+
+    _MufTestWorld world;
+    world.capacity = MUF_TEST_OBJECT_COUNT;
+    world.bounds = mufAlloc(MufAABB3, world.capacity);
+    world.alive = mufAlloc(muf_bool, world.capacity);
+    world.found = mufAlloc(muf_u8, world.capacity);
+    for (muf_u32 i = 0; i < world.capacity; ++i) {
+        world.bounds[i] = _mufTestRandomBox();
+        world.alive[i] = MUF_TRUE;
+    }
+
+    MufSpatialHash *hash = mufCreateSpatialHash(4.0F);
+    mufSpatialHashBuild(hash, world.bounds, world.capacity);
+    _mufTestQueries(hash, &world, "bulk");
+
+    /* The ids of removed objects are reused, the world follows the returned ids */
+    for (muf_u32 u = 0; u < MUF_TEST_UPDATE_COUNT; ++u) {
+        muf_u32 id = (muf_u32) (mufXoshiro256Next(_generator) % world.capacity);
+        muf_f32 action = mufXoshiro256NextF32(_generator);
+        if (!world.alive[id]) {
+            MufAABB3 box = _mufTestRandomBox();
+            muf_u32 inserted = mufSpatialHashInsert(hash, box);
+            MUF_TEST_CHECK(inserted < world.capacity && !world.alive[inserted], "mufSpatialHashInsert: id %u is not a free one", inserted);
+            if (inserted >= world.capacity)
+                continue;
+            world.bounds[inserted] = box;
+            world.alive[inserted] = MUF_TRUE;
+        } else if (action < 0.3F) {
+            mufSpatialHashRemove(hash, id);
+            world.alive[id] = MUF_FALSE;
+        } else {
+            /* Small steps mostly stay in the cell, large ones cross the grid */
+            MufAABB3 box = world.bounds[id];
+            MufVec3 step = action < 0.8F ? _mufTestRandomVec3(-1.0F, 1.0F) : _mufTestRandomVec3(-30.0F, 30.0F);
+            box.min = mufCreateVec3(box.min.x + step.x, box.min.y + step.y, box.min.z + step.z);
+            box.max = mufCreateVec3(box.max.x + step.x, box.max.y + step.y, box.max.z + step.z);
+            mufSpatialHashMove(hash, id, box);
+            world.bounds[id] = box;
+        }
+    }
+    _mufTestQueries(hash, &world, "incremental");
+
+    mufSpatialHashClear(hash);
+    for (muf_u32 i = 0; i < world.capacity; ++i)
+        world.alive[i] = MUF_FALSE;
+    _mufTestQueries(hash, &world, "cleared");
+
+    mufDestroySpatialHash(hash);
+    mufFree(world.bounds);
+    mufFree(world.alive);
+    mufFree(world.found);
+    return MUF_TEST_RESULT();
+}
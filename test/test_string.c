@@ -0,0 +1,144 @@
+/*
+ * The MufStr functions that take a view or format arguments pointing into the string itself, compared with the same
+ * operation on a separate copy of the text. The strings are inline, on the heap with room to spare or exactly full,
+ * so the aliased bytes are read both in place and after the buffer moves.
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "muffin_core/memory.h"
+#include "muffin_core/random.h"
+#include "muffin_core/string.h"
+
+#define MUF_TEST_ROUND_COUNT    4000
+/* Around the inline capacity and the size formatted on the stack */
+#define MUF_TEST_MAX_LENGTH     600
+
+typedef enum _MufTestOp_e {
+    _MUF_TEST_OP_APPEND,
+    _MUF_TEST_OP_ASSIGN,
+    _MUF_TEST_OP_REPLACE,
+    _MUF_TEST_OP_APPEND_PATH,
+    _MUF_TEST_OP_APPEND_FORMAT,
+    _MUF_TEST_OP_COUNT
+} _MufTestOp;
+
+static const char *const _opNames[] = {
+    "mufStrAppend", "mufStrAssign", "mufStrReplace", "mufStrAppendPath", "mufStrAppendFormat"
+};
+
+static MufXoshiro256 _generator[1];
+
+static muf_usize _mufTestRandomIndex(muf_usize count) {
+    return count == 0 ? 0 : (muf_usize) (mufXoshiro256Next(_generator) % count);
+}
+
+/* Letters with a few separators, so the paths have to decide about the '/' on both sides */
+static void _mufTestFill(MufStr *str, muf_usize length) {
+    mufStrClear(str);
+    for (muf_usize i = 0; i < length; ++i)
+        mufStrAppendChar(str, _mufTestRandomIndex(8) == 0 ? '/' : (muf_char) ('a' + _mufTestRandomIndex(26)));
+}
+
+/* The reference works on a copy of the text, expected must hold the longest result */
+static muf_usize _mufTestReference(_MufTestOp op, const muf_char *text, muf_usize size, muf_usize begin, muf_usize length,
+    muf_usize count, muf_char *expected) {
+    const muf_char *view = text + begin;
+    switch (op) {
+        case _MUF_TEST_OP_APPEND:
+            memcpy(expected, text, size);
+            memcpy(expected + size, view, length);
+            return size + length;
+        case _MUF_TEST_OP_ASSIGN:
+            memcpy(expected, view, length);
+            return length;
+        case _MUF_TEST_OP_REPLACE:
+            memcpy(expected, text, begin);
+            memcpy(expected + begin, view, length);
+            memcpy(expected + begin + length, text + begin + count, size - begin - count);
+            return size - count + length;
+        case _MUF_TEST_OP_APPEND_PATH: {
+            muf_bool hasSeparator = size == 0 || text[size - 1] == '/';
+            muf_usize out = size;
+            memcpy(expected, text, size);
+            if (length != 0 && view[0] == '/') {
+                if (hasSeparator && size != 0) {
+                    ++view;
+                    --length;
+                }
+            } else if (!hasSeparator) {
+                expected[out++] = '/';
+            }
+            memcpy(expected + out, view, length);
+            return out + length;
+        }
+        default: {
+            memcpy(expected, text, size);
+            return size + (muf_usize) sprintf(expected + size, "%s|%.*s|%u", text, (int) length, view, (unsigned) count);
+        }
+    }
+}
+
+static void _mufTestRound(MufStr *str, muf_u32 round) {
+    _MufTestOp op = (_MufTestOp) _mufTestRandomIndex(_MUF_TEST_OP_COUNT);
+    _mufTestFill(str, _mufTestRandomIndex(4) == 0 ? _mufTestRandomIndex(MUF_STR_LOCAL_CAPACITY + 1) :
+        _mufTestRandomIndex(MUF_TEST_MAX_LENGTH));
+    /* Full buffers grow on any append, reserved ones take the result in place */
+    if (_mufTestRandomIndex(2) == 0)
+        mufStrShrinkToFit(str);
+    else
+        mufStrReserve(str, mufStrGetCapacity(str) + _mufTestRandomIndex(2 * MUF_TEST_MAX_LENGTH));
+
+    muf_usize size = mufStrGetSize(str);
+    muf_usize begin = _mufTestRandomIndex(size + 1);
+    muf_usize length = _mufTestRandomIndex(size - begin + 1);
+    /* The characters replaced from begin, the number formatted otherwise */
+    muf_usize count = op == _MUF_TEST_OP_REPLACE ? _mufTestRandomIndex(size - begin + 1) : _mufTestRandomIndex(100000);
+
+    muf_char *text = mufAlloc(muf_char, size + 1);
+    muf_char *expected = mufAlloc(muf_char, 3 * size + 32);
+    memcpy(text, mufStrGetCStr(str), size + 1);
+    muf_usize expectedSize = _mufTestReference(op, text, size, begin, length, count, expected);
+
+    MufStrView view = mufStrSlice(str, begin, length);
+    switch (op) {
+        case _MUF_TEST_OP_APPEND:
+            mufStrAppend(str, view);
+            break;
+        case _MUF_TEST_OP_ASSIGN:
+            mufStrAssign(str, view);
+            break;
+        case _MUF_TEST_OP_REPLACE:
+            mufStrReplace(str, begin, count, view);
+            break;
+        case _MUF_TEST_OP_APPEND_PATH:
+            mufStrAppendPath(str, view);
+            break;
+        default:
+            mufStrAppendFormat(str, "%s|%.*s|%u", mufStrGetCStr(str), (int) view.length, view.data, (unsigned) count);
+            break;
+    }
+
+    MUF_TEST_CHECK(mufStrGetSize(str) == expectedSize && memcmp(mufStrGetCStr(str), expected, expectedSize) == 0
+        && mufStrGetCStr(str)[expectedSize] == '\0', "%s, round %u, size %u, view %u+%u: size %u, expected %u",
+        _opNames[op], round, (unsigned) size, (unsigned) begin, (unsigned) length, (unsigned) mufStrGetSize(str),
+        (unsigned) expectedSize);
+    mufFree(text);
+    mufFree(expected);
+}
+
+int main(void) {
+    mufInitXoshiro256(_generator, 0x73747273ULL);
+    for (muf_u32 round = 0; round < MUF_TEST_ROUND_COUNT; ++round) {
+        /* The second round starts from whatever buffer the first one left */
+        MufStr str;
+        mufInitStr(&str, NULL);
+        _mufTestRound(&str, round);
+        _mufTestRound(&str, round);
+        mufDestroyStr(&str);
+    }
+    return MUF_TEST_RESULT();
+}
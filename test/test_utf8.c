@@ -0,0 +1,277 @@
+/*
+ * Comparison of the UTF-8 validation, counting and transcoding of string.h with a scalar reference decoder.
+ * The kernels are selected once per process, ctest runs this program once per feature mask:
+ *     test_utf8 <mask>
+ * The strings mix runs of one width, so the vectorized paths for ASCII, 2 and 3 byte characters all see full blocks.
+ */
+
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "muffin_core/cpu.h"
+#include "muffin_core/random.h"
+#include "muffin_core/string.h"
+
+#define MUF_TEST_STRING_COUNT   10000
+#define MUF_TEST_MAX_LENGTH     400
+#define MUF_TEST_CUT_COUNT      4
+/* The bytes checked one by one sit on each side of the 32-byte boundary of the widest kernel */
+#define MUF_TEST_WINDOW_OFFSET  29
+#define MUF_TEST_WINDOW_SIZE    40
+
+typedef enum _MufTestRun_e {
+    _MUF_TEST_RUN_ASCII,
+    _MUF_TEST_RUN_2_BYTES,
+    _MUF_TEST_RUN_3_BYTES,
+    _MUF_TEST_RUN_MIXED,
+    _MUF_TEST_RUN_COUNT
+} _MufTestRun;
+
+static MufXoshiro256 _generator[1];
+
+static muf_u32 _mufTestRandomIndex(muf_u32 count) {
+    return count == 0 ? 0 : (muf_u32) (mufXoshiro256Next(_generator) % count);
+}
+
+static muf_bool _mufTestIsSurrogate(muf_u32 cp) {
+    return cp >= 0xD800 && cp <= 0xDFFF;
+}
+
+static muf_u32 _mufTestRandomCodePoint(_MufTestRun run) {
+    muf_u32 cp;
+    switch (run) {
+        case _MUF_TEST_RUN_ASCII:
+            return _mufTestRandomIndex(0x80);
+        case _MUF_TEST_RUN_2_BYTES:
+            /* A few spaces break the runs in the middle of a block */
+            return _mufTestRandomIndex(40) == 0 ? ' ' : 0x80 + _mufTestRandomIndex(0x780);
+        case _MUF_TEST_RUN_3_BYTES:
+            do {
+                cp = 0x800 + _mufTestRandomIndex(0xF800);
+            } while (_mufTestIsSurrogate(cp));
+            return cp;
+        default:
+            switch (_mufTestRandomIndex(5)) {
+                case 0:
+                case 1:
+                    return _mufTestRandomIndex(0x80);
+                case 2:
+                    return 0x80 + _mufTestRandomIndex(0x780);
+                case 3:
+                    return _mufTestRandomCodePoint(_MUF_TEST_RUN_3_BYTES);
+                default:
+                    return 0x10000 + _mufTestRandomIndex(0x100000);
+            }
+    }
+}
+
+static muf_usize _mufTestEncode(muf_u32 cp, muf_u8 *out) {
+    if (cp < 0x80) {
+        out[0] = (muf_u8) cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (muf_u8) (0xC0 | cp >> 6);
+        out[1] = (muf_u8) (0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (muf_u8) (0xE0 | cp >> 12);
+        out[1] = (muf_u8) (0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (muf_u8) (0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (muf_u8) (0xF0 | cp >> 18);
+    out[1] = (muf_u8) (0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (muf_u8) (0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (muf_u8) (0x80 | (cp & 0x3F));
+    return 4;
+}
+
+/* A strict decoder, one character at a time */
+static muf_bool _mufTestIsValid(const muf_u8 *s, muf_usize length) {
+    muf_usize i = 0;
+    while (i < length) {
+        muf_u32 c = s[i], cp, size;
+        if (c < 0x80) {
+            ++i;
+            continue;
+        }
+        if (c >= 0xC2 && c <= 0xDF) {
+            size = 2;
+            cp = c & 0x1F;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            size = 3;
+            cp = c & 0x0F;
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            size = 4;
+            cp = c & 0x07;
+        } else {
+            return MUF_FALSE;
+        }
+        if (i + size > length)
+            return MUF_FALSE;
+        for (muf_u32 k = 1; k < size; ++k) {
+            if ((s[i + k] & 0xC0) != 0x80)
+                return MUF_FALSE;
+            cp = (cp << 6) | (s[i + k] & 0x3F);
+        }
+        if ((size == 3 && cp < 0x800) || (size == 4 && (cp < 0x10000 || cp > 0x10FFFF)) || _mufTestIsSurrogate(cp))
+            return MUF_FALSE;
+        i += size;
+    }
+    return MUF_TRUE;
+}
+
+static muf_u8 _utf8[MUF_TEST_MAX_LENGTH + 4];
+static muf_u16 _utf16[MUF_TEST_MAX_LENGTH + 4];
+static muf_u16 _utf16Out[MUF_TEST_MAX_LENGTH + 4];
+static muf_char _utf8Out[MUF_TEST_MAX_LENGTH + 4];
+
+static void _mufTestValidString(muf_u32 index) {
+    _MufTestRun run = (_MufTestRun) _mufTestRandomIndex(_MUF_TEST_RUN_COUNT);
+    muf_usize target = _mufTestRandomIndex(MUF_TEST_MAX_LENGTH - 3);
+    muf_usize size = 0, units = 0, count = 0;
+    while (size < target) {
+        muf_u32 cp = _mufTestRandomCodePoint(run);
+        size += _mufTestEncode(cp, _utf8 + size);
+        if (cp > 0xFFFF) {
+            _utf16[units++] = (muf_u16) (0xD7C0 + (cp >> 10));
+            _utf16[units++] = (muf_u16) (0xDC00 + (cp & 0x3FF));
+        } else {
+            _utf16[units++] = (muf_u16) cp;
+        }
+        ++count;
+    }
+    const muf_char *str = (const muf_char *) _utf8;
+
+    MUF_TEST_CHECK(mufUtf8IsValidN(str, size), "mufUtf8IsValidN, string %u: a valid string of %u bytes is rejected",
+        index, (unsigned) size);
+    MUF_TEST_CHECK(mufUtf8LengthN(str, size) == count, "mufUtf8LengthN, string %u: %u, expected %u", index,
+        (unsigned) mufUtf8LengthN(str, size), (unsigned) count);
+    MUF_TEST_CHECK(mufUtf8GetUtf16Length(str, size) == units, "mufUtf8GetUtf16Length, string %u: %u, expected %u", index,
+        (unsigned) mufUtf8GetUtf16Length(str, size), (unsigned) units);
+    MUF_TEST_CHECK(mufUtf16GetUtf8Length(_utf16, units) == size, "mufUtf16GetUtf8Length, string %u: %u, expected %u", index,
+        (unsigned) mufUtf16GetUtf8Length(_utf16, units), (unsigned) size);
+
+    MufUtf8ResultCode result = mufUtf8ToUtf16(_utf16Out, units + 1, str, size);
+    MUF_TEST_CHECK(result == MUF_UTF8_SUCCESS && memcmp(_utf16Out, _utf16, units * sizeof(muf_u16)) == 0
+        && _utf16Out[units] == 0, "mufUtf8ToUtf16, string %u: result %d or units differ", index, (int) result);
+    result = mufUtf16ToUtf8(_utf8Out, size + 1, _utf16, units);
+    MUF_TEST_CHECK(result == MUF_UTF8_SUCCESS && memcmp(_utf8Out, _utf8, size) == 0 && _utf8Out[size] == '\0',
+        "mufUtf16ToUtf8, string %u: result %d or bytes differ", index, (int) result);
+
+    /* Short outputs fail, what they hold is a terminated prefix of the result */
+    for (muf_u32 cut = 0; cut < MUF_TEST_CUT_COUNT; ++cut) {
+        muf_usize room = _mufTestRandomIndex((muf_u32) units + 1);
+        result = mufUtf8ToUtf16(_utf16Out, room + 1, str, size);
+        muf_usize written = 0;
+        while (written <= room && _utf16Out[written] != 0)
+            ++written;
+        MUF_TEST_CHECK(result == (room >= units ? MUF_UTF8_SUCCESS : MUF_UTF8_TOO_SMALL) && written <= room
+            && memcmp(_utf16Out, _utf16, written * sizeof(muf_u16)) == 0,
+            "mufUtf8ToUtf16, string %u: room %u of %u, result %d", index, (unsigned) room, (unsigned) units, (int) result);
+
+        room = _mufTestRandomIndex((muf_u32) size + 1);
+        result = mufUtf16ToUtf8(_utf8Out, room + 1, _utf16, units);
+        written = strlen(_utf8Out);
+        MUF_TEST_CHECK(result == (room >= size ? MUF_UTF8_SUCCESS : MUF_UTF8_TOO_SMALL) && written <= room
+            && memcmp(_utf8Out, _utf8, written) == 0,
+            "mufUtf16ToUtf8, string %u: room %u of %u, result %d", index, (unsigned) room, (unsigned) size, (int) result);
+    }
+
+    /* Damage a few bytes or cut the string, the reference decides whether it is still valid */
+    muf_u32 damageCount = 1 + _mufTestRandomIndex(3);
+    for (muf_u32 k = 0; k < damageCount && size != 0; ++k) {
+        muf_usize position = _mufTestRandomIndex((muf_u32) size);
+        switch (_mufTestRandomIndex(4)) {
+            case 0:
+                _utf8[position] = (muf_u8) mufXoshiro256Next(_generator);
+                break;
+            case 1:
+                _utf8[position] ^= (muf_u8) (1U << _mufTestRandomIndex(8));
+                break;
+            case 2:
+                _utf8[position] = (muf_u8) (0x80 | _mufTestRandomIndex(0x80));
+                break;
+            default:
+                size = position;
+                break;
+        }
+    }
+    muf_bool valid = _mufTestIsValid(_utf8, size);
+    MUF_TEST_CHECK(mufUtf8IsValidN(str, size) == valid, "mufUtf8IsValidN, damaged string %u: %d, expected %d", index,
+        (int) !valid, (int) valid);
+    MUF_TEST_CHECK((mufUtf8LengthN(str, size) != (muf_usize) -1) == valid, "mufUtf8LengthN, damaged string %u", index);
+    MUF_TEST_CHECK((mufUtf8GetUtf16Length(str, size) != (muf_usize) -1) == valid, "mufUtf8GetUtf16Length, damaged string %u",
+        index);
+    result = mufUtf8ToUtf16(_utf16Out, MUF_TEST_MAX_LENGTH + 1, str, size);
+    MUF_TEST_CHECK(result == (valid ? MUF_UTF8_SUCCESS : MUF_UTF8_INVALID), "mufUtf8ToUtf16, damaged string %u: result %d",
+        index, (int) result);
+
+    /* An unpaired surrogate anywhere makes the UTF-16 side invalid */
+    if (units != 0) {
+        muf_usize position = _mufTestRandomIndex((muf_u32) units);
+        muf_u16 saved = _utf16[position];
+        _utf16[position] = (muf_u16) (_mufTestRandomIndex(2) == 0 ? 0xDC00 : 0xD800) + (muf_u16) _mufTestRandomIndex(0x400);
+        muf_bool paired = MUF_FALSE;
+        for (muf_usize i = 0; i < units && !paired; ++i)
+            paired = _utf16[i] >= 0xD800 && _utf16[i] <= 0xDBFF && i + 1 < units && _utf16[i + 1] >= 0xDC00 && _utf16[i + 1] <= 0xDFFF
+                && (i == position || i + 1 == position);
+        if (!paired) {
+            MUF_TEST_CHECK(mufUtf16GetUtf8Length(_utf16, units) == (muf_usize) -1, "mufUtf16GetUtf8Length, string %u: "
+                "surrogate at %u", index, (unsigned) position);
+            result = mufUtf16ToUtf8(_utf8Out, MUF_TEST_MAX_LENGTH + 1, _utf16, units);
+            MUF_TEST_CHECK(result == MUF_UTF8_INVALID, "mufUtf16ToUtf8, string %u: surrogate at %u, result %d", index,
+                (unsigned) position, (int) result);
+        }
+        _utf16[position] = saved;
+    }
+}
+
+/* One byte of each class the decoders tell apart, with the ends of the ranges allowed after E0, ED, F0 and F4 */
+static const muf_u8 _byteClasses[] = {
+    0x00, 0x41, 0x7F, 0x80, 0x8F, 0x90, 0x9F, 0xA0, 0xBF, 0xC0, 0xC1, 0xC2, 0xDF,
+    0xE0, 0xE1, 0xEC, 0xED, 0xEE, 0xEF, 0xF0, 0xF1, 0xF3, 0xF4, 0xF5, 0xFF
+};
+
+/* Sequences of three bytes across the block boundary, followed by ASCII or cut at each length */
+static void _mufTestWindows(void) {
+    muf_u8 s[MUF_TEST_WINDOW_SIZE];
+    memset(s, 'a', sizeof(s));
+    for (muf_u32 a = 0; a < 256; ++a) {
+        for (muf_u32 b = 0; b < 256; ++b) {
+            /* Only a second byte has a range that depends on the lead, the third one is taken by class */
+            for (muf_u32 k = 0; k < MUF_COUNTOF(_byteClasses); ++k) {
+                muf_u32 c = _byteClasses[k];
+                s[MUF_TEST_WINDOW_OFFSET] = (muf_u8) a;
+                s[MUF_TEST_WINDOW_OFFSET + 1] = (muf_u8) b;
+                s[MUF_TEST_WINDOW_OFFSET + 2] = (muf_u8) c;
+                for (muf_usize length = MUF_TEST_WINDOW_OFFSET + 1; length <= MUF_TEST_WINDOW_OFFSET + 4; ++length) {
+                    muf_bool valid = _mufTestIsValid(s, length);
+                    MUF_TEST_CHECK(mufUtf8IsValidN((const muf_char *) s, length) == valid,
+                        "mufUtf8IsValidN: %02X %02X %02X, length %u, expected %d", a, b, c, (unsigned) length, (int) valid);
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <feature mask>\n", argv[0]);
+        return 1;
+    }
+    mufSetCpuFeatureMask((MufCpuFeatureFlags) strtoul(argv[1], NULL, 0));
+
+    mufInitXoshiro256(_generator, 0x75746638ULL);
+    for (muf_u32 i = 0; i < MUF_TEST_STRING_COUNT; ++i)
+        _mufTestValidString(i);
+    _mufTestWindows();
+
+    MUF_TEST_CHECK(mufUtf8Length("h\xC3\xA9llo") == 5 && mufUtf8Length("\xC3") == (muf_usize) -1, "mufUtf8Length");
+    MUF_TEST_CHECK(mufUtf8IsValid("\xE2\x82\xAC") && !mufUtf8IsValid("\xED\xA0\x80"), "mufUtf8IsValid");
+    return MUF_TEST_RESULT();
+}
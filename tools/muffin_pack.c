@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "muffin_core/common.h"
+#include "muffin_core/memory.h"
+#include "muffin_platform/archive.h"
+#include "muffin_platform/filesystem.h"
+
+#if defined(MUF_PLATFORM_WIN32)
+#   include <windows.h>
+#else
+#   include <dirent.h>
+#   include <sys/stat.h>
+#endif
+
+#define MUF_PACK_MAX_PATH 1024
+
+typedef struct _MufPackList_s {
+    muf_char    **paths;
+    muf_usize   count;
+    muf_usize   capacity;
+} _MufPackList;
+
+MUF_INTERNAL void _mufPackListPush(_MufPackList *list, const muf_char *path) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity == 0 ? 256 : list->capacity * 2;
+        list->paths = mufRealloc(muf_char *, list->paths, list->capacity);
+    }
+    muf_usize length = strlen(path);
+    muf_char *copy = mufAlloc(muf_char, length + 1);
+    mufMemCopyBytes(copy, path, length + 1);
+    list->paths[list->count++] = copy;
+}
+
+MUF_INTERNAL void _mufPackListClear(_MufPackList *list) {
+    for (muf_usize i = 0; i < list->count; ++i)
+        mufFree(list->paths[i]);
+    mufSafeFree(list->paths);
+    list->count = list->capacity = 0;
+}
+
+/* Join two parts with a '/', an empty part is left out. A path that does not fit is reported */
+MUF_INTERNAL muf_bool _mufPackJoin(muf_char *dst, muf_usize capacity, const muf_char *first, const muf_char *second) {
+    muf_i32 length = first[0] == '\0' || second[0] == '\0' ? snprintf(dst, capacity, "%s%s", first, second)
+        : snprintf(dst, capacity, "%s/%s", first, second);
+    if (length < 0 || (muf_usize) length >= capacity) {
+        fprintf(stderr, "muffin_pack: path too long '%s/%s'\n", first, second);
+        return MUF_FALSE;
+    }
+    return MUF_TRUE;
+}
+
+/*
+ * Collect the regular files below root, paths are relative to root and '/' separated.
+ * Fails rather than leave out a file whose path is too long.
+ */
+MUF_INTERNAL muf_bool _mufPackCollect(const muf_char *root, const muf_char *relative, _MufPackList *list) {
+    muf_char directory[MUF_PACK_MAX_PATH];
+    if (!_mufPackJoin(directory, sizeof(directory), root, relative))
+        return MUF_FALSE;
+    muf_bool succeeded = MUF_TRUE;
+
+#if defined(MUF_PLATFORM_WIN32)
+    muf_char pattern[MUF_PACK_MAX_PATH];
+    if (!_mufPackJoin(pattern, sizeof(pattern), directory, "*"))
+        return MUF_FALSE;
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA(pattern, &data);
+    if (find == INVALID_HANDLE_VALUE)
+        return MUF_TRUE;
+    do {
+        const muf_char *name = data.cFileName;
+        muf_bool isDirectory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#else
+    DIR *dir = opendir(directory);
+    if (dir == NULL)
+        return MUF_TRUE;
+    struct dirent *dirEntry;
+    while (succeeded && (dirEntry = readdir(dir)) != NULL) {
+        const muf_char *name = dirEntry->d_name;
+        muf_char fullPath[MUF_PACK_MAX_PATH];
+        struct stat st;
+        if (!_mufPackJoin(fullPath, sizeof(fullPath), directory, name)) {
+            succeeded = MUF_FALSE;
+            break;
+        }
+        if (stat(fullPath, &st) != 0)
+            continue;
+        muf_bool isDirectory = S_ISDIR(st.st_mode);
+        if (!isDirectory && !S_ISREG(st.st_mode))
+            continue;
+#endif
+        if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+            continue;
+
+        muf_char child[MUF_PACK_MAX_PATH];
+        if (!_mufPackJoin(child, sizeof(child), relative, name)) {
+            succeeded = MUF_FALSE;
+            break;
+        }
+
+        if (isDirectory)
+            succeeded = _mufPackCollect(root, child, list);
+        else
+            _mufPackListPush(list, child);
+#if defined(MUF_PLATFORM_WIN32)
+    } while (succeeded && FindNextFileA(find, &data));
+    FindClose(find);
+#else
+    }
+    closedir(dir);
+#endif
+    return succeeded;
+}
+
+MUF_INTERNAL int _mufPackComparePaths(const void *lhs, const void *rhs) {
+    return strcmp(*(const muf_char *const *) lhs, *(const muf_char *const *) rhs);
+}
+
+MUF_INTERNAL void _mufPackPrintUsage(void) {
+    printf("Usage: muffin_pack <input-directory> <output-file> [--align <bytes>] [--compress] [--block-size <bytes>]\n");
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        _mufPackPrintUsage();
+        return 1;
+    }
+
+    const muf_char *inputPath = argv[1];
+    const muf_char *outputPath = argv[2];
+    muf_u32 alignment = MUF_ARCHIVE_DEFAULT_ALIGN;
+    muf_u32 blockSize = 0;
+    muf_bool compress = MUF_FALSE;
+    for (muf_i32 i = 3; i < argc; ++i) {
+        if (strcmp(argv[i], "--align") == 0 && i + 1 < argc) {
+            alignment = (muf_u32) strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--block-size") == 0 && i + 1 < argc) {
+            blockSize = (muf_u32) strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--compress") == 0) {
+            compress = MUF_TRUE;
+        } else {
+            _mufPackPrintUsage();
+            return 1;
+        }
+    }
+
+    _MufPackList list = { NULL, 0, 0 };
+    if (!_mufPackCollect(inputPath, "", &list)) {
+        _mufPackListClear(&list);
+        return 1;
+    }
+    /* Sorted input keeps the output byte-identical between runs */
+    if (list.count > 1)
+        qsort(list.paths, list.count, sizeof(muf_char *), _mufPackComparePaths);
+
+    MufArchiveWriter *writer = mufCreateArchiveWriter(outputPath, alignment);
+    if (writer == NULL) {
+        fprintf(stderr, "muffin_pack: cannot create '%s'\n", outputPath);
+        _mufPackListClear(&list);
+        return 1;
+    }
+
+    muf_bool succeeded = MUF_TRUE;
+    muf_u64 totalBytes = 0;
+    muf_byte *buffer = NULL;
+    muf_usize bufferCapacity = 0;
+    for (muf_usize i = 0; i < list.count && succeeded; ++i) {
+        muf_char fullPath[MUF_PACK_MAX_PATH];
+        if (!_mufPackJoin(fullPath, sizeof(fullPath), inputPath, list.paths[i])) {
+            succeeded = MUF_FALSE;
+            break;
+        }
+
+        MufFile *file = mufCreateFile(fullPath, MUF_FILE_OPEN_READ);
+        if (!mufFileIsOpened(file)) {
+            fprintf(stderr, "muffin_pack: cannot open '%s'\n", fullPath);
+            mufDestroyFile(file);
+            succeeded = MUF_FALSE;
+            break;
+        }
+        muf_usize size = mufFileGetSize(file);
+        if (size > bufferCapacity) {
+            bufferCapacity = size;
+            buffer = mufRealloc(muf_byte, buffer, bufferCapacity);
+        }
+        muf_bool added = mufFileRead(file, size, buffer) == size;
+        if (added && compress)
+            added = mufArchiveWriterAddCompressed(writer, list.paths[i], buffer, size, blockSize);
+        else if (added)
+            added = mufArchiveWriterAdd(writer, list.paths[i], buffer, size);
+        if (!added) {
+            fprintf(stderr, "muffin_pack: cannot pack '%s'\n", fullPath);
+            succeeded = MUF_FALSE;
+        }
+        totalBytes += size;
+        mufDestroyFile(file);
+    }
+
+    if (!mufArchiveWriterFinish(writer))
+        succeeded = MUF_FALSE;
+    if (succeeded)
+        printf("muffin_pack: %llu files, %llu bytes -> %s\n", (unsigned long long) list.count,
+            (unsigned long long) totalBytes, outputPath);
+
+    _mufPackListClear(&list);
+    mufSafeFree(buffer);
+    return succeeded ? 0 : 1;
+}